@@ -0,0 +1,83 @@
+#ifndef CKANIMATIONBATCH_H
+#define CKANIMATIONBATCH_H
+
+#include "XArray.h"
+#include "VxVector.h"
+#include "VxQuaternion.h"
+
+class CKKeyedAnimation;
+class RCKObjectAnimation;
+class RCK3dEntity;
+
+// Applies the object animations of a keyed animation in three bulk passes
+// instead of one RCKObjectAnimation::SetStep per bone, with the same local
+// and world matrices.
+//
+// SetStep first evaluates the position / rotation / scale / scale axis of
+// every bone into per-channel arrays, then composes all the local matrices,
+// and finally updates the world matrices in one sweep over the hierarchy,
+// parents first, so that no entity is left dirty for a later resolve.
+//
+// Bones are kept sorted by depth. The sweep starts from every bone not
+// reached yet during the frame, so a hierarchy changed since Build still gives
+// the right matrices, only with some entities updated twice.
+//
+// Not batched:
+// - Keys stay in their controllers, each evaluated through its virtual
+//   Evaluate. A copy of the keys into flat arrays would need one evaluator
+//   per key type, and would go stale when keys are edited through GetKey.
+// - Every moved entity is still registered with AddMovedEntity: the render
+//   manager flags, then resets, each entity of that list at the frame end.
+class CKAnimationBatch {
+public:
+    CKAnimationBatch();
+
+    void Build(RCKObjectAnimation **anims, int count);
+    void Clear();
+
+    // FALSE when the animations or their entities differ from the ones of the
+    // last Build
+    CKBOOL Matches(RCKObjectAnimation **anims, int count) const;
+
+    // Same result as calling SetStep(step, owner) on every animation
+    void SetStep(float step, CKKeyedAnimation *owner);
+
+    int GetBoneCount() const { return m_Bones.Size(); }
+
+    struct EntityBone {
+        RCK3dEntity *Entity;
+        int Bone;
+    };
+
+protected:
+    struct Bone {
+        RCKObjectAnimation *Anim;
+        RCK3dEntity *Entity;
+        int Depth;
+        int Order; // Index in the animation array
+    };
+
+    // Bone of an entity, -1 if the entity is not animated by the batch
+    int FindBone(RCK3dEntity *entity) const;
+    void UpdateSubtree(RCK3dEntity *entity);
+
+    XArray<RCKObjectAnimation *> m_Anims; // Animation array of the last Build
+    XArray<RCK3dEntity *> m_Entities;     // Their entities
+    XArray<Bone> m_Bones;                 // Sorted by depth
+    XArray<EntityBone> m_EntityBones;     // Sorted by entity address
+
+    // Per bone, for the current frame
+    XArray<VxVector> m_Positions;
+    XArray<VxVector> m_Scales;
+    XArray<VxQuaternion> m_Rotations;
+    XArray<VxQuaternion> m_ScaleAxes;
+    XArray<float> m_Frames;
+    XArray<CKDWORD> m_TransformFlags; // 1 scale, 2 scale axis, 4 position, 8 rotation
+    XArray<CKBYTE> m_Active;          // FALSE if SetStep would skip the bone
+    XArray<int> m_SweepStamps;        // Sweep that last updated the bone
+    int m_SweepStamp;
+
+    XArray<RCK3dEntity *> m_Stack;
+};
+
+#endif // CKANIMATIONBATCH_H
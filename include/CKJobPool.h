@@ -0,0 +1,56 @@
+#ifndef CKJOBPOOL_H
+#define CKJOBPOOL_H
+
+#include "VxDefines.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define CKJOBPOOL_MAX_WORKERS 15
+
+// Fixed set of worker threads running indexed tasks, for the render engine and
+// the software rasterizer.
+//
+// Run() hands out the indices 0..Count-1 to the workers and to the calling
+// thread, and returns once every task has completed. Tasks must only write
+// data that no other index touches. Run() is not reentrant: it is meant to be
+// called from the main thread only.
+class CKJobPool {
+public:
+    typedef void (*TaskFunction)(void *context, int index);
+
+    CKJobPool();
+    ~CKJobPool();
+
+    // Restarts the pool with workerCount threads (0 runs everything on the caller)
+    void Start(int workerCount);
+    void Stop();
+    int GetWorkerCount() const { return (int) m_Workers.size(); }
+
+    void Run(int count, TaskFunction task, void *context);
+
+    // Worker count for a WorkerThreads option value: negative means one
+    // worker per extra hardware thread
+    static int GetAutoWorkerCount(int optionValue);
+
+protected:
+    void WorkerLoop();
+    void Execute();
+
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Mutex;
+    std::condition_variable m_WakeUp;
+    std::condition_variable m_Done;
+    std::atomic<int> m_NextIndex;
+    TaskFunction m_Task;
+    void *m_Context;
+    int m_Count;
+    int m_Busy;
+    CKDWORD m_Generation;
+    bool m_Quit;
+};
+
+#endif // CKJOBPOOL_H
@@ -0,0 +1,59 @@
+#ifndef CKMESHBVH_H
+#define CKMESHBVH_H
+
+#include "CKRenderEngineTypes.h"
+
+// 32 byte node. Nodes are stored in depth-first order: the first child of an
+// interior node is the next node and Offset is the first index after its
+// subtree, so the traversal only ever moves forward and needs no stack.
+struct CKMeshBVHNode {
+    float Min[3];
+    int Offset; // Leaf: first entry in the triangle list, interior node: skip index
+    float Max[3];
+    int Count;  // Leaf: triangle count, 0 for interior nodes
+};
+
+// Called with the face indices of every leaf whose box the ray crosses
+typedef void (*CKMeshBVHLeafFunc)(const int *faces, int count, void *arg);
+
+// Triangle hierarchy used by RayIntersectionBVHFunc.
+//
+// Built with a binned surface area heuristic over the face boxes. It only
+// depends on the vertex positions and the face vertex indices: materials and
+// two-sided flags are read per candidate face at query time, so changing them
+// does not invalidate the hierarchy. The owning mesh calls Invalidate() when
+// vertices move or faces change, and the next query rebuilds it.
+class CKMeshBVH {
+public:
+    CKMeshBVH();
+
+    void Invalidate() { m_Built = FALSE; }
+
+    // TRUE when the hierarchy was built for these counts and not invalidated since
+    CKBOOL IsUpToDate(int faceCount, int vertexCount) const {
+        return m_Built && m_FaceCount == faceCount && m_VertexCount == vertexCount;
+    }
+
+    void Build(const VxVertex *vertices, int vertexCount, const CKWORD *indices, int faceCount);
+    void Build(const VxVertex *vertices, int vertexCount, const CKDWORD *indices, int faceCount);
+
+    // Visits the leaves crossed by origin + t * direction for t in [0, maxDist].
+    // Leaves are visited in memory order, not front to back.
+    void Traverse(const VxVector &origin, const VxVector &direction, float maxDist,
+                  CKMeshBVHLeafFunc func, void *arg) const;
+
+    int GetNodeCount() const { return m_Nodes.Size(); }
+
+private:
+    // Exactly one of indices16 / indices32 is set
+    void BuildFaces(const VxVertex *vertices, int vertexCount, const CKWORD *indices16, const CKDWORD *indices32,
+                    int faceCount);
+
+    CKBOOL m_Built;
+    int m_FaceCount;
+    int m_VertexCount;
+    XArray<CKMeshBVHNode> m_Nodes;
+    XArray<int> m_Triangles; // Face indices referenced by the leaves
+};
+
+#endif // CKMESHBVH_H
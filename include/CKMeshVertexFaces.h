@@ -0,0 +1,80 @@
+#ifndef CKMESHVERTEXFACES_H
+#define CKMESHVERTEXFACES_H
+
+#include "CKRenderEngineTypes.h"
+#include "MeshAdjacency.h"
+
+// Faces around each vertex of a mesh, used by RCKMesh::ModifierVerticesMoved
+// to rebuild the normals around a few moved vertices only.
+//
+// The lists are the vertex to face table of MeshAdjacency. Like CKMeshBVH it
+// only depends on the face vertex indices: the owning mesh calls
+// Invalidate() when faces change.
+class CKMeshVertexFaces {
+public:
+    typedef void (*FaceNormalsFunc)(CKFace *, CKWORD *, int, VxVertex *, int);
+    typedef void (*NormalizeFunc)(VxVertex *, int);
+
+    CKMeshVertexFaces();
+
+    void Invalidate() { m_Built = FALSE; }
+
+    // TRUE when the lists were built for these counts and not invalidated since
+    CKBOOL IsUpToDate(int faceCount, int vertexCount) const {
+        return m_Built && m_FaceCount == faceCount && m_VertexCount == vertexCount;
+    }
+
+    void Build(const CKWORD *indices, int faceCount, int vertexCount);
+    void Build(const CKDWORD *indices, int faceCount, int vertexCount);
+
+    // Faces using the vertex, by increasing index and once each
+    const CKDWORD *GetFaces(int vertex, int &count) const {
+        if ((CKDWORD) vertex >= (CKDWORD) m_Adjacency.GetVertexCount()) {
+            count = 0;
+            return nullptr;
+        }
+        const CKDWORD *starts = m_Adjacency.GetVertexFaceStarts().Begin();
+        count = (int) (starts[vertex + 1] - starts[vertex]);
+        return m_Adjacency.GetVertexFaces().Begin() + starts[vertex];
+    }
+
+    // Recomputes the normals of the faces around the moved vertices, then
+    // with vertexNormals the normals of the vertices of these faces, with the
+    // same results as a full build by faceNormals and normalize over all the
+    // faces and vertices (g_BuildNormalsFunc is faceNormals, the sums in face
+    // order and normalize). moved can list a vertex more than once.
+    void PatchNormals(const int *moved, int movedCount, CKFace *faces, const CKWORD *indices, VxVertex *vertices,
+                      CKBOOL vertexNormals, FaceNormalsFunc faceNormals, NormalizeFunc normalize);
+    // 32-bit indices: the face normals of BuildNormals32GenericFunc
+    void PatchNormals(const int *moved, int movedCount, CKFace *faces, const CKDWORD *indices, VxVertex *vertices,
+                      CKBOOL vertexNormals, NormalizeFunc normalize);
+
+private:
+    template <class IndexType>
+    void BuildLists(const IndexType *indices, int faceCount, int vertexCount);
+    template <class IndexType>
+    void CollectFaces(const int *moved, int movedCount, const IndexType *indices, CKBOOL vertexNormals);
+    template <class IndexType>
+    void PatchVertexNormals(CKFace *faces, const IndexType *indices, VxVertex *vertices, NormalizeFunc normalize);
+    void PatchFaceNormals(CKFace *faces, const CKWORD *indices, VxVertex *vertices, FaceNormalsFunc faceNormals);
+
+    // Starts a new set of marks, clearing them when the counter wraps
+    void NextMark();
+
+    CKBOOL m_Built;
+    int m_FaceCount;
+    int m_VertexCount;
+    MeshAdjacency m_Adjacency;
+
+    // Scratch of PatchNormals
+    int m_Mark;
+    XArray<int> m_FaceMarks;
+    XArray<int> m_VertexMarks;
+    XArray<int> m_PatchFaces;
+    XArray<int> m_PatchVertices;
+    XArray<CKFace> m_BatchFaces;
+    XArray<CKWORD> m_BatchIndices;
+    XArray<VxVertex> m_BatchVertices;
+};
+
+#endif // CKMESHVERTEXFACES_H
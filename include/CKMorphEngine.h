@@ -0,0 +1,89 @@
+#ifndef CKMORPHENGINE_H
+#define CKMORPHENGINE_H
+
+#include "CKKeyframeData.h"
+#include "XArray.h"
+
+// Sparse index over the keys of a morph controller, used by
+// RCKMorphController::Evaluate.
+//
+// Keys keep their full position / normal arrays (GetKey exposes them), the
+// table records for every key the sorted list of vertices where it differs
+// from the first key. Between two keys only the vertices changed by either
+// key can leave the first key pose, so a facial animation on a large head
+// only blends the few hundred vertices of the face.
+//
+// The vertices of the current key pair are copied into packed from / delta
+// arrays, so the blend runs on contiguous floats with the kernels below.
+class CKMorphDeltaTable {
+public:
+    CKMorphDeltaTable();
+
+    // Returns FALSE and leaves the table empty when a key has no positions or
+    // only some of the keys have normals
+    CKBOOL Build(const CKMorphKey *keys, int keyCount, int vertexCount);
+    void Clear();
+
+    CKBOOL IsBuilt() const { return m_Built; }
+    CKBOOL HasNormals() const { return m_HasNormals; }
+
+    // Different after every Build, never 0
+    int GetVersion() const { return m_Version; }
+
+    // Vertices where the key differs from the first key, sorted
+    const int *GetKeyVertices(int key, int &count) const {
+        count = m_KeyStarts[key + 1] - m_KeyStarts[key];
+        return m_KeyVertices.Begin() + m_KeyStarts[key];
+    }
+
+    // Selects the key pair blended by EvaluatePair. keys are the ones the
+    // table was built from.
+    void SetPair(const CKMorphKey *keys, int from, int to);
+
+    // Vertices of the current pair, sorted: the ones either key changes
+    const int *GetPairVertices(int &count) const {
+        count = m_PairVertices.Size();
+        return m_PairVertices.Begin();
+    }
+
+    // Writes from + (to - from) * factor for the pair vertices below
+    // vertexCount, as the dense evaluation does. normalPtr can be NULL; it is
+    // ignored if the keys have no normals. Returns the number of vertices
+    // written.
+    int EvaluatePair(float factor, int vertexCount, CKBYTE *vertexPtr, CKDWORD vStride, VxCompressedVector *normalPtr);
+
+    // Writes the first key pose of the vertices the key changes below
+    // vertexCount. Returns the number of vertices written.
+    int RestoreKey(const CKMorphKey *keys, int key, int vertexCount, CKBYTE *vertexPtr, CKDWORD vStride,
+                   VxCompressedVector *normalPtr) const;
+
+protected:
+    CKBOOL m_Built;
+    CKBOOL m_HasNormals;
+    int m_Version;
+    XArray<int> m_KeyStarts;   // Key count + 1 offsets in m_KeyVertices
+    XArray<int> m_KeyVertices;
+
+    // Current pair, 3 position floats and 2 normal floats (xa ya) per vertex
+    int m_PairKeyFrom; // -1 when no pair is selected
+    int m_PairKeyTo;
+    XArray<int> m_PairVertices;
+    XArray<float> m_FromPositions;
+    XArray<float> m_DeltaPositions; // To key - from key
+    XArray<float> m_FromNormals;
+    XArray<float> m_DeltaNormals;
+    XArray<float> m_Blended;        // Kernel output
+};
+
+// out[i] = from[i] + delta[i] * factor for count floats. No fused
+// multiply-add, so all versions give the same result.
+typedef void (*CKMorphLerpFunc)(const float *from, const float *delta, float factor, float *out, int count);
+
+void MorphLerpGenericFunc(const float *from, const float *delta, float factor, float *out, int count);
+void MorphLerpSSE2Func(const float *from, const float *delta, float factor, float *out, int count);
+void MorphLerpAVX2Func(const float *from, const float *delta, float factor, float *out, int count);
+
+// Kernel matching GetMeshSIMDLevel()
+CKMorphLerpFunc GetMorphLerpFunc();
+
+#endif // CKMORPHENGINE_H
@@ -0,0 +1,64 @@
+#ifndef CKOCCLUSIONBUFFER_H
+#define CKOCCLUSIONBUFFER_H
+
+#include "CKRenderEngineTypes.h"
+
+// Low resolution depth buffer for software occlusion culling.
+//
+// Occluder triangles are projected with the view projection matrix of the
+// frame, clipped against the near plane and rasterized at pixel centers.
+// Each pixel keeps the largest 1 / w of the occluders covering it, which is
+// linear in screen space and keeps its precision in the distance. A box is
+// occluded when every pixel its projection touches holds an occluder nearer
+// than the nearest box corner.
+//
+// Rows are processed 4 pixels at a time, with SSE2 when the processor has
+// it; both paths write the same buffer. Coverage is sampled at pixel
+// centers, so occluder meshes are expected to lie inside the geometry they
+// stand for.
+class CKOcclusionBuffer {
+public:
+    CKOcclusionBuffer();
+
+    // Resizes the buffer to width x height pixels and clears it
+    void Begin(int width, int height, const VxMatrix &viewProj);
+
+    // Rasterizes indexed triangles of positions transformed by world
+    void AddOccluder(const VxMatrix &world, const CKBYTE *positions, CKDWORD stride, int vertexCount,
+                     const CKWORD *indices, int indexCount);
+    void AddOccluder(const VxMatrix &world, const CKBYTE *positions, CKDWORD stride, int vertexCount,
+                     const CKDWORD *indices, int indexCount);
+
+    // TRUE when the world space box is hidden by the occluders. Boxes
+    // crossing the near plane or outside the buffer are never occluded.
+    CKBOOL IsBoxOccluded(const VxBbox &box);
+
+    int GetWidth() const { return m_Width; }
+    int GetHeight() const { return m_Height; }
+    // 1 / w of the nearest occluder at a pixel, 0 when none covers it
+    float GetInverseDepth(int x, int y) const { return m_Depth[y * m_Pitch + x]; }
+
+    int GetOccluderTriangleCount() const { return m_OccluderTriangleCount; }
+    int GetTestedBoxCount() const { return m_TestedBoxCount; }
+    int GetOccludedBoxCount() const { return m_OccludedBoxCount; }
+
+private:
+    template <class IndexType>
+    void AddTriangles(const VxMatrix &world, const CKBYTE *positions, CKDWORD stride, int vertexCount,
+                      const IndexType *indices, int indexCount);
+    void ClipTriangle(const VxVector4 *clip);
+    void RasterizeTriangle(const VxVector4 &a, const VxVector4 &b, const VxVector4 &c);
+
+    int m_Width;
+    int m_Height;
+    int m_Pitch; // Width rounded up to 4 pixels
+    VxMatrix m_ViewProj;
+    XArray<float> m_Depth;
+    XArray<VxVector4> m_Projected; // Scratch of AddOccluder
+
+    int m_OccluderTriangleCount;
+    int m_TestedBoxCount;
+    int m_OccludedBoxCount;
+};
+
+#endif // CKOCCLUSIONBUFFER_H
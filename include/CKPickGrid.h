@@ -0,0 +1,56 @@
+#ifndef CKPICKGRID_H
+#define CKPICKGRID_H
+
+#include "CKRenderEngineTypes.h"
+
+struct CKObjectExtents;
+
+struct CKPickCandidate {
+    float Distance; // Lower bound of any hit distance on the object
+    int Index;      // Index in the object extents
+};
+
+// Uniform screen-space grid over the object extents of the last rendered frame.
+//
+// The render context invalidates it whenever the extents array changes and
+// rebuilds it on the next pick, so frames without picking pay nothing. Cells
+// hold extent indices in one flat array (m_CellStart gives the range of each
+// cell). Extents outside the grid bounds are clamped into the border cells,
+// so the bounds only affect the cell size, never the query results.
+class CKPickGrid {
+public:
+    CKPickGrid();
+
+    void Invalidate() { m_Built = FALSE; }
+    CKBOOL IsBuilt() const { return m_Built; }
+
+    // bounds is usually the viewport: rectangles far outside it do not stretch the cells
+    void Build(const CKObjectExtents *extents, int count, const VxRect &bounds);
+
+    // Appends the indices of the extents containing pt (borders included)
+    void QueryPoint(const CKObjectExtents *extents, const Vx2DVector &pt, XArray<int> &indices) const;
+
+    // Appends the indices of the extents overlapping rect, each index once
+    void QueryRect(const CKObjectExtents *extents, const VxRect &rect, XArray<int> &indices);
+
+    // Sorts by increasing distance, then by extent index so ties keep the
+    // order of a linear scan
+    static void SortFrontToBack(XArray<CKPickCandidate> &candidates);
+
+private:
+    int CellX(float x) const;
+    int CellY(float y) const;
+
+    CKBOOL m_Built;
+    VxRect m_Bounds;
+    int m_CellsX;
+    int m_CellsY;
+    float m_InvCellWidth;
+    float m_InvCellHeight;
+    XArray<int> m_CellStart; // m_CellsX * m_CellsY + 1 entries
+    XArray<int> m_CellItems;
+    XArray<CKDWORD> m_QueryStamps; // Per extent, last QueryRect that returned it
+    CKDWORD m_QueryStamp;
+};
+
+#endif // CKPICKGRID_H
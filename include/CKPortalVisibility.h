@@ -0,0 +1,42 @@
+#ifndef CKPORTALVISIBILITY_H
+#define CKPORTALVISIBILITY_H
+
+#include "CKRenderEngineTypes.h"
+
+// Places seen from the camera through the portals of CKPlace.
+//
+// The walk starts from the place of the camera with the whole viewport and
+// crosses each portal with the part of the viewport the portal covers: the
+// rectangle of its projected world box, clipped by the rectangle it was
+// reached with. A place gets the union of the rectangles it is reached
+// with, in the homogeneous viewport coordinates of CKPlace::ViewportClip
+// (0..1, y down). Places the walk does not reach cannot be seen.
+//
+// Portals without geometry see the whole rectangle they are reached with,
+// as do portal boxes crossing the near plane.
+class CKPortalVisibility {
+public:
+    CKPortalVisibility();
+
+    // Recomputes the visible places for the view projection matrix of a frame
+    void Compute(CKPlace *cameraPlace, const VxMatrix &viewProj);
+    void Clear();
+
+    // FALSE when the place cannot be seen, its viewport rectangle otherwise
+    CKBOOL GetPlaceRect(CKPlace *place, VxRect &rect) const;
+
+    int GetVisiblePlaceCount() const { return m_Places.Size(); }
+    int GetPortalTestCount() const { return m_PortalTestCount; }
+
+private:
+    void Visit(CKPlace *place, const VxRect &rect, int depth);
+    CKBOOL ProjectPortal(CK3dEntity *portal, const VxRect &clip, VxRect &rect);
+    int FindPlace(CKPlace *place) const;
+
+    VxMatrix m_ViewProj;
+    XArray<CKPlace *> m_Places;
+    XArray<VxRect> m_Rects;
+    int m_PortalTestCount;
+};
+
+#endif // CKPORTALVISIBILITY_H
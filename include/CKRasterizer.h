@@ -345,6 +345,8 @@ public:
     //--- Computes the visibility of a box in the current viewport
     //--- and also computes its screen extents if asked.
     virtual CKDWORD ComputeBoxVisibility(const VxBbox &box, CKBOOL World = FALSE, VxRect *extents = NULL);
+    //--- Visibility of BoxCount boxes at once (one CBV_ value per box in results), without extents
+    void ComputeBoxVisibility(int BoxCount, const VxBbox *boxes, CKDWORD *results, CKBOOL World = FALSE);
 
     //-----------------------------------------------------------------
     //--- When using threads one must warn the context before/after using its methods of the active calling thread.
@@ -0,0 +1,45 @@
+#ifndef CKRASTERIZERSIMD_H
+#define CKRASTERIZERSIMD_H
+
+#include "VxDefines.h"
+#include "VxMath.h"
+
+// Vertex kernels behind CKRasterizerContext::TransformVertices,
+// ComputeBoxVisibility and CKRSTLoadVertexBuffer. The processor specific
+// levels of the transforms work on 4 (SSE2) or 8 (AVX) vertices per
+// iteration in x, y, z, w lanes and follow the operation order of the
+// generic level, so every level returns the same bits.
+enum CKRST_SIMD {
+    CKRST_SIMD_NONE = 0,
+    CKRST_SIMD_SSE2 = 1,
+    CKRST_SIMD_AVX = 2,
+};
+
+// Best level of the processor, detected once
+CKRST_SIMD GetRasterizerSIMDLevel();
+
+// Homogeneous coordinates of count positions (w = 1) transformed by mat.
+// When clipFlags is not NULL it receives the VXCLIP flags of each vertex and
+// the function returns their AND, otherwise it returns 0.
+CKDWORD CKRstTransformVertices(CKRST_SIMD level, const VxMatrix &mat, const void *in, CKDWORD inStride,
+                               VxVector4 *out, CKDWORD outStride, CKDWORD *clipFlags, int count);
+
+// Screen coordinates of homogeneous vertices: x and y in pixels, z / w, 1 / w
+void CKRstProjectVertices(CKRST_SIMD level, const VxVector4 *in, CKDWORD inStride, VxVector4 *out,
+                          CKDWORD outStride, int count, float centerX, float centerY, float halfWidth,
+                          float halfHeight);
+
+// OR and AND of the VXCLIP flags of the 8 corners of each box transformed by mat
+void CKRstComputeBoxesClipFlags(CKRST_SIMD level, const VxMatrix &mat, const VxBbox *boxes, int count,
+                                CKDWORD *orFlags, CKDWORD *andFlags);
+
+// Fills the vertices of data at VBMem in a vertex format (VSize bytes per
+// vertex) of CKRSTGetVertexFormat, one whole vertex at a time. Returns FALSE
+// without writing anything when the format has weights, a point size, a
+// texture coordinate size or padding, or when data misses the normals or
+// texture coordinates the format holds: CKRSTLoadVertexBuffer then copies
+// one attribute at a time.
+CKBOOL CKRstLoadVertices(CKRST_SIMD level, CKBYTE *VBMem, CKDWORD VFormat, CKDWORD VSize,
+                         const VxDrawPrimitiveData *data);
+
+#endif // CKRASTERIZERSIMD_H
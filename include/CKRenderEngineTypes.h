@@ -561,6 +561,7 @@ struct VxMaterialChannel {
     VXBLEND_MODE m_DestBlend;      // 0x0C
     CKDWORD m_Flags;               // 0x10
     XArray<CKWORD> *m_FaceIndices; // 0x14 - Per-channel face indices (nullptr if channel applies to all faces)
+    XArray<CKDWORD> *m_FaceIndices32; // Used instead of m_FaceIndices by meshes with 32-bit indices
 
     VxMaterialChannel()
         : m_UVs(nullptr),
@@ -568,13 +569,18 @@ struct VxMaterialChannel {
           m_SourceBlend(VXBLEND_ZERO),
           m_DestBlend(VXBLEND_SRCCOLOR),
           m_Flags(1),
-          m_FaceIndices(nullptr) {}
+          m_FaceIndices(nullptr),
+          m_FaceIndices32(nullptr) {}
 
     void Clear() {
         if (m_FaceIndices) {
             delete m_FaceIndices;
             m_FaceIndices = nullptr;
         }
+        if (m_FaceIndices32) {
+            delete m_FaceIndices32;
+            m_FaceIndices32 = nullptr;
+        }
         delete[] m_UVs;
         m_UVs = nullptr;
     }
@@ -584,6 +590,17 @@ struct CKPrimitiveEntry {
     VXPRIMITIVETYPE m_Type;
     XArray<CKWORD> m_Indices;
     CKDWORD m_IndexBufferOffset;
+    // Meshes with 32-bit indices split their groups in batches of at most
+    // 0x10000 vertices: m_Indices are then relative to m_VertexStart in the
+    // group vertices. m_VertexCount is 0 when the primitive uses the whole group.
+    CKDWORD m_VertexStart;
+    CKDWORD m_VertexCount;
+
+    CKPrimitiveEntry()
+        : m_Type(VX_TRIANGLELIST),
+          m_IndexBufferOffset(-1),
+          m_VertexStart(0),
+          m_VertexCount(0) {}
 };
 
 // IDA: CKVBuffer (0x30 bytes)
@@ -603,8 +620,8 @@ struct CKVBuffer {
 
 struct CKMaterialGroup {
     RCKMaterial *m_Material;                    // 0x00
-    XClassArray<CKPrimitiveEntry> m_Primitives; // 0x04 - Primitive entries (size 12)
-    XArray<CKWORD> m_FaceIndices;               // 0x10 - Face indices for this group
+    XClassArray<CKPrimitiveEntry> m_Primitives; // 0x04 - Primitive entries, one per batch with wide indices
+    XArray<CKDWORD> m_FaceIndices;              // 0x10 - Face indices for this group
     CKDWORD m_HasValidPrimitives;               // 0x1C - Flag set when at least one primitive has indices
     CKDWORD m_MinVertexIndex;                   // 0x20 - Smallest vertex index used by the group
     CKDWORD m_MaxVertexIndex;                   // 0x24 - Largest vertex index (exclusive) used by the group
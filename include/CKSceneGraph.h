@@ -2,6 +2,7 @@
 #define CKSCENEGRAPH_H
 
 #include "CKRenderEngineTypes.h"
+#include "RadixSort.h"
 
 class RCKRenderContext;
 class RCKPlace;
@@ -23,6 +24,11 @@ typedef enum CKSCENEGRAPHNODE_FLAGS
     // Sorting / bookkeeping
     CKSGN_NEEDSORT             = 0x00000010, // Children need sorting
     CKSGN_INTRANSPARENTLIST    = 0x00000020, // Added to transparent object list
+
+    // Flat culling pass result (CKSceneGraphBVH::Cull)
+    CKSGN_CULLINSIDE           = 0x00000040, // Hierarchy box entirely inside frustum
+    CKSGN_CULLOUTSIDE          = 0x00000080, // Hierarchy box entirely outside frustum
+    CKSGN_CULL_MASK            = 0x000000C0,
 } CKSCENEGRAPHNODE_FLAGS;
 
 // Forward declaration
@@ -35,6 +41,33 @@ struct CKTransparentObject {
     float m_ZhMax;            // Maximum Z in homogeneous coordinates
 };
 
+// Back-to-front ordering engine for CKTransparentObject lists.
+// Objects are radix sorted on (priority, projected depth) and the expensive
+// tie-breaker only runs inside clusters whose projected Z ranges overlap.
+class CKTransparentSorter {
+public:
+    // Tie-breaker for overlapping depth ranges.
+    // Returns > 0 if a must be drawn before b, < 0 if after, 0 if undecided.
+    typedef int (*ClassifyFunc)(const CKTransparentObject &a, const CKTransparentObject &b, void *arg);
+
+    CKTransparentSorter();
+
+    // Same order as SortLegacy over the whole list, provided classify never
+    // puts both a before b and b before a. It need not be transitive.
+    void Sort(XClassArray<CKTransparentObject> &objects, ClassifyFunc classify, void *arg);
+
+    // Reference O(n^2) bubble sort reproducing CK2_3D.dll ordering.
+    static void SortLegacy(CKTransparentObject *begin, CKTransparentObject *end, ClassifyFunc classify, void *arg);
+
+    int GetOverlapClusterCount() const { return m_OverlapClusterCount; }
+
+private:
+    RadixSorter m_Sorter;
+    XArray<CKDWORD> m_Keys;
+    XClassArray<CKTransparentObject> m_Sorted;
+    int m_OverlapClusterCount;
+};
+
 struct CKSceneGraphNode {
     explicit CKSceneGraphNode(RCK3dEntity *entity = nullptr);
     ~CKSceneGraphNode();
@@ -50,6 +83,9 @@ struct CKSceneGraphNode {
     CKDWORD Rebuild();
     CKDWORD ComputeHierarchicalBox();
 
+    // Incremented whenever a node is attached to or detached from a parent.
+    static CKDWORD GetTopologyStamp();
+
     // Rendering traversal
     void NoTestsTraversal(RCKRenderContext *dev, CKDWORD flags);
     void SetAsPotentiallyVisible();
@@ -92,6 +128,7 @@ struct CKSceneGraphNode {
     CKSceneGraphNode *m_Parent;
     XArray<CKSceneGraphNode *> m_Children;
     int m_ChildToBeParsedCount;
+    int m_FlatIndex; // Index in CKSceneGraphBVH, -1 when never built
 };
 
 struct CKSceneGraphRootNode : CKSceneGraphNode {
@@ -0,0 +1,84 @@
+#ifndef CKSCENEGRAPHBVH_H
+#define CKSCENEGRAPHBVH_H
+
+#include "CKSceneGraph.h"
+
+class CKJobPool;
+
+// Flat culling structure mirroring the CKSceneGraphNode tree.
+//
+// Nodes are stored in depth-first order so the subtree of node i spans
+// [i, m_Skip[i]): a rejected or fully visible subtree is stepped over with a
+// single index jump and the traversal needs no recursion. Hierarchical boxes
+// are kept in SoA arrays and refitted bottom-up for dirty nodes only: the
+// nodes invalidated since the last update are queued by depth, and a level
+// is refitted once the deeper ones are done, so that its nodes are
+// independent and can be split over a job pool. A parent is only queued
+// when the box of a child changed; untouched branches keep their boxes.
+//
+// The node tree stays the source of truth for priorities, render masks and
+// traversal order; this structure only precomputes the frustum classification
+// that RenderTransparentObjects would otherwise get from
+// RCK3dEntity::IsInViewFrustrumHierarchic on every node.
+class CKSceneGraphBVH {
+public:
+    CKSceneGraphBVH();
+
+    void Clear();
+
+    // Rebuilds the flat layout when the scene graph topology changed,
+    // then refits the boxes invalidated since the last update. The entity
+    // world matrices must be resolved when a pool is given.
+    void Update(CKSceneGraphRootNode *root, CKJobPool *pool = nullptr);
+
+    // Queues the node for the next refit (CKSceneGraphNode::InvalidateBox)
+    void NodeInvalidated(CKSceneGraphNode *node);
+
+    // Classifies the hierarchy against the clip planes of viewProj and
+    // stores the result in the CKSGN_CULL_MASK bits of the tested nodes.
+    void Cull(const VxMatrix &viewProj);
+
+    // TRUE when the node flags hold the result of a Cull for the current topology.
+    CKBOOL IsCulled() const;
+
+    int GetNodeCount() const { return m_Nodes.Size(); }
+    int GetRefittedNodeCount() const { return m_RefittedNodeCount; }
+    int GetTestedNodeCount() const { return m_TestedNodeCount; }
+
+private:
+    void Build(CKSceneGraphRootNode *root);
+    void Refit(CKJobPool *pool);
+    void QueueNode(int index);
+    void RestoreAncestors(int index);
+    void PrepareNode(int index);
+    CKBOOL RefitNode(int index);
+    static void RefitChunkTask(void *context, int index);
+    CKDWORD ClassifyNode(int index, const VxPlane *planes) const;
+
+    CKDWORD m_TopologyStamp;
+    CKBOOL m_Built;
+    CKBOOL m_Culled;
+
+    XArray<CKSceneGraphNode *> m_Nodes; // Depth-first order, m_Nodes[0] is the root
+    XArray<int> m_Skip;                 // First index after the subtree
+    XArray<int> m_Parent;               // Parent index (-1 for the root)
+    XArray<int> m_Depth;
+    XArray<CKBYTE> m_Dirty;             // Queued in m_Levels
+    XArray<CKBYTE> m_Changed;           // Box changed by the last refit of the node
+    XClassArray<XArray<int> > m_Levels; // Queued nodes of each depth
+    const int *m_LevelNodes;            // Level being refitted by RefitChunkTask
+    int m_LevelCount;
+
+    XArray<float> m_MinX;
+    XArray<float> m_MinY;
+    XArray<float> m_MinZ;
+    XArray<float> m_MaxX;
+    XArray<float> m_MaxY;
+    XArray<float> m_MaxZ;
+    XArray<CKBYTE> m_BoxValid;
+
+    int m_RefittedNodeCount;
+    int m_TestedNodeCount;
+};
+
+#endif // CKSCENEGRAPHBVH_H
@@ -0,0 +1,86 @@
+#ifndef CKSKINENGINE_H
+#define CKSKINENGINE_H
+
+#include "XArray.h"
+#include "VxVector.h"
+#include "VxMatrix.h"
+
+class RCKSkinVertexData;
+class RCKSkin;
+
+// Influences per vertex of a table (4 when no vertex has more, else 8)
+#define CKSKIN_MAX_INFLUENCES 8
+
+// Vertex-major copy of the skin weights used by the skinning kernels.
+//
+// Each vertex stores its rest position, the weight of the rest position in
+// the result (w component, see Build), its rest normal and a fixed number of
+// bone / weight pairs. Weights are quantized to 16 bits (1.0 = 65535) and
+// unused slots have a zero weight. A vertex can then be skinned on its own
+// with one blended matrix instead of being revisited for every bone, and any
+// vertex range can be processed independently of the others.
+class CKSkinInfluenceTable {
+public:
+    CKSkinInfluenceTable();
+
+    // Returns FALSE and leaves the table empty when the skin does not fit:
+    // more than CKSKIN_MAX_INFLUENCES valid bones on a vertex, a weight outside
+    // [0, 1] or more than 65536 bones. Influences on invalid bone indices are
+    // dropped. weighted is the skin weighted mode: the rest position then
+    // keeps 1 - sum(weights) of the result when that is positive.
+    CKBOOL Build(RCKSkinVertexData *vertexData, int vertexCount, int boneCount, const VxVector *normals, int normalCount,
+                 CKBOOL weighted);
+    void Clear();
+
+    CKBOOL IsBuilt() const { return m_Built; }
+    int GetVertexCount() const { return m_Positions.Size(); }
+    int GetInfluenceCount() const { return m_InfluenceCount; }
+    CKBOOL HasNormals() const { return m_Normals.Size() > 0; }
+
+    // TRUE if at least one vertex has a valid influence on the bone
+    CKBOOL IsBoneUsed(int bone) const { return m_BoneUsed[bone] != 0; }
+
+    const VxVector4 *GetPositions() const { return m_Positions.Begin(); }
+    const VxVector *GetNormals() const { return m_Normals.Begin(); }
+    const CKWORD *GetBones() const { return m_Bones.Begin(); }
+    const CKWORD *GetWeights() const { return m_Weights.Begin(); }
+
+protected:
+    CKBOOL m_Built;
+    int m_InfluenceCount;
+    XArray<VxVector4> m_Positions; // Rest position, rest position weight in w
+    XArray<VxVector> m_Normals;    // Empty when the skin has no normals
+    XArray<CKWORD> m_Bones;        // m_InfluenceCount per vertex
+    XArray<CKWORD> m_Weights;      // m_InfluenceCount per vertex
+    XArray<CKBYTE> m_BoneUsed;
+};
+
+// Skins the vertices [begin, end) of a table into strided outputs.
+// palette holds one matrix per bone: a zero matrix removes the bone
+// contribution. normalPtr can be NULL; it is ignored if the table has no
+// normals.
+typedef void (*CKSkinVerticesFunc)(const CKSkinInfluenceTable &table, const VxMatrix *palette, int begin, int end,
+                                   CKBYTE *vertexPtr, CKDWORD vStride, CKBYTE *normalPtr, CKDWORD nStride);
+
+void SkinVerticesGenericFunc(const CKSkinInfluenceTable &table, const VxMatrix *palette, int begin, int end,
+                             CKBYTE *vertexPtr, CKDWORD vStride, CKBYTE *normalPtr, CKDWORD nStride);
+void SkinVerticesSSE2Func(const CKSkinInfluenceTable &table, const VxMatrix *palette, int begin, int end,
+                          CKBYTE *vertexPtr, CKDWORD vStride, CKBYTE *normalPtr, CKDWORD nStride);
+void SkinVerticesAVX2Func(const CKSkinInfluenceTable &table, const VxMatrix *palette, int begin, int end,
+                          CKBYTE *vertexPtr, CKDWORD vStride, CKBYTE *normalPtr, CKDWORD nStride);
+
+// Kernel matching GetMeshSIMDLevel()
+CKSkinVerticesFunc GetSkinVerticesFunc();
+
+// One CalcPointsEx call of a batch (see RCKSkin::CalcPointsBatch)
+struct CKSkinJob {
+    RCKSkin *Skin;
+    int VertexCount;
+    CKBYTE *VertexPtr;
+    CKDWORD VStride;
+    CKBYTE *NormalPtr;
+    CKDWORD NStride;
+    CKBOOL Result;
+};
+
+#endif // CKSKINENGINE_H
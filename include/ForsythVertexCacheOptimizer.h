@@ -0,0 +1,72 @@
+#ifndef FORSYTHVERTEXCACHEOPTIMIZER_H
+#define FORSYTHVERTEXCACHEOPTIMIZER_H
+
+#include "XArray.h"
+#include "CKTypes.h"
+
+// ============================================================================
+// ForsythVertexCacheOptimizer - Reorders triangle lists for the vertex cache
+// with the scoring of Tom Forsyth's "Linear-Speed Vertex Cache Optimisation",
+// adapted to FIFO caches.
+//
+// Alternative to VertexCacheOptimizer selected by the VertexCacheOptimizer
+// render option. The faces of each vertex live in one flat array (offsets per
+// vertex, the faces left to emit first), and the FIFO cache is modelled by the
+// miss count at which each vertex was loaded: a vertex is cached while fewer
+// than cacheSize vertices were loaded since it, so lookups and insertions
+// are O(1). Each step scores the faces of the cached vertices and emits the
+// best one, or the next face in input order when none is left around them.
+// ============================================================================
+class ForsythVertexCacheOptimizer {
+public:
+    ForsythVertexCacheOptimizer();
+
+    // Writes the faceCount triangles of indices to output (which can be
+    // indices) in an order suited to a FIFO cache of cacheSize vertices.
+    // Triangles keep their corner order. Indices at or above vertexCount
+    // are allowed and extend it.
+    void Optimize(const CKWORD *indices, int faceCount, int vertexCount, int cacheSize, CKWORD *output);
+    void Optimize(const CKDWORD *indices, int faceCount, int vertexCount, int cacheSize, CKDWORD *output);
+
+    // Average cache miss ratio of a triangle list with a FIFO cache of
+    // cacheSize vertices: vertices transformed per triangle, 0.5 at best
+    // on a large regular grid and 3 at worst.
+    float ComputeACMR(const CKWORD *indices, int faceCount, int cacheSize);
+    float ComputeACMR(const CKDWORD *indices, int faceCount, int cacheSize);
+
+private:
+    template <class IndexType>
+    void Reorder(const IndexType *indices, int faceCount, int vertexCount, int cacheSize, IndexType *output);
+    template <class IndexType>
+    float SimulateCache(const IndexType *indices, int faceCount, int cacheSize);
+    template <class IndexType>
+    void BuildFaceLists(const IndexType *indices, int faceCount, int vertexCount);
+
+    void ResetCache(int vertexCount, int cacheSize);
+    void BuildScoreTables(int cacheSize);
+    float ComputeVertexScore(int vertex) const;
+
+    CKBOOL InCache(int vertex) const { return m_Clock - m_LoadTimes[vertex] <= m_CacheSize; }
+
+    // Removes face from the faces left to emit of vertex
+    void RemoveFace(int vertex, int face);
+
+    int m_CacheSize;
+    int m_Clock;              // Vertices loaded so far
+    XArray<int> m_Starts;     // Vertex count + 1 offsets in m_Faces
+    XArray<int> m_Faces;      // Faces of each vertex, the ones left to emit first
+    XArray<int> m_Remaining;  // Faces left to emit per vertex
+    XArray<int> m_LoadTimes;  // m_Clock when each vertex was last loaded
+    XArray<int> m_Cache;      // Ring of the last m_CacheSize loaded vertices
+    XArray<float> m_Scores;   // Per vertex
+    XArray<CKBYTE> m_Emitted; // Per face
+    XArray<int> m_Order;      // Emitted faces
+    XArray<float> m_CacheScores; // Per age in the cache, 0 for the last loaded vertex
+    XArray<float> m_ValenceScores;
+
+    // non-copyable
+    ForsythVertexCacheOptimizer(const ForsythVertexCacheOptimizer &);
+    ForsythVertexCacheOptimizer &operator=(const ForsythVertexCacheOptimizer &);
+};
+
+#endif // FORSYTHVERTEXCACHEOPTIMIZER_H
@@ -7,7 +7,15 @@
 #define GET_EDGE_NB(x) (x >> 30)
 #define IS_BOUNDARY(x) (x == 0xffffffff)
 
+class CKJobPool;
+
 // Mesh Adjacency Computation class usefully to create edges information of faces connectivity
+//
+// Compute buckets the edges of the faces by their smallest vertex with a
+// counting sort, so that the faces sharing an edge meet in the short list of
+// one vertex. The buckets, then the faces, are split across the threads of a
+// CKJobPool and the whole build is linear in the face count. The links and
+// edges are the ones of the former radix sort of all the edges.
 class MeshAdjacency {
 public:
     class Edge {
@@ -31,7 +39,8 @@ public:
     void Init(CKWORD *iIndices, int iCount);
     void Init(CKDWORD *iIndices, int iCount);
 
-    bool Compute(bool iEdges, bool iFaces);
+    // Returns false when an edge is shared by more than 2 faces
+    bool Compute(bool iEdges, bool iFaces, CKJobPool *iPool = nullptr);
 
     const XArray<Edge> &GetEdges() {
         return m_Edges;
@@ -47,13 +56,52 @@ public:
         return m_Faces;
     }
 
+    // Fills the vertex to face table alone, without the links and edges
+    void ComputeVertexFaces();
+
+    // Vertex to face table filled by Compute or ComputeVertexFaces: the faces using vertex v are
+    // GetVertexFaces()[GetVertexFaceStarts()[v]] up to the start of v + 1, by
+    // increasing index and once each. There are GetVertexCount() + 1 starts.
+    int GetVertexCount() const {
+        return m_VertexFaceStarts.Size() > 0 ? m_VertexFaceStarts.Size() - 1 : 0;
+    }
+    const XArray<CKDWORD> &GetVertexFaceStarts() const {
+        return m_VertexFaceStarts;
+    }
+    const XArray<CKDWORD> &GetVertexFaces() const {
+        return m_VertexFaces;
+    }
+
 private:
+    // Edge slot (face * 3 + edge) in the bucket of its smallest vertex
+    struct EdgeSlot {
+        CKDWORD vertex; // Largest vertex
+        CKDWORD slot;
+    };
+
     void AddTriangle(int iIndex, CKDWORD iV0, CKDWORD iV1, CKDWORD iV2);
-    void AddEdge(CKDWORD iV0, CKDWORD iV1, CKDWORD iFace, CKDWORD iEdgeIndex);
-    bool UpdateLink(CKDWORD iFace1, CKDWORD iFace2, CKDWORD iV0, CKDWORD iV1);
+    void BuildVertexFaces();
+    void BuildBuckets();
+    bool LinkBuckets(int iBegin, int iEnd);
+    int CountEdges(int iBegin, int iEnd) const;
+    void WriteEdges(int iBegin, int iEnd, int iFirstEdge);
+
+    static int CompareEdgeSlots(const void *iA, const void *iB);
+    static void LinkBucketsTask(void *iContext, int iIndex);
+    static void CountEdgesTask(void *iContext, int iIndex);
+    static void WriteEdgesTask(void *iContext, int iIndex);
 
     XArray<Edge> m_Edges;
     XArray<Face> m_Faces;
+    XArray<CKDWORD> m_VertexFaceStarts;
+    XArray<CKDWORD> m_VertexFaces;
+
+    // Compute scratch: the edge slots by smallest vertex and a result per
+    // task, -1 for a non manifold edge, then the edges kept by each chunk of
+    // faces
+    XArray<CKDWORD> m_BucketStarts;
+    XArray<EdgeSlot> m_Buckets;
+    XArray<int> m_ChunkResults;
 };
 
 #endif // MESHADJACENCY_H
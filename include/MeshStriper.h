@@ -11,6 +11,13 @@ typedef enum CKMESHSTRIPER_FLAGS {
     CKMESHSTRIPER_CONNECTALL = 0x00000008UL,  // connect all strips into one (degenerate joins)
 } CKMESHSTRIPER_FLAGS;
 
+// MeshStriper - Greedy triangle stripper over MeshAdjacency.
+//
+// Each seed face tries a strip from each of its three edges, walking the
+// adjacency both ways, and keeps the longest. Seeds are taken in face order,
+// or by increasing number of neighbors with CKMESHSTRIPER_SORTSEEDS. The
+// candidate buffers and face marks are kept between Compute calls, so a
+// seed costs the length of its strips rather than the size of the mesh.
 class MeshStriper {
 public:
     struct Result {
@@ -26,6 +33,7 @@ public:
     MeshStriper &operator=(const MeshStriper &) = delete;
 
     CKBOOL Init(CKWORD *triList, int triCount, CKDWORD flags);
+    CKBOOL Init(CKDWORD *triList, int triCount, CKDWORD flags);
     CKBOOL Compute(Result *out);
 
 private:
@@ -33,11 +41,16 @@ private:
                    CKDWORD startV0,
                    CKDWORD startV1,
                    CKDWORD *outVertices,
-                   CKDWORD *outFaces,
-                   CKBYTE *used) const;
-    CKDWORD ComputeBestStrip(CKDWORD seedFace, CKBYTE *usedGlobal, int faceCount);
+                   CKDWORD *outFaces);
+    CKDWORD ComputeBestStrip(CKDWORD seedFace);
+    void ComputeSeedOrder(int faceCount);
     void ConnectAllStrips(Result *io);
 
+    // A face is taken by a committed strip or by the candidate being tracked
+    CKBOOL IsUsed(CKDWORD face) const { return m_Marks[(int) face] == kCommitted || m_Marks[(int) face] == m_Mark; }
+
+    static const CKDWORD kCommitted = 0xFFFFFFFF;
+
     MeshAdjacency m_Adj;
     CKBOOL m_AdjValid;
     CKDWORD m_Flags;
@@ -50,6 +63,13 @@ private:
     CKDWORD m_ConnectedStripLength;
     XArray<CKWORD> m_Connected16;
     XArray<CKDWORD> m_Connected32;
+
+    // Scratch reused across seeds and Compute calls
+    XArray<CKDWORD> m_Marks; // kCommitted, or the m_Mark of the last candidate which walked the face
+    CKDWORD m_Mark;
+    XArray<CKDWORD> m_Order; // Seed faces
+    XArray<CKDWORD> m_CandidateVertices[3];
+    XArray<CKDWORD> m_CandidateFaces[3];
 };
 
 #endif // MESHSTRIPER_H
@@ -4,32 +4,22 @@
 #ifndef NEARESTPOINTGRID_H
 #define NEARESTPOINTGRID_H
 
-#include "VxVector.h"
-#include "XArray.h"
+#include "PointIndex.h"
 
 /// Spatial grid for efficient 3D nearest point search.
 /// Usage: SetGridDimensions() -> AddPoint() -> SetThreshold() -> FindNearPoint()
+///
+/// Points are in grid units, inside [0, size) on each axis. The grid is a
+/// PointIndex with cells of one unit: only the occupied cells are stored,
+/// whatever the dimensions.
 class NearestPointGrid {
 protected:
-    struct Point {
-        VxVector pt;
-        int index;
-    };
-
-    typedef XArray<Point> Cell;
-
-    XArray<Cell *> m_Grid;  // 3D grid array
-    int m_SizeX;             // Grid X dimension
-    int m_SizeY;             // Grid Y dimension
-    int m_SizeZ;             // Grid Z dimension
-    int m_SizeXY;            // SizeX x SizeY
-    int m_SizeXYZ;           // Total cell count
-    float m_Threshold;       // Max distance for "near" points
-    float m_Threshold2;      // Squared threshold
-
-    Cell *&GetCell(const int x, const int y, const int z) {
-        return m_Grid[x + m_SizeX * y + m_SizeXY * z];
-    }
+    PointIndex m_Index;
+    int m_SizeX;       // Grid X dimension
+    int m_SizeY;       // Grid Y dimension
+    int m_SizeZ;       // Grid Z dimension
+    float m_Threshold; // Max distance for "near" points
+    CKBOOL m_Dirty;    // Points added since the last build
 
 public:
     NearestPointGrid();
@@ -41,14 +31,13 @@ public:
     /// Sets the distance threshold for queries.
     inline void SetThreshold(const float threshold) {
         m_Threshold = threshold;
-        m_Threshold2 = threshold * threshold;
     }
 
     /// Adds a 3D point to the grid.
     void AddPoint(const VxVector &p, int index);
 
-    /// Finds index of a point within threshold distance.
-    /// Returns -1 if no point found.
+    /// Finds index of the nearest point within threshold distance, the
+    /// first added on ties. Returns -1 if no point found.
     int FindNearPoint(const VxVector &p);
 };
 
@@ -4,6 +4,7 @@
 #include "XArray.h"
 #include "CKTypes.h"
 #include "VertexCache.h"
+#include "MeshAdjacency.h"
 
 // Binary-faithful NvStripifier reimplementation.
 //
@@ -12,6 +13,12 @@
 // - CreateStrips() emits a single index stream from those strips.
 //   - joinStrips=true: strips are connected with degenerate triangles
 //   - joinStrips=false: strips separated by -1 (0xFFFF), count returned
+//
+// Unlike the binary, faces and edges live in flat arrays of the stripifier
+// rather than one allocation each: the faces referenced by the strips stay
+// valid until the next Stripify call or the destruction of the stripifier,
+// and DestroyStrips only releases the strips. The CKDWORD overloads strip
+// 32-bit index lists, with 0xFFFFFFFF as the restart value.
 
 // ============================================================================
 // NvFaceInfo - Binary layout: 0x24 bytes
@@ -87,7 +94,8 @@ struct NvStripInfo {
 
     // Binary: NvStripInfo::Build (0x834)
     // CRITICAL: Uses STATIC local variables
-    void Build(XArray<NvEdgeInfo *> &edgeBuckets, XArray<NvFaceInfo *> &allFaces);
+    // Walks the Neighbor links of the faces rather than the edge buckets.
+    void Build();
 
     // Binary: NvStripInfo::Combine (0x11F4)
     void Combine(XArray<NvFaceInfo *> &forward, XArray<NvFaceInfo *> &backward);
@@ -136,6 +144,27 @@ public:
         XArray<CKWORD> &outIndices,
         CKDWORD &outStripCount);
 
+    // 32-bit index variants (not in original binary)
+    void Stripify(
+        const XArray<CKDWORD> &inIndices,
+        int minStripLength,
+        int cacheSize,
+        int vertexCount,
+        XArray<NvStripInfo *> &outStrips);
+    static void CreateStrips(
+        const XArray<NvStripInfo *> &strips,
+        XArray<CKDWORD> &outIndices,
+        bool joinStrips,
+        CKDWORD &outStripCount);
+    void Stripify(
+        const XArray<CKDWORD> &inIndices,
+        int minStripLength,
+        int cacheSize,
+        int vertexCount,
+        bool joinStrips,
+        XArray<CKDWORD> &outIndices,
+        CKDWORD &outStripCount);
+
     // Cleanup method for allocated strips
     static void DestroyStrips(XArray<NvStripInfo *> &strips);
 
@@ -147,18 +176,27 @@ private:
     float m_Ratio;             // +0x14
     unsigned char m_FirstTime; // +0x18
 
-    // Internal helpers (static in binary)
-    static void BuildStripifyInfo(
-        const XArray<CKWORD> &indices,
-        CKWORD vertexCount,
-        XArray<NvFaceInfo *> &outFaces,
-        XArray<NvEdgeInfo *> &outEdgeBuckets,
-        XArray<NvEdgeInfo *> &outEdges);
+    // Stripify state, kept between calls to reuse the allocations
+    MeshAdjacency m_Adjacency;
+    XArray<NvFaceInfo> m_Faces;
+    XArray<NvEdgeInfo> m_Edges;
+    XArray<NvEdgeInfo *> m_EdgeBuckets;
+    int m_ResetCursor; // Faces below are all in committed strips
+
+    template <class IndexType>
+    void StripifyIndices(
+        IndexType *indices,
+        int triCount,
+        int minStripLength,
+        int cacheSize,
+        int vertexCount,
+        XArray<NvStripInfo *> &outStrips);
+
+    template <class IndexType>
+    bool BuildStripifyInfo(IndexType *indices, int triCount, int vertexCount);
 
-    static bool FindAllStrips(
+    bool FindAllStrips(
         XArray<NvStripInfo *> &outAllStrips,
-        XArray<NvFaceInfo *> &allFaces,
-        XArray<NvEdgeInfo *> &edgeBuckets,
         int numSamples,
         int minStripLength);
 
@@ -167,9 +205,7 @@ private:
         bool joinStrips,
         XArray<NvEdgeInfo *> &edgeBuckets);
 
-    static NvFaceInfo *FindGoodResetPoint(
-        XArray<NvFaceInfo *> &allFaces,
-        XArray<NvEdgeInfo *> &edgeBuckets);
+    NvFaceInfo *FindGoodResetPoint();
 
     static void CommitStrips(
         XArray<NvStripInfo *> &outStrips,
@@ -186,11 +222,7 @@ private:
         int v0,
         int v1);
 
-    static NvFaceInfo *FindOtherFace(
-        XArray<NvEdgeInfo *> &edgeBuckets,
-        int v0,
-        int v1,
-        NvFaceInfo *notThisFace);
+    static NvFaceInfo *FindOtherFace(NvFaceInfo *face, int v0, int v1);
 
     static int FindStartPoint(
         XArray<NvFaceInfo *> &allFaces,
@@ -0,0 +1,77 @@
+#ifndef OVERDRAWOPTIMIZER_H
+#define OVERDRAWOPTIMIZER_H
+
+#include "XArray.h"
+#include "VxMath.h"
+#include "RadixSort.h"
+
+// ============================================================================
+// OverdrawOptimizer - Reorders a triangle list already in vertex cache order
+// so that the outer surfaces of the mesh are drawn first, as in Sander,
+// Nehab and Barczak's "Fast Triangle Reordering for Vertex Locality and
+// Reduced Overdraw".
+//
+// The list is cut where the cache is cold (triangles missing their three
+// vertices), then each part again as soon as its misses per triangle fall
+// to threshold times the ones of the part, resetting the cache. Clusters are
+// drawn by decreasing dot product of their average normal with their offset
+// from the centroid of the mesh, a view independent estimate of how much
+// they occlude the rest. RCKMesh::CreateRenderGroups runs it after the vertex
+// cache optimizer on opaque groups when the OverdrawThreshold render option
+// is set.
+// ============================================================================
+class OverdrawOptimizer {
+public:
+    OverdrawOptimizer();
+
+    // Writes the faceCount triangles of indices to output (which can be
+    // indices) by clusters. The clusters keep the order of their triangles.
+    // With a threshold of 1.05 a cluster can miss a FIFO cache of cacheSize
+    // vertices 5% more than the cache order did; lower values keep larger
+    // clusters. Triangles with indices at or above vertexCount are kept but
+    // do not weigh in the cluster order.
+    void Optimize(const CKWORD *indices, int faceCount, const VxVector *positions, CKDWORD positionStride,
+                  int vertexCount, int cacheSize, float threshold, CKWORD *output);
+    void Optimize(const CKDWORD *indices, int faceCount, const VxVector *positions, CKDWORD positionStride,
+                  int vertexCount, int cacheSize, float threshold, CKDWORD *output);
+
+    // Software rasterized overdraw: the pixels passing the depth test over
+    // the covered pixels, summed over six orthographic views of the mesh
+    // along the axes with back faces culled. 1 when nothing is drawn twice.
+    float ComputeOverdraw(const CKWORD *indices, int faceCount, const VxVector *positions, CKDWORD positionStride,
+                          int vertexCount);
+    float ComputeOverdraw(const CKDWORD *indices, int faceCount, const VxVector *positions, CKDWORD positionStride,
+                          int vertexCount);
+
+    int GetClusterCount() const { return m_ClusterStarts.Size(); }
+
+private:
+    template <class IndexType>
+    void Reorder(const IndexType *indices, int faceCount, const VxVector *positions, CKDWORD positionStride,
+                 int vertexCount, int cacheSize, float threshold, IndexType *output);
+    template <class IndexType>
+    void BuildClusters(const IndexType *indices, int faceCount, int vertexCount, int cacheSize, float threshold);
+    template <class IndexType>
+    void ComputeClusterKeys(const IndexType *indices, int faceCount, const VxVector *positions,
+                            CKDWORD positionStride, int vertexCount);
+    template <class IndexType>
+    float Rasterize(const IndexType *indices, int faceCount, const VxVector *positions, CKDWORD positionStride,
+                    int vertexCount);
+
+    // FIFO cache of the load time of each vertex, as ForsythVertexCacheOptimizer
+    void ResetCache(int vertexCount, int cacheSize);
+    void FlushCache() { m_Clock += m_CacheSize + 1; }
+    int LoadVertex(int vertex);
+
+    int m_CacheSize;
+    int m_Clock;
+    XArray<int> m_LoadTimes;
+    XArray<int> m_ClusterStarts; // First face of each cluster
+    XArray<float> m_ClusterKeys;
+    RadixSorter m_Sorter;
+
+    // Overdraw counter
+    XArray<float> m_Depths;
+};
+
+#endif // OVERDRAWOPTIMIZER_H
@@ -0,0 +1,115 @@
+/// @file PointIndex.h
+/// @brief Spatial index for nearest point and radius queries
+
+#ifndef POINTINDEX_H
+#define POINTINDEX_H
+
+#include "VxVector.h"
+#include "XArray.h"
+
+class CKJobPool;
+
+/// Spatial index of 3D points for nearest point and radius queries.
+/// Usage: SetMode() -> SetCellSize() -> AddPoint() -> Build() -> FindNearest() / FindInRadius()
+///
+/// Build() sorts the points into one contiguous array, by cell or by k-d
+/// tree leaf. In HASHED_GRID mode an open addressing table holds the
+/// occupied cells only, so memory follows the point count and not the extent
+/// of the points. KD_TREE mode suits very uneven densities where no single
+/// cell size fits. Queries only read the index: once built, it can be queried
+/// from several threads.
+class PointIndex {
+public:
+    enum Mode {
+        HASHED_GRID, ///< Uniform cells of SetCellSize()
+        KD_TREE      ///< Median split tree, no cell size to tune
+    };
+
+    PointIndex();
+    ~PointIndex();
+
+    /// Sets the structure built by the next Build().
+    void SetMode(Mode mode) { m_Mode = mode; }
+    Mode GetMode() const { return m_Mode; }
+
+    /// Sets the cell size of HASHED_GRID mode, used by the next Build().
+    /// Cells a few times the query radius keep most queries in one cell.
+    void SetCellSize(float size) { m_CellSize = (size > 0.0f) ? size : 1.0f; }
+    float GetCellSize() const { return m_CellSize; }
+
+    /// Removes all the points.
+    void Clear();
+    void Reserve(int count);
+
+    /// Adds a point with the index returned by the queries. Points added
+    /// after Build() are found once Build() is called again.
+    void AddPoint(const VxVector &p, int index);
+    int GetPointCount() const { return m_Positions.Size(); }
+
+    void Build();
+
+    /// Index of the nearest point within radius (inclusive), or -1. Among
+    /// points at the same distance, the one added first wins.
+    int FindNearest(const VxVector &p, float radius) const;
+
+    /// FindNearest for count points read every stride bytes, results[i] for
+    /// the point i. The queries are split across the threads of pool if any.
+    void FindNearest(const VxVector *points, CKDWORD stride, int count, float radius, int *results,
+                     CKJobPool *pool = nullptr) const;
+
+    /// Appends the indices of all the points within radius (inclusive) to
+    /// results, in the order they were added, and returns their count.
+    int FindInRadius(const VxVector &p, float radius, XArray<int> &results) const;
+
+protected:
+    struct Point {
+        VxVector pt;
+        int order; // Rank of the point in the addition order
+    };
+
+    // Slot of the cell table, empty when count is 0
+    struct Cell {
+        int x, y, z;
+        int start; // First point of the cell in m_Points
+        int count;
+    };
+
+    struct Node {
+        int begin, end;   // Points of the node in m_Points
+        int left, right;  // Children, -1 for a leaf
+        int axis;
+        float split;
+    };
+
+    void BuildGrid();
+    void BuildTree();
+    int BuildNode(int begin, int end);
+    static void SelectPoint(Point *points, int begin, int end, int nth, int axis);
+
+    int CellCoord(float value) const;
+    int FindCellSlot(int x, int y, int z) const;
+
+    // Calls visitor(point) for the points possibly within radius: the
+    // cells of the box around p or the tree leaves reaching the sphere.
+    // best2 is read again for each tree node, so the nearest point search
+    // can shrink it as it goes.
+    template <class Visitor>
+    void VisitPoints(const VxVector &p, float radius, const float &best2, Visitor &visitor) const;
+
+    Mode m_Mode;
+    float m_CellSize;
+    float m_InvCellSize;
+
+    XArray<VxVector> m_Positions; // Added points
+    XArray<int> m_Indices;        // Index of each added point
+    XArray<Point> m_Points;       // Points by cell or leaf
+    int m_BuiltCount;
+
+    XArray<Cell> m_Cells; // Power of two open addressing table
+    int m_CellCount;
+    XArray<int> m_PointSlots; // Build scratch: cell slot of each added point
+
+    XArray<Node> m_Nodes;
+};
+
+#endif // POINTINDEX_H
@@ -11,6 +11,7 @@
 #include "VxMatrix.h"
 
 class RCKSkin;
+struct CKSkinJob;
 
 class RCK3dEntity : public RCKRenderObject {
 public:
@@ -61,7 +62,22 @@ public:
     // Matrix change propagation methods
     void WorldMatrixChanged(int updateChildren, int keepScale);
     void LocalMatrixChanged(int updateChildren, int keepScale);
+    void UpdateWorldMatrixFromLocal(int keepScale);
     void WorldPositionChanged(int updateChildren, int keepScale);
+
+    // Lazy world matrices: when an entity moves, its descendants are only
+    // flagged as moved (MarkChildrenMoved). Their world matrix is recomputed
+    // from the parent when it is read, or for all the moved entities by
+    // RCKRenderManager::ResolveMovedEntities before drawing. Code reading
+    // m_WorldMatrix directly calls ResolveWorldMatrix first.
+    void ResolveWorldMatrix() const {
+        if (m_WorldMatrixDirty)
+            const_cast<RCK3dEntity *>(this)->ComputeDirtyWorldMatrix();
+    }
+    // Resolves the world matrix before a change that reads it, and with
+    // keepChildren the children ones the change keeps
+    void ResolveBeforeMove(CKBOOL keepChildren);
+    void MarkChildrenMoved();
     
     // Save the current world matrix as the last frame matrix
     void SaveLastFrameMatrix();
@@ -69,6 +85,12 @@ public:
     // Place hierarchy management
     void UpdatePlace(CK_ID placeId);
 
+    // UpdateSkin in two halves around RCKSkin::CalcPointsBatch, for
+    // RCKRenderManager::BatchSkins. PrepareSkinJob returns FALSE when
+    // UpdateSkin fails before skinning.
+    CKBOOL PrepareSkinJob(CKSkinJob &job);
+    CKBOOL FinishSkinJob(const CKSkinJob &job);
+
     //--------------------------------------------
     // Class Registering	{Secret}
     static CKSTRING GetClassName();
@@ -117,6 +139,14 @@ public:
     VxRect m_RenderExtents;
     // Offset 0x1A4: Scene graph node for render ordering
     CKSceneGraphNode *m_SceneGraphNode;
+    // Not in the original layout: an ancestor moved since m_WorldMatrix was
+    // computed, see ResolveWorldMatrix
+    CKBOOL m_WorldMatrixDirty;
+
+protected:
+    void ComputeDirtyWorldMatrix();
+    // Box invalidation and moved entity notification of a world matrix change
+    void FlagMoved(int keepScale);
 };
 
 #endif // RCK3DENTITY_H
@@ -5,6 +5,7 @@
 
 #include "CKKeyedAnimation.h"
 #include "RCKAnimation.h"
+#include "CKAnimationBatch.h"
 
 class RCKKeyedAnimation : public RCKAnimation {
     friend class RCKCharacter;  // Allow RCKCharacter to access protected members
@@ -34,6 +35,8 @@ public:
     CKERROR RemapDependencies(CKDependenciesContext &context) override;
 
     // Override CKAnimation methods with RCKKeyedAnimation-specific implementations
+    void SetStep(float step) override;
+    void SetFrame(float frame) override;
     void CenterAnimation(float frame) override;
     CKAnimation *CreateMergedAnimation(CKAnimation *anim2, CKBOOL dynamic = FALSE) override;
     float CreateTransition(CKAnimation *in, CKAnimation *out, CKDWORD OutTransitionMode, float length, float FrameTo) override;
@@ -59,6 +62,7 @@ protected:
     float m_MergeFactor;               // 0x40
     RCKObjectAnimation *m_RootAnimation; // 0x44
     VxVector m_Vector;                 // 0x48-0x53 (12 bytes)
+    CKAnimationBatch m_Batch;          // Sub-animations applied by SetStep
 };
 
 #endif // RCKKEYEDANIMATION_H
@@ -2,6 +2,7 @@
 #define RCKKEYFRAMEDATA_H
 
 #include "CKKeyframeData.h"
+#include "CKMorphEngine.h"
 
 //===================================================================
 // CKKeyframeData - Container for animation controllers
@@ -23,6 +24,30 @@ struct CKKeyframeData
 
     // Factory method to create a controller
     CKAnimController *CreateController(CKANIMATION_CONTROLLER type);
+
+    // Replaces the position, rotation, scale and scale axis controllers by
+    // compressed ones within maxError (distance) and maxAngleError (radians)
+    void CompressControllers(float maxError, float maxAngleError);
+};
+
+//===================================================================
+// Key interval cached by the spline controllers
+//===================================================================
+// Evaluate keeps the interval of its last call with the cubic of that
+// interval in power form, so that evaluating again in the same interval
+// costs one polynomial and no key search. Invalidated whenever the keys or
+// their tangents may change.
+struct CKKeySegmentCache
+{
+    int Key;           // First key of the interval, -1 when invalid
+    float StartTime;   // TimeStep of that key
+    float InvLength;   // 1 / duration of the interval
+    float EaseTo;      // Ease parameters of the interval (TCB only)
+    float EaseFrom;
+    VxVector Coefs[4]; // t^3, t^2, t and constant terms
+
+    CKKeySegmentCache() : Key(-1), StartTime(0.0f), InvLength(0.0f), EaseTo(0.0f), EaseFrom(0.0f) {}
+    void Invalidate() { Key = -1; }
 };
 
 //===================================================================
@@ -45,6 +70,8 @@ public:
 
 protected:
     CKPositionKey *m_Keys;
+    // Interval of the last Evaluate, a search hint
+    int m_Cursor;
 };
 
 //===================================================================
@@ -67,6 +94,8 @@ public:
 
 protected:
     CKRotationKey *m_Keys;
+    // Interval of the last Evaluate, a search hint
+    int m_Cursor;
 };
 
 //===================================================================
@@ -89,6 +118,8 @@ public:
 
 protected:
     CKScaleKey *m_Keys;
+    // Interval of the last Evaluate, a search hint
+    int m_Cursor;
 };
 
 //===================================================================
@@ -111,6 +142,8 @@ public:
 
 protected:
     CKScaleAxisKey *m_Keys;
+    // Interval of the last Evaluate, a search hint
+    int m_Cursor;
 };
 
 //===================================================================
@@ -138,6 +171,8 @@ protected:
     CKTCBPositionKey *m_Keys;
     // Precomputed tangent data (2 tangents per key)
     VxVector *m_Tangents;
+    // Interval of the last Evaluate and its Hermite cubic
+    CKKeySegmentCache m_Segment;
 };
 
 //===================================================================
@@ -165,6 +200,8 @@ protected:
     CKTCBRotationKey *m_Keys;
     // Precomputed tangent data
     VxQuaternion *m_Tangents;
+    // Interval of the last Evaluate, a search hint
+    int m_Cursor;
 };
 
 //===================================================================
@@ -190,6 +227,7 @@ public:
 protected:
     CKTCBScaleKey *m_Keys;
     VxVector *m_Tangents;
+    CKKeySegmentCache m_Segment;
 };
 
 //===================================================================
@@ -215,6 +253,7 @@ public:
 protected:
     CKTCBScaleAxisKey *m_Keys;
     VxQuaternion *m_Tangents;
+    int m_Cursor;
 };
 
 //===================================================================
@@ -245,6 +284,8 @@ protected:
 
     CKBezierPositionKey *m_Keys;
     CKBOOL m_TangentsComputed;
+    // Interval of the last Evaluate and its Bezier cubic
+    CKKeySegmentCache m_Segment;
 };
 
 //===================================================================
@@ -273,11 +314,135 @@ protected:
 
     CKBezierScaleKey *m_Keys;
     CKBOOL m_TangentsComputed;
+    CKKeySegmentCache m_Segment;
+};
+
+//===================================================================
+// Compressed controllers
+//===================================================================
+// Linear tracks with 48 bit keys and a float time per key, made from any
+// controller of the same channel by Compress. Times and key values are kept
+// in two separate arrays so that the key search only reads times, and
+// Evaluate decodes the two keys of an interval only when it changes.
+//
+// The controller type written before DumpKeysTo data in a chunk identifies
+// the format when reading it back.
+#define CKANIMATION_COMPRESSED_CONTROL 0x00008000
+#define CKANIMATION_COMPRESSEDPOS_CONTROL \
+    ((CKANIMATION_CONTROLLER) (CKANIMATION_COMPRESSED_CONTROL | CKANIMATION_CONTROLLER_POS))
+#define CKANIMATION_COMPRESSEDROT_CONTROL \
+    ((CKANIMATION_CONTROLLER) (CKANIMATION_COMPRESSED_CONTROL | CKANIMATION_CONTROLLER_ROT))
+#define CKANIMATION_COMPRESSEDSCL_CONTROL \
+    ((CKANIMATION_CONTROLLER) (CKANIMATION_COMPRESSED_CONTROL | CKANIMATION_CONTROLLER_SCL))
+#define CKANIMATION_COMPRESSEDSCLAXIS_CONTROL \
+    ((CKANIMATION_CONTROLLER) (CKANIMATION_COMPRESSED_CONTROL | CKANIMATION_CONTROLLER_SCLAXIS))
+
+//===================================================================
+// Compressed Position / Scale Controller
+//===================================================================
+// Each component is quantized to 16 bits over the range of the track.
+class RCKCompressedVectorController : public CKAnimController
+{
+public:
+    // type is CKANIMATION_COMPRESSEDPOS_CONTROL or CKANIMATION_COMPRESSEDSCL_CONTROL
+    explicit RCKCompressedVectorController(CKANIMATION_CONTROLLER type);
+    virtual ~RCKCompressedVectorController();
+
+    virtual CKBOOL Evaluate(float TimeStep, void *res);
+    // Any position or scale key; the keys are quantized again over the new range
+    virtual int AddKey(CKKey *key);
+    // Decoded copy of the key (a CKPositionKey): editing it does not change the controller
+    virtual CKKey *GetKey(int index);
+    virtual void RemoveKey(int index);
+    virtual int DumpKeysTo(void *Buffer);
+    virtual int ReadKeysFrom(void *Buffer);
+    virtual CKBOOL Compare(CKAnimController *control, float Threshold = 0.0f);
+    virtual CKBOOL Clone(CKAnimController *control);
+
+    // Replaces the keys by a linear track within maxError (distance) of
+    // source, sampled at its keys and 4 times per frame in between. Only the
+    // samples needed to stay within maxError are kept; the kept samples add
+    // their quantization error (half a step of the range).
+    CKBOOL Compress(CKAnimController *source, float maxError);
+
+    void DecodeKey(int index, VxVector &value) const;
+    float GetKeyTime(int index) const { return m_Times[index]; }
+
+protected:
+    void SetKeys(const float *times, const VxVector *values, int count);
+    void SetRange(const VxVector *values, int count);
+    void EncodeKey(int index, const VxVector &value);
+
+    float *m_Times;
+    CKWORD *m_Values; // 3 per key
+    VxVector m_Min;
+    VxVector m_Step;  // Range / 65535
+    int m_Cursor;
+    // Interval of the last Evaluate: Coefs[2] is the difference of its keys,
+    // Coefs[3] its first key
+    CKKeySegmentCache m_Segment;
+    CKPositionKey m_KeyCopy;
+};
+
+//===================================================================
+// Compressed Rotation / Scale Axis Controller
+//===================================================================
+// Smallest three encoding: the index of the largest quaternion component
+// and the three others, quantized to 15 bits.
+class RCKCompressedQuaternionController : public CKAnimController
+{
+public:
+    // type is CKANIMATION_COMPRESSEDROT_CONTROL or CKANIMATION_COMPRESSEDSCLAXIS_CONTROL
+    explicit RCKCompressedQuaternionController(CKANIMATION_CONTROLLER type);
+    virtual ~RCKCompressedQuaternionController();
+
+    virtual CKBOOL Evaluate(float TimeStep, void *res);
+    virtual int AddKey(CKKey *key);
+    // Decoded copy of the key (a CKRotationKey): editing it does not change the controller
+    virtual CKKey *GetKey(int index);
+    virtual void RemoveKey(int index);
+    virtual int DumpKeysTo(void *Buffer);
+    virtual int ReadKeysFrom(void *Buffer);
+    virtual CKBOOL Compare(CKAnimController *control, float Threshold = 0.0f);
+    virtual CKBOOL Clone(CKAnimController *control);
+
+    // Same as RCKCompressedVectorController::Compress, maxError being an
+    // angle in radians
+    CKBOOL Compress(CKAnimController *source, float maxError);
+
+    void DecodeKey(int index, VxQuaternion &value) const;
+    float GetKeyTime(int index) const { return m_Times[index]; }
+
+protected:
+    void Resize(int count);
+
+    float *m_Times;
+    CKWORD *m_Values; // 3 per key
+    int m_Cursor;
+    // Interval of the last Evaluate, its keys in the same hemisphere
+    int m_SegmentKey;
+    float m_SegmentStart;
+    float m_SegmentInvLength;
+    VxQuaternion m_SegmentRot[2];
+    CKRotationKey m_KeyCopy;
 };
 
 //===================================================================
 // Morph Controller
 //===================================================================
+// What RCKMorphController::EvaluateChanges left in a vertex buffer
+struct CKMorphState
+{
+    int Version;     // Delta table version, 0 when the buffer content is unknown
+    int VertexCount;
+    int KeyFrom;     // Key pair and factor of the last evaluation
+    int KeyTo;
+    float Factor;
+
+    CKMorphState() : Version(0), VertexCount(0), KeyFrom(0), KeyTo(0), Factor(0.0f) {}
+    void Invalidate() { Version = 0; }
+};
+
 class RCKMorphController : public CKMorphController
 {
 public:
@@ -296,13 +461,40 @@ public:
     virtual CKBOOL Compare(CKAnimController *control, float Threshold = 0.0f);
     virtual CKBOOL Clone(CKAnimController *control);
     virtual void SetMorphVertexCount(int count);
+
+    // Read-only key access, NULL out of range
+    const CKMorphKey *GetMorphKey(int index) const {
+        return (index >= 0 && index < m_NbKeys) ? &m_Keys[index] : nullptr;
+    }
+    // To call after writing the arrays of keys returned by GetKey, which
+    // does not rebuild the delta table by itself
+    void KeysChanged() { m_DeltasDirty = TRUE; }
     
     // Get the vertex count for morph data
     int GetMorphVertexCount() const { return m_VertexCount; }
 
+    // Evaluate into a buffer that still holds the result of the previous call
+    // made with the same state: only the vertices that can differ from it are
+    // written (normals too) and listed in moved, possibly more than once.
+    // Returns the number of entries in moved, or -1 when the whole buffer
+    // was written as by Evaluate.
+    int EvaluateChanges(float TimeStep, int VertexCount, void *VertexPtr, CKDWORD VertexStride,
+                        VxCompressedVector *NormalPtr, CKMorphState &state, XArray<int> &moved);
+
 protected:
+    // Dense evaluation, used when the delta table does not support the keys
+    CKBOOL EvaluateKeys(float TimeStep, int VertexCount, void *VertexPtr, CKDWORD VertexStride,
+                        VxCompressedVector *NormalPtr);
+    // Builds the delta table if the keys changed, FALSE if it cannot be used
+    CKBOOL PrepareDeltas(int VertexCount);
+    // Key pair around TimeStep, factor 0 at the from key
+    void SelectKeys(float TimeStep, int &from, int &to, float &factor);
+
     CKMorphKey *m_Keys;
     int m_VertexCount;
+    int m_Cursor;                // Key interval of the last evaluation
+    CKBOOL m_DeltasDirty;        // Keys changed since the delta table was built
+    CKMorphDeltaTable m_Deltas;
 };
 
 #endif // RCKKEYFRAMEDATA_H
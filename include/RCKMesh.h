@@ -5,17 +5,52 @@
 
 #include "CKMesh.h"
 
+class CKMeshBVH;
+class CKMeshVertexFaces;
+
 // Forward declarations for generic functions
 void BuildFaceNormalsGenericFunc(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount);
 void BuildNormalsGenericFunc(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount);
 int RayIntersectionGenericFunc(RCKMesh *mesh, VxVector &origin, VxVector &direction, VxIntersectionDesc *desc, CK_RAYINTERSECTION mode, const VxMatrix &worldMatrix);
 void NormalizeGenericFunc(VxVertex *vertices, int count);
 
+// 32-bit index versions, used while a mesh stores wide indices
+void BuildFaceNormals32GenericFunc(CKFace *faces, CKDWORD *indices, int faceCount, VxVertex *vertices, int vertexCount);
+void BuildNormals32GenericFunc(CKFace *faces, CKDWORD *indices, int faceCount, VxVertex *vertices, int vertexCount);
+
+// Uses the mesh triangle hierarchy above the MeshRayBVHThreshold face count
+int RayIntersectionBVHFunc(RCKMesh *mesh, VxVector &origin, VxVector &direction, VxIntersectionDesc *desc, CK_RAYINTERSECTION mode, const VxMatrix &worldMatrix);
+
+// Processor specific versions (CKMeshUtilsSIMD.cpp)
+enum CK_MESHSIMD {
+    CK_MESHSIMD_NONE = 0,
+    CK_MESHSIMD_SSE2 = 1,
+    CK_MESHSIMD_AVX2 = 2,
+};
+CK_MESHSIMD GetMeshSIMDLevel();
+void BuildFaceNormalsSSE2Func(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount);
+void BuildNormalsSSE2Func(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount);
+void NormalizeSSE2Func(VxVertex *vertices, int count);
+void BuildFaceNormalsAVX2Func(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount);
+void BuildNormalsAVX2Func(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount);
+void NormalizeAVX2Func(VxVertex *vertices, int count);
+
+// Vertex attributes changed since the hardware vertex buffer was written
+enum CK_MESHVBDIRTY {
+    CK_MESHVB_POSITIONS = 0x01, // Positions, with the normals rebuilt from them
+    CK_MESHVB_NORMALS = 0x02,
+    CK_MESHVB_COLORS = 0x04,
+    CK_MESHVB_UVS = 0x08,
+};
+
 class RCKMesh : public CKMesh {
     // Friend function for ray intersection (needs access to protected members)
     friend int RayIntersectionGenericFunc(RCKMesh *mesh, VxVector &origin, VxVector &direction, 
                                                VxIntersectionDesc *desc, CK_RAYINTERSECTION mode, 
                                                const VxMatrix &worldMatrix);
+    friend int RayIntersectionBVHFunc(RCKMesh *mesh, VxVector &origin, VxVector &direction,
+                                      VxIntersectionDesc *desc, CK_RAYINTERSECTION mode,
+                                      const VxMatrix &worldMatrix);
 public:
 
     //--------------------------------------------------------
@@ -166,6 +201,10 @@ public:
     void UpdateChannelIndices();
     CKBOOL CheckHWVertexBuffer(CKRasterizerContext *rst, VxDrawPrimitiveData *data);
     CKBOOL CheckHWIndexBuffer(CKRasterizerContext *rst);
+    // TRUE when the hardware vertex buffer of vertexFormat is up to date but
+    // for a few vertices (or attributes it does not hold), so that
+    // CheckHWVertexBuffer only writes these vertices again
+    CKBOOL IsHWVertexBufferPatchable(CKDWORD vertexFormat);
 
     // Progressive mesh rendering (IDA: 0x100257b1)
     void BuildRenderMesh();
@@ -176,6 +215,59 @@ public:
     void ResetMaterialGroup(CKMaterialGroup *group, int a2);
     void UpdateHasValidPrimitives(CKMaterialGroup *group);
 
+    // Marks the ray intersection hierarchy for rebuild after geometry changes
+    void InvalidateRayBVH();
+    // VertexMove for a change limited to the vertices [first, end)
+    void VerticesMoved(int first, int end);
+    // Marks the vertex face lists for rebuild after face changes
+    void InvalidateVertexFaces();
+
+    // ModifierVertexMove for a mesh whose positions only changed at the given
+    // vertices since its normals were last built: only the normals around
+    // them are rebuilt. vertices can list a vertex more than once.
+    void ModifierVerticesMoved(const int *vertices, int count, CKBOOL RebuildNormals, CKBOOL RebuildFaceNormals);
+
+    // Records that the CK_MESHVBDIRTY attributes of the vertices [first, end)
+    // changed, for the next write of the hardware vertex buffer. The change
+    // notifications (VertexMove, ColorChanged...) record all the vertices.
+    void MarkHWVertexBufferDirty(CKDWORD attributes, int first, int end);
+
+    // Changes whenever vertices move, normals are set or faces change, so that
+    // a modifier can tell if the mesh still holds what it last wrote
+    CKDWORD GetGeometryStamp() const { return m_GeometryStamp; }
+
+    // 32-bit indices (opt-in). Once enabled, face and line indices move to
+    // m_FaceVertexIndices32 / m_LineIndices32 while the vertex count does not
+    // fit in a CKWORD, and back to 16-bit storage as soon as it does again.
+    // GetFacesIndices() and GetLineIndices() return NULL while the 32-bit
+    // arrays are in use; GetFacesIndices32() and GetLineIndices32() return
+    // NULL otherwise. Progressive meshes always keep 16-bit indices.
+    void EnableWideIndices(CKBOOL enable);
+    CKBOOL IsWideIndicesEnabled() const { return m_WideIndicesEnabled; }
+    CKBOOL HasWideIndices() const { return m_WideIndices; }
+    CKDWORD *GetFacesIndices32();
+    CKDWORD *GetLineIndices32();
+
+    // Switches the index storage to match the vertex count
+    void UpdateIndexFormat();
+
+    // Face and line index access whatever the storage
+    CKDWORD GetFaceIndexValue(int i) const {
+        return m_WideIndices ? m_FaceVertexIndices32[i] : (CKDWORD) m_FaceVertexIndices[i];
+    }
+    void SetFaceIndexValue(int i, CKDWORD index) {
+        if (m_WideIndices)
+            m_FaceVertexIndices32[i] = index;
+        else
+            m_FaceVertexIndices[i] = (CKWORD) index;
+    }
+    CKDWORD GetLineIndexValue(int i) const {
+        return m_WideIndices ? m_LineIndices32[i] : (CKDWORD) m_LineIndices[i];
+    }
+
+    // Wide index render groups: primitives in batches of 16-bit local indices
+    void CreateWideRenderGroups(CKDWORD *vertexTracker);
+
     explicit RCKMesh(CKContext *Context, CKSTRING name = nullptr);
     ~RCKMesh() override;
     CK_CLASSID GetClassID() override;
@@ -228,11 +320,21 @@ protected:
     XArray<CKMaterialGroup *> m_MaterialGroups;
     CKDWORD m_Valid;
     CKDWORD m_VertexBufferReady; // Non-zero when HW vertex buffer is up to date
+    CKDWORD m_VBDirtyAttributes; // CK_MESHVBDIRTY attributes changed since the HW vertex buffer was written
+    int m_VBDirtyFirst;          // Changed vertices [m_VBDirtyFirst, m_VBDirtyEnd)
+    int m_VBDirtyEnd;
     CKDWORD m_VertexBuffer;
     CKDWORD m_IndexBuffer;
     CKProgressiveMesh *m_ProgressiveMesh;
     CKCallbacksContainer *m_RenderCallbacks;
     CKCallbacksContainer *m_SubMeshCallbacks;
+    CKMeshBVH *m_RayBVH; // Built on the first ray intersection above the threshold
+    CKMeshVertexFaces *m_VertexFaces; // Built on the first ModifierVerticesMoved
+    CKDWORD m_GeometryStamp;
+    XArray<CKDWORD> m_FaceVertexIndices32; // Replace the 16-bit arrays while m_WideIndices is set
+    XArray<CKDWORD> m_LineIndices32;
+    CKBOOL m_WideIndicesEnabled;
+    CKBOOL m_WideIndices;
 };
 
 #endif // RCKMESH_H
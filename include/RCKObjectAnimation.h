@@ -9,6 +9,7 @@ class RCKKeyedAnimation;
 
 class RCKObjectAnimation : public CKObjectAnimation {
     friend class RCKKeyedAnimation;  // Allow access to m_ParentKeyedAnimation
+    friend class CKAnimationBatch;
 public:
     explicit RCKObjectAnimation(CKContext *Context, CKSTRING name = nullptr);
     ~RCKObjectAnimation() override;
@@ -89,6 +90,14 @@ public:
     // Set keyframe data length and propagate to all controllers
     void SetKeyframeLength(float length);
 
+    // Local matrix of SetStep from the evaluated components (transformFlags:
+    // 1 scale, 2 scale axis, 4 position, 8 rotation). Missing components are
+    // taken from the current local matrix.
+    static void ComposeLocalMatrix(VxMatrix &localMatrix, CKDWORD transformFlags, VxVector pos, VxQuaternion rot,
+                                   VxVector scale);
+    // Morph part of SetStep: moves the vertices of the entity mesh
+    void ApplyMorphTarget(float frame);
+
     // Static methods for class registration
     static CKSTRING GetClassName();
     static int GetDependenciesCount(int mode);
@@ -107,6 +116,13 @@ protected:
     RCKObjectAnimation *m_Anim2;     // 0x34 - Second source animation for merged animations
     CKDWORD m_field_38;              // 0x38 - Reserved/unknown field (set to 0 in constructor)
     RCKKeyedAnimation *m_ParentKeyedAnimation; // 0x3C - Parent keyed animation (used in SetStep)
+
+    // Morph target left in the mesh by ApplyMorphTarget, so that the next
+    // frame only rewrites the vertices that change
+    CKMorphState m_MorphState;
+    RCKMesh *m_MorphMesh;
+    CKDWORD m_MorphMeshStamp; // Mesh geometry stamp after the last morph
+    XArray<int> m_MorphMoved;
 };
 
 #endif // RCKOBJECTANIMATION_H
@@ -5,6 +5,9 @@
 #include "CKRenderContext.h"
 #include "CKRenderedScene.h"
 #include "CKRasterizerEnums.h"
+#include "CKPickGrid.h"
+#include "CKOcclusionBuffer.h"
+#include "CKPortalVisibility.h"
 
 // Forward declarations
 class RCKMaterial;
@@ -179,6 +182,7 @@ public:
     // Internal pick methods
     CK3dEntity *Pick3D(const Vx2DVector &pt, VxIntersectionDesc *desc, CK3dEntity *filter, CKBOOL ignoreUnpickable);
     CK2dEntity *_Pick2D(const Vx2DVector &pt, CKBOOL ignoreUnpickable);
+    void UpdatePickGrid();
 
     CKERROR Create(void *Window, int Driver, CKRECT *rect, CKBOOL Fullscreen, int Bpp, int Zbpp, int StencilBpp, int RefreshRate);
     VxStats &GetStats() {
@@ -308,6 +312,21 @@ public:
     CKDWORD m_PVInformation;                // 0x3B8 (4 bytes)
     // Total: 956 bytes (0x3BC)
 
+    // Pick acceleration, rebuilt from m_ObjectExtents on the first pick after they change
+    CKPickGrid m_PickGrid;
+    CKBOOL m_ObjectExtentsCollected; // A DrawScene refilled m_ObjectExtents since the last DetachAll
+    XArray<int> m_PickIndices;
+    XArray<CKPickCandidate> m_PickCandidates;
+
+    // Occluders of the current scene traversal (OcclusionCulling option).
+    // VxStats has no room for its counts: they are read from the buffer.
+    CKOcclusionBuffer m_OcclusionBuffer;
+    CKBOOL m_OcclusionActive;
+
+    // Places seen through the portals of the camera place (PortalCulling option)
+    CKPortalVisibility m_PortalVisibility;
+    CKBOOL m_PortalActive;
+
     void OnClearAll();
 };
 
@@ -6,9 +6,15 @@
 #include "CKRenderEngineEnums.h"
 #include "CKRenderManager.h"
 #include "CKSceneGraph.h"
+#include "CKSceneGraphBVH.h"
 #include "VertexCacheOptimizer.h"
+#include "ForsythVertexCacheOptimizer.h"
+#include "OverdrawOptimizer.h"
+#include "CKJobPool.h"
+#include "RCKSkin.h"
 
 class RCK3dEntity;
+class RCKRenderContext;
 
 class RCKRenderManager : public CKRenderManager {
 public:
@@ -47,6 +53,20 @@ public:
 
     CKMaterial *GetDefaultMaterial();
 
+    // Worker threads shared by the engine tasks (skinning), started on first
+    // use with the WorkerThreads option
+    CKJobPool *GetJobPool();
+
+    // Skins of the opaque entities a render context is about to draw, in one
+    // RCKSkin::CalcPointsBatch over the job pool. Until EndSkinBatch,
+    // RCK3dEntity::Render skips UpdateSkin for them unless their owner, mesh
+    // or bones changed since (e.g. moved by an earlier render callback).
+    void BatchSkins(RCKRenderContext *rc);
+    void EndSkinBatch() { m_SkinBatch = 0; }
+    CKBOOL IsSkinBatched(RCKSkin *skin, CK3dEntity *owner) const {
+        return m_SkinBatch != 0 && skin->GetBatch() == m_SkinBatch && skin->IsBatchCurrent(owner);
+    }
+
     CKDWORD CreateObjectIndex(CKRST_OBJECTTYPE type);
     CKBOOL ReleaseObjectIndex(CKDWORD index, CKRST_OBJECTTYPE type);
 
@@ -79,6 +99,14 @@ public:
 
     // Entity movement tracking (called when entities move)
     void AddMovedEntity(RCK3dEntity *entity) { m_MovedEntities.PushBack((CKObject*)entity); }
+    // Computes the world matrices left dirty by moved parents, parents first.
+    // Every dirty entity was flagged as moved, so it is in the list.
+    void ResolveMovedEntities();
+
+    // Occluders of the OcclusionCulling option: the current mesh of these
+    // entities hides the scene graph nodes behind it
+    void SetOccluder(CK3dEntity *entity, CKBOOL occluder);
+    CKBOOL IsOccluder(CK3dEntity *entity);
 
     // Render context mask management
     CKDWORD GetRenderContextMaskFree() { return m_RenderContextMaskFree; }
@@ -102,6 +130,8 @@ public:
     XObjectPointerArray m_MovedEntities;                     // 0xB8
     XObjectPointerArray m_Entities;                          // 0xC4
     VertexCacheOptimizer m_VertexCacheOptimizer;             // 0xD0
+    ForsythVertexCacheOptimizer m_ForsythVertexCacheOptimizer;
+    OverdrawOptimizer m_OverdrawOptimizer;
     XArray<CKVertexBuffer *> m_VertexBuffers;
     VxOption m_ForceLinearFog;
     VxOption m_ForceSoftware;
@@ -115,17 +145,34 @@ public:
     VxOption m_EnableScreenDump;
     VxOption m_EnableDebugMode;
     VxOption m_VertexCache;
+    VxOption m_VertexCacheOptimizerType;
+    VxOption m_OverdrawThreshold;
     VxOption m_SortTransparentObjects;
     VxOption m_TextureCacheManagement;
     VxOption m_DisablePerspectiveCorrection;
     VxOption m_TextureVideoFormat;
     VxOption m_SpriteVideoFormat;
+    VxOption m_FlatSceneCulling;
+    VxOption m_MeshRayBVHThreshold;
+    VxOption m_WorkerThreads;
+    VxOption m_OcclusionCulling;
+    VxOption m_OcclusionBufferWidth;
+    VxOption m_PortalCulling;
     XArray<VxOption*> m_Options;
     CK2dEntity *m_2DRootFore;
     CK2dEntity *m_2DRootBack;
     CK_ID m_2DRootBackId;
     CK_ID m_2DRootForeId;
     XClassArray<VxEffectDescription> m_Effects;
+    CKTransparentSorter m_TransparentSorter;
+    CKSceneGraphBVH m_SceneGraphBVH;
+    CKJobPool m_JobPool;
+    CKBOOL m_JobPoolStarted;
+    XArray<RCK3dEntity *> m_SkinEntities;
+    XArray<CKSkinJob> m_SkinJobs;
+    CKDWORD m_SkinBatch;      // Batch of the current traversal, 0 outside
+    CKDWORD m_SkinBatchCount;
+    XObjectPointerArray m_Occluders;
 };
 
 #endif // RCKRENDERMANAGER_H
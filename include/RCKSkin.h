@@ -6,8 +6,11 @@
 #include "VxVector.h"
 #include "VxBbox.h"
 #include "VxMatrix.h"
+#include "CKSkinEngine.h"
 
 class CK3dEntity;
+class CKMesh;
+class CKJobPool;
 class CKContext;
 class RCK3dEntity;
 
@@ -96,7 +99,8 @@ protected:
  * 
  * Manages skeletal skinning for meshes. Contains:
  * - Arrays of bone data and vertex data
- * - Per-bone point lists for efficient skinning calculations
+ * - A vertex-major influence table for the skinning kernels, or per-bone
+ *   point lists for skins the table cannot hold
  * - Optional normal skinning data
  * - Matrices for coordinate transformation
  */
@@ -133,20 +137,47 @@ public:
     // If owner == NULL, raw bone world positions are used.
     CKBOOL CalcBonesBBox(CKContext *context, CK3dEntity *owner, VxBbox *bbox);
 
+    // Runs the CalcPointsEx calls of several skins, splitting large skins in
+    // vertex chunks over the pool (NULL runs everything on the calling thread).
+    // Each job receives the CalcPointsEx return value in Result.
+    static void CalcPointsBatch(CKSkinJob *jobs, int jobCount, CKJobPool *pool);
+
     // Internal methods
     void BuildBonePointLists();
     void ClearBonePointLists();
 
     const VxMatrix &GetObjectInitMatrix() const { return m_ObjectInitMatrix; }
 
+    // Last RCKRenderManager::BatchSkins that skinned this skin (0 = none).
+    // SetBatch records the owner mesh and the owner and bone world matrices
+    // the batch used; IsBatchCurrent is FALSE once any of them has changed.
+    CKDWORD GetBatch() const { return m_Batch; }
+    void SetBatch(CKDWORD batch, CK3dEntity *owner);
+    CKBOOL IsBatchCurrent(CK3dEntity *owner);
+
 protected:
+    // Fills what the influence table kernels do not write and returns the
+    // number of vertices left to skin (0 when the job is complete)
+    int PrepareCalcPoints(CKSkinJob &job);
+    // Original bone-major path, used when the influence table cannot be built
+    CKBOOL CalcPointsFromBoneLists(int VertexCount, CKBYTE *VertexPtr, CKDWORD VStride, CKBYTE *NormalPtr, CKDWORD NStride);
+    // Transform matrix of every bone used by the table, zero for missing bones.
+    // Returns FALSE if no used bone is valid.
+    CKBOOL BuildBonePalette();
+    void UpdateBoneTransform(RCKSkinBoneData &boneData, CK3dEntity *bone);
+
     VxMatrix m_ObjectInitMatrix;                       // Original world matrix of the owner entity
     VxMatrix m_InverseWorldMatrix;                     // Inverse of object init matrix
     XClassArray<RCKSkinBoneData> m_BoneData;          // Array of bone data
     XClassArray<RCKSkinBonePoints> m_Points;          // Per-bone vertex/normal lists
+    CKSkinInfluenceTable m_Influences;                 // Vertex-major weights (replaces m_Points when built)
+    XArray<VxMatrix> m_Palette;                        // Per-bone matrices of the last CalcPointsEx
     XClassArray<RCKSkinVertexData> m_VertexData;      // Array of vertex data
     XClassArray<VxVector> m_Normals;                  // Optional normal array
     CKDWORD m_Flags;                                   // Skin flags (bit 0 = use weighted mode)
+    CKDWORD m_Batch;                                   // See GetBatch
+    CKMesh *m_BatchMesh;                               // Owner mesh of SetBatch
+    XArray<VxMatrix> m_BatchMatrices;                  // Owner then bone world matrices of SetBatch
 };
 
 #endif // RCKSKIN_H
@@ -703,6 +703,7 @@ RCK3dEntity::RCK3dEntity(CKContext *Context, CKSTRING name) : RCKRenderObject(Co
     m_Skin = nullptr;
     m_LastFrameMatrix = nullptr;
     m_SceneGraphNode = nullptr;
+    m_WorldMatrixDirty = FALSE;
 
     m_LocalMatrix = VxMatrix::Identity();
     m_WorldMatrix = VxMatrix::Identity();
@@ -812,6 +813,9 @@ CKBOOL RCK3dEntity::SetParent(CK3dEntity *Parent, CKBOOL KeepWorldPos) {
         }
     }
 
+    // The world matrix depends on the old parent until now
+    ResolveWorldMatrix();
+
     // Remove from old parent's children array
     if (m_Parent) {
         m_Parent->m_Children.Remove(this);
@@ -1142,6 +1146,10 @@ Implementation based on decompilation at 0x1000579f:
   - Update scene graph node priority (10000 for RENDERFIRST, 0 otherwise)
 *************************************************/
 CKDWORD RCK3dEntity::ModifyMoveableFlags(CKDWORD Add, CKDWORD Remove) {
+    // Stops following the parent from the current world matrix
+    if ((Add & VX_MOVEABLE_DONTUPDATEFROMPARENT) != 0)
+        ResolveWorldMatrix();
+
     // Apply flag changes
     m_MoveableFlags &= ~Remove;
     m_MoveableFlags |= Add;
@@ -1275,6 +1283,7 @@ void RCK3dEntity::LookAt(const VxVector *Pos, CK3dEntity *Ref, CKBOOL KeepChildr
     // - If Dot(up, oldUpAxis) < 0, negate up and right (avoid flip)
     // - Calls SetOrientation(dir, up, right, Ref=NULL)
 
+    ResolveWorldMatrix();
     const VxVector currentWorldPos(m_WorldMatrix[3][0], m_WorldMatrix[3][1], m_WorldMatrix[3][2]);
 
     VxVector targetWorld;
@@ -1395,6 +1404,7 @@ void RCK3dEntity::Translate(const VxVector *Vect, CK3dEntity *Ref, CKBOOL KeepCh
     }
 
     // IDA: Add to world matrix row 3 (translation)
+    ResolveBeforeMove(KeepChildren);
     m_WorldMatrix[3][0] += trans.x;
     m_WorldMatrix[3][1] += trans.y;
     m_WorldMatrix[3][2] += trans.z;
@@ -1430,6 +1440,7 @@ void RCK3dEntity::AddScale(const VxVector *Scale, CKBOOL KeepChildren, CKBOOL Lo
         Vx3DMultiplyMatrix(newMat, m_LocalMatrix, scaleMat);
         SetLocalMatrix(newMat, KeepChildren);
     } else {
+        ResolveWorldMatrix();
         Vx3DMultiplyMatrix(newMat, m_WorldMatrix, scaleMat);
         SetWorldMatrix(newMat, KeepChildren);
     }
@@ -1458,6 +1469,7 @@ void RCK3dEntity::SetPosition(const VxVector *Pos, CK3dEntity *Ref, CKBOOL KeepC
     //      RCK3dEntity::WorldPositionChanged(this, KeepChildren, 1);
 
     // Get pointer to translation component (row 3) of world matrix
+    ResolveBeforeMove(KeepChildren);
     VxVector *worldPos = &m_WorldMatrix[3];
 
     if (Ref) {
@@ -1482,6 +1494,7 @@ Implementation based on decompilation at 0x10006b51:
 - If Ref is null: return world position directly
 *************************************************/
 void RCK3dEntity::GetPosition(VxVector *Pos, CK3dEntity *Ref) const {
+    ResolveWorldMatrix();
     if (Ref) {
         if (Ref == (CK3dEntity *) m_Parent) {
             // IDA: Return local matrix row 3 (position relative to parent)
@@ -1505,6 +1518,7 @@ void RCK3dEntity::SetOrientation(const VxVector *Dir, const VxVector *Up, const
     // IDA @ 0x10006CC3
     constexpr float kEps = 0.000001f;
 
+    ResolveBeforeMove(KeepChildren);
     VxVector prevScale;
     GetScale(&prevScale, FALSE);
     if (prevScale.x == 0.0f) prevScale.x = kEps;
@@ -1594,6 +1608,7 @@ void RCK3dEntity::GetOrientation(VxVector *Dir, VxVector *Up, VxVector *Right, C
     // - If Ref: computes (Ref^-1 * thisWorld), then returns normalized axes
     // - Else: returns normalized axes from GetWorldMatrix()
     if (Ref) {
+        ResolveWorldMatrix();
         VxMatrix tmp;
         Vx3DMultiplyMatrix(tmp, Ref->GetInverseWorldMatrix(), m_WorldMatrix);
 
@@ -1894,7 +1909,7 @@ CKERROR RCK3dEntity::Copy(CKObject &o, CKDependenciesContext &context) {
     SetZOrder(zOrder);
 
     // Copy world matrix
-    SetWorldMatrix(src.m_WorldMatrix, TRUE);
+    SetWorldMatrix(src.GetWorldMatrix(), TRUE);
 
     // Copy meshes array
     m_Meshes = src.m_Meshes;
@@ -2111,6 +2126,9 @@ void RCK3dEntity::WorldMatrixChanged(int updateChildren, int keepScale) {
         }
     }
 
+    // The world matrix was written by the caller
+    m_WorldMatrixDirty = FALSE;
+
     // Update local matrix based on parent relationship
     if (m_Parent) {
         // LocalMatrix = ParentInverseWorld * WorldMatrix
@@ -2123,7 +2141,8 @@ void RCK3dEntity::WorldMatrixChanged(int updateChildren, int keepScale) {
 
     // Handle children
     if (updateChildren) {
-        // Keep children's world positions - recalculate their local matrices
+        // Keep children's world positions - recalculate their local matrices.
+        // The caller resolved them before changing our world matrix.
         GetInverseWorldMatrix(); // Force recalculation of inverse matrix
 
         for (CKObject **it = m_Children.Begin(); it != m_Children.End(); ++it) {
@@ -2134,13 +2153,8 @@ void RCK3dEntity::WorldMatrixChanged(int updateChildren, int keepScale) {
             }
         }
     } else {
-        // Children move with parent - propagate local matrix changes
-        for (CKObject **it = m_Children.Begin(); it != m_Children.End(); ++it) {
-            RCK3dEntity *child = (RCK3dEntity *) *it;
-            if (child && !(child->m_MoveableFlags & VX_MOVEABLE_DONTUPDATEFROMPARENT)) {
-                child->LocalMatrixChanged(FALSE, FALSE);
-            }
-        }
+        // Children move with parent - their world matrices follow when read
+        MarkChildrenMoved();
     }
 }
 
@@ -2156,6 +2170,52 @@ Implementation based on decompilation at 0x100064a4:
 - Propagates changes to children similar to WorldMatrixChanged
 *************************************************/
 void RCK3dEntity::LocalMatrixChanged(int updateChildren, int keepScale) {
+    UpdateWorldMatrixFromLocal(keepScale);
+
+    // Handle children
+    if (updateChildren) {
+        // Keep children's world positions, resolved by the caller
+        GetInverseWorldMatrix();
+
+        for (CKObject **it = m_Children.Begin(); it != m_Children.End(); ++it) {
+            RCK3dEntity *child = (RCK3dEntity *) *it;
+            if (child && !(child->m_MoveableFlags & VX_MOVEABLE_DONTUPDATEFROMPARENT)) {
+                Vx3DMultiplyMatrix(child->m_LocalMatrix, m_InverseWorldMatrix, child->m_WorldMatrix);
+            }
+        }
+    } else {
+        // Children move with parent
+        MarkChildrenMoved();
+    }
+}
+
+/*************************************************
+Summary: UpdateWorldMatrixFromLocal - LocalMatrixChanged without the children.
+Purpose: Lets a caller that updates a whole hierarchy parents first (see
+CKAnimationBatch) visit each entity once.
+*************************************************/
+void RCK3dEntity::UpdateWorldMatrixFromLocal(int keepScale) {
+    FlagMoved(keepScale);
+
+    // Update world matrix based on parent relationship
+    if (m_Parent) {
+        // WorldMatrix = ParentWorld * LocalMatrix
+        m_Parent->ResolveWorldMatrix();
+        Vx3DMultiplyMatrix(m_WorldMatrix, m_Parent->m_WorldMatrix, m_LocalMatrix);
+    } else {
+        // No parent - world matrix equals local matrix
+        m_WorldMatrix = m_LocalMatrix;
+    }
+    m_WorldMatrixDirty = FALSE;
+}
+
+/*************************************************
+Summary: FlagMoved - Bookkeeping of a world matrix change.
+Purpose: Shared by UpdateWorldMatrixFromLocal and MarkChildrenMoved, so that a
+descendant whose world matrix is computed later is flagged as when it was
+updated right away.
+*************************************************/
+void RCK3dEntity::FlagMoved(int keepScale) {
     // Invalidate scene graph node's bounding box
     if (m_SceneGraphNode) {
         m_SceneGraphNode->InvalidateBox(keepScale);
@@ -2174,34 +2234,48 @@ void RCK3dEntity::LocalMatrixChanged(int updateChildren, int keepScale) {
             renderManager->AddMovedEntity(this);
         }
     }
+}
 
-    // Update world matrix based on parent relationship
+/*************************************************
+Summary: MarkChildrenMoved - Flags the descendants moving with this entity.
+Purpose: Replaces the LocalMatrixChanged recursion: the descendants get the
+moved bookkeeping now and their world matrix when read. A dirty child already
+has a dirty subtree, so the walk stops there and moving the bones of a
+hierarchy one by one visits each descendant once.
+*************************************************/
+void RCK3dEntity::MarkChildrenMoved() {
+    for (CKObject **it = m_Children.Begin(); it != m_Children.End(); ++it) {
+        RCK3dEntity *child = (RCK3dEntity *) *it;
+        if (child && !child->m_WorldMatrixDirty && !(child->m_MoveableFlags & VX_MOVEABLE_DONTUPDATEFROMPARENT)) {
+            child->FlagMoved(FALSE);
+            child->m_WorldMatrixDirty = TRUE;
+            child->MarkChildrenMoved();
+        }
+    }
+}
+
+/*************************************************
+Summary: ComputeDirtyWorldMatrix - Computes a world matrix left dirty.
+Purpose: Same product as UpdateWorldMatrixFromLocal, from the resolved parent
+matrix, so the result does not depend on when it is computed.
+*************************************************/
+void RCK3dEntity::ComputeDirtyWorldMatrix() {
     if (m_Parent) {
-        // WorldMatrix = ParentWorld * LocalMatrix
+        m_Parent->ResolveWorldMatrix();
         Vx3DMultiplyMatrix(m_WorldMatrix, m_Parent->m_WorldMatrix, m_LocalMatrix);
     } else {
-        // No parent - world matrix equals local matrix
         m_WorldMatrix = m_LocalMatrix;
     }
+    m_WorldMatrixDirty = FALSE;
+}
 
-    // Handle children
-    if (updateChildren) {
-        // Keep children's world positions
-        GetInverseWorldMatrix();
-
-        for (CKObject **it = m_Children.Begin(); it != m_Children.End(); ++it) {
-            RCK3dEntity *child = (RCK3dEntity *) *it;
-            if (child && !(child->m_MoveableFlags & VX_MOVEABLE_DONTUPDATEFROMPARENT)) {
-                Vx3DMultiplyMatrix(child->m_LocalMatrix, m_InverseWorldMatrix, child->m_WorldMatrix);
-            }
-        }
-    } else {
-        // Children move with parent
+void RCK3dEntity::ResolveBeforeMove(CKBOOL keepChildren) {
+    ResolveWorldMatrix();
+    if (keepChildren) {
         for (CKObject **it = m_Children.Begin(); it != m_Children.End(); ++it) {
             RCK3dEntity *child = (RCK3dEntity *) *it;
-            if (child && !(child->m_MoveableFlags & VX_MOVEABLE_DONTUPDATEFROMPARENT)) {
-                child->LocalMatrixChanged(FALSE, FALSE);
-            }
+            if (child)
+                child->ResolveWorldMatrix();
         }
     }
 }
@@ -2242,6 +2316,9 @@ void RCK3dEntity::WorldPositionChanged(int updateChildren, int keepScale) {
         }
     }
 
+    // The world matrix was written by the caller
+    m_WorldMatrixDirty = FALSE;
+
     // Update local matrix based on parent relationship
     if (m_Parent) {
         // LocalMatrix = ParentInverseWorld * WorldMatrix
@@ -2289,13 +2366,8 @@ void RCK3dEntity::WorldPositionChanged(int updateChildren, int keepScale) {
             }
         }
     } else {
-        // Children move with parent - propagate local matrix changes
-        for (CKObject **it = m_Children.Begin(); it != m_Children.End(); ++it) {
-            RCK3dEntity *child = (RCK3dEntity *) *it;
-            if (child && (child->m_MoveableFlags & VX_MOVEABLE_DONTUPDATEFROMPARENT) == 0) {
-                child->LocalMatrixChanged(FALSE, FALSE);
-            }
-        }
+        // Children move with parent
+        MarkChildrenMoved();
     }
 }
 
@@ -2315,7 +2387,7 @@ void RCK3dEntity::SaveLastFrameMatrix() {
     if (!m_LastFrameMatrix) {
         m_LastFrameMatrix = new VxMatrix();
     }
-    memcpy(m_LastFrameMatrix, &m_WorldMatrix, sizeof(VxMatrix));
+    memcpy(m_LastFrameMatrix, &GetWorldMatrix(), sizeof(VxMatrix));
 }
 
 void RCK3dEntity::UpdatePlace(CK_ID placeId) {
@@ -2343,6 +2415,7 @@ void RCK3dEntity::SetQuaternion(const VxQuaternion *Quat, CK3dEntity *Ref, CKBOO
     // - Else: world = QuatMatrix, then restore translation
     // - Calls WorldMatrixChanged(KeepChildren, 1)
 
+    ResolveBeforeMove(KeepChildren);
     VxVector savedLocalScale;
     if (KeepScale) {
         GetScale(&savedLocalScale, TRUE);
@@ -2375,6 +2448,7 @@ void RCK3dEntity::GetQuaternion(VxQuaternion *Quat, CK3dEntity *Ref) {
     // - If Ref: quat from (Ref^-1 * thisWorld)
     // - Else: quat from thisWorld
     // - Uses FromMatrix(MatIsUnit=FALSE, RestoreMat=TRUE)
+    ResolveWorldMatrix();
     if (Ref) {
         VxMatrix tmp;
         Vx3DMultiplyMatrix(tmp, Ref->GetInverseWorldMatrix(), m_WorldMatrix);
@@ -2401,6 +2475,8 @@ void RCK3dEntity::SetScale(const VxVector *Scale, CKBOOL KeepChildren, CKBOOL Lo
     const float sy = (Scale->y == 0.0f) ? kEps : Scale->y;
     const float sz = (Scale->z == 0.0f) ? kEps : Scale->z;
 
+    if (KeepChildren || !Local)
+        ResolveBeforeMove(KeepChildren);
     VxMatrix &mat = Local ? m_LocalMatrix : m_WorldMatrix;
 
     {
@@ -2439,6 +2515,8 @@ void RCK3dEntity::GetScale(VxVector *Scale, CKBOOL Local) {
     if (!Scale)
         return;
 
+    if (!Local)
+        ResolveWorldMatrix();
     const VxMatrix &mat = Local ? m_LocalMatrix : m_WorldMatrix;
     VxVector axis0 = mat[0];
     VxVector axis1 = mat[1];
@@ -2552,6 +2630,9 @@ CKBOOL RCK3dEntity::Render(CKRenderContext *Dev, CKDWORD Flags) {
     // Flush pending Sprite3D batches (only when needed).
     dev->FlushSprite3DBatchesIfNeeded();
 
+    // A callback may have moved a parent since the scene was resolved
+    ResolveWorldMatrix();
+
     // Check if extents are up to date (meaning we've already been verified visible)
     if ((m_MoveableFlags & VX_MOVEABLE_EXTENTSUPTODATE) != 0) {
         // Extents are valid - we know we're visible
@@ -2588,8 +2669,9 @@ CKBOOL RCK3dEntity::Render(CKRenderContext *Dev, CKDWORD Flags) {
     if (m_Skin && m_CurrentMesh) {
         if (m_CurrentMesh->IsPM()) {
             isPM = TRUE;
-        } else {
-            // Update skin before callbacks
+        } else if (!dev->m_RenderManager->IsSkinBatched(m_Skin, this)) {
+            // Update skin before callbacks, unless RCKRenderManager::BatchSkins did
+            // with the current bones
             dev->m_SkinTimeProfiler.Reset();
             UpdateSkin();
             dev->m_Stats.SkinTime += dev->m_SkinTimeProfiler.Current();
@@ -2701,6 +2783,7 @@ int RCK3dEntity::RayIntersection(const VxVector *Pos1, const VxVector *Pos2, VxI
     if (Desc)
         Desc->Object = (CKRenderObject *) Ref;
 
+    ResolveWorldMatrix();
     const int hit = g_RayIntersection ? g_RayIntersection(mesh, localP1, dir, Desc, iOptions, m_WorldMatrix) : 0;
     if (hit && Desc) {
         Desc->Object = (CKRenderObject *) this;
@@ -2720,7 +2803,7 @@ const VxMatrix &RCK3dEntity::GetLastFrameMatrix() const {
     // - else return &m_WorldMatrix
     if (m_LastFrameMatrix)
         return *m_LastFrameMatrix;
-    return m_WorldMatrix;
+    return GetWorldMatrix();
 }
 
 /*************************************************
@@ -2732,6 +2815,9 @@ Implementation based on decompilation at 0x10008874:
 - Calls LocalMatrixChanged(KeepChildren, 1)
 *************************************************/
 void RCK3dEntity::SetLocalMatrix(const VxMatrix &Mat, CKBOOL KeepChildren) {
+    // The new matrix is complete, only the kept children need resolving
+    if (KeepChildren)
+        ResolveBeforeMove(TRUE);
     m_LocalMatrix = Mat;
     LocalMatrixChanged(KeepChildren, TRUE);
 }
@@ -2749,11 +2835,14 @@ Implementation based on decompilation at 0x100088c4:
 - Calls WorldMatrixChanged(KeepChildren, 1)
 *************************************************/
 void RCK3dEntity::SetWorldMatrix(const VxMatrix &Mat, CKBOOL KeepChildren) {
+    if (KeepChildren)
+        ResolveBeforeMove(TRUE);
     m_WorldMatrix = Mat;
     WorldMatrixChanged(KeepChildren, TRUE);
 }
 
 const VxMatrix &RCK3dEntity::GetWorldMatrix() const {
+    ResolveWorldMatrix();
     return m_WorldMatrix;
 }
 
@@ -2770,6 +2859,7 @@ Implementation based on decompilation at 0x10008909:
 const VxMatrix &RCK3dEntity::GetInverseWorldMatrix() const {
     // Lazy evaluation - compute inverse only when needed
     // IDA: if ( (this->m_MoveableFlags & 0x400000) == 0 )
+    ResolveWorldMatrix();
     if (!(m_MoveableFlags & VX_MOVEABLE_INVERSEWORLDMATVALID)) {
         // Mark as valid and compute
         // Note: const_cast required as this is logically const (caching)
@@ -2781,6 +2871,7 @@ const VxMatrix &RCK3dEntity::GetInverseWorldMatrix() const {
 }
 
 void RCK3dEntity::Transform(VxVector *Dest, const VxVector *Src, CK3dEntity *Ref) const {
+    ResolveWorldMatrix();
     if (Ref) {
         VxMatrix tmp;
         Vx3DMultiplyMatrix(tmp, Ref->GetInverseWorldMatrix(), m_WorldMatrix);
@@ -2802,6 +2893,7 @@ void RCK3dEntity::InverseTransform(VxVector *Dest, const VxVector *Src, CK3dEnti
 }
 
 void RCK3dEntity::TransformVector(VxVector *Dest, const VxVector *Src, CK3dEntity *Ref) const {
+    ResolveWorldMatrix();
     if (Ref) {
         VxMatrix tmp;
         Vx3DMultiplyMatrix(tmp, Ref->GetInverseWorldMatrix(), m_WorldMatrix);
@@ -2823,6 +2915,7 @@ void RCK3dEntity::InverseTransformVector(VxVector *Dest, const VxVector *Src, CK
 }
 
 void RCK3dEntity::TransformMany(VxVector *Dest, const VxVector *Src, int count, CK3dEntity *Ref) const {
+    ResolveWorldMatrix();
     if (Ref) {
         VxMatrix tmp;
         Vx3DMultiplyMatrix(tmp, Ref->GetInverseWorldMatrix(), m_WorldMatrix);
@@ -2916,6 +3009,17 @@ CKBOOL RCK3dEntity::DestroySkin() {
 }
 
 CKBOOL RCK3dEntity::UpdateSkin() {
+    CKSkinJob job;
+    if (!PrepareSkinJob(job))
+        return FALSE;
+
+    // Large skins are split over the job pool
+    RCKRenderManager *rm = (RCKRenderManager *) m_Context->GetRenderManager();
+    RCKSkin::CalcPointsBatch(&job, 1, rm ? rm->GetJobPool() : nullptr);
+    return FinishSkinJob(job);
+}
+
+CKBOOL RCK3dEntity::PrepareSkinJob(CKSkinJob &job) {
     if (!m_Skin)
         return FALSE;
 
@@ -2955,21 +3059,24 @@ CKBOOL RCK3dEntity::UpdateSkin() {
     CKDWORD vStride = 0;
     CKBYTE *vertexPtr = mesh->GetModifierVertices(&vStride);
 
-    if (m_Skin->GetNormalCount() != 0) {
-        CKDWORD nStride = 0;
-        CKBYTE *normalPtr = static_cast<CKBYTE *>(mesh->GetNormalsPtr(&nStride));
-        if (m_Skin->CalcPointsEx(modifierVertexCount, vertexPtr, vStride, normalPtr, nStride)) {
-            mesh->ModifierVertexMove(FALSE, TRUE);
-            return TRUE;
-        }
-    } else {
-        if (m_Skin->CalcPoints(modifierVertexCount, vertexPtr, vStride)) {
-            mesh->ModifierVertexMove(TRUE, FALSE);
-            return TRUE;
-        }
-    }
+    // Same as CalcPointsEx / CalcPoints
+    CKSkinJob skinJob = {m_Skin, modifierVertexCount, vertexPtr, vStride, nullptr, 0, FALSE};
+    if (m_Skin->GetNormalCount() != 0)
+        skinJob.NormalPtr = static_cast<CKBYTE *>(mesh->GetNormalsPtr(&skinJob.NStride));
+    job = skinJob;
+    return TRUE;
+}
 
-    return FALSE;
+CKBOOL RCK3dEntity::FinishSkinJob(const CKSkinJob &job) {
+    if (!job.Result)
+        return FALSE;
+
+    RCKMesh *mesh = static_cast<RCKMesh *>(GetCurrentMesh());
+    if (m_Skin->GetNormalCount() != 0)
+        mesh->ModifierVertexMove(FALSE, TRUE);
+    else
+        mesh->ModifierVertexMove(TRUE, FALSE);
+    return TRUE;
 }
 
 CKSkin *RCK3dEntity::GetSkin() const {
@@ -2989,6 +3096,8 @@ Implementation based on decompilation at 0x10006113:
 void RCK3dEntity::UpdateBox(CKBOOL World) {
     (void) World; // Original implementation ignores this parameter (IDA: 0x10006113)
 
+    ResolveWorldMatrix();
+
     if ((m_MoveableFlags & VX_MOVEABLE_USERBOX) != 0) {
         m_MoveableFlags |= VX_MOVEABLE_BOXVALID;
         m_WorldBoundingBox.TransformFrom(m_LocalBoundingBox, m_WorldMatrix);
@@ -3030,7 +3139,7 @@ CKBOOL RCK3dEntity::SetBoundingBox(const VxBbox *BBox, CKBOOL Local) {
     if (BBox) {
         if (Local) {
             m_LocalBoundingBox = *BBox;
-            m_WorldBoundingBox.TransformFrom(m_LocalBoundingBox, m_WorldMatrix);
+            m_WorldBoundingBox.TransformFrom(m_LocalBoundingBox, GetWorldMatrix());
         } else {
             m_WorldBoundingBox = *BBox;
             const VxMatrix &invWorld = GetInverseWorldMatrix();
@@ -3083,6 +3192,7 @@ CKBOOL RCK3dEntity::GetBaryCenter(VxVector *Pos) {
     }
 
     // No mesh: return world translation and return FALSE.
+    ResolveWorldMatrix();
     Pos->x = m_WorldMatrix[3][0];
     Pos->y = m_WorldMatrix[3][1];
     Pos->z = m_WorldMatrix[3][2];
@@ -3092,6 +3202,7 @@ CKBOOL RCK3dEntity::GetBaryCenter(VxVector *Pos) {
 float RCK3dEntity::GetRadius() {
     // IDA: ?GetRadius@RCK3dEntity@@UAEMXZ @ 0x10008EE2
     if (m_CurrentMesh) {
+        ResolveWorldMatrix();
         VxVector row0 = m_WorldMatrix[0];
         VxVector row1 = m_WorldMatrix[1];
         VxVector row2 = m_WorldMatrix[2];
@@ -3210,6 +3321,7 @@ CKBOOL RCK3dEntity::IsInViewFrustrum(CKRenderContext *rc, CKDWORD flags) {
 
     // Mark extents as up-to-date for this test pass
     ModifyMoveableFlags(VX_MOVEABLE_EXTENTSUPTODATE, 0);
+    ResolveWorldMatrix();
 
     CKDWORD vis = 1;
 
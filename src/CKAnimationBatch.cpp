@@ -0,0 +1,201 @@
+#include "CKAnimationBatch.h"
+
+#include "CKBodyPart.h"
+#include "RCK3dEntity.h"
+#include "RCKObjectAnimation.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Parents first, animation order between bones of the same depth
+static int CompareBoneDepth(const void *a, const void *b) {
+    const int depthA = *(const int *) a >> 16;
+    const int depthB = *(const int *) b >> 16;
+    if (depthA != depthB)
+        return depthA - depthB;
+    return (*(const int *) a & 0xFFFF) - (*(const int *) b & 0xFFFF);
+}
+
+static int CompareBoneEntity(const void *a, const void *b) {
+    const CKAnimationBatch::EntityBone *entryA = (const CKAnimationBatch::EntityBone *) a;
+    const CKAnimationBatch::EntityBone *entryB = (const CKAnimationBatch::EntityBone *) b;
+    if (entryA->Entity != entryB->Entity)
+        return entryA->Entity < entryB->Entity ? -1 : 1;
+    return entryA->Bone - entryB->Bone;
+}
+
+CKAnimationBatch::CKAnimationBatch() : m_SweepStamp(0) {}
+
+void CKAnimationBatch::Clear() {
+    m_Anims.Clear();
+    m_Entities.Clear();
+    m_Bones.Clear();
+    m_EntityBones.Clear();
+    m_SweepStamps.Clear();
+    m_SweepStamp = 0;
+}
+
+void CKAnimationBatch::Build(RCKObjectAnimation **anims, int count) {
+    Clear();
+    // Depth and animation index packed for the sort
+    if (count <= 0 || count > 0xFFFF)
+        return;
+
+    m_Anims.Resize(count);
+    m_Entities.Resize(count);
+    XArray<int> keys;
+    keys.Resize(count);
+    for (int i = 0; i < count; ++i) {
+        m_Anims[i] = anims[i];
+        m_Entities[i] = anims[i] ? anims[i]->m_Entity : nullptr;
+
+        int depth = 0;
+        if (m_Entities[i]) {
+            for (RCK3dEntity *parent = m_Entities[i]->m_Parent; parent && depth < 0x7FFF; parent = parent->m_Parent)
+                ++depth;
+        }
+        keys[i] = (depth << 16) | i;
+    }
+    ::qsort(keys.Begin(), count, sizeof(int), CompareBoneDepth);
+
+    m_Bones.Resize(count);
+    for (int b = 0; b < count; ++b) {
+        Bone &bone = m_Bones[b];
+        bone.Order = keys[b] & 0xFFFF;
+        bone.Depth = keys[b] >> 16;
+        bone.Anim = m_Anims[bone.Order];
+        bone.Entity = m_Entities[bone.Order];
+    }
+
+    m_EntityBones.Resize(count);
+    for (int b = 0; b < count; ++b) {
+        m_EntityBones[b].Entity = m_Bones[b].Entity;
+        m_EntityBones[b].Bone = b;
+    }
+    ::qsort(m_EntityBones.Begin(), count, sizeof(EntityBone), CompareBoneEntity);
+
+    m_Positions.Resize(count);
+    m_Scales.Resize(count);
+    m_Rotations.Resize(count);
+    m_ScaleAxes.Resize(count);
+    m_Frames.Resize(count);
+    m_TransformFlags.Resize(count);
+    m_Active.Resize(count);
+    m_SweepStamps.Resize(count);
+    memset(m_SweepStamps.Begin(), 0, count * sizeof(int));
+}
+
+CKBOOL CKAnimationBatch::Matches(RCKObjectAnimation **anims, int count) const {
+    if (count != m_Anims.Size() || count == 0)
+        return FALSE;
+    for (int i = 0; i < count; ++i) {
+        if (anims[i] != m_Anims[i])
+            return FALSE;
+        if ((anims[i] ? anims[i]->m_Entity : nullptr) != m_Entities[i])
+            return FALSE;
+    }
+    return TRUE;
+}
+
+int CKAnimationBatch::FindBone(RCK3dEntity *entity) const {
+    int low = 0;
+    int high = m_EntityBones.Size();
+    while (low < high) {
+        const int mid = (low + high) >> 1;
+        RCK3dEntity *midEntity = m_EntityBones[mid].Entity;
+        if (midEntity == entity)
+            return m_EntityBones[mid].Bone;
+        if (midEntity < entity)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return -1;
+}
+
+void CKAnimationBatch::SetStep(float step, CKKeyedAnimation *owner) {
+    const int count = m_Bones.Size();
+
+    // Evaluate the animated components of every bone
+    for (int b = 0; b < count; ++b) {
+        RCKObjectAnimation *anim = m_Bones[b].Anim;
+        RCK3dEntity *entity = m_Bones[b].Entity;
+        m_Active[b] = FALSE;
+        m_TransformFlags[b] = 0;
+        if (!anim)
+            continue;
+
+        // Same checks as RCKObjectAnimation::SetStep
+        anim->m_CurrentStep = step;
+        const float frame = step * (anim->m_KeyframeData ? anim->m_KeyframeData->m_Length : 0.0f);
+        m_Frames[b] = frame;
+        if (!entity || (entity->GetMoveableFlags() & 0x400))
+            continue;
+        if (CKIsChildClassOf(entity, CKCID_BODYPART)) {
+            CKAnimation *exclusive = ((CKBodyPart *) entity)->GetExclusiveAnimation();
+            if (exclusive && (CKKeyedAnimation *) exclusive != owner)
+                continue;
+        }
+        m_Active[b] = TRUE;
+
+        CKDWORD transformFlags = 0;
+        m_Positions[b].Set(0.0f, 0.0f, 0.0f);
+        m_Scales[b].Set(1.0f, 1.0f, 1.0f);
+        m_Rotations[b] = VxQuaternion();
+        m_ScaleAxes[b] = VxQuaternion();
+        if (anim->EvaluatePosition(frame, m_Positions[b]))
+            transformFlags |= 4;
+        if (anim->EvaluateRotation(frame, m_Rotations[b]))
+            transformFlags |= 8;
+        if (anim->EvaluateScale(frame, m_Scales[b]))
+            transformFlags |= 1;
+        if (anim->EvaluateScaleAxis(frame, m_ScaleAxes[b]))
+            transformFlags |= 2;
+        m_TransformFlags[b] = transformFlags;
+    }
+
+    // Local matrices, in animation order when several bones share an entity
+    for (int b = 0; b < count; ++b) {
+        if (m_TransformFlags[b])
+            RCKObjectAnimation::ComposeLocalMatrix(m_Bones[b].Entity->m_LocalMatrix, m_TransformFlags[b],
+                                                   m_Positions[b], m_Rotations[b], m_Scales[b]);
+    }
+
+    // World matrices, parents first, each subtree once
+    if (++m_SweepStamp == 0) {
+        memset(m_SweepStamps.Begin(), 0, count * sizeof(int));
+        m_SweepStamp = 1;
+    }
+    for (int b = 0; b < count; ++b) {
+        if (m_TransformFlags[b] && m_SweepStamps[b] != m_SweepStamp)
+            UpdateSubtree(m_Bones[b].Entity);
+    }
+
+    for (int b = 0; b < count; ++b) {
+        if (m_Active[b])
+            m_Bones[b].Anim->ApplyMorphTarget(m_Frames[b]);
+    }
+}
+
+void CKAnimationBatch::UpdateSubtree(RCK3dEntity *entity) {
+    m_Stack.Resize(0);
+    m_Stack.PushBack(entity);
+    while (m_Stack.Size() > 0) {
+        RCK3dEntity *current = m_Stack.PopBack();
+
+        // An animated bone keeps the box propagation of SetLocalMatrix
+        const int bone = FindBone(current);
+        CKBOOL animated = FALSE;
+        if (bone >= 0) {
+            m_SweepStamps[bone] = m_SweepStamp;
+            animated = m_TransformFlags[bone] != 0;
+        }
+        current->UpdateWorldMatrixFromLocal(animated);
+
+        for (CKObject **it = current->m_Children.Begin(); it != current->m_Children.End(); ++it) {
+            RCK3dEntity *child = (RCK3dEntity *) *it;
+            if (child && !(child->m_MoveableFlags & VX_MOVEABLE_DONTUPDATEFROMPARENT))
+                m_Stack.PushBack(child);
+        }
+    }
+}
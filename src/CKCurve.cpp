@@ -411,6 +411,7 @@ CKERROR RCKCurve::GetPos(float step, VxVector *Pos, VxVector *Dir) {
     if (err != CK_OK)
         return err;
 
+    ResolveWorldMatrix();
     Vx3DMultiplyMatrixVector(Pos, m_WorldMatrix, &localPos);
     if (Dir) {
         Vx3DRotateVector(Dir, m_WorldMatrix, &localDir);
@@ -908,7 +909,7 @@ void RCKCurve::Update() {
     const int count = m_ControlPoints.Size();
 
     VxMatrix invCurveWorld;
-    Vx3DInverseMatrix(invCurveWorld, m_WorldMatrix);
+    Vx3DInverseMatrix(invCurveWorld, GetWorldMatrix());
 
     VxVector worldPos, localPos;
     RCKCurvePoint **ppPoints = (RCKCurvePoint **)m_ControlPoints.Begin();
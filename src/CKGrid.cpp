@@ -70,7 +70,7 @@ void RCKGrid::UpdateBox(CKBOOL World) {
     m_LocalBoundingBox.Max.Set((float) m_Width, 1.0f, (float) m_Length);
 
     if (World) {
-        m_WorldBoundingBox.TransformFrom(m_LocalBoundingBox, m_WorldMatrix);
+        m_WorldBoundingBox.TransformFrom(m_LocalBoundingBox, GetWorldMatrix());
     }
 
     m_MoveableFlags |= 4;
@@ -275,6 +275,37 @@ CKObjectAnimation *RCKKeyedAnimation::GetAnimation(int index) {
 void RCKKeyedAnimation::Clear() {
     m_Animations.Clear();
     m_RootAnimation = nullptr;
+    m_Batch.Clear();
+}
+
+//=============================================================================
+// Current Position
+//=============================================================================
+
+// Stores the step, as RCKAnimation::SetStep, and moves the animated entities:
+// RCKCharacter::ProcessAnimation reads the root body part position right after
+// SetFrame, which needs the bones placed. They are placed by one batch (see
+// CKAnimationBatch) with the matrices of one RCKObjectAnimation::SetStep per
+// sub-animation. The batch is rebuilt whenever the sub-animations or their
+// entities changed.
+void RCKKeyedAnimation::SetStep(float step) {
+    RCKAnimation::SetStep(step);
+
+    RCKObjectAnimation **anims = (RCKObjectAnimation **) m_Animations.Begin();
+    const int count = m_Animations.Size();
+    if (!m_Batch.Matches(anims, count)) {
+        m_Batch.Build(anims, count);
+        m_Flags |= CKANIMATION_SUBANIMSSORTED;
+    }
+    m_Batch.SetStep(step, (CKKeyedAnimation *) this);
+}
+
+void RCKKeyedAnimation::SetFrame(float frame) {
+    if (m_Length == 0.0f) {
+        RCKAnimation::SetFrame(frame);
+        return;
+    }
+    SetStep(frame / m_Length);
 }
 
 //=============================================================================
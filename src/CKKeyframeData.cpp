@@ -36,6 +36,77 @@ static float ApplyEaseParameters(float t, float easeTo, float easeFrom) {
     return h1 * 0.0f + h2 * 1.0f + h3 * (1.0f - easeFrom) + h4 * easeTo;
 }
 
+//===================================================================
+// Key interval lookup shared by the controllers
+//===================================================================
+
+static inline float KeyTime(const CKKey &key) {
+    return key.TimeStep;
+}
+
+// Time arrays of the compressed controllers
+static inline float KeyTime(float time) {
+    return time;
+}
+
+// Returns the key i with keys[i].TimeStep <= time < keys[i + 1].TimeStep,
+// the interval a binary search over the whole array finds. The caller handles
+// times outside the keys. hint is the interval of the previous call: playback
+// mostly moves forward, so that interval and the next one are tried first and
+// otherwise bound the search.
+template <class KeyType>
+static inline int FindKeyInterval(const KeyType *keys, int count, float time, int hint) {
+    int low = 0;
+    int high = count - 1;
+
+    if (hint >= 0 && hint < count - 1) {
+        if (KeyTime(keys[hint]) <= time) {
+            if (time < KeyTime(keys[hint + 1]))
+                return hint;
+            if (hint + 2 < count && time < KeyTime(keys[hint + 2]))
+                return hint + 1;
+            low = hint + 1;
+        } else {
+            high = hint;
+        }
+    }
+
+    while (low < high - 1) {
+        int mid = (low + high) >> 1;
+        if (KeyTime(keys[mid]) <= time)
+            low = mid;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+// Power basis of the cubic Hermite curve of a segment:
+// h1 * p1 + h2 * p2 + h3 * m1 + h4 * m2 = ((C[0] * t + C[1]) * t + C[2]) * t + C[3]
+static void SetHermiteCoefs(CKKeySegmentCache &segment, const VxVector &p1, const VxVector &p2, const VxVector &m1,
+                            const VxVector &m2) {
+    segment.Coefs[0] = (p1 - p2) * 2.0f + m1 + m2;
+    segment.Coefs[1] = (p2 - p1) * 3.0f - m1 * 2.0f - m2;
+    segment.Coefs[2] = m1;
+    segment.Coefs[3] = p1;
+}
+
+// Same for the cubic Bezier curve with control points p0, p1, p2, p3
+static void SetBezierCoefs(CKKeySegmentCache &segment, const VxVector &p0, const VxVector &p1, const VxVector &p2,
+                           const VxVector &p3) {
+    segment.Coefs[0] = p3 - p0 + (p1 - p2) * 3.0f;
+    segment.Coefs[1] = (p0 - p1 * 2.0f + p2) * 3.0f;
+    segment.Coefs[2] = (p1 - p0) * 3.0f;
+    segment.Coefs[3] = p0;
+}
+
+static inline void EvaluateSegmentCoefs(const CKKeySegmentCache &segment, float t, VxVector *result) {
+    const VxVector *c = segment.Coefs;
+    result->x = ((c[0].x * t + c[1].x) * t + c[2].x) * t + c[3].x;
+    result->y = ((c[0].y * t + c[1].y) * t + c[2].y) * t + c[3].y;
+    result->z = ((c[0].z * t + c[1].z) * t + c[2].z) * t + c[3].z;
+}
+
 //===================================================================
 // CKKeyframeData Implementation
 //===================================================================
@@ -95,6 +166,14 @@ CKAnimController *CKKeyframeData::CreateController(CKANIMATION_CONTROLLER type)
     case CKANIMATION_MORPH_CONTROL:
         controller = new RCKMorphController();
         break;
+    case CKANIMATION_COMPRESSEDPOS_CONTROL:
+    case CKANIMATION_COMPRESSEDSCL_CONTROL:
+        controller = new RCKCompressedVectorController(type);
+        break;
+    case CKANIMATION_COMPRESSEDROT_CONTROL:
+    case CKANIMATION_COMPRESSEDSCLAXIS_CONTROL:
+        controller = new RCKCompressedQuaternionController(type);
+        break;
     default:
         return nullptr;
     }
@@ -106,12 +185,39 @@ CKAnimController *CKKeyframeData::CreateController(CKANIMATION_CONTROLLER type)
     return controller;
 }
 
+// Compresses one controller slot, keeping the original controller if it
+// cannot be compressed
+template <class CompressedController>
+static void CompressController(CKKeyframeData &data, CKAnimController *&controller, CKANIMATION_CONTROLLER type,
+                               float maxError) {
+    if (!controller || (controller->GetType() & CKANIMATION_COMPRESSED_CONTROL))
+        return;
+    CompressedController *compressed = static_cast<CompressedController *>(data.CreateController(type));
+    if (compressed->Compress(controller, maxError)) {
+        delete controller;
+        controller = compressed;
+    } else {
+        delete compressed;
+    }
+}
+
+void CKKeyframeData::CompressControllers(float maxError, float maxAngleError) {
+    CompressController<RCKCompressedVectorController>(*this, m_PositionController, CKANIMATION_COMPRESSEDPOS_CONTROL,
+                                                      maxError);
+    CompressController<RCKCompressedVectorController>(*this, m_ScaleController, CKANIMATION_COMPRESSEDSCL_CONTROL,
+                                                      maxError);
+    CompressController<RCKCompressedQuaternionController>(*this, m_RotationController,
+                                                          CKANIMATION_COMPRESSEDROT_CONTROL, maxAngleError);
+    CompressController<RCKCompressedQuaternionController>(*this, m_ScaleAxisController,
+                                                          CKANIMATION_COMPRESSEDSCLAXIS_CONTROL, maxAngleError);
+}
+
 //===================================================================
 // RCKLinearPositionController Implementation
 //===================================================================
 
 RCKLinearPositionController::RCKLinearPositionController()
-    : CKAnimController(CKANIMATION_LINPOS_CONTROL), m_Keys(nullptr) {
+    : CKAnimController(CKANIMATION_LINPOS_CONTROL), m_Keys(nullptr), m_Cursor(-1) {
     m_Length = 0.0f;
 }
 
@@ -137,16 +243,9 @@ CKBOOL RCKLinearPositionController::Evaluate(float TimeStep, void *res) {
         return TRUE;
     }
 
-    // Binary search for the interval containing TimeStep
-    int low = 0;
-    int high = m_NbKeys - 1;
-    while (low < high - 1) {
-        int mid = (low + high) >> 1;
-        if (m_Keys[mid].TimeStep <= TimeStep)
-            low = mid;
-        else
-            high = mid;
-    }
+    int low = FindKeyInterval(m_Keys, m_NbKeys, TimeStep, m_Cursor);
+    int high = low + 1;
+    m_Cursor = low;
 
     // Linear interpolation between keys[low] and keys[high]
     float t1 = m_Keys[low].TimeStep;
@@ -302,7 +401,7 @@ CKBOOL RCKLinearPositionController::Clone(CKAnimController *control) {
 //===================================================================
 
 RCKLinearRotationController::RCKLinearRotationController()
-    : CKAnimController(CKANIMATION_LINROT_CONTROL), m_Keys(nullptr) {
+    : CKAnimController(CKANIMATION_LINROT_CONTROL), m_Keys(nullptr), m_Cursor(-1) {
     m_Length = 0.0f;
 }
 
@@ -328,16 +427,9 @@ CKBOOL RCKLinearRotationController::Evaluate(float TimeStep, void *res) {
         return TRUE;
     }
 
-    // Binary search
-    int low = 0;
-    int high = m_NbKeys - 1;
-    while (low < high - 1) {
-        int mid = (low + high) >> 1;
-        if (m_Keys[mid].TimeStep <= TimeStep)
-            low = mid;
-        else
-            high = mid;
-    }
+    int low = FindKeyInterval(m_Keys, m_NbKeys, TimeStep, m_Cursor);
+    int high = low + 1;
+    m_Cursor = low;
 
     // Spherical linear interpolation (Slerp) between quaternions
     float t1 = m_Keys[low].TimeStep;
@@ -481,7 +573,7 @@ CKBOOL RCKLinearRotationController::Clone(CKAnimController *control) {
 //===================================================================
 
 RCKLinearScaleController::RCKLinearScaleController()
-    : CKAnimController(CKANIMATION_LINSCL_CONTROL), m_Keys(nullptr) {
+    : CKAnimController(CKANIMATION_LINSCL_CONTROL), m_Keys(nullptr), m_Cursor(-1) {
     m_Length = 0.0f;
 }
 
@@ -505,15 +597,9 @@ CKBOOL RCKLinearScaleController::Evaluate(float TimeStep, void *res) {
         return TRUE;
     }
 
-    int low = 0;
-    int high = m_NbKeys - 1;
-    while (low < high - 1) {
-        int mid = (low + high) >> 1;
-        if (m_Keys[mid].TimeStep <= TimeStep)
-            low = mid;
-        else
-            high = mid;
-    }
+    int low = FindKeyInterval(m_Keys, m_NbKeys, TimeStep, m_Cursor);
+    int high = low + 1;
+    m_Cursor = low;
 
     float t1 = m_Keys[low].TimeStep;
     float t2_time = m_Keys[high].TimeStep;
@@ -661,7 +747,7 @@ CKBOOL RCKLinearScaleController::Clone(CKAnimController *control) {
 //===================================================================
 
 RCKLinearScaleAxisController::RCKLinearScaleAxisController()
-    : CKAnimController(CKANIMATION_LINSCLAXIS_CONTROL), m_Keys(nullptr) {
+    : CKAnimController(CKANIMATION_LINSCLAXIS_CONTROL), m_Keys(nullptr), m_Cursor(-1) {
     m_Length = 0.0f;
 }
 
@@ -685,15 +771,9 @@ CKBOOL RCKLinearScaleAxisController::Evaluate(float TimeStep, void *res) {
         return TRUE;
     }
 
-    int low = 0;
-    int high = m_NbKeys - 1;
-    while (low < high - 1) {
-        int mid = (low + high) >> 1;
-        if (m_Keys[mid].TimeStep <= TimeStep)
-            low = mid;
-        else
-            high = mid;
-    }
+    int low = FindKeyInterval(m_Keys, m_NbKeys, TimeStep, m_Cursor);
+    int high = low + 1;
+    m_Cursor = low;
 
     float t1 = m_Keys[low].TimeStep;
     float t2 = m_Keys[high].TimeStep;
@@ -846,6 +926,8 @@ RCKTCBPositionController::~RCKTCBPositionController() {
 }
 
 void RCKTCBPositionController::ComputeTangents() {
+    m_Segment.Invalidate();
+
     if (m_NbKeys < 2) {
         delete[] m_Tangents;
         m_Tangents = nullptr;
@@ -919,42 +1001,22 @@ CKBOOL RCKTCBPositionController::Evaluate(float TimeStep, void *res) {
         return TRUE;
     }
 
-    // Binary search for interval
-    int low = 0;
-    int high = m_NbKeys - 1;
-    while (low < high - 1) {
-        int mid = (low + high) >> 1;
-        if (m_Keys[mid].TimeStep <= TimeStep)
-            low = mid;
-        else
-            high = mid;
+    int low = FindKeyInterval(m_Keys, m_NbKeys, TimeStep, m_Segment.Key);
+    if (low != m_Segment.Key) {
+        int high = low + 1;
+        m_Segment.Key = low;
+        m_Segment.StartTime = m_Keys[low].TimeStep;
+        m_Segment.InvLength = 1.0f / (m_Keys[high].TimeStep - m_Keys[low].TimeStep);
+        m_Segment.EaseTo = m_Keys[low].easeto;
+        m_Segment.EaseFrom = m_Keys[high].easefrom;
+        // Outgoing tangent of the low key, incoming tangent of the high key
+        SetHermiteCoefs(m_Segment, m_Keys[low].Pos, m_Keys[high].Pos, m_Tangents[low * 2 + 1], m_Tangents[high * 2]);
     }
 
     // Hermite spline interpolation
-    float t1 = m_Keys[low].TimeStep;
-    float t2 = m_Keys[high].TimeStep;
-    float t = (TimeStep - t1) / (t2 - t1);
-
-    // Apply ease parameters
-    t = ApplyEaseParameters(t, m_Keys[low].easeto, m_Keys[high].easefrom);
-
-    // Hermite basis functions
-    float t2_val = t * t;
-    float t3 = t2_val * t;
-
-    float h1 = 2.0f * t3 - 3.0f * t2_val + 1.0f; // (2t^3 - 3t^2 + 1)
-    float h2 = -2.0f * t3 + 3.0f * t2_val;       // (-2t^3 + 3t^2)
-    float h3 = t3 - 2.0f * t2_val + t;           // (t^3 - 2t^2 + t)
-    float h4 = t3 - t2_val;                      // (t^3 - t^2)
-
-    VxVector &p1 = m_Keys[low].Pos;
-    VxVector &p2 = m_Keys[high].Pos;
-    VxVector &m1 = m_Tangents[low * 2 + 1]; // outgoing tangent of low key
-    VxVector &m2 = m_Tangents[high * 2];    // incoming tangent of high key
-
-    result->x = h1 * p1.x + h2 * p2.x + h3 * m1.x + h4 * m2.x;
-    result->y = h1 * p1.y + h2 * p2.y + h3 * m1.y + h4 * m2.y;
-    result->z = h1 * p1.z + h2 * p2.z + h3 * m1.z + h4 * m2.z;
+    float t = (TimeStep - m_Segment.StartTime) * m_Segment.InvLength;
+    t = ApplyEaseParameters(t, m_Segment.EaseTo, m_Segment.EaseFrom);
+    EvaluateSegmentCoefs(m_Segment, t, result);
 
     return TRUE;
 }
@@ -963,6 +1025,8 @@ int RCKTCBPositionController::AddKey(CKKey *key) {
     if (!key)
         return -1;
 
+    m_Segment.Invalidate();
+
     CKTCBPositionKey *tcbKey = static_cast<CKTCBPositionKey *>(key);
     float time = tcbKey->TimeStep;
 
@@ -1003,12 +1067,16 @@ int RCKTCBPositionController::AddKey(CKKey *key) {
 }
 
 CKKey *RCKTCBPositionController::GetKey(int index) {
+    // The key can be edited through the returned pointer
+    m_Segment.Invalidate();
     if (index < 0 || index >= m_NbKeys)
         return nullptr;
     return &m_Keys[index];
 }
 
 void RCKTCBPositionController::RemoveKey(int index) {
+    m_Segment.Invalidate();
+
     if (index < 0 || index >= m_NbKeys)
         return;
 
@@ -1048,6 +1116,8 @@ int RCKTCBPositionController::DumpKeysTo(void *Buffer) {
 }
 
 int RCKTCBPositionController::ReadKeysFrom(void *Buffer) {
+    m_Segment.Invalidate();
+
     if (!Buffer)
         return 0;
 
@@ -1087,6 +1157,8 @@ CKBOOL RCKTCBPositionController::Clone(CKAnimController *control) {
     if (!CKAnimController::Clone(control))
         return FALSE;
 
+    m_Segment.Invalidate();
+
     RCKTCBPositionController *other = static_cast<RCKTCBPositionController *>(control);
 
     delete[] m_Keys;
@@ -1107,7 +1179,7 @@ CKBOOL RCKTCBPositionController::Clone(CKAnimController *control) {
 //===================================================================
 
 RCKTCBRotationController::RCKTCBRotationController()
-    : CKAnimController(CKANIMATION_TCBROT_CONTROL), m_Keys(nullptr), m_Tangents(nullptr) {
+    : CKAnimController(CKANIMATION_TCBROT_CONTROL), m_Keys(nullptr), m_Tangents(nullptr), m_Cursor(-1) {
     m_Length = 0.0f;
 }
 
@@ -1182,15 +1254,9 @@ CKBOOL RCKTCBRotationController::Evaluate(float TimeStep, void *res) {
         return TRUE;
     }
 
-    int low = 0;
-    int high = m_NbKeys - 1;
-    while (low < high - 1) {
-        int mid = (low + high) >> 1;
-        if (m_Keys[mid].TimeStep <= TimeStep)
-            low = mid;
-        else
-            high = mid;
-    }
+    int low = FindKeyInterval(m_Keys, m_NbKeys, TimeStep, m_Cursor);
+    int high = low + 1;
+    m_Cursor = low;
 
     float t1 = m_Keys[low].TimeStep;
     float t2 = m_Keys[high].TimeStep;
@@ -1365,6 +1431,8 @@ RCKTCBScaleController::~RCKTCBScaleController() {
 }
 
 void RCKTCBScaleController::ComputeTangents() {
+    m_Segment.Invalidate();
+
     if (m_NbKeys < 2) {
         delete[] m_Tangents;
         m_Tangents = nullptr;
@@ -1428,38 +1496,21 @@ CKBOOL RCKTCBScaleController::Evaluate(float TimeStep, void *res) {
         return TRUE;
     }
 
-    int low = 0;
-    int high = m_NbKeys - 1;
-    while (low < high - 1) {
-        int mid = (low + high) >> 1;
-        if (m_Keys[mid].TimeStep <= TimeStep)
-            low = mid;
-        else
-            high = mid;
+    int low = FindKeyInterval(m_Keys, m_NbKeys, TimeStep, m_Segment.Key);
+    if (low != m_Segment.Key) {
+        int high = low + 1;
+        m_Segment.Key = low;
+        m_Segment.StartTime = m_Keys[low].TimeStep;
+        m_Segment.InvLength = 1.0f / (m_Keys[high].TimeStep - m_Keys[low].TimeStep);
+        m_Segment.EaseTo = m_Keys[low].easeto;
+        m_Segment.EaseFrom = m_Keys[high].easefrom;
+        // Outgoing tangent of the low key, incoming tangent of the high key
+        SetHermiteCoefs(m_Segment, m_Keys[low].Pos, m_Keys[high].Pos, m_Tangents[low * 2 + 1], m_Tangents[high * 2]);
     }
 
-    float t1 = m_Keys[low].TimeStep;
-    float t2 = m_Keys[high].TimeStep;
-    float t = (TimeStep - t1) / (t2 - t1);
-
-    t = ApplyEaseParameters(t, m_Keys[low].easeto, m_Keys[high].easefrom);
-
-    float t2_val = t * t;
-    float t3 = t2_val * t;
-
-    float h1 = 2.0f * t3 - 3.0f * t2_val + 1.0f;
-    float h2 = -2.0f * t3 + 3.0f * t2_val;
-    float h3 = t3 - 2.0f * t2_val + t;
-    float h4 = t3 - t2_val;
-
-    VxVector &p1 = m_Keys[low].Pos;
-    VxVector &p2 = m_Keys[high].Pos;
-    VxVector &m1 = m_Tangents[low * 2 + 1];
-    VxVector &m2 = m_Tangents[high * 2];
-
-    result->x = h1 * p1.x + h2 * p2.x + h3 * m1.x + h4 * m2.x;
-    result->y = h1 * p1.y + h2 * p2.y + h3 * m1.y + h4 * m2.y;
-    result->z = h1 * p1.z + h2 * p2.z + h3 * m1.z + h4 * m2.z;
+    float t = (TimeStep - m_Segment.StartTime) * m_Segment.InvLength;
+    t = ApplyEaseParameters(t, m_Segment.EaseTo, m_Segment.EaseFrom);
+    EvaluateSegmentCoefs(m_Segment, t, result);
 
     return TRUE;
 }
@@ -1468,6 +1519,8 @@ int RCKTCBScaleController::AddKey(CKKey *key) {
     if (!key)
         return -1;
 
+    m_Segment.Invalidate();
+
     CKTCBScaleKey *tcbKey = static_cast<CKTCBScaleKey *>(key);
     float time = tcbKey->TimeStep;
 
@@ -1506,12 +1559,16 @@ int RCKTCBScaleController::AddKey(CKKey *key) {
 }
 
 CKKey *RCKTCBScaleController::GetKey(int index) {
+    // The key can be edited through the returned pointer
+    m_Segment.Invalidate();
     if (index < 0 || index >= m_NbKeys)
         return nullptr;
     return &m_Keys[index];
 }
 
 void RCKTCBScaleController::RemoveKey(int index) {
+    m_Segment.Invalidate();
+
     if (index < 0 || index >= m_NbKeys)
         return;
 
@@ -1552,6 +1609,8 @@ int RCKTCBScaleController::DumpKeysTo(void *Buffer) {
 }
 
 int RCKTCBScaleController::ReadKeysFrom(void *Buffer) {
+    m_Segment.Invalidate();
+
     if (!Buffer)
         return 0;
 
@@ -1591,6 +1650,8 @@ CKBOOL RCKTCBScaleController::Clone(CKAnimController *control) {
     if (!CKAnimController::Clone(control))
         return FALSE;
 
+    m_Segment.Invalidate();
+
     RCKTCBScaleController *other = static_cast<RCKTCBScaleController *>(control);
 
     delete[] m_Keys;
@@ -1611,7 +1672,7 @@ CKBOOL RCKTCBScaleController::Clone(CKAnimController *control) {
 //===================================================================
 
 RCKTCBScaleAxisController::RCKTCBScaleAxisController()
-    : CKAnimController(CKANIMATION_TCBSCLAXIS_CONTROL), m_Keys(nullptr), m_Tangents(nullptr) {
+    : CKAnimController(CKANIMATION_TCBSCLAXIS_CONTROL), m_Keys(nullptr), m_Tangents(nullptr), m_Cursor(-1) {
     m_Length = 0.0f;
 }
 
@@ -1672,15 +1733,9 @@ CKBOOL RCKTCBScaleAxisController::Evaluate(float TimeStep, void *res) {
         return TRUE;
     }
 
-    int low = 0;
-    int high = m_NbKeys - 1;
-    while (low < high - 1) {
-        int mid = (low + high) >> 1;
-        if (m_Keys[mid].TimeStep <= TimeStep)
-            low = mid;
-        else
-            high = mid;
-    }
+    int low = FindKeyInterval(m_Keys, m_NbKeys, TimeStep, m_Cursor);
+    int high = low + 1;
+    m_Cursor = low;
 
     float t1 = m_Keys[low].TimeStep;
     float t2 = m_Keys[high].TimeStep;
@@ -1867,6 +1922,8 @@ void RCKBezierPositionController::ComputeBezierPts() {
 }
 
 void RCKBezierPositionController::ComputeBezierPts(int index) {
+    m_Segment.Invalidate();
+
     if (index < 0 || index >= m_NbKeys)
         return;
 
@@ -1988,39 +2045,21 @@ CKBOOL RCKBezierPositionController::Evaluate(float TimeStep, void *res) {
         return TRUE;
     }
 
-    // Binary search
-    int low = 0;
-    int high = m_NbKeys - 1;
-    while (low < high - 1) {
-        int mid = (low + high) >> 1;
-        if (m_Keys[mid].TimeStep <= TimeStep)
-            low = mid;
-        else
-            high = mid;
+    int low = FindKeyInterval(m_Keys, m_NbKeys, TimeStep, m_Segment.Key);
+    if (low != m_Segment.Key) {
+        int high = low + 1;
+        m_Segment.Key = low;
+        m_Segment.StartTime = m_Keys[low].TimeStep;
+        m_Segment.InvLength = 1.0f / (m_Keys[high].TimeStep - m_Keys[low].TimeStep);
+        // P0 = key[low].Pos, P1 = P0 + Out, P2 = P3 + In, P3 = key[high].Pos
+        const VxVector &p0 = m_Keys[low].Pos;
+        const VxVector &p3 = m_Keys[high].Pos;
+        SetBezierCoefs(m_Segment, p0, p0 + m_Keys[low].Out, p3 + m_Keys[high].In, p3);
     }
 
-    float t1 = m_Keys[low].TimeStep;
-    float t2_time = m_Keys[high].TimeStep;
-    float t = (TimeStep - t1) / (t2_time - t1);
-
     // Cubic Bezier interpolation
-    // B(t) = (1-t)^3 * P0 + 3(1-t)^2 * t * P1 + 3(1-t) * t^2 * P2 + t^3 * P3
-    // where P0 = key[low].Pos, P1 = P0 + Out, P2 = P3 + In, P3 = key[high].Pos
-
-    VxVector &p0 = m_Keys[low].Pos;
-    VxVector &p3 = m_Keys[high].Pos;
-    VxVector p1 = p0 + m_Keys[low].Out;
-    VxVector p2 = p3 + m_Keys[high].In;
-
-    float omt = 1.0f - t;
-    float omt2 = omt * omt;
-    float omt3 = omt2 * omt;
-    float t2 = t * t;
-    float t3 = t2 * t;
-
-    result->x = omt3 * p0.x + 3.0f * omt2 * t * p1.x + 3.0f * omt * t2 * p2.x + t3 * p3.x;
-    result->y = omt3 * p0.y + 3.0f * omt2 * t * p1.y + 3.0f * omt * t2 * p2.y + t3 * p3.y;
-    result->z = omt3 * p0.z + 3.0f * omt2 * t * p1.z + 3.0f * omt * t2 * p2.z + t3 * p3.z;
+    float t = (TimeStep - m_Segment.StartTime) * m_Segment.InvLength;
+    EvaluateSegmentCoefs(m_Segment, t, result);
 
     return TRUE;
 }
@@ -2029,6 +2068,8 @@ int RCKBezierPositionController::AddKey(CKKey *key) {
     if (!key)
         return -1;
 
+    m_Segment.Invalidate();
+
     CKBezierPositionKey *bezKey = static_cast<CKBezierPositionKey *>(key);
     float time = bezKey->TimeStep;
 
@@ -2064,12 +2105,16 @@ int RCKBezierPositionController::AddKey(CKKey *key) {
 }
 
 CKKey *RCKBezierPositionController::GetKey(int index) {
+    // The key can be edited through the returned pointer
+    m_Segment.Invalidate();
     if (index < 0 || index >= m_NbKeys)
         return nullptr;
     return &m_Keys[index];
 }
 
 void RCKBezierPositionController::RemoveKey(int index) {
+    m_Segment.Invalidate();
+
     if (index < 0 || index >= m_NbKeys)
         return;
 
@@ -2105,6 +2150,8 @@ int RCKBezierPositionController::DumpKeysTo(void *Buffer) {
 }
 
 int RCKBezierPositionController::ReadKeysFrom(void *Buffer) {
+    m_Segment.Invalidate();
+
     if (!Buffer)
         return 0;
 
@@ -2143,6 +2190,8 @@ CKBOOL RCKBezierPositionController::Clone(CKAnimController *control) {
     if (!CKAnimController::Clone(control))
         return FALSE;
 
+    m_Segment.Invalidate();
+
     RCKBezierPositionController *other = static_cast<RCKBezierPositionController *>(control);
 
     delete[] m_Keys;
@@ -2186,6 +2235,8 @@ void RCKBezierScaleController::ComputeBezierPts() {
 }
 
 void RCKBezierScaleController::ComputeBezierPts(int index) {
+    m_Segment.Invalidate();
+
     if (index < 0 || index >= m_NbKeys)
         return;
 
@@ -2267,34 +2318,21 @@ CKBOOL RCKBezierScaleController::Evaluate(float TimeStep, void *res) {
         return TRUE;
     }
 
-    int low = 0;
-    int high = m_NbKeys - 1;
-    while (low < high - 1) {
-        int mid = (low + high) >> 1;
-        if (m_Keys[mid].TimeStep <= TimeStep)
-            low = mid;
-        else
-            high = mid;
+    int low = FindKeyInterval(m_Keys, m_NbKeys, TimeStep, m_Segment.Key);
+    if (low != m_Segment.Key) {
+        int high = low + 1;
+        m_Segment.Key = low;
+        m_Segment.StartTime = m_Keys[low].TimeStep;
+        m_Segment.InvLength = 1.0f / (m_Keys[high].TimeStep - m_Keys[low].TimeStep);
+        // P0 = key[low].Pos, P1 = P0 + Out, P2 = P3 + In, P3 = key[high].Pos
+        const VxVector &p0 = m_Keys[low].Pos;
+        const VxVector &p3 = m_Keys[high].Pos;
+        SetBezierCoefs(m_Segment, p0, p0 + m_Keys[low].Out, p3 + m_Keys[high].In, p3);
     }
 
-    float t1 = m_Keys[low].TimeStep;
-    float t2_time = m_Keys[high].TimeStep;
-    float t = (TimeStep - t1) / (t2_time - t1);
-
-    VxVector &p0 = m_Keys[low].Pos;
-    VxVector &p3 = m_Keys[high].Pos;
-    VxVector p1 = p0 + m_Keys[low].Out;
-    VxVector p2 = p3 + m_Keys[high].In;
-
-    float omt = 1.0f - t;
-    float omt2 = omt * omt;
-    float omt3 = omt2 * omt;
-    float t2 = t * t;
-    float t3 = t2 * t;
-
-    result->x = omt3 * p0.x + 3.0f * omt2 * t * p1.x + 3.0f * omt * t2 * p2.x + t3 * p3.x;
-    result->y = omt3 * p0.y + 3.0f * omt2 * t * p1.y + 3.0f * omt * t2 * p2.y + t3 * p3.y;
-    result->z = omt3 * p0.z + 3.0f * omt2 * t * p1.z + 3.0f * omt * t2 * p2.z + t3 * p3.z;
+    // Cubic Bezier interpolation
+    float t = (TimeStep - m_Segment.StartTime) * m_Segment.InvLength;
+    EvaluateSegmentCoefs(m_Segment, t, result);
 
     return TRUE;
 }
@@ -2303,6 +2341,8 @@ int RCKBezierScaleController::AddKey(CKKey *key) {
     if (!key)
         return -1;
 
+    m_Segment.Invalidate();
+
     CKBezierScaleKey *bezKey = static_cast<CKBezierScaleKey *>(key);
     float time = bezKey->TimeStep;
 
@@ -2338,12 +2378,16 @@ int RCKBezierScaleController::AddKey(CKKey *key) {
 }
 
 CKKey *RCKBezierScaleController::GetKey(int index) {
+    // The key can be edited through the returned pointer
+    m_Segment.Invalidate();
     if (index < 0 || index >= m_NbKeys)
         return nullptr;
     return &m_Keys[index];
 }
 
 void RCKBezierScaleController::RemoveKey(int index) {
+    m_Segment.Invalidate();
+
     if (index < 0 || index >= m_NbKeys)
         return;
 
@@ -2379,6 +2423,8 @@ int RCKBezierScaleController::DumpKeysTo(void *Buffer) {
 }
 
 int RCKBezierScaleController::ReadKeysFrom(void *Buffer) {
+    m_Segment.Invalidate();
+
     if (!Buffer)
         return 0;
 
@@ -2417,6 +2463,8 @@ CKBOOL RCKBezierScaleController::Clone(CKAnimController *control) {
     if (!CKAnimController::Clone(control))
         return FALSE;
 
+    m_Segment.Invalidate();
+
     RCKBezierScaleController *other = static_cast<RCKBezierScaleController *>(control);
 
     delete[] m_Keys;
@@ -2431,12 +2479,749 @@ CKBOOL RCKBezierScaleController::Clone(CKAnimController *control) {
     return TRUE;
 }
 
+//===================================================================
+// Compressed controllers
+//===================================================================
+
+// Samples per frame between the keys of a source controller
+#define CKCOMPRESSED_SAMPLES_PER_FRAME 4
+
+// Sample times of a source controller: its key times, and evenly spaced times
+// in between (at most 256 per interval)
+static void SampleSourceTimes(CKAnimController *source, XArray<float> &times) {
+    times.Resize(0);
+    for (int i = 0; i < source->m_NbKeys; ++i) {
+        const float time = source->GetKey(i)->TimeStep;
+        if (i > 0) {
+            const float previous = times[times.Size() - 1];
+            const float gap = time - previous;
+            int steps = (int) ceilf(gap * CKCOMPRESSED_SAMPLES_PER_FRAME);
+            if (steps > 256)
+                steps = 256;
+            for (int k = 1; k < steps; ++k)
+                times.PushBack(previous + gap * (float) k / (float) steps);
+        }
+        times.PushBack(time);
+    }
+}
+
+// Douglas-Peucker reduction: keeps the first and last samples, then in each
+// span the sample furthest from the interpolation of the span ends, until
+// every sample is within maxError. errors.Evaluate(first, last, i) is the
+// error of sample i interpolated between samples first and last.
+template <class SpanError>
+static void ReduceSamples(const SpanError &errors, int count, float maxError, XArray<CKBYTE> &keep) {
+    keep.Resize(count);
+    memset(keep.Begin(), 0, count);
+    keep[0] = 1;
+    keep[count - 1] = 1;
+
+    XArray<int> spans;
+    spans.PushBack(0);
+    spans.PushBack(count - 1);
+    while (spans.Size() > 0) {
+        const int last = spans.PopBack();
+        const int first = spans.PopBack();
+        int worst = -1;
+        float worstError = maxError;
+        for (int i = first + 1; i < last; ++i) {
+            const float error = errors.Evaluate(first, last, i);
+            if (error > worstError) {
+                worstError = error;
+                worst = i;
+            }
+        }
+        if (worst >= 0) {
+            keep[worst] = 1;
+            spans.PushBack(first);
+            spans.PushBack(worst);
+            spans.PushBack(worst);
+            spans.PushBack(last);
+        }
+    }
+}
+
+struct VectorSpanError {
+    const float *Times;
+    const VxVector *Samples;
+    const VxVector *Decoded;
+
+    float Evaluate(int first, int last, int i) const {
+        const float t = (Times[i] - Times[first]) / (Times[last] - Times[first]);
+        const VxVector value = Decoded[first] + (Decoded[last] - Decoded[first]) * t;
+        return Magnitude(value - Samples[i]);
+    }
+};
+
+static inline float QuaternionDot(const VxQuaternion &a, const VxQuaternion &b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+// Angle of the rotation between two unit quaternions. |a - b| = 2 sin(angle / 4)
+// keeps its precision for small angles, unlike acos of the dot product.
+static float QuaternionAngle(const VxQuaternion &a, const VxQuaternion &b) {
+    const float sign = QuaternionDot(a, b) < 0.0f ? -1.0f : 1.0f;
+    const float dx = a.x - sign * b.x;
+    const float dy = a.y - sign * b.y;
+    const float dz = a.z - sign * b.z;
+    const float dw = a.w - sign * b.w;
+    float halfChord = 0.5f * sqrtf(dx * dx + dy * dy + dz * dz + dw * dw);
+    if (halfChord > 1.0f)
+        halfChord = 1.0f;
+    return 4.0f * asinf(halfChord);
+}
+
+// b or -b, whichever is on the side of a, so that interpolating between them
+// takes the shortest path
+static inline VxQuaternion SameHemisphere(const VxQuaternion &a, const VxQuaternion &b) {
+    if (QuaternionDot(a, b) < 0.0f)
+        return VxQuaternion(-b.x, -b.y, -b.z, -b.w);
+    return b;
+}
+
+struct QuaternionSpanError {
+    const float *Times;
+    const VxQuaternion *Samples;
+    const VxQuaternion *Decoded;
+
+    float Evaluate(int first, int last, int i) const {
+        const float t = (Times[i] - Times[first]) / (Times[last] - Times[first]);
+        const VxQuaternion value = Slerp(t, Decoded[first], SameHemisphere(Decoded[first], Decoded[last]));
+        return QuaternionAngle(value, Samples[i]);
+    }
+};
+
+// Smallest three: 2 bits for the index of the largest component, made
+// positive, then the three others in [-1/sqrt(2), 1/sqrt(2)] on 15 bits each
+static const float kSqrt2 = 1.41421356f;
+static const float kSmallestThreeMax = 32767.0f;
+
+static void EncodeQuaternion(const VxQuaternion &rot, CKWORD *out) {
+    float c[4] = {rot.x, rot.y, rot.z, rot.w};
+    const float length = sqrtf(c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3]);
+    if (length < 1e-12f) {
+        c[0] = c[1] = c[2] = 0.0f;
+        c[3] = 1.0f;
+    }
+
+    int largest = 0;
+    for (int i = 1; i < 4; ++i) {
+        if (fabsf(c[i]) > fabsf(c[largest]))
+            largest = i;
+    }
+    const float scale = (c[largest] < 0.0f ? -kSqrt2 : kSqrt2) / (length < 1e-12f ? 1.0f : length);
+
+    CKDWORD q[3];
+    for (int i = 0, j = 0; i < 4; ++i) {
+        if (i == largest)
+            continue;
+        float v = (c[i] * scale + 1.0f) * 0.5f * kSmallestThreeMax + 0.5f;
+        if (v < 0.0f)
+            v = 0.0f;
+        if (v > kSmallestThreeMax)
+            v = kSmallestThreeMax;
+        q[j++] = (CKDWORD) v;
+    }
+    out[0] = (CKWORD) ((largest << 14) | (q[0] >> 1));
+    out[1] = (CKWORD) (((q[0] & 1) << 15) | q[1]);
+    out[2] = (CKWORD) q[2];
+}
+
+static void DecodeQuaternion(const CKWORD *in, VxQuaternion &rot) {
+    const int largest = in[0] >> 14;
+    const CKDWORD q[3] = {(CKDWORD) ((in[0] & 0x3FFF) << 1) | (in[1] >> 15), (CKDWORD) (in[1] & 0x7FFF),
+                          (CKDWORD) (in[2] & 0x7FFF)};
+
+    float c[4];
+    float sum = 0.0f;
+    for (int i = 0, j = 0; i < 4; ++i) {
+        if (i == largest)
+            continue;
+        c[i] = ((float) q[j++] * (2.0f / kSmallestThreeMax) - 1.0f) * (1.0f / kSqrt2);
+        sum += c[i] * c[i];
+    }
+    c[largest] = sum < 1.0f ? sqrtf(1.0f - sum) : 0.0f;
+    rot.x = c[0];
+    rot.y = c[1];
+    rot.z = c[2];
+    rot.w = c[3];
+}
+
+// 3 CKWORD per key, padded to a multiple of 4 bytes
+static inline int PackedKeyValuesSize(int count) {
+    return (count * 3 * (int) sizeof(CKWORD) + 3) & ~3;
+}
+
+//===================================================================
+// RCKCompressedVectorController Implementation
+//===================================================================
+
+RCKCompressedVectorController::RCKCompressedVectorController(CKANIMATION_CONTROLLER type)
+    : CKAnimController(type), m_Times(nullptr), m_Values(nullptr), m_Min(0.0f, 0.0f, 0.0f), m_Step(0.0f, 0.0f, 0.0f),
+      m_Cursor(-1) {
+    m_Length = 0.0f;
+}
+
+RCKCompressedVectorController::~RCKCompressedVectorController() {
+    delete[] m_Times;
+    delete[] m_Values;
+}
+
+void RCKCompressedVectorController::DecodeKey(int index, VxVector &value) const {
+    const CKWORD *q = &m_Values[index * 3];
+    value.x = m_Min.x + (float) q[0] * m_Step.x;
+    value.y = m_Min.y + (float) q[1] * m_Step.y;
+    value.z = m_Min.z + (float) q[2] * m_Step.z;
+}
+
+static inline CKWORD QuantizeComponent(float value, float min, float step) {
+    if (step <= 0.0f)
+        return 0;
+    float q = (value - min) / step + 0.5f;
+    if (q < 0.0f)
+        q = 0.0f;
+    if (q > 65535.0f)
+        q = 65535.0f;
+    return (CKWORD) q;
+}
+
+void RCKCompressedVectorController::EncodeKey(int index, const VxVector &value) {
+    CKWORD *q = &m_Values[index * 3];
+    q[0] = QuantizeComponent(value.x, m_Min.x, m_Step.x);
+    q[1] = QuantizeComponent(value.y, m_Min.y, m_Step.y);
+    q[2] = QuantizeComponent(value.z, m_Min.z, m_Step.z);
+}
+
+void RCKCompressedVectorController::SetRange(const VxVector *values, int count) {
+    VxVector max = values[0];
+    m_Min = values[0];
+    for (int i = 1; i < count; ++i) {
+        m_Min = Minimize(m_Min, values[i]);
+        max = Maximize(max, values[i]);
+    }
+    m_Step = (max - m_Min) * (1.0f / 65535.0f);
+}
+
+void RCKCompressedVectorController::SetKeys(const float *times, const VxVector *values, int count) {
+    delete[] m_Times;
+    delete[] m_Values;
+    m_Times = nullptr;
+    m_Values = nullptr;
+    m_NbKeys = count;
+    m_Segment.Invalidate();
+    if (count <= 0)
+        return;
+
+    m_Times = new float[count];
+    m_Values = new CKWORD[count * 3];
+    memcpy(m_Times, times, count * sizeof(float));
+    SetRange(values, count);
+    for (int i = 0; i < count; ++i)
+        EncodeKey(i, values[i]);
+}
+
+CKBOOL RCKCompressedVectorController::Evaluate(float TimeStep, void *res) {
+    if (m_NbKeys <= 0)
+        return FALSE;
+
+    VxVector *result = static_cast<VxVector *>(res);
+    if (TimeStep <= m_Times[0]) {
+        DecodeKey(0, *result);
+        return TRUE;
+    }
+    if (TimeStep >= m_Times[m_NbKeys - 1]) {
+        DecodeKey(m_NbKeys - 1, *result);
+        return TRUE;
+    }
+
+    int low = FindKeyInterval(m_Times, m_NbKeys, TimeStep, m_Cursor);
+    m_Cursor = low;
+
+    // Decode the keys only when entering a new interval
+    if (m_Segment.Key != low) {
+        VxVector from, to;
+        DecodeKey(low, from);
+        DecodeKey(low + 1, to);
+        m_Segment.Key = low;
+        m_Segment.StartTime = m_Times[low];
+        m_Segment.InvLength = 1.0f / (m_Times[low + 1] - m_Times[low]);
+        m_Segment.Coefs[2] = to - from;
+        m_Segment.Coefs[3] = from;
+    }
+
+    const float t = (TimeStep - m_Segment.StartTime) * m_Segment.InvLength;
+    *result = m_Segment.Coefs[3] + m_Segment.Coefs[2] * t;
+    return TRUE;
+}
+
+int RCKCompressedVectorController::AddKey(CKKey *key) {
+    if (!key)
+        return -1;
+
+    CKPositionKey *posKey = static_cast<CKPositionKey *>(key);
+    const float time = posKey->TimeStep;
+
+    int index = m_NbKeys;
+    CKBOOL replace = FALSE;
+    for (int i = 0; i < m_NbKeys; ++i) {
+        if (m_Times[i] == time) {
+            index = i;
+            replace = TRUE;
+            break;
+        }
+        if (m_Times[i] > time) {
+            index = i;
+            break;
+        }
+    }
+
+    // Decode, insert, and quantize again over the new range
+    const int count = replace ? m_NbKeys : m_NbKeys + 1;
+    float *times = new float[count];
+    VxVector *values = new VxVector[count];
+    for (int i = 0, j = 0; i < count; ++i) {
+        if (i == index) {
+            times[i] = time;
+            values[i] = posKey->Pos;
+            if (replace)
+                ++j;
+            continue;
+        }
+        times[i] = m_Times[j];
+        DecodeKey(j, values[i]);
+        ++j;
+    }
+    SetKeys(times, values, count);
+    delete[] times;
+    delete[] values;
+
+    return index;
+}
+
+CKKey *RCKCompressedVectorController::GetKey(int index) {
+    if (index < 0 || index >= m_NbKeys)
+        return nullptr;
+    m_KeyCopy.TimeStep = m_Times[index];
+    DecodeKey(index, m_KeyCopy.Pos);
+    return &m_KeyCopy;
+}
+
+void RCKCompressedVectorController::RemoveKey(int index) {
+    if (index < 0 || index >= m_NbKeys)
+        return;
+
+    --m_NbKeys;
+    m_Segment.Invalidate();
+    if (m_NbKeys == 0) {
+        delete[] m_Times;
+        delete[] m_Values;
+        m_Times = nullptr;
+        m_Values = nullptr;
+        return;
+    }
+
+    // The range of the remaining keys is kept
+    const int after = m_NbKeys - index;
+    memmove(&m_Times[index], &m_Times[index + 1], after * sizeof(float));
+    memmove(&m_Values[index * 3], &m_Values[(index + 1) * 3], after * 3 * sizeof(CKWORD));
+}
+
+// Layout: key count, range minimum, range step, times, quantized values
+int RCKCompressedVectorController::DumpKeysTo(void *Buffer) {
+    const int size = sizeof(int) + 2 * sizeof(VxVector) + m_NbKeys * sizeof(float) + PackedKeyValuesSize(m_NbKeys);
+
+    if (Buffer) {
+        CKBYTE *buf = static_cast<CKBYTE *>(Buffer);
+        memcpy(buf, &m_NbKeys, sizeof(int));
+        buf += sizeof(int);
+        memcpy(buf, &m_Min, sizeof(VxVector));
+        buf += sizeof(VxVector);
+        memcpy(buf, &m_Step, sizeof(VxVector));
+        buf += sizeof(VxVector);
+        if (m_NbKeys > 0) {
+            memcpy(buf, m_Times, m_NbKeys * sizeof(float));
+            buf += m_NbKeys * sizeof(float);
+            memset(buf, 0, PackedKeyValuesSize(m_NbKeys));
+            memcpy(buf, m_Values, m_NbKeys * 3 * sizeof(CKWORD));
+        }
+    }
+
+    return size;
+}
+
+int RCKCompressedVectorController::ReadKeysFrom(void *Buffer) {
+    if (!Buffer)
+        return 0;
+
+    delete[] m_Times;
+    delete[] m_Values;
+    m_Times = nullptr;
+    m_Values = nullptr;
+    m_Segment.Invalidate();
+
+    const CKBYTE *buf = static_cast<const CKBYTE *>(Buffer);
+    memcpy(&m_NbKeys, buf, sizeof(int));
+    buf += sizeof(int);
+    memcpy(&m_Min, buf, sizeof(VxVector));
+    buf += sizeof(VxVector);
+    memcpy(&m_Step, buf, sizeof(VxVector));
+    buf += sizeof(VxVector);
+
+    if (m_NbKeys > 0) {
+        m_Times = new float[m_NbKeys];
+        m_Values = new CKWORD[m_NbKeys * 3];
+        memcpy(m_Times, buf, m_NbKeys * sizeof(float));
+        buf += m_NbKeys * sizeof(float);
+        memcpy(m_Values, buf, m_NbKeys * 3 * sizeof(CKWORD));
+    } else {
+        m_NbKeys = 0;
+    }
+
+    return sizeof(int) + 2 * sizeof(VxVector) + m_NbKeys * sizeof(float) + PackedKeyValuesSize(m_NbKeys);
+}
+
+CKBOOL RCKCompressedVectorController::Compare(CKAnimController *control, float Threshold) {
+    if (!control || control->GetType() != m_Type)
+        return FALSE;
+
+    RCKCompressedVectorController *other = static_cast<RCKCompressedVectorController *>(control);
+    if (m_NbKeys != other->m_NbKeys)
+        return FALSE;
+
+    for (int i = 0; i < m_NbKeys; ++i) {
+        VxVector a, b;
+        DecodeKey(i, a);
+        other->DecodeKey(i, b);
+        if (fabsf(m_Times[i] - other->m_Times[i]) > Threshold || fabsf(a.x - b.x) > Threshold ||
+            fabsf(a.y - b.y) > Threshold || fabsf(a.z - b.z) > Threshold)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+CKBOOL RCKCompressedVectorController::Clone(CKAnimController *control) {
+    if (!CKAnimController::Clone(control))
+        return FALSE;
+
+    RCKCompressedVectorController *other = static_cast<RCKCompressedVectorController *>(control);
+
+    delete[] m_Times;
+    delete[] m_Values;
+    m_Times = nullptr;
+    m_Values = nullptr;
+    m_Segment.Invalidate();
+    m_Min = other->m_Min;
+    m_Step = other->m_Step;
+
+    if (other->m_NbKeys > 0) {
+        m_Times = new float[other->m_NbKeys];
+        m_Values = new CKWORD[other->m_NbKeys * 3];
+        memcpy(m_Times, other->m_Times, other->m_NbKeys * sizeof(float));
+        memcpy(m_Values, other->m_Values, other->m_NbKeys * 3 * sizeof(CKWORD));
+    }
+
+    return TRUE;
+}
+
+CKBOOL RCKCompressedVectorController::Compress(CKAnimController *source, float maxError) {
+    if (!source || source == this || source->m_NbKeys <= 0)
+        return FALSE;
+    if ((source->GetType() & CKANIMATION_CONTROLLER_MASK) != (m_Type & CKANIMATION_CONTROLLER_MASK))
+        return FALSE;
+
+    XArray<float> times;
+    SampleSourceTimes(source, times);
+    const int count = times.Size();
+    XArray<VxVector> samples;
+    samples.Resize(count);
+    for (int i = 0; i < count; ++i)
+        source->Evaluate(times[i], &samples[i]);
+
+    // Quantize every sample first, so that the reduction measures the error
+    // of the keys as they decode
+    SetKeys(times.Begin(), samples.Begin(), count);
+    XArray<VxVector> decoded;
+    decoded.Resize(count);
+    for (int i = 0; i < count; ++i)
+        DecodeKey(i, decoded[i]);
+
+    VectorSpanError errors = {times.Begin(), samples.Begin(), decoded.Begin()};
+    XArray<CKBYTE> keep;
+    ReduceSamples(errors, count, maxError, keep);
+
+    int kept = 0;
+    for (int i = 0; i < count; ++i)
+        kept += keep[i];
+    float *keptTimes = new float[kept];
+    CKWORD *keptValues = new CKWORD[kept * 3];
+    for (int i = 0, k = 0; i < count; ++i) {
+        if (!keep[i])
+            continue;
+        keptTimes[k] = m_Times[i];
+        memcpy(&keptValues[k * 3], &m_Values[i * 3], 3 * sizeof(CKWORD));
+        ++k;
+    }
+    delete[] m_Times;
+    delete[] m_Values;
+    m_Times = keptTimes;
+    m_Values = keptValues;
+    m_NbKeys = kept;
+    m_Segment.Invalidate();
+    m_Length = source->m_Length;
+
+    return TRUE;
+}
+
+//===================================================================
+// RCKCompressedQuaternionController Implementation
+//===================================================================
+
+RCKCompressedQuaternionController::RCKCompressedQuaternionController(CKANIMATION_CONTROLLER type)
+    : CKAnimController(type), m_Times(nullptr), m_Values(nullptr), m_Cursor(-1), m_SegmentKey(-1),
+      m_SegmentStart(0.0f), m_SegmentInvLength(0.0f) {
+    m_Length = 0.0f;
+}
+
+RCKCompressedQuaternionController::~RCKCompressedQuaternionController() {
+    delete[] m_Times;
+    delete[] m_Values;
+}
+
+void RCKCompressedQuaternionController::DecodeKey(int index, VxQuaternion &value) const {
+    DecodeQuaternion(&m_Values[index * 3], value);
+}
+
+void RCKCompressedQuaternionController::Resize(int count) {
+    float *times = nullptr;
+    CKWORD *values = nullptr;
+    if (count > 0) {
+        times = new float[count];
+        values = new CKWORD[count * 3];
+        const int copied = count < m_NbKeys ? count : m_NbKeys;
+        if (copied > 0) {
+            memcpy(times, m_Times, copied * sizeof(float));
+            memcpy(values, m_Values, copied * 3 * sizeof(CKWORD));
+        }
+    }
+    delete[] m_Times;
+    delete[] m_Values;
+    m_Times = times;
+    m_Values = values;
+    m_NbKeys = count;
+    m_SegmentKey = -1;
+}
+
+CKBOOL RCKCompressedQuaternionController::Evaluate(float TimeStep, void *res) {
+    if (m_NbKeys <= 0)
+        return FALSE;
+
+    VxQuaternion *result = static_cast<VxQuaternion *>(res);
+    if (TimeStep <= m_Times[0]) {
+        DecodeKey(0, *result);
+        return TRUE;
+    }
+    if (TimeStep >= m_Times[m_NbKeys - 1]) {
+        DecodeKey(m_NbKeys - 1, *result);
+        return TRUE;
+    }
+
+    int low = FindKeyInterval(m_Times, m_NbKeys, TimeStep, m_Cursor);
+    m_Cursor = low;
+
+    // Decode the keys only when entering a new interval
+    if (m_SegmentKey != low) {
+        VxQuaternion to;
+        DecodeKey(low, m_SegmentRot[0]);
+        DecodeKey(low + 1, to);
+        m_SegmentRot[1] = SameHemisphere(m_SegmentRot[0], to);
+        m_SegmentKey = low;
+        m_SegmentStart = m_Times[low];
+        m_SegmentInvLength = 1.0f / (m_Times[low + 1] - m_Times[low]);
+    }
+
+    *result = Slerp((TimeStep - m_SegmentStart) * m_SegmentInvLength, m_SegmentRot[0], m_SegmentRot[1]);
+    return TRUE;
+}
+
+int RCKCompressedQuaternionController::AddKey(CKKey *key) {
+    if (!key)
+        return -1;
+
+    CKRotationKey *rotKey = static_cast<CKRotationKey *>(key);
+    const float time = rotKey->TimeStep;
+
+    for (int i = 0; i < m_NbKeys; ++i) {
+        if (m_Times[i] == time) {
+            EncodeQuaternion(rotKey->Rot, &m_Values[i * 3]);
+            m_SegmentKey = -1;
+            return i;
+        }
+        if (m_Times[i] > time) {
+            Resize(m_NbKeys + 1);
+            const int after = m_NbKeys - 1 - i;
+            memmove(&m_Times[i + 1], &m_Times[i], after * sizeof(float));
+            memmove(&m_Values[(i + 1) * 3], &m_Values[i * 3], after * 3 * sizeof(CKWORD));
+            m_Times[i] = time;
+            EncodeQuaternion(rotKey->Rot, &m_Values[i * 3]);
+            return i;
+        }
+    }
+
+    Resize(m_NbKeys + 1);
+    m_Times[m_NbKeys - 1] = time;
+    EncodeQuaternion(rotKey->Rot, &m_Values[(m_NbKeys - 1) * 3]);
+    return m_NbKeys - 1;
+}
+
+CKKey *RCKCompressedQuaternionController::GetKey(int index) {
+    if (index < 0 || index >= m_NbKeys)
+        return nullptr;
+    m_KeyCopy.TimeStep = m_Times[index];
+    DecodeKey(index, m_KeyCopy.Rot);
+    return &m_KeyCopy;
+}
+
+void RCKCompressedQuaternionController::RemoveKey(int index) {
+    if (index < 0 || index >= m_NbKeys)
+        return;
+
+    const int after = m_NbKeys - 1 - index;
+    memmove(&m_Times[index], &m_Times[index + 1], after * sizeof(float));
+    memmove(&m_Values[index * 3], &m_Values[(index + 1) * 3], after * 3 * sizeof(CKWORD));
+    Resize(m_NbKeys - 1);
+}
+
+// Layout: key count, times, smallest three values
+int RCKCompressedQuaternionController::DumpKeysTo(void *Buffer) {
+    const int size = sizeof(int) + m_NbKeys * sizeof(float) + PackedKeyValuesSize(m_NbKeys);
+
+    if (Buffer) {
+        CKBYTE *buf = static_cast<CKBYTE *>(Buffer);
+        memcpy(buf, &m_NbKeys, sizeof(int));
+        buf += sizeof(int);
+        if (m_NbKeys > 0) {
+            memcpy(buf, m_Times, m_NbKeys * sizeof(float));
+            buf += m_NbKeys * sizeof(float);
+            memset(buf, 0, PackedKeyValuesSize(m_NbKeys));
+            memcpy(buf, m_Values, m_NbKeys * 3 * sizeof(CKWORD));
+        }
+    }
+
+    return size;
+}
+
+int RCKCompressedQuaternionController::ReadKeysFrom(void *Buffer) {
+    if (!Buffer)
+        return 0;
+
+    const CKBYTE *buf = static_cast<const CKBYTE *>(Buffer);
+    int count = 0;
+    memcpy(&count, buf, sizeof(int));
+    buf += sizeof(int);
+
+    // Resize keeps the old keys, drop them first
+    Resize(0);
+    if (count > 0) {
+        Resize(count);
+        memcpy(m_Times, buf, count * sizeof(float));
+        buf += count * sizeof(float);
+        memcpy(m_Values, buf, count * 3 * sizeof(CKWORD));
+    }
+
+    return sizeof(int) + m_NbKeys * sizeof(float) + PackedKeyValuesSize(m_NbKeys);
+}
+
+CKBOOL RCKCompressedQuaternionController::Compare(CKAnimController *control, float Threshold) {
+    if (!control || control->GetType() != m_Type)
+        return FALSE;
+
+    RCKCompressedQuaternionController *other = static_cast<RCKCompressedQuaternionController *>(control);
+    if (m_NbKeys != other->m_NbKeys)
+        return FALSE;
+
+    for (int i = 0; i < m_NbKeys; ++i) {
+        VxQuaternion a, b;
+        DecodeKey(i, a);
+        other->DecodeKey(i, b);
+        if (fabsf(m_Times[i] - other->m_Times[i]) > Threshold || fabsf(a.x - b.x) > Threshold ||
+            fabsf(a.y - b.y) > Threshold || fabsf(a.z - b.z) > Threshold || fabsf(a.w - b.w) > Threshold)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+CKBOOL RCKCompressedQuaternionController::Clone(CKAnimController *control) {
+    if (!CKAnimController::Clone(control))
+        return FALSE;
+
+    RCKCompressedQuaternionController *other = static_cast<RCKCompressedQuaternionController *>(control);
+
+    delete[] m_Times;
+    delete[] m_Values;
+    m_Times = nullptr;
+    m_Values = nullptr;
+    m_SegmentKey = -1;
+
+    if (other->m_NbKeys > 0) {
+        m_Times = new float[other->m_NbKeys];
+        m_Values = new CKWORD[other->m_NbKeys * 3];
+        memcpy(m_Times, other->m_Times, other->m_NbKeys * sizeof(float));
+        memcpy(m_Values, other->m_Values, other->m_NbKeys * 3 * sizeof(CKWORD));
+    }
+
+    return TRUE;
+}
+
+CKBOOL RCKCompressedQuaternionController::Compress(CKAnimController *source, float maxError) {
+    if (!source || source == this || source->m_NbKeys <= 0)
+        return FALSE;
+    if ((source->GetType() & CKANIMATION_CONTROLLER_MASK) != (m_Type & CKANIMATION_CONTROLLER_MASK))
+        return FALSE;
+
+    XArray<float> times;
+    SampleSourceTimes(source, times);
+    const int count = times.Size();
+    XArray<VxQuaternion> samples;
+    XArray<VxQuaternion> decoded;
+    samples.Resize(count);
+    decoded.Resize(count);
+
+    Resize(0);
+    Resize(count);
+    for (int i = 0; i < count; ++i) {
+        source->Evaluate(times[i], &samples[i]);
+        samples[i].Normalize();
+        m_Times[i] = times[i];
+        EncodeQuaternion(samples[i], &m_Values[i * 3]);
+        DecodeKey(i, decoded[i]);
+    }
+
+    QuaternionSpanError errors = {times.Begin(), samples.Begin(), decoded.Begin()};
+    XArray<CKBYTE> keep;
+    ReduceSamples(errors, count, maxError, keep);
+
+    int kept = 0;
+    for (int i = 0; i < count; ++i) {
+        if (!keep[i])
+            continue;
+        m_Times[kept] = m_Times[i];
+        memcpy(&m_Values[kept * 3], &m_Values[i * 3], 3 * sizeof(CKWORD));
+        ++kept;
+    }
+    Resize(kept);
+    m_Length = source->m_Length;
+
+    return TRUE;
+}
+
 //===================================================================
 // RCKMorphController Implementation
 //===================================================================
 
 RCKMorphController::RCKMorphController()
-    : CKMorphController(), m_Keys(nullptr), m_VertexCount(0) {
+    : CKMorphController(), m_Keys(nullptr), m_VertexCount(0), m_Cursor(0), m_DeltasDirty(TRUE) {
     m_Length = 0.0f;
 }
 
@@ -2454,11 +3239,115 @@ CKBOOL RCKMorphController::Evaluate(float TimeStep, void *res) {
     return FALSE;
 }
 
+CKBOOL RCKMorphController::PrepareDeltas(int VertexCount) {
+    if (m_DeltasDirty) {
+        m_DeltasDirty = FALSE;
+        m_Cursor = 0;
+        m_Deltas.Build(m_Keys, m_NbKeys, m_VertexCount);
+    }
+    return m_Deltas.IsBuilt() && VertexCount <= m_VertexCount;
+}
+
+void RCKMorphController::SelectKeys(float TimeStep, int &from, int &to, float &factor) {
+    factor = 0.0f;
+    if (TimeStep <= m_Keys[0].TimeStep) {
+        from = to = 0;
+    } else if (TimeStep >= m_Keys[m_NbKeys - 1].TimeStep) {
+        from = to = m_NbKeys - 1;
+    } else {
+        m_Cursor = FindKeyInterval(m_Keys, m_NbKeys, TimeStep, m_Cursor);
+        const float t1 = m_Keys[m_Cursor].TimeStep;
+        const float t2 = m_Keys[m_Cursor + 1].TimeStep;
+        factor = (TimeStep - t1) / (t2 - t1);
+        from = m_Cursor;
+        to = factor > 0.0f ? m_Cursor + 1 : m_Cursor;
+    }
+}
+
 CKBOOL RCKMorphController::Evaluate(float TimeStep, int VertexCount, void *VertexPtr,
                                     CKDWORD VertexStride, VxCompressedVector *NormalPtr) {
     if (m_NbKeys <= 0 || VertexCount <= 0)
         return FALSE;
+    if (!PrepareDeltas(VertexCount))
+        return EvaluateKeys(TimeStep, VertexCount, VertexPtr, VertexStride, NormalPtr);
+
+    // Vertices outside the key pair keep the first key pose
+    const CKMorphKey &base = m_Keys[0];
+    if (VertexPtr) {
+        if (VertexStride == sizeof(VxVector))
+            memcpy(VertexPtr, base.PosArray, VertexCount * sizeof(VxVector));
+        else
+            VxCopyStructure(VertexCount, VertexPtr, VertexStride, sizeof(VxVector), base.PosArray, sizeof(VxVector));
+    }
+    if (NormalPtr && m_Deltas.HasNormals())
+        memcpy(NormalPtr, base.NormArray, VertexCount * sizeof(VxCompressedVector));
+
+    int from, to;
+    float factor;
+    SelectKeys(TimeStep, from, to, factor);
+    m_Deltas.SetPair(m_Keys, from, to);
+    m_Deltas.EvaluatePair(factor, VertexCount, (CKBYTE *) VertexPtr, VertexStride, NormalPtr);
+    return TRUE;
+}
 
+int RCKMorphController::EvaluateChanges(float TimeStep, int VertexCount, void *VertexPtr, CKDWORD VertexStride,
+                                        VxCompressedVector *NormalPtr, CKMorphState &state, XArray<int> &moved) {
+    moved.Resize(0);
+    if (m_NbKeys <= 0 || VertexCount <= 0) {
+        state.Invalidate();
+        return -1;
+    }
+    if (!PrepareDeltas(VertexCount)) {
+        state.Invalidate();
+        EvaluateKeys(TimeStep, VertexCount, VertexPtr, VertexStride, NormalPtr);
+        return -1;
+    }
+
+    int from, to;
+    float factor;
+    SelectKeys(TimeStep, from, to, factor);
+    if (state.Version != m_Deltas.GetVersion() || state.VertexCount != VertexCount) {
+        Evaluate(TimeStep, VertexCount, VertexPtr, VertexStride, NormalPtr);
+        state.Version = m_Deltas.GetVersion();
+        state.VertexCount = VertexCount;
+        state.KeyFrom = from;
+        state.KeyTo = to;
+        state.Factor = factor;
+        return -1;
+    }
+    if (from == state.KeyFrom && to == state.KeyTo && factor == state.Factor)
+        return 0;
+
+    CKBYTE *vertexPtr = (CKBYTE *) VertexPtr;
+    if (from != state.KeyFrom || to != state.KeyTo) {
+        // Vertices the previous pair moved go back to the first key pose
+        const int previous[2] = {state.KeyFrom, state.KeyTo};
+        for (int p = 0; p < 2; ++p) {
+            if (p == 1 && previous[1] == previous[0])
+                break;
+            int count;
+            const int *vertices = m_Deltas.GetKeyVertices(previous[p], count);
+            count = m_Deltas.RestoreKey(m_Keys, previous[p], VertexCount, vertexPtr, VertexStride, NormalPtr);
+            for (int i = 0; i < count; ++i)
+                moved.PushBack(vertices[i]);
+        }
+    }
+
+    m_Deltas.SetPair(m_Keys, from, to);
+    const int count = m_Deltas.EvaluatePair(factor, VertexCount, vertexPtr, VertexStride, NormalPtr);
+    int pairCount;
+    const int *vertices = m_Deltas.GetPairVertices(pairCount);
+    for (int i = 0; i < count; ++i)
+        moved.PushBack(vertices[i]);
+
+    state.KeyFrom = from;
+    state.KeyTo = to;
+    state.Factor = factor;
+    return moved.Size();
+}
+
+CKBOOL RCKMorphController::EvaluateKeys(float TimeStep, int VertexCount, void *VertexPtr,
+                                        CKDWORD VertexStride, VxCompressedVector *NormalPtr) {
     // Find the key index
     int keyIdx = -1;
     for (int i = 0; i < m_NbKeys; ++i) {
@@ -2575,6 +3464,7 @@ int RCKMorphController::AddKey(CKKey *key, CKBOOL AllocateNormals) {
 
     CKMorphKey *morphKey = static_cast<CKMorphKey *>(key);
     float time = morphKey->TimeStep;
+    m_DeltasDirty = TRUE;
 
     int insertIdx = m_NbKeys;
     for (int i = 0; i < m_NbKeys; ++i) {
@@ -2617,6 +3507,7 @@ CKKey *RCKMorphController::GetKey(int index) {
 void RCKMorphController::RemoveKey(int index) {
     if (index < 0 || index >= m_NbKeys)
         return;
+    m_DeltasDirty = TRUE;
 
     // Free memory for the key being removed
     delete[] m_Keys[index].PosArray;
@@ -2688,6 +3579,7 @@ int RCKMorphController::DumpKeysTo(void *Buffer) {
 int RCKMorphController::ReadKeysFrom(void *Buffer) {
     if (!Buffer)
         return 0;
+    m_DeltasDirty = TRUE;
 
     // Clean up existing data
     for (int i = 0; i < m_NbKeys; ++i) {
@@ -2752,13 +3644,16 @@ CKBOOL RCKMorphController::Compare(CKAnimController *control, float Threshold) {
 }
 
 CKBOOL RCKMorphController::Clone(CKAnimController *control) {
+    // CKAnimController::Clone copies the key count
+    const int oldKeyCount = m_NbKeys;
     if (!CKAnimController::Clone(control))
         return FALSE;
 
     RCKMorphController *other = static_cast<RCKMorphController *>(control);
+    m_DeltasDirty = TRUE;
 
     // Clean up existing data
-    for (int i = 0; i < m_NbKeys; ++i) {
+    for (int i = 0; i < oldKeyCount; ++i) {
         delete[] m_Keys[i].PosArray;
         delete[] m_Keys[i].NormArray;
     }
@@ -2795,6 +3690,7 @@ CKBOOL RCKMorphController::Clone(CKAnimController *control) {
 void RCKMorphController::SetMorphVertexCount(int count) {
     if (count == m_VertexCount)
         return;
+    m_DeltasDirty = TRUE;
 
     // Resize all existing keys
     for (int i = 0; i < m_NbKeys; ++i) {
@@ -1475,7 +1475,7 @@ CKDWORD RCKMaterial::TexGenEffect(RCKRenderContext *dev, VX_EFFECTTEXGEN texGen,
         CK3dEntity *rootEntity = dev->m_RenderedScene->GetRootEntity();
         texMatrix = (refEntity == reinterpret_cast<RCK3dEntity *>(rootEntity))
                         ? VxMatrix::Identity()
-                        : refEntity->m_WorldMatrix;
+                        : refEntity->GetWorldMatrix();
 
         // IDA: Copy row 3 to row 2 and force [2][2] = 1.0f (even for root entity)
         texMatrix[2][0] = texMatrix[3][0];
@@ -1513,9 +1513,9 @@ CKDWORD RCKMaterial::TexGenEffect(RCKRenderContext *dev, VX_EFFECTTEXGEN texGen,
             // IDA builds an orthonormal basis from (rst->m_WorldMatrix.translation - refEntity.translation)
             // and converts it through rootEntity->GetWorldMatrix().
             const VxVector dirRaw(
-                rst->m_WorldMatrix[3][0] - refEntity->m_WorldMatrix[3][0],
-                rst->m_WorldMatrix[3][1] - refEntity->m_WorldMatrix[3][1],
-                rst->m_WorldMatrix[3][2] - refEntity->m_WorldMatrix[3][2]);
+                rst->m_WorldMatrix[3][0] - refEntity->GetWorldMatrix()[3][0],
+                rst->m_WorldMatrix[3][1] - refEntity->GetWorldMatrix()[3][1],
+                rst->m_WorldMatrix[3][2] - refEntity->GetWorldMatrix()[3][2]);
 
             VxVector dir = dirRaw;
             dir.Normalize();
@@ -1595,7 +1595,7 @@ CKDWORD RCKMaterial::TexGenEffect(RCKRenderContext *dev, VX_EFFECTTEXGEN texGen,
         // Cubemap reflection
         rst->SetTextureStageState(stage, CKRST_TSS_TEXTURETRANSFORMFLAGS, CKRST_TTF_COUNT3);
         rst->SetTextureStageState(stage, CKRST_TSS_TEXCOORDINDEX, stage | 0x30000);
-        texMatrix = refEntity->m_WorldMatrix;
+        texMatrix = refEntity->GetWorldMatrix();
         texMatrix[3][0] = 0.0f;
         texMatrix[3][1] = 0.0f;
         texMatrix[3][2] = 0.0f;
@@ -1608,7 +1608,7 @@ CKDWORD RCKMaterial::TexGenEffect(RCKRenderContext *dev, VX_EFFECTTEXGEN texGen,
         // Cubemap normals
         rst->SetTextureStageState(stage, CKRST_TSS_TEXTURETRANSFORMFLAGS, CKRST_TTF_COUNT3);
         rst->SetTextureStageState(stage, CKRST_TSS_TEXCOORDINDEX, stage | 0x10000);
-        texMatrix = refEntity->m_WorldMatrix;
+        texMatrix = refEntity->GetWorldMatrix();
         texMatrix[3][0] = 0.0f;
         texMatrix[3][1] = 0.0f;
         texMatrix[3][2] = 0.0f;
@@ -1621,7 +1621,7 @@ CKDWORD RCKMaterial::TexGenEffect(RCKRenderContext *dev, VX_EFFECTTEXGEN texGen,
         // Cubemap skymap
         rst->SetTextureStageState(stage, CKRST_TSS_TEXTURETRANSFORMFLAGS, CKRST_TTF_COUNT3);
         rst->SetTextureStageState(stage, CKRST_TSS_TEXCOORDINDEX, stage | 0x20000);
-        texMatrix = refEntity->m_WorldMatrix;
+        texMatrix = refEntity->GetWorldMatrix();
         texMatrix[3][0] = 0.0f;
         texMatrix[3][1] = 0.0f;
         texMatrix[3][2] = 0.0f;
@@ -1,5 +1,7 @@
 #include "RCKMesh.h"
 
+#include "CKMeshBVH.h"
+#include "CKMeshVertexFaces.h"
 #include "CKMemoryPool.h"
 #include "CKStateChunk.h"
 #include "CKFile.h"
@@ -10,6 +12,7 @@
 #include "CKSkin.h"
 #include "CKObjectAnimation.h"
 #include "CKKeyframeData.h"
+#include "RCKKeyframeData.h"
 #include "CKRasterizer.h"
 #include "RCKRenderManager.h"
 #include "RCKRenderContext.h"
@@ -24,6 +27,22 @@ extern CKBOOL g_UpdateTransparency;
 // External VxMath normal building functions
 extern void (*g_BuildNormalsFunc)(CKFace *, CKWORD *, int, VxVertex *, int);
 extern void (*g_BuildFaceNormalsFunc)(CKFace *, CKWORD *, int, VxVertex *, int);
+extern void (*g_NormalizeFunc)(VxVertex *, int);
+
+// Faces and lines of meshes stored with 32-bit indices, and the opt-in to
+// them. They use the reserved mesh identifiers so older readers skip them;
+// the data starts with a version.
+static const CKDWORD CK_STATESAVE_MESHWIDEINDICES = CK_STATESAVE_MESHRESERVED0;
+static const CKDWORD CK_STATESAVE_MESHFACES32 = CK_STATESAVE_MESHRESERVED1;
+static const CKDWORD CK_STATESAVE_MESHLINES32 = CK_STATESAVE_MESHRESERVED2;
+static const int MESH_WIDEINDICES_VERSION = 1;
+
+// Geometry stamps are shared by all meshes, so a stamp recorded for a deleted
+// mesh never matches a new one allocated at the same address
+static CKDWORD NextGeometryStamp() {
+    static CKDWORD s_GeometryStamp = 0;
+    return ++s_GeometryStamp;
+}
 
 CKVBuffer *RCKMesh::GetVBuffer(CKMaterialGroup *group) const {
     if (!group || !group->m_RemapData)
@@ -49,6 +68,8 @@ void RCKMesh::ResetMaterialGroup(CKMaterialGroup *group, int a2) {
         group->m_Primitives[0].m_Indices.Resize(0);
         group->m_Primitives[0].m_Type = VX_TRIANGLELIST;
         group->m_Primitives[0].m_IndexBufferOffset = -1;
+        group->m_Primitives[0].m_VertexStart = 0;
+        group->m_Primitives[0].m_VertexCount = 0;
     }
 
     group->m_FaceIndices.Resize(0);
@@ -231,6 +252,113 @@ static int ClampPMVertexCount(RCKMesh *mesh, int target) {
     return SnapPMVertexCount(target, maxVertices, morphStep);
 }
 
+static void *OffsetAttribute(void *ptr, CKDWORD stride, CKDWORD start) {
+    return ptr ? (CKBYTE *) ptr + stride * start : nullptr;
+}
+
+// Primitives of meshes with 32-bit indices only address a window of the
+// group vertices (CKPrimitiveEntry::m_VertexStart / m_VertexCount)
+static void DrawGroupPrimitive(CKRasterizerContext *rst, CKPrimitiveEntry *prim, VxDrawPrimitiveData *data) {
+    if (prim->m_VertexCount == 0) {
+        rst->DrawPrimitive(prim->m_Type, prim->m_Indices.Begin(), prim->m_Indices.Size(), data);
+        return;
+    }
+
+    const CKDWORD start = prim->m_VertexStart;
+    VxDrawPrimitiveData window = *data;
+    window.VertexCount = prim->m_VertexCount;
+    window.PositionPtr = OffsetAttribute(data->PositionPtr, data->PositionStride, start);
+    window.NormalPtr = OffsetAttribute(data->NormalPtr, data->NormalStride, start);
+    window.ColorPtr = OffsetAttribute(data->ColorPtr, data->ColorStride, start);
+    window.SpecularColorPtr = OffsetAttribute(data->SpecularColorPtr, data->SpecularColorStride, start);
+    window.TexCoordPtr = OffsetAttribute(data->TexCoordPtr, data->TexCoordStride, start);
+    for (int i = 0; i < CKRST_MAX_STAGES - 1; ++i)
+        window.TexCoordPtrs[i] = OffsetAttribute(data->TexCoordPtrs[i], data->TexCoordStrides[i], start);
+    rst->DrawPrimitive(prim->m_Type, prim->m_Indices.Begin(), prim->m_Indices.Size(), &window);
+}
+
+static void *GatherAttribute(CKBYTE *&scratch, void *src, CKDWORD srcStride, CKDWORD size, XArray<int> &remap) {
+    if (!src)
+        return nullptr;
+    CKBYTE *dst = scratch;
+    VxStridedData dstData(dst, size);
+    VxStridedData srcData(src, srcStride);
+    VxIndexedCopy(dstData, srcData, size, remap.Begin(), remap.Size());
+    scratch += size * remap.Size();
+    return dst;
+}
+
+static void DrawWideBatch(CKRasterizerContext *rst, VXPRIMITIVETYPE type, XArray<int> &remap, XArray<CKWORD> &indices,
+                          XArray<CKBYTE> &scratch, VxDrawPrimitiveData *data) {
+    if (indices.Size() == 0)
+        return;
+
+    const CKDWORD positionSize = (data->Flags & CKRST_DP_TRANSFORM) ? sizeof(VxVector) : sizeof(VxVector4);
+    const CKDWORD vertexSize = positionSize + sizeof(VxVector) + 2 * sizeof(CKDWORD) + CKRST_MAX_STAGES * sizeof(Vx2DVector);
+    scratch.Resize(remap.Size() * vertexSize);
+    CKBYTE *dst = scratch.Begin();
+
+    VxDrawPrimitiveData batch = *data;
+    batch.VertexCount = remap.Size();
+    batch.PositionPtr = GatherAttribute(dst, data->PositionPtr, data->PositionStride, positionSize, remap);
+    batch.PositionStride = positionSize;
+    batch.NormalPtr = GatherAttribute(dst, data->NormalPtr, data->NormalStride, sizeof(VxVector), remap);
+    batch.NormalStride = sizeof(VxVector);
+    batch.ColorPtr = GatherAttribute(dst, data->ColorPtr, data->ColorStride, sizeof(CKDWORD), remap);
+    batch.ColorStride = sizeof(CKDWORD);
+    batch.SpecularColorPtr = GatherAttribute(dst, data->SpecularColorPtr, data->SpecularColorStride, sizeof(CKDWORD), remap);
+    batch.SpecularColorStride = sizeof(CKDWORD);
+    batch.TexCoordPtr = GatherAttribute(dst, data->TexCoordPtr, data->TexCoordStride, sizeof(Vx2DVector), remap);
+    batch.TexCoordStride = sizeof(Vx2DVector);
+    for (int i = 0; i < CKRST_MAX_STAGES - 1; ++i) {
+        batch.TexCoordPtrs[i] = GatherAttribute(dst, data->TexCoordPtrs[i], data->TexCoordStrides[i], sizeof(Vx2DVector), remap);
+        batch.TexCoordStrides[i] = sizeof(Vx2DVector);
+    }
+    rst->DrawPrimitive(type, indices.Begin(), indices.Size(), &batch);
+}
+
+// Draws a triangle or line list of 32-bit indices (mesh level passes of
+// meshes with wide indices). The rasterizers only take 16-bit indices, so the
+// list is cut in batches of at most 0x10000 vertices gathered in a scratch buffer.
+static void DrawWidePrimitive(CKRasterizerContext *rst, VXPRIMITIVETYPE type, const CKDWORD *indices, int indexCount,
+                              int vertexCount, VxDrawPrimitiveData *data) {
+    const int primSize = (type == VX_LINELIST) ? 2 : 3;
+
+    // Position + 1 of each vertex among all batches: values up to batchBase
+    // belong to previous batches
+    XArray<CKDWORD> tracker;
+    tracker.Resize(vertexCount);
+    memset(tracker.Begin(), 0, vertexCount * sizeof(CKDWORD));
+    XArray<int> remap;
+    XArray<CKWORD> localIndices;
+    XArray<CKBYTE> scratch;
+    CKDWORD batchBase = 0;
+
+    for (int i = 0; i + primSize <= indexCount; i += primSize) {
+        int newVertices = 0;
+        for (int k = 0; k < primSize; ++k) {
+            if (tracker[indices[i + k]] <= batchBase)
+                ++newVertices;
+        }
+        if (remap.Size() + newVertices > 0x10000) {
+            DrawWideBatch(rst, type, remap, localIndices, scratch, data);
+            batchBase += remap.Size();
+            remap.Resize(0);
+            localIndices.Resize(0);
+        }
+
+        for (int k = 0; k < primSize; ++k) {
+            const CKDWORD index = indices[i + k];
+            if (tracker[index] <= batchBase) {
+                remap.PushBack((int) index);
+                tracker[index] = batchBase + remap.Size();
+            }
+            localIndices.PushBack((CKWORD) (tracker[index] - 1 - batchBase));
+        }
+    }
+    DrawWideBatch(rst, type, remap, localIndices, scratch, data);
+}
+
 void ProgressiveMeshPreRenderCallback(CKRenderContext *ctx, CK3dEntity *entity, CKMesh *meshObj, void *data) {
     // Match IDA at 0x100238dd
     // The original callback simply calls BuildRenderMesh
@@ -273,6 +401,14 @@ RCKMesh::RCKMesh(CKContext *Context, CKSTRING name) : CKMesh(Context, name) {
     m_FaceChannelMask = 0;
     m_Valid = 0;
     m_VertexBufferReady = 0;
+    m_VBDirtyAttributes = 0;
+    m_VBDirtyFirst = 0;
+    m_VBDirtyEnd = 0;
+    m_RayBVH = nullptr;
+    m_VertexFaces = nullptr;
+    m_GeometryStamp = NextGeometryStamp();
+    m_WideIndicesEnabled = FALSE;
+    m_WideIndices = FALSE;
 }
 
 // Destructor
@@ -286,6 +422,8 @@ RCKMesh::~RCKMesh() {
             delete[] channel.m_UVs;
             channel.m_UVs = nullptr;
         }
+        delete channel.m_FaceIndices32;
+        channel.m_FaceIndices32 = nullptr;
     }
 
     // Delete render groups
@@ -300,6 +438,11 @@ RCKMesh::~RCKMesh() {
         m_VertexWeights = nullptr;
     }
 
+    delete m_RayBVH;
+    m_RayBVH = nullptr;
+    delete m_VertexFaces;
+    m_VertexFaces = nullptr;
+
     // Release vertex buffer
     if (m_VertexBuffer) {
         RCKRenderManager *renderManager = (RCKRenderManager *) m_Context->GetRenderManager();
@@ -413,6 +556,8 @@ VXTEXTURE_WRAPMODE RCKMesh::GetWrapMode() {
 // Lighting mode methods
 void RCKMesh::SetLitMode(VXMESH_LITMODE Mode) {
     // Match IDA at 0x1001ce04
+    // The vertex normals are only kept up to date in lit mode
+    m_GeometryStamp = NextGeometryStamp();
     if (Mode) {
         m_Flags &= ~VXMESH_PRELITMODE;
     } else {
@@ -509,15 +654,23 @@ void *RCKMesh::GetTextureCoordinatesPtr(CKDWORD *Stride, int channel) {
 // Vertex manipulation notifications
 void RCKMesh::VertexMove() {
     // Match IDA at 0x1001e115
+    VerticesMoved(0, m_Vertices.Size());
+}
+
+void RCKMesh::VerticesMoved(int first, int end) {
     m_Flags &= ~VXMESH_BOUNDINGUPTODATE;
     m_Flags |= VXMESH_POS_CHANGED;
     m_Valid = FALSE;
+    InvalidateRayBVH();
+    m_GeometryStamp = NextGeometryStamp();
+    MarkHWVertexBufferDirty(CK_MESHVB_POSITIONS, first, end);
 }
 
 void RCKMesh::UVChanged() {
     // Match IDA at 0x1001e14e
     m_Flags |= VXMESH_UV_CHANGED;
     m_Valid = FALSE;
+    MarkHWVertexBufferDirty(CK_MESHVB_UVS, 0, m_Vertices.Size());
 }
 
 void RCKMesh::NormalChanged() {
@@ -525,12 +678,30 @@ void RCKMesh::NormalChanged() {
     m_Flags |= VXMESH_NORMAL_CHANGED;
     m_Flags &= ~VXMESH_NORMAL_CHANGED;
     m_Valid = FALSE;
+    m_GeometryStamp = NextGeometryStamp();
+    MarkHWVertexBufferDirty(CK_MESHVB_NORMALS, 0, m_Vertices.Size());
 }
 
 void RCKMesh::ColorChanged() {
     // Match IDA at 0x1001e1ae
     m_Flags |= VXMESH_COLOR_CHANGED;
     m_Valid = FALSE;
+    MarkHWVertexBufferDirty(CK_MESHVB_COLORS, 0, m_Vertices.Size());
+}
+
+void RCKMesh::MarkHWVertexBufferDirty(CKDWORD attributes, int first, int end) {
+    if (first >= end)
+        return;
+    if (m_VBDirtyAttributes == 0) {
+        m_VBDirtyFirst = first;
+        m_VBDirtyEnd = end;
+    } else {
+        if (first < m_VBDirtyFirst)
+            m_VBDirtyFirst = first;
+        if (end > m_VBDirtyEnd)
+            m_VBDirtyEnd = end;
+    }
+    m_VBDirtyAttributes |= attributes;
 }
 
 // Normal building methods
@@ -541,6 +712,12 @@ void RCKMesh::BuildNormals() {
 
     m_Flags |= VXMESH_NORMAL_CHANGED | VXMESH_GENNORMALS;
 
+    if (m_WideIndices) {
+        BuildNormals32GenericFunc(m_Faces.Begin(), m_FaceVertexIndices32.Begin(), m_Faces.Size(),
+                                  m_Vertices.Begin(), m_Vertices.Size());
+        return;
+    }
+
     // Call the VxMath normal building function
     g_BuildNormalsFunc(m_Faces.Begin(),
                        m_FaceVertexIndices.Begin(),
@@ -554,6 +731,12 @@ void RCKMesh::BuildFaceNormals() {
     if (m_Faces.Size() == 0) return;
     if (m_Vertices.Size() == 0) return;
 
+    if (m_WideIndices) {
+        BuildFaceNormals32GenericFunc(m_Faces.Begin(), m_FaceVertexIndices32.Begin(), m_Faces.Size(),
+                                      m_Vertices.Begin(), m_Vertices.Size());
+        return;
+    }
+
     // Call the VxMath face normal building function
     g_BuildFaceNormalsFunc(m_Faces.Begin(),
                            m_FaceVertexIndices.Begin(),
@@ -625,6 +808,9 @@ CKBOOL RCKMesh::SetVertexCount(int Count) {
     }
 
     m_Flags &= ~VXMESH_BOUNDINGUPTODATE;
+    InvalidateRayBVH();
+    InvalidateVertexFaces();
+    UpdateIndexFormat();
     return TRUE;
 }
 
@@ -722,12 +908,18 @@ CKBOOL RCKMesh::SetFaceCount(int Count) {
     int oldCount = m_Faces.Size();
 
     m_Faces.Resize(Count);
-    m_FaceVertexIndices.Resize(Count * 3);
+    if (m_WideIndices)
+        m_FaceVertexIndices32.Resize(Count * 3);
+    else
+        m_FaceVertexIndices.Resize(Count * 3);
 
     // Initialize new faces
     if (oldCount < Count) {
         // Clear new face vertex indices
-        memset(&m_FaceVertexIndices[oldCount * 3], 0, sizeof(CKWORD) * 3 * (Count - oldCount));
+        if (m_WideIndices)
+            memset(&m_FaceVertexIndices32[oldCount * 3], 0, sizeof(CKDWORD) * 3 * (Count - oldCount));
+        else
+            memset(&m_FaceVertexIndices[oldCount * 3], 0, sizeof(CKWORD) * 3 * (Count - oldCount));
 
         // Set channel mask to all channels
         m_FaceChannelMask = 0xFFFF;
@@ -751,9 +943,9 @@ int RCKMesh::GetFaceCount() {
 void RCKMesh::SetFaceVertexIndex(int FaceIndex, int Vertex1, int Vertex2, int Vertex3) {
     // Match IDA at 0x1001c70d
     if (FaceIndex >= 0 && FaceIndex < m_Faces.Size()) {
-        m_FaceVertexIndices[FaceIndex * 3] = Vertex1;
-        m_FaceVertexIndices[FaceIndex * 3 + 1] = Vertex2;
-        m_FaceVertexIndices[FaceIndex * 3 + 2] = Vertex3;
+        SetFaceIndexValue(FaceIndex * 3, Vertex1);
+        SetFaceIndexValue(FaceIndex * 3 + 1, Vertex2);
+        SetFaceIndexValue(FaceIndex * 3 + 2, Vertex3);
         UnOptimize();
     }
 }
@@ -761,9 +953,9 @@ void RCKMesh::SetFaceVertexIndex(int FaceIndex, int Vertex1, int Vertex2, int Ve
 void RCKMesh::GetFaceVertexIndex(int FaceIndex, int &Vertex1, int &Vertex2, int &Vertex3) {
     // Match IDA at 0x1001c7f0
     if (FaceIndex >= 0 && FaceIndex < m_Faces.Size()) {
-        Vertex1 = m_FaceVertexIndices[FaceIndex * 3];
-        Vertex2 = m_FaceVertexIndices[FaceIndex * 3 + 1];
-        Vertex3 = m_FaceVertexIndices[FaceIndex * 3 + 2];
+        Vertex1 = GetFaceIndexValue(FaceIndex * 3);
+        Vertex2 = GetFaceIndexValue(FaceIndex * 3 + 1);
+        Vertex3 = GetFaceIndexValue(FaceIndex * 3 + 2);
     }
 }
 
@@ -787,7 +979,11 @@ CKMaterial *RCKMesh::GetFaceMaterial(int Index) {
 
 // Face indices access
 CKWORD *RCKMesh::GetFacesIndices() {
-    return m_FaceVertexIndices.Begin();
+    return m_WideIndices ? nullptr : m_FaceVertexIndices.Begin();
+}
+
+CKDWORD *RCKMesh::GetFacesIndices32() {
+    return m_WideIndices ? m_FaceVertexIndices32.Begin() : nullptr;
 }
 
 // Geometry calculations
@@ -818,29 +1014,41 @@ void RCKMesh::GetBaryCenter(VxVector *Vector) {
 // Line operations
 // Match IDA at 0x1001e2cd
 CKBOOL RCKMesh::SetLineCount(int Count) {
-    m_LineIndices.Resize(2 * Count);
+    if (m_WideIndices)
+        m_LineIndices32.Resize(2 * Count);
+    else
+        m_LineIndices.Resize(2 * Count);
     return TRUE;
 }
 
 // Match IDA at 0x1001e2f3
 int RCKMesh::GetLineCount() {
-    return m_LineIndices.Size() >> 1;
+    return (m_WideIndices ? m_LineIndices32.Size() : m_LineIndices.Size()) >> 1;
 }
 
 // Match IDA at 0x1001e30e
 void RCKMesh::SetLine(int LineIndex, int VIndex1, int VIndex2) {
+    if (m_WideIndices) {
+        m_LineIndices32[2 * LineIndex] = VIndex1;
+        m_LineIndices32[2 * LineIndex + 1] = VIndex2;
+        return;
+    }
     m_LineIndices[2 * LineIndex] = VIndex1;
     m_LineIndices[2 * LineIndex + 1] = VIndex2;
 }
 
 // Match IDA at 0x1001e353
 void RCKMesh::GetLine(int LineIndex, int *VIndex1, int *VIndex2) {
-    *VIndex1 = m_LineIndices[2 * LineIndex];
-    *VIndex2 = m_LineIndices[2 * LineIndex + 1];
+    *VIndex1 = GetLineIndexValue(2 * LineIndex);
+    *VIndex2 = GetLineIndexValue(2 * LineIndex + 1);
 }
 
 CKWORD *RCKMesh::GetLineIndices() {
-    return m_LineIndices.Begin();
+    return m_WideIndices ? nullptr : m_LineIndices.Begin();
+}
+
+CKDWORD *RCKMesh::GetLineIndices32() {
+    return m_WideIndices ? m_LineIndices32.Begin() : nullptr;
 }
 
 // Vertex weight system
@@ -896,6 +1104,10 @@ void RCKMesh::Clean(CKBOOL KeepVertices) {
     m_Faces.Clear();
     m_FaceVertexIndices.Clear();
     m_LineIndices.Clear();
+    m_FaceVertexIndices32.Clear();
+    m_LineIndices32.Clear();
+    InvalidateRayBVH();
+    InvalidateVertexFaces();
 
     DeleteRenderGroup();
 
@@ -906,6 +1118,8 @@ void RCKMesh::Clean(CKBOOL KeepVertices) {
             delete[] channel.m_UVs;
             channel.m_UVs = nullptr;
         }
+        delete channel.m_FaceIndices32;
+        channel.m_FaceIndices32 = nullptr;
     }
     m_MaterialChannels.Clear();
 
@@ -917,6 +1131,7 @@ void RCKMesh::Clean(CKBOOL KeepVertices) {
             delete m_VertexWeights;
             m_VertexWeights = nullptr;
         }
+        UpdateIndexFormat();
     }
 }
 
@@ -926,9 +1141,9 @@ void RCKMesh::InverseWinding() {
     int secondVertexOffset = 1; // Start at index 1 (second vertex of first face)
     for (int i = 0; i < faceCount; ++i) {
         // Swap vertices at indices secondVertexOffset and secondVertexOffset+1 (i.e., indices 1&2, 4&5, 7&8, ...)
-        CKWORD temp = m_FaceVertexIndices[secondVertexOffset];
-        m_FaceVertexIndices[secondVertexOffset] = m_FaceVertexIndices[secondVertexOffset + 1];
-        m_FaceVertexIndices[secondVertexOffset + 1] = temp;
+        CKDWORD temp = GetFaceIndexValue(secondVertexOffset);
+        SetFaceIndexValue(secondVertexOffset, GetFaceIndexValue(secondVertexOffset + 1));
+        SetFaceIndexValue(secondVertexOffset + 1, temp);
         secondVertexOffset += 3;
     }
     UnOptimize();
@@ -957,9 +1172,8 @@ void RCKMesh::Consolidate() {
             if (i != newFaceCount) {
                 // Swap with last valid face
                 m_Faces[i] = m_Faces[newFaceCount];
-                m_FaceVertexIndices[i * 3] = m_FaceVertexIndices[newFaceCount * 3];
-                m_FaceVertexIndices[i * 3 + 1] = m_FaceVertexIndices[newFaceCount * 3 + 1];
-                m_FaceVertexIndices[i * 3 + 2] = m_FaceVertexIndices[newFaceCount * 3 + 2];
+                for (int k = 0; k < 3; ++k)
+                    SetFaceIndexValue(i * 3 + k, GetFaceIndexValue(newFaceCount * 3 + k));
             }
         } else {
             ++i;
@@ -979,8 +1193,9 @@ void RCKMesh::Consolidate() {
     }
 
     // Mark vertices used by faces
-    for (i = 0; i < m_FaceVertexIndices.Size(); ++i) {
-        vertexMap[m_FaceVertexIndices[i]] = 666666; // Mark as used
+    const int indexCount = m_Faces.Size() * 3;
+    for (i = 0; i < indexCount; ++i) {
+        vertexMap[GetFaceIndexValue(i)] = 666666; // Mark as used
     }
 
     // Compact vertices
@@ -1015,9 +1230,10 @@ void RCKMesh::Consolidate() {
         m_Vertices.Resize(newVertexCount);
         m_VertexColors.Resize(newVertexCount);
 
-        for (i = 0; i < m_FaceVertexIndices.Size(); ++i) {
-            m_FaceVertexIndices[i] = vertexMap[m_FaceVertexIndices[i]];
+        for (i = 0; i < indexCount; ++i) {
+            SetFaceIndexValue(i, vertexMap[GetFaceIndexValue(i)]);
         }
+        UpdateIndexFormat();
     }
 
     // Update skins if vertices were removed (IDA lines 126-140)
@@ -1042,6 +1258,69 @@ void RCKMesh::Consolidate() {
 void RCKMesh::UnOptimize() {
     // Match IDA at 0x1002a980
     m_Flags &= ~(VXMESH_OPTIMIZED | VXMESH_TRANSPARENCYUPTODATE);
+    InvalidateRayBVH();
+    InvalidateVertexFaces();
+}
+
+void RCKMesh::InvalidateRayBVH() {
+    if (m_RayBVH)
+        m_RayBVH->Invalidate();
+}
+
+void RCKMesh::InvalidateVertexFaces() {
+    if (m_VertexFaces)
+        m_VertexFaces->Invalidate();
+    m_GeometryStamp = NextGeometryStamp();
+}
+
+void RCKMesh::EnableWideIndices(CKBOOL enable) {
+    m_WideIndicesEnabled = enable;
+    UpdateIndexFormat();
+}
+
+void RCKMesh::UpdateIndexFormat() {
+    // 16-bit indices address up to 0x10000 vertices
+    const CKBOOL wide = m_WideIndicesEnabled && m_Vertices.Size() > 0x10000;
+    if (wide == m_WideIndices)
+        return;
+
+    if (wide) {
+        // Progressive mesh data only stores 16-bit vertex indices
+        DestroyPM();
+
+        m_FaceVertexIndices32.Resize(m_FaceVertexIndices.Size());
+        for (int i = 0; i < m_FaceVertexIndices.Size(); ++i)
+            m_FaceVertexIndices32[i] = m_FaceVertexIndices[i];
+        m_LineIndices32.Resize(m_LineIndices.Size());
+        for (int i = 0; i < m_LineIndices.Size(); ++i)
+            m_LineIndices32[i] = m_LineIndices[i];
+
+        XArray<CKWORD> noFaces, noLines;
+        m_FaceVertexIndices.Swap(noFaces);
+        m_LineIndices.Swap(noLines);
+    } else {
+        m_FaceVertexIndices.Resize(m_FaceVertexIndices32.Size());
+        for (int i = 0; i < m_FaceVertexIndices32.Size(); ++i)
+            m_FaceVertexIndices[i] = (CKWORD) m_FaceVertexIndices32[i];
+        m_LineIndices.Resize(m_LineIndices32.Size());
+        for (int i = 0; i < m_LineIndices32.Size(); ++i)
+            m_LineIndices[i] = (CKWORD) m_LineIndices32[i];
+
+        XArray<CKDWORD> noFaces, noLines;
+        m_FaceVertexIndices32.Swap(noFaces);
+        m_LineIndices32.Swap(noLines);
+    }
+    m_WideIndices = wide;
+
+    // Channel index lists are rebuilt in the new format by CreateRenderGroups
+    for (int c = 0; c < m_MaterialChannels.Size(); ++c) {
+        VxMaterialChannel &channel = m_MaterialChannels[c];
+        delete channel.m_FaceIndices;
+        channel.m_FaceIndices = nullptr;
+        delete channel.m_FaceIndices32;
+        channel.m_FaceIndices32 = nullptr;
+    }
+    UnOptimize();
 }
 
 // Callback system methods
@@ -1360,9 +1639,25 @@ CKStateChunk *RCKMesh::Save(CKFile *file, CKDWORD flags) {
             }
         }
 
+        // The opt-in to 32-bit indices, also saved while the vertex count fits in 16 bits
+        if (m_WideIndicesEnabled) {
+            chunk->WriteIdentifier(CK_STATESAVE_MESHWIDEINDICES);
+            chunk->WriteInt(MESH_WIDEINDICES_VERSION);
+        }
+
         // Write face data
         int faceCount = GetFaceCount();
-        if (faceCount > 0) {
+        if (faceCount > 0 && m_WideIndices) {
+            chunk->WriteIdentifier(CK_STATESAVE_MESHFACES32);
+            chunk->WriteInt(MESH_WIDEINDICES_VERSION);
+            chunk->WriteInt(faceCount);
+            for (int j = 0; j < faceCount; j++) {
+                chunk->WriteDword(m_FaceVertexIndices32[3 * j]);
+                chunk->WriteDword(m_FaceVertexIndices32[3 * j + 1]);
+                chunk->WriteDword(m_FaceVertexIndices32[3 * j + 2]);
+                chunk->WriteWord(m_Faces[j].m_MatIndex);
+            }
+        } else if (faceCount > 0) {
             chunk->WriteIdentifier(CK_STATESAVE_MESHFACES);
             chunk->WriteInt(faceCount);
             for (int j = 0; j < faceCount; j++) {
@@ -1382,7 +1677,13 @@ CKStateChunk *RCKMesh::Save(CKFile *file, CKDWORD flags) {
 
         // Write line data using bulk write
         int lineCount = GetLineCount();
-        if (lineCount > 0) {
+        if (lineCount > 0 && m_WideIndices) {
+            chunk->WriteIdentifier(CK_STATESAVE_MESHLINES32);
+            chunk->WriteInt(MESH_WIDEINDICES_VERSION);
+            chunk->WriteInt(lineCount);
+            for (int j = 0; j < 2 * lineCount; j++)
+                chunk->WriteDword(m_LineIndices32[j]);
+        } else if (lineCount > 0) {
             chunk->WriteIdentifier(CK_STATESAVE_MESHLINES);
             chunk->WriteInt(lineCount);
             // Bulk write line indices - based on IDA at 0x100275b5
@@ -1547,6 +1848,8 @@ CKERROR RCKMesh::Load(CKStateChunk *chunk, CKFile *file) {
 
     // Call base class load
     CKBeObject::Load(chunk, file);
+    InvalidateRayBVH();
+    InvalidateVertexFaces();
 
     // Clear existing channels if not loading from file
     if (!file) {
@@ -1618,6 +1921,9 @@ CKERROR RCKMesh::Load(CKStateChunk *chunk, CKFile *file) {
                 }
             }
 
+            // Set before the vertices so that the faces are read in the storage they end up in
+            EnableWideIndices(chunk->SeekIdentifier(CK_STATESAVE_MESHWIDEINDICES));
+
             // Load vertex data using optimized buffer read
             ILoadVertices(chunk, &loadFlags);
 
@@ -1629,11 +1935,11 @@ CKERROR RCKMesh::Load(CKStateChunk *chunk, CKFile *file) {
                     for (int j = 0; j < faceCount; j++) {
                         // Read packed indices
                         CKDWORD indices01 = chunk->ReadDwordAsWords();
-                        m_FaceVertexIndices[3 * j] = (CKWORD) (indices01 & 0xFFFF);
-                        m_FaceVertexIndices[3 * j + 1] = (CKWORD) (indices01 >> 16);
+                        SetFaceIndexValue(3 * j, indices01 & 0xFFFF);
+                        SetFaceIndexValue(3 * j + 1, indices01 >> 16);
 
                         CKDWORD idx2AndMat = chunk->ReadDwordAsWords();
-                        m_FaceVertexIndices[3 * j + 2] = (CKWORD) (idx2AndMat & 0xFFFF);
+                        SetFaceIndexValue(3 * j + 2, idx2AndMat & 0xFFFF);
 
                         // Map material index through group indices if available
                         int matIdx = (idx2AndMat >> 16);
@@ -1649,7 +1955,60 @@ CKERROR RCKMesh::Load(CKStateChunk *chunk, CKFile *file) {
             if (chunk->SeekIdentifier(CK_STATESAVE_MESHLINES)) {
                 int lineCount = chunk->ReadInt();
                 SetLineCount(lineCount);
-                chunk->ReadAndFillBuffer_LEndian16(m_LineIndices.Begin());
+                if (m_WideIndices) {
+                    XArray<CKWORD> lineIndices;
+                    lineIndices.Resize(2 * lineCount);
+                    chunk->ReadAndFillBuffer_LEndian16(lineIndices.Begin());
+                    for (int j = 0; j < 2 * lineCount; j++)
+                        m_LineIndices32[j] = lineIndices[j];
+                } else {
+                    chunk->ReadAndFillBuffer_LEndian16(m_LineIndices.Begin());
+                }
+            }
+
+            // Faces and lines saved with 32-bit indices (vertex count above 65536).
+            // No 16-bit copy is saved with them, so an unknown version loses them.
+            int faceVersion = MESH_WIDEINDICES_VERSION;
+            if (chunk->SeekIdentifier(CK_STATESAVE_MESHFACES32) &&
+                (faceVersion = chunk->ReadInt()) == MESH_WIDEINDICES_VERSION) {
+                EnableWideIndices(TRUE);
+                int faceCount = chunk->ReadInt();
+                SetFaceCount(faceCount);
+                for (int j = 0; j < faceCount; j++) {
+                    CKDWORD v0 = chunk->ReadDword();
+                    CKDWORD v1 = chunk->ReadDword();
+                    CKDWORD v2 = chunk->ReadDword();
+                    SetFaceIndexValue(3 * j, v0);
+                    SetFaceIndexValue(3 * j + 1, v1);
+                    SetFaceIndexValue(3 * j + 2, v2);
+                    int matIdx = chunk->ReadWord();
+                    if (groupIndices.Size() > 0 && matIdx < groupIndices.Size())
+                        m_Faces[j].m_MatIndex = groupIndices[matIdx];
+                    else
+                        m_Faces[j].m_MatIndex = matIdx;
+                }
+            }
+            int lineVersion = MESH_WIDEINDICES_VERSION;
+            if (chunk->SeekIdentifier(CK_STATESAVE_MESHLINES32) &&
+                (lineVersion = chunk->ReadInt()) == MESH_WIDEINDICES_VERSION) {
+                EnableWideIndices(TRUE);
+                int lineCount = chunk->ReadInt();
+                SetLineCount(lineCount);
+                for (int j = 0; j < 2 * lineCount; j++) {
+                    CKDWORD index = chunk->ReadDword();
+                    if (m_WideIndices)
+                        m_LineIndices32[j] = index;
+                    else
+                        m_LineIndices[j] = (CKWORD) index;
+                }
+            }
+            if (faceVersion != MESH_WIDEINDICES_VERSION || lineVersion != MESH_WIDEINDICES_VERSION) {
+                m_Context->OutputToConsoleExBeep("%s : Unknown version of 32-bit mesh indices: Cannot Load",
+                                                 GetName());
+                if (faceVersion != MESH_WIDEINDICES_VERSION)
+                    SetFaceCount(0);
+                if (lineVersion != MESH_WIDEINDICES_VERSION)
+                    SetLineCount(0);
             }
 
             // Rebuild geometry
@@ -1893,6 +2252,10 @@ int RCKMesh::GetMemoryOccupation() {
     // Faces: sizeof(CKFace) per face
     size += m_Faces.GetMemoryOccupation(FALSE);
 
+    // 32-bit index storage
+    size += m_FaceVertexIndices32.GetMemoryOccupation(FALSE);
+    size += m_LineIndices32.GetMemoryOccupation(FALSE);
+
     // Render callbacks
     if (m_RenderCallbacks) {
         // Add callback array sizes + callback container
@@ -1926,6 +2289,9 @@ int RCKMesh::GetMemoryOccupation() {
         if (m_MaterialChannels[i].m_FaceIndices) {
             size += m_MaterialChannels[i].m_FaceIndices->GetMemoryOccupation(FALSE);
         }
+        if (m_MaterialChannels[i].m_FaceIndices32) {
+            size += m_MaterialChannels[i].m_FaceIndices32->GetMemoryOccupation(FALSE);
+        }
     }
 
     // Progressive mesh
@@ -2018,6 +2384,8 @@ CKERROR RCKMesh::Copy(CKObject &o, CKDependenciesContext &context) {
         return result;
 
     RCKMesh *source = (RCKMesh *) &o;
+    InvalidateRayBVH();
+    InvalidateVertexFaces();
 
     // Copy starts from source state; clear target-only mutable runtime state first.
     while (GetChannelCount() > 0)
@@ -2035,9 +2403,12 @@ CKERROR RCKMesh::Copy(CKObject &o, CKDependenciesContext &context) {
     m_Flags &= ~VXMESH_VISIBLE;
     m_Flags |= source->m_Flags & VXMESH_VISIBLE;
 
-    // Copy vertex data using memcpy for efficiency
+    // Copy vertex data using memcpy for efficiency; the index format follows
+    // from the vertex count once the opt-in matches the source
+    m_WideIndicesEnabled = source->m_WideIndicesEnabled;
     int vertexCount = source->GetVertexCount();
     SetVertexCount(vertexCount);
+    UpdateIndexFormat();
     if (vertexCount > 0) {
         // Copy vertices (VxVertex = 32 bytes)
         if (m_Vertices.Size() > 0 && source->m_Vertices.Size() > 0) {
@@ -2085,7 +2456,10 @@ CKERROR RCKMesh::Copy(CKObject &o, CKDependenciesContext &context) {
     // Copy face data
     int faceCount = source->GetFaceCount();
     m_Faces.Resize(faceCount);
-    m_FaceVertexIndices.Resize(3 * faceCount);
+    if (m_WideIndices)
+        m_FaceVertexIndices32 = source->m_FaceVertexIndices32;
+    else
+        m_FaceVertexIndices.Resize(3 * faceCount);
     if (faceCount > 0) {
         // Copy face structures (CKFace = sizeof(CKFace) bytes per face)
         if (m_Faces.Size() > 0 && source->m_Faces.Size() > 0) {
@@ -2100,6 +2474,7 @@ CKERROR RCKMesh::Copy(CKObject &o, CKDependenciesContext &context) {
 
     // Copy line topology.
     m_LineIndices = source->m_LineIndices;
+    m_LineIndices32 = source->m_LineIndices32;
 
     // Copy channels
     int channelCount = source->GetChannelCount();
@@ -2303,13 +2678,11 @@ CKDWORD RCKMesh::GetSaveFlags() {
             vertexNormals[i] = VxVector(0, 0, 0);
         }
 
-        CKWORD *faceIndices = m_FaceVertexIndices.Begin();
         for (int f = 0; f < faceCount; ++f) {
             VxVector &faceNormal = m_Faces[f].m_Normal;
-            vertexNormals[faceIndices[0]] += faceNormal;
-            vertexNormals[faceIndices[1]] += faceNormal;
-            vertexNormals[faceIndices[2]] += faceNormal;
-            faceIndices += 3;
+            vertexNormals[GetFaceIndexValue(3 * f)] += faceNormal;
+            vertexNormals[GetFaceIndexValue(3 * f + 1)] += faceNormal;
+            vertexNormals[GetFaceIndexValue(3 * f + 2)] += faceNormal;
         }
 
         // Calculate average difference between computed and stored normals
@@ -2482,6 +2855,8 @@ void RCKMesh::DeleteRenderGroup() {
     }
     m_MaterialGroups.Clear();
     m_Valid = FALSE;
+    // The hardware vertex buffer follows the groups: it is written whole again
+    m_VertexBufferReady = 0;
 }
 
 // Match IDA at 0x1002AB90
@@ -2849,6 +3224,65 @@ void RCKMesh::ModifierVertexMove(CKBOOL RebuildNormals, CKBOOL RebuildFaceNormal
     VertexMove();
 }
 
+void RCKMesh::ModifierVerticesMoved(const int *vertices, int count, CKBOOL RebuildNormals,
+                                    CKBOOL RebuildFaceNormals) {
+    const int vertexCount = m_Vertices.Size();
+    const int faceCount = m_Faces.Size();
+    // Progressive meshes and large changes take the full rebuild
+    if (m_ProgressiveMesh || count * 4 >= vertexCount) {
+        ModifierVertexMove(RebuildNormals, RebuildFaceNormals);
+        return;
+    }
+
+    // Same choice of normals as ModifierVertexMove
+    const CKBOOL vertexNormals = GetLitMode() && RebuildNormals;
+    if ((RebuildNormals || RebuildFaceNormals) && faceCount > 0 && vertexCount > 0) {
+        if (!m_VertexFaces)
+            m_VertexFaces = new CKMeshVertexFaces();
+        if (m_WideIndices) {
+            if (!m_VertexFaces->IsUpToDate(faceCount, vertexCount))
+                m_VertexFaces->Build(m_FaceVertexIndices32.Begin(), faceCount, vertexCount);
+            m_VertexFaces->PatchNormals(vertices, count, m_Faces.Begin(), m_FaceVertexIndices32.Begin(),
+                                        m_Vertices.Begin(), vertexNormals, g_NormalizeFunc);
+        } else {
+            if (!m_VertexFaces->IsUpToDate(faceCount, vertexCount))
+                m_VertexFaces->Build(m_FaceVertexIndices.Begin(), faceCount, vertexCount);
+            // Same kernels as BuildNormals / BuildFaceNormals
+            m_VertexFaces->PatchNormals(vertices, count, m_Faces.Begin(), m_FaceVertexIndices.Begin(),
+                                        m_Vertices.Begin(), vertexNormals, g_BuildFaceNormalsFunc, g_NormalizeFunc);
+        }
+        if (vertexNormals)
+            m_Flags |= VXMESH_NORMAL_CHANGED | VXMESH_GENNORMALS;
+    }
+
+    // Vertices to write again in the hardware vertex buffer: the moved ones
+    // and, when their normals were rebuilt, the vertices of their faces
+    int first = vertexCount;
+    int end = 0;
+    for (int i = 0; i < count; ++i) {
+        const int v = vertices[i];
+        if (v < first)
+            first = v;
+        if (v + 1 > end)
+            end = v + 1;
+        if (!vertexNormals || !m_VertexFaces)
+            continue;
+        int vertexFaceCount;
+        const CKDWORD *vertexFaces = m_VertexFaces->GetFaces(v, vertexFaceCount);
+        for (int f = 0; f < vertexFaceCount; ++f) {
+            for (int k = 0; k < 3; ++k) {
+                const int index = m_WideIndices ? (int) m_FaceVertexIndices32[vertexFaces[f] * 3 + k]
+                                                : (int) m_FaceVertexIndices[vertexFaces[f] * 3 + k];
+                if (index < first)
+                    first = index;
+                if (index + 1 > end)
+                    end = index + 1;
+            }
+        }
+    }
+    VerticesMoved(first, end);
+}
+
 CKBYTE *RCKMesh::GetModifierUVs(CKDWORD *Stride, int channel) {
     // Match IDA at 0x1002a800
     return (CKBYTE *) GetTextureCoordinatesPtr(Stride, channel);
@@ -2998,7 +3432,7 @@ CKWORD RCKMesh::GetFaceChannelMask(int FaceIndex) {
 
 // Match IDA at 0x1001c7b7 - no bounds checking in original
 VxVector &RCKMesh::GetFaceVertex(int FaceIndex, int VIndex) {
-    int vertexIndex = m_FaceVertexIndices[FaceIndex * 3 + VIndex];
+    int vertexIndex = GetFaceIndexValue(FaceIndex * 3 + VIndex);
     return m_Vertices[vertexIndex].m_Position;
 }
 
@@ -3087,8 +3521,13 @@ void RCKMesh::DissociateAllFaces() {
     tempVertices = m_Vertices;
     tempColors = m_VertexColors;
 
-    // Get total number of face vertex indices (faces * 3)
-    int indexCount = m_FaceVertexIndices.Size();
+    // Get total number of face vertex indices (faces * 3); keep the old ones
+    // since the vertex count change may switch the index format
+    int indexCount = m_Faces.Size() * 3;
+    XArray<CKDWORD> oldIndices;
+    oldIndices.Resize(indexCount);
+    for (int i = 0; i < indexCount; ++i)
+        oldIndices[i] = GetFaceIndexValue(i);
 
     // Resize vertex array to hold one vertex per face index
     SetVertexCount(indexCount);
@@ -3098,7 +3537,7 @@ void RCKMesh::DissociateAllFaces() {
         XArray<float> tempWeights;
         tempWeights.Resize(indexCount);
         for (int i = 0; i < indexCount; ++i) {
-            CKWORD oldIndex = m_FaceVertexIndices[i];
+            CKDWORD oldIndex = oldIndices[i];
             tempWeights[i] = (*m_VertexWeights)[oldIndex];
         }
         *m_VertexWeights = tempWeights;
@@ -3106,11 +3545,11 @@ void RCKMesh::DissociateAllFaces() {
 
     // Copy vertex and color data from original locations to new sequential locations
     for (int j = 0; j < indexCount; ++j) {
-        CKWORD oldIndex = m_FaceVertexIndices[j];
+        CKDWORD oldIndex = oldIndices[j];
         m_Vertices[j] = tempVertices[oldIndex];
         m_VertexColors[j] = tempColors[oldIndex];
         // Set each index to its sequential value
-        m_FaceVertexIndices[j] = (CKWORD) j;
+        SetFaceIndexValue(j, j);
     }
 
     UnOptimize();
@@ -3328,6 +3767,8 @@ float *RCKMesh::GetVertexWeightsPtr() {
 void RCKMesh::LoadVertices(CKStateChunk *chunk) {
     CKDWORD loadFlags = 0;
     const int result = ILoadVertices(chunk, &loadFlags);
+    InvalidateRayBVH();
+    InvalidateVertexFaces();
     if (result)
         Load(chunk, nullptr);
 }
@@ -3588,6 +4029,10 @@ CKERROR RCKMesh::CreatePM() {
     // Match IDA at 0x100247df: Consolidate geometry first
     Consolidate();
 
+    // Progressive mesh data only stores 16-bit vertex indices
+    if (m_WideIndices)
+        return CKERR_INVALIDOPERATION;
+
     int vertexCount = GetVertexCount();
     int faceCount = GetFaceCount();
 
@@ -3841,6 +4286,7 @@ CKERROR RCKMesh::CreatePM() {
                 delete[] key->NormArray;
                 key->NormArray = newNorm;
             }
+            ((RCKMorphController *) mc)->KeysChanged();
         }
     }
 
@@ -3950,7 +4396,9 @@ int RCKMesh::DefaultRender(RCKRenderContext *rc, RCK3dEntity *ent) {
             rstContext->SetRenderState(VXRENDERSTATE_SRCBLEND, VXBLEND_ZERO);
             rstContext->SetRenderState(VXRENDERSTATE_DESTBLEND, VXBLEND_ONE);
 
-            if (m_FaceVertexIndices.Size() > 0)
+            if (m_WideIndices)
+                DrawWidePrimitive(rstContext, VX_TRIANGLELIST, m_FaceVertexIndices32.Begin(), m_FaceVertexIndices32.Size(), vertexCount, &dpData);
+            else if (m_FaceVertexIndices.Size() > 0)
                 rstContext->DrawPrimitive(VX_TRIANGLELIST, m_FaceVertexIndices.Begin(), m_FaceVertexIndices.Size(), &dpData);
         } else if (stencilOnly) {
             // Stencil only rendering mode
@@ -3967,7 +4415,9 @@ int RCKMesh::DefaultRender(RCKRenderContext *rc, RCK3dEntity *ent) {
             rstContext->SetRenderState(VXRENDERSTATE_SRCBLEND, VXBLEND_ZERO);
             rstContext->SetRenderState(VXRENDERSTATE_DESTBLEND, VXBLEND_ONE);
 
-            if (m_FaceVertexIndices.Size() > 0)
+            if (m_WideIndices)
+                DrawWidePrimitive(rstContext, VX_TRIANGLELIST, m_FaceVertexIndices32.Begin(), m_FaceVertexIndices32.Size(), vertexCount, &dpData);
+            else if (m_FaceVertexIndices.Size() > 0)
                 rstContext->DrawPrimitive(VX_TRIANGLELIST, m_FaceVertexIndices.Begin(), m_FaceVertexIndices.Size(), &dpData);
 
             // Match original: stencil-only disables channel passes.
@@ -4006,7 +4456,7 @@ int RCKMesh::DefaultRender(RCKRenderContext *rc, RCK3dEntity *ent) {
                     }
 
                     if (!hasAlphaMaterial) {
-                        if (channel.m_FaceIndices || zbufOnly || IsTransparent() || !channel.m_Material->GetTexture(0)) {
+                        if (channel.m_FaceIndices || channel.m_FaceIndices32 || zbufOnly || IsTransparent() || !channel.m_Material->GetTexture(0)) {
                             needsMultiPass = TRUE;
                             lastMultiPass = &channel;
                             usedStages = maxAdditionalStages;
@@ -4080,7 +4530,12 @@ int RCKMesh::DefaultRender(RCKRenderContext *rc, RCK3dEntity *ent) {
             VxDrawPrimitiveData *dp = &dpData;
             m_Valid++;
             const CKDWORD vbCaps = CKRST_SPECIFICCAPS_CANDOVERTEXBUFFER | CKRST_SPECIFICCAPS_HARDWARETL;
-            if (m_Valid > 3 && (rstContext->m_Driver->m_3DCaps.CKRasterizerSpecificCaps & vbCaps) == vbCaps) {
+            CKDWORD vbVertexSize;
+            const CKDWORD vbFormat = CKRSTGetVertexFormat((CKRST_DPFLAGS) dpData.Flags, vbVertexSize);
+            // A buffer missing a few changed vertices keeps being used, the
+            // others wait for the mesh to stop changing to be written whole
+            if ((m_Valid > 3 || IsHWVertexBufferPatchable(vbFormat)) &&
+                (rstContext->m_Driver->m_3DCaps.CKRasterizerSpecificCaps & vbCaps) == vbCaps) {
                 if (CheckHWVertexBuffer(rstContext, dp)) {
                     dp = nullptr; // Use HW vertex buffer instead
                     m_VertexBufferReady = 1;
@@ -4145,7 +4600,9 @@ int RCKMesh::DefaultRender(RCKRenderContext *rc, RCK3dEntity *ent) {
 
                 VxDrawPrimitiveData wfDp = dpData;
                 wfDp.Flags = m_DrawFlags | CKRST_DP_TRANSFORM;
-                if (m_FaceVertexIndices.Size() > 0)
+                if (m_WideIndices)
+                    DrawWidePrimitive(rstContext, VX_TRIANGLELIST, m_FaceVertexIndices32.Begin(), m_FaceVertexIndices32.Size(), vertexCount, &wfDp);
+                else if (m_FaceVertexIndices.Size() > 0)
                     rstContext->DrawPrimitive(VX_TRIANGLELIST, m_FaceVertexIndices.Begin(), m_FaceVertexIndices.Size(), &wfDp);
 
                 projMat[3][2] = origZ;
@@ -4185,7 +4642,9 @@ int RCKMesh::DefaultRender(RCKRenderContext *rc, RCK3dEntity *ent) {
         rstContext->SetTexture(0, 0);
 
         lineDp.Flags = (m_DrawFlags | CKRST_DP_TRANSFORM | CKRST_DP_DIFFUSE);
-        if (m_LineIndices.Size() > 0)
+        if (m_WideIndices)
+            DrawWidePrimitive(rstContext, VX_LINELIST, m_LineIndices32.Begin(), m_LineIndices32.Size(), vertexCount, &lineDp);
+        else if (m_LineIndices.Size() > 0)
             rstContext->DrawPrimitive(VX_LINELIST, m_LineIndices.Begin(), m_LineIndices.Size(), &lineDp);
 
         rc->m_Stats.NbLinesDrawn += lineCount;
@@ -4302,11 +4761,8 @@ int RCKMesh::RenderGroup(RCKRenderContext *dev, CKMaterialGroup *group, RCK3dEnt
             rstContext->SetRenderState(VXRENDERSTATE_CULLMODE, VXCULL_CW); // 2
 
             for (CKPrimitiveEntry *prim = group->m_Primitives.Begin(); prim < group->m_Primitives.End(); ++prim) {
-                if (prim->m_Indices.Size() > 0) {
-                    int indexCount = prim->m_Indices.Size();
-                    CKWORD *indices = prim->m_Indices.Begin();
-                    rstContext->DrawPrimitive(prim->m_Type, indices, indexCount, data);
-                }
+                if (prim->m_Indices.Size() > 0)
+                    DrawGroupPrimitive(rstContext, prim, data);
             }
 
             rstContext->SetRenderState(VXRENDERSTATE_CULLMODE, VXCULL_CCW);
@@ -4314,11 +4770,8 @@ int RCKMesh::RenderGroup(RCKRenderContext *dev, CKMaterialGroup *group, RCK3dEnt
 
         // Main render pass
         for (CKPrimitiveEntry *prim = group->m_Primitives.Begin(); prim < group->m_Primitives.End(); ++prim) {
-            if (prim->m_Indices.Size() > 0) {
-                int indexCount = prim->m_Indices.Size();
-                CKWORD *indices = prim->m_Indices.Begin();
-                rstContext->DrawPrimitive(prim->m_Type, indices, indexCount, data);
-            }
+            if (prim->m_Indices.Size() > 0)
+                DrawGroupPrimitive(rstContext, prim, data);
         }
     } else {
         // Hardware vertex buffer path (data == null)
@@ -4332,7 +4785,8 @@ int RCKMesh::RenderGroup(RCKRenderContext *dev, CKMaterialGroup *group, RCK3dEnt
                     int indexCount = prim->m_Indices.Size();
                     CKWORD *indices = prim->m_Indices.Begin();
                     rstContext->DrawPrimitiveVB(prim->m_Type, m_VertexBuffer,
-                                                group->m_BaseVertex, group->m_VertexCount,
+                                                group->m_BaseVertex + prim->m_VertexStart,
+                                                prim->m_VertexCount ? prim->m_VertexCount : group->m_VertexCount,
                                                 indices, indexCount);
                 }
             }
@@ -4348,17 +4802,19 @@ int RCKMesh::RenderGroup(RCKRenderContext *dev, CKMaterialGroup *group, RCK3dEnt
         for (CKPrimitiveEntry *prim = group->m_Primitives.Begin(); prim < group->m_Primitives.End(); ++prim) {
             if (prim->m_Indices.Size() > 0) {
                 int indexCount = prim->m_Indices.Size();
+                const CKDWORD startVertex = group->m_BaseVertex + prim->m_VertexStart;
+                const CKDWORD vertexCount = prim->m_VertexCount ? prim->m_VertexCount : group->m_VertexCount;
 
                 if ((int) prim->m_IndexBufferOffset >= 0) {
                     // Use hardware index buffer
                     rstContext->DrawPrimitiveVBIB(prim->m_Type, m_VertexBuffer, m_IndexBuffer,
-                                                  group->m_BaseVertex, group->m_VertexCount,
+                                                  startVertex, vertexCount,
                                                   prim->m_IndexBufferOffset, indexCount);
                 } else {
                     // Use software indices with hardware vertex buffer
                     CKWORD *indices = prim->m_Indices.Begin();
                     rstContext->DrawPrimitiveVB(prim->m_Type, m_VertexBuffer,
-                                                group->m_BaseVertex, group->m_VertexCount,
+                                                startVertex, vertexCount,
                                                 indices, indexCount);
                 }
             }
@@ -4410,6 +4866,7 @@ int RCKMesh::RenderChannels(RCKRenderContext *dev, RCK3dEntity *ent, VxDrawPrimi
         RCKMaterial *mat = (RCKMaterial *) channel.m_Material;
         CKDWORD &channelFlags = channel.m_Flags;
         XArray<CKWORD> *faceIndices = channel.m_FaceIndices;
+        XArray<CKDWORD> *faceIndices32 = channel.m_FaceIndices32;
 
         // Skip inactive or already processed channels
         if (!mat)
@@ -4421,6 +4878,8 @@ int RCKMesh::RenderChannels(RCKRenderContext *dev, RCK3dEntity *ent, VxDrawPrimi
         // Check if channel has face indices and they have data (sub_100047B0)
         if (faceIndices && faceIndices->Size() == 0)
             continue;
+        if (faceIndices32 && faceIndices32->Size() == 0)
+            continue;
 
         // Match original binary: patch blend/flags without side effects
         VXBLEND_MODE savedSourceBlend = (VXBLEND_MODE) 0;
@@ -4482,18 +4941,23 @@ int RCKMesh::RenderChannels(RCKRenderContext *dev, RCK3dEntity *ent, VxDrawPrimi
         }
 
         // Get indices to draw
-        CKWORD *indices;
-        int indexCount;
-        if (faceIndices) {
-            indices = faceIndices->Begin();
-            indexCount = faceIndices->Size();
+        if (m_WideIndices) {
+            XArray<CKDWORD> &indices32 = faceIndices32 ? *faceIndices32 : m_FaceVertexIndices32;
+            DrawWidePrimitive(rstContext, VX_TRIANGLELIST, indices32.Begin(), indices32.Size(), m_Vertices.Size(), data);
         } else {
-            indices = m_FaceVertexIndices.Begin();
-            indexCount = m_FaceVertexIndices.Size();
-        }
+            CKWORD *indices;
+            int indexCount;
+            if (faceIndices) {
+                indices = faceIndices->Begin();
+                indexCount = faceIndices->Size();
+            } else {
+                indices = m_FaceVertexIndices.Begin();
+                indexCount = m_FaceVertexIndices.Size();
+            }
 
-        // Draw the channel
-        rstContext->DrawPrimitive(VX_TRIANGLELIST, indices, indexCount, data);
+            // Draw the channel
+            rstContext->DrawPrimitive(VX_TRIANGLELIST, indices, indexCount, data);
+        }
 
         // Restore material state exactly
         mat->RestoreAfterChannelRender(savedSourceBlend, savedDestBlend, savedFlags);
@@ -4520,6 +4984,7 @@ int RCKMesh::CreateRenderGroups() {
     // Set mono-material flag initially and invalidate
     m_Flags |= VXMESH_MONOMATERIAL;
     m_Valid = 0;
+    m_VertexBufferReady = 0;
 
     // Check for valid geometry
     int vertexCount = m_Vertices.Size();
@@ -4538,165 +5003,167 @@ int RCKMesh::CreateRenderGroups() {
     CKMemoryPool pool(m_Context, vertexCount);
     CKDWORD *vertexTracker = (CKDWORD *) pool.Mem();
 
-    // Track min/max material indices
-    int maxMatIndex = 0;
-    int minMatIndex = 2048;
+    if (m_WideIndices) {
+        CreateWideRenderGroups(vertexTracker);
+    } else {
+        // Track min/max material indices
+        int maxMatIndex = 0;
+        int minMatIndex = 2048;
 
-    // Pointer to face vertex indices
-    CKWORD *faceIndices = m_FaceVertexIndices.Begin();
+        // Pointer to face vertex indices
+        CKWORD *faceIndices = m_FaceVertexIndices.Begin();
 
-    int matGroupCount = m_MaterialGroups.Size();
+        int matGroupCount = m_MaterialGroups.Size();
 
-    if (matGroupCount >= 31) {
-        // For >= 31 material groups, use XBitArray per vertex to track materials
-        // Each vertex has a bit array to track which materials it's used by
-        XClassArray<XBitArray> vertexMaterialSets;
-        vertexMaterialSets.Resize(vertexCount);
+        if (matGroupCount >= 31) {
+            // For >= 31 material groups, use XBitArray per vertex to track materials
+            // Each vertex has a bit array to track which materials it's used by
+            XClassArray<XBitArray> vertexMaterialSets;
+            vertexMaterialSets.Resize(vertexCount);
 
-        CKFace *facePtr = (CKFace *) m_Faces.Begin();
-        for (int faceIdx = 0; faceIdx < faceCount; faceIdx++) {
-            int matIdx = facePtr->m_MatIndex;
+            CKFace *facePtr = (CKFace *) m_Faces.Begin();
+            for (int faceIdx = 0; faceIdx < faceCount; faceIdx++) {
+                int matIdx = facePtr->m_MatIndex;
 
-            // Track min/max
-            if (matIdx > maxMatIndex) maxMatIndex = matIdx;
-            if (matIdx < minMatIndex) minMatIndex = matIdx;
+                // Track min/max
+                if (matIdx > maxMatIndex) maxMatIndex = matIdx;
+                if (matIdx < minMatIndex) minMatIndex = matIdx;
 
-            // Add face index to material group's face list
-            CKWORD faceWord = (CKWORD) faceIdx;
-            CKMaterialGroup *group = m_MaterialGroups[matIdx];
-            group->m_FaceIndices.PushBack(faceWord);
+                // Add face index to material group's face list
+                CKMaterialGroup *group = m_MaterialGroups[matIdx];
+                group->m_FaceIndices.PushBack((CKDWORD) faceIdx);
 
-            // For each of the 3 vertices in this face
-            for (int v = 0; v < 3; v++) {
-                CKWORD vidx = faceIndices[v];
-                XBitArray &bits = vertexMaterialSets[vidx];
-                // Check if this material was already added for this vertex
-                if (!bits.IsSet(matIdx)) {
-                    bits.Set(matIdx);
-                    // Increment vertex count for this material group
-                    group->m_VertexCount++;
+                // For each of the 3 vertices in this face
+                for (int v = 0; v < 3; v++) {
+                    CKWORD vidx = faceIndices[v];
+                    XBitArray &bits = vertexMaterialSets[vidx];
+                    // Check if this material was already added for this vertex
+                    if (!bits.IsSet(matIdx)) {
+                        bits.Set(matIdx);
+                        // Increment vertex count for this material group
+                        group->m_VertexCount++;
+                    }
                 }
-            }
 
-            facePtr++;
-            faceIndices += 3;
-        }
-    } else {
-        // For < 31 material groups, use 32-bit mask per vertex
-        memset(vertexTracker, 0, vertexCount * sizeof(CKDWORD));
+                facePtr++;
+                faceIndices += 3;
+            }
+        } else {
+            // For < 31 material groups, use 32-bit mask per vertex
+            memset(vertexTracker, 0, vertexCount * sizeof(CKDWORD));
 
-        CKFace *facePtr = (CKFace *) m_Faces.Begin();
-        for (int faceIdx = 0; faceIdx < faceCount; faceIdx++) {
-            int matIdx = facePtr->m_MatIndex;
+            CKFace *facePtr = (CKFace *) m_Faces.Begin();
+            for (int faceIdx = 0; faceIdx < faceCount; faceIdx++) {
+                int matIdx = facePtr->m_MatIndex;
 
-            // Track min/max
-            if (matIdx > maxMatIndex) maxMatIndex = matIdx;
-            if (matIdx < minMatIndex) minMatIndex = matIdx;
+                // Track min/max
+                if (matIdx > maxMatIndex) maxMatIndex = matIdx;
+                if (matIdx < minMatIndex) minMatIndex = matIdx;
 
-            // Add face index to material group's face list
-            CKWORD faceWord = (CKWORD) faceIdx;
-            CKMaterialGroup *group = m_MaterialGroups[matIdx];
-            group->m_FaceIndices.PushBack(faceWord);
+                // Add face index to material group's face list
+                CKMaterialGroup *group = m_MaterialGroups[matIdx];
+                group->m_FaceIndices.PushBack((CKDWORD) faceIdx);
 
-            // Bit mask for this material
-            CKDWORD matBit = 1 << matIdx;
+                // Bit mask for this material
+                CKDWORD matBit = 1 << matIdx;
 
-            // For each of the 3 vertices in this face
-            for (int v = 0; v < 3; v++) {
-                CKWORD vidx = faceIndices[v];
-                // Check if this material was already added for this vertex
-                if ((vertexTracker[vidx] & matBit) == 0) {
-                    vertexTracker[vidx] |= matBit;
-                    // Increment vertex count for this material group
-                    group->m_VertexCount++;
+                // For each of the 3 vertices in this face
+                for (int v = 0; v < 3; v++) {
+                    CKWORD vidx = faceIndices[v];
+                    // Check if this material was already added for this vertex
+                    if ((vertexTracker[vidx] & matBit) == 0) {
+                        vertexTracker[vidx] |= matBit;
+                        // Increment vertex count for this material group
+                        group->m_VertexCount++;
+                    }
                 }
-            }
 
-            facePtr++;
-            faceIndices += 3;
+                facePtr++;
+                faceIndices += 3;
+            }
         }
-    }
 
-    // Accumulate vertex buffer offsets
-    CKDWORD totalVertexOffset = 0;
-
-    // Check if single material (mono-material)
-    if (minMatIndex == maxMatIndex) {
-        // Single material case - copy all face indices directly
-        CKMaterialGroup *group = m_MaterialGroups[minMatIndex];
+        // Accumulate vertex buffer offsets
+        CKDWORD totalVertexOffset = 0;
 
-        // Resize index array to hold all indices
-        CKPrimitiveEntry &entry = group->m_Primitives[0];
-        entry.m_Indices.Resize(faceCount * 3);
+        // Check if single material (mono-material)
+        if (minMatIndex == maxMatIndex) {
+            // Single material case - copy all face indices directly
+            CKMaterialGroup *group = m_MaterialGroups[minMatIndex];
 
-        // Copy all indices directly
-        memcpy(entry.m_Indices.Begin(), m_FaceVertexIndices.Begin(), faceCount * 3 * sizeof(CKWORD));
-        entry.m_IndexBufferOffset = -1;
+            // Resize index array to hold all indices
+            CKPrimitiveEntry &entry = group->m_Primitives[0];
+            entry.m_Indices.Resize(faceCount * 3);
 
-        // Set vertex range for full mesh
-        group->m_MinVertexIndex = 0;
-        group->m_MaxVertexIndex = vertexCount;
-        group->m_VertexCount = vertexCount;
-        group->m_BaseVertex = 0;
-    } else {
-        // Multiple materials - clear mono-material flag
-        m_Flags &= ~VXMESH_MONOMATERIAL;
-
-        // Process each material group (build local remap + indices + VBuffer)
-        for (int matIdx = 0; matIdx < m_MaterialGroups.Size(); matIdx++) {
-            CKMaterialGroup *group = m_MaterialGroups[matIdx];
-            if (!group || group->m_VertexCount == 0 || group->m_FaceIndices.Size() == 0)
-                continue;
+            // Copy all indices directly
+            memcpy(entry.m_Indices.Begin(), m_FaceVertexIndices.Begin(), faceCount * 3 * sizeof(CKWORD));
+            entry.m_IndexBufferOffset = -1;
 
-            const int expectedLocalVertexCount = (int) group->m_VertexCount;
-
-            // Per-group remap buffer
-            CKVBuffer *vb = new CKVBuffer(expectedLocalVertexCount);
-            group->m_RemapData = reinterpret_cast<CKUINTPTR>(vb);
-            group->m_VertexCount = 0;
-
-            memset(vertexTracker, 0, vertexCount * sizeof(CKDWORD));
-
-            // Allocate indices for this group
-            group->m_Primitives.Resize(1);
-            group->m_Primitives[0].m_Type = VX_TRIANGLELIST;
-            group->m_Primitives[0].m_IndexBufferOffset = -1;
+            // Set vertex range for full mesh
+            group->m_MinVertexIndex = 0;
+            group->m_MaxVertexIndex = vertexCount;
+            group->m_VertexCount = vertexCount;
+            group->m_BaseVertex = 0;
+        } else {
+            // Multiple materials - clear mono-material flag
+            m_Flags &= ~VXMESH_MONOMATERIAL;
 
-            const int faceListCount = group->m_FaceIndices.Size();
-            // IDA reserves then push-backs indices
-            group->m_Primitives[0].m_Indices.Resize(faceListCount * 3);
-            group->m_Primitives[0].m_Indices.Resize(0);
+            // Process each material group (build local remap + indices + VBuffer)
+            for (int matIdx = 0; matIdx < m_MaterialGroups.Size(); matIdx++) {
+                CKMaterialGroup *group = m_MaterialGroups[matIdx];
+                if (!group || group->m_VertexCount == 0 || group->m_FaceIndices.Size() == 0)
+                    continue;
 
-            for (int f = 0; f < faceListCount; f++) {
-                const int faceIdx = group->m_FaceIndices[f];
-                CKWORD *srcIndices = m_FaceVertexIndices.Begin() + faceIdx * 3;
+                const int expectedLocalVertexCount = (int) group->m_VertexCount;
+
+                // Per-group remap buffer
+                CKVBuffer *vb = new CKVBuffer(expectedLocalVertexCount);
+                group->m_RemapData = reinterpret_cast<CKUINTPTR>(vb);
+                group->m_VertexCount = 0;
+
+                memset(vertexTracker, 0, vertexCount * sizeof(CKDWORD));
+
+                // Allocate indices for this group
+                group->m_Primitives.Resize(1);
+                group->m_Primitives[0].m_Type = VX_TRIANGLELIST;
+                group->m_Primitives[0].m_IndexBufferOffset = -1;
+
+                const int faceListCount = group->m_FaceIndices.Size();
+                // IDA reserves then push-backs indices
+                group->m_Primitives[0].m_Indices.Resize(faceListCount * 3);
+                group->m_Primitives[0].m_Indices.Resize(0);
+
+                for (int f = 0; f < faceListCount; f++) {
+                    const int faceIdx = group->m_FaceIndices[f];
+                    CKWORD *srcIndices = m_FaceVertexIndices.Begin() + faceIdx * 3;
+
+                    for (int v = 0; v < 3; v++) {
+                        const CKWORD globalIdx = srcIndices[v];
+                        if (vertexTracker[globalIdx] == 0) {
+                            vertexTracker[globalIdx] = group->m_VertexCount + 1;
+                            const int localIdx = (int) group->m_VertexCount;
+                            group->m_VertexCount = localIdx + 1;
+                            if (vb && localIdx < vb->m_VertexRemap.Size())
+                                vb->m_VertexRemap[localIdx] = (int) globalIdx;
+                        }
 
-                for (int v = 0; v < 3; v++) {
-                    const CKWORD globalIdx = srcIndices[v];
-                    if (vertexTracker[globalIdx] == 0) {
-                        vertexTracker[globalIdx] = group->m_VertexCount + 1;
-                        const int localIdx = (int) group->m_VertexCount;
-                        group->m_VertexCount = localIdx + 1;
-                        if (vb && localIdx < vb->m_VertexRemap.Size())
-                            vb->m_VertexRemap[localIdx] = (int) globalIdx;
+                        group->m_Primitives[0].m_Indices.PushBack((CKWORD) (vertexTracker[globalIdx] - 1));
                     }
+                }
 
-                    group->m_Primitives[0].m_Indices.PushBack((CKWORD) (vertexTracker[globalIdx] - 1));
+                // Tighten VBuffer arrays if the earlier unique-count was off
+                if (vb && (int) group->m_VertexCount != vb->m_VertexRemap.Size()) {
+                    vb->Resize((int) group->m_VertexCount);
                 }
-            }
 
-            // Tighten VBuffer arrays if the earlier unique-count was off
-            if (vb && (int) group->m_VertexCount != vb->m_VertexRemap.Size()) {
-                vb->Resize((int) group->m_VertexCount);
-            }
+                group->m_MinVertexIndex = 0;
+                group->m_MaxVertexIndex = group->m_VertexCount;
+                group->m_BaseVertex = totalVertexOffset;
+                totalVertexOffset += group->m_VertexCount;
 
-            group->m_MinVertexIndex = 0;
-            group->m_MaxVertexIndex = group->m_VertexCount;
-            group->m_BaseVertex = totalVertexOffset;
-            totalVertexOffset += group->m_VertexCount;
-
-            if (vb)
-                vb->Update(this, 1);
+                if (vb)
+                    vb->Update(this, 1);
+            }
         }
     }
 
@@ -4734,6 +5201,8 @@ int RCKMesh::CreateRenderGroups() {
             delete m_MaterialChannels[c].m_FaceIndices;
             m_MaterialChannels[c].m_FaceIndices = nullptr;
         }
+        delete m_MaterialChannels[c].m_FaceIndices32;
+        m_MaterialChannels[c].m_FaceIndices32 = nullptr;
     }
 
     // Reset face channel mask (will trigger rebuild on next render)
@@ -4811,14 +5280,39 @@ int RCKMesh::CreateRenderGroups() {
                     if (prim->m_Indices.Size() <= 0)
                         continue;
 
-                    const int localVertexCount = (int)group->m_VertexCount;
+                    const int localVertexCount = prim->m_VertexCount ? (int)prim->m_VertexCount : (int)group->m_VertexCount;
                     const int faceCount = prim->m_Indices.Size() / 3;
 
-                    // Binary: always attempts optimization when enabled.
-                    optimizer.Initialize(localVertexCount, faceCount, cacheSize);
-                    optimizer.BuildVertexFaceLists(prim->m_Indices);
-                    optimizer.ProcessFaces(prim->m_Indices);
-                    optimizer.SwapOutput(prim->m_Indices);
+                    if (rm->m_VertexCacheOptimizerType.Value == 1) {
+                        rm->m_ForsythVertexCacheOptimizer.Optimize(prim->m_Indices.Begin(), faceCount,
+                                                                   localVertexCount, cacheSize,
+                                                                   prim->m_Indices.Begin());
+                    } else {
+                        // Binary: always attempts optimization when enabled.
+                        optimizer.Initialize(localVertexCount, faceCount, cacheSize);
+                        optimizer.BuildVertexFaceLists(prim->m_Indices);
+                        optimizer.ProcessFaces(prim->m_Indices);
+                        optimizer.SwapOutput(prim->m_Indices);
+                    }
+
+                    // Draw the outer surfaces of opaque groups first, within
+                    // OverdrawThreshold percent of the cache misses
+                    if (rm->m_OverdrawThreshold.Value > 0 &&
+                        !(group->m_Material && group->m_Material->IsAlphaTransparent())) {
+                        const VxVertex *vertices = m_Vertices.Begin();
+                        if (group->m_RemapData) {
+                            CKVBuffer *vb = GetVBuffer(group);
+                            if ((int) prim->m_VertexStart + localVertexCount > vb->m_Vertices.Size())
+                                continue;
+                            vertices = vb->m_Vertices.Begin() + prim->m_VertexStart;
+                        } else if (localVertexCount > m_Vertices.Size()) {
+                            continue;
+                        }
+                        rm->m_OverdrawOptimizer.Optimize(prim->m_Indices.Begin(), faceCount, &vertices->m_Position,
+                                                         sizeof(VxVertex), localVertexCount, cacheSize,
+                                                         (float) rm->m_OverdrawThreshold.Value / 100.0f,
+                                                         prim->m_Indices.Begin());
+                    }
                 }
             }
         }
@@ -4829,6 +5323,80 @@ int RCKMesh::CreateRenderGroups() {
     return 1;
 }
 
+void RCKMesh::CreateWideRenderGroups(CKDWORD *vertexTracker) {
+    // Every group goes through a remap buffer. Its faces are cut in batches
+    // referencing at most 0x10000 vertices, each batch being a primitive entry
+    // with 16-bit indices relative to its m_VertexStart.
+    m_Flags &= ~VXMESH_MONOMATERIAL;
+
+    const int vertexCount = m_Vertices.Size();
+    const int faceCount = m_Faces.Size();
+    const CKDWORD *faceIndices = m_FaceVertexIndices32.Begin();
+
+    for (int f = 0; f < faceCount; f++)
+        m_MaterialGroups[m_Faces[f].m_MatIndex]->m_FaceIndices.PushBack((CKDWORD) f);
+
+    // The tracker holds the position + 1 of each vertex in the concatenated
+    // group vertices: values below the current batch start are stale, so it
+    // never needs to be cleared between groups or batches
+    memset(vertexTracker, 0, vertexCount * sizeof(CKDWORD));
+    CKDWORD totalVertexOffset = 0;
+
+    for (int matIdx = 0; matIdx < m_MaterialGroups.Size(); matIdx++) {
+        CKMaterialGroup *group = m_MaterialGroups[matIdx];
+        if (!group || group->m_FaceIndices.Size() == 0)
+            continue;
+
+        CKVBuffer *vb = new CKVBuffer();
+        group->m_RemapData = reinterpret_cast<CKUINTPTR>(vb);
+        group->m_VertexCount = 0;
+        group->m_Primitives.Resize(1);
+
+        CKPrimitiveEntry *prim = &group->m_Primitives[0];
+        prim->m_Indices.Resize(0);
+        CKDWORD batchStart = 0;
+
+        for (int f = 0; f < group->m_FaceIndices.Size(); f++) {
+            const CKDWORD *src = faceIndices + group->m_FaceIndices[f] * 3;
+
+            int newVertices = 0;
+            for (int v = 0; v < 3; v++) {
+                if (vertexTracker[src[v]] <= totalVertexOffset + batchStart)
+                    ++newVertices;
+            }
+            if (group->m_VertexCount - batchStart + newVertices > 0x10000) {
+                // Close the batch; its face vertices will be duplicated in the next one
+                prim->m_VertexStart = batchStart;
+                prim->m_VertexCount = group->m_VertexCount - batchStart;
+                batchStart = group->m_VertexCount;
+                CKPrimitiveEntry entry;
+                group->m_Primitives.PushBack(entry);
+                prim = &group->m_Primitives[group->m_Primitives.Size() - 1];
+            }
+
+            for (int v = 0; v < 3; v++) {
+                const CKDWORD globalIdx = src[v];
+                if (vertexTracker[globalIdx] <= totalVertexOffset + batchStart) {
+                    vb->m_VertexRemap.PushBack((int) globalIdx);
+                    ++group->m_VertexCount;
+                    vertexTracker[globalIdx] = totalVertexOffset + group->m_VertexCount;
+                }
+                prim->m_Indices.PushBack((CKWORD) (vertexTracker[globalIdx] - 1 - totalVertexOffset - batchStart));
+            }
+        }
+        prim->m_VertexStart = batchStart;
+        prim->m_VertexCount = group->m_VertexCount - batchStart;
+
+        vb->Resize((int) group->m_VertexCount);
+        group->m_MinVertexIndex = 0;
+        group->m_MaxVertexIndex = group->m_VertexCount;
+        group->m_BaseVertex = totalVertexOffset;
+        totalVertexOffset += group->m_VertexCount;
+
+        vb->Update(this, 1);
+    }
+}
+
 //--------------------------------------------
 // UpdateChannelIndices - Update channel face indices
 // Builds per-channel index lists for faces that use each material channel
@@ -4855,6 +5423,25 @@ void RCKMesh::UpdateChannelIndices() {
                 delete channel.m_FaceIndices;
                 channel.m_FaceIndices = nullptr;
             }
+            delete channel.m_FaceIndices32;
+            channel.m_FaceIndices32 = nullptr;
+        } else if (m_WideIndices) {
+            if (!channel.m_FaceIndices32 || (channelBit & m_FaceChannelMask) != 0) {
+                if (channel.m_FaceIndices32)
+                    channel.m_FaceIndices32->Clear();
+                else
+                    channel.m_FaceIndices32 = new XArray<CKDWORD>();
+
+                const CKDWORD *faceIndices = m_FaceVertexIndices32.Begin();
+                for (int f = 0; f < m_Faces.Size(); f++) {
+                    if ((channelBit & m_Faces[f].m_ChannelMask) != 0) {
+                        channel.m_FaceIndices32->PushBack(faceIndices[0]);
+                        channel.m_FaceIndices32->PushBack(faceIndices[1]);
+                        channel.m_FaceIndices32->PushBack(faceIndices[2]);
+                    }
+                    faceIndices += 3;
+                }
+            }
         } else if (!channel.m_FaceIndices || (channelBit & m_FaceChannelMask) != 0) {
             // Need to build index list for faces that use this channel
 
@@ -4886,6 +5473,55 @@ void RCKMesh::UpdateChannelIndices() {
     m_FaceChannelMask = 0;
 }
 
+// CK_MESHVBDIRTY attributes a hardware vertex buffer of this format holds
+static CKDWORD GetVertexFormatAttributes(CKDWORD vertexFormat) {
+    CKDWORD attributes = CK_MESHVB_POSITIONS;
+    if (vertexFormat & CKRST_VF_NORMAL)
+        attributes |= CK_MESHVB_NORMALS;
+    if (vertexFormat & (CKRST_VF_DIFFUSE | CKRST_VF_SPECULAR))
+        attributes |= CK_MESHVB_COLORS;
+    if (vertexFormat & CKRST_VF_TEXMASK)
+        attributes |= CK_MESHVB_UVS;
+    return attributes;
+}
+
+// Moves the arrays of data to their vertex first
+static void OffsetDrawPrimitiveData(VxDrawPrimitiveData &data, int first) {
+    data.PositionPtr = (CKBYTE *) data.PositionPtr + first * data.PositionStride;
+    if (data.NormalPtr)
+        data.NormalPtr = (CKBYTE *) data.NormalPtr + first * data.NormalStride;
+    if (data.ColorPtr)
+        data.ColorPtr = (CKBYTE *) data.ColorPtr + first * data.ColorStride;
+    if (data.SpecularColorPtr)
+        data.SpecularColorPtr = (CKBYTE *) data.SpecularColorPtr + first * data.SpecularColorStride;
+    if (data.TexCoordPtr)
+        data.TexCoordPtr = (CKBYTE *) data.TexCoordPtr + first * data.TexCoordStride;
+    for (int t = 0; t < CKRST_MAX_STAGES - 1; ++t) {
+        if (data.TexCoordPtrs[t])
+            data.TexCoordPtrs[t] = (CKBYTE *) data.TexCoordPtrs[t] + first * data.TexCoordStrides[t];
+    }
+}
+
+//--------------------------------------------
+// IsHWVertexBufferPatchable - Whether the changes since the hardware vertex
+// buffer was written can be written alone
+//--------------------------------------------
+CKBOOL RCKMesh::IsHWVertexBufferPatchable(CKDWORD vertexFormat) {
+    if (!m_VertexBufferReady || m_ProgressiveMesh)
+        return FALSE;
+    if (!(m_VBDirtyAttributes & GetVertexFormatAttributes(vertexFormat)))
+        return TRUE;
+
+    // Remapped vertices of material groups are only written whole
+    for (int i = 0; i < m_MaterialGroups.Size(); i++) {
+        CKMaterialGroup *group = m_MaterialGroups[i];
+        if (IsRenderableMaterialGroup(group) && group->m_RemapData)
+            return FALSE;
+    }
+    // Same threshold as ModifierVerticesMoved
+    return (m_VBDirtyEnd - m_VBDirtyFirst) * 4 < m_Vertices.Size();
+}
+
 //--------------------------------------------
 // CheckHWVertexBuffer - Check and setup hardware vertex buffer
 // Returns TRUE if hardware VB was created/updated successfully
@@ -4950,10 +5586,31 @@ CKBOOL RCKMesh::CheckHWVertexBuffer(CKRasterizerContext *rst, VxDrawPrimitiveDat
         m_VertexBufferReady = 0; // Mark as needing update
     }
 
+    // Write again only the vertices changed since the buffer was written, if
+    // it holds their attributes (direct vertices come first in the buffer)
+    if (m_VertexBufferReady != 0 && (m_VBDirtyAttributes & GetVertexFormatAttributes(vertexFormat))) {
+        const int first = m_VBDirtyFirst;
+        const int end = (m_VBDirtyEnd < data->VertexCount) ? m_VBDirtyEnd : data->VertexCount;
+        if (hasRemappedVertices || !hasDirectVertices) {
+            m_VertexBufferReady = 0;
+        } else if (first < end) {
+            CKBYTE *vbData = (CKBYTE *) rst->LockVertexBuffer(m_VertexBuffer, first, end - first, CKRST_LOCK_DEFAULT);
+            if (!vbData)
+                return FALSE;
+            VxDrawPrimitiveData rangeData;
+            memcpy(&rangeData, data, sizeof(VxDrawPrimitiveData));
+            OffsetDrawPrimitiveData(rangeData, first);
+            rangeData.VertexCount = end - first;
+            CKRSTLoadVertexBuffer(vbData, vertexFormat, vertexSize, &rangeData);
+            rst->UnlockVertexBuffer(m_VertexBuffer);
+        }
+    }
+
     // If buffer is up to date, just check index buffer and return
     if (m_VertexBufferReady != 0) {
+        m_VBDirtyAttributes = 0;
         RCKRenderManager *rm = (RCKRenderManager *) m_Context->GetRenderManager();
-        if (rm->m_UseIndexBuffers.Value) {
+        if (rm && rm->m_UseIndexBuffers.Value) {
             CheckHWIndexBuffer(rst);
         }
         return TRUE;
@@ -5038,10 +5695,12 @@ CKBOOL RCKMesh::CheckHWVertexBuffer(CKRasterizerContext *rst, VxDrawPrimitiveDat
     }
 
     rst->UnlockVertexBuffer(m_VertexBuffer);
+    m_VertexBufferReady = 1;
+    m_VBDirtyAttributes = 0;
 
     // Check if we should create index buffer
     RCKRenderManager *rm = (RCKRenderManager *) m_Context->GetRenderManager();
-    if (rm->m_UseIndexBuffers.Value) {
+    if (rm && rm->m_UseIndexBuffers.Value) {
         CheckHWIndexBuffer(rst);
     }
 
@@ -5192,13 +5851,10 @@ CKBOOL RCKMesh::Pick2D(const Vx2DVector &pt, VxIntersectionDesc *desc, RCKRender
         desc->FaceIndex = 0;
     }
 
-    // Get line indices pointer
-    CKWORD *lineIndices = m_LineIndices.Begin();
-
     // Test each line
     for (int i = 0; i < lineCount; ++i) {
-        CKWORD idx0 = lineIndices[0];
-        CKWORD idx1 = lineIndices[1];
+        CKDWORD idx0 = GetLineIndexValue(2 * i);
+        CKDWORD idx1 = GetLineIndexValue(2 * i + 1);
 
         // Get screen positions of line endpoints
         float x0 = screenVertices[idx0].x;
@@ -5257,8 +5913,6 @@ CKBOOL RCKMesh::Pick2D(const Vx2DVector &pt, VxIntersectionDesc *desc, RCKRender
                 return TRUE;
             }
         }
-
-        lineIndices += 2;
     }
 
     return FALSE;
@@ -0,0 +1,349 @@
+#include "CKMeshBVH.h"
+
+#include "RCKMesh.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CKMESHBVH_SIMD_X86 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#define CKMESHBVH_TARGET_SSE2
+#else
+#define CKMESHBVH_TARGET_SSE2 __attribute__((target("sse2")))
+#endif
+#endif
+
+namespace {
+
+const int kBinCount = 16;
+const int kMaxLeafSize = 8;
+// Cost of visiting a node relative to one triangle test
+const float kTraversalCost = 1.0f;
+
+struct BuildBox {
+    VxVector Min;
+    VxVector Max;
+
+    void Reset() {
+        Min.Set(1.0e30f, 1.0e30f, 1.0e30f);
+        Max.Set(-1.0e30f, -1.0e30f, -1.0e30f);
+    }
+
+    void Grow(const VxVector &v) {
+        Min.Set(XMin(Min.x, v.x), XMin(Min.y, v.y), XMin(Min.z, v.z));
+        Max.Set(XMax(Max.x, v.x), XMax(Max.y, v.y), XMax(Max.z, v.z));
+    }
+
+    void Grow(const BuildBox &box) {
+        Grow(box.Min);
+        Grow(box.Max);
+    }
+
+    float HalfArea() const {
+        if (Max.x < Min.x)
+            return 0.0f;
+        const float dx = Max.x - Min.x;
+        const float dy = Max.y - Min.y;
+        const float dz = Max.z - Min.z;
+        return dx * dy + dy * dz + dz * dx;
+    }
+};
+
+struct BuildRange {
+    int Start;
+    int Count;
+    int Parent; // Interior node whose second child this range becomes, -1 otherwise
+};
+
+struct SplitPlane {
+    int Axis;
+    int Bin; // Faces whose centroid falls in a bin below this one go to the first child
+    float Cost;
+};
+
+inline int CentroidBin(const VxVector &centroid, int axis, float origin, float scale) {
+    const int bin = (int) ((centroid[axis] - origin) * scale);
+    return bin < 0 ? 0 : (bin >= kBinCount ? kBinCount - 1 : bin);
+}
+
+// Binned SAH over the centroid bounds. The cost is the sum of the child
+// areas weighted by their face count, without dividing by the parent area.
+SplitPlane FindSplit(const int *triangles, int count, const BuildBox *faceBoxes, const VxVector *centroids,
+                     const BuildBox &centroidBounds) {
+    SplitPlane best = {-1, 0, 1.0e30f};
+
+    for (int axis = 0; axis < 3; ++axis) {
+        const float extent = centroidBounds.Max[axis] - centroidBounds.Min[axis];
+        if (extent <= 0.0f)
+            continue;
+        const float scale = (float) kBinCount / extent;
+
+        BuildBox bins[kBinCount];
+        int binCounts[kBinCount];
+        for (int b = 0; b < kBinCount; ++b) {
+            bins[b].Reset();
+            binCounts[b] = 0;
+        }
+        for (int i = 0; i < count; ++i) {
+            const int face = triangles[i];
+            const int b = CentroidBin(centroids[face], axis, centroidBounds.Min[axis], scale);
+            bins[b].Grow(faceBoxes[face]);
+            ++binCounts[b];
+        }
+
+        // Right to left sweep for the areas above each plane
+        float rightArea[kBinCount];
+        int rightCount[kBinCount];
+        BuildBox box;
+        box.Reset();
+        int sum = 0;
+        for (int b = kBinCount - 1; b > 0; --b) {
+            box.Grow(bins[b]);
+            sum += binCounts[b];
+            rightArea[b] = box.HalfArea();
+            rightCount[b] = sum;
+        }
+
+        box.Reset();
+        sum = 0;
+        for (int b = 1; b < kBinCount; ++b) {
+            box.Grow(bins[b - 1]);
+            sum += binCounts[b - 1];
+            if (sum == 0 || rightCount[b] == 0)
+                continue;
+            const float cost = box.HalfArea() * (float) sum + rightArea[b] * (float) rightCount[b];
+            if (cost < best.Cost) {
+                best.Axis = axis;
+                best.Bin = b;
+                best.Cost = cost;
+            }
+        }
+    }
+    return best;
+}
+
+inline float InverseComponent(float d) {
+    // Keeps the slab distances finite so 0 * inf never produces a NaN
+    if (fabsf(d) > 1.0e-30f)
+        return 1.0f / d;
+    return d < 0.0f ? -1.0e30f : 1.0e30f;
+}
+
+inline CKBOOL RayHitsNode(const CKMeshBVHNode &node, const float *origin, const float *invDir, float maxDist) {
+    float tNear = 0.0f;
+    float tFar = maxDist;
+    for (int a = 0; a < 3; ++a) {
+        float t1 = (node.Min[a] - origin[a]) * invDir[a];
+        float t2 = (node.Max[a] - origin[a]) * invDir[a];
+        if (t1 > t2) {
+            const float t = t1;
+            t1 = t2;
+            t2 = t;
+        }
+        if (t1 > tNear)
+            tNear = t1;
+        if (t2 < tFar)
+            tFar = t2;
+    }
+    return tNear <= tFar;
+}
+
+void TraverseGeneric(const CKMeshBVHNode *nodes, int nodeCount, const int *triangles, const float *origin,
+                     const float *invDir, float maxDist, CKMeshBVHLeafFunc func, void *arg) {
+    int i = 0;
+    while (i < nodeCount) {
+        const CKMeshBVHNode &node = nodes[i];
+        if (RayHitsNode(node, origin, invDir, maxDist)) {
+            if (node.Count)
+                func(&triangles[node.Offset], node.Count, arg);
+            ++i;
+        } else {
+            i = node.Count ? i + 1 : node.Offset;
+        }
+    }
+}
+
+#ifdef CKMESHBVH_SIMD_X86
+// Slab test on the three axes at once. The fourth lane of the node loads is
+// Offset / Count; the origin and inverse direction are zero there so the lane
+// gives t = 0, and it is replaced by maxDist on the far side.
+CKMESHBVH_TARGET_SSE2 void TraverseSSE2(const CKMeshBVHNode *nodes, int nodeCount, const int *triangles,
+                                        const float *origin, const float *invDir, float maxDist,
+                                        CKMeshBVHLeafFunc func, void *arg) {
+    const __m128 rayOrigin = _mm_set_ps(0.0f, origin[2], origin[1], origin[0]);
+    const __m128 rayInvDir = _mm_set_ps(0.0f, invDir[2], invDir[1], invDir[0]);
+    const __m128 xyzMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    const __m128 farW = _mm_set_ps(maxDist, 0.0f, 0.0f, 0.0f);
+    const __m128 farLimit = _mm_set1_ps(maxDist);
+    const __m128 zero = _mm_setzero_ps();
+
+    int i = 0;
+    while (i < nodeCount) {
+        const CKMeshBVHNode &node = nodes[i];
+        const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.Min), rayOrigin), rayInvDir);
+        const __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.Max), rayOrigin), rayInvDir);
+
+        __m128 tNear = _mm_max_ps(_mm_min_ps(t1, t2), zero);
+        __m128 tFar = _mm_min_ps(_mm_or_ps(_mm_and_ps(_mm_max_ps(t1, t2), xyzMask), farW), farLimit);
+        tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(1, 0, 3, 2)));
+        tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(2, 3, 0, 1)));
+        tFar = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(1, 0, 3, 2)));
+        tFar = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        if (_mm_comile_ss(tNear, tFar)) {
+            if (node.Count)
+                func(&triangles[node.Offset], node.Count, arg);
+            ++i;
+        } else {
+            i = node.Count ? i + 1 : node.Offset;
+        }
+    }
+}
+#endif
+
+} // namespace
+
+CKMeshBVH::CKMeshBVH() : m_Built(FALSE), m_FaceCount(0), m_VertexCount(0) {}
+
+void CKMeshBVH::Build(const VxVertex *vertices, int vertexCount, const CKWORD *indices, int faceCount) {
+    BuildFaces(vertices, vertexCount, indices, nullptr, faceCount);
+}
+
+void CKMeshBVH::Build(const VxVertex *vertices, int vertexCount, const CKDWORD *indices, int faceCount) {
+    BuildFaces(vertices, vertexCount, nullptr, indices, faceCount);
+}
+
+void CKMeshBVH::BuildFaces(const VxVertex *vertices, int vertexCount, const CKWORD *indices16,
+                           const CKDWORD *indices32, int faceCount) {
+    m_Nodes.Resize(0);
+    m_Triangles.Resize(faceCount);
+    m_FaceCount = faceCount;
+    m_VertexCount = vertexCount;
+    m_Built = TRUE;
+    if (faceCount <= 0 || vertexCount <= 0)
+        return;
+
+    XArray<BuildBox> faceBoxes;
+    XArray<VxVector> centroids;
+    faceBoxes.Resize(faceCount);
+    centroids.Resize(faceCount);
+    for (int f = 0; f < faceCount; ++f) {
+        BuildBox &box = faceBoxes[f];
+        box.Reset();
+        for (int k = f * 3; k < f * 3 + 3; ++k)
+            box.Grow(vertices[indices32 ? indices32[k] : indices16[k]].m_Position);
+        centroids[f] = (box.Min + box.Max) * 0.5f;
+        m_Triangles[f] = f;
+    }
+
+    // Pre-order build with an explicit stack: the first child is pushed last
+    // so it is popped next and gets the index following its parent.
+    XArray<BuildRange> stack;
+    XArray<int> secondChild;
+    m_Nodes.Reserve(2 * faceCount / kMaxLeafSize + 1);
+    BuildRange root = {0, faceCount, -1};
+    stack.PushBack(root);
+
+    while (stack.Size() > 0) {
+        const BuildRange range = stack.PopBack();
+        int *triangles = &m_Triangles[range.Start];
+
+        const int index = m_Nodes.Size();
+        if (range.Parent >= 0)
+            secondChild[range.Parent] = index;
+        secondChild.PushBack(-1);
+
+        BuildBox bounds, centroidBounds;
+        bounds.Reset();
+        centroidBounds.Reset();
+        for (int i = 0; i < range.Count; ++i) {
+            bounds.Grow(faceBoxes[triangles[i]]);
+            centroidBounds.Grow(centroids[triangles[i]]);
+        }
+
+        CKMeshBVHNode node;
+        node.Min[0] = bounds.Min.x;
+        node.Min[1] = bounds.Min.y;
+        node.Min[2] = bounds.Min.z;
+        node.Max[0] = bounds.Max.x;
+        node.Max[1] = bounds.Max.y;
+        node.Max[2] = bounds.Max.z;
+        node.Offset = range.Start;
+        node.Count = range.Count;
+
+        int firstCount = 0;
+        if (range.Count > 1) {
+            const SplitPlane split = FindSplit(triangles, range.Count, faceBoxes.Begin(), centroids.Begin(),
+                                               centroidBounds);
+            const float leafCost = bounds.HalfArea() * ((float) range.Count - kTraversalCost);
+            if (split.Axis >= 0 && (split.Cost < leafCost || range.Count > kMaxLeafSize)) {
+                const float origin = centroidBounds.Min[split.Axis];
+                const float scale = (float) kBinCount / (centroidBounds.Max[split.Axis] - origin);
+                int last = range.Count - 1;
+                while (firstCount <= last) {
+                    if (CentroidBin(centroids[triangles[firstCount]], split.Axis, origin, scale) < split.Bin) {
+                        ++firstCount;
+                    } else {
+                        const int t = triangles[firstCount];
+                        triangles[firstCount] = triangles[last];
+                        triangles[last--] = t;
+                    }
+                }
+            } else if (range.Count > kMaxLeafSize) {
+                // All centroids coincide: any split is as good as another
+                firstCount = range.Count / 2;
+            }
+        }
+
+        if (firstCount > 0 && firstCount < range.Count) {
+            node.Offset = 0;
+            node.Count = 0;
+            BuildRange second = {range.Start + firstCount, range.Count - firstCount, index};
+            BuildRange first = {range.Start, firstCount, -1};
+            stack.PushBack(second);
+            stack.PushBack(first);
+        }
+        m_Nodes.PushBack(node);
+    }
+
+    // Children always follow their parent, so a backward pass can turn the
+    // second child index into the first index after the subtree.
+    for (int i = m_Nodes.Size() - 1; i >= 0; --i) {
+        CKMeshBVHNode &node = m_Nodes[i];
+        if (node.Count == 0) {
+            const CKMeshBVHNode &last = m_Nodes[secondChild[i]];
+            node.Offset = last.Count ? secondChild[i] + 1 : last.Offset;
+        }
+
+        // Pad the boxes so rounding in the slab test can not reject a face the
+        // exact triangle test would hit
+        float extent = 0.0f;
+        float magnitude = 0.0f;
+        for (int a = 0; a < 3; ++a) {
+            extent = XMax(extent, node.Max[a] - node.Min[a]);
+            magnitude = XMax(magnitude, XMax(fabsf(node.Min[a]), fabsf(node.Max[a])));
+        }
+        const float pad = extent * 1.0e-4f + magnitude * 1.0e-6f + 1.0e-6f;
+        for (int a = 0; a < 3; ++a) {
+            node.Min[a] -= pad;
+            node.Max[a] += pad;
+        }
+    }
+}
+
+void CKMeshBVH::Traverse(const VxVector &origin, const VxVector &direction, float maxDist,
+                         CKMeshBVHLeafFunc func, void *arg) const {
+    if (m_Nodes.Size() == 0)
+        return;
+
+    const float rayOrigin[3] = {origin.x, origin.y, origin.z};
+    const float invDir[3] = {InverseComponent(direction.x), InverseComponent(direction.y),
+                             InverseComponent(direction.z)};
+
+#ifdef CKMESHBVH_SIMD_X86
+    if (GetMeshSIMDLevel() >= CK_MESHSIMD_SSE2) {
+        TraverseSSE2(m_Nodes.Begin(), m_Nodes.Size(), m_Triangles.Begin(), rayOrigin, invDir, maxDist, func, arg);
+        return;
+    }
+#endif
+    TraverseGeneric(m_Nodes.Begin(), m_Nodes.Size(), m_Triangles.Begin(), rayOrigin, invDir, maxDist, func, arg);
+}
@@ -2,9 +2,11 @@
 
 #include "CKRasterizer.h"
 #include "RCKRenderContext.h"
+#include "RCKRenderManager.h"
 #include "RCK3dEntity.h"
 #include "RCKMaterial.h"
 #include "RCKTexture.h"
+#include "CKMeshBVH.h"
 
 void (*g_BuildFaceNormalsFunc)(CKFace *, CKWORD *, int, VxVertex *, int);
 void (*g_BuildNormalsFunc)(CKFace *, CKWORD *, int, VxVertex *, int);
@@ -16,14 +18,26 @@ void SetProcessorSpecific_FunctionsPtr() {
     // Set default generic implementations
     g_BuildFaceNormalsFunc = BuildFaceNormalsGenericFunc;
     g_BuildNormalsFunc = BuildNormalsGenericFunc;
-    g_RayIntersection = RayIntersectionGenericFunc;
+    g_RayIntersection = RayIntersectionBVHFunc;
     g_NormalizeFunc = NormalizeGenericFunc;
 
-    // IDA lines 6-12: Check for SSE support (bit 25 of processor features)
-    // Original code checks GetProcessorFeatures() & 0x2000000 and assigns SIMD versions
-    // For now, use generic implementations only as SIMD versions are not implemented
-    // TODO: Implement SIMD versions (BuildFaceNormalsSIMDFunc, BuildNormalsSIMDFunc, 
-    //       Mesh_RayIntersectionSIMDFunc, NormalizeSIMDFunc) if needed
+    // IDA lines 6-12: the original checked GetProcessorFeatures() & 0x2000000 (SSE).
+    // The level is read once from CPUID. Ray intersection goes through the mesh
+    // BVH, which falls back to the generic version below MeshRayBVHThreshold faces.
+    switch (GetMeshSIMDLevel()) {
+    case CK_MESHSIMD_AVX2:
+        g_BuildFaceNormalsFunc = BuildFaceNormalsAVX2Func;
+        g_BuildNormalsFunc = BuildNormalsAVX2Func;
+        g_NormalizeFunc = NormalizeAVX2Func;
+        break;
+    case CK_MESHSIMD_SSE2:
+        g_BuildFaceNormalsFunc = BuildFaceNormalsSSE2Func;
+        g_BuildNormalsFunc = BuildNormalsSSE2Func;
+        g_NormalizeFunc = NormalizeSSE2Func;
+        break;
+    default:
+        break;
+    }
 }
 
 // =====================================================
@@ -176,21 +190,157 @@ void NormalizeGenericFunc(VxVertex *vertices, int count) {
     }
 }
 
+// Same as BuildFaceNormalsGenericFunc for 32-bit indices
+void BuildFaceNormals32GenericFunc(CKFace *faces, CKDWORD *indices, int faceCount, VxVertex *vertices, int vertexCount) {
+    for (int i = 0; i < faceCount; ++i) {
+        const VxVector &v0 = vertices[indices[i * 3]].m_Position;
+        const VxVector &v1 = vertices[indices[i * 3 + 1]].m_Position;
+        const VxVector &v2 = vertices[indices[i * 3 + 2]].m_Position;
+        faces[i].m_Normal = CrossProduct(v1 - v0, v2 - v0);
+        float length = Magnitude(faces[i].m_Normal);
+        if (length > 0.0f)
+            faces[i].m_Normal *= (1.0f / length);
+    }
+}
+
+// Same as BuildNormalsGenericFunc for 32-bit indices
+void BuildNormals32GenericFunc(CKFace *faces, CKDWORD *indices, int faceCount, VxVertex *vertices, int vertexCount) {
+    BuildFaceNormals32GenericFunc(faces, indices, faceCount, vertices, vertexCount);
+
+    for (int i = 0; i < vertexCount; ++i)
+        vertices[i].m_Normal.Set(0.0f, 0.0f, 0.0f);
+
+    for (int j = 0; j < faceCount; ++j) {
+        const VxVector &faceNormal = faces[j].m_Normal;
+        vertices[indices[j * 3]].m_Normal += faceNormal;
+        vertices[indices[j * 3 + 1]].m_Normal += faceNormal;
+        vertices[indices[j * 3 + 2]].m_Normal += faceNormal;
+    }
+
+    g_NormalizeFunc(vertices, vertexCount);
+}
+
+// Fills desc for the closest hit (IDA lines 188-265 of RayIntersectionGenericFunc).
+// Returns FALSE when the precise texture pick rejects the hit.
+template <class IndexType>
+static CKBOOL FillRayIntersectionDesc(RCKMesh *mesh, const float *vertexPtr, const IndexType *indices,
+                                      VxVector &origin, VxVector &direction, VxIntersectionDesc *desc,
+                                      const VxMatrix &worldMatrix, int faceIdx, float dist, int i1, int i2) {
+    // Calculate intersection point: origin + direction * dist (IDA lines 190-191)
+    desc->IntersectionPoint = origin + direction * dist;
+
+    int indexBase = faceIdx * 3;
+
+    // Get vertex pointers (IDA lines 193-195)
+    // These point to VxVertex structures - v42/v41/v48 in IDA
+    const float *vert0 = &vertexPtr[8 * indices[indexBase]];
+    const float *vert1 = &vertexPtr[8 * indices[indexBase + 1]];
+    const float *vert2 = &vertexPtr[8 * indices[indexBase + 2]];
+
+    // Get barycentric coordinates (IDA lines 196-205)
+    float c0, c1, c2; // v46, v45, arg4a
+    VxIntersect::GetPointCoefficients(
+        desc->IntersectionPoint,
+        *(const VxVector *) vert0,
+        *(const VxVector *) vert1,
+        *(const VxVector *) vert2,
+        i1, i2, c0, c1, c2);
+
+    // Interpolate normal: vert[1] is the Normal in VxVertex (IDA lines 206-210)
+    // v42[1] = Normal, accessed as &v42[1].x which is vert0 + 3 floats
+    const VxVector &n0 = *(const VxVector *) (vert0 + 3);
+    const VxVector &n1 = *(const VxVector *) (vert1 + 3);
+    const VxVector &n2 = *(const VxVector *) (vert2 + 3);
+    desc->IntersectionNormal = c0 * n0 + c1 * n1 + c2 * n2;
+
+    // Interpolate texture coordinates (IDA lines 211-212)
+    // v42[2] = UV in VxVertex, accessed as vert0 + 6 floats
+    desc->TexU = c0 * vert0[6] + c1 * vert1[6] + c2 * vert2[6]; // UV.x
+    desc->TexV = c0 * vert0[7] + c1 * vert1[7] + c2 * vert2[7]; // UV.y
+
+    // Get material for perspective correction and alpha test (IDA lines 213-262)
+    CKMaterial *faceMat = mesh->GetFaceMaterial(faceIdx);
+    if (faceMat) {
+        // Check if perspective correction is disabled (IDA lines 216-255)
+        if (!faceMat->PerspectiveCorrectionEnabled()) {
+            CKContext *ctx = mesh->GetCKContext();
+            RCKRenderContext *dev = (RCKRenderContext *) ctx->GetPlayerRenderContext();
+            if (dev) {
+                CK3dEntity *rootEntity = dev->m_RenderedScene->GetRootEntity();
+                if (desc->Object == (CKRenderObject *) rootEntity) {
+                    // Perform perspective-correct UV interpolation
+                    VxMatrix invWorld;
+                    Vx3DMatrixIdentity(invWorld);
+                    VxMatrix combined;
+                    Vx3DMatrixIdentity(combined);
+
+                    const VxMatrix &invWorldMat = rootEntity->GetInverseWorldMatrix();
+                    Vx3DMultiplyMatrix(combined, invWorldMat, worldMatrix);
+
+                    VxMatrix projCombined;
+                    Vx3DMultiplyMatrix4(projCombined, dev->m_RasterizerContext->m_ProjectionMatrix, combined);
+
+                    // Transform points to clip space
+                    VxVector4 clipIntersect, clipV0, clipV1, clipV2;
+                    Vx3DMultiplyMatrixVector4(&clipIntersect, projCombined, &desc->IntersectionPoint);
+                    Vx3DMultiplyMatrixVector4(&clipV0, projCombined, (const VxVector *) vert0);
+                    Vx3DMultiplyMatrixVector4(&clipV1, projCombined, (const VxVector *) vert1);
+                    Vx3DMultiplyMatrixVector4(&clipV2, projCombined, (const VxVector *) vert2);
+
+                    // Perspective divide
+                    clipV0.w = 1.0f / clipV0.w;
+                    clipV1.w = 1.0f / clipV1.w;
+                    clipV2.w = 1.0f / clipV2.w;
+                    clipIntersect.w = 1.0f / clipIntersect.w;
+
+                    clipV0.x *= clipV0.w;
+                    clipV1.x *= clipV1.w;
+                    clipV2.x *= clipV2.w;
+                    clipIntersect.x *= clipIntersect.w;
+
+                    clipV0.y *= clipV0.w;
+                    clipV1.y *= clipV1.w;
+                    clipV2.y *= clipV2.w;
+                    clipIntersect.y *= clipIntersect.w;
+
+                    // Recalculate barycentric coordinates in screen space
+                    int newI1 = 0, newI2 = 1;
+                    VxIntersect::GetPointCoefficients(
+                        *(const VxVector *) &clipIntersect,
+                        *(const VxVector *) &clipV0,
+                        *(const VxVector *) &clipV1,
+                        *(const VxVector *) &clipV2,
+                        newI1, newI2, c0, c1, c2);
+
+                    // Recalculate UVs with perspective-correct interpolation
+                    desc->TexU = c0 * vert0[6] + c1 * vert1[6] + c2 * vert2[6];
+                    desc->TexV = c0 * vert0[7] + c1 * vert1[7] + c2 * vert2[7];
+                }
+            }
+        }
+
+        // Precise texture pick (alpha test) (IDA lines 256-261)
+        if (!PreciseTexturePick(faceMat, desc->TexU, desc->TexV))
+            return FALSE; // Hit was on transparent pixel
+    }
+
+    // Final output (IDA lines 263-264)
+    desc->Distance = dist;
+    desc->FaceIndex = faceIdx;
+    return TRUE;
+}
+
 // IDA @ 0x1002ea85: Mesh ray intersection (generic implementation)
-// This is a complex function with spatial partitioning optimization
-int RayIntersectionGenericFunc(RCKMesh *mesh, VxVector &origin, VxVector &direction,
-                               VxIntersectionDesc *desc, CK_RAYINTERSECTION mode,
-                               const VxMatrix &worldMatrix) {
+// This is a complex function with spatial partitioning optimization.
+// Instantiated for 16-bit and 32-bit mesh indices.
+template <class IndexType>
+static int RayIntersectionIndexed(RCKMesh *mesh, float *vertexPtr, CKFace *faces, IndexType *indices,
+                                  int faceCount, int vertexCount, VxVector &origin, VxVector &direction,
+                                  VxIntersectionDesc *desc, CK_RAYINTERSECTION mode,
+                                  const VxMatrix &worldMatrix) {
     float minDist = 1.0e35f; // v82
     CKBOOL foundHit = FALSE; // v74
-
-    // Get mesh data directly from protected members (friend access)
-    float *vertexPtr = (float *) mesh->m_Vertices.Begin(); // v78
-    CKFace *faces = mesh->m_Faces.Begin();                 // v80
-    CKWORD *indices = mesh->m_FaceVertexIndices.Begin();   // v77
-    int faceCount = mesh->m_Faces.Size();                  // v83
-    int vertexCount = mesh->m_Vertices.Size();             // v84
-    int hitCount = 0;                                      // v79
+    int hitCount = 0;        // v79
 
     if (faceCount == 0 || vertexCount == 0)
         return 0;
@@ -254,7 +404,7 @@ int RayIntersectionGenericFunc(RCKMesh *mesh, VxVector &origin, VxVector &direct
         int bestFaceIdx = -1;     // v66
 
         const VxVector *faceNormalPtr = (const VxVector *) faces; // v59 - points to face normal
-        CKWORD *indexPtr = indices;                               // v64
+        IndexType *indexPtr = indices;                            // v64
 
         // Create ray structure (IDA: sub_100301F0)
         VxRay ray;
@@ -318,113 +468,147 @@ int RayIntersectionGenericFunc(RCKMesh *mesh, VxVector &origin, VxVector &direct
 
         // Fill in intersection description (IDA lines 188-265)
         if (foundHit && desc) {
-            // Calculate intersection point: origin + direction * minDist (IDA lines 190-191)
-            desc->IntersectionPoint = origin + direction * minDist;
-
-            int faceIdx = bestFaceIdx;
-            int indexBase = faceIdx * 3;
-
-            // Get vertex pointers (IDA lines 193-195)
-            // These point to VxVertex structures - v42/v41/v48 in IDA
-            const float *vert0 = &vertexPtr[8 * indices[indexBase]];
-            const float *vert1 = &vertexPtr[8 * indices[indexBase + 1]];
-            const float *vert2 = &vertexPtr[8 * indices[indexBase + 2]];
-
-            // Get barycentric coordinates (IDA lines 196-205)
-            float c0, c1, c2; // v46, v45, arg4a
-            VxIntersect::GetPointCoefficients(
-                desc->IntersectionPoint,
-                *(const VxVector *) vert0,
-                *(const VxVector *) vert1,
-                *(const VxVector *) vert2,
-                bestI1, bestI2, c0, c1, c2);
-
-            // Interpolate normal: vert[1] is the Normal in VxVertex (IDA lines 206-210)
-            // v42[1] = Normal, accessed as &v42[1].x which is vert0 + 3 floats
-            const VxVector &n0 = *(const VxVector *) (vert0 + 3);
-            const VxVector &n1 = *(const VxVector *) (vert1 + 3);
-            const VxVector &n2 = *(const VxVector *) (vert2 + 3);
-            desc->IntersectionNormal = c0 * n0 + c1 * n1 + c2 * n2;
-
-            // Interpolate texture coordinates (IDA lines 211-212)
-            // v42[2] = UV in VxVertex, accessed as vert0 + 6 floats
-            desc->TexU = c0 * vert0[6] + c1 * vert1[6] + c2 * vert2[6]; // UV.x
-            desc->TexV = c0 * vert0[7] + c1 * vert1[7] + c2 * vert2[7]; // UV.y
-
-            // Get material for perspective correction and alpha test (IDA lines 213-262)
-            CKMaterial *faceMat = mesh->GetFaceMaterial(faceIdx);
-            if (faceMat) {
-                // Check if perspective correction is disabled (IDA lines 216-255)
-                if (!faceMat->PerspectiveCorrectionEnabled()) {
-                    CKContext *ctx = mesh->m_Context;
-                    RCKRenderContext *dev = (RCKRenderContext *) ctx->GetPlayerRenderContext();
-                    if (dev) {
-                        CK3dEntity *rootEntity = dev->m_RenderedScene->GetRootEntity();
-                        if (desc->Object == (CKRenderObject *) rootEntity) {
-                            // Perform perspective-correct UV interpolation
-                            VxMatrix invWorld;
-                            Vx3DMatrixIdentity(invWorld);
-                            VxMatrix combined;
-                            Vx3DMatrixIdentity(combined);
-
-                            const VxMatrix &invWorldMat = rootEntity->GetInverseWorldMatrix();
-                            Vx3DMultiplyMatrix(combined, invWorldMat, worldMatrix);
-
-                            VxMatrix projCombined;
-                            Vx3DMultiplyMatrix4(projCombined, dev->m_RasterizerContext->m_ProjectionMatrix, combined);
-
-                            // Transform points to clip space
-                            VxVector4 clipIntersect, clipV0, clipV1, clipV2;
-                            Vx3DMultiplyMatrixVector4(&clipIntersect, projCombined, &desc->IntersectionPoint);
-                            Vx3DMultiplyMatrixVector4(&clipV0, projCombined, (const VxVector *) vert0);
-                            Vx3DMultiplyMatrixVector4(&clipV1, projCombined, (const VxVector *) vert1);
-                            Vx3DMultiplyMatrixVector4(&clipV2, projCombined, (const VxVector *) vert2);
-
-                            // Perspective divide
-                            clipV0.w = 1.0f / clipV0.w;
-                            clipV1.w = 1.0f / clipV1.w;
-                            clipV2.w = 1.0f / clipV2.w;
-                            clipIntersect.w = 1.0f / clipIntersect.w;
-
-                            clipV0.x *= clipV0.w;
-                            clipV1.x *= clipV1.w;
-                            clipV2.x *= clipV2.w;
-                            clipIntersect.x *= clipIntersect.w;
-
-                            clipV0.y *= clipV0.w;
-                            clipV1.y *= clipV1.w;
-                            clipV2.y *= clipV2.w;
-                            clipIntersect.y *= clipIntersect.w;
-
-                            // Recalculate barycentric coordinates in screen space
-                            int newI1 = 0, newI2 = 1;
-                            VxIntersect::GetPointCoefficients(
-                                *(const VxVector *) &clipIntersect,
-                                *(const VxVector *) &clipV0,
-                                *(const VxVector *) &clipV1,
-                                *(const VxVector *) &clipV2,
-                                newI1, newI2, c0, c1, c2);
-
-                            // Recalculate UVs with perspective-correct interpolation
-                            desc->TexU = c0 * vert0[6] + c1 * vert1[6] + c2 * vert2[6];
-                            desc->TexV = c0 * vert0[7] + c1 * vert1[7] + c2 * vert2[7];
-                        }
-                    }
-                }
-
-                // Precise texture pick (alpha test) (IDA lines 256-261)
-                if (!PreciseTexturePick(faceMat, desc->TexU, desc->TexV)) {
-                    delete[] vertexFlags;
-                    return 0; // Hit was on transparent pixel
-                }
+            if (!FillRayIntersectionDesc(mesh, vertexPtr, indices, origin, direction, desc, worldMatrix,
+                                         bestFaceIdx, minDist, bestI1, bestI2)) {
+                delete[] vertexFlags;
+                return 0; // Hit was on transparent pixel
             }
-
-            // Final output (IDA lines 263-264)
-            desc->Distance = minDist;
-            desc->FaceIndex = faceIdx;
         }
     }
 
     delete[] vertexFlags;
     return foundHit ? hitCount : 0;
 }
+
+int RayIntersectionGenericFunc(RCKMesh *mesh, VxVector &origin, VxVector &direction,
+                               VxIntersectionDesc *desc, CK_RAYINTERSECTION mode,
+                               const VxMatrix &worldMatrix) {
+    // Get mesh data directly from protected members (friend access)
+    float *vertexPtr = (float *) mesh->m_Vertices.Begin();
+    CKFace *faces = mesh->m_Faces.Begin();
+    const int faceCount = mesh->m_Faces.Size();
+    const int vertexCount = mesh->m_Vertices.Size();
+    if (mesh->m_WideIndices)
+        return RayIntersectionIndexed(mesh, vertexPtr, faces, mesh->m_FaceVertexIndices32.Begin(), faceCount,
+                                      vertexCount, origin, direction, desc, mode, worldMatrix);
+    return RayIntersectionIndexed(mesh, vertexPtr, faces, mesh->m_FaceVertexIndices.Begin(), faceCount,
+                                  vertexCount, origin, direction, desc, mode, worldMatrix);
+}
+
+typedef XBOOL (*RayFaceFunc)(const VxRay &, const VxVector &, const VxVector &, const VxVector &, const VxVector &,
+                             VxVector &, float &, int &, int &);
+
+struct MeshBVHRayQuery {
+    RCKMesh *mesh;
+    const float *vertexPtr;
+    const CKWORD *indices;     // 16-bit mesh indices, or
+    const CKDWORD *indices32;  // 32-bit mesh indices
+    const CKFace *faces;
+    VxRay ray;
+    RayFaceFunc culledFunc;
+    RayFaceFunc twoSidedFunc;
+    float minDist;
+    int bestI1;
+    int bestI2;
+    int bestFaceIdx;
+    int hitCount;
+};
+
+// Same per face test as the RayIntersectionGenericFunc loop
+static void RayIntersectLeafFaces(const int *faceList, int count, void *arg) {
+    MeshBVHRayQuery &query = *(MeshBVHRayQuery *) arg;
+    VxVector intersectPoint;
+    float dist;
+    int i1 = 1;
+    int i2 = 2;
+
+    for (int i = 0; i < count; ++i) {
+        const int f = faceList[i];
+        int vi[3];
+        for (int k = 0; k < 3; ++k)
+            vi[k] = query.indices32 ? (int) query.indices32[f * 3 + k] : (int) query.indices[f * 3 + k];
+        const VxVector *v0 = (const VxVector *) &query.vertexPtr[8 * vi[0]];
+        const VxVector *v1 = (const VxVector *) &query.vertexPtr[8 * vi[1]];
+        const VxVector *v2 = (const VxVector *) &query.vertexPtr[8 * vi[2]];
+
+        CKMaterial *mat = query.mesh->GetFaceMaterial(f);
+        RayFaceFunc func = (mat && mat->IsTwoSided()) ? query.twoSidedFunc : query.culledFunc;
+        if (!func(query.ray, *v0, *v1, *v2, query.faces[f].m_Normal, intersectPoint, dist, i1, i2))
+            continue;
+
+        ++query.hitCount;
+        // Leaves are not visited in face order: equal distances go to the
+        // lowest face index, as the first hit would in the generic loop
+        if (dist < query.minDist || (dist == query.minDist && f < query.bestFaceIdx)) {
+            query.minDist = dist;
+            query.bestI1 = i1;
+            query.bestI2 = i2;
+            query.bestFaceIdx = f;
+        }
+    }
+}
+
+// Mesh ray intersection through the cached triangle hierarchy. Every face of
+// the leaves crossed by the ray is tested, so the hit count and the returned
+// description are the same as with RayIntersectionGenericFunc.
+int RayIntersectionBVHFunc(RCKMesh *mesh, VxVector &origin, VxVector &direction,
+                           VxIntersectionDesc *desc, CK_RAYINTERSECTION mode,
+                           const VxMatrix &worldMatrix) {
+    const int faceCount = mesh->m_Faces.Size();
+    const int vertexCount = mesh->m_Vertices.Size();
+
+    RCKRenderManager *rm = (RCKRenderManager *) mesh->m_Context->GetRenderManager();
+    const int threshold = rm ? rm->m_MeshRayBVHThreshold.Value : 0;
+    if (threshold <= 0 || faceCount < threshold || vertexCount == 0)
+        return RayIntersectionGenericFunc(mesh, origin, direction, desc, mode, worldMatrix);
+
+    if (!mesh->m_RayBVH)
+        mesh->m_RayBVH = new CKMeshBVH();
+    CKMeshBVH *bvh = mesh->m_RayBVH;
+    const CKBOOL wide = mesh->m_WideIndices;
+    if (!bvh->IsUpToDate(faceCount, vertexCount)) {
+        if (wide)
+            bvh->Build(mesh->m_Vertices.Begin(), vertexCount, mesh->m_FaceVertexIndices32.Begin(), faceCount);
+        else
+            bvh->Build(mesh->m_Vertices.Begin(), vertexCount, mesh->m_FaceVertexIndices.Begin(), faceCount);
+    }
+
+    MeshBVHRayQuery query;
+    query.mesh = mesh;
+    query.vertexPtr = (const float *) mesh->m_Vertices.Begin();
+    query.indices = wide ? nullptr : mesh->m_FaceVertexIndices.Begin();
+    query.indices32 = wide ? mesh->m_FaceVertexIndices32.Begin() : nullptr;
+    query.faces = mesh->m_Faces.Begin();
+    query.ray.m_Origin = origin;
+    query.ray.m_Direction = direction;
+    query.culledFunc = (RayFaceFunc) VxIntersect::RayFaceCulled;
+    query.twoSidedFunc = (RayFaceFunc) VxIntersect::RayFace;
+    float maxDist = 1.0e35f;
+    if (mode != 0) {
+        query.culledFunc = (RayFaceFunc) VxIntersect::SegmentFaceCulled;
+        query.twoSidedFunc = (RayFaceFunc) VxIntersect::SegmentFace;
+        maxDist = 1.0f;
+    }
+    query.minDist = 1.0e35f;
+    query.bestI1 = 0;
+    query.bestI2 = 0;
+    query.bestFaceIdx = -1;
+    query.hitCount = 0;
+
+    bvh->Traverse(origin, direction, maxDist, RayIntersectLeafFaces, &query);
+
+    if (query.bestFaceIdx < 0)
+        return 0;
+
+    if (desc) {
+        const CKBOOL kept =
+            wide ? FillRayIntersectionDesc(mesh, query.vertexPtr, query.indices32, origin, direction, desc, worldMatrix,
+                                           query.bestFaceIdx, query.minDist, query.bestI1, query.bestI2)
+                 : FillRayIntersectionDesc(mesh, query.vertexPtr, query.indices, origin, direction, desc, worldMatrix,
+                                           query.bestFaceIdx, query.minDist, query.bestI1, query.bestI2);
+        if (!kept)
+            return 0; // Hit was on transparent pixel
+    }
+
+    return query.hitCount;
+}
@@ -0,0 +1,364 @@
+#include "RCKMesh.h"
+
+// =====================================================
+// SIMD Normal Functions for Mesh Operations
+// Processor specific versions selected by SetProcessorSpecific_FunctionsPtr().
+// They work in place on the strided VxVertex / CKFace arrays and follow the
+// generic operation order (no fused multiply-add), so results only differ
+// from the generic versions by rounding. The first count & ~3 elements take
+// the same vector operations at both levels and the rest the generic code:
+// CKMeshVertexFaces relies on it to patch normals with the same results.
+// =====================================================
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CKMESH_SIMD_X86 1
+#endif
+
+#ifdef CKMESH_SIMD_X86
+
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CKMESH_TARGET_SSE2
+#define CKMESH_TARGET_AVX2
+#else
+#define CKMESH_TARGET_SSE2 __attribute__((target("sse2")))
+#define CKMESH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+static CK_MESHSIMD DetectMeshSIMDLevel() {
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0);
+    const int maxLeaf = regs[0];
+    if (maxLeaf < 1)
+        return CK_MESHSIMD_NONE;
+
+    __cpuid(regs, 1);
+    if (!(regs[3] & (1 << 26))) // EDX: SSE2
+        return CK_MESHSIMD_NONE;
+
+    // AVX2 also needs the OS to save the YMM registers (OSXSAVE + XCR0)
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    if (maxLeaf < 7 || !osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        return CK_MESHSIMD_SSE2;
+
+    __cpuidex(regs, 7, 0);
+    if (regs[1] & (1 << 5)) // EBX: AVX2
+        return CK_MESHSIMD_AVX2;
+    return CK_MESHSIMD_SSE2;
+#else
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("sse2"))
+        return CK_MESHSIMD_NONE;
+    if (__builtin_cpu_supports("avx2"))
+        return CK_MESHSIMD_AVX2;
+    return CK_MESHSIMD_SSE2;
+#endif
+}
+
+CK_MESHSIMD GetMeshSIMDLevel() {
+    static const CK_MESHSIMD level = DetectMeshSIMDLevel();
+    return level;
+}
+
+// Accumulates face normals into the vertex normals in face order, exactly like
+// BuildNormalsGenericFunc, so the sums are bit identical. This stays scalar:
+// neighbouring faces share vertices, and a 16 byte reload of a normal just
+// written as 8 + 4 bytes stalls on store forwarding.
+static void AccumulateVertexNormals(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount) {
+    for (int i = 0; i < vertexCount; ++i)
+        vertices[i].m_Normal.Set(0.0f, 0.0f, 0.0f);
+
+    const CKWORD *idx = indices;
+    for (int f = 0; f < faceCount; ++f, idx += 3) {
+        const VxVector &faceNormal = faces[f].m_Normal;
+        vertices[idx[0]].m_Normal += faceNormal;
+        vertices[idx[1]].m_Normal += faceNormal;
+        vertices[idx[2]].m_Normal += faceNormal;
+    }
+}
+
+// =====================================================
+// SSE2: four faces / vertices per iteration
+// =====================================================
+
+// Loads the 16 bytes at each address (a VxVector plus the next float, which
+// is always inside the same VxVertex) and transposes them to x, y, z lanes.
+CKMESH_TARGET_SSE2
+static inline void LoadVectors4(const float *p0, const float *p1, const float *p2, const float *p3,
+                                __m128 &x, __m128 &y, __m128 &z) {
+    __m128 r0 = _mm_loadu_ps(p0);
+    __m128 r1 = _mm_loadu_ps(p1);
+    __m128 r2 = _mm_loadu_ps(p2);
+    __m128 r3 = _mm_loadu_ps(p3);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    x = r0;
+    y = r1;
+    z = r2;
+}
+
+// Transposes x, y, z lanes back and writes 12 bytes at each address
+CKMESH_TARGET_SSE2
+static inline void StoreVectors4(float *p0, float *p1, float *p2, float *p3, __m128 x, __m128 y, __m128 z) {
+    __m128 w = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storel_pi((__m64 *) p0, x);
+    _mm_store_ss(p0 + 2, _mm_movehl_ps(x, x));
+    _mm_storel_pi((__m64 *) p1, y);
+    _mm_store_ss(p1 + 2, _mm_movehl_ps(y, y));
+    _mm_storel_pi((__m64 *) p2, z);
+    _mm_store_ss(p2 + 2, _mm_movehl_ps(z, z));
+    _mm_storel_pi((__m64 *) p3, w);
+    _mm_store_ss(p3 + 2, _mm_movehl_ps(w, w));
+}
+
+// Writes four consecutive face normals with full 16 byte stores, keeping the
+// material index and channel mask packed in the 4th float of each CKFace
+CKMESH_TARGET_SSE2
+static inline void StoreFaceNormals4(CKFace *faces, __m128 x, __m128 y, __m128 z) {
+    __m128 w = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    const __m128 wMask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+    float *p = &faces[0].m_Normal.x;
+    _mm_storeu_ps(p, _mm_or_ps(x, _mm_and_ps(_mm_loadu_ps(p), wMask)));
+    _mm_storeu_ps(p + 4, _mm_or_ps(y, _mm_and_ps(_mm_loadu_ps(p + 4), wMask)));
+    _mm_storeu_ps(p + 8, _mm_or_ps(z, _mm_and_ps(_mm_loadu_ps(p + 8), wMask)));
+    _mm_storeu_ps(p + 12, _mm_or_ps(w, _mm_and_ps(_mm_loadu_ps(p + 12), wMask)));
+}
+
+// Scales (x, y, z) by 1 / length, leaving zero length vectors untouched
+CKMESH_TARGET_SSE2
+static inline void Normalize4(__m128 &x, __m128 &y, __m128 &z) {
+    const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+    const __m128 valid = _mm_cmpgt_ps(length, _mm_setzero_ps());
+    const __m128 scale = _mm_or_ps(_mm_and_ps(valid, _mm_div_ps(_mm_set1_ps(1.0f), length)),
+                                   _mm_andnot_ps(valid, _mm_set1_ps(1.0f)));
+    x = _mm_mul_ps(x, scale);
+    y = _mm_mul_ps(y, scale);
+    z = _mm_mul_ps(z, scale);
+}
+
+CKMESH_TARGET_SSE2
+void BuildFaceNormalsSSE2Func(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount) {
+    int f = 0;
+    for (; f + 4 <= faceCount; f += 4) {
+        const CKWORD *idx = &indices[f * 3];
+
+        __m128 x0, y0, z0, x1, y1, z1, x2, y2, z2;
+        LoadVectors4(&vertices[idx[0]].m_Position.x, &vertices[idx[3]].m_Position.x,
+                     &vertices[idx[6]].m_Position.x, &vertices[idx[9]].m_Position.x, x0, y0, z0);
+        LoadVectors4(&vertices[idx[1]].m_Position.x, &vertices[idx[4]].m_Position.x,
+                     &vertices[idx[7]].m_Position.x, &vertices[idx[10]].m_Position.x, x1, y1, z1);
+        LoadVectors4(&vertices[idx[2]].m_Position.x, &vertices[idx[5]].m_Position.x,
+                     &vertices[idx[8]].m_Position.x, &vertices[idx[11]].m_Position.x, x2, y2, z2);
+
+        const __m128 ex1 = _mm_sub_ps(x1, x0), ey1 = _mm_sub_ps(y1, y0), ez1 = _mm_sub_ps(z1, z0);
+        const __m128 ex2 = _mm_sub_ps(x2, x0), ey2 = _mm_sub_ps(y2, y0), ez2 = _mm_sub_ps(z2, z0);
+
+        __m128 nx = _mm_sub_ps(_mm_mul_ps(ey1, ez2), _mm_mul_ps(ez1, ey2));
+        __m128 ny = _mm_sub_ps(_mm_mul_ps(ez1, ex2), _mm_mul_ps(ex1, ez2));
+        __m128 nz = _mm_sub_ps(_mm_mul_ps(ex1, ey2), _mm_mul_ps(ey1, ex2));
+        Normalize4(nx, ny, nz);
+
+        StoreFaceNormals4(&faces[f], nx, ny, nz);
+    }
+
+    if (f < faceCount)
+        BuildFaceNormalsGenericFunc(&faces[f], &indices[f * 3], faceCount - f, vertices, vertexCount);
+}
+
+CKMESH_TARGET_SSE2
+void NormalizeSSE2Func(VxVertex *vertices, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float *n0 = &vertices[i].m_Normal.x;
+        float *n1 = &vertices[i + 1].m_Normal.x;
+        float *n2 = &vertices[i + 2].m_Normal.x;
+        float *n3 = &vertices[i + 3].m_Normal.x;
+
+        __m128 x, y, z;
+        LoadVectors4(n0, n1, n2, n3, x, y, z);
+        Normalize4(x, y, z);
+        StoreVectors4(n0, n1, n2, n3, x, y, z);
+    }
+
+    if (i < count)
+        NormalizeGenericFunc(&vertices[i], count - i);
+}
+
+void BuildNormalsSSE2Func(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount) {
+    BuildFaceNormalsSSE2Func(faces, indices, faceCount, vertices, vertexCount);
+    AccumulateVertexNormals(faces, indices, faceCount, vertices, vertexCount);
+    NormalizeSSE2Func(vertices, vertexCount);
+}
+
+// =====================================================
+// AVX2: eight faces / vertices per iteration. Vectors are loaded with 16 byte
+// loads and transposed inside each 128-bit lane, which beats gathers here.
+// =====================================================
+
+// Same as LoadVectors4 for eight addresses: lane k of x, y, z comes from p[k]
+CKMESH_TARGET_AVX2
+static inline void LoadVectors8(const float *const *p, __m256 &x, __m256 &y, __m256 &z) {
+    const __m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p[0])), _mm_loadu_ps(p[4]), 1);
+    const __m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p[1])), _mm_loadu_ps(p[5]), 1);
+    const __m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p[2])), _mm_loadu_ps(p[6]), 1);
+    const __m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p[3])), _mm_loadu_ps(p[7]), 1);
+
+    const __m256 t0 = _mm256_unpacklo_ps(r0, r1); // x0 x1 y0 y1
+    const __m256 t1 = _mm256_unpacklo_ps(r2, r3); // x2 x3 y2 y3
+    const __m256 t2 = _mm256_unpackhi_ps(r0, r1); // z0 z1 w0 w1
+    const __m256 t3 = _mm256_unpackhi_ps(r2, r3); // z2 z3 w2 w3
+    x = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+    y = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+    z = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+}
+
+// Transposes x, y, z back to one (x, y, z, 0) row per vector: row k holds
+// vector k in its low half and vector k + 4 in its high half
+CKMESH_TARGET_AVX2
+static inline void TransposeToRows8(__m256 x, __m256 y, __m256 z, __m256 *rows) {
+    const __m256 t0 = _mm256_unpacklo_ps(x, y);                   // x0 y0 x1 y1
+    const __m256 t1 = _mm256_unpackhi_ps(x, y);                   // x2 y2 x3 y3
+    const __m256 t2 = _mm256_unpacklo_ps(z, _mm256_setzero_ps()); // z0 0 z1 0
+    const __m256 t3 = _mm256_unpackhi_ps(z, _mm256_setzero_ps()); // z2 0 z3 0
+    rows[0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    rows[1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    rows[2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    rows[3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+// Writes 12 bytes at each of the eight addresses
+CKMESH_TARGET_AVX2
+static inline void StoreVectors8(float *const *p, __m256 x, __m256 y, __m256 z) {
+    __m256 rows[4];
+    TransposeToRows8(x, y, z, rows);
+    for (int k = 0; k < 4; ++k) {
+        const __m128 lo = _mm256_castps256_ps128(rows[k]);
+        const __m128 hi = _mm256_extractf128_ps(rows[k], 1);
+        _mm_storel_pi((__m64 *) p[k], lo);
+        _mm_store_ss(p[k] + 2, _mm_movehl_ps(lo, lo));
+        _mm_storel_pi((__m64 *) p[k + 4], hi);
+        _mm_store_ss(p[k + 4] + 2, _mm_movehl_ps(hi, hi));
+    }
+}
+
+// Eight consecutive face normals with 32 byte stores, see StoreFaceNormals4
+CKMESH_TARGET_AVX2
+static inline void StoreFaceNormals8(CKFace *faces, __m256 x, __m256 y, __m256 z) {
+    __m256 rows[4];
+    TransposeToRows8(x, y, z, rows);
+    float *p = &faces[0].m_Normal.x;
+    const __m256 pairs[4] = {
+        _mm256_permute2f128_ps(rows[0], rows[1], 0x20), // faces 0, 1
+        _mm256_permute2f128_ps(rows[2], rows[3], 0x20), // faces 2, 3
+        _mm256_permute2f128_ps(rows[0], rows[1], 0x31), // faces 4, 5
+        _mm256_permute2f128_ps(rows[2], rows[3], 0x31), // faces 6, 7
+    };
+    for (int k = 0; k < 4; ++k)
+        _mm256_storeu_ps(p + k * 8, _mm256_blend_ps(pairs[k], _mm256_loadu_ps(p + k * 8), 0x88));
+}
+
+CKMESH_TARGET_AVX2
+static inline void Normalize8(__m256 &x, __m256 &y, __m256 &z) {
+    const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)),
+                                                       _mm256_mul_ps(z, z)));
+    const __m256 valid = _mm256_cmp_ps(length, _mm256_setzero_ps(), _CMP_GT_OQ);
+    const __m256 scale = _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_div_ps(_mm256_set1_ps(1.0f), length), valid);
+    x = _mm256_mul_ps(x, scale);
+    y = _mm256_mul_ps(y, scale);
+    z = _mm256_mul_ps(z, scale);
+}
+
+CKMESH_TARGET_AVX2
+void BuildFaceNormalsAVX2Func(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount) {
+    int f = 0;
+    for (; f + 8 <= faceCount; f += 8) {
+        const CKWORD *idx = &indices[f * 3];
+
+        const float *p0[8], *p1[8], *p2[8];
+        for (int k = 0; k < 8; ++k) {
+            p0[k] = &vertices[idx[k * 3]].m_Position.x;
+            p1[k] = &vertices[idx[k * 3 + 1]].m_Position.x;
+            p2[k] = &vertices[idx[k * 3 + 2]].m_Position.x;
+        }
+
+        __m256 x0, y0, z0, x1, y1, z1, x2, y2, z2;
+        LoadVectors8(p0, x0, y0, z0);
+        LoadVectors8(p1, x1, y1, z1);
+        LoadVectors8(p2, x2, y2, z2);
+
+        const __m256 ex1 = _mm256_sub_ps(x1, x0), ey1 = _mm256_sub_ps(y1, y0), ez1 = _mm256_sub_ps(z1, z0);
+        const __m256 ex2 = _mm256_sub_ps(x2, x0), ey2 = _mm256_sub_ps(y2, y0), ez2 = _mm256_sub_ps(z2, z0);
+
+        __m256 nx = _mm256_sub_ps(_mm256_mul_ps(ey1, ez2), _mm256_mul_ps(ez1, ey2));
+        __m256 ny = _mm256_sub_ps(_mm256_mul_ps(ez1, ex2), _mm256_mul_ps(ex1, ez2));
+        __m256 nz = _mm256_sub_ps(_mm256_mul_ps(ex1, ey2), _mm256_mul_ps(ey1, ex2));
+        Normalize8(nx, ny, nz);
+
+        StoreFaceNormals8(&faces[f], nx, ny, nz);
+    }
+
+    if (f < faceCount)
+        BuildFaceNormalsSSE2Func(&faces[f], &indices[f * 3], faceCount - f, vertices, vertexCount);
+}
+
+CKMESH_TARGET_AVX2
+void NormalizeAVX2Func(VxVertex *vertices, int count) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float *n[8];
+        for (int k = 0; k < 8; ++k)
+            n[k] = &vertices[i + k].m_Normal.x;
+
+        __m256 x, y, z;
+        LoadVectors8(n, x, y, z);
+        Normalize8(x, y, z);
+        StoreVectors8(n, x, y, z);
+    }
+
+    if (i < count)
+        NormalizeSSE2Func(&vertices[i], count - i);
+}
+
+void BuildNormalsAVX2Func(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount) {
+    BuildFaceNormalsAVX2Func(faces, indices, faceCount, vertices, vertexCount);
+    AccumulateVertexNormals(faces, indices, faceCount, vertices, vertexCount);
+    NormalizeAVX2Func(vertices, vertexCount);
+}
+
+#else // CKMESH_SIMD_X86
+
+// Other architectures only have the generic versions
+CK_MESHSIMD GetMeshSIMDLevel() {
+    return CK_MESHSIMD_NONE;
+}
+
+void BuildFaceNormalsSSE2Func(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount) {
+    BuildFaceNormalsGenericFunc(faces, indices, faceCount, vertices, vertexCount);
+}
+
+void BuildNormalsSSE2Func(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount) {
+    BuildNormalsGenericFunc(faces, indices, faceCount, vertices, vertexCount);
+}
+
+void NormalizeSSE2Func(VxVertex *vertices, int count) {
+    NormalizeGenericFunc(vertices, count);
+}
+
+void BuildFaceNormalsAVX2Func(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount) {
+    BuildFaceNormalsGenericFunc(faces, indices, faceCount, vertices, vertexCount);
+}
+
+void BuildNormalsAVX2Func(CKFace *faces, CKWORD *indices, int faceCount, VxVertex *vertices, int vertexCount) {
+    BuildNormalsGenericFunc(faces, indices, faceCount, vertices, vertexCount);
+}
+
+void NormalizeAVX2Func(VxVertex *vertices, int count) {
+    NormalizeGenericFunc(vertices, count);
+}
+
+#endif // CKMESH_SIMD_X86
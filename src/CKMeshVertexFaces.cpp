@@ -0,0 +1,176 @@
+#include "CKMeshVertexFaces.h"
+
+#include <string.h>
+
+#include "RCKMesh.h"
+
+CKMeshVertexFaces::CKMeshVertexFaces() : m_Built(FALSE), m_FaceCount(0), m_VertexCount(0), m_Mark(0) {}
+
+void CKMeshVertexFaces::Build(const CKWORD *indices, int faceCount, int vertexCount) {
+    BuildLists(indices, faceCount, vertexCount);
+}
+
+void CKMeshVertexFaces::Build(const CKDWORD *indices, int faceCount, int vertexCount) {
+    BuildLists(indices, faceCount, vertexCount);
+}
+
+template <class IndexType>
+void CKMeshVertexFaces::BuildLists(const IndexType *indices, int faceCount, int vertexCount) {
+    m_FaceCount = faceCount;
+    m_VertexCount = vertexCount;
+
+    // Init only reads the indices
+    m_Adjacency.Init(const_cast<IndexType *>(indices), faceCount);
+    m_Adjacency.ComputeVertexFaces();
+
+    m_FaceMarks.Resize(faceCount);
+    m_VertexMarks.Resize(vertexCount);
+    memset(m_FaceMarks.Begin(), 0, faceCount * sizeof(int));
+    memset(m_VertexMarks.Begin(), 0, vertexCount * sizeof(int));
+    m_Mark = 0;
+    m_Built = TRUE;
+}
+
+void CKMeshVertexFaces::NextMark() {
+    if (++m_Mark == 0) {
+        memset(m_FaceMarks.Begin(), 0, m_FaceMarks.Size() * sizeof(int));
+        memset(m_VertexMarks.Begin(), 0, m_VertexMarks.Size() * sizeof(int));
+        m_Mark = 1;
+    }
+}
+
+void CKMeshVertexFaces::PatchNormals(const int *moved, int movedCount, CKFace *faces, const CKWORD *indices,
+                                     VxVertex *vertices, CKBOOL vertexNormals, FaceNormalsFunc faceNormals,
+                                     NormalizeFunc normalize) {
+    CollectFaces(moved, movedCount, indices, vertexNormals);
+    PatchFaceNormals(faces, indices, vertices, faceNormals);
+    if (vertexNormals)
+        PatchVertexNormals(faces, indices, vertices, normalize);
+}
+
+void CKMeshVertexFaces::PatchNormals(const int *moved, int movedCount, CKFace *faces, const CKDWORD *indices,
+                                     VxVertex *vertices, CKBOOL vertexNormals, NormalizeFunc normalize) {
+    CollectFaces(moved, movedCount, indices, vertexNormals);
+    for (int i = 0; i < m_PatchFaces.Size(); ++i) {
+        const int f = m_PatchFaces[i];
+        BuildFaceNormals32GenericFunc(&faces[f], const_cast<CKDWORD *>(indices + f * 3), 1, vertices, m_VertexCount);
+    }
+    if (vertexNormals)
+        PatchVertexNormals(faces, indices, vertices, normalize);
+}
+
+// Faces around the moved vertices, then with vertexNormals the vertices of
+// these faces
+template <class IndexType>
+void CKMeshVertexFaces::CollectFaces(const int *moved, int movedCount, const IndexType *indices,
+                                     CKBOOL vertexNormals) {
+    NextMark();
+    m_PatchFaces.Resize(0);
+    m_PatchVertices.Resize(0);
+    for (int i = 0; i < movedCount; ++i) {
+        const int v = moved[i];
+        if (v < 0 || v >= m_VertexCount)
+            continue;
+        int count;
+        const CKDWORD *vertexFaces = GetFaces(v, count);
+        for (int f = 0; f < count; ++f) {
+            if (m_FaceMarks[vertexFaces[f]] != m_Mark) {
+                m_FaceMarks[vertexFaces[f]] = m_Mark;
+                m_PatchFaces.PushBack((int) vertexFaces[f]);
+            }
+        }
+    }
+    if (!vertexNormals)
+        return;
+
+    for (int i = 0; i < m_PatchFaces.Size(); ++i) {
+        const IndexType *idx = indices + m_PatchFaces[i] * 3;
+        for (int c = 0; c < 3; ++c) {
+            const CKDWORD v = (CKDWORD) idx[c];
+            if (v < (CKDWORD) m_VertexCount && m_VertexMarks[v] != m_Mark) {
+                m_VertexMarks[v] = m_Mark;
+                m_PatchVertices.PushBack((int) v);
+            }
+        }
+    }
+}
+
+// The SSE2 and AVX2 kernels take the first count & ~3 elements four or eight
+// at a time with the same operations, and the rest with the generic code. The
+// faces below that bound are gathered, padded to a multiple of four, and go
+// through faceNormals so that they get the lanes of the full build.
+void CKMeshVertexFaces::PatchFaceNormals(CKFace *faces, const CKWORD *indices, VxVertex *vertices,
+                                         FaceNormalsFunc faceNormals) {
+    const int laneFaceCount = m_FaceCount & ~3;
+    m_BatchFaces.Resize(0);
+    m_BatchIndices.Resize(0);
+    for (int i = 0; i < m_PatchFaces.Size(); ++i) {
+        const int f = m_PatchFaces[i];
+        if (f < laneFaceCount) {
+            m_BatchFaces.PushBack(faces[f]);
+            for (int c = 0; c < 3; ++c)
+                m_BatchIndices.PushBack(indices[f * 3 + c]);
+        } else {
+            BuildFaceNormalsGenericFunc(&faces[f], const_cast<CKWORD *>(indices + f * 3), 1, vertices, m_VertexCount);
+        }
+    }
+
+    const int batchCount = m_BatchFaces.Size();
+    if (batchCount == 0)
+        return;
+    while (m_BatchFaces.Size() & 3) {
+        m_BatchFaces.PushBack(m_BatchFaces[batchCount - 1]);
+        for (int c = 0; c < 3; ++c)
+            m_BatchIndices.PushBack(m_BatchIndices[(batchCount - 1) * 3 + c]);
+    }
+    faceNormals(m_BatchFaces.Begin(), m_BatchIndices.Begin(), m_BatchFaces.Size(), vertices, m_VertexCount);
+
+    int b = 0;
+    for (int i = 0; i < m_PatchFaces.Size(); ++i) {
+        const int f = m_PatchFaces[i];
+        if (f < laneFaceCount)
+            faces[f].m_Normal = m_BatchFaces[b++].m_Normal;
+    }
+}
+
+// Same sums as the full build: from zero, the faces in order and a face once
+// per corner on the vertex. Then the same lanes of normalize as the faces.
+template <class IndexType>
+void CKMeshVertexFaces::PatchVertexNormals(CKFace *faces, const IndexType *indices, VxVertex *vertices,
+                                           NormalizeFunc normalize) {
+    const int laneVertexCount = m_VertexCount & ~3;
+    m_BatchVertices.Resize(0);
+    for (int i = 0; i < m_PatchVertices.Size(); ++i) {
+        const int v = m_PatchVertices[i];
+        int count;
+        const CKDWORD *vertexFaces = GetFaces(v, count);
+        VxVector &normal = vertices[v].m_Normal;
+        normal.Set(0.0f, 0.0f, 0.0f);
+        for (int f = 0; f < count; ++f) {
+            const IndexType *idx = indices + vertexFaces[f] * 3;
+            const VxVector &faceNormal = faces[vertexFaces[f]].m_Normal;
+            for (int c = 0; c < 3; ++c) {
+                if ((int) idx[c] == v)
+                    normal += faceNormal;
+            }
+        }
+        if (v < laneVertexCount)
+            m_BatchVertices.PushBack(vertices[v]);
+        else
+            NormalizeGenericFunc(&vertices[v], 1);
+    }
+
+    const int batchCount = m_BatchVertices.Size();
+    if (batchCount == 0)
+        return;
+    while (m_BatchVertices.Size() & 3)
+        m_BatchVertices.PushBack(m_BatchVertices[batchCount - 1]);
+    normalize(m_BatchVertices.Begin(), m_BatchVertices.Size());
+
+    int b = 0;
+    for (int i = 0; i < m_PatchVertices.Size(); ++i) {
+        const int v = m_PatchVertices[i];
+        if (v < laneVertexCount)
+            vertices[v].m_Normal = m_BatchVertices[b++].m_Normal;
+    }
+}
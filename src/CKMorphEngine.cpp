@@ -0,0 +1,251 @@
+#include "CKMorphEngine.h"
+
+#include "RCKMesh.h"
+
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CKMORPH_SIMD_X86 1
+#endif
+
+// Versions of all tables, so that a state recorded for one table never
+// matches another one
+static int s_MorphTableVersion = 0;
+
+// Entries of a sorted vertex list below vertexCount
+static int CountBelow(const int *vertices, int count, int vertexCount) {
+    int low = 0;
+    int high = count;
+    while (low < high) {
+        const int mid = (low + high) >> 1;
+        if (vertices[mid] < vertexCount)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+CKMorphDeltaTable::CKMorphDeltaTable()
+    : m_Built(FALSE), m_HasNormals(FALSE), m_Version(0), m_PairKeyFrom(-1), m_PairKeyTo(-1) {}
+
+void CKMorphDeltaTable::Clear() {
+    m_Built = FALSE;
+    m_HasNormals = FALSE;
+    m_KeyStarts.Clear();
+    m_KeyVertices.Clear();
+    m_PairKeyFrom = -1;
+    m_PairKeyTo = -1;
+    m_PairVertices.Clear();
+    m_FromPositions.Clear();
+    m_DeltaPositions.Clear();
+    m_FromNormals.Clear();
+    m_DeltaNormals.Clear();
+    m_Blended.Clear();
+}
+
+CKBOOL CKMorphDeltaTable::Build(const CKMorphKey *keys, int keyCount, int vertexCount) {
+    Clear();
+    if (keyCount <= 0 || vertexCount <= 0)
+        return FALSE;
+
+    const CKBOOL hasNormals = keys[0].NormArray != nullptr;
+    for (int k = 0; k < keyCount; ++k) {
+        if (!keys[k].PosArray || (keys[k].NormArray != nullptr) != hasNormals)
+            return FALSE;
+    }
+
+    const VxVector *basePositions = keys[0].PosArray;
+    const VxCompressedVector *baseNormals = keys[0].NormArray;
+    m_KeyStarts.Resize(keyCount + 1);
+    m_KeyStarts[0] = 0;
+    m_KeyStarts[1] = 0;
+    for (int k = 1; k < keyCount; ++k) {
+        const VxVector *positions = keys[k].PosArray;
+        const VxCompressedVector *normals = keys[k].NormArray;
+        for (int v = 0; v < vertexCount; ++v) {
+            if (memcmp(&positions[v], &basePositions[v], sizeof(VxVector)) != 0 ||
+                (hasNormals && memcmp(&normals[v], &baseNormals[v], sizeof(VxCompressedVector)) != 0))
+                m_KeyVertices.PushBack(v);
+        }
+        m_KeyStarts[k + 1] = m_KeyVertices.Size();
+    }
+
+    m_HasNormals = hasNormals;
+    if (++s_MorphTableVersion == 0)
+        s_MorphTableVersion = 1;
+    m_Version = s_MorphTableVersion;
+    m_Built = TRUE;
+    return TRUE;
+}
+
+void CKMorphDeltaTable::SetPair(const CKMorphKey *keys, int from, int to) {
+    if (from == m_PairKeyFrom && to == m_PairKeyTo)
+        return;
+    m_PairKeyFrom = from;
+    m_PairKeyTo = to;
+
+    // Union of the two sorted lists
+    int fromCount, toCount;
+    const int *fromVertices = GetKeyVertices(from, fromCount);
+    const int *toVertices = GetKeyVertices(to, toCount);
+    m_PairVertices.Resize(0);
+    int i = 0, j = 0;
+    while (i < fromCount || j < toCount) {
+        if (j >= toCount || (i < fromCount && fromVertices[i] < toVertices[j])) {
+            m_PairVertices.PushBack(fromVertices[i++]);
+        } else {
+            if (i < fromCount && fromVertices[i] == toVertices[j])
+                ++i;
+            m_PairVertices.PushBack(toVertices[j++]);
+        }
+    }
+
+    const int count = m_PairVertices.Size();
+    const CKMorphKey &fromKey = keys[from];
+    const CKMorphKey &toKey = keys[to];
+    m_FromPositions.Resize(count * 3);
+    m_DeltaPositions.Resize(count * 3);
+    for (int p = 0; p < count; ++p) {
+        const VxVector &p1 = fromKey.PosArray[m_PairVertices[p]];
+        const VxVector &p2 = toKey.PosArray[m_PairVertices[p]];
+        float *fromPos = &m_FromPositions[p * 3];
+        float *deltaPos = &m_DeltaPositions[p * 3];
+        fromPos[0] = p1.x;
+        fromPos[1] = p1.y;
+        fromPos[2] = p1.z;
+        deltaPos[0] = p2.x - p1.x;
+        deltaPos[1] = p2.y - p1.y;
+        deltaPos[2] = p2.z - p1.z;
+    }
+
+    if (m_HasNormals) {
+        m_FromNormals.Resize(count * 2);
+        m_DeltaNormals.Resize(count * 2);
+        for (int p = 0; p < count; ++p) {
+            const VxCompressedVector &n1 = fromKey.NormArray[m_PairVertices[p]];
+            const VxCompressedVector &n2 = toKey.NormArray[m_PairVertices[p]];
+            m_FromNormals[p * 2] = (float) n1.xa;
+            m_FromNormals[p * 2 + 1] = (float) n1.ya;
+            m_DeltaNormals[p * 2] = (float) (n2.xa - n1.xa);
+            m_DeltaNormals[p * 2 + 1] = (float) (n2.ya - n1.ya);
+        }
+    }
+}
+
+int CKMorphDeltaTable::EvaluatePair(float factor, int vertexCount, CKBYTE *vertexPtr, CKDWORD vStride,
+                                    VxCompressedVector *normalPtr) {
+    const int count = CountBelow(m_PairVertices.Begin(), m_PairVertices.Size(), vertexCount);
+    if (count == 0)
+        return 0;
+
+    const CKMorphLerpFunc lerp = GetMorphLerpFunc();
+    const int *vertices = m_PairVertices.Begin();
+    m_Blended.Resize(count * 3);
+    float *blended = m_Blended.Begin();
+
+    if (vertexPtr) {
+        lerp(m_FromPositions.Begin(), m_DeltaPositions.Begin(), factor, blended, count * 3);
+        for (int p = 0; p < count; ++p)
+            memcpy(vertexPtr + vertices[p] * vStride, &blended[p * 3], sizeof(VxVector));
+    }
+
+    if (normalPtr && m_HasNormals) {
+        lerp(m_FromNormals.Begin(), m_DeltaNormals.Begin(), factor, blended, count * 2);
+        for (int p = 0; p < count; ++p) {
+            VxCompressedVector &n = normalPtr[vertices[p]];
+            n.xa = (short) (int) blended[p * 2];
+            n.ya = (short) (int) blended[p * 2 + 1];
+        }
+    }
+    return count;
+}
+
+int CKMorphDeltaTable::RestoreKey(const CKMorphKey *keys, int key, int vertexCount, CKBYTE *vertexPtr, CKDWORD vStride,
+                                  VxCompressedVector *normalPtr) const {
+    int count;
+    const int *vertices = GetKeyVertices(key, count);
+    count = CountBelow(vertices, count, vertexCount);
+
+    const CKMorphKey &base = keys[0];
+    for (int i = 0; i < count; ++i) {
+        const int v = vertices[i];
+        if (vertexPtr)
+            memcpy(vertexPtr + v * vStride, &base.PosArray[v], sizeof(VxVector));
+        if (normalPtr && m_HasNormals)
+            normalPtr[v] = base.NormArray[v];
+    }
+    return count;
+}
+
+// =====================================================
+// Lerp kernels
+// =====================================================
+
+void MorphLerpGenericFunc(const float *from, const float *delta, float factor, float *out, int count) {
+    for (int i = 0; i < count; ++i)
+        out[i] = from[i] + delta[i] * factor;
+}
+
+CKMorphLerpFunc GetMorphLerpFunc() {
+    switch (GetMeshSIMDLevel()) {
+    case CK_MESHSIMD_AVX2:
+        return MorphLerpAVX2Func;
+    case CK_MESHSIMD_SSE2:
+        return MorphLerpSSE2Func;
+    default:
+        return MorphLerpGenericFunc;
+    }
+}
+
+#ifdef CKMORPH_SIMD_X86
+
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define CKMORPH_TARGET_SSE2
+#define CKMORPH_TARGET_AVX2
+#else
+#define CKMORPH_TARGET_SSE2 __attribute__((target("sse2")))
+#define CKMORPH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+CKMORPH_TARGET_SSE2
+void MorphLerpSSE2Func(const float *from, const float *delta, float factor, float *out, int count) {
+    const __m128 f = _mm_set1_ps(factor);
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(from + i), _mm_mul_ps(_mm_loadu_ps(delta + i), f)));
+    for (; i < count; ++i)
+        out[i] = from[i] + delta[i] * factor;
+}
+
+CKMORPH_TARGET_AVX2
+void MorphLerpAVX2Func(const float *from, const float *delta, float factor, float *out, int count) {
+    const __m256 f = _mm256_set1_ps(factor);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256 a = _mm256_add_ps(_mm256_loadu_ps(from + i), _mm256_mul_ps(_mm256_loadu_ps(delta + i), f));
+        const __m256 b =
+            _mm256_add_ps(_mm256_loadu_ps(from + i + 8), _mm256_mul_ps(_mm256_loadu_ps(delta + i + 8), f));
+        _mm256_storeu_ps(out + i, a);
+        _mm256_storeu_ps(out + i + 8, b);
+    }
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(from + i), _mm256_mul_ps(_mm256_loadu_ps(delta + i), f)));
+    for (; i < count; ++i)
+        out[i] = from[i] + delta[i] * factor;
+}
+
+#else // CKMORPH_SIMD_X86
+
+// Other architectures only have the generic version
+void MorphLerpSSE2Func(const float *from, const float *delta, float factor, float *out, int count) {
+    MorphLerpGenericFunc(from, delta, factor, out, count);
+}
+
+void MorphLerpAVX2Func(const float *from, const float *delta, float factor, float *out, int count) {
+    MorphLerpGenericFunc(from, delta, factor, out, count);
+}
+
+#endif // CKMORPH_SIMD_X86
@@ -27,7 +27,9 @@ RCKObjectAnimation::RCKObjectAnimation(CKContext *Context, CKSTRING name)
       m_Anim1(nullptr),
       m_Anim2(nullptr),
       m_field_38(0),
-      m_ParentKeyedAnimation(nullptr) {
+      m_ParentKeyedAnimation(nullptr),
+      m_MorphMesh(nullptr),
+      m_MorphMeshStamp(0) {
     // Allocate and initialize keyframe data
     m_KeyframeData = new CKKeyframeData();
     if (m_KeyframeData) {
@@ -506,6 +508,10 @@ CKERROR RCKObjectAnimation::Load(CKStateChunk *chunk, CKFile *file) {
                     delete[] tmp;
                 }
             }
+
+            // The normals were written through GetKey
+            if (m_KeyframeData && m_KeyframeData->m_MorphController)
+                reinterpret_cast<RCKMorphController *>(m_KeyframeData->m_MorphController)->KeysChanged();
         }
     } else {
         // Very old format (data version < 1)
@@ -1261,12 +1267,10 @@ CKBOOL RCKObjectAnimation::HasMorphNormalInfo() {
 
     // Direct check: controller exists, has keys, and first key has normal data
     if (m_KeyframeData && m_KeyframeData->m_MorphController) {
-        CKMorphController *ctrl = m_KeyframeData->m_MorphController;
-        if (ctrl->GetKeyCount() > 0) {
-            CKMorphKey *key = static_cast<CKMorphKey *>(ctrl->GetKey(0));
-            if (key && key->NormArray)
-                return TRUE;
-        }
+        RCKMorphController *ctrl = reinterpret_cast<RCKMorphController *>(m_KeyframeData->m_MorphController);
+        const CKMorphKey *key = ctrl->GetMorphKey(0);
+        if (key && key->NormArray)
+            return TRUE;
     }
     return FALSE;
 }
@@ -1714,50 +1718,59 @@ CKERROR RCKObjectAnimation::SetStep(float step, CKKeyedAnimation *anim) {
     // Apply transforms to entity
     if (transformFlags) {
         VxMatrix localMatrix = m_Entity->GetLocalMatrix();
+        ComposeLocalMatrix(localMatrix, transformFlags, pos, rot, scale);
+        m_Entity->SetLocalMatrix(localMatrix);
 
-        if (transformFlags == 4) {
-            // Only position - just set position component of local matrix
-            localMatrix[3][0] = pos.x;
-            localMatrix[3][1] = pos.y;
-            localMatrix[3][2] = pos.z;
-        } else {
-            // Need to decompose current matrix to fill missing components
-            if ((transformFlags & 0xF) != 0xF) {
-                VxQuaternion tempRot;
-                VxVector tempPos, tempScale;
-                Vx3DDecomposeMatrix(localMatrix, tempRot, tempPos, tempScale);
-                if (!(transformFlags & 8)) rot = tempRot;
-                if (!(transformFlags & 4)) pos = tempPos;
-                if (!(transformFlags & 1)) scale = tempScale;
-            }
-
-            // Build matrix from quaternion rotation and components
-            VxMatrix rotMatrix;
-            rot.ToMatrix(rotMatrix);
+        // Notify matrix change if not driven by character animation
+        if (!anim || !anim->GetCharacter())
+            m_Entity->LocalMatrixChanged(FALSE, FALSE);
+    }
 
-            // Apply scale
-            VxMatrix scaleMatrix;
-            Vx3DMatrixIdentity(scaleMatrix);
-            scaleMatrix[0][0] = scale.x;
-            scaleMatrix[1][1] = scale.y;
-            scaleMatrix[2][2] = scale.z;
+    ApplyMorphTarget(frame);
 
-            // Combine: result = scale * rotation
-            Vx3DMultiplyMatrix(localMatrix, scaleMatrix, rotMatrix);
+    return CK_OK;
+}
 
-            // Set position
-            localMatrix[3][0] = pos.x;
-            localMatrix[3][1] = pos.y;
-            localMatrix[3][2] = pos.z;
+void RCKObjectAnimation::ComposeLocalMatrix(VxMatrix &localMatrix, CKDWORD transformFlags, VxVector pos,
+                                            VxQuaternion rot, VxVector scale) {
+    if (transformFlags == 4) {
+        // Only position - just set position component of local matrix
+        localMatrix[3][0] = pos.x;
+        localMatrix[3][1] = pos.y;
+        localMatrix[3][2] = pos.z;
+    } else {
+        // Need to decompose current matrix to fill missing components
+        if ((transformFlags & 0xF) != 0xF) {
+            VxQuaternion tempRot;
+            VxVector tempPos, tempScale;
+            Vx3DDecomposeMatrix(localMatrix, tempRot, tempPos, tempScale);
+            if (!(transformFlags & 8)) rot = tempRot;
+            if (!(transformFlags & 4)) pos = tempPos;
+            if (!(transformFlags & 1)) scale = tempScale;
         }
 
-        m_Entity->SetLocalMatrix(localMatrix);
+        // Build matrix from quaternion rotation and components
+        VxMatrix rotMatrix;
+        rot.ToMatrix(rotMatrix);
 
-        // Notify matrix change if not driven by character animation
-        if (!anim || !anim->GetCharacter())
-            m_Entity->LocalMatrixChanged(FALSE, FALSE);
+        // Apply scale
+        VxMatrix scaleMatrix;
+        Vx3DMatrixIdentity(scaleMatrix);
+        scaleMatrix[0][0] = scale.x;
+        scaleMatrix[1][1] = scale.y;
+        scaleMatrix[2][2] = scale.z;
+
+        // Combine: result = scale * rotation
+        Vx3DMultiplyMatrix(localMatrix, scaleMatrix, rotMatrix);
+
+        // Set position
+        localMatrix[3][0] = pos.x;
+        localMatrix[3][1] = pos.y;
+        localMatrix[3][2] = pos.z;
     }
+}
 
+void RCKObjectAnimation::ApplyMorphTarget(float frame) {
     // Morph animation processing
     // Based on IDA decompilation at 0x100578CA (lines 130-182)
     if (HasMorphInfo()) {
@@ -1789,33 +1802,62 @@ CKERROR RCKObjectAnimation::SetStep(float step, CKKeyedAnimation *anim) {
                     CKDWORD vertexStride = 0;
                     CKBYTE *vertices = currentMesh->GetModifierVertices(&vertexStride);
 
-                    // Evaluate morph target into mesh vertices
-                    EvaluateMorphTarget(frame, meshVertexCount, (VxVector *) vertices, vertexStride, normalBuffer);
+                    // A plain morph controller only rewrites the vertices that
+                    // change when the mesh still holds its previous result
+                    int movedCount = -1;
+                    RCKMorphController *ctrl = nullptr;
+                    if (!IsMerged() && !(m_Flags & CK_OBJECTANIMATION_IGNOREMORPH) && m_KeyframeData)
+                        ctrl = reinterpret_cast<RCKMorphController *>(m_KeyframeData->m_MorphController);
+                    if (ctrl) {
+                        if (currentMesh != m_MorphMesh || currentMesh->GetGeometryStamp() != m_MorphMeshStamp)
+                            m_MorphState.Invalidate();
+                        movedCount = ctrl->EvaluateChanges(frame, meshVertexCount, vertices, vertexStride, normalBuffer,
+                                                           m_MorphState, m_MorphMoved);
+                    } else {
+                        // Evaluate morph target into mesh vertices
+                        m_MorphState.Invalidate();
+                        EvaluateMorphTarget(frame, meshVertexCount, (VxVector *) vertices, vertexStride, normalBuffer);
+                    }
 
-                    // Copy normals if we have normal info
-                    if (hasNormalInfo) {
-                        CKDWORD normalStride = 0;
-                        VxVector *normals = (VxVector *) currentMesh->GetNormalsPtr(&normalStride);
-                        if (normals && normalBuffer) {
-                            for (int i = 0; i < meshVertexCount; i++) {
-                                // Decompress the compressed normal into full normal
-                                // Use operator= for conversion from compressed to full vector
-                                *normals = normalBuffer[i];
-                                normals = (VxVector *) ((CKBYTE *) normals + normalStride);
+                    if (movedCount < 0) {
+                        // Copy normals if we have normal info
+                        if (hasNormalInfo) {
+                            CKDWORD normalStride = 0;
+                            VxVector *normals = (VxVector *) currentMesh->GetNormalsPtr(&normalStride);
+                            if (normals && normalBuffer) {
+                                for (int i = 0; i < meshVertexCount; i++) {
+                                    // Decompress the compressed normal into full normal
+                                    // Use operator= for conversion from compressed to full vector
+                                    *normals = normalBuffer[i];
+                                    normals = (VxVector *) ((CKBYTE *) normals + normalStride);
+                                }
                             }
+                            // Notify mesh of vertex movement, don't rebuild normals since we provided them
+                            currentMesh->ModifierVertexMove(FALSE, TRUE);
+                        } else {
+                            // Notify mesh of vertex movement, rebuild normals automatically
+                            currentMesh->ModifierVertexMove(TRUE, TRUE);
+                        }
+                    } else if (movedCount > 0) {
+                        const int *moved = m_MorphMoved.Begin();
+                        if (hasNormalInfo) {
+                            CKDWORD normalStride = 0;
+                            CKBYTE *normals = (CKBYTE *) currentMesh->GetNormalsPtr(&normalStride);
+                            if (normals && normalBuffer) {
+                                for (int i = 0; i < movedCount; i++)
+                                    *(VxVector *) (normals + moved[i] * normalStride) = normalBuffer[moved[i]];
+                            }
+                            currentMesh->ModifierVerticesMoved(moved, movedCount, FALSE, TRUE);
+                        } else {
+                            currentMesh->ModifierVerticesMoved(moved, movedCount, TRUE, TRUE);
                         }
-                        // Notify mesh of vertex movement, don't rebuild normals since we provided them
-                        currentMesh->ModifierVertexMove(FALSE, TRUE);
-                    } else {
-                        // Notify mesh of vertex movement, rebuild normals automatically
-                        currentMesh->ModifierVertexMove(TRUE, TRUE);
                     }
+                    m_MorphMesh = currentMesh;
+                    m_MorphMeshStamp = currentMesh->GetGeometryStamp();
                 }
             }
         }
     }
-
-    return CK_OK;
 }
 
 // Based on IDA decompilation at 0x10058042
@@ -2144,6 +2186,7 @@ void RCKObjectAnimation::CreateTransition(float length, CKObjectAnimation *AnimI
                 animOut->EvaluateMorphTarget(frameTo, outMorphVertexCount,
                                              endKey->PosArray, sizeof(VxVector), endKey->NormArray);
             }
+            morphCtrl->KeysChanged();
         }
     } else {
         // AnimOut has no morph info, clear morph controller
@@ -0,0 +1,326 @@
+#include "CKOcclusionBuffer.h"
+
+#include "RCKMesh.h"
+
+#include <math.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CKOCCLUSION_SIMD_X86 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#define CKOCCLUSION_TARGET_SSE2
+#else
+#define CKOCCLUSION_TARGET_SSE2 __attribute__((target("sse2")))
+#endif
+#endif
+
+namespace {
+
+// A box must be this much farther (relative 1 / w) than the occluders to be
+// hidden: an occluder face lying on its own box does not hide the box.
+const float kDepthBias = 1.0e-5f;
+
+// Values of a row: Base + (x - xBegin) * Step at column x
+struct RowSetup {
+    float EdgeBase[3];
+    float EdgeStep[3];
+    float DepthBase;
+    float DepthStep;
+    float DepthMin;
+    float DepthMax;
+};
+
+void RasterRowGeneric(float *row, int xBegin, int xEnd, const RowSetup &setup) {
+    for (int x = xBegin; x < xEnd; ++x) {
+        const float offset = (float) (x - xBegin);
+        const float e0 = setup.EdgeBase[0] + offset * setup.EdgeStep[0];
+        const float e1 = setup.EdgeBase[1] + offset * setup.EdgeStep[1];
+        const float e2 = setup.EdgeBase[2] + offset * setup.EdgeStep[2];
+        if (e0 < 0.0f || e1 < 0.0f || e2 < 0.0f)
+            continue;
+        float q = setup.DepthBase + offset * setup.DepthStep;
+        q = XMax(setup.DepthMin, XMin(setup.DepthMax, q));
+        if (q > row[x])
+            row[x] = q;
+    }
+}
+
+// TRUE when a pixel of [x0, x1] is not nearer than limit
+CKBOOL HasVisiblePixelGeneric(const float *row, int x0, int x1, float limit) {
+    for (int x = x0; x <= x1; ++x) {
+        if (row[x] <= limit)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+#ifdef CKOCCLUSION_SIMD_X86
+
+CKOCCLUSION_TARGET_SSE2 void RasterRowSSE2(float *row, int xBegin, int xEnd, const RowSetup &setup) {
+    const __m128 e0Step = _mm_set1_ps(setup.EdgeStep[0]);
+    const __m128 e1Step = _mm_set1_ps(setup.EdgeStep[1]);
+    const __m128 e2Step = _mm_set1_ps(setup.EdgeStep[2]);
+    const __m128 e0Base = _mm_set1_ps(setup.EdgeBase[0]);
+    const __m128 e1Base = _mm_set1_ps(setup.EdgeBase[1]);
+    const __m128 e2Base = _mm_set1_ps(setup.EdgeBase[2]);
+    const __m128 qStep = _mm_set1_ps(setup.DepthStep);
+    const __m128 qBase = _mm_set1_ps(setup.DepthBase);
+    const __m128 qMin = _mm_set1_ps(setup.DepthMin);
+    const __m128 qMax = _mm_set1_ps(setup.DepthMax);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 four = _mm_set1_ps(4.0f);
+
+    // xBegin and xEnd are multiples of 4 in the padded row
+    __m128 offset = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    for (int x = xBegin; x < xEnd; x += 4) {
+        const __m128 e0 = _mm_add_ps(e0Base, _mm_mul_ps(offset, e0Step));
+        const __m128 e1 = _mm_add_ps(e1Base, _mm_mul_ps(offset, e1Step));
+        const __m128 e2 = _mm_add_ps(e2Base, _mm_mul_ps(offset, e2Step));
+        const __m128 inside =
+            _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+        if (_mm_movemask_ps(inside)) {
+            __m128 q = _mm_add_ps(qBase, _mm_mul_ps(offset, qStep));
+            q = _mm_max_ps(qMin, _mm_min_ps(qMax, q));
+            const __m128 old = _mm_loadu_ps(row + x);
+            const __m128 nearest = _mm_max_ps(old, q);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+        }
+        offset = _mm_add_ps(offset, four);
+    }
+}
+
+CKOCCLUSION_TARGET_SSE2 CKBOOL HasVisiblePixelSSE2(const float *row, int x0, int x1, float limit) {
+    const __m128 limits = _mm_set1_ps(limit);
+    int x = x0;
+    for (; x + 4 <= x1 + 1; x += 4) {
+        if (_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(row + x), limits)))
+            return TRUE;
+    }
+    return HasVisiblePixelGeneric(row, x, x1, limit);
+}
+
+#endif // CKOCCLUSION_SIMD_X86
+
+void RasterRow(float *row, int xBegin, int xEnd, const RowSetup &setup) {
+#ifdef CKOCCLUSION_SIMD_X86
+    if (GetMeshSIMDLevel() >= CK_MESHSIMD_SSE2) {
+        RasterRowSSE2(row, xBegin, xEnd, setup);
+        return;
+    }
+#endif
+    RasterRowGeneric(row, xBegin, xEnd, setup);
+}
+
+CKBOOL HasVisiblePixel(const float *row, int x0, int x1, float limit) {
+#ifdef CKOCCLUSION_SIMD_X86
+    if (GetMeshSIMDLevel() >= CK_MESHSIMD_SSE2)
+        return HasVisiblePixelSSE2(row, x0, x1, limit);
+#endif
+    return HasVisiblePixelGeneric(row, x0, x1, limit);
+}
+
+// Clip space position of a world space point (row vector convention)
+void Project(const VxMatrix &mat, const VxVector &v, VxVector4 &out) {
+    out.x = v.x * mat[0][0] + v.y * mat[1][0] + v.z * mat[2][0] + mat[3][0];
+    out.y = v.x * mat[0][1] + v.y * mat[1][1] + v.z * mat[2][1] + mat[3][1];
+    out.z = v.x * mat[0][2] + v.y * mat[1][2] + v.z * mat[2][2] + mat[3][2];
+    out.w = v.x * mat[0][3] + v.y * mat[1][3] + v.z * mat[2][3] + mat[3][3];
+}
+
+VxVector4 LerpClip(const VxVector4 &a, const VxVector4 &b, float t) {
+    VxVector4 r;
+    r.x = a.x + (b.x - a.x) * t;
+    r.y = a.y + (b.y - a.y) * t;
+    r.z = a.z + (b.z - a.z) * t;
+    r.w = a.w + (b.w - a.w) * t;
+    return r;
+}
+
+} // namespace
+
+CKOcclusionBuffer::CKOcclusionBuffer()
+    : m_Width(0), m_Height(0), m_Pitch(0), m_OccluderTriangleCount(0), m_TestedBoxCount(0), m_OccludedBoxCount(0) {
+    Vx3DMatrixIdentity(m_ViewProj);
+}
+
+void CKOcclusionBuffer::Begin(int width, int height, const VxMatrix &viewProj) {
+    m_Width = (width > 0) ? width : 0;
+    m_Height = (height > 0) ? height : 0;
+    m_Pitch = (m_Width + 3) & ~3;
+    m_ViewProj = viewProj;
+    m_Depth.Resize(m_Pitch * m_Height);
+    m_Depth.Memset(0);
+    m_OccluderTriangleCount = 0;
+    m_TestedBoxCount = 0;
+    m_OccludedBoxCount = 0;
+}
+
+void CKOcclusionBuffer::AddOccluder(const VxMatrix &world, const CKBYTE *positions, CKDWORD stride, int vertexCount,
+                                    const CKWORD *indices, int indexCount) {
+    AddTriangles(world, positions, stride, vertexCount, indices, indexCount);
+}
+
+void CKOcclusionBuffer::AddOccluder(const VxMatrix &world, const CKBYTE *positions, CKDWORD stride, int vertexCount,
+                                    const CKDWORD *indices, int indexCount) {
+    AddTriangles(world, positions, stride, vertexCount, indices, indexCount);
+}
+
+template <class IndexType>
+void CKOcclusionBuffer::AddTriangles(const VxMatrix &world, const CKBYTE *positions, CKDWORD stride,
+                                     int vertexCount, const IndexType *indices, int indexCount) {
+    if (!positions || !indices || vertexCount <= 0 || m_Depth.Size() == 0)
+        return;
+
+    VxMatrix mat;
+    Vx3DMultiplyMatrix4(mat, m_ViewProj, world);
+    m_Projected.Resize(vertexCount);
+    for (int v = 0; v < vertexCount; ++v)
+        Project(mat, *(const VxVector *) (positions + v * stride), m_Projected[v]);
+
+    for (int i = 0; i + 2 < indexCount; i += 3) {
+        const CKDWORD i0 = (CKDWORD) indices[i];
+        const CKDWORD i1 = (CKDWORD) indices[i + 1];
+        const CKDWORD i2 = (CKDWORD) indices[i + 2];
+        if (i0 >= (CKDWORD) vertexCount || i1 >= (CKDWORD) vertexCount || i2 >= (CKDWORD) vertexCount)
+            continue;
+        const VxVector4 clip[3] = {m_Projected[i0], m_Projected[i1], m_Projected[i2]};
+        ClipTriangle(clip);
+    }
+}
+
+void CKOcclusionBuffer::ClipTriangle(const VxVector4 *clip) {
+    // Near plane z >= 0: one triangle, or two when a single vertex is behind
+    VxVector4 polygon[4];
+    int count = 0;
+    for (int i = 0; i < 3; ++i) {
+        const VxVector4 &a = clip[i];
+        const VxVector4 &b = clip[(i + 1) % 3];
+        if (a.z >= 0.0f)
+            polygon[count++] = a;
+        if ((a.z >= 0.0f) != (b.z >= 0.0f))
+            polygon[count++] = LerpClip(a, b, a.z / (a.z - b.z));
+    }
+    for (int i = 1; i + 1 < count; ++i)
+        RasterizeTriangle(polygon[0], polygon[i], polygon[i + 1]);
+}
+
+void CKOcclusionBuffer::RasterizeTriangle(const VxVector4 &a, const VxVector4 &b, const VxVector4 &c) {
+    if (a.w <= 0.0f || b.w <= 0.0f || c.w <= 0.0f)
+        return;
+
+    // Pixel coordinates, y down, and 1 / w
+    const VxVector4 *clip[3] = {&a, &b, &c};
+    float sx[3], sy[3], q[3];
+    for (int i = 0; i < 3; ++i) {
+        q[i] = 1.0f / clip[i]->w;
+        sx[i] = (clip[i]->x * q[i] * 0.5f + 0.5f) * (float) m_Width;
+        sy[i] = (0.5f - clip[i]->y * q[i] * 0.5f) * (float) m_Height;
+    }
+
+    float area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sx[2] - sx[0]) * (sy[1] - sy[0]);
+    if (area == 0.0f || area != area)
+        return;
+    if (area < 0.0f) {
+        // Both windings occlude: reorder to a positive area
+        float t = sx[1]; sx[1] = sx[2]; sx[2] = t;
+        t = sy[1]; sy[1] = sy[2]; sy[2] = t;
+        t = q[1]; q[1] = q[2]; q[2] = t;
+        area = -area;
+    }
+
+    // Pixel centers x + 0.5 inside the bounds of the triangle
+    const float minX = XMin(sx[0], XMin(sx[1], sx[2]));
+    const float maxX = XMax(sx[0], XMax(sx[1], sx[2]));
+    const float minY = XMin(sy[0], XMin(sy[1], sy[2]));
+    const float maxY = XMax(sy[0], XMax(sy[1], sy[2]));
+    if (maxX < 0.0f || maxY < 0.0f || minX > (float) m_Width || minY > (float) m_Height)
+        return;
+    const int x0 = (int) ceilf(XMax(minX, 0.0f) - 0.5f);
+    const int x1 = XMin((int) floorf(XMin(maxX, (float) m_Width) - 0.5f), m_Width - 1);
+    const int y0 = (int) ceilf(XMax(minY, 0.0f) - 0.5f);
+    const int y1 = XMin((int) floorf(XMin(maxY, (float) m_Height) - 0.5f), m_Height - 1);
+    if (x0 > x1 || y0 > y1)
+        return;
+
+    ++m_OccluderTriangleCount;
+
+    // Edge i goes from vertex i to vertex i + 1 and is >= 0 inside
+    RowSetup setup;
+    const int xBegin = x0 & ~3;
+    const int xEnd = (x1 + 4) & ~3;
+    const float px = (float) xBegin + 0.5f;
+    float edgeY[3];
+    float edgeRowBase[3];
+    for (int e = 0; e < 3; ++e) {
+        const int n = (e + 1) % 3;
+        const float dx = sx[n] - sx[e];
+        const float dy = sy[n] - sy[e];
+        setup.EdgeStep[e] = -dy;
+        edgeY[e] = dx;
+        edgeRowBase[e] = dx * (0.5f - sy[e]) - dy * (px - sx[e]);
+    }
+
+    const float invArea = 1.0f / area;
+    const float dqdx = ((q[1] - q[0]) * (sy[2] - sy[0]) - (q[2] - q[0]) * (sy[1] - sy[0])) * invArea;
+    const float dqdy = ((q[2] - q[0]) * (sx[1] - sx[0]) - (q[1] - q[0]) * (sx[2] - sx[0])) * invArea;
+    setup.DepthStep = dqdx;
+    setup.DepthMin = XMin(q[0], XMin(q[1], q[2]));
+    setup.DepthMax = XMax(q[0], XMax(q[1], q[2]));
+    const float qRowBase = q[0] + dqdx * (px - sx[0]) + dqdy * (0.5f - sy[0]);
+
+    for (int y = y0; y <= y1; ++y) {
+        const float fy = (float) y;
+        for (int e = 0; e < 3; ++e)
+            setup.EdgeBase[e] = edgeRowBase[e] + fy * edgeY[e];
+        setup.DepthBase = qRowBase + fy * dqdy;
+        RasterRow(m_Depth.Begin() + y * m_Pitch, xBegin, xEnd, setup);
+    }
+}
+
+CKBOOL CKOcclusionBuffer::IsBoxOccluded(const VxBbox &box) {
+    if (m_Depth.Size() == 0)
+        return FALSE;
+    ++m_TestedBoxCount;
+
+    float minX = 0.0f, maxX = 0.0f, minY = 0.0f, maxY = 0.0f, nearest = 0.0f;
+    for (int i = 0; i < 8; ++i) {
+        const VxVector corner((i & 1) ? box.Max.x : box.Min.x, (i & 2) ? box.Max.y : box.Min.y,
+                              (i & 4) ? box.Max.z : box.Min.z);
+        VxVector4 clip;
+        Project(m_ViewProj, corner, clip);
+        if (clip.z < 0.0f || clip.w <= 0.0f)
+            return FALSE;
+
+        const float q = 1.0f / clip.w;
+        const float x = (clip.x * q * 0.5f + 0.5f) * (float) m_Width;
+        const float y = (0.5f - clip.y * q * 0.5f) * (float) m_Height;
+        if (i == 0) {
+            minX = maxX = x;
+            minY = maxY = y;
+            nearest = q;
+        } else {
+            minX = XMin(minX, x);
+            maxX = XMax(maxX, x);
+            minY = XMin(minY, y);
+            maxY = XMax(maxY, y);
+            nearest = XMax(nearest, q);
+        }
+    }
+
+    // Every pixel the box rectangle touches, clamped to the buffer
+    if (maxX < 0.0f || maxY < 0.0f || minX >= (float) m_Width || minY >= (float) m_Height)
+        return FALSE;
+    const int x0 = (int) XMax(minX, 0.0f);
+    const int x1 = XMin((int) XMin(maxX, (float) m_Width), m_Width - 1);
+    const int y0 = (int) XMax(minY, 0.0f);
+    const int y1 = XMin((int) XMin(maxY, (float) m_Height), m_Height - 1);
+
+    const float limit = nearest * (1.0f + kDepthBias);
+    for (int y = y0; y <= y1; ++y) {
+        if (HasVisiblePixel(m_Depth.Begin() + y * m_Pitch, x0, x1, limit))
+            return FALSE;
+    }
+
+    ++m_OccludedBoxCount;
+    return TRUE;
+}
@@ -0,0 +1,155 @@
+#include "CKPickGrid.h"
+
+#include "RCKRenderContext.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+const int kMaxCellsPerAxis = 32;
+
+inline CKBOOL IsEmptyExtent(const VxRect &rect) {
+    return rect.left > rect.right || rect.top > rect.bottom;
+}
+
+int CompareCandidates(const void *a, const void *b) {
+    const CKPickCandidate *ca = (const CKPickCandidate *) a;
+    const CKPickCandidate *cb = (const CKPickCandidate *) b;
+    if (ca->Distance < cb->Distance)
+        return -1;
+    if (ca->Distance > cb->Distance)
+        return 1;
+    return ca->Index - cb->Index;
+}
+
+} // namespace
+
+CKPickGrid::CKPickGrid()
+    : m_Built(FALSE), m_CellsX(1), m_CellsY(1), m_InvCellWidth(0.0f), m_InvCellHeight(0.0f), m_QueryStamp(0) {}
+
+int CKPickGrid::CellX(float x) const {
+    const float cell = (x - m_Bounds.left) * m_InvCellWidth;
+    if (cell <= 0.0f)
+        return 0;
+    if (cell >= (float) (m_CellsX - 1))
+        return m_CellsX - 1;
+    return (int) cell;
+}
+
+int CKPickGrid::CellY(float y) const {
+    const float cell = (y - m_Bounds.top) * m_InvCellHeight;
+    if (cell <= 0.0f)
+        return 0;
+    if (cell >= (float) (m_CellsY - 1))
+        return m_CellsY - 1;
+    return (int) cell;
+}
+
+void CKPickGrid::Build(const CKObjectExtents *extents, int count, const VxRect &bounds) {
+    m_Built = TRUE;
+    m_Bounds = bounds;
+    m_QueryStamps.Resize(count);
+    memset(m_QueryStamps.Begin(), 0, count * sizeof(CKDWORD));
+    m_QueryStamp = 0;
+
+    int validCount = 0;
+    for (int i = 0; i < count; ++i) {
+        if (extents[i].m_Entity && !IsEmptyExtent(extents[i].m_Rect))
+            ++validCount;
+    }
+
+    // About one extent per cell, as long as the viewport is not degenerate
+    int cells = 1;
+    while (cells < kMaxCellsPerAxis && cells * cells < validCount)
+        ++cells;
+    const float width = bounds.right - bounds.left;
+    const float height = bounds.bottom - bounds.top;
+    m_CellsX = width > 0.0f ? cells : 1;
+    m_CellsY = height > 0.0f ? cells : 1;
+    m_InvCellWidth = width > 0.0f ? (float) m_CellsX / width : 0.0f;
+    m_InvCellHeight = height > 0.0f ? (float) m_CellsY / height : 0.0f;
+
+    const int cellCount = m_CellsX * m_CellsY;
+    m_CellStart.Resize(cellCount + 1);
+    memset(m_CellStart.Begin(), 0, (cellCount + 1) * sizeof(int));
+
+    // Count the items of each cell in m_CellStart[cell + 1], then turn the
+    // counts into offsets and fill
+    for (int i = 0; i < count; ++i) {
+        const CKObjectExtents &ext = extents[i];
+        if (!ext.m_Entity || IsEmptyExtent(ext.m_Rect))
+            continue;
+        const int x0 = CellX(ext.m_Rect.left), x1 = CellX(ext.m_Rect.right);
+        const int y0 = CellY(ext.m_Rect.top), y1 = CellY(ext.m_Rect.bottom);
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+                ++m_CellStart[y * m_CellsX + x + 1];
+    }
+    for (int c = 0; c < cellCount; ++c)
+        m_CellStart[c + 1] += m_CellStart[c];
+
+    m_CellItems.Resize(m_CellStart[cellCount]);
+    XArray<int> fill;
+    fill.Resize(cellCount);
+    memcpy(fill.Begin(), m_CellStart.Begin(), cellCount * sizeof(int));
+    for (int i = 0; i < count; ++i) {
+        const CKObjectExtents &ext = extents[i];
+        if (!ext.m_Entity || IsEmptyExtent(ext.m_Rect))
+            continue;
+        const int x0 = CellX(ext.m_Rect.left), x1 = CellX(ext.m_Rect.right);
+        const int y0 = CellY(ext.m_Rect.top), y1 = CellY(ext.m_Rect.bottom);
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+                m_CellItems[fill[y * m_CellsX + x]++] = i;
+    }
+}
+
+void CKPickGrid::QueryPoint(const CKObjectExtents *extents, const Vx2DVector &pt, XArray<int> &indices) const {
+    if (!m_Built)
+        return;
+
+    // A point lies in a single cell, so no index can come up twice
+    const int cell = CellY(pt.y) * m_CellsX + CellX(pt.x);
+    for (int i = m_CellStart[cell]; i < m_CellStart[cell + 1]; ++i) {
+        const int index = m_CellItems[i];
+        const VxRect &rect = extents[index].m_Rect;
+        if (pt.x > rect.right || pt.x < rect.left || pt.y > rect.bottom || pt.y < rect.top)
+            continue;
+        indices.PushBack(index);
+    }
+}
+
+void CKPickGrid::QueryRect(const CKObjectExtents *extents, const VxRect &rect, XArray<int> &indices) {
+    if (!m_Built)
+        return;
+
+    if (++m_QueryStamp == 0) {
+        memset(m_QueryStamps.Begin(), 0, m_QueryStamps.Size() * sizeof(CKDWORD));
+        m_QueryStamp = 1;
+    }
+
+    const int x0 = CellX(rect.left), x1 = CellX(rect.right);
+    const int y0 = CellY(rect.top), y1 = CellY(rect.bottom);
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            const int cell = y * m_CellsX + x;
+            for (int i = m_CellStart[cell]; i < m_CellStart[cell + 1]; ++i) {
+                const int index = m_CellItems[i];
+                if (m_QueryStamps[index] == m_QueryStamp)
+                    continue;
+                m_QueryStamps[index] = m_QueryStamp;
+
+                const VxRect &ext = extents[index].m_Rect;
+                if (ext.left > rect.right || ext.right < rect.left || ext.top > rect.bottom || ext.bottom < rect.top)
+                    continue;
+                indices.PushBack(index);
+            }
+        }
+    }
+}
+
+void CKPickGrid::SortFrontToBack(XArray<CKPickCandidate> &candidates) {
+    if (candidates.Size() > 1)
+        ::qsort(candidates.Begin(), candidates.Size(), sizeof(CKPickCandidate), CompareCandidates);
+}
@@ -0,0 +1,127 @@
+#include "CKPortalVisibility.h"
+
+#include "RCKPlace.h"
+
+namespace {
+
+// Longest chain of portals walked from the camera place
+const int kMaxPortalDepth = 32;
+
+CKBOOL IntersectRect(const VxRect &a, const VxRect &b, VxRect &out) {
+    out.left = XMax(a.left, b.left);
+    out.top = XMax(a.top, b.top);
+    out.right = XMin(a.right, b.right);
+    out.bottom = XMin(a.bottom, b.bottom);
+    return out.left < out.right && out.top < out.bottom;
+}
+
+CKBOOL ContainsRect(const VxRect &outer, const VxRect &inner) {
+    return outer.left <= inner.left && outer.top <= inner.top &&
+           outer.right >= inner.right && outer.bottom >= inner.bottom;
+}
+
+} // namespace
+
+CKPortalVisibility::CKPortalVisibility() : m_PortalTestCount(0) {
+    Vx3DMatrixIdentity(m_ViewProj);
+}
+
+void CKPortalVisibility::Clear() {
+    m_Places.Resize(0);
+    m_Rects.Resize(0);
+    m_PortalTestCount = 0;
+}
+
+void CKPortalVisibility::Compute(CKPlace *cameraPlace, const VxMatrix &viewProj) {
+    Clear();
+    m_ViewProj = viewProj;
+    if (cameraPlace)
+        Visit(cameraPlace, VxRect(0.0f, 0.0f, 1.0f, 1.0f), 0);
+}
+
+CKBOOL CKPortalVisibility::GetPlaceRect(CKPlace *place, VxRect &rect) const {
+    const int index = FindPlace(place);
+    if (index < 0)
+        return FALSE;
+    rect = m_Rects[index];
+    return TRUE;
+}
+
+int CKPortalVisibility::FindPlace(CKPlace *place) const {
+    for (int i = 0; i < m_Places.Size(); ++i) {
+        if (m_Places[i] == place)
+            return i;
+    }
+    return -1;
+}
+
+void CKPortalVisibility::Visit(CKPlace *place, const VxRect &rect, int depth) {
+    // A place is walked again only when it is seen through a rectangle its
+    // current one does not contain, so cycles of portals end
+    const int index = FindPlace(place);
+    if (index < 0) {
+        m_Places.PushBack(place);
+        m_Rects.PushBack(rect);
+    } else {
+        VxRect &merged = m_Rects[index];
+        if (ContainsRect(merged, rect))
+            return;
+        merged.left = XMin(merged.left, rect.left);
+        merged.top = XMin(merged.top, rect.top);
+        merged.right = XMax(merged.right, rect.right);
+        merged.bottom = XMax(merged.bottom, rect.bottom);
+    }
+    if (depth >= kMaxPortalDepth)
+        return;
+
+    RCKPlace *rplace = (RCKPlace *) place;
+    const int portalCount = rplace->GetPortalCount();
+    for (int i = 0; i < portalCount; ++i) {
+        CK3dEntity *portal = nullptr;
+        CKPlace *next = rplace->GetPortal(i, &portal);
+        if (!next)
+            continue;
+        VxRect seen;
+        if (ProjectPortal(portal, rect, seen))
+            Visit(next, seen, depth + 1);
+    }
+}
+
+CKBOOL CKPortalVisibility::ProjectPortal(CK3dEntity *portal, const VxRect &clip, VxRect &rect) {
+    if (!portal) {
+        rect = clip;
+        return TRUE;
+    }
+    ++m_PortalTestCount;
+
+    const VxBbox &box = ((RCK3dEntity *) portal)->GetBoundingBox(FALSE);
+    VxRect projected(1.0f, 1.0f, 0.0f, 0.0f);
+    int behind = 0;
+    for (int i = 0; i < 8; ++i) {
+        const VxVector v((i & 1) ? box.Max.x : box.Min.x, (i & 2) ? box.Max.y : box.Min.y,
+                         (i & 4) ? box.Max.z : box.Min.z);
+        const float x = v.x * m_ViewProj[0][0] + v.y * m_ViewProj[1][0] + v.z * m_ViewProj[2][0] + m_ViewProj[3][0];
+        const float y = v.x * m_ViewProj[0][1] + v.y * m_ViewProj[1][1] + v.z * m_ViewProj[2][1] + m_ViewProj[3][1];
+        const float z = v.x * m_ViewProj[0][2] + v.y * m_ViewProj[1][2] + v.z * m_ViewProj[2][2] + m_ViewProj[3][2];
+        const float w = v.x * m_ViewProj[0][3] + v.y * m_ViewProj[1][3] + v.z * m_ViewProj[2][3] + m_ViewProj[3][3];
+        if (z < 0.0f || w <= 0.0f) {
+            ++behind;
+            continue;
+        }
+        const float sx = x / w * 0.5f + 0.5f;
+        const float sy = 0.5f - y / w * 0.5f;
+        projected.left = XMin(projected.left, sx);
+        projected.top = XMin(projected.top, sy);
+        projected.right = XMax(projected.right, sx);
+        projected.bottom = XMax(projected.bottom, sy);
+    }
+
+    if (behind == 8)
+        return FALSE;
+    if (behind > 0) {
+        // The camera stands in the portal: it does not narrow the view
+        rect = clip;
+        return TRUE;
+    }
+    return IntersectRect(clip, projected, rect);
+}
@@ -0,0 +1,73 @@
+#include "CKNullRasterizer.h"
+
+#ifdef CK_LIB
+#define CKRasterizerGetInfo CKNullRasterizerGetInfo
+#endif
+
+CKRasterizer *CKNullRasterizerStart(WIN_HANDLE AppWnd)
+{
+    CKRasterizer *rasterizer = new CKNullRasterizer;
+    if (!rasterizer)
+        return NULL;
+
+    if (!rasterizer->Start(AppWnd))
+    {
+        delete rasterizer;
+        return NULL;
+    }
+
+    return rasterizer;
+}
+
+void CKNullRasterizerClose(CKRasterizer *rst)
+{
+    if (rst)
+    {
+        rst->Close();
+        delete rst;
+    }
+}
+
+PLUGIN_EXPORT void CKRasterizerGetInfo(CKRasterizerInfo *info)
+{
+    info->StartFct = CKNullRasterizerStart;
+    info->CloseFct = CKNullRasterizerClose;
+    info->Desc = "Null Rasterizer";
+}
+
+CKNullRasterizer::CKNullRasterizer() : m_Init(FALSE) {}
+
+CKNullRasterizer::~CKNullRasterizer()
+{
+    Close();
+}
+
+CKBOOL CKNullRasterizer::Start(WIN_HANDLE AppWnd)
+{
+    m_MainWindow = AppWnd;
+
+    CKNullRasterizerDriver *driver = new CKNullRasterizerDriver(this);
+    if (!driver->InitializeCaps())
+    {
+        delete driver;
+        return FALSE;
+    }
+
+    m_Drivers.PushBack(driver);
+    m_Init = TRUE;
+    return TRUE;
+}
+
+void CKNullRasterizer::Close()
+{
+    if (!m_Init)
+        return;
+
+    while (m_Drivers.Size() != 0)
+    {
+        CKRasterizerDriver *driver = m_Drivers.PopBack();
+        delete driver;
+    }
+
+    m_Init = FALSE;
+}
@@ -0,0 +1,293 @@
+#ifndef CKRASTERIZERNULL_H
+#define CKRASTERIZERNULL_H
+
+#include "CKRasterizer.h"
+
+#define CKNULL_MAX_TEXTURESTAGES 8
+#define CKNULL_MAX_CLIPPLANES 6
+
+/*******************************************
+ Commands recorded by the NULL rasterizer.
+ The meaning of CKNullCommand::Args is given
+ for each command.
+*********************************************/
+typedef enum CKNULL_COMMANDTYPE
+{
+    CKNULL_CMD_RESIZE               = 0,  // Width, Height, Flags
+    CKNULL_CMD_CLEAR                = 1,  // Flags, Color, Stencil
+    CKNULL_CMD_BACKTOFRONT          = 2,  // Frame index
+    CKNULL_CMD_BEGINSCENE           = 3,  //
+    CKNULL_CMD_ENDSCENE             = 4,  //
+    CKNULL_CMD_SETLIGHT             = 5,  // Light index, Light type
+    CKNULL_CMD_ENABLELIGHT          = 6,  // Light index, Enable
+    CKNULL_CMD_SETMATERIAL          = 7,  //
+    CKNULL_CMD_SETVIEWPORT          = 8,  // Width, Height
+    CKNULL_CMD_SETTRANSFORM         = 9,  // VXMATRIX_TYPE
+    CKNULL_CMD_SETRENDERSTATE       = 10, // VXRENDERSTATETYPE, Value
+    CKNULL_CMD_SETTEXTURE           = 11, // Texture, Stage
+    CKNULL_CMD_SETTEXTURESTAGESTATE = 12, // Stage, CKRST_TEXTURESTAGESTATETYPE, Value
+    CKNULL_CMD_SETVERTEXSHADER      = 13, // Shader
+    CKNULL_CMD_SETPIXELSHADER       = 14, // Shader
+    CKNULL_CMD_SETVSCONSTANT        = 15, // Register, Constant count
+    CKNULL_CMD_SETPSCONSTANT        = 16, // Register, Constant count
+    CKNULL_CMD_DRAWPRIMITIVE        = 17, // VXPRIMITIVETYPE, Vertex count, Index count
+    CKNULL_CMD_DRAWPRIMITIVEVB      = 18, // VXPRIMITIVETYPE, Vertex buffer, Index count
+    CKNULL_CMD_DRAWPRIMITIVEVBIB    = 19, // VXPRIMITIVETYPE, Vertex buffer, Index buffer
+    CKNULL_CMD_CREATEOBJECT         = 20, // Object index, CKRST_OBJECTTYPE
+    CKNULL_CMD_DELETEOBJECT         = 21, // Object index, CKRST_OBJECTTYPE
+    CKNULL_CMD_LOADTEXTURE          = 22, // Texture, Mip level, Bytes
+    CKNULL_CMD_COPYTOTEXTURE        = 23, // Texture, CKRST_CUBEFACE
+    CKNULL_CMD_SETTARGETTEXTURE     = 24, // Texture, CKRST_CUBEFACE
+    CKNULL_CMD_DRAWSPRITE           = 25, // Sprite
+    CKNULL_CMD_LOCKVB               = 26, // Vertex buffer, Bytes, CKRST_LOCKFLAGS
+    CKNULL_CMD_UNLOCKVB             = 27, // Vertex buffer
+    CKNULL_CMD_LOCKIB               = 28, // Index buffer, Bytes, CKRST_LOCKFLAGS
+    CKNULL_CMD_UNLOCKIB             = 29, // Index buffer
+    CKNULL_CMD_SETCLIPPLANE         = 30, // Plane index
+    CKNULL_CMD_SETDRAWBUFFER        = 31, // CKRST_DRAWBUFFER_FLAGS
+} CKNULL_COMMANDTYPE;
+
+typedef struct CKNullCommand
+{
+    CKDWORD Type; // CKNULL_COMMANDTYPE
+    CKDWORD Args[3];
+} CKNullCommand;
+
+/*******************************************
+ Counters accumulated between two BackToFront
+*********************************************/
+typedef struct CKNullFrameStats
+{
+    int DrawCalls;             // DrawPrimitive, DrawPrimitiveVB, DrawPrimitiveVBIB and DrawSprite
+    int PrimitiveCount;        // Points, lines or triangles submitted
+    int VertexCount;           // Vertices referenced by draw calls
+    int IndexCount;            // Indices referenced by draw calls
+    int RenderStateChanges;    // SetRenderState calls that reached the device
+    int RedundantRenderStates; // SetRenderState calls filtered by the state cache
+    int TextureChanges;        // SetTexture calls that changed a stage binding
+    int TextureStageChanges;   // SetTextureStageState calls
+    int TransformChanges;      // SetTransformMatrix calls
+    int ShaderChanges;         // SetVertexShader and SetPixelShader calls
+    int BufferLocks;           // Vertex and index buffer locks
+    int ObjectsCreated;        // CreateObject calls
+    CKDWORD BytesUploaded;     // Buffer locks, system memory vertices/indices, textures and shader constants
+} CKNullFrameStats;
+
+/********************************************
+ Vertex and index buffers keep a system memory
+ copy so they can be locked and written to
+*************************************************/
+typedef struct CKNullVertexBufferDesc : public CKVertexBufferDesc
+{
+public:
+    CKBYTE *Data;
+
+public:
+    CKNullVertexBufferDesc() { Data = NULL; }
+    ~CKNullVertexBufferDesc() { delete[] Data; }
+} CKNullVertexBufferDesc;
+
+typedef struct CKNullIndexBufferDesc : public CKIndexBufferDesc
+{
+public:
+    CKWORD *Data;
+
+public:
+    CKNullIndexBufferDesc() { Data = NULL; }
+    ~CKNullIndexBufferDesc() { delete[] Data; }
+} CKNullIndexBufferDesc;
+
+class CKNullRasterizerDriver;
+class CKNullRasterizer;
+
+/*****************************************************************
+ CKNullRasterizerContext override
+
+ Does not render anything: every call is validated like a device
+ would, counted in the per-frame statistics and, when recording is
+ enabled, appended to a command stream. BackToFront closes a frame.
+******************************************************************/
+class CKNullRasterizerContext : public CKRasterizerContext
+{
+public:
+    //--- Construction/destruction
+    CKNullRasterizerContext(CKNullRasterizerDriver *driver);
+    virtual ~CKNullRasterizerContext();
+
+    //--- Creation
+    virtual CKBOOL Create(WIN_HANDLE Window, int PosX = 0, int PosY = 0, int Width = 0, int Height = 0, int Bpp = -1,
+                          CKBOOL Fullscreen = 0, int RefreshRate = 0, int Zbpp = -1, int StencilBpp = -1);
+    //---
+    virtual CKBOOL Resize(int PosX = 0, int PosY = 0, int Width = 0, int Height = 0, CKDWORD Flags = 0);
+    virtual CKBOOL Clear(CKDWORD Flags = CKRST_CTXCLEAR_ALL, CKDWORD Ccol = 0, float Z = 1.0f, CKDWORD Stencil = 0,
+                         int RectCount = 0, CKRECT *rects = NULL);
+    virtual CKBOOL BackToFront(CKBOOL vsync);
+
+    //--- Scene
+    virtual CKBOOL BeginScene();
+    virtual CKBOOL EndScene();
+
+    //--- Lighting & Material States
+    virtual CKBOOL SetLight(CKDWORD Light, CKLightData *data);
+    virtual CKBOOL EnableLight(CKDWORD Light, CKBOOL Enable);
+    virtual CKBOOL SetMaterial(CKMaterialData *mat);
+
+    //--- Viewport State
+    virtual CKBOOL SetViewport(CKViewportData *data);
+
+    //--- Transform Matrix
+    virtual CKBOOL SetTransformMatrix(VXMATRIX_TYPE Type, const VxMatrix &Mat);
+
+    //--- Render states
+    virtual CKBOOL SetRenderState(VXRENDERSTATETYPE State, CKDWORD Value);
+
+    //--- Texture States
+    virtual CKBOOL SetTexture(CKDWORD Texture, int Stage = 0);
+    virtual CKBOOL SetTextureStageState(int Stage, CKRST_TEXTURESTAGESTATETYPE Tss, CKDWORD Value);
+
+    //--- Vertex & Pixel shaders
+    virtual CKBOOL SetVertexShader(CKDWORD VShaderIndex);
+    virtual CKBOOL SetPixelShader(CKDWORD PShaderIndex);
+    virtual CKBOOL SetVertexShaderConstant(CKDWORD Register, const void *Data, CKDWORD CstCount);
+    virtual CKBOOL SetPixelShaderConstant(CKDWORD Register, const void *Data, CKDWORD CstCount);
+
+    //--- Drawing
+    virtual CKBOOL DrawPrimitive(VXPRIMITIVETYPE pType, CKWORD *indices, int indexcount, VxDrawPrimitiveData *data);
+    virtual CKBOOL DrawPrimitiveVB(VXPRIMITIVETYPE pType, CKDWORD VertexBuffer, CKDWORD StartIndex, CKDWORD VertexCount,
+                                   CKWORD *indices = NULL, int indexcount = 0);
+    virtual CKBOOL DrawPrimitiveVBIB(VXPRIMITIVETYPE pType, CKDWORD VB, CKDWORD IB, CKDWORD MinVIndex,
+                                     CKDWORD VertexCount, CKDWORD StartIndex, int Indexcount);
+
+    //--- Creation of Textures, Sprites and Vertex Buffer
+    virtual CKBOOL CreateObject(CKDWORD ObjIndex, CKRST_OBJECTTYPE Type, void *DesiredFormat);
+    virtual CKBOOL DeleteObject(CKDWORD ObjIndex, CKRST_OBJECTTYPE Type);
+
+    //--- Textures
+    virtual CKBOOL LoadTexture(CKDWORD Texture, const VxImageDescEx &SurfDesc, int miplevel = -1);
+    virtual CKBOOL CopyToTexture(CKDWORD Texture, VxRect *Src, VxRect *Dest, CKRST_CUBEFACE Face = CKRST_CUBEFACE_XPOS);
+    virtual CKBOOL SetTargetTexture(CKDWORD TextureObject, int Width = 0, int Height = 0, CKRST_CUBEFACE Face = CKRST_CUBEFACE_XPOS);
+
+    //--- Sprites
+    virtual CKBOOL DrawSprite(CKDWORD Sprite, VxRect *src, VxRect *dst);
+
+    //--- Vertex Buffers
+    virtual void *LockVertexBuffer(CKDWORD VB, CKDWORD StartVertex, CKDWORD VertexCount,
+                                   CKRST_LOCKFLAGS Lock = CKRST_LOCK_DEFAULT);
+    virtual CKBOOL UnlockVertexBuffer(CKDWORD VB);
+    virtual CKBOOL OptimizeVertexBuffer(CKDWORD VB);
+
+    //--- Copy the content of this rendering context to a memory buffer	(CopyToMemoryBuffer)
+    //--- or Updates this rendering context with the content of a memory buffer	(CopyFromMemoryBuffer)
+    virtual int CopyToMemoryBuffer(CKRECT *rect, VXBUFFER_TYPE buffer, VxImageDescEx &img_desc);
+    virtual int CopyFromMemoryBuffer(CKRECT *rect, VXBUFFER_TYPE buffer, const VxImageDescEx &img_desc);
+
+    //--- Threads
+    virtual CKBOOL WarnThread(CKBOOL Enter) { return TRUE; }
+
+    //--- User Clip Plane Function
+    virtual CKBOOL SetUserClipPlane(CKDWORD ClipPlaneIndex, const VxPlane &PlaneEquation);
+    virtual CKBOOL GetUserClipPlane(CKDWORD ClipPlaneIndex, VxPlane &PlaneEquation);
+
+    //--------- Load a cube map texture face
+    virtual CKBOOL LoadCubeMapTexture(CKDWORD Texture, const VxImageDescEx &SurfDesc, CKRST_CUBEFACE Face, int miplevel = -1);
+
+    //--------- Stereo rendering
+    virtual CKBOOL SetDrawBuffer(CKRST_DRAWBUFFER_FLAGS Flags);
+
+    //--- Index Buffers
+    virtual void *LockIndexBuffer(CKDWORD IB, CKDWORD StartIndex, CKDWORD IndexCount,
+                                  CKRST_LOCKFLAGS Lock = CKRST_LOCK_DEFAULT);
+    virtual CKBOOL UnlockIndexBuffer(CKDWORD IB);
+
+    //--- Command stream and statistics
+    // Recording can be disabled to measure the cost of the calls without the stream.
+    void EnableRecording(CKBOOL Enable) { m_Recording = Enable; }
+    CKBOOL IsRecording() const { return m_Recording; }
+
+    // Commands and counters of the frame being built (since the last BackToFront)
+    const XArray<CKNullCommand> &GetCommands() const { return m_Commands; }
+    const CKNullFrameStats &GetFrameStats() const { return m_FrameStats; }
+
+    // Commands and counters of the last completed frame
+    const XArray<CKNullCommand> &GetLastFrameCommands() const { return m_LastFrameCommands; }
+    const CKNullFrameStats &GetLastFrameStats() const { return m_LastFrameStats; }
+
+    CKDWORD GetFrameCount() const { return m_FrameCount; }
+
+    // Drops the current frame commands and counters
+    void ResetFrame();
+
+protected:
+    //--- Objects creation
+    CKBOOL CreateTexture(CKDWORD Texture, CKTextureDesc *DesiredFormat);
+    CKBOOL CreateVertexShader(CKDWORD VShader, CKVertexShaderDesc *DesiredFormat);
+    CKBOOL CreatePixelShader(CKDWORD PShader, CKPixelShaderDesc *DesiredFormat);
+    CKBOOL CreateVertexBuffer(CKDWORD VB, CKVertexBufferDesc *DesiredFormat);
+    CKBOOL CreateIndexBuffer(CKDWORD IB, CKIndexBufferDesc *DesiredFormat);
+
+    void Record(CKNULL_COMMANDTYPE Type, CKDWORD Arg0 = 0, CKDWORD Arg1 = 0, CKDWORD Arg2 = 0)
+    {
+        if (!m_Recording)
+            return;
+        CKNullCommand cmd;
+        cmd.Type = Type;
+        cmd.Args[0] = Arg0;
+        cmd.Args[1] = Arg1;
+        cmd.Args[2] = Arg2;
+        m_Commands.PushBack(cmd);
+    }
+
+    void CountDraw(VXPRIMITIVETYPE pType, CKDWORD VertexCount, CKDWORD IndexCount);
+
+public:
+    CKBOOL m_Recording;
+    CKDWORD m_FrameCount;
+    XArray<CKNullCommand> m_Commands;
+    XArray<CKNullCommand> m_LastFrameCommands;
+    CKNullFrameStats m_FrameStats;
+    CKNullFrameStats m_LastFrameStats;
+
+    //--- Current bindings, used to count actual changes
+    CKDWORD m_CurrentTextures[CKNULL_MAX_TEXTURESTAGES];
+    CKDWORD m_CurrentVertexShader;
+    CKDWORD m_CurrentPixelShader;
+    VxPlane m_ClipPlanes[CKNULL_MAX_CLIPPLANES];
+
+    CKNullRasterizer *m_Owner;
+};
+
+/*****************************************************************
+ CKNullRasterizerDriver overload
+******************************************************************/
+class CKNullRasterizerDriver : public CKRasterizerDriver
+{
+public:
+    CKNullRasterizerDriver(CKNullRasterizer *rst);
+    virtual ~CKNullRasterizerDriver();
+
+    //--- Contexts
+    virtual CKRasterizerContext *CreateContext();
+
+    CKBOOL InitializeCaps();
+};
+
+/*****************************************************************
+ CKNullRasterizer overload
+******************************************************************/
+class CKNullRasterizer : public CKRasterizer
+{
+public:
+    CKNullRasterizer();
+    virtual ~CKNullRasterizer();
+
+    virtual CKBOOL Start(WIN_HANDLE AppWnd);
+    virtual void Close();
+
+public:
+    CKBOOL m_Init;
+};
+
+CKRasterizer *CKNullRasterizerStart(WIN_HANDLE AppWnd);
+void CKNullRasterizerClose(CKRasterizer *rst);
+
+#endif
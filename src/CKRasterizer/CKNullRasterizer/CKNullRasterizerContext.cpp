@@ -0,0 +1,708 @@
+#include "CKNullRasterizer.h"
+
+static inline CKBOOL IsValidArrayIndex(CKDWORD index, int size)
+{
+    return size > 0 && index < static_cast<CKDWORD>(size);
+}
+
+static int GetPrimitiveCount(VXPRIMITIVETYPE pType, int count)
+{
+    switch (pType)
+    {
+        case VX_LINELIST:
+            return count / 2;
+        case VX_LINESTRIP:
+            return count - 1;
+        case VX_TRIANGLELIST:
+            return count / 3;
+        case VX_TRIANGLESTRIP:
+        case VX_TRIANGLEFAN:
+            return count - 2;
+        default:
+            return count;
+    }
+}
+
+CKNullRasterizerContext::CKNullRasterizerContext(CKNullRasterizerDriver *driver) :
+    CKRasterizerContext(),
+    m_Recording(TRUE),
+    m_FrameCount(0),
+    m_Commands(),
+    m_LastFrameCommands(),
+    m_CurrentVertexShader(0),
+    m_CurrentPixelShader(0),
+    m_Owner(NULL)
+{
+    memset(&m_FrameStats, 0, sizeof(m_FrameStats));
+    memset(&m_LastFrameStats, 0, sizeof(m_LastFrameStats));
+    memset(m_CurrentTextures, 0, sizeof(m_CurrentTextures));
+    memset(m_ClipPlanes, 0, sizeof(m_ClipPlanes));
+
+    if (!driver)
+        return;
+
+    m_Driver = driver;
+    m_Owner = static_cast<CKNullRasterizer *>(driver->m_Owner);
+}
+
+CKNullRasterizerContext::~CKNullRasterizerContext()
+{
+    if (m_Owner && m_Owner->m_FullscreenContext == this)
+        m_Owner->m_FullscreenContext = NULL;
+
+    // Buffers own their system memory copy
+    FlushObjects(CKRST_OBJ_ALL);
+}
+
+CKBOOL CKNullRasterizerContext::Create(WIN_HANDLE Window, int PosX, int PosY, int Width, int Height, int Bpp,
+                                       CKBOOL Fullscreen, int RefreshRate, int Zbpp, int StencilBpp)
+{
+    if (m_Owner && m_Owner->m_FullscreenContext && Fullscreen)
+        return FALSE;
+
+    if (Width <= 0 || Height <= 0)
+    {
+        const VxDisplayMode &dm = m_Driver->m_DisplayModes[0];
+        Width = dm.Width;
+        Height = dm.Height;
+    }
+
+    m_Window = Window;
+    m_PosX = PosX;
+    m_PosY = PosY;
+    m_Width = Width;
+    m_Height = Height;
+    m_Bpp = (Bpp > 0) ? Bpp : 32;
+    m_ZBpp = (Zbpp > 0) ? Zbpp : 24;
+    m_StencilBpp = (StencilBpp >= 0) ? StencilBpp : 8;
+    m_PixelFormat = _32_ARGB8888;
+    m_Fullscreen = Fullscreen;
+    m_RefreshRate = RefreshRate;
+
+    if (Fullscreen && m_Owner)
+        m_Owner->m_FullscreenContext = this;
+
+    CKViewportData viewport;
+    viewport.ViewX = 0;
+    viewport.ViewY = 0;
+    viewport.ViewWidth = Width;
+    viewport.ViewHeight = Height;
+    viewport.ViewZMin = 0.0f;
+    viewport.ViewZMax = 1.0f;
+    CKRasterizerContext::SetViewport(&viewport);
+
+    FlushRenderStateCache();
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::Resize(int PosX, int PosY, int Width, int Height, CKDWORD Flags)
+{
+    m_PosX = PosX;
+    m_PosY = PosY;
+    if (Width > 0 && Height > 0)
+    {
+        m_Width = Width;
+        m_Height = Height;
+    }
+    Record(CKNULL_CMD_RESIZE, m_Width, m_Height, Flags);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::Clear(CKDWORD Flags, CKDWORD Ccol, float Z, CKDWORD Stencil, int RectCount, CKRECT *rects)
+{
+    Record(CKNULL_CMD_CLEAR, Flags, Ccol, Stencil);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::BackToFront(CKBOOL vsync)
+{
+    if (m_SceneBegined)
+        EndScene();
+
+    Record(CKNULL_CMD_BACKTOFRONT, m_FrameCount);
+
+    // The completed frame becomes the last frame, the arrays keep their storage.
+    m_LastFrameCommands.Swap(m_Commands);
+    m_Commands.Resize(0);
+    m_LastFrameStats = m_FrameStats;
+    memset(&m_FrameStats, 0, sizeof(m_FrameStats));
+    ++m_FrameCount;
+    return TRUE;
+}
+
+void CKNullRasterizerContext::ResetFrame()
+{
+    m_Commands.Resize(0);
+    memset(&m_FrameStats, 0, sizeof(m_FrameStats));
+}
+
+CKBOOL CKNullRasterizerContext::BeginScene()
+{
+    if (m_SceneBegined)
+        return TRUE;
+    m_SceneBegined = TRUE;
+    Record(CKNULL_CMD_BEGINSCENE);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::EndScene()
+{
+    if (!m_SceneBegined)
+        return TRUE;
+    m_SceneBegined = FALSE;
+    Record(CKNULL_CMD_ENDSCENE);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::SetLight(CKDWORD Light, CKLightData *data)
+{
+    if (!data || Light >= RST_MAX_LIGHT)
+        return FALSE;
+    m_CurrentLightData[Light] = *data;
+    Record(CKNULL_CMD_SETLIGHT, Light, data->Type);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::EnableLight(CKDWORD Light, CKBOOL Enable)
+{
+    if (Light >= RST_MAX_LIGHT)
+        return FALSE;
+    Record(CKNULL_CMD_ENABLELIGHT, Light, Enable);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::SetMaterial(CKMaterialData *mat)
+{
+    if (!mat)
+        return FALSE;
+    CKRasterizerContext::SetMaterial(mat);
+    Record(CKNULL_CMD_SETMATERIAL);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::SetViewport(CKViewportData *data)
+{
+    if (!data)
+        return FALSE;
+    CKRasterizerContext::SetViewport(data);
+    Record(CKNULL_CMD_SETVIEWPORT, data->ViewWidth, data->ViewHeight);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::SetTransformMatrix(VXMATRIX_TYPE Type, const VxMatrix &Mat)
+{
+    // The base class keeps the matrices used by TransformVertices and ComputeBoxVisibility.
+    CKRasterizerContext::SetTransformMatrix(Type, Mat);
+    ++m_FrameStats.TransformChanges;
+    Record(CKNULL_CMD_SETTRANSFORM, Type);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::SetRenderState(VXRENDERSTATETYPE State, CKDWORD Value)
+{
+    if (State >= VXRENDERSTATE_MAXSTATE)
+        return FALSE;
+
+    if (InternalSetRenderState(State, Value))
+    {
+        ++m_FrameStats.RedundantRenderStates;
+        return TRUE;
+    }
+
+    if (State == VXRENDERSTATE_INVERSEWINDING)
+    {
+        m_InverseWinding = (Value != 0);
+        InvalidateStateCache(VXRENDERSTATE_CULLMODE);
+    }
+
+    ++m_FrameStats.RenderStateChanges;
+    Record(CKNULL_CMD_SETRENDERSTATE, State, Value);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::SetTexture(CKDWORD Texture, int Stage)
+{
+    if (Stage < 0 || Stage >= CKNULL_MAX_TEXTURESTAGES)
+        return FALSE;
+
+    if (Texture != 0 && !GetTextureData(Texture))
+        Texture = 0;
+
+    if (m_CurrentTextures[Stage] == Texture)
+        return TRUE;
+
+    m_CurrentTextures[Stage] = Texture;
+    ++m_FrameStats.TextureChanges;
+    Record(CKNULL_CMD_SETTEXTURE, Texture, Stage);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::SetTextureStageState(int Stage, CKRST_TEXTURESTAGESTATETYPE Tss, CKDWORD Value)
+{
+    if (Stage < 0 || Stage >= CKNULL_MAX_TEXTURESTAGES)
+        return FALSE;
+
+    ++m_FrameStats.TextureStageChanges;
+    Record(CKNULL_CMD_SETTEXTURESTAGESTATE, Stage, Tss, Value);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::SetVertexShader(CKDWORD VShaderIndex)
+{
+    if (VShaderIndex != 0 &&
+        (!IsValidArrayIndex(VShaderIndex, m_VertexShaders.Size()) || !m_VertexShaders[VShaderIndex]))
+        return FALSE;
+
+    if (m_CurrentVertexShader == VShaderIndex)
+        return TRUE;
+
+    m_CurrentVertexShader = VShaderIndex;
+    ++m_FrameStats.ShaderChanges;
+    Record(CKNULL_CMD_SETVERTEXSHADER, VShaderIndex);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::SetPixelShader(CKDWORD PShaderIndex)
+{
+    if (PShaderIndex != 0 &&
+        (!IsValidArrayIndex(PShaderIndex, m_PixelShaders.Size()) || !m_PixelShaders[PShaderIndex]))
+        return FALSE;
+
+    if (m_CurrentPixelShader == PShaderIndex)
+        return TRUE;
+
+    m_CurrentPixelShader = PShaderIndex;
+    ++m_FrameStats.ShaderChanges;
+    Record(CKNULL_CMD_SETPIXELSHADER, PShaderIndex);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::SetVertexShaderConstant(CKDWORD Register, const void *Data, CKDWORD CstCount)
+{
+    if (!Data)
+        return FALSE;
+
+    // Constants are float4 registers
+    m_FrameStats.BytesUploaded += CstCount * 4 * sizeof(float);
+    Record(CKNULL_CMD_SETVSCONSTANT, Register, CstCount);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::SetPixelShaderConstant(CKDWORD Register, const void *Data, CKDWORD CstCount)
+{
+    if (!Data)
+        return FALSE;
+
+    m_FrameStats.BytesUploaded += CstCount * 4 * sizeof(float);
+    Record(CKNULL_CMD_SETPSCONSTANT, Register, CstCount);
+    return TRUE;
+}
+
+void CKNullRasterizerContext::CountDraw(VXPRIMITIVETYPE pType, CKDWORD VertexCount, CKDWORD IndexCount)
+{
+    const int count = GetPrimitiveCount(pType, IndexCount ? (int) IndexCount : (int) VertexCount);
+    ++m_FrameStats.DrawCalls;
+    if (count > 0)
+        m_FrameStats.PrimitiveCount += count;
+    m_FrameStats.VertexCount += VertexCount;
+    m_FrameStats.IndexCount += IndexCount;
+}
+
+CKBOOL CKNullRasterizerContext::DrawPrimitive(VXPRIMITIVETYPE pType, CKWORD *indices, int indexcount, VxDrawPrimitiveData *data)
+{
+    if (!data || data->VertexCount <= 0)
+        return FALSE;
+
+    if (!m_SceneBegined && !BeginScene())
+        return FALSE;
+
+    if (!indices)
+        indexcount = 0;
+
+    CKDWORD vertexSize;
+    CKDWORD vertexFormat = CKRSTGetVertexFormat((CKRST_DPFLAGS) data->Flags, vertexSize);
+
+    // Same path as a hardware driver: vertices are converted into a dynamic vertex buffer,
+    // so the CPU cost of the conversion is part of what gets measured.
+    CKDWORD index = GetDynamicVertexBuffer(vertexFormat, data->VertexCount, vertexSize, (data->Flags & CKRST_DP_DOCLIP) ? 1 : 0);
+    CKNullVertexBufferDesc *vb = IsValidArrayIndex(index, m_VertexBuffers.Size()) ? static_cast<CKNullVertexBufferDesc *>(m_VertexBuffers[index]) : NULL;
+    if (!vb || !vb->Data)
+        return FALSE;
+
+    CKDWORD startVertex = 0;
+    if (vb->m_CurrentVCount + data->VertexCount <= vb->m_MaxVertexCount)
+        startVertex = vb->m_CurrentVCount;
+    vb->m_CurrentVCount = startVertex + data->VertexCount;
+
+    CKRSTLoadVertexBuffer(vb->Data + startVertex * vb->m_VertexSize, vertexFormat, vertexSize, data);
+
+    m_FrameStats.BytesUploaded += data->VertexCount * vertexSize + indexcount * sizeof(CKWORD);
+    CountDraw(pType, data->VertexCount, indexcount);
+    Record(CKNULL_CMD_DRAWPRIMITIVE, pType, data->VertexCount, indexcount);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::DrawPrimitiveVB(VXPRIMITIVETYPE pType, CKDWORD VertexBuffer, CKDWORD StartIndex,
+                                                CKDWORD VertexCount, CKWORD *indices, int indexcount)
+{
+    if (VertexCount == 0)
+        return FALSE;
+
+    CKVertexBufferDesc *vb = GetVertexBufferData(VertexBuffer);
+    if (!vb)
+        return FALSE;
+
+    if (indices && indexcount <= 0)
+        return FALSE;
+    if (!indices)
+        indexcount = 0;
+
+    if (StartIndex + VertexCount > vb->m_MaxVertexCount)
+        return FALSE;
+
+    if (!m_SceneBegined && !BeginScene())
+        return FALSE;
+
+    // System memory indices are copied to an index buffer by hardware drivers
+    m_FrameStats.BytesUploaded += indexcount * sizeof(CKWORD);
+    CountDraw(pType, VertexCount, indexcount);
+    Record(CKNULL_CMD_DRAWPRIMITIVEVB, pType, VertexBuffer, indexcount);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::DrawPrimitiveVBIB(VXPRIMITIVETYPE pType, CKDWORD VB, CKDWORD IB, CKDWORD MinVIndex,
+                                                  CKDWORD VertexCount, CKDWORD StartIndex, int Indexcount)
+{
+    if (VertexCount == 0 || Indexcount <= 0)
+        return FALSE;
+
+    CKVertexBufferDesc *vb = GetVertexBufferData(VB);
+    CKIndexBufferDesc *ib = GetIndexBufferData(IB);
+    if (!vb || !ib)
+        return FALSE;
+
+    if (MinVIndex + VertexCount > vb->m_MaxVertexCount)
+        return FALSE;
+    if (StartIndex + Indexcount > ib->m_MaxIndexCount)
+        return FALSE;
+
+    if (GetPrimitiveCount(pType, Indexcount) <= 0)
+        return FALSE;
+
+    if (!m_SceneBegined && !BeginScene())
+        return FALSE;
+
+    CountDraw(pType, VertexCount, Indexcount);
+    Record(CKNULL_CMD_DRAWPRIMITIVEVBIB, pType, VB, IB);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::CreateObject(CKDWORD ObjIndex, CKRST_OBJECTTYPE Type, void *DesiredFormat)
+{
+    CKBOOL result = FALSE;
+
+    if (!IsValidArrayIndex(ObjIndex, m_Textures.Size()) || !DesiredFormat)
+        return FALSE;
+
+    switch (Type)
+    {
+        case CKRST_OBJ_TEXTURE:
+            result = CreateTexture(ObjIndex, static_cast<CKTextureDesc *>(DesiredFormat));
+            break;
+        case CKRST_OBJ_SPRITE:
+            result = CreateSprite(ObjIndex, static_cast<CKSpriteDesc *>(DesiredFormat));
+            break;
+        case CKRST_OBJ_VERTEXBUFFER:
+            result = CreateVertexBuffer(ObjIndex, static_cast<CKVertexBufferDesc *>(DesiredFormat));
+            break;
+        case CKRST_OBJ_INDEXBUFFER:
+            result = CreateIndexBuffer(ObjIndex, static_cast<CKIndexBufferDesc *>(DesiredFormat));
+            break;
+        case CKRST_OBJ_VERTEXSHADER:
+            result = CreateVertexShader(ObjIndex, static_cast<CKVertexShaderDesc *>(DesiredFormat));
+            break;
+        case CKRST_OBJ_PIXELSHADER:
+            result = CreatePixelShader(ObjIndex, static_cast<CKPixelShaderDesc *>(DesiredFormat));
+            break;
+        default:
+            return FALSE;
+    }
+
+    if (result)
+    {
+        ++m_FrameStats.ObjectsCreated;
+        Record(CKNULL_CMD_CREATEOBJECT, ObjIndex, Type);
+    }
+    return result;
+}
+
+CKBOOL CKNullRasterizerContext::DeleteObject(CKDWORD ObjIndex, CKRST_OBJECTTYPE Type)
+{
+    if (!CKRasterizerContext::DeleteObject(ObjIndex, Type))
+        return FALSE;
+
+    if (Type == CKRST_OBJ_TEXTURE)
+    {
+        for (int i = 0; i < CKNULL_MAX_TEXTURESTAGES; ++i)
+            if (m_CurrentTextures[i] == ObjIndex)
+                m_CurrentTextures[i] = 0;
+    }
+    else if (Type == CKRST_OBJ_VERTEXSHADER && m_CurrentVertexShader == ObjIndex)
+    {
+        m_CurrentVertexShader = 0;
+    }
+    else if (Type == CKRST_OBJ_PIXELSHADER && m_CurrentPixelShader == ObjIndex)
+    {
+        m_CurrentPixelShader = 0;
+    }
+
+    Record(CKNULL_CMD_DELETEOBJECT, ObjIndex, Type);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::LoadTexture(CKDWORD Texture, const VxImageDescEx &SurfDesc, int miplevel)
+{
+    if (!GetTextureData(Texture))
+        return FALSE;
+
+    const CKDWORD bytes = SurfDesc.Height * SurfDesc.BytesPerLine;
+    m_FrameStats.BytesUploaded += bytes;
+    Record(CKNULL_CMD_LOADTEXTURE, Texture, (CKDWORD) miplevel, bytes);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::CopyToTexture(CKDWORD Texture, VxRect *Src, VxRect *Dest, CKRST_CUBEFACE Face)
+{
+    if (!GetTextureData(Texture))
+        return FALSE;
+
+    Record(CKNULL_CMD_COPYTOTEXTURE, Texture, Face);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::SetTargetTexture(CKDWORD TextureObject, int Width, int Height, CKRST_CUBEFACE Face)
+{
+    // 0 restores the default back buffer
+    if (TextureObject != 0 && !GetTextureData(TextureObject))
+        return FALSE;
+
+    Record(CKNULL_CMD_SETTARGETTEXTURE, TextureObject, Face);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::DrawSprite(CKDWORD Sprite, VxRect *src, VxRect *dst)
+{
+    CKSpriteDesc *sprite = GetSpriteData(Sprite);
+    if (!sprite || !src || !dst)
+        return FALSE;
+
+    if (!m_SceneBegined && !BeginScene())
+        return FALSE;
+
+    // One quad per sub texture
+    const int quads = sprite->Textures.Size();
+    m_FrameStats.DrawCalls += quads;
+    m_FrameStats.PrimitiveCount += quads * 2;
+    m_FrameStats.VertexCount += quads * 4;
+    Record(CKNULL_CMD_DRAWSPRITE, Sprite);
+    return TRUE;
+}
+
+void *CKNullRasterizerContext::LockVertexBuffer(CKDWORD VB, CKDWORD StartVertex, CKDWORD VertexCount, CKRST_LOCKFLAGS Lock)
+{
+    if (!IsValidArrayIndex(VB, m_VertexBuffers.Size()))
+        return NULL;
+
+    CKNullVertexBufferDesc *vb = static_cast<CKNullVertexBufferDesc *>(m_VertexBuffers[VB]);
+    if (!vb || !vb->Data)
+        return NULL;
+
+    if (StartVertex >= vb->m_MaxVertexCount)
+        return NULL;
+
+    if (VertexCount == 0 || StartVertex + VertexCount > vb->m_MaxVertexCount)
+        VertexCount = vb->m_MaxVertexCount - StartVertex;
+
+    const CKDWORD bytes = VertexCount * vb->m_VertexSize;
+    ++m_FrameStats.BufferLocks;
+    m_FrameStats.BytesUploaded += bytes;
+    Record(CKNULL_CMD_LOCKVB, VB, bytes, Lock);
+
+    return vb->Data + StartVertex * vb->m_VertexSize;
+}
+
+CKBOOL CKNullRasterizerContext::UnlockVertexBuffer(CKDWORD VB)
+{
+    if (!IsValidArrayIndex(VB, m_VertexBuffers.Size()))
+        return FALSE;
+
+    CKNullVertexBufferDesc *vb = static_cast<CKNullVertexBufferDesc *>(m_VertexBuffers[VB]);
+    if (!vb || !vb->Data)
+        return FALSE;
+
+    Record(CKNULL_CMD_UNLOCKVB, VB);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::OptimizeVertexBuffer(CKDWORD VB)
+{
+    return GetVertexBufferData(VB) != NULL;
+}
+
+int CKNullRasterizerContext::CopyToMemoryBuffer(CKRECT *rect, VXBUFFER_TYPE buffer, VxImageDescEx &img_desc)
+{
+    // Nothing is rendered
+    return 0;
+}
+
+int CKNullRasterizerContext::CopyFromMemoryBuffer(CKRECT *rect, VXBUFFER_TYPE buffer, const VxImageDescEx &img_desc)
+{
+    return 0;
+}
+
+CKBOOL CKNullRasterizerContext::SetUserClipPlane(CKDWORD ClipPlaneIndex, const VxPlane &PlaneEquation)
+{
+    if (ClipPlaneIndex >= CKNULL_MAX_CLIPPLANES)
+        return FALSE;
+
+    m_ClipPlanes[ClipPlaneIndex] = PlaneEquation;
+    Record(CKNULL_CMD_SETCLIPPLANE, ClipPlaneIndex);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::GetUserClipPlane(CKDWORD ClipPlaneIndex, VxPlane &PlaneEquation)
+{
+    if (ClipPlaneIndex >= CKNULL_MAX_CLIPPLANES)
+        return FALSE;
+
+    PlaneEquation = m_ClipPlanes[ClipPlaneIndex];
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::LoadCubeMapTexture(CKDWORD Texture, const VxImageDescEx &SurfDesc, CKRST_CUBEFACE Face, int miplevel)
+{
+    CKTextureDesc *desc = GetTextureData(Texture);
+    if (!desc || (desc->Flags & CKRST_TEXTURE_CUBEMAP) == 0)
+        return FALSE;
+
+    const CKDWORD bytes = SurfDesc.Height * SurfDesc.BytesPerLine;
+    m_FrameStats.BytesUploaded += bytes;
+    Record(CKNULL_CMD_LOADTEXTURE, Texture, (CKDWORD) miplevel, bytes);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::SetDrawBuffer(CKRST_DRAWBUFFER_FLAGS Flags)
+{
+    Record(CKNULL_CMD_SETDRAWBUFFER, Flags);
+    return TRUE;
+}
+
+void *CKNullRasterizerContext::LockIndexBuffer(CKDWORD IB, CKDWORD StartIndex, CKDWORD IndexCount, CKRST_LOCKFLAGS Lock)
+{
+    if (!IsValidArrayIndex(IB, m_IndexBuffers.Size()))
+        return NULL;
+
+    CKNullIndexBufferDesc *ib = static_cast<CKNullIndexBufferDesc *>(m_IndexBuffers[IB]);
+    if (!ib || !ib->Data)
+        return NULL;
+
+    if (StartIndex >= ib->m_MaxIndexCount)
+        return NULL;
+
+    if (IndexCount == 0 || StartIndex + IndexCount > ib->m_MaxIndexCount)
+        IndexCount = ib->m_MaxIndexCount - StartIndex;
+
+    const CKDWORD bytes = IndexCount * sizeof(CKWORD);
+    ++m_FrameStats.BufferLocks;
+    m_FrameStats.BytesUploaded += bytes;
+    Record(CKNULL_CMD_LOCKIB, IB, bytes, Lock);
+
+    return ib->Data + StartIndex;
+}
+
+CKBOOL CKNullRasterizerContext::UnlockIndexBuffer(CKDWORD IB)
+{
+    if (!IsValidArrayIndex(IB, m_IndexBuffers.Size()))
+        return FALSE;
+
+    CKNullIndexBufferDesc *ib = static_cast<CKNullIndexBufferDesc *>(m_IndexBuffers[IB]);
+    if (!ib || !ib->Data)
+        return FALSE;
+
+    Record(CKNULL_CMD_UNLOCKIB, IB);
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::CreateTexture(CKDWORD Texture, CKTextureDesc *DesiredFormat)
+{
+    CKTextureDesc *desc = new CKTextureDesc;
+    desc->Flags = DesiredFormat->Flags & ~CKRST_TEXTURE_COMPRESSION;
+    desc->Flags |= CKRST_TEXTURE_VALID | CKRST_TEXTURE_RGB | CKRST_TEXTURE_ALPHA;
+    desc->MipMapCount = DesiredFormat->MipMapCount;
+
+    // Only one texture format is advertised by the driver
+    VxPixelFormat2ImageDesc(_32_ARGB8888, desc->Format);
+    desc->Format.Width = DesiredFormat->Format.Width;
+    desc->Format.Height = DesiredFormat->Format.Height;
+    desc->Format.BytesPerLine = desc->Format.Width * 4;
+
+    if (m_Textures[Texture])
+        delete m_Textures[Texture];
+    m_Textures[Texture] = desc;
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::CreateVertexShader(CKDWORD VShader, CKVertexShaderDesc *DesiredFormat)
+{
+    CKVertexShaderDesc *desc = new CKVertexShaderDesc;
+    desc->m_FunctionSize = DesiredFormat->m_FunctionSize;
+
+    if (m_VertexShaders[VShader])
+        delete m_VertexShaders[VShader];
+    m_VertexShaders[VShader] = desc;
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::CreatePixelShader(CKDWORD PShader, CKPixelShaderDesc *DesiredFormat)
+{
+    CKPixelShaderDesc *desc = new CKPixelShaderDesc;
+    desc->m_FunctionSize = DesiredFormat->m_FunctionSize;
+
+    if (m_PixelShaders[PShader])
+        delete m_PixelShaders[PShader];
+    m_PixelShaders[PShader] = desc;
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::CreateVertexBuffer(CKDWORD VB, CKVertexBufferDesc *DesiredFormat)
+{
+    if (DesiredFormat->m_MaxVertexCount == 0 || DesiredFormat->m_VertexSize == 0)
+        return FALSE;
+
+    // DesiredFormat may be the current descriptor, copy it before releasing the old one
+    CKNullVertexBufferDesc *desc = new CKNullVertexBufferDesc;
+    *static_cast<CKVertexBufferDesc *>(desc) = *DesiredFormat;
+    desc->Data = new CKBYTE[desc->m_MaxVertexCount * desc->m_VertexSize];
+    desc->m_Flags |= CKRST_VB_VALID;
+
+    if (m_VertexBuffers[VB])
+        delete m_VertexBuffers[VB];
+    m_VertexBuffers[VB] = desc;
+    return TRUE;
+}
+
+CKBOOL CKNullRasterizerContext::CreateIndexBuffer(CKDWORD IB, CKIndexBufferDesc *DesiredFormat)
+{
+    if (DesiredFormat->m_MaxIndexCount == 0)
+        return FALSE;
+
+    CKNullIndexBufferDesc *desc = new CKNullIndexBufferDesc;
+    *static_cast<CKIndexBufferDesc *>(desc) = *DesiredFormat;
+    desc->Data = new CKWORD[desc->m_MaxIndexCount];
+    desc->m_Flags |= CKRST_VB_VALID;
+
+    if (m_IndexBuffers[IB])
+        delete m_IndexBuffers[IB];
+    m_IndexBuffers[IB] = desc;
+    return TRUE;
+}
@@ -0,0 +1,96 @@
+#include "CKJobPool.h"
+
+CKJobPool::CKJobPool()
+    : m_NextIndex(0), m_Task(nullptr), m_Context(nullptr), m_Count(0), m_Busy(0), m_Generation(0), m_Quit(false) {}
+
+CKJobPool::~CKJobPool() {
+    Stop();
+}
+
+void CKJobPool::Start(int workerCount) {
+    Stop();
+
+    if (workerCount > CKJOBPOOL_MAX_WORKERS)
+        workerCount = CKJOBPOOL_MAX_WORKERS;
+
+    m_Quit = false;
+    for (int i = 0; i < workerCount; ++i)
+        m_Workers.push_back(std::thread(&CKJobPool::WorkerLoop, this));
+}
+
+void CKJobPool::Stop() {
+    if (m_Workers.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+    }
+    m_WakeUp.notify_all();
+
+    for (size_t i = 0; i < m_Workers.size(); ++i)
+        m_Workers[i].join();
+    m_Workers.clear();
+}
+
+void CKJobPool::Run(int count, TaskFunction task, void *context) {
+    if (count <= 0 || !task)
+        return;
+
+    m_Task = task;
+    m_Context = context;
+    m_Count = count;
+    m_NextIndex = 0;
+
+    // A single task or no worker: nothing to hand out
+    if (m_Workers.empty() || count == 1) {
+        Execute();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Busy = (int) m_Workers.size();
+        ++m_Generation;
+    }
+    m_WakeUp.notify_all();
+
+    Execute();
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Done.wait(lock, [this] { return m_Busy == 0; });
+}
+
+int CKJobPool::GetAutoWorkerCount(int optionValue) {
+    if (optionValue >= 0)
+        return optionValue < CKJOBPOOL_MAX_WORKERS ? optionValue : CKJOBPOOL_MAX_WORKERS;
+
+    // The calling thread runs tasks too
+    const int cores = (int) std::thread::hardware_concurrency();
+    const int workers = cores > 1 ? cores - 1 : 0;
+    return workers < CKJOBPOOL_MAX_WORKERS ? workers : CKJOBPOOL_MAX_WORKERS;
+}
+
+void CKJobPool::Execute() {
+    for (int index = m_NextIndex++; index < m_Count; index = m_NextIndex++)
+        m_Task(m_Context, index);
+}
+
+void CKJobPool::WorkerLoop() {
+    CKDWORD generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WakeUp.wait(lock, [&] { return m_Quit || m_Generation != generation; });
+            if (m_Quit)
+                return;
+            generation = m_Generation;
+        }
+
+        Execute();
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (--m_Busy == 0)
+            m_Done.notify_one();
+    }
+}
@@ -1,4 +1,5 @@
 #include "CKRasterizer.h"
+#include "CKRasterizerSIMD.h"
 
 #include <stdio.h>
 
@@ -459,6 +460,10 @@ CKBYTE *CKRSTLoadVertexBuffer(CKBYTE *VBMem, CKDWORD VFormat, CKDWORD VSize, VxD
         return &VBMem[data->VertexCount * sizeof(CKVertex)];
     }
 
+    // Whole vertices in one pass for the formats of CKRSTGetVertexFormat
+    if (CKRstLoadVertices(GetRasterizerSIMDLevel(), VBMem, VFormat, VSize, data))
+        return &VBMem[data->VertexCount * VSize];
+
     int offset;
     if (VFormat & CKRST_VF_RASTERPOS) {
         VxCopyStructure(data->VertexCount, VBMem, VSize, sizeof(VxVector4), data->PositionPtr, data->PositionStride);
@@ -1,4 +1,5 @@
 #include "CKRasterizer.h"
+#include "CKRasterizerSIMD.h"
 
 CKDWORD GetMsb(CKDWORD data, CKDWORD index) {
 #define OPERAND_SIZE (sizeof(CKDWORD) * 8)
@@ -330,37 +331,15 @@ CKBOOL CKRasterizerContext::TransformVertices(int VertexCount, VxTransformData *
         outStride = sizeof(VxVector4);
     }
 
-    VxStridedData out(outVertices, outStride);
-    VxStridedData in(Data->InVertices, Data->InStride);
-    Vx3DMultiplyMatrixVector4Strided(&out, &in, m_TotalMatrix, VertexCount);
-
-    CKBYTE *outPtr = (CKBYTE *) outVertices;
-
-    if (Data->ClipFlags) {
-        offscreen = 0xFFFFFFFF;
-        for (int v = 0; v < VertexCount; ++v) {
-            VxVector4 *vertex = (VxVector4 *) outPtr;
-            unsigned int clipFlag = 0;
-
-            float w = vertex->w;
-            if (-w > vertex->x)
-                clipFlag |= VXCLIP_LEFT;
-            if (vertex->x > w)
-                clipFlag |= VXCLIP_RIGHT;
-            if (-w > vertex->y)
-                clipFlag |= VXCLIP_BOTTOM;
-            if (vertex->y > w)
-                clipFlag |= VXCLIP_TOP;
-            if (vertex->z < 0.0f)
-                clipFlag |= VXCLIP_FRONT;
-            if (vertex->z > w)
-                clipFlag |= VXCLIP_BACK;
-
-            offscreen &= clipFlag;
-            Data->ClipFlags[v] = clipFlag;
-            outPtr += outStride;
-        }
-    }
+    // Clip coordinates and flags, then screen coordinates, several vertices
+    // at a time when the processor allows it (CKRasterizerSIMD.cpp)
+    const CKRST_SIMD level = GetRasterizerSIMDLevel();
+    if (Data->ClipFlags)
+        offscreen = CKRstTransformVertices(level, m_TotalMatrix, Data->InVertices, Data->InStride, outVertices,
+                                           outStride, (CKDWORD *) Data->ClipFlags, VertexCount);
+    else
+        CKRstTransformVertices(level, m_TotalMatrix, Data->InVertices, Data->InStride, outVertices, outStride,
+                               NULL, VertexCount);
 
     VxVector4 *screenVertices = (VxVector4 *) Data->ScreenVertices;
     if (screenVertices) {
@@ -368,23 +347,12 @@ CKBOOL CKRasterizerContext::TransformVertices(int VertexCount, VxTransformData *
         if (screenStride == 0)
             screenStride = sizeof(VxVector4);
 
-        CKBYTE *screenPtr = (CKBYTE *) screenVertices;
-        CKBYTE *outScreenPtr = (CKBYTE *) outVertices;
         float halfWidth = m_ViewportData.ViewWidth * 0.5f;
         float halfHeight = m_ViewportData.ViewHeight * 0.5f;
         float centerX = m_ViewportData.ViewX + halfWidth;
         float centerY = m_ViewportData.ViewY + halfHeight;
-        for (int v = 0; v < VertexCount; ++v) {
-            VxVector4 *outVertex = (VxVector4 *) outScreenPtr;
-            VxVector4 *screenVertex = (VxVector4 *) screenPtr;
-            float w = 1.0f / outVertex->w;
-            screenVertex->w = w;
-            screenVertex->z = w * outVertex->z;
-            screenVertex->y = centerY - outVertex->y * w * halfHeight;
-            screenVertex->x = centerX + outVertex->x * w * halfWidth;
-            outScreenPtr += outStride;
-            screenPtr += screenStride;
-        }
+        CKRstProjectVertices(level, outVertices, outStride, screenVertices, screenStride, VertexCount, centerX,
+                             centerY, halfWidth, halfHeight);
     }
 
     Data->m_Offscreen = offscreen & VXCLIP_ALL;
@@ -406,10 +374,12 @@ CKDWORD CKRasterizerContext::ComputeBoxVisibility(const VxBbox &box, CKBOOL Worl
         else
             VxTransformBox2D(m_TotalMatrix, box, &screen, extents, orClipFlags, andClipFlags);
     } else {
-        if (World)
-            VxTransformBox2D(m_ViewProjMatrix, box, NULL, NULL, orClipFlags, andClipFlags);
-        else
-            VxTransformBox2D(m_TotalMatrix, box, NULL, NULL, orClipFlags, andClipFlags);
+        // Without extents only the clip flags of the corners are needed
+        CKDWORD orFlags, andFlags;
+        CKRstComputeBoxesClipFlags(GetRasterizerSIMDLevel(), World ? m_ViewProjMatrix : m_TotalMatrix, &box, 1,
+                                   &orFlags, &andFlags);
+        orClipFlags = (VXCLIP_FLAGS) orFlags;
+        andClipFlags = (VXCLIP_FLAGS) andFlags;
     }
 
     if (andClipFlags & VXCLIP_ALL)
@@ -420,6 +390,28 @@ CKDWORD CKRasterizerContext::ComputeBoxVisibility(const VxBbox &box, CKBOOL Worl
         return CBV_ALLINSIDE;
 }
 
+void CKRasterizerContext::ComputeBoxVisibility(int BoxCount, const VxBbox *boxes, CKDWORD *results, CKBOOL World) {
+    UpdateMatrices(World ? VIEW_TRANSFORM : WORLD_TRANSFORM);
+    const VxMatrix &mat = World ? m_ViewProjMatrix : m_TotalMatrix;
+    const CKRST_SIMD level = GetRasterizerSIMDLevel();
+
+    // Clip flags of a chunk of boxes at a time
+    CKDWORD orFlags[64];
+    CKDWORD andFlags[64];
+    for (int first = 0; first < BoxCount; first += 64) {
+        const int count = (BoxCount - first < 64) ? BoxCount - first : 64;
+        CKRstComputeBoxesClipFlags(level, mat, boxes + first, count, orFlags, andFlags);
+        for (int i = 0; i < count; ++i) {
+            if (andFlags[i] & VXCLIP_ALL)
+                results[first + i] = CBV_OFFSCREEN;
+            else if (orFlags[i] & VXCLIP_ALL)
+                results[first + i] = CBV_VISIBLE;
+            else
+                results[first + i] = CBV_ALLINSIDE;
+        }
+    }
+}
+
 void CKRasterizerContext::InitDefaultRenderStatesValue() {
     m_StateCache[VXRENDERSTATE_SHADEMODE].DefaultValue = 2;
     m_StateCache[VXRENDERSTATE_SRCBLEND].DefaultValue = 2;
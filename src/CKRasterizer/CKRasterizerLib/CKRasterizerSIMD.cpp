@@ -0,0 +1,651 @@
+#include "CKRasterizerSIMD.h"
+
+#include <string.h>
+
+#include "CKRasterizerEnums.h"
+
+// =====================================================
+// Vertex kernels of CKRasterizerContext
+// The processor specific versions gather 4 or 8 vertices into x, y, z, w
+// lanes, keep the generic operation order (no fused multiply-add) and leave
+// the last vertices of a batch to the generic version.
+// =====================================================
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CKRST_SIMD_X86 1
+#endif
+
+#ifdef CKRST_SIMD_X86
+
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CKRST_TARGET_SSE2
+#define CKRST_TARGET_AVX
+#else
+#define CKRST_TARGET_SSE2 __attribute__((target("sse2")))
+#define CKRST_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+static CKRST_SIMD DetectRasterizerSIMDLevel() {
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 1)
+        return CKRST_SIMD_NONE;
+
+    __cpuid(regs, 1);
+    if (!(regs[3] & (1 << 26))) // EDX: SSE2
+        return CKRST_SIMD_NONE;
+
+    // AVX also needs the OS to save the YMM registers (OSXSAVE + XCR0)
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        return CKRST_SIMD_SSE2;
+    return CKRST_SIMD_AVX;
+#else
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("sse2"))
+        return CKRST_SIMD_NONE;
+    if (__builtin_cpu_supports("avx"))
+        return CKRST_SIMD_AVX;
+    return CKRST_SIMD_SSE2;
+#endif
+}
+
+#endif // CKRST_SIMD_X86
+
+CKRST_SIMD GetRasterizerSIMDLevel() {
+#ifdef CKRST_SIMD_X86
+    static const CKRST_SIMD level = DetectRasterizerSIMDLevel();
+    return level;
+#else
+    return CKRST_SIMD_NONE;
+#endif
+}
+
+// =====================================================
+// Generic versions
+// =====================================================
+
+static inline CKDWORD ClipFlags(const VxVector4 &v) {
+    CKDWORD flags = 0;
+    if (-v.w > v.x)
+        flags |= VXCLIP_LEFT;
+    if (v.x > v.w)
+        flags |= VXCLIP_RIGHT;
+    if (-v.w > v.y)
+        flags |= VXCLIP_BOTTOM;
+    if (v.y > v.w)
+        flags |= VXCLIP_TOP;
+    if (v.z < 0.0f)
+        flags |= VXCLIP_FRONT;
+    if (v.z > v.w)
+        flags |= VXCLIP_BACK;
+    return flags;
+}
+
+static inline void TransformPoint(VxVector4 &out, const VxMatrix &mat, float x, float y, float z) {
+    out.x = x * mat[0][0] + y * mat[1][0] + z * mat[2][0] + mat[3][0];
+    out.y = x * mat[0][1] + y * mat[1][1] + z * mat[2][1] + mat[3][1];
+    out.z = x * mat[0][2] + y * mat[1][2] + z * mat[2][2] + mat[3][2];
+    out.w = x * mat[0][3] + y * mat[1][3] + z * mat[2][3] + mat[3][3];
+}
+
+static CKDWORD TransformVerticesGeneric(const VxMatrix &mat, const CKBYTE *in, CKDWORD inStride, CKBYTE *out,
+                                        CKDWORD outStride, CKDWORD *clipFlags, int count) {
+    CKDWORD andFlags = 0xFFFFFFFF;
+    for (int v = 0; v < count; ++v, in += inStride, out += outStride) {
+        const VxVector &pos = *(const VxVector *) in;
+        VxVector4 &res = *(VxVector4 *) out;
+        TransformPoint(res, mat, pos.x, pos.y, pos.z);
+        if (clipFlags) {
+            clipFlags[v] = ClipFlags(res);
+            andFlags &= clipFlags[v];
+        }
+    }
+    return andFlags;
+}
+
+static void ProjectVerticesGeneric(const CKBYTE *in, CKDWORD inStride, CKBYTE *out, CKDWORD outStride, int count,
+                                   float centerX, float centerY, float halfWidth, float halfHeight) {
+    for (int v = 0; v < count; ++v, in += inStride, out += outStride) {
+        const VxVector4 &hv = *(const VxVector4 *) in;
+        VxVector4 &sv = *(VxVector4 *) out;
+        const float x = hv.x;
+        const float y = hv.y;
+        const float z = hv.z;
+        const float w = 1.0f / hv.w;
+        sv.w = w;
+        sv.z = w * z;
+        sv.y = centerY - y * w * halfHeight;
+        sv.x = centerX + x * w * halfWidth;
+    }
+}
+
+static void BoxClipFlagsGeneric(const VxMatrix &mat, const VxBbox &box, CKDWORD &orFlags, CKDWORD &andFlags) {
+    orFlags = 0;
+    andFlags = 0xFFFFFFFF;
+    for (int i = 0; i < 8; ++i) {
+        VxVector4 corner;
+        TransformPoint(corner, mat, (i & 1) ? box.Max.x : box.Min.x, (i & 2) ? box.Max.y : box.Min.y,
+                       (i & 4) ? box.Max.z : box.Min.z);
+        const CKDWORD flags = ClipFlags(corner);
+        orFlags |= flags;
+        andFlags &= flags;
+    }
+}
+
+#ifdef CKRST_SIMD_X86
+
+// =====================================================
+// SSE2: four vertices per iteration
+// =====================================================
+
+// x, y, z of 4 strided positions. The 16 byte loads read the next float,
+// which belongs to the next vertex when the block is not the last one.
+CKRST_TARGET_SSE2
+static inline void LoadPositions4(const CKBYTE *in, CKDWORD stride, CKBOOL wide, __m128 &x, __m128 &y, __m128 &z) {
+    const float *p0 = (const float *) in;
+    const float *p1 = (const float *) (in + stride);
+    const float *p2 = (const float *) (in + 2 * stride);
+    const float *p3 = (const float *) (in + 3 * stride);
+    if (wide) {
+        __m128 r0 = _mm_loadu_ps(p0);
+        __m128 r1 = _mm_loadu_ps(p1);
+        __m128 r2 = _mm_loadu_ps(p2);
+        __m128 r3 = _mm_loadu_ps(p3);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        x = r0;
+        y = r1;
+        z = r2;
+    } else {
+        x = _mm_set_ps(p3[0], p2[0], p1[0], p0[0]);
+        y = _mm_set_ps(p3[1], p2[1], p1[1], p0[1]);
+        z = _mm_set_ps(p3[2], p2[2], p1[2], p0[2]);
+    }
+}
+
+CKRST_TARGET_SSE2
+static inline void StoreVectors4(CKBYTE *out, CKDWORD stride, __m128 x, __m128 y, __m128 z, __m128 w) {
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+    _mm_storeu_ps((float *) out, x);
+    _mm_storeu_ps((float *) (out + stride), y);
+    _mm_storeu_ps((float *) (out + 2 * stride), z);
+    _mm_storeu_ps((float *) (out + 3 * stride), w);
+}
+
+CKRST_TARGET_SSE2
+static inline __m128 TransformLane4(const VxMatrix &mat, int c, __m128 x, __m128 y, __m128 z) {
+    __m128 r = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(mat[0][c])), _mm_mul_ps(y, _mm_set1_ps(mat[1][c])));
+    r = _mm_add_ps(r, _mm_mul_ps(z, _mm_set1_ps(mat[2][c])));
+    return _mm_add_ps(r, _mm_set1_ps(mat[3][c]));
+}
+
+CKRST_TARGET_SSE2
+static inline __m128i ClipFlags4(__m128 x, __m128 y, __m128 z, __m128 w) {
+    const __m128 negW = _mm_xor_ps(w, _mm_set1_ps(-0.0f));
+    __m128i flags = _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(negW, x)), _mm_set1_epi32(VXCLIP_LEFT));
+    flags = _mm_or_si128(flags, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(x, w)), _mm_set1_epi32(VXCLIP_RIGHT)));
+    flags = _mm_or_si128(flags, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(negW, y)), _mm_set1_epi32(VXCLIP_BOTTOM)));
+    flags = _mm_or_si128(flags, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(y, w)), _mm_set1_epi32(VXCLIP_TOP)));
+    flags = _mm_or_si128(flags, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(z, _mm_setzero_ps())),
+                                              _mm_set1_epi32(VXCLIP_FRONT)));
+    flags = _mm_or_si128(flags, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(z, w)), _mm_set1_epi32(VXCLIP_BACK)));
+    return flags;
+}
+
+CKRST_TARGET_SSE2
+static CKDWORD TransformVerticesSSE2(const VxMatrix &mat, const CKBYTE *in, CKDWORD inStride, CKBYTE *out,
+                                     CKDWORD outStride, CKDWORD *clipFlags, int count) {
+    __m128i andFlags = _mm_set1_epi32(-1);
+    int v = 0;
+    for (; v + 4 <= count; v += 4) {
+        __m128 x, y, z;
+        LoadPositions4(in + v * inStride, inStride, inStride >= 4 && v + 4 < count, x, y, z);
+        const __m128 cx = TransformLane4(mat, 0, x, y, z);
+        const __m128 cy = TransformLane4(mat, 1, x, y, z);
+        const __m128 cz = TransformLane4(mat, 2, x, y, z);
+        const __m128 cw = TransformLane4(mat, 3, x, y, z);
+        if (clipFlags) {
+            const __m128i flags = ClipFlags4(cx, cy, cz, cw);
+            _mm_storeu_si128((__m128i *) (clipFlags + v), flags);
+            andFlags = _mm_and_si128(andFlags, flags);
+        }
+        StoreVectors4(out + v * outStride, outStride, cx, cy, cz, cw);
+    }
+
+    CKDWORD lanes[4];
+    _mm_storeu_si128((__m128i *) lanes, andFlags);
+    const CKDWORD tail = TransformVerticesGeneric(mat, in + v * inStride, inStride, out + v * outStride, outStride,
+                                                  clipFlags ? clipFlags + v : NULL, count - v);
+    return lanes[0] & lanes[1] & lanes[2] & lanes[3] & tail;
+}
+
+CKRST_TARGET_SSE2
+static void ProjectVerticesSSE2(const CKBYTE *in, CKDWORD inStride, CKBYTE *out, CKDWORD outStride, int count,
+                                float centerX, float centerY, float halfWidth, float halfHeight) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 cx = _mm_set1_ps(centerX);
+    const __m128 cy = _mm_set1_ps(centerY);
+    const __m128 hw = _mm_set1_ps(halfWidth);
+    const __m128 hh = _mm_set1_ps(halfHeight);
+    int v = 0;
+    for (; v + 4 <= count; v += 4) {
+        const CKBYTE *src = in + v * inStride;
+        __m128 x = _mm_loadu_ps((const float *) src);
+        __m128 y = _mm_loadu_ps((const float *) (src + inStride));
+        __m128 z = _mm_loadu_ps((const float *) (src + 2 * inStride));
+        __m128 w = _mm_loadu_ps((const float *) (src + 3 * inStride));
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+
+        const __m128 rw = _mm_div_ps(one, w);
+        const __m128 sz = _mm_mul_ps(rw, z);
+        const __m128 sy = _mm_sub_ps(cy, _mm_mul_ps(_mm_mul_ps(y, rw), hh));
+        const __m128 sx = _mm_add_ps(cx, _mm_mul_ps(_mm_mul_ps(x, rw), hw));
+        StoreVectors4(out + v * outStride, outStride, sx, sy, sz, rw);
+    }
+    ProjectVerticesGeneric(in + v * inStride, inStride, out + v * outStride, outStride, count - v, centerX, centerY,
+                           halfWidth, halfHeight);
+}
+
+CKRST_TARGET_SSE2
+static void BoxesClipFlagsSSE2(const VxMatrix &mat, const VxBbox *boxes, int count, CKDWORD *orFlags,
+                               CKDWORD *andFlags) {
+    for (int b = 0; b < count; ++b) {
+        const VxBbox &box = boxes[b];
+        // Corners 0-3 on the min z face, 4-7 on the max z face
+        const __m128 x = _mm_set_ps(box.Max.x, box.Min.x, box.Max.x, box.Min.x);
+        const __m128 y = _mm_set_ps(box.Max.y, box.Max.y, box.Min.y, box.Min.y);
+        __m128i orLanes = _mm_setzero_si128();
+        __m128i andLanes = _mm_set1_epi32(-1);
+        for (int face = 0; face < 2; ++face) {
+            const __m128 z = _mm_set1_ps(face ? box.Max.z : box.Min.z);
+            const __m128i flags = ClipFlags4(TransformLane4(mat, 0, x, y, z), TransformLane4(mat, 1, x, y, z),
+                                             TransformLane4(mat, 2, x, y, z), TransformLane4(mat, 3, x, y, z));
+            orLanes = _mm_or_si128(orLanes, flags);
+            andLanes = _mm_and_si128(andLanes, flags);
+        }
+        CKDWORD o[4], a[4];
+        _mm_storeu_si128((__m128i *) o, orLanes);
+        _mm_storeu_si128((__m128i *) a, andLanes);
+        orFlags[b] = o[0] | o[1] | o[2] | o[3];
+        andFlags[b] = a[0] & a[1] & a[2] & a[3];
+    }
+}
+
+// =====================================================
+// AVX: eight vertices per iteration. There are no 256 bit integer
+// operations before AVX2, so the clip flags are combined as float bits.
+// =====================================================
+
+CKRST_TARGET_AVX
+static inline __m256 Combine4(__m128 lo, __m128 hi) {
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+CKRST_TARGET_AVX
+static inline __m256 TransformLane8(const VxMatrix &mat, int c, __m256 x, __m256 y, __m256 z) {
+    __m256 r = _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(mat[0][c])), _mm256_mul_ps(y, _mm256_set1_ps(mat[1][c])));
+    r = _mm256_add_ps(r, _mm256_mul_ps(z, _mm256_set1_ps(mat[2][c])));
+    return _mm256_add_ps(r, _mm256_set1_ps(mat[3][c]));
+}
+
+CKRST_TARGET_AVX
+static inline __m256 FlagBits8(__m256 mask, int flag) {
+    return _mm256_and_ps(mask, _mm256_castsi256_ps(_mm256_set1_epi32(flag)));
+}
+
+CKRST_TARGET_AVX
+static inline __m256 ClipFlags8(__m256 x, __m256 y, __m256 z, __m256 w) {
+    const __m256 negW = _mm256_xor_ps(w, _mm256_set1_ps(-0.0f));
+    __m256 flags = FlagBits8(_mm256_cmp_ps(negW, x, _CMP_GT_OQ), VXCLIP_LEFT);
+    flags = _mm256_or_ps(flags, FlagBits8(_mm256_cmp_ps(x, w, _CMP_GT_OQ), VXCLIP_RIGHT));
+    flags = _mm256_or_ps(flags, FlagBits8(_mm256_cmp_ps(negW, y, _CMP_GT_OQ), VXCLIP_BOTTOM));
+    flags = _mm256_or_ps(flags, FlagBits8(_mm256_cmp_ps(y, w, _CMP_GT_OQ), VXCLIP_TOP));
+    flags = _mm256_or_ps(flags, FlagBits8(_mm256_cmp_ps(z, _mm256_setzero_ps(), _CMP_LT_OQ), VXCLIP_FRONT));
+    flags = _mm256_or_ps(flags, FlagBits8(_mm256_cmp_ps(z, w, _CMP_GT_OQ), VXCLIP_BACK));
+    return flags;
+}
+
+CKRST_TARGET_AVX
+static inline void StoreVectors8(CKBYTE *out, CKDWORD stride, __m256 x, __m256 y, __m256 z, __m256 w) {
+    __m128 x0 = _mm256_castps256_ps128(x), y0 = _mm256_castps256_ps128(y);
+    __m128 z0 = _mm256_castps256_ps128(z), w0 = _mm256_castps256_ps128(w);
+    __m128 x1 = _mm256_extractf128_ps(x, 1), y1 = _mm256_extractf128_ps(y, 1);
+    __m128 z1 = _mm256_extractf128_ps(z, 1), w1 = _mm256_extractf128_ps(w, 1);
+    _MM_TRANSPOSE4_PS(x0, y0, z0, w0);
+    _MM_TRANSPOSE4_PS(x1, y1, z1, w1);
+    _mm_storeu_ps((float *) out, x0);
+    _mm_storeu_ps((float *) (out + stride), y0);
+    _mm_storeu_ps((float *) (out + 2 * stride), z0);
+    _mm_storeu_ps((float *) (out + 3 * stride), w0);
+    _mm_storeu_ps((float *) (out + 4 * stride), x1);
+    _mm_storeu_ps((float *) (out + 5 * stride), y1);
+    _mm_storeu_ps((float *) (out + 6 * stride), z1);
+    _mm_storeu_ps((float *) (out + 7 * stride), w1);
+}
+
+CKRST_TARGET_AVX
+static CKDWORD TransformVerticesAVX(const VxMatrix &mat, const CKBYTE *in, CKDWORD inStride, CKBYTE *out,
+                                    CKDWORD outStride, CKDWORD *clipFlags, int count) {
+    __m256 andFlags = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    int v = 0;
+    for (; v + 8 <= count; v += 8) {
+        const CKBYTE *src = in + v * inStride;
+        __m128 x0, y0, z0, x1, y1, z1;
+        LoadPositions4(src, inStride, inStride >= 4, x0, y0, z0);
+        LoadPositions4(src + 4 * inStride, inStride, inStride >= 4 && v + 8 < count, x1, y1, z1);
+        const __m256 x = Combine4(x0, x1);
+        const __m256 y = Combine4(y0, y1);
+        const __m256 z = Combine4(z0, z1);
+        const __m256 cx = TransformLane8(mat, 0, x, y, z);
+        const __m256 cy = TransformLane8(mat, 1, x, y, z);
+        const __m256 cz = TransformLane8(mat, 2, x, y, z);
+        const __m256 cw = TransformLane8(mat, 3, x, y, z);
+        if (clipFlags) {
+            const __m256 flags = ClipFlags8(cx, cy, cz, cw);
+            _mm256_storeu_ps((float *) (clipFlags + v), flags);
+            andFlags = _mm256_and_ps(andFlags, flags);
+        }
+        StoreVectors8(out + v * outStride, outStride, cx, cy, cz, cw);
+    }
+
+    CKDWORD lanes[8];
+    _mm256_storeu_ps((float *) lanes, andFlags);
+    CKDWORD result = TransformVerticesSSE2(mat, in + v * inStride, inStride, out + v * outStride, outStride,
+                                           clipFlags ? clipFlags + v : NULL, count - v);
+    for (int i = 0; i < 8; ++i)
+        result &= lanes[i];
+    return result;
+}
+
+CKRST_TARGET_AVX
+static void ProjectVerticesAVX(const CKBYTE *in, CKDWORD inStride, CKBYTE *out, CKDWORD outStride, int count,
+                               float centerX, float centerY, float halfWidth, float halfHeight) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 cx = _mm256_set1_ps(centerX);
+    const __m256 cy = _mm256_set1_ps(centerY);
+    const __m256 hw = _mm256_set1_ps(halfWidth);
+    const __m256 hh = _mm256_set1_ps(halfHeight);
+    int v = 0;
+    for (; v + 8 <= count; v += 8) {
+        const CKBYTE *src = in + v * inStride;
+        __m128 x0 = _mm_loadu_ps((const float *) src);
+        __m128 y0 = _mm_loadu_ps((const float *) (src + inStride));
+        __m128 z0 = _mm_loadu_ps((const float *) (src + 2 * inStride));
+        __m128 w0 = _mm_loadu_ps((const float *) (src + 3 * inStride));
+        __m128 x1 = _mm_loadu_ps((const float *) (src + 4 * inStride));
+        __m128 y1 = _mm_loadu_ps((const float *) (src + 5 * inStride));
+        __m128 z1 = _mm_loadu_ps((const float *) (src + 6 * inStride));
+        __m128 w1 = _mm_loadu_ps((const float *) (src + 7 * inStride));
+        _MM_TRANSPOSE4_PS(x0, y0, z0, w0);
+        _MM_TRANSPOSE4_PS(x1, y1, z1, w1);
+        const __m256 x = Combine4(x0, x1);
+        const __m256 y = Combine4(y0, y1);
+        const __m256 z = Combine4(z0, z1);
+        const __m256 w = Combine4(w0, w1);
+
+        const __m256 rw = _mm256_div_ps(one, w);
+        const __m256 sz = _mm256_mul_ps(rw, z);
+        const __m256 sy = _mm256_sub_ps(cy, _mm256_mul_ps(_mm256_mul_ps(y, rw), hh));
+        const __m256 sx = _mm256_add_ps(cx, _mm256_mul_ps(_mm256_mul_ps(x, rw), hw));
+        StoreVectors8(out + v * outStride, outStride, sx, sy, sz, rw);
+    }
+    ProjectVerticesSSE2(in + v * inStride, inStride, out + v * outStride, outStride, count - v, centerX, centerY,
+                        halfWidth, halfHeight);
+}
+
+CKRST_TARGET_AVX
+static void BoxesClipFlagsAVX(const VxMatrix &mat, const VxBbox *boxes, int count, CKDWORD *orFlags,
+                              CKDWORD *andFlags) {
+    for (int b = 0; b < count; ++b) {
+        const VxBbox &box = boxes[b];
+        // The 8 corners in the generic order
+        const __m256 x = _mm256_set_ps(box.Max.x, box.Min.x, box.Max.x, box.Min.x,
+                                       box.Max.x, box.Min.x, box.Max.x, box.Min.x);
+        const __m256 y = _mm256_set_ps(box.Max.y, box.Max.y, box.Min.y, box.Min.y,
+                                       box.Max.y, box.Max.y, box.Min.y, box.Min.y);
+        const __m256 z = _mm256_set_ps(box.Max.z, box.Max.z, box.Max.z, box.Max.z,
+                                       box.Min.z, box.Min.z, box.Min.z, box.Min.z);
+        const __m256 flags = ClipFlags8(TransformLane8(mat, 0, x, y, z), TransformLane8(mat, 1, x, y, z),
+                                        TransformLane8(mat, 2, x, y, z), TransformLane8(mat, 3, x, y, z));
+        const __m128 lo = _mm256_castps256_ps128(flags);
+        const __m128 hi = _mm256_extractf128_ps(flags, 1);
+        CKDWORD o[4], a[4];
+        _mm_storeu_ps((float *) o, _mm_or_ps(lo, hi));
+        _mm_storeu_ps((float *) a, _mm_and_ps(lo, hi));
+        orFlags[b] = o[0] | o[1] | o[2] | o[3];
+        andFlags[b] = a[0] & a[1] & a[2] & a[3];
+    }
+}
+
+#endif // CKRST_SIMD_X86
+
+// =====================================================
+// Vertex buffer loading
+// One kernel per vertex format of CKRSTGetVertexFormat writes whole
+// vertices in a single pass over the vertex buffer, where copying one
+// attribute at a time walks over it once per attribute. Missing colors are
+// read from their default value with a stride of 0. Large buffers are
+// assembled 4 vertices at a time (a multiple of 16 bytes) and written with
+// non-temporal stores, so they do not evict the cache.
+// =====================================================
+
+enum VertexAttribute {
+    VB_POSITION = 0,
+    VB_NORMAL,
+    VB_DIFFUSE,
+    VB_SPECULAR,
+    VB_TEXCOORD,
+    VB_ATTRIBUTE_COUNT = VB_TEXCOORD + CKRST_MAX_STAGES,
+};
+
+// Largest vertex: transformed position, normal, 2 colors, all texture stages
+#define VB_MAX_VERTEX_SIZE (16 + 12 + 4 + 4 + 8 * CKRST_MAX_STAGES)
+
+// Below this size the written vertices stay in the cache for the driver
+#define VB_STREAM_MIN_SIZE (128 * 1024)
+
+struct VertexSources {
+    const CKBYTE *Ptr[VB_ATTRIBUTE_COUNT];
+    CKDWORD Stride[VB_ATTRIBUTE_COUNT];
+    int TexCount;
+};
+
+template <int Size>
+static inline CKBYTE *CopyAttribute(CKBYTE *dst, const VertexSources &src, int attribute, int v) {
+    memcpy(dst, src.Ptr[attribute] + (size_t) v * src.Stride[attribute], Size);
+    return dst + Size;
+}
+
+// TexCount is -1 for more than 2 texture coordinate sets, read from src
+template <int PositionSize, bool Normal, bool Diffuse, bool Specular, int TexCount>
+static inline void WriteVertex(CKBYTE *dst, const VertexSources &src, int v) {
+    dst = CopyAttribute<PositionSize>(dst, src, VB_POSITION, v);
+    if (Normal)
+        dst = CopyAttribute<sizeof(VxVector)>(dst, src, VB_NORMAL, v);
+    if (Diffuse)
+        dst = CopyAttribute<sizeof(CKDWORD)>(dst, src, VB_DIFFUSE, v);
+    if (Specular)
+        dst = CopyAttribute<sizeof(CKDWORD)>(dst, src, VB_SPECULAR, v);
+    const int texCount = (TexCount >= 0) ? TexCount : src.TexCount;
+    for (int t = 0; t < texCount; ++t)
+        dst = CopyAttribute<2 * sizeof(float)>(dst, src, VB_TEXCOORD + t, v);
+}
+
+template <int PositionSize, bool Normal, bool Diffuse, bool Specular, int TexCount>
+static void LoadVerticesGeneric(CKBYTE *dst, CKDWORD vertexSize, const VertexSources &src, int first, int count) {
+    for (int v = first; v < count; ++v, dst += vertexSize)
+        WriteVertex<PositionSize, Normal, Diffuse, Specular, TexCount>(dst, src, v);
+}
+
+typedef void (*LoadVerticesFunc)(CKBYTE *dst, CKDWORD vertexSize, const VertexSources &src, int first, int count);
+
+#ifdef CKRST_SIMD_X86
+
+// dst must be 16 byte aligned
+template <int PositionSize, bool Normal, bool Diffuse, bool Specular, int TexCount>
+CKRST_TARGET_SSE2 static void LoadVerticesStream(CKBYTE *dst, CKDWORD vertexSize, const VertexSources &src,
+                                                 int first, int count) {
+    __m128i block[4 * VB_MAX_VERTEX_SIZE / 16];
+    CKBYTE *blockPtr = (CKBYTE *) block;
+    const int blockSize = 4 * vertexSize;
+
+    int v = first;
+    for (; v + 4 <= count; v += 4, dst += blockSize) {
+        WriteVertex<PositionSize, Normal, Diffuse, Specular, TexCount>(blockPtr, src, v);
+        WriteVertex<PositionSize, Normal, Diffuse, Specular, TexCount>(blockPtr + vertexSize, src, v + 1);
+        WriteVertex<PositionSize, Normal, Diffuse, Specular, TexCount>(blockPtr + 2 * vertexSize, src, v + 2);
+        WriteVertex<PositionSize, Normal, Diffuse, Specular, TexCount>(blockPtr + 3 * vertexSize, src, v + 3);
+        for (int i = 0; i < blockSize / 16; ++i)
+            _mm_stream_si128((__m128i *) dst + i, _mm_load_si128(block + i));
+    }
+    _mm_sfence();
+
+    LoadVerticesGeneric<PositionSize, Normal, Diffuse, Specular, TexCount>(dst, vertexSize, src, v, count);
+}
+
+#define VB_STREAM_KERNEL(P, N, D, S, T) &LoadVerticesStream<P, N, D, S, T>
+#else
+#define VB_STREAM_KERNEL(P, N, D, S, T) NULL
+#endif // CKRST_SIMD_X86
+
+struct LoadVerticesKernel {
+    CKDWORD Format; // Vertex format without the texture coordinate count
+    int TexCount;   // -1 for more than 2 sets
+    LoadVerticesFunc Generic;
+    LoadVerticesFunc Stream;
+};
+
+#define VB_KERNEL(F, P, N, D, S, T) {F, T, &LoadVerticesGeneric<P, N, D, S, T>, VB_STREAM_KERNEL(P, N, D, S, T)}
+#define VB_KERNELS(F, P, N, D, S) \
+    VB_KERNEL(F, P, N, D, S, 0), VB_KERNEL(F, P, N, D, S, 1), VB_KERNEL(F, P, N, D, S, 2), VB_KERNEL(F, P, N, D, S, -1)
+
+static const LoadVerticesKernel kLoadVerticesKernels[] = {
+    VB_KERNELS(CKRST_VF_POSITION | CKRST_VF_NORMAL, 12, true, false, false),
+    VB_KERNELS(CKRST_VF_POSITION, 12, false, false, false),
+    VB_KERNELS(CKRST_VF_POSITION | CKRST_VF_DIFFUSE, 12, false, true, false),
+    VB_KERNELS(CKRST_VF_POSITION | CKRST_VF_SPECULAR, 12, false, false, true),
+    VB_KERNELS(CKRST_VF_POSITION | CKRST_VF_DIFFUSE | CKRST_VF_SPECULAR, 12, false, true, true),
+    VB_KERNELS(CKRST_VF_RASTERPOS, 16, false, false, false),
+    VB_KERNELS(CKRST_VF_RASTERPOS | CKRST_VF_DIFFUSE, 16, false, true, false),
+    VB_KERNELS(CKRST_VF_RASTERPOS | CKRST_VF_SPECULAR, 16, false, false, true),
+    VB_KERNELS(CKRST_VF_RASTERPOS | CKRST_VF_DIFFUSE | CKRST_VF_SPECULAR, 16, false, true, true),
+};
+
+#undef VB_KERNELS
+#undef VB_KERNEL
+#undef VB_STREAM_KERNEL
+
+// =====================================================
+// Dispatch
+// =====================================================
+
+CKDWORD CKRstTransformVertices(CKRST_SIMD level, const VxMatrix &mat, const void *in, CKDWORD inStride,
+                               VxVector4 *out, CKDWORD outStride, CKDWORD *clipFlags, int count) {
+    CKDWORD andFlags;
+#ifdef CKRST_SIMD_X86
+    if (level >= CKRST_SIMD_AVX)
+        andFlags = TransformVerticesAVX(mat, (const CKBYTE *) in, inStride, (CKBYTE *) out, outStride, clipFlags, count);
+    else if (level >= CKRST_SIMD_SSE2)
+        andFlags = TransformVerticesSSE2(mat, (const CKBYTE *) in, inStride, (CKBYTE *) out, outStride, clipFlags, count);
+    else
+#endif
+        andFlags = TransformVerticesGeneric(mat, (const CKBYTE *) in, inStride, (CKBYTE *) out, outStride, clipFlags, count);
+    return clipFlags ? andFlags : 0;
+}
+
+void CKRstProjectVertices(CKRST_SIMD level, const VxVector4 *in, CKDWORD inStride, VxVector4 *out,
+                          CKDWORD outStride, int count, float centerX, float centerY, float halfWidth,
+                          float halfHeight) {
+#ifdef CKRST_SIMD_X86
+    if (level >= CKRST_SIMD_AVX) {
+        ProjectVerticesAVX((const CKBYTE *) in, inStride, (CKBYTE *) out, outStride, count, centerX, centerY,
+                           halfWidth, halfHeight);
+        return;
+    }
+    if (level >= CKRST_SIMD_SSE2) {
+        ProjectVerticesSSE2((const CKBYTE *) in, inStride, (CKBYTE *) out, outStride, count, centerX, centerY,
+                            halfWidth, halfHeight);
+        return;
+    }
+#endif
+    ProjectVerticesGeneric((const CKBYTE *) in, inStride, (CKBYTE *) out, outStride, count, centerX, centerY,
+                           halfWidth, halfHeight);
+}
+
+void CKRstComputeBoxesClipFlags(CKRST_SIMD level, const VxMatrix &mat, const VxBbox *boxes, int count,
+                                CKDWORD *orFlags, CKDWORD *andFlags) {
+#ifdef CKRST_SIMD_X86
+    if (level >= CKRST_SIMD_AVX) {
+        BoxesClipFlagsAVX(mat, boxes, count, orFlags, andFlags);
+        return;
+    }
+    if (level >= CKRST_SIMD_SSE2) {
+        BoxesClipFlagsSSE2(mat, boxes, count, orFlags, andFlags);
+        return;
+    }
+#endif
+    for (int b = 0; b < count; ++b)
+        BoxClipFlagsGeneric(mat, boxes[b], orFlags[b], andFlags[b]);
+}
+
+CKBOOL CKRstLoadVertices(CKRST_SIMD level, CKBYTE *VBMem, CKDWORD VFormat, CKDWORD VSize,
+                         const VxDrawPrimitiveData *data) {
+    const CKDWORD format = VFormat & ~CKRST_VF_TEXMASK;
+    const int texCount = (int) CKRST_VF_GETTEXCOUNT(VFormat);
+    const int kernelTexCount = (texCount > 2) ? -1 : texCount;
+    const LoadVerticesKernel *kernel = NULL;
+    for (int k = 0; k < (int) (sizeof(kLoadVerticesKernels) / sizeof(kLoadVerticesKernels[0])); ++k) {
+        if (kLoadVerticesKernels[k].Format == format && kLoadVerticesKernels[k].TexCount == kernelTexCount) {
+            kernel = &kLoadVerticesKernels[k];
+            break;
+        }
+    }
+    if (!kernel || texCount > CKRST_MAX_STAGES)
+        return FALSE;
+
+    // The kernels write packed vertices
+    CKDWORD vertexSize = (format & CKRST_VF_RASTERPOS) ? sizeof(VxVector4) : sizeof(VxVector);
+    if (format & CKRST_VF_NORMAL)
+        vertexSize += sizeof(VxVector);
+    if (format & CKRST_VF_DIFFUSE)
+        vertexSize += sizeof(CKDWORD);
+    if (format & CKRST_VF_SPECULAR)
+        vertexSize += sizeof(CKDWORD);
+    vertexSize += texCount * 2 * sizeof(float);
+    if (VSize != vertexSize)
+        return FALSE;
+
+    static const CKDWORD white = 0xFFFFFFFF;
+    static const CKDWORD black = 0;
+    VertexSources src;
+    src.Ptr[VB_POSITION] = (const CKBYTE *) data->PositionPtr;
+    src.Stride[VB_POSITION] = data->PositionStride;
+    src.Ptr[VB_NORMAL] = (const CKBYTE *) data->NormalPtr;
+    src.Stride[VB_NORMAL] = data->NormalStride;
+    src.Ptr[VB_DIFFUSE] = data->ColorPtr ? (const CKBYTE *) data->ColorPtr : (const CKBYTE *) &white;
+    src.Stride[VB_DIFFUSE] = data->ColorPtr ? data->ColorStride : 0;
+    src.Ptr[VB_SPECULAR] = data->SpecularColorPtr ? (const CKBYTE *) data->SpecularColorPtr : (const CKBYTE *) &black;
+    src.Stride[VB_SPECULAR] = data->SpecularColorPtr ? data->SpecularColorStride : 0;
+    src.TexCount = texCount;
+    for (int t = 0; t < texCount; ++t) {
+        src.Ptr[VB_TEXCOORD + t] = (const CKBYTE *) (t ? data->TexCoordPtrs[t - 1] : data->TexCoordPtr);
+        src.Stride[VB_TEXCOORD + t] = t ? data->TexCoordStrides[t - 1] : data->TexCoordStride;
+        if (!src.Ptr[VB_TEXCOORD + t])
+            return FALSE;
+    }
+    if ((format & CKRST_VF_NORMAL) && !src.Ptr[VB_NORMAL])
+        return FALSE;
+
+    const int count = data->VertexCount;
+    if (kernel->Stream && level >= CKRST_SIMD_SSE2 && ((size_t) VBMem & 15) == 0 &&
+        (size_t) count * VSize >= VB_STREAM_MIN_SIZE)
+        kernel->Stream(VBMem, VSize, src, 0, count);
+    else
+        kernel->Generic(VBMem, VSize, src, 0, count);
+    return TRUE;
+}
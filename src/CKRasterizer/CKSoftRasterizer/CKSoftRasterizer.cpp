@@ -0,0 +1,73 @@
+#include "CKSoftRasterizer.h"
+
+#ifdef CK_LIB
+#define CKRasterizerGetInfo CKSoftRasterizerGetInfo
+#endif
+
+CKRasterizer *CKSoftRasterizerStart(WIN_HANDLE AppWnd)
+{
+    CKRasterizer *rasterizer = new CKSoftRasterizer;
+    if (!rasterizer)
+        return NULL;
+
+    if (!rasterizer->Start(AppWnd))
+    {
+        delete rasterizer;
+        return NULL;
+    }
+
+    return rasterizer;
+}
+
+void CKSoftRasterizerClose(CKRasterizer *rst)
+{
+    if (rst)
+    {
+        rst->Close();
+        delete rst;
+    }
+}
+
+PLUGIN_EXPORT void CKRasterizerGetInfo(CKRasterizerInfo *info)
+{
+    info->StartFct = CKSoftRasterizerStart;
+    info->CloseFct = CKSoftRasterizerClose;
+    info->Desc = "Software Rasterizer";
+}
+
+CKSoftRasterizer::CKSoftRasterizer() : m_Init(FALSE) {}
+
+CKSoftRasterizer::~CKSoftRasterizer()
+{
+    Close();
+}
+
+CKBOOL CKSoftRasterizer::Start(WIN_HANDLE AppWnd)
+{
+    m_MainWindow = AppWnd;
+
+    CKSoftRasterizerDriver *driver = new CKSoftRasterizerDriver(this);
+    if (!driver->InitializeCaps())
+    {
+        delete driver;
+        return FALSE;
+    }
+
+    m_Drivers.PushBack(driver);
+    m_Init = TRUE;
+    return TRUE;
+}
+
+void CKSoftRasterizer::Close()
+{
+    if (!m_Init)
+        return;
+
+    while (m_Drivers.Size() != 0)
+    {
+        CKRasterizerDriver *driver = m_Drivers.PopBack();
+        delete driver;
+    }
+
+    m_Init = FALSE;
+}
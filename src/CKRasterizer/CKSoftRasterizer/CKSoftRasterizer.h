@@ -0,0 +1,302 @@
+#ifndef CKRASTERIZERSOFT_H
+#define CKRASTERIZERSOFT_H
+
+#include "CKRasterizer.h"
+#include "CKJobPool.h"
+
+#define CKSOFT_MAX_TEXTURESTAGES 8
+#define CKSOFT_TILE_SIZE 64
+// Pending triangles are rasterized when this many have been binned
+#define CKSOFT_MAX_PENDING_TRIANGLES 65536
+#define CKSOFT_MAX_WORKERS CKJOBPOOL_MAX_WORKERS
+
+/********************************************
+ Textures keep their first level as ARGB8888
+ pixels, mipmaps are not stored.
+*************************************************/
+typedef struct CKSoftTextureDesc : public CKTextureDesc
+{
+public:
+    CKDWORD *Pixels;
+
+public:
+    CKSoftTextureDesc() { Pixels = NULL; }
+    ~CKSoftTextureDesc() { delete[] Pixels; }
+} CKSoftTextureDesc;
+
+typedef struct CKSoftVertexBufferDesc : public CKVertexBufferDesc
+{
+public:
+    CKBYTE *Data;
+
+public:
+    CKSoftVertexBufferDesc() { Data = NULL; }
+    ~CKSoftVertexBufferDesc() { delete[] Data; }
+} CKSoftVertexBufferDesc;
+
+typedef struct CKSoftIndexBufferDesc : public CKIndexBufferDesc
+{
+public:
+    CKWORD *Data;
+
+public:
+    CKSoftIndexBufferDesc() { Data = NULL; }
+    ~CKSoftIndexBufferDesc() { delete[] Data; }
+} CKSoftIndexBufferDesc;
+
+/*******************************************
+ Render states captured when a primitive is
+ submitted: triangles are only rasterized when
+ the frame is flushed.
+*********************************************/
+typedef struct CKSoftDrawState
+{
+    const CKDWORD *Texels; // NULL when no texture is bound to stage 0
+    int TexWidth;
+    int TexHeight;
+    CKDWORD TextureBlend;  // VXTEXTURE_BLENDMODE
+    CKDWORD MinFilter;     // VXTEXTURE_FILTERMODE
+    CKDWORD MagFilter;     // VXTEXTURE_FILTERMODE
+    CKDWORD AddressU;      // VXTEXTURE_ADDRESSMODE
+    CKDWORD AddressV;      // VXTEXTURE_ADDRESSMODE
+    CKDWORD BorderColor;
+    CKDWORD CullMode;      // VXCULL, with VXRENDERSTATE_INVERSEWINDING applied
+    CKDWORD ZEnable;
+    CKDWORD ZWriteEnable;
+    CKDWORD ZFunc;         // VXCMPFUNC
+    CKDWORD AlphaTestEnable;
+    CKDWORD AlphaFunc;     // VXCMPFUNC
+    CKDWORD AlphaRef;
+    CKDWORD AlphaBlendEnable;
+    CKDWORD SrcBlend;      // VXBLEND_MODE
+    CKDWORD DestBlend;     // VXBLEND_MODE
+    CKDWORD ShadeMode;     // VXSHADE_MODE
+    CKDWORD SpecularEnable;
+    CKDWORD Perspective;   // Perspective correct interpolation
+} CKSoftDrawState;
+
+/*******************************************
+ A transformed and lit vertex.
+ Before projection X,Y,Z,W are clip space
+ coordinates, after projection they are the
+ screen position, Z/W and 1/W.
+*********************************************/
+typedef struct CKSoftVertex
+{
+    float X, Y, Z, W;
+    float R, G, B, A;    // Diffuse (0..1)
+    float SR, SG, SB;    // Specular (0..1)
+    float U, V;
+} CKSoftVertex;
+
+typedef struct CKSoftTriangle
+{
+    CKSoftVertex V[3]; // Screen space, counter-clockwise in pixel coordinates
+    int MinX, MinY;    // Pixel bounds (inclusive) clamped to the viewport
+    int MaxX, MaxY;
+    int State;         // Index in CKSoftRasterizerContext::m_DrawStates
+    CKBOOL Minified;   // Texture is minified: use the min filter
+} CKSoftTriangle;
+
+class CKSoftRasterizerDriver;
+class CKSoftRasterizer;
+
+/*****************************************************************
+ CKSoftRasterizerContext override
+
+ Renders without a GPU: vertices are transformed and lit on the
+ calling thread with the fixed function pipeline, triangles are
+ clipped, set up and binned into CKSOFT_TILE_SIZE tiles, and the
+ tiles are rasterized by a worker pool when the frame is flushed
+ (Clear, EndScene, BackToFront, read backs and texture updates).
+ Each tile is owned by one thread and keeps the submission order,
+ so the result does not depend on the worker count.
+
+ Supported states are the ones RCKMaterial::SetAsCurrent issues:
+ culling, depth test/write, alpha test, alpha blending, flat or
+ gouraud shading, specular and the stage 0 texture blend, filter
+ and address modes. Fog, stencil, user clip planes, shaders and
+ the other texture stages are ignored.
+******************************************************************/
+class CKSoftRasterizerContext : public CKRasterizerContext
+{
+public:
+    //--- Construction/destruction
+    CKSoftRasterizerContext(CKSoftRasterizerDriver *driver);
+    virtual ~CKSoftRasterizerContext();
+
+    //--- Creation
+    virtual CKBOOL Create(WIN_HANDLE Window, int PosX = 0, int PosY = 0, int Width = 0, int Height = 0, int Bpp = -1,
+                          CKBOOL Fullscreen = 0, int RefreshRate = 0, int Zbpp = -1, int StencilBpp = -1);
+    //---
+    virtual CKBOOL Resize(int PosX = 0, int PosY = 0, int Width = 0, int Height = 0, CKDWORD Flags = 0);
+    virtual CKBOOL Clear(CKDWORD Flags = CKRST_CTXCLEAR_ALL, CKDWORD Ccol = 0, float Z = 1.0f, CKDWORD Stencil = 0,
+                         int RectCount = 0, CKRECT *rects = NULL);
+    virtual CKBOOL BackToFront(CKBOOL vsync);
+
+    //--- Scene
+    virtual CKBOOL BeginScene();
+    virtual CKBOOL EndScene();
+
+    //--- Lighting & Material States
+    virtual CKBOOL SetLight(CKDWORD Light, CKLightData *data);
+    virtual CKBOOL EnableLight(CKDWORD Light, CKBOOL Enable);
+    virtual CKBOOL SetMaterial(CKMaterialData *mat);
+
+    //--- Viewport State
+    virtual CKBOOL SetViewport(CKViewportData *data);
+
+    //--- Transform Matrix
+    virtual CKBOOL SetTransformMatrix(VXMATRIX_TYPE Type, const VxMatrix &Mat);
+
+    //--- Render states
+    virtual CKBOOL SetRenderState(VXRENDERSTATETYPE State, CKDWORD Value);
+
+    //--- Texture States
+    virtual CKBOOL SetTexture(CKDWORD Texture, int Stage = 0);
+    virtual CKBOOL SetTextureStageState(int Stage, CKRST_TEXTURESTAGESTATETYPE Tss, CKDWORD Value);
+
+    //--- Vertex & Pixel shaders
+    virtual CKBOOL SetVertexShader(CKDWORD VShaderIndex);
+    virtual CKBOOL SetPixelShader(CKDWORD PShaderIndex);
+    virtual CKBOOL SetVertexShaderConstant(CKDWORD Register, const void *Data, CKDWORD CstCount);
+    virtual CKBOOL SetPixelShaderConstant(CKDWORD Register, const void *Data, CKDWORD CstCount);
+
+    //--- Drawing
+    virtual CKBOOL DrawPrimitive(VXPRIMITIVETYPE pType, CKWORD *indices, int indexcount, VxDrawPrimitiveData *data);
+    virtual CKBOOL DrawPrimitiveVB(VXPRIMITIVETYPE pType, CKDWORD VertexBuffer, CKDWORD StartIndex, CKDWORD VertexCount,
+                                   CKWORD *indices = NULL, int indexcount = 0);
+    virtual CKBOOL DrawPrimitiveVBIB(VXPRIMITIVETYPE pType, CKDWORD VB, CKDWORD IB, CKDWORD MinVIndex,
+                                     CKDWORD VertexCount, CKDWORD StartIndex, int Indexcount);
+
+    //--- Creation of Textures, Sprites and Vertex Buffer
+    virtual CKBOOL CreateObject(CKDWORD ObjIndex, CKRST_OBJECTTYPE Type, void *DesiredFormat);
+    virtual CKBOOL DeleteObject(CKDWORD ObjIndex, CKRST_OBJECTTYPE Type);
+
+    //--- Textures
+    virtual CKBOOL LoadTexture(CKDWORD Texture, const VxImageDescEx &SurfDesc, int miplevel = -1);
+    virtual CKBOOL CopyToTexture(CKDWORD Texture, VxRect *Src, VxRect *Dest, CKRST_CUBEFACE Face = CKRST_CUBEFACE_XPOS);
+    virtual CKBOOL SetTargetTexture(CKDWORD TextureObject, int Width = 0, int Height = 0, CKRST_CUBEFACE Face = CKRST_CUBEFACE_XPOS);
+
+    //--- Sprites
+    virtual CKBOOL DrawSprite(CKDWORD Sprite, VxRect *src, VxRect *dst);
+
+    //--- Vertex Buffers
+    virtual void *LockVertexBuffer(CKDWORD VB, CKDWORD StartVertex, CKDWORD VertexCount,
+                                   CKRST_LOCKFLAGS Lock = CKRST_LOCK_DEFAULT);
+    virtual CKBOOL UnlockVertexBuffer(CKDWORD VB);
+    virtual CKBOOL OptimizeVertexBuffer(CKDWORD VB);
+
+    //--- Copy the content of this rendering context to a memory buffer	(CopyToMemoryBuffer)
+    //--- or Updates this rendering context with the content of a memory buffer	(CopyFromMemoryBuffer)
+    virtual int CopyToMemoryBuffer(CKRECT *rect, VXBUFFER_TYPE buffer, VxImageDescEx &img_desc);
+    virtual int CopyFromMemoryBuffer(CKRECT *rect, VXBUFFER_TYPE buffer, const VxImageDescEx &img_desc);
+
+    //--- Threads
+    virtual CKBOOL WarnThread(CKBOOL Enter) { return TRUE; }
+
+    //--- User Clip Plane Function
+    virtual CKBOOL SetUserClipPlane(CKDWORD ClipPlaneIndex, const VxPlane &PlaneEquation) { return FALSE; }
+    virtual CKBOOL GetUserClipPlane(CKDWORD ClipPlaneIndex, VxPlane &PlaneEquation) { return FALSE; }
+
+    //--------- Load a cube map texture face
+    virtual CKBOOL LoadCubeMapTexture(CKDWORD Texture, const VxImageDescEx &SurfDesc, CKRST_CUBEFACE Face, int miplevel = -1) { return FALSE; }
+
+    //--------- Stereo rendering
+    virtual CKBOOL SetDrawBuffer(CKRST_DRAWBUFFER_FLAGS Flags) { return TRUE; }
+
+    //--- Index Buffers
+    virtual void *LockIndexBuffer(CKDWORD IB, CKDWORD StartIndex, CKDWORD IndexCount,
+                                  CKRST_LOCKFLAGS Lock = CKRST_LOCK_DEFAULT);
+    virtual CKBOOL UnlockIndexBuffer(CKDWORD IB);
+
+    //--- Software rendering
+    // Number of threads rasterizing tiles besides the calling thread (0 rasterizes on the calling thread)
+    void SetWorkerCount(int Count);
+    int GetWorkerCount() { return m_Pool.GetWorkerCount(); }
+
+    // Rasterizes the pending triangles
+    void Flush();
+
+    // Framebuffer (ARGB8888 and Z/W), m_Width * m_Height pixels
+    const CKDWORD *GetColorBuffer() const { return m_ColorBuffer.Begin(); }
+    const float *GetDepthBuffer() const { return m_DepthBuffer.Begin(); }
+
+protected:
+    //--- Objects creation
+    CKBOOL CreateTexture(CKDWORD Texture, CKTextureDesc *DesiredFormat);
+    CKBOOL CreateVertexBuffer(CKDWORD VB, CKVertexBufferDesc *DesiredFormat);
+    CKBOOL CreateIndexBuffer(CKDWORD IB, CKIndexBufferDesc *DesiredFormat);
+
+    //--- Pipeline
+    void AllocateBuffers();
+    void RasterizeBins();
+    int CaptureDrawState();
+    void ScreenToClip(CKSoftVertex &v, float x, float y, float z, float rhw);
+    CKBOOL ProcessVertices(VxDrawPrimitiveData *data);
+    void LightVertex(CKSoftVertex &out, const VxVector &position, const VxVector &normal, const VxVector &eye,
+                     CKBOOL specular);
+    void AssemblePrimitives(VXPRIMITIVETYPE pType, const CKWORD *indices, int indexcount, int State);
+    void ClipTriangle(const CKSoftVertex &v0, const CKSoftVertex &v1, const CKSoftVertex &v2, int State);
+    void SetupTriangle(const CKSoftVertex &c0, const CKSoftVertex &c1, const CKSoftVertex &c2, int State);
+    void BinTriangle(int Index);
+    void RasterizeTile(int Tile);
+    static void RasterizeTileTask(void *Context, int Tile);
+
+public:
+    //--- Framebuffer
+    XArray<CKDWORD> m_ColorBuffer;
+    XArray<float> m_DepthBuffer;
+
+    //--- Pending work
+    XArray<CKSoftVertex> m_Vertices;      // Vertices of the current draw call
+    XArray<CKSoftDrawState> m_DrawStates; // One per draw call
+    XArray<CKSoftTriangle> m_Triangles;
+    XClassArray<XArray<int> > m_TileBins; // Triangle indices per tile, in submission order
+    int m_TilesX;
+    int m_TilesY;
+
+    //--- Fixed function states not kept by the base class
+    CKBOOL m_LightEnabled[RST_MAX_LIGHT];
+    CKDWORD m_CurrentTextures[CKSOFT_MAX_TEXTURESTAGES];
+    CKDWORD m_TextureStageStates[CKSOFT_MAX_TEXTURESTAGES][CKRST_TSS_MAXSTATE];
+
+    CKJobPool m_Pool; // Rasterizes the tiles
+    CKSoftRasterizer *m_Owner;
+};
+
+/*****************************************************************
+ CKSoftRasterizerDriver overload
+******************************************************************/
+class CKSoftRasterizerDriver : public CKRasterizerDriver
+{
+public:
+    CKSoftRasterizerDriver(CKSoftRasterizer *rst);
+    virtual ~CKSoftRasterizerDriver();
+
+    //--- Contexts
+    virtual CKRasterizerContext *CreateContext();
+
+    CKBOOL InitializeCaps();
+};
+
+/*****************************************************************
+ CKSoftRasterizer overload
+******************************************************************/
+class CKSoftRasterizer : public CKRasterizer
+{
+public:
+    CKSoftRasterizer();
+    virtual ~CKSoftRasterizer();
+
+    virtual CKBOOL Start(WIN_HANDLE AppWnd);
+    virtual void Close();
+
+public:
+    CKBOOL m_Init;
+};
+
+CKRasterizer *CKSoftRasterizerStart(WIN_HANDLE AppWnd);
+void CKSoftRasterizerClose(CKRasterizer *rst);
+
+#endif
@@ -0,0 +1,1582 @@
+#include "CKSoftRasterizer.h"
+
+#include <math.h>
+
+static inline CKBOOL IsValidArrayIndex(CKDWORD index, int size)
+{
+    return size > 0 && index < static_cast<CKDWORD>(size);
+}
+
+static inline float Saturate(float v)
+{
+    return (v < 0.0f) ? 0.0f : ((v > 1.0f) ? 1.0f : v);
+}
+
+static inline void UnpackColor(CKDWORD c, float out[4])
+{
+    const float k = 1.0f / 255.0f;
+    out[0] = (float) ((c >> 16) & 0xFF) * k;
+    out[1] = (float) ((c >> 8) & 0xFF) * k;
+    out[2] = (float) (c & 0xFF) * k;
+    out[3] = (float) ((c >> 24) & 0xFF) * k;
+}
+
+static inline CKDWORD PackColor(const float c[4])
+{
+    const CKDWORD r = (CKDWORD) (Saturate(c[0]) * 255.0f + 0.5f);
+    const CKDWORD g = (CKDWORD) (Saturate(c[1]) * 255.0f + 0.5f);
+    const CKDWORD b = (CKDWORD) (Saturate(c[2]) * 255.0f + 0.5f);
+    const CKDWORD a = (CKDWORD) (Saturate(c[3]) * 255.0f + 0.5f);
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+template <class T>
+static inline CKBOOL CompareValues(CKDWORD Func, T Value, T Ref)
+{
+    switch (Func)
+    {
+        case VXCMP_NEVER:
+            return FALSE;
+        case VXCMP_LESS:
+            return Value < Ref;
+        case VXCMP_EQUAL:
+            return Value == Ref;
+        case VXCMP_LESSEQUAL:
+            return Value <= Ref;
+        case VXCMP_GREATER:
+            return Value > Ref;
+        case VXCMP_NOTEQUAL:
+            return Value != Ref;
+        case VXCMP_GREATEREQUAL:
+            return Value >= Ref;
+        default:
+            return TRUE;
+    }
+}
+
+// Returns -1 when the texel is the border color
+static inline int AddressTexel(int i, int size, CKDWORD mode)
+{
+    switch (mode)
+    {
+        case VXTEXTURE_ADDRESSCLAMP:
+            return (i < 0) ? 0 : ((i >= size) ? size - 1 : i);
+        case VXTEXTURE_ADDRESSBORDER:
+            return (i < 0 || i >= size) ? -1 : i;
+        case VXTEXTURE_ADDRESSMIRROR:
+        {
+            const int period = size * 2;
+            i %= period;
+            if (i < 0)
+                i += period;
+            return (i >= size) ? period - 1 - i : i;
+        }
+        default:
+            i %= size;
+            return (i < 0) ? i + size : i;
+    }
+}
+
+static inline void FetchTexel(const CKSoftDrawState &st, int x, int y, float out[4])
+{
+    x = AddressTexel(x, st.TexWidth, st.AddressU);
+    y = AddressTexel(y, st.TexHeight, st.AddressV);
+    if (x < 0 || y < 0)
+        UnpackColor(st.BorderColor, out);
+    else
+        UnpackColor(st.Texels[y * st.TexWidth + x], out);
+}
+
+static void SampleTexture(const CKSoftDrawState &st, float u, float v, CKBOOL bilinear, float out[4])
+{
+    const float fx = u * (float) st.TexWidth;
+    const float fy = v * (float) st.TexHeight;
+    if (!bilinear)
+    {
+        FetchTexel(st, (int) floorf(fx), (int) floorf(fy), out);
+        return;
+    }
+
+    const float sx = fx - 0.5f;
+    const float sy = fy - 0.5f;
+    const float x0 = floorf(sx);
+    const float y0 = floorf(sy);
+    const float ax = sx - x0;
+    const float ay = sy - y0;
+    const int ix = (int) x0;
+    const int iy = (int) y0;
+
+    float t00[4], t10[4], t01[4], t11[4];
+    FetchTexel(st, ix, iy, t00);
+    FetchTexel(st, ix + 1, iy, t10);
+    FetchTexel(st, ix, iy + 1, t01);
+    FetchTexel(st, ix + 1, iy + 1, t11);
+    for (int c = 0; c < 4; ++c)
+    {
+        const float top = t00[c] + (t10[c] - t00[c]) * ax;
+        const float bottom = t01[c] + (t11[c] - t01[c]) * ax;
+        out[c] = top + (bottom - top) * ay;
+    }
+}
+
+static void GetBlendFactor(CKDWORD Mode, const float src[4], const float dst[4], float f[4])
+{
+    switch (Mode)
+    {
+        case VXBLEND_ZERO:
+            f[0] = f[1] = f[2] = f[3] = 0.0f;
+            break;
+        case VXBLEND_SRCCOLOR:
+            f[0] = src[0]; f[1] = src[1]; f[2] = src[2]; f[3] = src[3];
+            break;
+        case VXBLEND_INVSRCCOLOR:
+            f[0] = 1.0f - src[0]; f[1] = 1.0f - src[1]; f[2] = 1.0f - src[2]; f[3] = 1.0f - src[3];
+            break;
+        case VXBLEND_SRCALPHA:
+            f[0] = f[1] = f[2] = f[3] = src[3];
+            break;
+        case VXBLEND_INVSRCALPHA:
+            f[0] = f[1] = f[2] = f[3] = 1.0f - src[3];
+            break;
+        case VXBLEND_DESTALPHA:
+            f[0] = f[1] = f[2] = f[3] = dst[3];
+            break;
+        case VXBLEND_INVDESTALPHA:
+            f[0] = f[1] = f[2] = f[3] = 1.0f - dst[3];
+            break;
+        case VXBLEND_DESTCOLOR:
+            f[0] = dst[0]; f[1] = dst[1]; f[2] = dst[2]; f[3] = dst[3];
+            break;
+        case VXBLEND_INVDESTCOLOR:
+            f[0] = 1.0f - dst[0]; f[1] = 1.0f - dst[1]; f[2] = 1.0f - dst[2]; f[3] = 1.0f - dst[3];
+            break;
+        case VXBLEND_SRCALPHASAT:
+            f[0] = f[1] = f[2] = (src[3] < 1.0f - dst[3]) ? src[3] : 1.0f - dst[3];
+            f[3] = 1.0f;
+            break;
+        default:
+            f[0] = f[1] = f[2] = f[3] = 1.0f;
+            break;
+    }
+}
+
+CKSoftRasterizerContext::CKSoftRasterizerContext(CKSoftRasterizerDriver *driver) :
+    CKRasterizerContext(),
+    m_TilesX(0),
+    m_TilesY(0),
+    m_Owner(NULL)
+{
+    memset(m_LightEnabled, 0, sizeof(m_LightEnabled));
+    memset(m_CurrentTextures, 0, sizeof(m_CurrentTextures));
+    memset(m_TextureStageStates, 0, sizeof(m_TextureStageStates));
+    for (int i = 0; i < CKSOFT_MAX_TEXTURESTAGES; ++i)
+    {
+        m_TextureStageStates[i][CKRST_TSS_TEXTUREMAPBLEND] = VXTEXTUREBLEND_MODULATE;
+        m_TextureStageStates[i][CKRST_TSS_MINFILTER] = VXTEXTUREFILTER_NEAREST;
+        m_TextureStageStates[i][CKRST_TSS_MAGFILTER] = VXTEXTUREFILTER_NEAREST;
+        m_TextureStageStates[i][CKRST_TSS_ADDRESSU] = VXTEXTURE_ADDRESSWRAP;
+        m_TextureStageStates[i][CKRST_TSS_ADDRESSV] = VXTEXTURE_ADDRESSWRAP;
+    }
+
+    if (!driver)
+        return;
+
+    m_Driver = driver;
+    m_Owner = static_cast<CKSoftRasterizer *>(driver->m_Owner);
+}
+
+CKSoftRasterizerContext::~CKSoftRasterizerContext()
+{
+    m_Pool.Stop();
+
+    if (m_Owner && m_Owner->m_FullscreenContext == this)
+        m_Owner->m_FullscreenContext = NULL;
+
+    FlushObjects(CKRST_OBJ_ALL);
+}
+
+CKBOOL CKSoftRasterizerContext::Create(WIN_HANDLE Window, int PosX, int PosY, int Width, int Height, int Bpp,
+                                       CKBOOL Fullscreen, int RefreshRate, int Zbpp, int StencilBpp)
+{
+    if (m_Owner && m_Owner->m_FullscreenContext && Fullscreen)
+        return FALSE;
+
+    if (Width <= 0 || Height <= 0)
+    {
+        const VxDisplayMode &dm = m_Driver->m_DisplayModes[0];
+        Width = dm.Width;
+        Height = dm.Height;
+    }
+
+    m_Window = Window;
+    m_PosX = PosX;
+    m_PosY = PosY;
+    m_Width = Width;
+    m_Height = Height;
+    m_Bpp = 32;
+    m_ZBpp = 32;
+    m_StencilBpp = 0;
+    m_PixelFormat = _32_ARGB8888;
+    m_Fullscreen = Fullscreen;
+    m_RefreshRate = RefreshRate;
+
+    if (Fullscreen && m_Owner)
+        m_Owner->m_FullscreenContext = this;
+
+    AllocateBuffers();
+
+    CKViewportData viewport;
+    viewport.ViewX = 0;
+    viewport.ViewY = 0;
+    viewport.ViewWidth = Width;
+    viewport.ViewHeight = Height;
+    viewport.ViewZMin = 0.0f;
+    viewport.ViewZMax = 1.0f;
+    CKRasterizerContext::SetViewport(&viewport);
+
+    FlushRenderStateCache();
+
+    // The calling thread rasterizes tiles too
+    SetWorkerCount(CKJobPool::GetAutoWorkerCount(-1));
+    return TRUE;
+}
+
+void CKSoftRasterizerContext::SetWorkerCount(int Count)
+{
+    if (Count < 0)
+        Count = 0;
+    if (Count != m_Pool.GetWorkerCount())
+        m_Pool.Start(Count);
+}
+
+void CKSoftRasterizerContext::AllocateBuffers()
+{
+    const int pixels = m_Width * m_Height;
+    m_ColorBuffer.Resize(pixels);
+    m_DepthBuffer.Resize(pixels);
+    for (int i = 0; i < pixels; ++i)
+    {
+        m_ColorBuffer[i] = 0;
+        m_DepthBuffer[i] = 1.0f;
+    }
+
+    m_TilesX = (m_Width + CKSOFT_TILE_SIZE - 1) / CKSOFT_TILE_SIZE;
+    m_TilesY = (m_Height + CKSOFT_TILE_SIZE - 1) / CKSOFT_TILE_SIZE;
+    m_TileBins.Resize(m_TilesX * m_TilesY);
+    for (int i = 0; i < m_TileBins.Size(); ++i)
+        m_TileBins[i].Resize(0);
+}
+
+CKBOOL CKSoftRasterizerContext::Resize(int PosX, int PosY, int Width, int Height, CKDWORD Flags)
+{
+    Flush();
+
+    m_PosX = PosX;
+    m_PosY = PosY;
+    if (Width > 0 && Height > 0 && (Width != (int) m_Width || Height != (int) m_Height))
+    {
+        m_Width = Width;
+        m_Height = Height;
+        AllocateBuffers();
+    }
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::Clear(CKDWORD Flags, CKDWORD Ccol, float Z, CKDWORD Stencil, int RectCount, CKRECT *rects)
+{
+    Flush();
+
+    // Like a device, the viewport is cleared when no rectangle is given
+    CKRECT viewport;
+    viewport.left = m_ViewportData.ViewX;
+    viewport.top = m_ViewportData.ViewY;
+    viewport.right = m_ViewportData.ViewX + m_ViewportData.ViewWidth;
+    viewport.bottom = m_ViewportData.ViewY + m_ViewportData.ViewHeight;
+    if (RectCount <= 0 || !rects)
+    {
+        RectCount = 1;
+        rects = &viewport;
+    }
+
+    for (int r = 0; r < RectCount; ++r)
+    {
+        const int left = XMax(rects[r].left, 0);
+        const int top = XMax(rects[r].top, 0);
+        const int right = XMin(rects[r].right, (int) m_Width);
+        const int bottom = XMin(rects[r].bottom, (int) m_Height);
+
+        for (int y = top; y < bottom; ++y)
+        {
+            const int row = y * m_Width;
+            if (Flags & CKRST_CTXCLEAR_COLOR)
+                for (int x = left; x < right; ++x)
+                    m_ColorBuffer[row + x] = Ccol;
+            if (Flags & CKRST_CTXCLEAR_DEPTH)
+                for (int x = left; x < right; ++x)
+                    m_DepthBuffer[row + x] = Z;
+        }
+    }
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::BackToFront(CKBOOL vsync)
+{
+    if (m_SceneBegined)
+        EndScene();
+
+    // There is no front buffer: the back buffer stays readable with CopyToMemoryBuffer
+    Flush();
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::BeginScene()
+{
+    m_SceneBegined = TRUE;
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::EndScene()
+{
+    m_SceneBegined = FALSE;
+    Flush();
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::SetLight(CKDWORD Light, CKLightData *data)
+{
+    if (!data || Light >= RST_MAX_LIGHT)
+        return FALSE;
+    m_CurrentLightData[Light] = *data;
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::EnableLight(CKDWORD Light, CKBOOL Enable)
+{
+    if (Light >= RST_MAX_LIGHT)
+        return FALSE;
+    m_LightEnabled[Light] = Enable;
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::SetMaterial(CKMaterialData *mat)
+{
+    if (!mat)
+        return FALSE;
+    CKRasterizerContext::SetMaterial(mat);
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::SetViewport(CKViewportData *data)
+{
+    if (!data)
+        return FALSE;
+    CKRasterizerContext::SetViewport(data);
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::SetTransformMatrix(VXMATRIX_TYPE Type, const VxMatrix &Mat)
+{
+    return CKRasterizerContext::SetTransformMatrix(Type, Mat);
+}
+
+CKBOOL CKSoftRasterizerContext::SetRenderState(VXRENDERSTATETYPE State, CKDWORD Value)
+{
+    if (State >= VXRENDERSTATE_MAXSTATE)
+        return FALSE;
+
+    // States are read back from the cache when a primitive is submitted
+    if (InternalSetRenderState(State, Value))
+        return TRUE;
+
+    if (State == VXRENDERSTATE_INVERSEWINDING)
+        m_InverseWinding = (Value != 0);
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::SetTexture(CKDWORD Texture, int Stage)
+{
+    if (Stage < 0 || Stage >= CKSOFT_MAX_TEXTURESTAGES)
+        return FALSE;
+
+    if (Texture != 0 && !GetTextureData(Texture))
+        Texture = 0;
+
+    m_CurrentTextures[Stage] = Texture;
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::SetTextureStageState(int Stage, CKRST_TEXTURESTAGESTATETYPE Tss, CKDWORD Value)
+{
+    if (Stage < 0 || Stage >= CKSOFT_MAX_TEXTURESTAGES || Tss >= CKRST_TSS_MAXSTATE)
+        return FALSE;
+
+    m_TextureStageStates[Stage][Tss] = Value;
+    if (Tss == CKRST_TSS_ADDRESS)
+    {
+        m_TextureStageStates[Stage][CKRST_TSS_ADDRESSU] = Value;
+        m_TextureStageStates[Stage][CKRST_TSS_ADDRESSV] = Value;
+    }
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::SetVertexShader(CKDWORD VShaderIndex)
+{
+    // Fixed function only
+    return VShaderIndex == 0;
+}
+
+CKBOOL CKSoftRasterizerContext::SetPixelShader(CKDWORD PShaderIndex)
+{
+    return PShaderIndex == 0;
+}
+
+CKBOOL CKSoftRasterizerContext::SetVertexShaderConstant(CKDWORD Register, const void *Data, CKDWORD CstCount)
+{
+    return FALSE;
+}
+
+CKBOOL CKSoftRasterizerContext::SetPixelShaderConstant(CKDWORD Register, const void *Data, CKDWORD CstCount)
+{
+    return FALSE;
+}
+
+int CKSoftRasterizerContext::CaptureDrawState()
+{
+    CKSoftDrawState st;
+    memset(&st, 0, sizeof(st));
+
+    CKSoftTextureDesc *tex = NULL;
+    if (m_CurrentTextures[0] != 0)
+        tex = static_cast<CKSoftTextureDesc *>(GetTextureData(m_CurrentTextures[0]));
+    if (tex && tex->Pixels)
+    {
+        st.Texels = tex->Pixels;
+        st.TexWidth = tex->Format.Width;
+        st.TexHeight = tex->Format.Height;
+    }
+
+    const CKDWORD *tss = m_TextureStageStates[0];
+    st.TextureBlend = tss[CKRST_TSS_TEXTUREMAPBLEND];
+    st.MinFilter = tss[CKRST_TSS_MINFILTER];
+    st.MagFilter = tss[CKRST_TSS_MAGFILTER];
+    st.AddressU = tss[CKRST_TSS_ADDRESSU];
+    st.AddressV = tss[CKRST_TSS_ADDRESSV];
+    st.BorderColor = tss[CKRST_TSS_BORDERCOLOR];
+
+    st.CullMode = GetRSCacheValue(VXRENDERSTATE_CULLMODE);
+    if (m_InverseWinding)
+    {
+        if (st.CullMode == VXCULL_CW)
+            st.CullMode = VXCULL_CCW;
+        else if (st.CullMode == VXCULL_CCW)
+            st.CullMode = VXCULL_CW;
+    }
+
+    st.ZEnable = GetRSCacheValue(VXRENDERSTATE_ZENABLE);
+    st.ZWriteEnable = GetRSCacheValue(VXRENDERSTATE_ZWRITEENABLE);
+    st.ZFunc = GetRSCacheValue(VXRENDERSTATE_ZFUNC);
+    st.AlphaTestEnable = GetRSCacheValue(VXRENDERSTATE_ALPHATESTENABLE);
+    st.AlphaFunc = GetRSCacheValue(VXRENDERSTATE_ALPHAFUNC);
+    st.AlphaRef = GetRSCacheValue(VXRENDERSTATE_ALPHAREF);
+    st.AlphaBlendEnable = GetRSCacheValue(VXRENDERSTATE_ALPHABLENDENABLE);
+    st.SrcBlend = GetRSCacheValue(VXRENDERSTATE_SRCBLEND);
+    st.DestBlend = GetRSCacheValue(VXRENDERSTATE_DESTBLEND);
+    st.ShadeMode = GetRSCacheValue(VXRENDERSTATE_SHADEMODE);
+    st.SpecularEnable = GetRSCacheValue(VXRENDERSTATE_SPECULARENABLE);
+    st.Perspective = GetRSCacheValue(VXRENDERSTATE_TEXTUREPERSPECTIVE);
+
+    // The BOTH modes override the destination factor
+    if (st.SrcBlend == VXBLEND_BOTHSRCALPHA)
+    {
+        st.SrcBlend = VXBLEND_SRCALPHA;
+        st.DestBlend = VXBLEND_INVSRCALPHA;
+    }
+    else if (st.SrcBlend == VXBLEND_BOTHINVSRCALPHA)
+    {
+        st.SrcBlend = VXBLEND_INVSRCALPHA;
+        st.DestBlend = VXBLEND_SRCALPHA;
+    }
+
+    m_DrawStates.PushBack(st);
+    return m_DrawStates.Size() - 1;
+}
+
+void CKSoftRasterizerContext::ScreenToClip(CKSoftVertex &v, float x, float y, float z, float rhw)
+{
+    // Inverse of the viewport mapping done by TransformVertices
+    const float halfWidth = m_ViewportData.ViewWidth * 0.5f;
+    const float halfHeight = m_ViewportData.ViewHeight * 0.5f;
+    const float centerX = m_ViewportData.ViewX + halfWidth;
+    const float centerY = m_ViewportData.ViewY + halfHeight;
+    const float w = (rhw != 0.0f) ? 1.0f / rhw : 1.0f;
+    v.X = (x - centerX) / halfWidth * w;
+    v.Y = (centerY - y) / halfHeight * w;
+    v.Z = z * w;
+    v.W = w;
+}
+
+void CKSoftRasterizerContext::LightVertex(CKSoftVertex &out, const VxVector &position, const VxVector &normal,
+                                          const VxVector &eye, CKBOOL specular)
+{
+    const CKMaterialData &mat = m_CurrentMaterialData;
+
+    float ambient[3] = {0.0f, 0.0f, 0.0f};
+    float diffuse[3] = {0.0f, 0.0f, 0.0f};
+    float spec[3] = {0.0f, 0.0f, 0.0f};
+
+    for (int i = 0; i < RST_MAX_LIGHT; ++i)
+    {
+        if (!m_LightEnabled[i])
+            continue;
+
+        const CKLightData &light = m_CurrentLightData[i];
+        VxVector dir;
+        float attenuation = 1.0f;
+
+        if (light.Type == VX_LIGHTDIREC)
+        {
+            dir = -light.Direction;
+            dir.Normalize();
+        }
+        else
+        {
+            dir = light.Position - position;
+            const float distance = dir.Magnitude();
+            if (distance > light.Range)
+                continue;
+            if (distance > 0.0f)
+                dir /= distance;
+
+            const float denom = light.Attenuation0 + light.Attenuation1 * distance +
+                                light.Attenuation2 * distance * distance;
+            if (denom > 0.0f)
+                attenuation = 1.0f / denom;
+
+            if (light.Type == VX_LIGHTSPOT)
+            {
+                VxVector spotDir = light.Direction;
+                spotDir.Normalize();
+                const float rho = -DotProduct(dir, spotDir);
+                const float cosInner = cosf(light.InnerSpotCone * 0.5f);
+                const float cosOuter = cosf(light.OuterSpotCone * 0.5f);
+                if (rho <= cosOuter)
+                    continue;
+                if (rho < cosInner && cosInner > cosOuter)
+                    attenuation *= powf((rho - cosOuter) / (cosInner - cosOuter), light.Falloff);
+            }
+        }
+
+        ambient[0] += light.Ambient.r * attenuation;
+        ambient[1] += light.Ambient.g * attenuation;
+        ambient[2] += light.Ambient.b * attenuation;
+
+        const float ndotl = DotProduct(normal, dir);
+        if (ndotl <= 0.0f)
+            continue;
+
+        diffuse[0] += light.Diffuse.r * ndotl * attenuation;
+        diffuse[1] += light.Diffuse.g * ndotl * attenuation;
+        diffuse[2] += light.Diffuse.b * ndotl * attenuation;
+
+        if (specular)
+        {
+            VxVector toEye = eye - position;
+            toEye.Normalize();
+            VxVector halfway = toEye + dir;
+            halfway.Normalize();
+            const float ndoth = DotProduct(normal, halfway);
+            if (ndoth > 0.0f)
+            {
+                const float s = powf(ndoth, mat.SpecularPower) * attenuation;
+                spec[0] += light.Specular.r * s;
+                spec[1] += light.Specular.g * s;
+                spec[2] += light.Specular.b * s;
+            }
+        }
+    }
+
+    float global[4];
+    UnpackColor(GetRSCacheValue(VXRENDERSTATE_AMBIENT), global);
+
+    out.R = Saturate(mat.Emissive.r + mat.Ambient.r * (global[0] + ambient[0]) + mat.Diffuse.r * diffuse[0]);
+    out.G = Saturate(mat.Emissive.g + mat.Ambient.g * (global[1] + ambient[1]) + mat.Diffuse.g * diffuse[1]);
+    out.B = Saturate(mat.Emissive.b + mat.Ambient.b * (global[2] + ambient[2]) + mat.Diffuse.b * diffuse[2]);
+    out.A = Saturate(mat.Diffuse.a);
+    out.SR = Saturate(mat.Specular.r * spec[0]);
+    out.SG = Saturate(mat.Specular.g * spec[1]);
+    out.SB = Saturate(mat.Specular.b * spec[2]);
+}
+
+CKBOOL CKSoftRasterizerContext::ProcessVertices(VxDrawPrimitiveData *data)
+{
+    const int count = data->VertexCount;
+    if (count <= 0 || !data->PositionPtr)
+        return FALSE;
+
+    m_Vertices.Resize(count);
+    CKSoftVertex *vertices = m_Vertices.Begin();
+
+    //--- Position: same transformation as CKRasterizerContext::TransformVertices
+    if (data->Flags & CKRST_DP_TRANSFORM)
+    {
+        UpdateMatrices(WORLD_TRANSFORM);
+        VxStridedData out(vertices, sizeof(CKSoftVertex));
+        VxStridedData in(data->PositionPtr, data->PositionStride);
+        Vx3DMultiplyMatrixVector4Strided(&out, &in, m_TotalMatrix, count);
+    }
+    else
+    {
+        const CKBYTE *ptr = (const CKBYTE *) data->PositionPtr;
+        for (int i = 0; i < count; ++i, ptr += data->PositionStride)
+        {
+            const VxVector4 *p = (const VxVector4 *) ptr;
+            ScreenToClip(vertices[i], p->x, p->y, p->z, p->w);
+        }
+    }
+
+    //--- Colors
+    const CKBOOL lit = (data->Flags & CKRST_DP_TRANSFORM) && (data->Flags & CKRST_DP_LIGHT) && data->NormalPtr &&
+                       GetRSCacheValue(VXRENDERSTATE_LIGHTING);
+    if (lit)
+    {
+        VxMatrix invView;
+        Vx3DInverseMatrix(invView, m_ViewMatrix);
+        const VxVector eye(invView[3][0], invView[3][1], invView[3][2]);
+        const CKBOOL specular = GetRSCacheValue(VXRENDERSTATE_SPECULARENABLE);
+
+        const CKBYTE *pos = (const CKBYTE *) data->PositionPtr;
+        const CKBYTE *nrm = (const CKBYTE *) data->NormalPtr;
+        for (int i = 0; i < count; ++i, pos += data->PositionStride, nrm += data->NormalStride)
+        {
+            VxVector position, normal;
+            Vx3DMultiplyMatrixVector(&position, m_WorldMatrix, (const VxVector *) pos);
+            Vx3DRotateVector(&normal, m_WorldMatrix, (const VxVector *) nrm);
+            normal.Normalize();
+            LightVertex(vertices[i], position, normal, eye, specular);
+        }
+    }
+    else
+    {
+        const CKBYTE *col = (const CKBYTE *) data->ColorPtr;
+        const CKBYTE *spc = (const CKBYTE *) data->SpecularColorPtr;
+        float c[4];
+        for (int i = 0; i < count; ++i)
+        {
+            CKSoftVertex &v = vertices[i];
+            if (col)
+            {
+                UnpackColor(*(const CKDWORD *) col, c);
+                v.R = c[0];
+                v.G = c[1];
+                v.B = c[2];
+                v.A = c[3];
+                col += data->ColorStride;
+            }
+            else
+            {
+                v.R = v.G = v.B = v.A = 1.0f;
+            }
+
+            if (spc)
+            {
+                UnpackColor(*(const CKDWORD *) spc, c);
+                v.SR = c[0];
+                v.SG = c[1];
+                v.SB = c[2];
+                spc += data->SpecularColorStride;
+            }
+            else
+            {
+                v.SR = v.SG = v.SB = 0.0f;
+            }
+        }
+    }
+
+    //--- Texture coordinates of stage 0
+    const CKBYTE *uv = (const CKBYTE *) data->TexCoordPtr;
+    for (int i = 0; i < count; ++i)
+    {
+        if (uv)
+        {
+            vertices[i].U = ((const float *) uv)[0];
+            vertices[i].V = ((const float *) uv)[1];
+            uv += data->TexCoordStride;
+        }
+        else
+        {
+            vertices[i].U = vertices[i].V = 0.0f;
+        }
+    }
+
+    return TRUE;
+}
+
+void CKSoftRasterizerContext::AssemblePrimitives(VXPRIMITIVETYPE pType, const CKWORD *indices, int indexcount, int State)
+{
+    const int vertexCount = m_Vertices.Size();
+    const int count = indices ? indexcount : vertexCount;
+    const CKSoftVertex *vertices = m_Vertices.Begin();
+
+    int i0, i1, i2;
+    for (int t = 0;; ++t)
+    {
+        switch (pType)
+        {
+            case VX_TRIANGLELIST:
+                i0 = t * 3;
+                i1 = i0 + 1;
+                i2 = i0 + 2;
+                break;
+            case VX_TRIANGLESTRIP:
+                // Odd triangles are flipped to keep the winding
+                i0 = t;
+                i1 = (t & 1) ? t + 2 : t + 1;
+                i2 = (t & 1) ? t + 1 : t + 2;
+                break;
+            case VX_TRIANGLEFAN:
+                i0 = 0;
+                i1 = t + 1;
+                i2 = t + 2;
+                break;
+            default:
+                // Points and lines are not rasterized
+                return;
+        }
+
+        if (i0 >= count || i1 >= count || i2 >= count)
+            return;
+
+        if (indices)
+        {
+            i0 = indices[i0];
+            i1 = indices[i1];
+            i2 = indices[i2];
+            if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount)
+                continue;
+        }
+
+        ClipTriangle(vertices[i0], vertices[i1], vertices[i2], State);
+    }
+}
+
+void CKSoftRasterizerContext::ClipTriangle(const CKSoftVertex &v0, const CKSoftVertex &v1, const CKSoftVertex &v2, int State)
+{
+    // Same clip rules as TransformVertices (x,y in [-w,w], z in [0,w]).
+    // x and y are not clipped: setup clamps the triangle bounds to the viewport.
+    const CKSoftVertex *in[3] = {&v0, &v1, &v2};
+    CKDWORD outside = 0xFFFFFFFF;
+    CKDWORD any = 0;
+    const float epsilon = 1e-6f;
+    for (int i = 0; i < 3; ++i)
+    {
+        const CKSoftVertex &v = *in[i];
+        CKDWORD flags = 0;
+        if (-v.W > v.X)
+            flags |= VXCLIP_LEFT;
+        if (v.X > v.W)
+            flags |= VXCLIP_RIGHT;
+        if (-v.W > v.Y)
+            flags |= VXCLIP_BOTTOM;
+        if (v.Y > v.W)
+            flags |= VXCLIP_TOP;
+        if (v.Z < 0.0f || v.W < epsilon)
+            flags |= VXCLIP_FRONT;
+        if (v.Z > v.W)
+            flags |= VXCLIP_BACK;
+        outside &= flags;
+        any |= flags;
+    }
+
+    if (outside)
+        return;
+
+    if ((any & (VXCLIP_FRONT | VXCLIP_BACK)) == 0)
+    {
+        SetupTriangle(v0, v1, v2, State);
+        return;
+    }
+
+    // Sutherland-Hodgman against the near and far planes
+    const int floatCount = sizeof(CKSoftVertex) / sizeof(float);
+    CKSoftVertex buffers[2][8];
+    int counts[2] = {3, 0};
+    buffers[0][0] = v0;
+    buffers[0][1] = v1;
+    buffers[0][2] = v2;
+
+    int src = 0;
+    for (int plane = 0; plane < 2; ++plane)
+    {
+        const int dst = src ^ 1;
+        counts[dst] = 0;
+        for (int i = 0; i < counts[src]; ++i)
+        {
+            const CKSoftVertex &a = buffers[src][i];
+            const CKSoftVertex &b = buffers[src][(i + 1) % counts[src]];
+            const float da = (plane == 0) ? XMin(a.Z, a.W - epsilon) : a.W - a.Z;
+            const float db = (plane == 0) ? XMin(b.Z, b.W - epsilon) : b.W - b.Z;
+
+            if (da >= 0.0f)
+                buffers[dst][counts[dst]++] = a;
+            if ((da >= 0.0f) != (db >= 0.0f))
+            {
+                const float t = da / (da - db);
+                const float *fa = (const float *) &a;
+                const float *fb = (const float *) &b;
+                float *fo = (float *) &buffers[dst][counts[dst]++];
+                for (int k = 0; k < floatCount; ++k)
+                    fo[k] = fa[k] + (fb[k] - fa[k]) * t;
+            }
+        }
+        src = dst;
+        if (counts[src] < 3)
+            return;
+    }
+
+    for (int i = 1; i + 1 < counts[src]; ++i)
+        SetupTriangle(buffers[src][0], buffers[src][i], buffers[src][i + 1], State);
+}
+
+void CKSoftRasterizerContext::SetupTriangle(const CKSoftVertex &c0, const CKSoftVertex &c1, const CKSoftVertex &c2, int State)
+{
+    const CKSoftDrawState &st = m_DrawStates[State];
+
+    const float halfWidth = m_ViewportData.ViewWidth * 0.5f;
+    const float halfHeight = m_ViewportData.ViewHeight * 0.5f;
+    const float centerX = m_ViewportData.ViewX + halfWidth;
+    const float centerY = m_ViewportData.ViewY + halfHeight;
+
+    CKSoftTriangle tri;
+    tri.V[0] = c0;
+    tri.V[1] = c1;
+    tri.V[2] = c2;
+    for (int i = 0; i < 3; ++i)
+    {
+        // Same viewport mapping as TransformVertices
+        CKSoftVertex &v = tri.V[i];
+        const float w = 1.0f / v.W;
+        v.W = w;
+        v.Z = w * v.Z;
+        v.Y = centerY - v.Y * w * halfHeight;
+        v.X = centerX + v.X * w * halfWidth;
+    }
+
+    CKSoftVertex *v = tri.V;
+    float area = (v[1].X - v[0].X) * (v[2].Y - v[0].Y) - (v[1].Y - v[0].Y) * (v[2].X - v[0].X);
+    if (area == 0.0f)
+        return;
+
+    // Screen y goes down: a positive area is clockwise on screen, the front face by default
+    if ((st.CullMode == VXCULL_CCW && area < 0.0f) || (st.CullMode == VXCULL_CW && area > 0.0f))
+        return;
+
+    if (area < 0.0f)
+    {
+        CKSoftVertex tmp = v[1];
+        v[1] = v[2];
+        v[2] = tmp;
+        area = -area;
+    }
+
+    const float minX = XMin(v[0].X, XMin(v[1].X, v[2].X));
+    const float maxX = XMax(v[0].X, XMax(v[1].X, v[2].X));
+    const float minY = XMin(v[0].Y, XMin(v[1].Y, v[2].Y));
+    const float maxY = XMax(v[0].Y, XMax(v[1].Y, v[2].Y));
+
+    const int viewLeft = XMax(m_ViewportData.ViewX, 0);
+    const int viewTop = XMax(m_ViewportData.ViewY, 0);
+    const int viewRight = XMin(m_ViewportData.ViewX + m_ViewportData.ViewWidth, (int) m_Width) - 1;
+    const int viewBottom = XMin(m_ViewportData.ViewY + m_ViewportData.ViewHeight, (int) m_Height) - 1;
+
+    tri.MinX = XMax((int) floorf(minX), viewLeft);
+    tri.MinY = XMax((int) floorf(minY), viewTop);
+    tri.MaxX = XMin((int) ceilf(maxX), viewRight);
+    tri.MaxY = XMin((int) ceilf(maxY), viewBottom);
+    if (tri.MinX > tri.MaxX || tri.MinY > tri.MaxY)
+        return;
+
+    tri.State = State;
+    tri.Minified = FALSE;
+    if (st.Texels)
+    {
+        const float uvArea = (v[1].U - v[0].U) * (v[2].V - v[0].V) - (v[1].V - v[0].V) * (v[2].U - v[0].U);
+        tri.Minified = fabsf(uvArea) * (float) (st.TexWidth * st.TexHeight) > area;
+    }
+
+    if (st.ShadeMode == VXSHADE_FLAT)
+    {
+        for (int i = 1; i < 3; ++i)
+        {
+            v[i].R = v[0].R;
+            v[i].G = v[0].G;
+            v[i].B = v[0].B;
+            v[i].A = v[0].A;
+            v[i].SR = v[0].SR;
+            v[i].SG = v[0].SG;
+            v[i].SB = v[0].SB;
+        }
+    }
+
+    // Attributes are interpolated as a/w then divided by the interpolated 1/w
+    if (st.Perspective)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            float *attr = &v[i].R;
+            for (int k = 0; k < 9; ++k)
+                attr[k] *= v[i].W;
+        }
+    }
+
+    m_Triangles.PushBack(tri);
+    BinTriangle(m_Triangles.Size() - 1);
+
+    if (m_Triangles.Size() >= CKSOFT_MAX_PENDING_TRIANGLES)
+        RasterizeBins();
+}
+
+void CKSoftRasterizerContext::BinTriangle(int Index)
+{
+    const CKSoftTriangle &tri = m_Triangles[Index];
+    const int tx0 = tri.MinX / CKSOFT_TILE_SIZE;
+    const int ty0 = tri.MinY / CKSOFT_TILE_SIZE;
+    const int tx1 = tri.MaxX / CKSOFT_TILE_SIZE;
+    const int ty1 = tri.MaxY / CKSOFT_TILE_SIZE;
+    for (int ty = ty0; ty <= ty1; ++ty)
+        for (int tx = tx0; tx <= tx1; ++tx)
+            m_TileBins[ty * m_TilesX + tx].PushBack(Index);
+}
+
+void CKSoftRasterizerContext::RasterizeTileTask(void *Context, int Tile)
+{
+    static_cast<CKSoftRasterizerContext *>(Context)->RasterizeTile(Tile);
+}
+
+void CKSoftRasterizerContext::RasterizeBins()
+{
+    if (m_Triangles.Size() == 0)
+        return;
+
+    m_Pool.Run(m_TilesX * m_TilesY, &CKSoftRasterizerContext::RasterizeTileTask, this);
+
+    for (int i = 0; i < m_TileBins.Size(); ++i)
+        m_TileBins[i].Resize(0);
+    m_Triangles.Resize(0);
+}
+
+void CKSoftRasterizerContext::Flush()
+{
+    RasterizeBins();
+    m_DrawStates.Resize(0);
+}
+
+static inline CKBOOL IsTopLeftEdge(const CKSoftVertex &a, const CKSoftVertex &b)
+{
+    const float dy = b.Y - a.Y;
+    return dy < 0.0f || (dy == 0.0f && b.X > a.X);
+}
+
+void CKSoftRasterizerContext::RasterizeTile(int Tile)
+{
+    const XArray<int> &bin = m_TileBins[Tile];
+    if (bin.Size() == 0)
+        return;
+
+    const int tileX0 = (Tile % m_TilesX) * CKSOFT_TILE_SIZE;
+    const int tileY0 = (Tile / m_TilesX) * CKSOFT_TILE_SIZE;
+    const int tileX1 = XMin(tileX0 + CKSOFT_TILE_SIZE, (int) m_Width) - 1;
+    const int tileY1 = XMin(tileY0 + CKSOFT_TILE_SIZE, (int) m_Height) - 1;
+
+    CKDWORD *colors = m_ColorBuffer.Begin();
+    float *depths = m_DepthBuffer.Begin();
+
+    for (int b = 0; b < bin.Size(); ++b)
+    {
+        const CKSoftTriangle &tri = m_Triangles[bin[b]];
+        const CKSoftDrawState &st = m_DrawStates[tri.State];
+        const CKSoftVertex &v0 = tri.V[0];
+        const CKSoftVertex &v1 = tri.V[1];
+        const CKSoftVertex &v2 = tri.V[2];
+
+        const int minX = XMax(tri.MinX, tileX0);
+        const int maxX = XMin(tri.MaxX, tileX1);
+        const int minY = XMax(tri.MinY, tileY0);
+        const int maxY = XMin(tri.MaxY, tileY1);
+        if (minX > maxX || minY > maxY)
+            continue;
+
+        // Edge functions E(p) = (b - a) x (p - a), positive inside. Edge i is opposite to vertex i.
+        const CKSoftVertex *edgeA[3] = {&v1, &v2, &v0};
+        const CKSoftVertex *edgeB[3] = {&v2, &v0, &v1};
+        float stepX[3], stepY[3], rowStart[3];
+        CKBOOL topLeft[3];
+        const float px = minX + 0.5f;
+        const float py = minY + 0.5f;
+        for (int e = 0; e < 3; ++e)
+        {
+            const CKSoftVertex &a = *edgeA[e];
+            const CKSoftVertex &bb = *edgeB[e];
+            stepX[e] = -(bb.Y - a.Y);
+            stepY[e] = bb.X - a.X;
+            rowStart[e] = (bb.X - a.X) * (py - a.Y) - (bb.Y - a.Y) * (px - a.X);
+            topLeft[e] = IsTopLeftEdge(a, bb);
+        }
+
+        const float invArea = 1.0f / ((v1.X - v0.X) * (v2.Y - v0.Y) - (v1.Y - v0.Y) * (v2.X - v0.X));
+
+        const CKBOOL bilinear = st.Texels &&
+                                ((tri.Minified ? st.MinFilter : st.MagFilter) != VXTEXTUREFILTER_NEAREST) &&
+                                ((tri.Minified ? st.MinFilter : st.MagFilter) != VXTEXTUREFILTER_MIPNEAREST);
+        const float alphaRef = (float) st.AlphaRef;
+
+        for (int y = minY; y <= maxY; ++y)
+        {
+            float w[3] = {rowStart[0], rowStart[1], rowStart[2]};
+            const int row = y * m_Width;
+
+            for (int x = minX; x <= maxX; ++x, w[0] += stepX[0], w[1] += stepX[1], w[2] += stepX[2])
+            {
+                if (w[0] < 0.0f || w[1] < 0.0f || w[2] < 0.0f)
+                    continue;
+                if ((w[0] == 0.0f && !topLeft[0]) || (w[1] == 0.0f && !topLeft[1]) || (w[2] == 0.0f && !topLeft[2]))
+                    continue;
+
+                const float b0 = w[0] * invArea;
+                const float b1 = w[1] * invArea;
+                const float b2 = w[2] * invArea;
+
+                //--- Depth test
+                const float z = b0 * v0.Z + b1 * v1.Z + b2 * v2.Z;
+                float &depth = depths[row + x];
+                if (st.ZEnable && !CompareValues(st.ZFunc, z, depth))
+                    continue;
+
+                //--- Interpolation
+                float k0 = b0, k1 = b1, k2 = b2;
+                if (st.Perspective)
+                {
+                    const float q = 1.0f / (b0 * v0.W + b1 * v1.W + b2 * v2.W);
+                    k0 *= q;
+                    k1 *= q;
+                    k2 *= q;
+                }
+
+                float color[4];
+                color[0] = k0 * v0.R + k1 * v1.R + k2 * v2.R;
+                color[1] = k0 * v0.G + k1 * v1.G + k2 * v2.G;
+                color[2] = k0 * v0.B + k1 * v1.B + k2 * v2.B;
+                color[3] = k0 * v0.A + k1 * v1.A + k2 * v2.A;
+
+                //--- Texture stage 0
+                if (st.Texels)
+                {
+                    float tex[4];
+                    SampleTexture(st, k0 * v0.U + k1 * v1.U + k2 * v2.U, k0 * v0.V + k1 * v1.V + k2 * v2.V,
+                                  bilinear, tex);
+                    switch (st.TextureBlend)
+                    {
+                        case VXTEXTUREBLEND_DECAL:
+                        case VXTEXTUREBLEND_COPY:
+                            color[0] = tex[0];
+                            color[1] = tex[1];
+                            color[2] = tex[2];
+                            color[3] = tex[3];
+                            break;
+                        case VXTEXTUREBLEND_DECALALPHA:
+                        case VXTEXTUREBLEND_DECALMASK:
+                            color[0] += (tex[0] - color[0]) * tex[3];
+                            color[1] += (tex[1] - color[1]) * tex[3];
+                            color[2] += (tex[2] - color[2]) * tex[3];
+                            break;
+                        case VXTEXTUREBLEND_ADD:
+                            color[0] = XMin(color[0] + tex[0], 1.0f);
+                            color[1] = XMin(color[1] + tex[1], 1.0f);
+                            color[2] = XMin(color[2] + tex[2], 1.0f);
+                            break;
+                        default:
+                            color[0] *= tex[0];
+                            color[1] *= tex[1];
+                            color[2] *= tex[2];
+                            color[3] *= tex[3];
+                            break;
+                    }
+                }
+
+                if (st.SpecularEnable)
+                {
+                    color[0] += k0 * v0.SR + k1 * v1.SR + k2 * v2.SR;
+                    color[1] += k0 * v0.SG + k1 * v1.SG + k2 * v2.SG;
+                    color[2] += k0 * v0.SB + k1 * v1.SB + k2 * v2.SB;
+                }
+
+                //--- Alpha test (the reference is 0..255)
+                if (st.AlphaTestEnable &&
+                    !CompareValues(st.AlphaFunc, (float) (int) (Saturate(color[3]) * 255.0f + 0.5f), alphaRef))
+                    continue;
+
+                //--- Blending
+                CKDWORD &pixel = colors[row + x];
+                if (st.AlphaBlendEnable)
+                {
+                    float dst[4], srcFactor[4], dstFactor[4];
+                    UnpackColor(pixel, dst);
+                    for (int c = 0; c < 4; ++c)
+                        color[c] = Saturate(color[c]);
+                    GetBlendFactor(st.SrcBlend, color, dst, srcFactor);
+                    GetBlendFactor(st.DestBlend, color, dst, dstFactor);
+                    for (int c = 0; c < 4; ++c)
+                        color[c] = color[c] * srcFactor[c] + dst[c] * dstFactor[c];
+                }
+
+                pixel = PackColor(color);
+                if (st.ZEnable && st.ZWriteEnable)
+                    depth = z;
+            }
+
+            rowStart[0] += stepY[0];
+            rowStart[1] += stepY[1];
+            rowStart[2] += stepY[2];
+        }
+    }
+}
+
+CKBOOL CKSoftRasterizerContext::DrawPrimitive(VXPRIMITIVETYPE pType, CKWORD *indices, int indexcount, VxDrawPrimitiveData *data)
+{
+    if (!data || data->VertexCount <= 0)
+        return FALSE;
+
+    if (!m_SceneBegined && !BeginScene())
+        return FALSE;
+
+    if (!indices)
+        indexcount = 0;
+
+    if (!ProcessVertices(data))
+        return FALSE;
+
+    AssemblePrimitives(pType, indices, indexcount, CaptureDrawState());
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::DrawPrimitiveVB(VXPRIMITIVETYPE pType, CKDWORD VertexBuffer, CKDWORD StartIndex,
+                                                CKDWORD VertexCount, CKWORD *indices, int indexcount)
+{
+    if (VertexCount == 0)
+        return FALSE;
+
+    CKSoftVertexBufferDesc *vb = static_cast<CKSoftVertexBufferDesc *>(GetVertexBufferData(VertexBuffer));
+    if (!vb || !vb->Data)
+        return FALSE;
+
+    if (indices && indexcount <= 0)
+        return FALSE;
+    if (!indices)
+        indexcount = 0;
+
+    if (StartIndex + VertexCount > vb->m_MaxVertexCount)
+        return FALSE;
+
+    if (!m_SceneBegined && !BeginScene())
+        return FALSE;
+
+    // Indices are relative to StartIndex
+    VxDrawPrimitiveData data;
+    memset(&data, 0, sizeof(data));
+    CKRSTSetupDPFromVertexBuffer(vb->Data + StartIndex * vb->m_VertexSize, vb, data);
+    data.VertexCount = VertexCount;
+    data.Flags = 0;
+    if ((vb->m_VertexFormat & CKRST_VF_RASTERPOS) == 0)
+        data.Flags |= CKRST_DP_TRANSFORM;
+    if (vb->m_VertexFormat & CKRST_VF_NORMAL)
+        data.Flags |= CKRST_DP_LIGHT;
+    if ((vb->m_VertexFormat & CKRST_VF_TEXMASK) == 0)
+        data.TexCoordPtr = NULL;
+
+    if (!ProcessVertices(&data))
+        return FALSE;
+
+    AssemblePrimitives(pType, indices, indexcount, CaptureDrawState());
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::DrawPrimitiveVBIB(VXPRIMITIVETYPE pType, CKDWORD VB, CKDWORD IB, CKDWORD MinVIndex,
+                                                  CKDWORD VertexCount, CKDWORD StartIndex, int Indexcount)
+{
+    if (VertexCount == 0 || Indexcount <= 0)
+        return FALSE;
+
+    CKSoftIndexBufferDesc *ib = static_cast<CKSoftIndexBufferDesc *>(GetIndexBufferData(IB));
+    if (!ib || !ib->Data)
+        return FALSE;
+
+    if (StartIndex + Indexcount > ib->m_MaxIndexCount)
+        return FALSE;
+
+    // MinVIndex is the base vertex of the indices, as for DrawIndexedPrimitive
+    return DrawPrimitiveVB(pType, VB, MinVIndex, VertexCount, ib->Data + StartIndex, Indexcount);
+}
+
+CKBOOL CKSoftRasterizerContext::CreateObject(CKDWORD ObjIndex, CKRST_OBJECTTYPE Type, void *DesiredFormat)
+{
+    if (!IsValidArrayIndex(ObjIndex, m_Textures.Size()) || !DesiredFormat)
+        return FALSE;
+
+    switch (Type)
+    {
+        case CKRST_OBJ_TEXTURE:
+            return CreateTexture(ObjIndex, static_cast<CKTextureDesc *>(DesiredFormat));
+        case CKRST_OBJ_SPRITE:
+            return CreateSprite(ObjIndex, static_cast<CKSpriteDesc *>(DesiredFormat));
+        case CKRST_OBJ_VERTEXBUFFER:
+            return CreateVertexBuffer(ObjIndex, static_cast<CKVertexBufferDesc *>(DesiredFormat));
+        case CKRST_OBJ_INDEXBUFFER:
+            return CreateIndexBuffer(ObjIndex, static_cast<CKIndexBufferDesc *>(DesiredFormat));
+        default:
+            // No programmable pipeline
+            return FALSE;
+    }
+}
+
+CKBOOL CKSoftRasterizerContext::DeleteObject(CKDWORD ObjIndex, CKRST_OBJECTTYPE Type)
+{
+    // Pending triangles may sample the texture
+    if (Type & (CKRST_OBJ_TEXTURE | CKRST_OBJ_SPRITE))
+        Flush();
+
+    if (!CKRasterizerContext::DeleteObject(ObjIndex, Type))
+        return FALSE;
+
+    if (Type == CKRST_OBJ_TEXTURE)
+    {
+        for (int i = 0; i < CKSOFT_MAX_TEXTURESTAGES; ++i)
+            if (m_CurrentTextures[i] == ObjIndex)
+                m_CurrentTextures[i] = 0;
+    }
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::LoadTexture(CKDWORD Texture, const VxImageDescEx &SurfDesc, int miplevel)
+{
+    CKSoftTextureDesc *desc = static_cast<CKSoftTextureDesc *>(GetTextureData(Texture));
+    if (!desc || !desc->Pixels)
+        return FALSE;
+
+    // Only the first level is sampled
+    if (miplevel > 0)
+        return TRUE;
+
+    Flush();
+
+    VxImageDescEx dst = desc->Format;
+    dst.Image = (XBYTE *) desc->Pixels;
+    VxDoBlit(SurfDesc, dst);
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::CopyToTexture(CKDWORD Texture, VxRect *Src, VxRect *Dest, CKRST_CUBEFACE Face)
+{
+    CKSoftTextureDesc *desc = static_cast<CKSoftTextureDesc *>(GetTextureData(Texture));
+    if (!desc || !desc->Pixels)
+        return FALSE;
+
+    Flush();
+
+    VxRect src(0.0f, 0.0f, (float) m_Width, (float) m_Height);
+    VxRect dst(0.0f, 0.0f, (float) desc->Format.Width, (float) desc->Format.Height);
+    if (Src)
+        src = *Src;
+    if (Dest)
+        dst = *Dest;
+    if (src.GetWidth() <= 0.0f || src.GetHeight() <= 0.0f || dst.GetWidth() <= 0.0f || dst.GetHeight() <= 0.0f)
+        return FALSE;
+
+    const float scaleX = src.GetWidth() / dst.GetWidth();
+    const float scaleY = src.GetHeight() / dst.GetHeight();
+    const int left = XMax((int) dst.left, 0);
+    const int top = XMax((int) dst.top, 0);
+    const int right = XMin((int) dst.right, desc->Format.Width);
+    const int bottom = XMin((int) dst.bottom, desc->Format.Height);
+
+    for (int y = top; y < bottom; ++y)
+    {
+        const int sy = XMin(XMax((int) (src.top + (y - dst.top + 0.5f) * scaleY), 0), (int) m_Height - 1);
+        for (int x = left; x < right; ++x)
+        {
+            const int sx = XMin(XMax((int) (src.left + (x - dst.left + 0.5f) * scaleX), 0), (int) m_Width - 1);
+            desc->Pixels[y * desc->Format.Width + x] = m_ColorBuffer[sy * m_Width + sx];
+        }
+    }
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::SetTargetTexture(CKDWORD TextureObject, int Width, int Height, CKRST_CUBEFACE Face)
+{
+    // Rendering into textures is not supported, CopyToTexture is
+    return TextureObject == 0;
+}
+
+CKBOOL CKSoftRasterizerContext::DrawSprite(CKDWORD Sprite, VxRect *src, VxRect *dst)
+{
+    CKSpriteDesc *sprite = GetSpriteData(Sprite);
+    if (!sprite || sprite->Textures.IsEmpty() || !src || !dst)
+        return FALSE;
+
+    if (src->GetWidth() <= 0.0f || src->GetHeight() <= 0.0f || dst->GetWidth() <= 0.0f || dst->GetHeight() <= 0.0f)
+        return FALSE;
+
+    if (!m_SceneBegined && !BeginScene())
+        return FALSE;
+
+    // Sprites are drawn over the whole context like the DX9 rasterizer does,
+    // with the states it forces, without touching the render state cache.
+    const CKViewportData oldViewport = m_ViewportData;
+    m_ViewportData.ViewX = 0;
+    m_ViewportData.ViewY = 0;
+    m_ViewportData.ViewWidth = m_Width;
+    m_ViewportData.ViewHeight = m_Height;
+
+    const float widthRatio = dst->GetWidth() / src->GetWidth();
+    const float heightRatio = dst->GetHeight() / src->GetHeight();
+
+    for (XArray<CKSPRTextInfo>::Iterator it = sprite->Textures.Begin(); it != sprite->Textures.End(); ++it)
+    {
+        const float tx = it->x;
+        const float ty = it->y;
+        const float tr = tx + it->w;
+        const float tb = ty + it->h;
+        if (tx > src->right || ty > src->bottom || tr < src->left || tb < src->top)
+            continue;
+
+        CKSoftTextureDesc *tex = static_cast<CKSoftTextureDesc *>(GetTextureData(it->IndexTexture));
+        if (!tex || !tex->Pixels)
+            continue;
+
+        float u1 = 0.0f, v1 = 0.0f;
+        float u2 = (float) it->w / it->sw;
+        float v2 = (float) it->h / it->sh;
+        float left = (tx - src->left) * widthRatio + dst->left;
+        float top = (ty - src->top) * heightRatio + dst->top;
+        float right = (tr - src->left) * widthRatio + dst->left;
+        float bottom = (tb - src->top) * heightRatio + dst->top;
+        if (src->right < tr)
+        {
+            right = (src->right - src->left) * widthRatio + dst->left;
+            u2 = (src->right - tx) / it->sw;
+        }
+        if (src->bottom < tb)
+        {
+            bottom = (src->bottom - src->top) * heightRatio + dst->top;
+            v2 = (src->bottom - ty) / it->sh;
+        }
+        if (src->left > tx)
+        {
+            u1 = (src->left - tx) / it->sw;
+            left = dst->left;
+        }
+        if (src->top > ty)
+        {
+            v1 = (src->top - ty) / it->sh;
+            top = dst->top;
+        }
+
+        CKSoftDrawState st;
+        memset(&st, 0, sizeof(st));
+        st.Texels = tex->Pixels;
+        st.TexWidth = tex->Format.Width;
+        st.TexHeight = tex->Format.Height;
+        st.TextureBlend = VXTEXTUREBLEND_COPY;
+        st.MinFilter = VXTEXTUREFILTER_NEAREST;
+        st.MagFilter = VXTEXTUREFILTER_NEAREST;
+        st.AddressU = VXTEXTURE_ADDRESSCLAMP;
+        st.AddressV = VXTEXTURE_ADDRESSCLAMP;
+        st.CullMode = VXCULL_NONE;
+        st.AlphaBlendEnable = TRUE;
+        st.SrcBlend = VXBLEND_SRCALPHA;
+        st.DestBlend = VXBLEND_INVSRCALPHA;
+        st.ShadeMode = VXSHADE_GOURAUD;
+        m_DrawStates.PushBack(st);
+        const int state = m_DrawStates.Size() - 1;
+
+        CKSoftVertex quad[4];
+        memset(quad, 0, sizeof(quad));
+        const float corners[4][4] = {{left, top, u1, v1}, {right, top, u2, v1}, {right, bottom, u2, v2}, {left, bottom, u1, v2}};
+        for (int i = 0; i < 4; ++i)
+        {
+            ScreenToClip(quad[i], corners[i][0], corners[i][1], 0.0f, 1.0f);
+            quad[i].R = quad[i].G = quad[i].B = quad[i].A = 1.0f;
+            quad[i].U = corners[i][2];
+            quad[i].V = corners[i][3];
+        }
+        ClipTriangle(quad[0], quad[1], quad[2], state);
+        ClipTriangle(quad[0], quad[2], quad[3], state);
+    }
+
+    m_ViewportData = oldViewport;
+    return TRUE;
+}
+
+void *CKSoftRasterizerContext::LockVertexBuffer(CKDWORD VB, CKDWORD StartVertex, CKDWORD VertexCount, CKRST_LOCKFLAGS Lock)
+{
+    CKSoftVertexBufferDesc *vb = static_cast<CKSoftVertexBufferDesc *>(GetVertexBufferData(VB));
+    if (!vb || !vb->Data || StartVertex >= vb->m_MaxVertexCount)
+        return NULL;
+
+    // Vertices are transformed when submitted, pending triangles do not reference the buffer
+    return vb->Data + StartVertex * vb->m_VertexSize;
+}
+
+CKBOOL CKSoftRasterizerContext::UnlockVertexBuffer(CKDWORD VB)
+{
+    return GetVertexBufferData(VB) != NULL;
+}
+
+CKBOOL CKSoftRasterizerContext::OptimizeVertexBuffer(CKDWORD VB)
+{
+    return GetVertexBufferData(VB) != NULL;
+}
+
+void *CKSoftRasterizerContext::LockIndexBuffer(CKDWORD IB, CKDWORD StartIndex, CKDWORD IndexCount, CKRST_LOCKFLAGS Lock)
+{
+    CKSoftIndexBufferDesc *ib = static_cast<CKSoftIndexBufferDesc *>(GetIndexBufferData(IB));
+    if (!ib || !ib->Data || StartIndex >= ib->m_MaxIndexCount)
+        return NULL;
+
+    return ib->Data + StartIndex;
+}
+
+CKBOOL CKSoftRasterizerContext::UnlockIndexBuffer(CKDWORD IB)
+{
+    return GetIndexBufferData(IB) != NULL;
+}
+
+int CKSoftRasterizerContext::CopyToMemoryBuffer(CKRECT *rect, VXBUFFER_TYPE buffer, VxImageDescEx &img_desc)
+{
+    if (buffer != VXBUFFER_BACKBUFFER && buffer != VXBUFFER_ZBUFFER)
+        return 0;
+
+    Flush();
+
+    int left = 0, top = 0, right = m_Width, bottom = m_Height;
+    if (rect)
+    {
+        left = XMax(rect->left, 0);
+        top = XMax(rect->top, 0);
+        right = XMin(rect->right, (int) m_Width);
+        bottom = XMin(rect->bottom, (int) m_Height);
+    }
+    if (left >= right || top >= bottom)
+        return 0;
+
+    VxPixelFormat2ImageDesc(_32_ARGB8888, img_desc);
+    if (buffer == VXBUFFER_ZBUFFER)
+        img_desc.AlphaMask = 0;
+    img_desc.Width = right - left;
+    img_desc.Height = bottom - top;
+    img_desc.BytesPerLine = img_desc.Width * 4;
+    if (!img_desc.Image)
+        return 0;
+
+    for (int y = top; y < bottom; ++y)
+    {
+        CKDWORD *out = (CKDWORD *) (img_desc.Image + (y - top) * img_desc.BytesPerLine);
+        if (buffer == VXBUFFER_BACKBUFFER)
+        {
+            memcpy(out, &m_ColorBuffer[y * m_Width + left], (right - left) * sizeof(CKDWORD));
+        }
+        else
+        {
+            // Depth is written as a gray level, like the DX9 rasterizer
+            for (int x = left; x < right; ++x)
+            {
+                const CKDWORD intensity = (CKDWORD) (Saturate(m_DepthBuffer[y * m_Width + x]) * 255.0f);
+                out[x - left] = (intensity << 16) | (intensity << 8) | intensity;
+            }
+        }
+    }
+
+    return img_desc.BytesPerLine * img_desc.Height;
+}
+
+int CKSoftRasterizerContext::CopyFromMemoryBuffer(CKRECT *rect, VXBUFFER_TYPE buffer, const VxImageDescEx &img_desc)
+{
+    if (buffer != VXBUFFER_BACKBUFFER || !img_desc.Image)
+        return 0;
+
+    Flush();
+
+    const int left = rect ? XMax(rect->left, 0) : 0;
+    const int top = rect ? XMax(rect->top, 0) : 0;
+    if (left + img_desc.Width > (int) m_Width || top + img_desc.Height > (int) m_Height)
+        return 0;
+
+    VxImageDescEx dst;
+    VxPixelFormat2ImageDesc(_32_ARGB8888, dst);
+    dst.Width = img_desc.Width;
+    dst.Height = img_desc.Height;
+    dst.BytesPerLine = m_Width * 4;
+    dst.Image = (XBYTE *) &m_ColorBuffer[top * m_Width + left];
+    VxDoBlit(img_desc, dst);
+
+    return img_desc.Width * img_desc.Height * 4;
+}
+
+CKBOOL CKSoftRasterizerContext::CreateTexture(CKDWORD Texture, CKTextureDesc *DesiredFormat)
+{
+    const int width = DesiredFormat->Format.Width;
+    const int height = DesiredFormat->Format.Height;
+    if (width <= 0 || height <= 0)
+        return FALSE;
+
+    Flush();
+
+    CKSoftTextureDesc *desc = new CKSoftTextureDesc;
+    desc->Flags = DesiredFormat->Flags & ~CKRST_TEXTURE_COMPRESSION;
+    desc->Flags |= CKRST_TEXTURE_VALID | CKRST_TEXTURE_RGB | CKRST_TEXTURE_ALPHA;
+    desc->MipMapCount = DesiredFormat->MipMapCount;
+
+    // Textures are stored and sampled as ARGB8888
+    VxPixelFormat2ImageDesc(_32_ARGB8888, desc->Format);
+    desc->Format.Width = width;
+    desc->Format.Height = height;
+    desc->Format.BytesPerLine = width * 4;
+    desc->Pixels = new CKDWORD[width * height];
+    memset(desc->Pixels, 0, width * height * sizeof(CKDWORD));
+
+    if (m_Textures[Texture])
+        delete m_Textures[Texture];
+    m_Textures[Texture] = desc;
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::CreateVertexBuffer(CKDWORD VB, CKVertexBufferDesc *DesiredFormat)
+{
+    if (DesiredFormat->m_MaxVertexCount == 0 || DesiredFormat->m_VertexSize == 0)
+        return FALSE;
+
+    // DesiredFormat may be the current descriptor, copy it before releasing the old one
+    CKSoftVertexBufferDesc *desc = new CKSoftVertexBufferDesc;
+    *static_cast<CKVertexBufferDesc *>(desc) = *DesiredFormat;
+    desc->Data = new CKBYTE[desc->m_MaxVertexCount * desc->m_VertexSize];
+    desc->m_Flags |= CKRST_VB_VALID;
+
+    if (m_VertexBuffers[VB])
+        delete m_VertexBuffers[VB];
+    m_VertexBuffers[VB] = desc;
+    return TRUE;
+}
+
+CKBOOL CKSoftRasterizerContext::CreateIndexBuffer(CKDWORD IB, CKIndexBufferDesc *DesiredFormat)
+{
+    if (DesiredFormat->m_MaxIndexCount == 0)
+        return FALSE;
+
+    CKSoftIndexBufferDesc *desc = new CKSoftIndexBufferDesc;
+    *static_cast<CKIndexBufferDesc *>(desc) = *DesiredFormat;
+    desc->Data = new CKWORD[desc->m_MaxIndexCount];
+    desc->m_Flags |= CKRST_VB_VALID;
+
+    if (m_IndexBuffers[IB])
+        delete m_IndexBuffers[IB];
+    m_IndexBuffers[IB] = desc;
+    return TRUE;
+}
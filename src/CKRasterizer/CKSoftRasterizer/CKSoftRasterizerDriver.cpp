@@ -0,0 +1,56 @@
+#include "CKSoftRasterizer.h"
+
+CKSoftRasterizerDriver::CKSoftRasterizerDriver(CKSoftRasterizer *rst) { m_Owner = rst; }
+
+CKSoftRasterizerDriver::~CKSoftRasterizerDriver() {}
+
+CKRasterizerContext *CKSoftRasterizerDriver::CreateContext()
+{
+    CKSoftRasterizerContext *context = new CKSoftRasterizerContext(this);
+    m_Contexts.PushBack(context);
+    return context;
+}
+
+CKBOOL CKSoftRasterizerDriver::InitializeCaps()
+{
+    // Start from the library NULL caps (one 640x480x32 display mode, ARGB textures)
+    InitNULLRasterizerCaps(m_Owner);
+
+    m_Desc = "Software Rasterizer (Tiled)";
+
+    m_DisplayModes.Resize(3);
+    const int modes[3][2] = {{640, 480}, {1024, 768}, {1920, 1080}};
+    for (int i = 0; i < 3; ++i)
+    {
+        VxDisplayMode &dm = m_DisplayModes[i];
+        dm.Width = modes[i][0];
+        dm.Height = modes[i][1];
+        dm.Bpp = 32;
+        dm.RefreshRate = 60;
+    }
+
+    // Only stage 0 is blended: the engine falls back to multipass rendering
+    // for materials using more textures. Mipmapped filters are sampled from
+    // the first level.
+    m_3DCaps.MinTextureWidth = 1;
+    m_3DCaps.MinTextureHeight = 1;
+    m_3DCaps.MaxTextureWidth = 4096;
+    m_3DCaps.MaxTextureHeight = 4096;
+    m_3DCaps.MaxTextureRatio = 4096;
+    m_3DCaps.MaxClipPlanes = 0;
+    m_3DCaps.MaxNumberBlendStage = 1;
+    m_3DCaps.MaxActiveLights = RST_MAX_LIGHT;
+    m_3DCaps.MaxNumberTextureStage = 1;
+    m_3DCaps.TextureFilterCaps = CKRST_TFILTERCAPS_NEAREST | CKRST_TFILTERCAPS_LINEAR;
+    m_3DCaps.CKRasterizerSpecificCaps =
+        CKRST_SPECIFICCAPS_SPRITEASTEXTURES |
+        CKRST_SPECIFICCAPS_CANDOVERTEXBUFFER |
+        CKRST_SPECIFICCAPS_CANDOINDEXBUFFER |
+        CKRST_SPECIFICCAPS_COPYTEXTURE |
+        CKRST_SPECIFICCAPS_HARDWARETL |
+        CKRST_SPECIFICCAPS_GLATTENUATIONMODEL;
+
+    m_2DCaps.Caps = CKRST_2DCAPS_WINDOWED | CKRST_2DCAPS_3D;
+
+    return TRUE;
+}
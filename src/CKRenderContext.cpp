@@ -207,6 +207,8 @@ CK2dEntity *RCKRenderContext::Get2dRoot(CKBOOL background) {
 void RCKRenderContext::DetachAll() {
     // Based on IDA at 0x10067e01
     m_ObjectExtents.Resize(0);
+    m_PickGrid.Invalidate();
+    m_ObjectExtentsCollected = FALSE;
 
     if (m_RasterizerContext)
         m_RasterizerContext->FlushRenderStateCache();
@@ -560,8 +562,13 @@ CKERROR RCKRenderContext::DrawScene(CK_RENDER_FLAGS Flags) {
 
     if (!(renderFlags & CK_RENDER_DONOTUPDATEEXTENTS)) {
         m_ObjectExtents.Resize(0);
+        m_PickGrid.Invalidate();
+        m_ObjectExtentsCollected = TRUE;
     }
 
+    // Entities moved by their parents since the last frame
+    m_RenderManager->ResolveMovedEntities();
+
     m_RasterizerContext->BeginScene();
     CKERROR err = m_RenderedScene->Draw(renderFlags);
     m_RasterizerContext->EndScene();
@@ -1591,7 +1598,7 @@ void RCKRenderContext::TransformVertices(int VertexCount, VxTransformData *data,
     if (!data)
         return;
     if (Ref) {
-        m_RasterizerContext->SetTransformMatrix(VXMATRIX_WORLD, ((RCK3dEntity *) Ref)->m_WorldMatrix);
+        m_RasterizerContext->SetTransformMatrix(VXMATRIX_WORLD, Ref->GetWorldMatrix());
     }
     m_RasterizerContext->TransformVertices(VertexCount, data);
 }
@@ -1657,7 +1664,42 @@ CK2dEntity *RCKRenderContext::_Pick2D(const Vx2DVector &pt, CKBOOL ignoreUnpicka
     return root->Pick(localPt, ignoreUnpickable);
 }
 
+// Distance from pt to a world box, measured in the referential of ref (world
+// when ref is null). No point of the object is closer, so it is a lower bound
+// of its pick distance; the small margin absorbs rounding in the box transform.
+static float PickDistanceBound(const VxBbox &worldBox, CK3dEntity *ref, const VxVector &pt) {
+    if (worldBox.Min.x > worldBox.Max.x || worldBox.Min.y > worldBox.Max.y || worldBox.Min.z > worldBox.Max.z)
+        return 0.0f;
+
+    VxBbox box = worldBox;
+    if (ref)
+        box.TransformFrom(worldBox, ref->GetInverseWorldMatrix());
+
+    VxVector delta(0.0f, 0.0f, 0.0f);
+    for (int a = 0; a < 3; ++a) {
+        if (pt[a] < box.Min[a])
+            delta[a] = box.Min[a] - pt[a];
+        else if (pt[a] > box.Max[a])
+            delta[a] = pt[a] - box.Max[a];
+    }
+    return delta.Magnitude() * 0.999f;
+}
+
+void RCKRenderContext::UpdatePickGrid() {
+    if (m_PickGrid.IsBuilt())
+        return;
+
+    VxRect viewRect((float) m_ViewportData.ViewX, (float) m_ViewportData.ViewY,
+                    (float) (m_ViewportData.ViewX + m_ViewportData.ViewWidth),
+                    (float) (m_ViewportData.ViewY + m_ViewportData.ViewHeight));
+    m_PickGrid.Build(m_ObjectExtents.Begin(), m_ObjectExtents.Size(), viewRect);
+}
+
 // IDA: 0x100682bc - Internal 3D picking method
+// The object loops go through front to back candidate lists: Path 1 sorts the
+// objects whose box the ray crosses, Path 2 the extents the pick grid returns
+// for the point. Both stop once the next lower bound is beyond the closest hit;
+// equal distances still go to the lowest extent index, as in the linear scan.
 CK3dEntity *RCKRenderContext::Pick3D(const Vx2DVector &pt, VxIntersectionDesc *idesc, CK3dEntity *filter, CKBOOL ignoreUnpickable) {
     // IDA line 83-85: Get object extent count, early exit if empty
     const int objCount = m_ObjectExtents.Size();
@@ -1761,6 +1803,7 @@ CK3dEntity *RCKRenderContext::Pick3D(const Vx2DVector &pt, VxIntersectionDesc *i
             CK3dEntity *pickedEntity = nullptr;
 
             // IDA line 150-165: Iterate through object extents
+            m_PickCandidates.Resize(0);
             for (int j = 0; j < objCount; ++j) {
                 CKObjectExtents *objExt = &m_ObjectExtents[j];
                 RCK3dEntity *entity = (RCK3dEntity *) objExt->m_Entity;
@@ -1777,14 +1820,31 @@ CK3dEntity *RCKRenderContext::Pick3D(const Vx2DVector &pt, VxIntersectionDesc *i
                 // IDA line 155: Get bounding box
                 const VxBbox &bbox = entity->GetBoundingBox(FALSE);
 
-                // IDA line 156-163: Test ray-box intersection, then ray intersection
+                // IDA line 156: Test ray-box intersection
                 if (VxIntersect::RayBox(ray, bbox)) {
-                    if (entity->RayIntersection(&ray.m_Origin, &rayEndPt, &tempDesc, nullptr, CKRAYINTERSECTION_SEGMENT)) {
-                        if (tempDesc.Distance < bestDistance) {
-                            memcpy(idesc, &tempDesc, sizeof(VxIntersectionDesc));
-                            bestDistance = tempDesc.Distance;
-                            pickedEntity = (CK3dEntity *) entity;
-                        }
+                    CKPickCandidate candidate;
+                    candidate.Distance = PickDistanceBound(bbox, nullptr, ray.m_Origin);
+                    candidate.Index = j;
+                    m_PickCandidates.PushBack(candidate);
+                }
+            }
+            CKPickGrid::SortFrontToBack(m_PickCandidates);
+
+            // IDA line 157-163: Ray intersection, closest candidates first
+            int pickedIndex = -1;
+            for (int c = 0; c < m_PickCandidates.Size(); ++c) {
+                const CKPickCandidate &candidate = m_PickCandidates[c];
+                if (candidate.Distance > bestDistance)
+                    break;
+
+                RCK3dEntity *entity = (RCK3dEntity *) m_ObjectExtents[candidate.Index].m_Entity;
+                if (entity->RayIntersection(&ray.m_Origin, &rayEndPt, &tempDesc, nullptr, CKRAYINTERSECTION_SEGMENT)) {
+                    if (tempDesc.Distance < bestDistance ||
+                        (tempDesc.Distance == bestDistance && candidate.Index < pickedIndex)) {
+                        memcpy(idesc, &tempDesc, sizeof(VxIntersectionDesc));
+                        bestDistance = tempDesc.Distance;
+                        pickedEntity = (CK3dEntity *) entity;
+                        pickedIndex = candidate.Index;
                     }
                 }
             }
@@ -1830,10 +1890,16 @@ CK3dEntity *RCKRenderContext::Pick3D(const Vx2DVector &pt, VxIntersectionDesc *i
     RCK3dEntity *currentEntity = nullptr;
     VxIntersectionDesc tempDesc;
 
-    // IDA line 196-248: Iterate through object extents
-    for (int k = 0; k < objCount; ++k) {
-        CKObjectExtents *ext = &m_ObjectExtents[k];
-        currentEntity = (RCK3dEntity *) ext->m_Entity;
+    // IDA line 196-212: Object extents containing the point, from the pick grid
+    CK3dEntity *refEntity = m_RenderedScene ? m_RenderedScene->m_RootEntity : nullptr;
+    UpdatePickGrid();
+    m_PickIndices.Resize(0);
+    m_PickGrid.QueryPoint(m_ObjectExtents.Begin(), localPt, m_PickIndices);
+
+    m_PickCandidates.Resize(0);
+    for (int i = 0; i < m_PickIndices.Size(); ++i) {
+        const int k = m_PickIndices[i];
+        currentEntity = (RCK3dEntity *) m_ObjectExtents[k].m_Entity;
 
         // IDA line 199: Skip null entities and apply filter
         if (!currentEntity)
@@ -1844,15 +1910,20 @@ CK3dEntity *RCKRenderContext::Pick3D(const Vx2DVector &pt, VxIntersectionDesc *i
         if (!ignoreUnpickable && (currentEntity->GetMoveableFlags() & VX_MOVEABLE_PICKABLE) == 0)
             continue;
 
-        // IDA line 201-212: Check if point is within object extent rect
-        if (localPt.x > ext->m_Rect.right)
-            continue;
-        if (localPt.x < ext->m_Rect.left)
-            continue;
-        if (localPt.y > ext->m_Rect.bottom)
-            continue;
-        if (localPt.y < ext->m_Rect.top)
-            continue;
+        CKPickCandidate candidate;
+        candidate.Distance = PickDistanceBound(currentEntity->GetBoundingBox(FALSE), refEntity, rayStart);
+        candidate.Index = k;
+        m_PickCandidates.PushBack(candidate);
+    }
+    CKPickGrid::SortFrontToBack(m_PickCandidates);
+
+    // IDA line 214-248: Closest candidates first
+    int bestIndex = -1;
+    for (int c = 0; c < m_PickCandidates.Size(); ++c) {
+        const CKPickCandidate &candidate = m_PickCandidates[c];
+        if (candidate.Distance > bestDistance)
+            break;
+        currentEntity = (RCK3dEntity *) m_ObjectExtents[candidate.Index].m_Entity;
 
         // IDA line 214-215: Clear temp descriptor
         memset(&tempDesc, 0, sizeof(tempDesc));
@@ -1875,21 +1946,22 @@ CK3dEntity *RCKRenderContext::Pick3D(const Vx2DVector &pt, VxIntersectionDesc *i
                 const float dist = diff.Magnitude();
 
                 // IDA line 223-227: Update best if closer
-                if (dist < bestDistance) {
+                if (dist < bestDistance || (dist == bestDistance && candidate.Index < bestIndex)) {
                     memcpy(idesc, &tempDesc, sizeof(VxIntersectionDesc));
                     bestDistance = dist;
                     bestEntity = (CK3dEntity *) currentEntity;
+                    bestIndex = candidate.Index;
                 }
             }
         }
 
         // IDA line 231-242: Ray intersection test
-        CK3dEntity *refEntity = m_RenderedScene ? m_RenderedScene->m_RootEntity : nullptr;
         if (currentEntity->RayIntersection(&rayStart, &rayEnd, &tempDesc, refEntity, CKRAYINTERSECTION_DEFAULT)) {
-            if (tempDesc.Distance < bestDistance) {
+            if (tempDesc.Distance < bestDistance || (tempDesc.Distance == bestDistance && candidate.Index < bestIndex)) {
                 memcpy(idesc, &tempDesc, sizeof(VxIntersectionDesc));
                 bestDistance = tempDesc.Distance;
                 bestEntity = (CK3dEntity *) currentEntity;
+                bestIndex = candidate.Index;
             }
         }
     }
@@ -1981,6 +2053,49 @@ static int RectIntersectTest(const VxRect *a, const VxRect *b) {
     return 1;
 }
 
+struct PickEntityEntry {
+    CK3dEntity *Entity;
+    int Index;
+};
+
+static int ComparePickEntities(const void *a, const void *b) {
+    const PickEntityEntry *ea = (const PickEntityEntry *) a;
+    const PickEntityEntry *eb = (const PickEntityEntry *) b;
+    if (ea->Entity != eb->Entity)
+        return ea->Entity < eb->Entity ? -1 : 1;
+    return ea->Index - eb->Index;
+}
+
+static int ComparePickIndices(const void *a, const void *b) {
+    return *(const int *) a - *(const int *) b;
+}
+
+// Keeps the first extent of each entity (an entity drawn several times since
+// the extents were reset has several) and sorts them in drawing order.
+static void UniqueEntitiesInRenderOrder(const CKObjectExtents *extents, XArray<int> &indices) {
+    const int count = indices.Size();
+    if (count < 2)
+        return;
+
+    XArray<PickEntityEntry> entries;
+    entries.Resize(count);
+    for (int i = 0; i < count; ++i) {
+        entries[i].Entity = extents[indices[i]].m_Entity;
+        entries[i].Index = indices[i];
+    }
+    ::qsort(entries.Begin(), count, sizeof(PickEntityEntry), ComparePickEntities);
+
+    int unique = 0;
+    for (int i = 0; i < count; ++i) {
+        if (unique == 0 || entries[i].Entity != entries[unique - 1].Entity)
+            entries[unique++] = entries[i];
+    }
+    indices.Resize(unique);
+    for (int i = 0; i < unique; ++i)
+        indices[i] = entries[i].Index;
+    ::qsort(indices.Begin(), unique, sizeof(int), ComparePickIndices);
+}
+
 // IDA: 0x10068abc
 CKERROR RCKRenderContext::RectPick(const VxRect &r, XObjectPointerArray &oObjects, CKBOOL Intersect) {
     // IDA line 29-30: Return error if oObjects is null (shouldn't happen with reference, but matches IDA check)
@@ -2011,8 +2126,30 @@ CKERROR RCKRenderContext::RectPick(const VxRect &r, XObjectPointerArray &oObject
     // IDA line 42: Normalize pickRect (sub_1006ED20)
     pickRect.Normalize();
 
-    // IDA line 43-66: Iterate through 3D entities in rendered scene
-    if (m_RenderedScene) {
+    // IDA line 43-66: Iterate through 3D entities in rendered scene. Once a
+    // DrawScene collected the object extents, the pick grid narrows the scan
+    // to the entities drawn over the rectangle.
+    if (m_RenderedScene && m_ObjectExtentsCollected) {
+        UpdatePickGrid();
+        m_PickIndices.Resize(0);
+        m_PickGrid.QueryRect(m_ObjectExtents.Begin(), pickRect, m_PickIndices);
+        UniqueEntitiesInRenderOrder(m_ObjectExtents.Begin(), m_PickIndices);
+
+        for (int i = 0; i < m_PickIndices.Size(); ++i) {
+            CK3dEntity *ent = m_ObjectExtents[m_PickIndices[i]].m_Entity;
+            if (!ent)
+                continue;
+            if ((ent->GetObjectFlags() & CK_OBJECT_INTERFACEOBJ) != 0)
+                continue;
+            if (!ent->IsVisible())
+                continue;
+
+            ent->GetRenderExtents(extRect);
+            int result = RectIntersectTest(&extRect, &pickRect);
+            if (result != 0 && (!Intersect || result != 2))
+                oObjects.PushFront(ent);
+        }
+    } else if (m_RenderedScene) {
         for (CK3dEntity **it = (CK3dEntity **) m_RenderedScene->m_3DEntities.Begin();
              it != (CK3dEntity **) m_RenderedScene->m_3DEntities.End(); ++it) {
             CK3dEntity *ent = *it;
@@ -2616,6 +2753,9 @@ RCKRenderContext::RCKRenderContext(CKContext *Context, CKSTRING name) : CKRender
     m_EyeSeparation = 100.0f;
     m_Camera = nullptr;
     m_PVInformation = (CKDWORD) -1;
+    m_ObjectExtentsCollected = FALSE;
+    m_OcclusionActive = FALSE;
+    m_PortalActive = FALSE;
     m_NCUTex = nullptr;
     m_DpFlags = 0;
     m_VertexBufferCount = 0;
@@ -3007,7 +3147,7 @@ void RCKRenderContext::RenderTransparents(CKDWORD flags) {
             }
 
             VxMatrix mvp;
-            Vx3DMultiplyMatrix4(mvp, viewProj, entity->m_WorldMatrix);
+            Vx3DMultiplyMatrix4(mvp, viewProj, entity->GetWorldMatrix());
             const VxBbox &bbox = entity->GetBoundingBox(TRUE);
             VxProjectBoxZExtents(mvp, bbox, items[i].zhMin, items[i].zhMax);
         }
@@ -3116,6 +3256,7 @@ void RCKRenderContext::AddExtents2D(const VxRect &rect, CKObject *obj) {
         extents.m_Entity = (CK3dEntity *) obj;
         extents.m_Camera = 0;
         m_ObjectExtents.PushBack(extents);
+        m_PickGrid.Invalidate();
     } else {
         // Merge with current extents (no associated object)
         if (rect.left < m_CurrentExtents.left)
@@ -14,6 +14,8 @@
 #include "RCKSpriteText.h"
 #include "RCKVertexBuffer.h"
 
+#include <stdlib.h>
+
 // External reference to rasterizer info array from CK2_3D.cpp
 extern XClassArray<CKRasterizerInfo> g_RasterizersInfo;
 
@@ -90,6 +92,15 @@ RCKRenderManager::RCKRenderManager(CKContext *context) : CKRenderManager(context
     m_VertexCache.Set("VertexCache", 16);
     m_Options.PushBack(&m_VertexCache);
 
+    // 0: greedy VertexCacheOptimizer, 1: ForsythVertexCacheOptimizer
+    m_VertexCacheOptimizerType.Set("VertexCacheOptimizer", 0);
+    m_Options.PushBack(&m_VertexCacheOptimizerType);
+
+    // Cache misses allowed to the overdraw pass on opaque groups, in percent
+    // of the vertex cache order (105: 5% more), 0 to skip it
+    m_OverdrawThreshold.Set("OverdrawThreshold", 0);
+    m_Options.PushBack(&m_OverdrawThreshold);
+
     m_SortTransparentObjects.Set("SortTransparentObjects", TRUE);
     m_Options.PushBack(&m_SortTransparentObjects);
 
@@ -126,6 +137,30 @@ RCKRenderManager::RCKRenderManager(CKContext *context) : CKRenderManager(context
     m_DisablePerspectiveCorrection.Set("DisablePerspectiveCorrection", FALSE);
     m_Options.PushBack(&m_DisablePerspectiveCorrection);
 
+    m_FlatSceneCulling.Set("FlatSceneCulling", FALSE);
+    m_Options.PushBack(&m_FlatSceneCulling);
+
+    m_MeshRayBVHThreshold.Set("MeshRayBVHThreshold", 256);
+    m_Options.PushBack(&m_MeshRayBVHThreshold);
+
+    // -1: one worker per extra hardware thread, 0: run on the main thread only
+    m_WorkerThreads.Set("WorkerThreads", -1);
+    m_Options.PushBack(&m_WorkerThreads);
+    m_JobPoolStarted = FALSE;
+    m_SkinBatch = 0;
+    m_SkinBatchCount = 0;
+
+    m_OcclusionCulling.Set("OcclusionCulling", FALSE);
+    m_Options.PushBack(&m_OcclusionCulling);
+
+    // Occlusion buffer width in pixels, the height follows the viewport ratio
+    m_OcclusionBufferWidth.Set("OcclusionBufferWidth", 256);
+    m_Options.PushBack(&m_OcclusionBufferWidth);
+
+    // Skip the places the portals of the camera place do not reach
+    m_PortalCulling.Set("PortalCulling", FALSE);
+    m_Options.PushBack(&m_PortalCulling);
+
     ApplyIniRenderOptions(this);
 
     m_RenderContextMaskFree = -1;
@@ -316,6 +351,9 @@ CKERROR RCKRenderManager::PreProcess() {
 }
 
 CKERROR RCKRenderManager::PostProcess() {
+    // World matrices of the frame, before the moved entities are reset
+    ResolveMovedEntities();
+
     // Set moved flag on all moved entities
     for (RCK3dEntity **it = (RCK3dEntity **) m_MovedEntities.Begin();
          it != (RCK3dEntity **) m_MovedEntities.End(); ++it) {
@@ -417,6 +455,7 @@ CKERROR RCKRenderManager::OnCKPause() {
 CKERROR RCKRenderManager::SequenceToBeDeleted(CK_ID *objids, int count) {
     m_Entities.Check();
     m_MovedEntities.Check();
+    m_Occluders.Check();
     m_SceneGraphRootNode.Check();
     return CK_OK;
 }
@@ -650,6 +689,13 @@ static void ApplyRenderOptionChange(RCKRenderManager *manager, CKSTRING optionNa
         return;
     }
 
+    if (stricmp(optionName, manager->m_WorkerThreads.Key.CStr()) == 0) {
+        // Restarted with the new count on next use
+        manager->m_JobPool.Stop();
+        manager->m_JobPoolStarted = FALSE;
+        return;
+    }
+
     if (stricmp(optionName, manager->m_DisableMipmap.Key.CStr()) == 0)
         InvalidateTextureVideoMemory(manager);
 
@@ -755,9 +801,111 @@ CKMaterial *RCKRenderManager::GetDefaultMaterial() {
     return m_DefaultMat;
 }
 
+CKJobPool *RCKRenderManager::GetJobPool() {
+    if (!m_JobPoolStarted) {
+        m_JobPool.Start(CKJobPool::GetAutoWorkerCount((int) m_WorkerThreads.Value));
+        m_JobPoolStarted = TRUE;
+    }
+    return &m_JobPool;
+}
+
+// Entities of BatchSkins: the opaque ones RCK3dEntity::Render skins before
+// their callbacks (not the progressive meshes) and that may be drawn
+static CKBOOL IsSkinToBatch(RCK3dEntity *entity, RCKRenderContext *rc, CKBOOL culled) {
+    if (!entity || !entity->m_Skin || !entity->m_CurrentMesh || entity->m_CurrentMesh->IsPM())
+        return FALSE;
+    CKSceneGraphNode *node = entity->m_SceneGraphNode;
+    if (!node || (node->m_RenderContextMask & rc->m_MaskFree) == 0)
+        return FALSE;
+    if (!entity->IsToBeRendered() || entity->IsToBeRenderedLast())
+        return FALSE;
+
+    const VxBbox &box = entity->GetBoundingBox(FALSE);
+    if (culled) {
+        if (node->HasAnyFlags(CKSGN_CULLOUTSIDE))
+            return FALSE;
+    } else if (!rc->m_RasterizerContext->ComputeBoxVisibility(box, TRUE, nullptr)) {
+        return FALSE;
+    }
+    return !rc->m_OcclusionActive || !rc->m_OcclusionBuffer.IsBoxOccluded(box);
+}
+
+static int CompareSkinEntityMeshes(const void *a, const void *b) {
+    const RCKMesh *meshA = (*(RCK3dEntity *const *) a)->m_CurrentMesh;
+    const RCKMesh *meshB = (*(RCK3dEntity *const *) b)->m_CurrentMesh;
+    return (meshA < meshB) ? -1 : (meshA > meshB) ? 1 : 0;
+}
+
+void RCKRenderManager::BatchSkins(RCKRenderContext *rc) {
+    m_SkinBatch = 0;
+
+    // Without workers Render skins them one by one at the same cost
+    CKJobPool *pool = GetJobPool();
+    if (pool->GetWorkerCount() == 0 || !rc->m_RenderedScene || !rc->m_RasterizerContext)
+        return;
+
+    rc->m_SkinTimeProfiler.Reset();
+    rc->m_RasterizerContext->UpdateMatrices(VIEW_TRANSFORM);
+    const CKBOOL culled = m_SceneGraphBVH.IsCulled();
+    XObjectPointerArray &entities = rc->m_RenderedScene->m_3DEntities;
+    m_SkinEntities.Resize(0);
+    for (CKObject **it = entities.Begin(); it != entities.End(); ++it) {
+        RCK3dEntity *entity = (RCK3dEntity *) *it;
+        if (IsSkinToBatch(entity, rc, culled))
+            m_SkinEntities.PushBack(entity);
+    }
+
+    // Entities sharing a mesh skin the same vertices: Render keeps skinning
+    // each of them just before drawing it
+    const int candidateCount = m_SkinEntities.Size();
+    ::qsort(m_SkinEntities.Begin(), candidateCount, sizeof(RCK3dEntity *), CompareSkinEntityMeshes);
+    m_SkinJobs.Resize(0);
+    int count = 0;
+    for (int i = 0; i < candidateCount;) {
+        int end = i + 1;
+        while (end < candidateCount && m_SkinEntities[end]->m_CurrentMesh == m_SkinEntities[i]->m_CurrentMesh)
+            ++end;
+        CKSkinJob job;
+        if (end == i + 1 && m_SkinEntities[i]->PrepareSkinJob(job)) {
+            m_SkinEntities[count++] = m_SkinEntities[i];
+            m_SkinJobs.PushBack(job);
+        }
+        i = end;
+    }
+    m_SkinEntities.Resize(count);
+    if (count == 0)
+        return;
+
+    RCKSkin::CalcPointsBatch(m_SkinJobs.Begin(), count, pool);
+
+    if (++m_SkinBatchCount == 0)
+        m_SkinBatchCount = 1;
+    m_SkinBatch = m_SkinBatchCount;
+    for (int i = 0; i < count; ++i) {
+        m_SkinEntities[i]->FinishSkinJob(m_SkinJobs[i]);
+        m_SkinEntities[i]->m_Skin->SetBatch(m_SkinBatch, m_SkinEntities[i]);
+    }
+    rc->m_Stats.SkinTime += rc->m_SkinTimeProfiler.Current();
+}
+
+void RCKRenderManager::SetOccluder(CK3dEntity *entity, CKBOOL occluder) {
+    if (!entity)
+        return;
+    if (occluder)
+        m_Occluders.AddIfNotHere(entity);
+    else
+        m_Occluders.Remove(entity);
+}
+
+CKBOOL RCKRenderManager::IsOccluder(CK3dEntity *entity) {
+    return entity && m_Occluders.FindObject(entity);
+}
+
 void RCKRenderManager::DetachAllObjects() {
+    ResolveMovedEntities();
     m_MovedEntities.Clear();
     m_Entities.Clear();
+    m_Occluders.Clear();
 
     for (CK_ID *it = m_RenderContexts.Begin(); it != m_RenderContexts.End(); ++it) {
         CKRenderContext *ctx = (CKRenderContext *) m_Context->GetObject(*it);
@@ -822,6 +970,13 @@ void RCKRenderManager::UnregisterLastFrameEntity(RCK3dEntity *entity) {
     m_Entities.Remove(entity);
 }
 
+void RCKRenderManager::ResolveMovedEntities() {
+    for (RCK3dEntity **it = (RCK3dEntity **) m_MovedEntities.Begin();
+         it != (RCK3dEntity **) m_MovedEntities.End(); ++it) {
+        (*it)->ResolveWorldMatrix();
+    }
+}
+
 void RCKRenderManager::CleanMovedEntities() {
     int count = 0;
     for (RCK3dEntity **it = (RCK3dEntity **) m_MovedEntities.Begin();
@@ -14,10 +14,73 @@
 #include "RCK2dEntity.h"
 #include "RCKCamera.h"
 #include "RCKLight.h"
+#include "RCKMesh.h"
+#include "RCKPlace.h"
 
 extern int g_UpdateTransparency;
 extern int g_FogProjectionMode;
 
+// Rasterizes the visible occluders into the occlusion buffer of the render
+// context, with the view projection matrix of the traversal
+static CKBOOL BuildOcclusionBuffer(RCKRenderContext *rc, RCKRenderManager *rm, CKRasterizerContext *rst) {
+    const int viewWidth = rc->m_ViewportData.ViewWidth;
+    const int viewHeight = rc->m_ViewportData.ViewHeight;
+    if (viewWidth <= 0 || viewHeight <= 0)
+        return FALSE;
+
+    int width = (int) rm->m_OcclusionBufferWidth.Value;
+    if (width < 16)
+        width = 16;
+    else if (width > 2048)
+        width = 2048;
+    int height = (int) ((float) width * (float) viewHeight / (float) viewWidth + 0.5f);
+    if (height < 1)
+        height = 1;
+    rc->m_OcclusionBuffer.Begin(width, height, rst->m_ViewProjMatrix);
+
+    for (CKObject **it = rm->m_Occluders.Begin(); it != rm->m_Occluders.End(); ++it) {
+        RCK3dEntity *entity = (RCK3dEntity *) *it;
+        RCKMesh *mesh = entity->m_CurrentMesh;
+        if (!mesh || !entity->IsVisible() || !(entity->m_InRenderContext & rc->m_MaskFree))
+            continue;
+
+        CKDWORD stride = 0;
+        const CKBYTE *positions = (const CKBYTE *) mesh->GetPositionsPtr(&stride);
+        const int indexCount = mesh->GetFaceCount() * 3;
+        if (mesh->HasWideIndices())
+            rc->m_OcclusionBuffer.AddOccluder(entity->GetWorldMatrix(), positions, stride, mesh->GetVertexCount(),
+                                              mesh->GetFacesIndices32(), indexCount);
+        else
+            rc->m_OcclusionBuffer.AddOccluder(entity->GetWorldMatrix(), positions, stride, mesh->GetVertexCount(),
+                                              mesh->GetFacesIndices(), indexCount);
+    }
+    return TRUE;
+}
+
+// Walks the portals from the place of the camera: the place it is attached
+// to, or else the first place whose box holds the viewpoint
+static CKBOOL ComputePortalVisibility(RCKRenderContext *rc, RCKRenderManager *rm, RCK3dEntity *viewpoint,
+                                      CKRasterizerContext *rst) {
+    CKPlace *cameraPlace = rc->m_Camera ? rc->m_Camera->GetReferencePlace() : nullptr;
+    if (!cameraPlace) {
+        VxVector position;
+        viewpoint->GetPosition(&position, nullptr);
+        XArray<CKSceneGraphNode *> &roots = rm->m_SceneGraphRootNode.m_Children;
+        for (CKSceneGraphNode **it = roots.Begin(); it != roots.End(); ++it) {
+            RCK3dEntity *entity = (*it)->m_Entity;
+            if (entity && entity->GetClassID() == CKCID_PLACE && entity->GetBoundingBox(FALSE).VectorIn(position)) {
+                cameraPlace = (CKPlace *) entity;
+                break;
+            }
+        }
+    }
+    if (!cameraPlace)
+        return FALSE;
+
+    rc->m_PortalVisibility.Compute(cameraPlace, rst->m_ViewProjMatrix);
+    return TRUE;
+}
+
 CKRenderedScene::CKRenderedScene(CKRenderContext *rc) {
     // IDA: 0x1006f830
     m_RenderContext = rc;
@@ -186,7 +249,8 @@ CKERROR CKRenderedScene::Draw(CK_RENDER_FLAGS Flags) {
 
         if (camera) {
             // Copy camera world matrix to root entity (3x4 part = 0x30 bytes)
-            VxMatrix *camMatrix = (VxMatrix *) &camera->m_WorldMatrix;
+            VxMatrix *camMatrix = (VxMatrix *) &camera->GetWorldMatrix();
+            rootEntity->ResolveWorldMatrix();
             VxMatrix *rootMatrix = (VxMatrix *) &rootEntity->m_WorldMatrix;
             memcpy(rootMatrix, camMatrix, sizeof(VxMatrix) - sizeof(VxVector4));
             rootEntity->WorldMatrixChanged(FALSE, TRUE);
@@ -223,6 +287,7 @@ CKERROR CKRenderedScene::Draw(CK_RENDER_FLAGS Flags) {
 
         // Build view frustum
         float aspectRatio = (float) rc->m_ViewportData.ViewWidth / (float) rc->m_ViewportData.ViewHeight;
+        rootEntity->ResolveWorldMatrix();
         VxVector *origin = (VxVector *) &rootEntity->m_WorldMatrix[3];
         VxVector *vright = (VxVector *) &rootEntity->m_WorldMatrix[0];
         VxVector *up = (VxVector *) &rootEntity->m_WorldMatrix[1];
@@ -267,7 +332,34 @@ CKERROR CKRenderedScene::Draw(CK_RENDER_FLAGS Flags) {
         rc->m_Stats.SceneTraversalTime = 0.0f;
         rc->m_SceneTraversalTimeProfiler.Reset();
 
+        if (rm->m_FlatSceneCulling.Value) {
+            // The refit reads the world matrices from the pool workers:
+            // resolve the ones the pre-render callbacks moved first
+            rm->ResolveMovedEntities();
+            rm->m_SceneGraphBVH.Update(&rm->m_SceneGraphRootNode, rm->GetJobPool());
+            rst->UpdateMatrices(VIEW_TRANSFORM);
+            rm->m_SceneGraphBVH.Cull(rst->m_ViewProjMatrix);
+        } else if (rm->m_SceneGraphBVH.GetNodeCount() > 0) {
+            rm->m_SceneGraphBVH.Clear();
+        }
+
+        rc->m_OcclusionActive = FALSE;
+        if (rm->m_OcclusionCulling.Value && rm->m_Occluders.Size() > 0) {
+            rst->UpdateMatrices(VIEW_TRANSFORM);
+            rc->m_OcclusionActive = BuildOcclusionBuffer(rc, rm, rst);
+        }
+
+        rc->m_PortalActive = FALSE;
+        if (rm->m_PortalCulling.Value) {
+            rst->UpdateMatrices(VIEW_TRANSFORM);
+            rc->m_PortalActive = ComputePortalVisibility(rc, rm, rootEntity, rst);
+        }
+
+        rm->BatchSkins(rc);
         rm->m_SceneGraphRootNode.RenderTransparentObjects(rc, renderFlags);
+        rm->EndSkinBatch();
+        rc->m_OcclusionActive = FALSE;
+        rc->m_PortalActive = FALSE;
 
         rc->m_Stats.SceneTraversalTime += rc->m_SceneTraversalTimeProfiler.Current();
 
@@ -510,7 +602,8 @@ void CKRenderedScene::PrepareCameras(CK_RENDER_FLAGS flags) {
         RCKCamera *cam = (RCKCamera *) m_AttachedCamera;
         RCK3dEntity *rootEntity = (RCK3dEntity *) m_RootEntity;
 
-        memcpy(&rootEntity->m_WorldMatrix, &cam->m_WorldMatrix, sizeof(rootEntity->m_WorldMatrix));
+        rootEntity->ResolveBeforeMove(TRUE);
+        memcpy(&rootEntity->m_WorldMatrix, &cam->GetWorldMatrix(), sizeof(rootEntity->m_WorldMatrix));
         ((RCK3dEntity *) m_RootEntity)->WorldMatrixChanged(TRUE, FALSE);
 
         if (!cam->IsUpToDate()) {
@@ -8,6 +8,11 @@
 #include "RCK3dEntity.h"
 #include "RCKPlace.h"
 
+#include <cstdlib>
+#include <cstring>
+
+static CKDWORD g_SceneGraphTopologyStamp = 0;
+
 static CKDWORD GetSceneGraphPriorityKey(const CKSceneGraphNode *n) {
     const CKWORD p = (CKWORD) n->m_Priority;
     const CKWORD mp = (CKWORD) n->m_MaxPriority;
@@ -79,6 +84,202 @@ static int ClassifyTransparentOrder(const RCK3dEntity *a, const RCK3dEntity *b,
     return (prod >= 0.0f) ? 1 : -1;
 }
 
+static int ClassifyTransparentObjects(const CKTransparentObject &a, const CKTransparentObject &b, void *arg) {
+    return ClassifyTransparentOrder(a.m_Node->m_Entity, b.m_Node->m_Entity, *(const VxVector *) arg);
+}
+
+// Pair test of the CK2_3D.dll bubble sort: TRUE when k must move in front of prev.
+static CKBOOL ShouldSwapTransparentObjects(const CKTransparentObject &k, const CKTransparentObject &prev,
+                                           CKTransparentSorter::ClassifyFunc classify, void *arg) {
+    if (k.m_Node->m_MaxPriority > prev.m_Node->m_MaxPriority)
+        return TRUE;
+    if (k.m_Node->m_MaxPriority != prev.m_Node->m_MaxPriority)
+        return FALSE;
+
+    // IDA/DLL behavior:
+    // - If projected Z ranges do NOT overlap, swap directly.
+    // - If they overlap, use sub_10009BB9 as an expensive tie-breaker,
+    //   then a final epsilon compare using EPSILON.
+    //
+    // Overlap test reconstructed from FPU status checks in the DLL:
+    //   (prev.ZhMin < k.ZhMax) && (k.ZhMin <= prev.ZhMax)
+    if (!(prev.m_ZhMin < k.m_ZhMax))
+        return FALSE;
+
+    // Non-overlap case: swap.
+    if (!(k.m_ZhMin <= prev.m_ZhMax))
+        return TRUE;
+
+    // Overlap case: tie-breaker.
+    const int cmp1 = classify(prev, k, arg);
+    if (cmp1 != 0)
+        return cmp1 < 0;
+
+    const int cmp2 = classify(k, prev, arg);
+    if (cmp2 != 0)
+        return cmp2 > 0;
+
+    return ShouldSwapTransparentTieFallback(k, prev);
+}
+
+// Maps a float to an unsigned key with the same ordering.
+static CKDWORD GetSortableFloatKey(float value) {
+    CKDWORD bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+}
+
+static int CompareTransparentIndices(const void *a, const void *b) {
+    const CKDWORD ia = *(const CKDWORD *) a;
+    const CKDWORD ib = *(const CKDWORD *) b;
+    return (ia < ib) ? -1 : (ia > ib) ? 1 : 0;
+}
+
+// =====================================================
+// CKTransparentSorter
+// =====================================================
+
+CKTransparentSorter::CKTransparentSorter() : m_OverlapClusterCount(0) {}
+
+void CKTransparentSorter::Sort(XClassArray<CKTransparentObject> &objects, ClassifyFunc classify, void *arg) {
+    m_OverlapClusterCount = 0;
+
+    const int count = objects.Size();
+    if (count < 2)
+        return;
+
+    m_Keys.Resize(count);
+
+    // Secondary key: farthest ZhMax first.
+    for (int i = 0; i < count; ++i)
+        m_Keys[i] = ~GetSortableFloatKey(objects[i].m_ZhMax);
+    m_Sorter.ResetIndices();
+    m_Sorter.Sort(m_Keys.Begin(), count, false);
+
+    // Primary key: highest priority first. Radix passes are stable, so the
+    // indices of the depth pass are carried over.
+    for (int i = 0; i < count; ++i)
+        m_Keys[i] = (CKDWORD) (0xFFFF - (CKWORD) objects[i].m_Node->m_MaxPriority);
+    m_Sorter.Sort(m_Keys.Begin(), count, false);
+
+    // The keys are no longer needed: they hold the sorted order from here on.
+    const CKDWORD *indices = m_Sorter.GetIndices();
+    CKDWORD *order = m_Keys.Begin();
+    for (int i = 0; i < count; ++i)
+        order[i] = indices[i];
+    m_Sorted.Resize(count);
+
+    // One sweep over the sorted intervals: a run of same priority objects whose
+    // ZhMax reaches the lowest ZhMin seen so far forms an overlap cluster.
+    // Objects outside a cluster are strictly ordered by depth and need no tie-breaker.
+    // The members of a cluster are bubble sorted from their input order, not
+    // the depth order: the bubble sort then makes the same swaps inside the
+    // cluster as over the whole list, even when the classifier is not
+    // transitive (as long as it never orders a pair both ways).
+    int start = 0;
+    while (start < count) {
+        const short priority = objects[order[start]].m_Node->m_MaxPriority;
+        float clusterMin = objects[order[start]].m_ZhMin;
+
+        int end = start + 1;
+        while (end < count) {
+            const CKTransparentObject &object = objects[order[end]];
+            if (object.m_Node->m_MaxPriority != priority || object.m_ZhMax < clusterMin)
+                break;
+            if (object.m_ZhMin < clusterMin)
+                clusterMin = object.m_ZhMin;
+            ++end;
+        }
+
+        if (end - start > 1)
+            ::qsort(order + start, end - start, sizeof(CKDWORD), CompareTransparentIndices);
+        for (int i = start; i < end; ++i)
+            m_Sorted[i] = objects[order[i]];
+        if (end - start > 1) {
+            SortLegacy(m_Sorted.Begin() + start, m_Sorted.Begin() + end, classify, arg);
+            ++m_OverlapClusterCount;
+        }
+        start = end;
+    }
+
+    for (int i = 0; i < count; ++i)
+        objects[i] = m_Sorted[i];
+}
+
+void CKTransparentSorter::SortLegacy(CKTransparentObject *begin, CKTransparentObject *end, ClassifyFunc classify, void *arg) {
+    if (end - begin < 2)
+        return;
+
+    CKBOOL noSwaps = TRUE;
+    for (CKTransparentObject *i = begin + 1; i != end; ++i) {
+        for (CKTransparentObject *k = end - 1; k != (i - 1); --k) {
+            CKTransparentObject *prev = k - 1;
+            if (ShouldSwapTransparentObjects(*k, *prev, classify, arg)) {
+                SwapTransparentObjects(k, prev);
+                noSwaps = FALSE;
+            }
+        }
+
+        if (noSwaps)
+            break;
+        noSwaps = TRUE;
+    }
+}
+
+// Uses the flat culling pass result when available, otherwise the per-node hierarchical test.
+static CKBOOL IsHierarchyInViewFrustum(CKSceneGraphNode *node, RCKRenderContext *rc) {
+    if (rc->m_RenderManager->m_SceneGraphBVH.IsCulled()) {
+        if (node->HasAnyFlags(CKSGN_CULLOUTSIDE)) {
+            node->SetAsOutsideFrustum();
+            return FALSE;
+        }
+        if (node->HasAnyFlags(CKSGN_CULLINSIDE))
+            node->SetAsInsideFrustum();
+        return TRUE;
+    }
+
+    return node->m_Entity->IsInViewFrustrumHierarchic((CKRenderContext *) rc);
+}
+
+// Software occlusion test (OcclusionCulling option): TRUE when the occluders
+// of the traversal hide the whole hierarchical box of the node. Occluded
+// characters still count as rendered, as in the frustum test above.
+static CKBOOL IsHierarchyOccluded(CKSceneGraphNode *node, RCKRenderContext *rc) {
+    if (!rc->m_OcclusionActive)
+        return FALSE;
+
+    node->ComputeHierarchicalBox();
+    if (!node->IsHierarchyBoxValid() || !rc->m_OcclusionBuffer.IsBoxOccluded(node->m_Bbox))
+        return FALSE;
+
+    if (node->m_Entity->GetClassID() == CKCID_CHARACTER)
+        node->m_Entity->m_MoveableFlags |= VX_MOVEABLE_CHARACTERRENDERED;
+    return TRUE;
+}
+
+// Viewport clip of a place: its ViewportClip, narrowed to the rectangle it is
+// seen through when the portals were walked this frame (PortalCulling option).
+// FALSE when no portal of the camera place reaches it, or when the two
+// rectangles do not overlap.
+static CKBOOL GetPlaceClip(RCKPlace *place, RCKRenderContext *rc, VxRect &clip) {
+    clip = place->ViewportClip();
+    if (!rc->m_PortalActive)
+        return TRUE;
+
+    VxRect portalRect;
+    if (!rc->m_PortalVisibility.GetPlaceRect((CKPlace *) place, portalRect))
+        return FALSE;
+    if (clip.IsNull() || !ShouldApplyPlaceClip(clip)) {
+        clip = portalRect;
+        return TRUE;
+    }
+    clip.left = XMax(clip.left, portalRect.left);
+    clip.top = XMax(clip.top, portalRect.top);
+    clip.right = XMin(clip.right, portalRect.right);
+    clip.bottom = XMin(clip.bottom, portalRect.bottom);
+    return clip.left < clip.right && clip.top < clip.bottom;
+}
+
 static void RenderTransparentObjectsRecursive(CKSceneGraphNode *node, CKSceneGraphRootNode *root, RCKRenderContext *rc, CKDWORD flags) {
     if (!node || !root)
         return;
@@ -96,7 +297,7 @@ static void RenderTransparentObjectsRecursive(CKSceneGraphNode *node, CKSceneGra
         if (node->m_Entity) {
             node->m_Entity->ModifyMoveableFlags(0, VX_MOVEABLE_EXTENTSUPTODATE);
 
-            if (!node->m_Entity->IsInViewFrustrumHierarchic((CKRenderContext *) rc)) {
+            if (!IsHierarchyInViewFrustum(node, rc)) {
                 if (node->m_Entity->GetClassID() == CKCID_CHARACTER) {
                     VxBbox expanded = node->m_Bbox;
                     expanded.Max *= 2.0f;
@@ -110,9 +311,18 @@ static void RenderTransparentObjectsRecursive(CKSceneGraphNode *node, CKSceneGra
                 return;
             }
 
+            if (IsHierarchyOccluded(node, rc)) {
+                node->ClearTransparentFlags();
+                return;
+            }
+
             if (node->m_Entity->GetClassID() == CKCID_PLACE) {
                 RCKPlace *place = (RCKPlace *) node->m_Entity;
-                VxRect &clip = place->ViewportClip();
+                VxRect clip;
+                if (!GetPlaceClip(place, rc, clip)) {
+                    node->ClearTransparentFlags();
+                    return;
+                }
                 if (!clip.IsNull()) {
                     if (ShouldApplyPlaceClip(clip)) {
                         clipRectSet = TRUE;
@@ -180,6 +390,9 @@ static void RenderTransparentObjectsRecursive(CKSceneGraphNode *node, CKSceneGra
     if (!node->m_Entity->IsInViewFrustrum((CKRenderContext *) rc, flags))
         return;
 
+    if (IsHierarchyOccluded(node, rc))
+        return;
+
     if (node->m_Entity->IsToBeRenderedLast()) {
         node->m_TimeFpsCalc = rc->m_TimeFpsCalc;
         root->AddTransparentObject(node);
@@ -208,6 +421,7 @@ CKSceneGraphNode::CKSceneGraphNode(RCK3dEntity *entity) {
     m_EntityMask = 0;
     m_Parent = nullptr;
     m_ChildToBeParsedCount = 0;
+    m_FlatIndex = -1;
 }
 
 CKSceneGraphNode::~CKSceneGraphNode() {
@@ -222,6 +436,11 @@ CKSceneGraphNode::~CKSceneGraphNode() {
 
     m_Children.Clear();
     m_ChildToBeParsedCount = 0;
+    ++g_SceneGraphTopologyStamp;
+}
+
+CKDWORD CKSceneGraphNode::GetTopologyStamp() {
+    return g_SceneGraphTopologyStamp;
 }
 
 // =====================================================
@@ -239,6 +458,7 @@ void CKSceneGraphNode::AddNode(CKSceneGraphNode *node) {
 
     // Add to children array
     m_Children.PushBack(node);
+    ++g_SceneGraphTopologyStamp;
 
     // Invalidate bounding box
     node->InvalidateBox(TRUE);
@@ -285,6 +505,7 @@ void CKSceneGraphNode::RemoveNode(CKSceneGraphNode *node) {
 
     // Remove from children array using iterator-style removal
     m_Children.RemoveAt(removeIndex);
+    ++g_SceneGraphTopologyStamp;
 
     // Update indices of subsequent children
     int newIndex = removeIndex;
@@ -466,6 +687,14 @@ void CKSceneGraphNode::InvalidateBox(CKBOOL propagate) {
     // Clear the "box valid" flags (0xC = 0x4 | 0x8)
     InvalidateHierarchyBox();
 
+    // The flat culling structure only refits the nodes it is told about,
+    // their ancestors follow when the box changes
+    if (m_FlatIndex >= 0 && m_Entity) {
+        RCKRenderManager *rm = (RCKRenderManager *) m_Entity->GetCKContext()->GetRenderManager();
+        if (rm)
+            rm->m_SceneGraphBVH.NodeInvalidated(this);
+    }
+
     // Propagate to parents if requested
     if (propagate) {
         for (CKSceneGraphNode *parent = m_Parent;
@@ -563,12 +792,17 @@ void CKSceneGraphNode::NoTestsTraversal(RCKRenderContext *dev, CKDWORD flags) {
     SetAsPotentiallyVisible();
     SetAsInsideFrustum();
 
+    if (IsHierarchyOccluded(this, dev))
+        return;
+
     if (NeedsSort())
         SortNodes();
 
     if (m_Entity->GetClassID() == CKCID_PLACE) {
         RCKPlace *place = (RCKPlace *) m_Entity;
-        VxRect &clip = place->ViewportClip();
+        VxRect clip;
+        if (!GetPlaceClip(place, dev, clip))
+            return;
         if (!clip.IsNull()) {
             if (ShouldApplyPlaceClip(clip)) {
                 clipRectSet = TRUE;
@@ -664,67 +898,7 @@ void CKSceneGraphRootNode::SortTransparentObjects(RCKRenderContext *dev, CKDWORD
                 cameraPos = static_cast<VxVector>(rootWorldMatrix[3]);
             }
 
-            CKBOOL noSwaps = TRUE;
-            for (CKTransparentObject *i = m_TransparentObjects.Begin() + 1; i != m_TransparentObjects.End(); ++i) {
-                for (CKTransparentObject *k = m_TransparentObjects.End() - 1; k != (i - 1); --k) {
-                    CKTransparentObject *prev = k - 1;
-
-                    if (k->m_Node->m_MaxPriority > prev->m_Node->m_MaxPriority) {
-                        SwapTransparentObjects(k, prev);
-                        noSwaps = FALSE;
-                        continue;
-                    }
-
-                    if (k->m_Node->m_MaxPriority == prev->m_Node->m_MaxPriority) {
-                        // IDA/DLL behavior:
-                        // - If projected Z ranges do NOT overlap, swap directly.
-                        // - If they overlap, use sub_10009BB9 as an expensive tie-breaker,
-                        //   then a final epsilon compare using EPSILON.
-                        //
-                        // Overlap test reconstructed from FPU status checks in the DLL:
-                        //   (prev.ZhMin < k.ZhMax) && (k.ZhMin <= prev.ZhMax)
-                        if (prev->m_ZhMin < k->m_ZhMax) {
-                            if (!(k->m_ZhMin <= prev->m_ZhMax)) {
-                                // Non-overlap case: swap.
-                                SwapTransparentObjects(k, prev);
-                                noSwaps = FALSE;
-                                continue;
-                            }
-
-                            // Overlap case: tie-breaker.
-                            const RCK3dEntity *a = prev->m_Node->m_Entity;
-                            const RCK3dEntity *b = k->m_Node->m_Entity;
-
-                            const int cmp1 = ClassifyTransparentOrder(a, b, cameraPos);
-                            if (cmp1 < 0) {
-                                SwapTransparentObjects(k, prev);
-                                noSwaps = FALSE;
-                                continue;
-                            }
-                            if (cmp1 > 0)
-                                continue;
-
-                            const int cmp2 = ClassifyTransparentOrder(b, a, cameraPos);
-                            if (cmp2 < 0)
-                                continue;
-                            if (cmp2 > 0) {
-                                SwapTransparentObjects(k, prev);
-                                noSwaps = FALSE;
-                                continue;
-                            }
-
-                            if (ShouldSwapTransparentTieFallback(*k, *prev)) {
-                                SwapTransparentObjects(k, prev);
-                                noSwaps = FALSE;
-                            }
-                        }
-                    }
-                }
-
-                if (noSwaps)
-                    break;
-                noSwaps = TRUE;
-            }
+            dev->m_RenderManager->m_TransparentSorter.Sort(m_TransparentObjects, &ClassifyTransparentObjects, &cameraPos);
 
             dev->m_Stats.TransparentObjectsSortTime = dev->m_TransparentObjectsSortTimeProfiler.Current();
 
@@ -779,6 +953,7 @@ void CKSceneGraphRootNode::Clear() {
         }
     }
     m_Children.Clear();
+    ++g_SceneGraphTopologyStamp;
     m_ChildToBeParsedCount = 0;
     m_Index = 0;
     m_Flags = 0;
@@ -0,0 +1,358 @@
+#include "CKSceneGraphBVH.h"
+
+#include "CKJobPool.h"
+#include "CKRasterizerEnums.h"
+#include "RCK3dEntity.h"
+#include "RCKMesh.h"
+
+// Nodes per refit task; smaller levels are refitted on the calling thread
+static const int kRefitChunkSize = 128;
+
+CKSceneGraphBVH::CKSceneGraphBVH()
+    : m_TopologyStamp(0), m_Built(FALSE), m_Culled(FALSE), m_LevelNodes(nullptr), m_LevelCount(0),
+      m_RefittedNodeCount(0), m_TestedNodeCount(0) {}
+
+void CKSceneGraphBVH::Clear() {
+    m_Nodes.Clear();
+    m_Skip.Clear();
+    m_Parent.Clear();
+    m_Depth.Clear();
+    m_Dirty.Clear();
+    m_Changed.Clear();
+    m_Levels.Clear();
+    m_MinX.Clear();
+    m_MinY.Clear();
+    m_MinZ.Clear();
+    m_MaxX.Clear();
+    m_MaxY.Clear();
+    m_MaxZ.Clear();
+    m_BoxValid.Clear();
+    m_Built = FALSE;
+    m_Culled = FALSE;
+    m_RefittedNodeCount = 0;
+    m_TestedNodeCount = 0;
+}
+
+void CKSceneGraphBVH::Update(CKSceneGraphRootNode *root, CKJobPool *pool) {
+    m_Culled = FALSE;
+    if (!root)
+        return;
+
+    if (!m_Built || m_TopologyStamp != CKSceneGraphNode::GetTopologyStamp())
+        Build(root);
+
+    Refit(pool);
+}
+
+CKBOOL CKSceneGraphBVH::IsCulled() const {
+    return m_Culled && m_TopologyStamp == CKSceneGraphNode::GetTopologyStamp();
+}
+
+void CKSceneGraphBVH::NodeInvalidated(CKSceneGraphNode *node) {
+    // Nodes of a previous layout keep their index until the next build
+    const int index = node->m_FlatIndex;
+    if (m_Built && index >= 0 && index < m_Nodes.Size() && m_Nodes[index] == node)
+        QueueNode(index);
+}
+
+void CKSceneGraphBVH::QueueNode(int index) {
+    if (!m_Dirty[index]) {
+        m_Dirty[index] = 1;
+        m_Levels[m_Depth[index]].PushBack(index);
+    }
+}
+
+void CKSceneGraphBVH::Build(CKSceneGraphRootNode *root) {
+    m_Nodes.Resize(0);
+    m_Parent.Resize(0);
+    m_Depth.Resize(0);
+
+    // Iterative pre-order walk: a node's subtree ends up contiguous.
+    XArray<CKSceneGraphNode *> stack;
+    XArray<int> stackParent;
+    stack.PushBack(root);
+    stackParent.PushBack(-1);
+
+    int maxDepth = 0;
+    while (stack.Size() > 0) {
+        CKSceneGraphNode *node = stack.PopBack();
+        const int parent = stackParent.PopBack();
+
+        const int index = m_Nodes.Size();
+        const int depth = (parent >= 0) ? m_Depth[parent] + 1 : 0;
+        if (depth > maxDepth)
+            maxDepth = depth;
+        node->m_FlatIndex = index;
+        m_Nodes.PushBack(node);
+        m_Parent.PushBack(parent);
+        m_Depth.PushBack(depth);
+
+        for (int c = node->m_Children.Size() - 1; c >= 0; --c) {
+            stack.PushBack(node->m_Children[c]);
+            stackParent.PushBack(index);
+        }
+    }
+
+    const int count = m_Nodes.Size();
+    m_Skip.Resize(count);
+    for (int i = 0; i < count; ++i)
+        m_Skip[i] = 1;
+    for (int i = count - 1; i > 0; --i)
+        m_Skip[m_Parent[i]] += m_Skip[i];
+    for (int i = 0; i < count; ++i)
+        m_Skip[i] += i;
+
+    m_MinX.Resize(count);
+    m_MinY.Resize(count);
+    m_MinZ.Resize(count);
+    m_MaxX.Resize(count);
+    m_MaxY.Resize(count);
+    m_MaxZ.Resize(count);
+    m_BoxValid.Resize(count);
+    m_Dirty.Resize(count);
+    m_Changed.Resize(count);
+
+    // Every box is recomputed by the next refit.
+    m_BoxValid.Memset(0);
+    m_Dirty.Memset(0);
+    m_Changed.Memset(0);
+    m_Levels.Resize(maxDepth + 1);
+    for (int d = 0; d <= maxDepth; ++d)
+        m_Levels[d].Resize(0);
+    for (int i = 0; i < count; ++i)
+        QueueNode(i);
+
+    m_TopologyStamp = CKSceneGraphNode::GetTopologyStamp();
+    m_Built = TRUE;
+}
+
+void CKSceneGraphBVH::RefitChunkTask(void *context, int index) {
+    CKSceneGraphBVH *bvh = (CKSceneGraphBVH *) context;
+    const int begin = index * kRefitChunkSize;
+    const int end = (bvh->m_LevelCount - begin > kRefitChunkSize) ? begin + kRefitChunkSize : bvh->m_LevelCount;
+    for (int i = begin; i < end; ++i) {
+        const int node = bvh->m_LevelNodes[i];
+        bvh->m_Changed[node] = (CKBYTE) bvh->RefitNode(node);
+    }
+}
+
+void CKSceneGraphBVH::Refit(CKJobPool *pool) {
+    m_RefittedNodeCount = 0;
+
+    // Moved entities and every other box change go through
+    // CKSceneGraphNode::InvalidateBox, which queues the node. The deepest
+    // level goes first: the nodes of a level only read the boxes of their
+    // children, which are final, and write their own, so a level can be
+    // split in chunks. A parent is queued when a child box changed.
+    const CKBOOL split = pool && pool->GetWorkerCount() > 0;
+    for (int depth = m_Levels.Size() - 1; depth >= 0; --depth) {
+        XArray<int> &level = m_Levels[depth];
+        const int count = level.Size();
+        if (count == 0)
+            continue;
+
+        m_RefittedNodeCount += count;
+        const int chunkCount = (count + kRefitChunkSize - 1) / kRefitChunkSize;
+        if (split && chunkCount > 1) {
+            for (int i = 0; i < count; ++i)
+                PrepareNode(level[i]);
+            m_LevelNodes = level.Begin();
+            m_LevelCount = count;
+            pool->Run(chunkCount, RefitChunkTask, this);
+            m_LevelNodes = nullptr;
+            m_LevelCount = 0;
+        } else {
+            for (int i = 0; i < count; ++i)
+                m_Changed[level[i]] = (CKBYTE) RefitNode(level[i]);
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const int index = level[i];
+            m_Dirty[index] = 0;
+            if (m_Changed[index]) {
+                if (depth > 0)
+                    QueueNode(m_Parent[index]);
+            } else {
+                RestoreAncestors(index);
+            }
+        }
+        level.Resize(0);
+    }
+}
+
+void CKSceneGraphBVH::RestoreAncestors(int index) {
+    // InvalidateBox(TRUE) also clears the flags of the ancestors, which keep
+    // their box when this one did not change: flag them computed again
+    // unless they are queued for their own change.
+    for (int p = m_Parent[index]; p >= 0 && !m_Dirty[p]; p = m_Parent[p]) {
+        CKSceneGraphNode *node = m_Nodes[p];
+        if (node->IsHierarchyBoxComputed())
+            break;
+        node->SetFlags(CKSGN_BOXCOMPUTED);
+        if (m_BoxValid[p]) {
+            node->m_Bbox = VxBbox(VxVector(m_MinX[p], m_MinY[p], m_MinZ[p]), VxVector(m_MaxX[p], m_MaxY[p], m_MaxZ[p]));
+            node->SetFlags(CKSGN_BOXVALID);
+        }
+    }
+}
+
+void CKSceneGraphBVH::PrepareNode(int index) {
+    RCK3dEntity *entity = m_Nodes[index]->m_Entity;
+    if (!entity)
+        return;
+
+    // UpdateBox computes shared data on demand: the box of a mesh used by
+    // several entities, and the bone matrices of a skin. These boxes are
+    // updated here so that the tasks only write their own entity.
+    entity->ResolveWorldMatrix();
+    if (entity->m_Skin) {
+        entity->UpdateBox(TRUE);
+    } else if (entity->m_CurrentMesh && !(entity->m_CurrentMesh->GetFlags() & VXMESH_BOUNDINGUPTODATE)) {
+        entity->m_CurrentMesh->GetLocalBox();
+    }
+}
+
+CKBOOL CKSceneGraphBVH::RefitNode(int index) {
+    CKSceneGraphNode *node = m_Nodes[index];
+
+    VxBbox box;
+    CKBOOL valid = FALSE;
+
+    // Same merge rules as CKSceneGraphNode::ComputeHierarchicalBox.
+    RCK3dEntity *entity = node->m_Entity;
+    if (entity) {
+        entity->UpdateBox(TRUE);
+        if ((entity->m_MoveableFlags & VX_MOVEABLE_BOXVALID) != 0) {
+            box = entity->m_WorldBoundingBox;
+            valid = TRUE;
+        }
+    }
+
+    const int end = m_Skip[index];
+    for (int c = index + 1; c < end; c = m_Skip[c]) {
+        if (!m_BoxValid[c])
+            continue;
+
+        const VxBbox childBox(VxVector(m_MinX[c], m_MinY[c], m_MinZ[c]), VxVector(m_MaxX[c], m_MaxY[c], m_MaxZ[c]));
+        if (valid) {
+            box.Merge(childBox);
+        } else {
+            box = childBox;
+            valid = TRUE;
+        }
+    }
+
+    // Keep the node tree coherent for GetHierarchicalBox and the per-node tests.
+    node->ClearFlags(CKSGN_BOX_MASK);
+    node->SetFlags(CKSGN_BOXCOMPUTED);
+    if (valid) {
+        node->m_Bbox = box;
+        node->SetFlags(CKSGN_BOXVALID);
+    }
+
+    const CKBOOL changed = valid != (CKBOOL) m_BoxValid[index] ||
+                           (valid && (box.Min.x != m_MinX[index] || box.Min.y != m_MinY[index] ||
+                                      box.Min.z != m_MinZ[index] || box.Max.x != m_MaxX[index] ||
+                                      box.Max.y != m_MaxY[index] || box.Max.z != m_MaxZ[index]));
+
+    m_BoxValid[index] = valid ? 1 : 0;
+    if (valid) {
+        m_MinX[index] = box.Min.x;
+        m_MinY[index] = box.Min.y;
+        m_MinZ[index] = box.Min.z;
+        m_MaxX[index] = box.Max.x;
+        m_MaxY[index] = box.Max.y;
+        m_MaxZ[index] = box.Max.z;
+    }
+
+    return changed;
+}
+
+CKDWORD CKSceneGraphBVH::ClassifyNode(int index, const VxPlane *planes) const {
+    const float minX = m_MinX[index];
+    const float minY = m_MinY[index];
+    const float minZ = m_MinZ[index];
+    const float maxX = m_MaxX[index];
+    const float maxY = m_MaxY[index];
+    const float maxZ = m_MaxZ[index];
+
+    // A box is off screen when its 8 corners are outside the same clip plane
+    // and all inside when no corner is outside any plane, which is what
+    // VxTransformBox2D reports through its and/or clip flags.
+    CKDWORD result = CBV_ALLINSIDE;
+    for (int p = 0; p < 6; ++p) {
+        const VxPlane &plane = planes[p];
+        const float a = plane.m_Normal.x;
+        const float b = plane.m_Normal.y;
+        const float c = plane.m_Normal.z;
+
+        const float farthest = plane.m_D +
+                               a * (a >= 0.0f ? maxX : minX) +
+                               b * (b >= 0.0f ? maxY : minY) +
+                               c * (c >= 0.0f ? maxZ : minZ);
+        if (farthest < 0.0f)
+            return CBV_OFFSCREEN;
+
+        const float nearest = plane.m_D +
+                              a * (a >= 0.0f ? minX : maxX) +
+                              b * (b >= 0.0f ? minY : maxY) +
+                              c * (c >= 0.0f ? minZ : maxZ);
+        if (nearest < 0.0f)
+            result = CBV_VISIBLE;
+    }
+    return result;
+}
+
+void CKSceneGraphBVH::Cull(const VxMatrix &viewProj) {
+    m_TestedNodeCount = 0;
+
+    // Clip planes in world space: with clip = v * viewProj, plane j of the
+    // homogeneous clip volume is a combination of the matrix columns.
+    VxPlane planes[6];
+    for (int p = 0; p < 6; ++p) {
+        const int axis = p >> 1;
+        const float sign = (p & 1) ? -1.0f : 1.0f;
+        VxPlane &plane = planes[p];
+        if (axis < 2) {
+            // x >= -w, x <= w, y >= -w, y <= w
+            plane.m_Normal.x = viewProj[0][3] + sign * viewProj[0][axis];
+            plane.m_Normal.y = viewProj[1][3] + sign * viewProj[1][axis];
+            plane.m_Normal.z = viewProj[2][3] + sign * viewProj[2][axis];
+            plane.m_D = viewProj[3][3] + sign * viewProj[3][axis];
+        } else if (p == 4) {
+            // z >= 0
+            plane.m_Normal.x = viewProj[0][2];
+            plane.m_Normal.y = viewProj[1][2];
+            plane.m_Normal.z = viewProj[2][2];
+            plane.m_D = viewProj[3][2];
+        } else {
+            // z <= w
+            plane.m_Normal.x = viewProj[0][3] - viewProj[0][2];
+            plane.m_Normal.y = viewProj[1][3] - viewProj[1][2];
+            plane.m_Normal.z = viewProj[2][3] - viewProj[2][2];
+            plane.m_D = viewProj[3][3] - viewProj[3][2];
+        }
+    }
+
+    const int count = m_Nodes.Size();
+    int i = 0;
+    while (i < count) {
+        CKSceneGraphNode *node = m_Nodes[i];
+        node->ClearFlags(CKSGN_CULL_MASK);
+        ++m_TestedNodeCount;
+
+        // Invalid boxes are left to the per-entity tests.
+        const CKDWORD vis = m_BoxValid[i] ? ClassifyNode(i, planes) : CBV_VISIBLE;
+        if (vis == CBV_OFFSCREEN) {
+            node->SetFlags(CKSGN_CULLOUTSIDE);
+            i = m_Skip[i];
+        } else if (vis == CBV_ALLINSIDE) {
+            node->SetFlags(CKSGN_CULLINSIDE);
+            i = m_Skip[i];
+        } else {
+            ++i;
+        }
+    }
+
+    m_Culled = TRUE;
+}
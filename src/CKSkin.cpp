@@ -3,6 +3,7 @@
 #include "VxMath.h"
 #include "VxMatrix.h"
 #include "CK3dEntity.h"
+#include "CKJobPool.h"
 
 //-----------------------------------------------------------------------------
 // RCKSkinBoneData Implementation
@@ -98,7 +99,7 @@ void RCKSkinVertexData::SetInitialPos(VxVector &pos) {
 //-----------------------------------------------------------------------------
 
 RCKSkin::RCKSkin()
-    : m_Flags(0) {
+    : m_Flags(0), m_Batch(0), m_BatchMesh(nullptr) {
     Vx3DMatrixIdentity(m_ObjectInitMatrix);
     Vx3DMatrixIdentity(m_InverseWorldMatrix);
 }
@@ -114,7 +115,7 @@ void RCKSkin::SetObjectInitMatrix(const VxMatrix &Mat) {
 
 void RCKSkin::SetBoneCount(int BoneCount) {
     // Clear cached point lists if they exist
-    if (m_Points.Size() > 0)
+    if (m_Points.Size() > 0 || m_Influences.IsBuilt())
         ClearBonePointLists();
 
     int currentCount = m_BoneData.Size();
@@ -129,7 +130,7 @@ void RCKSkin::SetBoneCount(int BoneCount) {
 
 void RCKSkin::SetVertexCount(int Count) {
     // Clear cached point lists if they exist
-    if (m_Points.Size() > 0)
+    if (m_Points.Size() > 0 || m_Influences.IsBuilt())
         ClearBonePointLists();
 
     int currentCount = m_VertexData.Size();
@@ -180,21 +181,155 @@ void RCKSkin::ConstructBoneTransfoMatrices(CKContext *context) {
     }
 }
 
+namespace {
+
+// Vertices per task when a skin is split over the job pool
+const int kSkinChunkSize = 1024;
+
+struct SkinChunk {
+    const CKSkinInfluenceTable *Table;
+    const VxMatrix *Palette;
+    int Begin;
+    int End;
+    CKSkinJob *Job;
+};
+
+struct SkinBatch {
+    CKSkinVerticesFunc Kernel;
+    SkinChunk *Chunks;
+};
+
+void RunSkinChunk(const SkinBatch &batch, const SkinChunk &chunk) {
+    const CKSkinJob &job = *chunk.Job;
+    batch.Kernel(*chunk.Table, chunk.Palette, chunk.Begin, chunk.End, job.VertexPtr, job.VStride, job.NormalPtr,
+                 job.NStride);
+}
+
+void SkinChunkTask(void *context, int index) {
+    const SkinBatch &batch = *(const SkinBatch *) context;
+    RunSkinChunk(batch, batch.Chunks[index]);
+}
+
+} // namespace
+
 CKBOOL RCKSkin::CalcPointsEx(int VertexCount, CKBYTE *VertexPtr, CKDWORD VStride, CKBYTE *NormalPtr, CKDWORD NStride) {
-    if (!VertexPtr)
-        return FALSE;
+    CKSkinJob job = {this, VertexCount, VertexPtr, VStride, NormalPtr, NStride, FALSE};
+    CalcPointsBatch(&job, 1, nullptr);
+    return job.Result;
+}
+
+void RCKSkin::CalcPointsBatch(CKSkinJob *jobs, int jobCount, CKJobPool *pool) {
+    SkinBatch batch;
+    batch.Kernel = GetSkinVerticesFunc();
+
+    // Bone matrices are read from the entities here, on the calling thread;
+    // the tasks only read the tables and palettes and write their own range
+    const CKBOOL split = pool && pool->GetWorkerCount() > 0;
+    XArray<SkinChunk> chunks;
+    for (int j = 0; j < jobCount; ++j) {
+        CKSkinJob &job = jobs[j];
+        RCKSkin *skin = job.Skin;
+        const int count = skin->PrepareCalcPoints(job);
+        const int chunkSize = split ? kSkinChunkSize : count;
+        for (int begin = 0; begin < count; begin += chunkSize) {
+            SkinChunk chunk;
+            chunk.Table = &skin->m_Influences;
+            chunk.Palette = skin->m_Palette.Begin();
+            chunk.Begin = begin;
+            chunk.End = (count - begin > chunkSize) ? begin + chunkSize : count;
+            chunk.Job = &job;
+            chunks.PushBack(chunk);
+        }
+    }
+
+    batch.Chunks = chunks.Begin();
+    if (split) {
+        pool->Run(chunks.Size(), SkinChunkTask, &batch);
+    } else {
+        for (int i = 0; i < chunks.Size(); ++i)
+            RunSkinChunk(batch, chunks[i]);
+    }
+}
+
+int RCKSkin::PrepareCalcPoints(CKSkinJob &job) {
+    job.Result = FALSE;
+    if (!job.VertexPtr)
+        return 0;
 
     const int skinVertexCount = m_VertexData.Size();
     if (skinVertexCount == 0)
-        return FALSE;
+        return 0;
 
-    if (VertexCount == 0)
-        return FALSE;
+    if (job.VertexCount == 0)
+        return 0;
 
-    // Build bone point lists if not already done
-    if (m_Points.Size() == 0)
+    // Build the influence table (or the bone point lists) if not already done
+    if (!m_Influences.IsBuilt() && m_Points.Size() == 0)
         BuildBonePointLists();
 
+    if (!m_Influences.IsBuilt()) {
+        job.Result = CalcPointsFromBoneLists(job.VertexCount, job.VertexPtr, job.VStride, job.NormalPtr, job.NStride);
+        return 0;
+    }
+
+    job.Result = TRUE;
+    const int outputVertexCount = (job.VertexCount < skinVertexCount) ? job.VertexCount : skinVertexCount;
+    const int tailCount = job.VertexCount - outputVertexCount;
+    VxVector zero(0.0f, 0.0f, 0.0f);
+
+    // Vertices past the skin are cleared in standard mode only, normals always
+    if (tailCount > 0 && !(m_Flags & 1))
+        VxFillStructure(tailCount, job.VertexPtr + outputVertexCount * job.VStride, job.VStride, sizeof(VxVector), &zero);
+    const CKBOOL hasNormals = m_Normals.Size() > 0 && job.NormalPtr;
+    if (!hasNormals)
+        job.NormalPtr = nullptr;
+
+    if (!BuildBonePalette()) {
+        // No bone was processed: initial positions and cleared normals
+        for (int i = 0; i < outputVertexCount; ++i)
+            *(VxVector *) (job.VertexPtr + i * job.VStride) = m_VertexData[i].GetInitialPos();
+        if (hasNormals)
+            VxFillStructure(job.VertexCount, job.NormalPtr, job.NStride, sizeof(VxVector), &zero);
+        return 0;
+    }
+
+    if (hasNormals && tailCount > 0)
+        VxFillStructure(tailCount, job.NormalPtr + outputVertexCount * job.NStride, job.NStride, sizeof(VxVector), &zero);
+    return outputVertexCount;
+}
+
+void RCKSkin::UpdateBoneTransform(RCKSkinBoneData &boneData, CK3dEntity *bone) {
+    // InverseWorld * BoneWorld * InitialInverse * ObjectInit
+    VxMatrix &transformMatrix = boneData.GetTransformMatrix();
+    Vx3DMultiplyMatrix(transformMatrix, m_InverseWorldMatrix, bone->GetWorldMatrix());
+    Vx3DMultiplyMatrix(transformMatrix, transformMatrix, boneData.GetInitialInverseMatrix());
+    Vx3DMultiplyMatrix(transformMatrix, transformMatrix, m_ObjectInitMatrix);
+}
+
+CKBOOL RCKSkin::BuildBonePalette() {
+    const int boneCount = m_BoneData.Size();
+    m_Palette.Resize(boneCount);
+
+    CKBOOL anyBoneProcessed = FALSE;
+    for (int boneIdx = 0; boneIdx < boneCount; ++boneIdx) {
+        VxMatrix &matrix = m_Palette[boneIdx];
+        RCKSkinBoneData &boneData = m_BoneData[boneIdx];
+        CK3dEntity *bone = boneData.GetBone();
+        if (!bone || !m_Influences.IsBoneUsed(boneIdx)) {
+            memset(&matrix, 0, sizeof(VxMatrix));
+            continue;
+        }
+
+        UpdateBoneTransform(boneData, bone);
+        matrix = boneData.GetTransformMatrix();
+        anyBoneProcessed = TRUE;
+    }
+    return anyBoneProcessed;
+}
+
+CKBOOL RCKSkin::CalcPointsFromBoneLists(int VertexCount, CKBYTE *VertexPtr, CKDWORD VStride, CKBYTE *NormalPtr, CKDWORD NStride) {
+    const int skinVertexCount = m_VertexData.Size();
+
     // Initialize output arrays
     const int outputVertexCount = (VertexCount < skinVertexCount) ? VertexCount : skinVertexCount;
 
@@ -263,12 +398,7 @@ CKBOOL RCKSkin::CalcPointsEx(int VertexCount, CKBYTE *VertexPtr, CKDWORD VStride
         }
 
         // Update bone transform matrix in CalcPoints (like original does)
-        const VxMatrix &boneWorldMatrix = bone->GetWorldMatrix();
-        VxMatrix temp;
-        Vx3DMultiplyMatrix(temp, m_InverseWorldMatrix, boneWorldMatrix);
-        boneData.GetTransformMatrix() = temp;
-        Vx3DMultiplyMatrix(boneData.GetTransformMatrix(), boneData.GetTransformMatrix(), boneData.GetInitialInverseMatrix());
-        Vx3DMultiplyMatrix(boneData.GetTransformMatrix(), boneData.GetTransformMatrix(), m_ObjectInitMatrix);
+        UpdateBoneTransform(boneData, bone);
 
         anyBoneProcessed = true;
         const VxMatrix &transformMatrix = boneData.GetTransformMatrix();
@@ -397,6 +527,10 @@ void RCKSkin::RemapVertices(const XArray<int> &permutation) {
 }
 
 void RCKSkin::SetNormalCount(int Count) {
+    // The influence table holds a copy of the normals
+    if (m_Influences.IsBuilt())
+        ClearBonePointLists();
+
     m_Normals.Resize(Count);
 }
 
@@ -414,6 +548,7 @@ VxVector &RCKSkin::GetNormal(int Index) {
 
 void RCKSkin::ClearBonePointLists() {
     m_Points.Clear();
+    m_Influences.Clear();
 }
 
 void RCKSkin::BuildBonePointLists() {
@@ -421,6 +556,12 @@ void RCKSkin::BuildBonePointLists() {
     int vertexCount = m_VertexData.Size();
     bool hasNormals = m_Normals.Size() > 0;
 
+    // Skins with at most 8 influences per vertex and weights in [0, 1] use
+    // the vertex-major table, the others keep the per-bone lists
+    m_Points.Clear();
+    if (m_Influences.Build(m_VertexData.Begin(), vertexCount, boneCount, m_Normals.Begin(), m_Normals.Size(), m_Flags & 1))
+        return;
+
     // Allocate bone point arrays
     m_Points.Resize(boneCount);
 
@@ -492,96 +633,10 @@ CKBOOL RCKSkin::CalcLocalBBox(CKContext *context, VxBbox *bbox) {
     if (skinVertexCount <= 0)
         return FALSE;
 
-    // Build bone point lists if not already done
-    if (m_Points.Size() == 0)
-        BuildBonePointLists();
-
+    // Same computation as CalcPoints over every skin vertex
     XClassArray<VxVector> outPositions;
     outPositions.Resize(skinVertexCount);
-
-    // Initialize output array similarly to CalcPoints
-    if (m_Flags & 1) {
-        for (int i = 0; i < skinVertexCount; ++i) {
-            RCKSkinVertexData &vd = m_VertexData[i];
-            const int boneCount = vd.GetBoneCount();
-            if (boneCount == 0) {
-                outPositions[i] = vd.GetInitialPos();
-            } else if (boneCount == 1 && vd.GetWeight(0) == 1.0f) {
-                outPositions[i].x = 0.0f;
-                outPositions[i].y = 0.0f;
-                outPositions[i].z = 0.0f;
-            } else {
-                float totalWeight = 0.0f;
-                for (int b = 0; b < boneCount; ++b)
-                    totalWeight += vd.GetWeight(b);
-
-                const float remainder = 1.0f - totalWeight;
-                if (remainder > 0.0f) {
-                    const VxVector &initPos = vd.GetInitialPos();
-                    outPositions[i].x = initPos.x * remainder;
-                    outPositions[i].y = initPos.y * remainder;
-                    outPositions[i].z = initPos.z * remainder;
-                } else {
-                    outPositions[i].x = 0.0f;
-                    outPositions[i].y = 0.0f;
-                    outPositions[i].z = 0.0f;
-                }
-            }
-        }
-    } else {
-        VxVector zero(0.0f, 0.0f, 0.0f);
-        VxFillStructure(skinVertexCount, (CKBYTE *) outPositions.Begin(), sizeof(VxVector), sizeof(VxVector), &zero);
-    }
-
-    bool anyBoneProcessed = false;
-    const int boneCount = m_BoneData.Size();
-
-    for (int boneIdx = 0; boneIdx < boneCount; ++boneIdx) {
-        RCKSkinBonePoints &bonePoints = m_Points[boneIdx];
-        const int pointCount = bonePoints.m_WeightedVertices.Size();
-        if (pointCount == 0)
-            continue;
-
-        RCKSkinBoneData &boneData = m_BoneData[boneIdx];
-        CK3dEntity *bone = boneData.GetBone();
-        if (!bone) {
-            boneData.SetBone(nullptr);
-            continue;
-        }
-
-        // Keep transform-matrix construction aligned with CalcPoints
-        const VxMatrix &boneWorldMatrix = bone->GetWorldMatrix();
-        VxMatrix temp;
-        Vx3DMultiplyMatrix(temp, m_InverseWorldMatrix, boneWorldMatrix);
-        boneData.GetTransformMatrix() = temp;
-        Vx3DMultiplyMatrix(boneData.GetTransformMatrix(), boneData.GetTransformMatrix(), boneData.GetInitialInverseMatrix());
-        Vx3DMultiplyMatrix(boneData.GetTransformMatrix(), boneData.GetTransformMatrix(), m_ObjectInitMatrix);
-
-        anyBoneProcessed = true;
-        const VxMatrix &transformMatrix = boneData.GetTransformMatrix();
-
-        for (int p = 0; p < pointCount; ++p) {
-            const CKWORD vertexIdx = bonePoints.m_VertexIndices[p];
-            if ((int) vertexIdx >= skinVertexCount)
-                continue;
-
-            VxVector4 &weightedVertex = bonePoints.m_WeightedVertices[p];
-            VxVector srcPos(weightedVertex.x, weightedVertex.y, weightedVertex.z);
-
-            VxVector transformed;
-            Vx3DMultiplyMatrixVector(&transformed, transformMatrix, &srcPos);
-
-            const float weight = weightedVertex.w;
-            outPositions[vertexIdx].x += transformed.x * weight;
-            outPositions[vertexIdx].y += transformed.y * weight;
-            outPositions[vertexIdx].z += transformed.z * weight;
-        }
-    }
-
-    if (!anyBoneProcessed) {
-        for (int i = 0; i < skinVertexCount; ++i)
-            outPositions[i] = m_VertexData[i].GetInitialPos();
-    }
+    CalcPointsEx(skinVertexCount, (CKBYTE *) outPositions.Begin(), sizeof(VxVector), nullptr, 0);
 
     bbox->Reset();
     for (int i = 0; i < skinVertexCount; ++i)
@@ -622,3 +677,35 @@ CKBOOL RCKSkin::CalcBonesBBox(CKContext *context, CK3dEntity *owner, VxBbox *bbo
 
     return TRUE;
 }
+
+void RCKSkin::SetBatch(CKDWORD batch, CK3dEntity *owner) {
+    m_Batch = batch;
+    m_BatchMesh = owner->GetCurrentMesh();
+
+    const int boneCount = m_BoneData.Size();
+    m_BatchMatrices.Resize(boneCount + 1);
+    m_BatchMatrices[0] = owner->GetWorldMatrix();
+    for (int i = 0; i < boneCount; ++i) {
+        CK3dEntity *bone = m_BoneData[i].GetBone();
+        if (bone)
+            m_BatchMatrices[i + 1] = bone->GetWorldMatrix();
+        else
+            memset(&m_BatchMatrices[i + 1], 0, sizeof(VxMatrix));
+    }
+}
+
+CKBOOL RCKSkin::IsBatchCurrent(CK3dEntity *owner) {
+    const int boneCount = m_BoneData.Size();
+    if (m_BatchMatrices.Size() != boneCount + 1 || owner->GetCurrentMesh() != m_BatchMesh)
+        return FALSE;
+    if (memcmp(&m_BatchMatrices[0], &owner->GetWorldMatrix(), sizeof(VxMatrix)) != 0)
+        return FALSE;
+
+    // Render callbacks of the entities drawn before the owner may have moved a bone
+    for (int i = 0; i < boneCount; ++i) {
+        CK3dEntity *bone = m_BoneData[i].GetBone();
+        if (bone && memcmp(&m_BatchMatrices[i + 1], &bone->GetWorldMatrix(), sizeof(VxMatrix)) != 0)
+            return FALSE;
+    }
+    return TRUE;
+}
@@ -0,0 +1,305 @@
+#include "CKSkinEngine.h"
+
+#include "RCKMesh.h"
+#include "RCKSkin.h"
+
+#include <string.h>
+
+// =====================================================
+// Vertex-major skinning used by RCKSkin::CalcPointsEx.
+// A vertex blends the palette matrices of its bones by weight, then
+// transforms its rest position and normal once:
+//   pos = p * sum(w_i * M_i) + w * p
+// which is the same sum as the bone-major loop of the original code, only in
+// a different order, so results match it up to rounding (and the 16 bit
+// weight quantization).
+// =====================================================
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CKSKIN_SIMD_X86 1
+#endif
+
+static const float kWeightScale = 1.0f / 65535.0f;
+
+CKSkinInfluenceTable::CKSkinInfluenceTable() : m_Built(FALSE), m_InfluenceCount(0) {}
+
+void CKSkinInfluenceTable::Clear() {
+    m_Built = FALSE;
+    m_InfluenceCount = 0;
+    m_Positions.Clear();
+    m_Normals.Clear();
+    m_Bones.Clear();
+    m_Weights.Clear();
+    m_BoneUsed.Clear();
+}
+
+CKBOOL CKSkinInfluenceTable::Build(RCKSkinVertexData *vertexData, int vertexCount, int boneCount,
+                                   const VxVector *normals, int normalCount, CKBOOL weighted) {
+    Clear();
+    if (vertexCount <= 0 || boneCount > 65536)
+        return FALSE;
+
+    // Widest vertex, counting the influences the kernels would actually use
+    int maxInfluences = 0;
+    for (int v = 0; v < vertexCount; ++v) {
+        RCKSkinVertexData &vd = vertexData[v];
+        const int count = vd.GetBoneCount();
+        int used = 0;
+        for (int b = 0; b < count; ++b) {
+            const float weight = vd.GetWeight(b);
+            if (!(weight >= 0.0f && weight <= 1.0f))
+                return FALSE;
+            const int bone = vd.GetBone(b);
+            if (bone >= 0 && bone < boneCount && weight > 0.0f)
+                ++used;
+        }
+        if (used > CKSKIN_MAX_INFLUENCES)
+            return FALSE;
+        if (used > maxInfluences)
+            maxInfluences = used;
+    }
+
+    const int influenceCount = (maxInfluences <= 4) ? 4 : CKSKIN_MAX_INFLUENCES;
+    m_InfluenceCount = influenceCount;
+    m_Positions.Resize(vertexCount);
+    m_Bones.Resize(vertexCount * influenceCount);
+    m_Weights.Resize(vertexCount * influenceCount);
+    memset(m_Bones.Begin(), 0, m_Bones.Size() * sizeof(CKWORD));
+    memset(m_Weights.Begin(), 0, m_Weights.Size() * sizeof(CKWORD));
+    m_BoneUsed.Resize(boneCount);
+    if (boneCount > 0)
+        memset(m_BoneUsed.Begin(), 0, boneCount);
+
+    for (int v = 0; v < vertexCount; ++v) {
+        RCKSkinVertexData &vd = vertexData[v];
+        const int count = vd.GetBoneCount();
+        CKWORD *bones = &m_Bones[v * influenceCount];
+        CKWORD *weights = &m_Weights[v * influenceCount];
+
+        // Zero weights only matter for the "no bone processed" fallback, so
+        // they mark the bone as used without taking a slot
+        float totalWeight = 0.0f;
+        int slot = 0;
+        for (int b = 0; b < count; ++b) {
+            const float weight = vd.GetWeight(b);
+            totalWeight += weight;
+            const int bone = vd.GetBone(b);
+            if (bone < 0 || bone >= boneCount)
+                continue;
+            m_BoneUsed[bone] = 1;
+            const CKWORD quantized = (CKWORD) (weight * 65535.0f + 0.5f);
+            if (quantized == 0)
+                continue;
+            bones[slot] = (CKWORD) bone;
+            weights[slot] = quantized;
+            ++slot;
+        }
+
+        // Weighted mode keeps the unassigned part of the weight on the rest
+        // position (all of it for a vertex without bones)
+        const float remainder = 1.0f - totalWeight;
+        const VxVector &initPos = vd.GetInitialPos();
+        VxVector4 &pos = m_Positions[v];
+        pos.x = initPos.x;
+        pos.y = initPos.y;
+        pos.z = initPos.z;
+        pos.w = (weighted && remainder > 0.0f) ? remainder : 0.0f;
+    }
+
+    if (normals && normalCount > 0) {
+        m_Normals.Resize(vertexCount);
+        for (int v = 0; v < vertexCount; ++v) {
+            if (v < normalCount)
+                m_Normals[v] = normals[v];
+            else
+                m_Normals[v].Set(0.0f, 0.0f, 0.0f);
+        }
+    }
+
+    m_Built = TRUE;
+    return TRUE;
+}
+
+void SkinVerticesGenericFunc(const CKSkinInfluenceTable &table, const VxMatrix *palette, int begin, int end,
+                             CKBYTE *vertexPtr, CKDWORD vStride, CKBYTE *normalPtr, CKDWORD nStride) {
+    const int influenceCount = table.GetInfluenceCount();
+    const VxVector4 *positions = table.GetPositions();
+    const VxVector *normals = table.HasNormals() ? table.GetNormals() : nullptr;
+    const CKWORD *bones = table.GetBones() + begin * influenceCount;
+    const CKWORD *weights = table.GetWeights() + begin * influenceCount;
+
+    for (int v = begin; v < end; ++v, bones += influenceCount, weights += influenceCount) {
+        // Rows 0-2 rotate, row 3 translates
+        float m[4][3] = {{0.0f}};
+        for (int k = 0; k < influenceCount && weights[k] != 0; ++k) {
+            const float w = (float) weights[k] * kWeightScale;
+            const float *b = (const float *) &palette[bones[k]];
+            for (int r = 0; r < 4; ++r) {
+                m[r][0] += w * b[r * 4];
+                m[r][1] += w * b[r * 4 + 1];
+                m[r][2] += w * b[r * 4 + 2];
+            }
+        }
+
+        const VxVector4 &p = positions[v];
+        VxVector *outPos = (VxVector *) (vertexPtr + v * vStride);
+        outPos->x = p.x * m[0][0] + p.y * m[1][0] + p.z * m[2][0] + m[3][0] + p.w * p.x;
+        outPos->y = p.x * m[0][1] + p.y * m[1][1] + p.z * m[2][1] + m[3][1] + p.w * p.y;
+        outPos->z = p.x * m[0][2] + p.y * m[1][2] + p.z * m[2][2] + m[3][2] + p.w * p.z;
+
+        if (normalPtr && normals) {
+            const VxVector &n = normals[v];
+            VxVector *outNorm = (VxVector *) (normalPtr + v * nStride);
+            outNorm->x = n.x * m[0][0] + n.y * m[1][0] + n.z * m[2][0];
+            outNorm->y = n.x * m[0][1] + n.y * m[1][1] + n.z * m[2][1];
+            outNorm->z = n.x * m[0][2] + n.y * m[1][2] + n.z * m[2][2];
+        }
+    }
+}
+
+CKSkinVerticesFunc GetSkinVerticesFunc() {
+    switch (GetMeshSIMDLevel()) {
+    case CK_MESHSIMD_AVX2:
+        return SkinVerticesAVX2Func;
+    case CK_MESHSIMD_SSE2:
+        return SkinVerticesSSE2Func;
+    default:
+        return SkinVerticesGenericFunc;
+    }
+}
+
+#ifdef CKSKIN_SIMD_X86
+
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define CKSKIN_TARGET_SSE2
+#define CKSKIN_TARGET_AVX2
+#else
+#define CKSKIN_TARGET_SSE2 __attribute__((target("sse2")))
+#define CKSKIN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Writes the x, y, z lanes of v as a VxVector
+CKSKIN_TARGET_SSE2
+static inline void StoreVector(CKBYTE *dst, __m128 v) {
+    _mm_storel_pi((__m64 *) dst, v);
+    _mm_store_ss((float *) dst + 2, _mm_movehl_ps(v, v));
+}
+
+// =====================================================
+// SSE2: one palette row per register
+// =====================================================
+
+CKSKIN_TARGET_SSE2
+void SkinVerticesSSE2Func(const CKSkinInfluenceTable &table, const VxMatrix *palette, int begin, int end,
+                          CKBYTE *vertexPtr, CKDWORD vStride, CKBYTE *normalPtr, CKDWORD nStride) {
+    const int influenceCount = table.GetInfluenceCount();
+    const VxVector4 *positions = table.GetPositions();
+    const VxVector *normals = table.HasNormals() ? table.GetNormals() : nullptr;
+    const CKWORD *bones = table.GetBones() + begin * influenceCount;
+    const CKWORD *weights = table.GetWeights() + begin * influenceCount;
+    const __m128 weightScale = _mm_set1_ps(kWeightScale);
+
+    for (int v = begin; v < end; ++v, bones += influenceCount, weights += influenceCount) {
+        __m128 r0 = _mm_setzero_ps();
+        __m128 r1 = _mm_setzero_ps();
+        __m128 r2 = _mm_setzero_ps();
+        __m128 r3 = _mm_setzero_ps();
+        for (int k = 0; k < influenceCount && weights[k] != 0; ++k) {
+            const __m128 w = _mm_mul_ps(_mm_set1_ps((float) weights[k]), weightScale);
+            const float *b = (const float *) &palette[bones[k]];
+            r0 = _mm_add_ps(r0, _mm_mul_ps(w, _mm_loadu_ps(b)));
+            r1 = _mm_add_ps(r1, _mm_mul_ps(w, _mm_loadu_ps(b + 4)));
+            r2 = _mm_add_ps(r2, _mm_mul_ps(w, _mm_loadu_ps(b + 8)));
+            r3 = _mm_add_ps(r3, _mm_mul_ps(w, _mm_loadu_ps(b + 12)));
+        }
+
+        const __m128 p = _mm_loadu_ps(&positions[v].x);
+        const __m128 px = _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0));
+        const __m128 py = _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1));
+        const __m128 pz = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2));
+        const __m128 pw = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128 pos = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, r0), _mm_mul_ps(py, r1)), _mm_mul_ps(pz, r2));
+        pos = _mm_add_ps(_mm_add_ps(pos, r3), _mm_mul_ps(pw, p));
+        StoreVector(vertexPtr + v * vStride, pos);
+
+        if (normalPtr && normals) {
+            const VxVector &n = normals[v];
+            __m128 norm = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(n.x), r0), _mm_mul_ps(_mm_set1_ps(n.y), r1));
+            norm = _mm_add_ps(norm, _mm_mul_ps(_mm_set1_ps(n.z), r2));
+            StoreVector(normalPtr + v * nStride, norm);
+        }
+    }
+}
+
+// =====================================================
+// AVX2: two palette rows per register, the eight weights of a vertex are
+// converted at once
+// =====================================================
+
+CKSKIN_TARGET_AVX2
+static inline __m128 SumHalves(__m256 v) {
+    return _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+}
+
+CKSKIN_TARGET_AVX2
+static inline __m256 Broadcast2(float lo, float hi) {
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(lo)), _mm_set1_ps(hi), 1);
+}
+
+CKSKIN_TARGET_AVX2
+void SkinVerticesAVX2Func(const CKSkinInfluenceTable &table, const VxMatrix *palette, int begin, int end,
+                          CKBYTE *vertexPtr, CKDWORD vStride, CKBYTE *normalPtr, CKDWORD nStride) {
+    const int influenceCount = table.GetInfluenceCount();
+    const VxVector4 *positions = table.GetPositions();
+    const VxVector *normals = table.HasNormals() ? table.GetNormals() : nullptr;
+    const CKWORD *bones = table.GetBones() + begin * influenceCount;
+    const CKWORD *weights = table.GetWeights() + begin * influenceCount;
+    const __m256 weightScale = _mm256_set1_ps(kWeightScale);
+
+    float w[CKSKIN_MAX_INFLUENCES];
+    for (int v = begin; v < end; ++v, bones += influenceCount, weights += influenceCount) {
+        // A table has 4 or 8 slots: the 4 slot case reads 8 bytes only
+        __m128i packed = (influenceCount == 8) ? _mm_loadu_si128((const __m128i *) weights)
+                                               : _mm_loadl_epi64((const __m128i *) weights);
+        _mm256_storeu_ps(w, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(packed)), weightScale));
+
+        __m256 r01 = _mm256_setzero_ps();
+        __m256 r23 = _mm256_setzero_ps();
+        for (int k = 0; k < influenceCount && weights[k] != 0; ++k) {
+            const __m256 wk = _mm256_set1_ps(w[k]);
+            const float *b = (const float *) &palette[bones[k]];
+            r01 = _mm256_add_ps(r01, _mm256_mul_ps(wk, _mm256_loadu_ps(b)));
+            r23 = _mm256_add_ps(r23, _mm256_mul_ps(wk, _mm256_loadu_ps(b + 8)));
+        }
+
+        const VxVector4 &p = positions[v];
+        const __m256 pos01 = _mm256_mul_ps(Broadcast2(p.x, p.y), r01);
+        const __m256 pos23 = _mm256_mul_ps(Broadcast2(p.z, 1.0f), r23);
+        const __m128 rest = _mm_mul_ps(_mm_set1_ps(p.w), _mm_loadu_ps(&p.x));
+        StoreVector(vertexPtr + v * vStride, _mm_add_ps(SumHalves(_mm256_add_ps(pos01, pos23)), rest));
+
+        if (normalPtr && normals) {
+            const VxVector &n = normals[v];
+            const __m256 norm01 = _mm256_mul_ps(Broadcast2(n.x, n.y), r01);
+            const __m256 norm23 = _mm256_mul_ps(Broadcast2(n.z, 0.0f), r23);
+            StoreVector(normalPtr + v * nStride, SumHalves(_mm256_add_ps(norm01, norm23)));
+        }
+    }
+}
+
+#else // CKSKIN_SIMD_X86
+
+// Other architectures only have the generic version
+void SkinVerticesSSE2Func(const CKSkinInfluenceTable &table, const VxMatrix *palette, int begin, int end,
+                          CKBYTE *vertexPtr, CKDWORD vStride, CKBYTE *normalPtr, CKDWORD nStride) {
+    SkinVerticesGenericFunc(table, palette, begin, end, vertexPtr, vStride, normalPtr, nStride);
+}
+
+void SkinVerticesAVX2Func(const CKSkinInfluenceTable &table, const VxMatrix *palette, int begin, int end,
+                          CKBYTE *vertexPtr, CKDWORD vStride, CKBYTE *normalPtr, CKDWORD nStride) {
+    SkinVerticesGenericFunc(table, palette, begin, end, vertexPtr, vStride, normalPtr, nStride);
+}
+
+#endif // CKSKIN_SIMD_X86
@@ -440,7 +440,7 @@ CKBOOL RCKSprite3D::IsInViewFrustrum(CKRenderContext *rc, CKDWORD flags) {
 
 void RCKSprite3D::UpdateBox(CKBOOL World) {
     if (!(m_MoveableFlags & VX_MOVEABLE_UPTODATE) && World) {
-        m_WorldBoundingBox.TransformFrom(m_LocalBoundingBox, m_WorldMatrix);
+        m_WorldBoundingBox.TransformFrom(m_LocalBoundingBox, GetWorldMatrix());
         m_MoveableFlags |= VX_MOVEABLE_BOXVALID | VX_MOVEABLE_UPTODATE;
     }
 }
@@ -461,7 +461,9 @@ void RCKSprite3D::UpdateOrientation(CKRenderContext *rc) {
     if (!rootEntity)
         return;
 
-    const VxMatrix &rootWorld = rootEntity->m_WorldMatrix;
+    // The rows below keep the translation and the children
+    ResolveBeforeMove(TRUE);
+    const VxMatrix &rootWorld = rootEntity->GetWorldMatrix();
 
     const CKDWORD mode = m_Mode;
     if (mode == VXSPRITE3D_BILLBOARD) {
@@ -608,6 +610,8 @@ void RCKSprite3D::FillBatch(CKSprite3DBatch *batch) {
     // Get pointer to the 4 new vertices at the end
     CKVertex *vertices = batch->m_Vertices.Begin() + currentSize;
 
+    ResolveWorldMatrix();
+
     // Dimensions from local bbox
     const float width = m_LocalBoundingBox.Max.x - m_LocalBoundingBox.Min.x;
     const float height = m_LocalBoundingBox.Max.y - m_LocalBoundingBox.Min.y;
@@ -689,6 +693,8 @@ CKBOOL RCKSprite3D::Render(CKRenderContext *Dev, CKDWORD Flags) {
     // Local VxTimeProfiler constructed at entry (used by Dev debug mode).
     VxTimeProfiler profiler;
 
+    ResolveWorldMatrix();
+
     // If VX_MOVEABLE_EXTENTSUPTODATE is set (0x20), the object is treated as transparent / already-validated.
     if ((m_MoveableFlags & VX_MOVEABLE_EXTENTSUPTODATE) != 0) {
         if (m_Callbacks && (Flags & CK_RENDER_CLEARVIEWPORT) == 0) {
@@ -0,0 +1,232 @@
+#include "ForsythVertexCacheOptimizer.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+// Valence boost of the original article. Its cache score decays with the
+// LRU position of the vertices, but in a FIFO cache hits do not move them:
+// every cached vertex scores the same, plus a bonus growing with its age so
+// the oldest ones are used before they are evicted.
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+const int kValenceTableSize = 32;
+const float kCachedScore = 1.0f;
+const float kCacheAgeBonus = 0.5f;
+
+// The vertices of a face fit in the cache
+const int kMinCacheSize = 3;
+
+// Load time of the vertices never loaded, far enough in the past to never be cached
+const int kNeverLoaded = -0x40000000;
+
+template <class IndexType>
+int GetIndexedVertexCount(const IndexType *indices, int indexCount, int vertexCount) {
+    if (vertexCount < 0)
+        vertexCount = 0;
+    for (int i = 0; i < indexCount; ++i) {
+        if ((int) indices[i] >= vertexCount)
+            vertexCount = (int) indices[i] + 1;
+    }
+    return vertexCount;
+}
+
+} // namespace
+
+ForsythVertexCacheOptimizer::ForsythVertexCacheOptimizer() : m_CacheSize(0), m_Clock(0) {}
+
+void ForsythVertexCacheOptimizer::Optimize(const CKWORD *indices, int faceCount, int vertexCount, int cacheSize,
+                                           CKWORD *output) {
+    Reorder(indices, faceCount, vertexCount, cacheSize, output);
+}
+
+void ForsythVertexCacheOptimizer::Optimize(const CKDWORD *indices, int faceCount, int vertexCount, int cacheSize,
+                                           CKDWORD *output) {
+    Reorder(indices, faceCount, vertexCount, cacheSize, output);
+}
+
+float ForsythVertexCacheOptimizer::ComputeACMR(const CKWORD *indices, int faceCount, int cacheSize) {
+    return SimulateCache(indices, faceCount, cacheSize);
+}
+
+float ForsythVertexCacheOptimizer::ComputeACMR(const CKDWORD *indices, int faceCount, int cacheSize) {
+    return SimulateCache(indices, faceCount, cacheSize);
+}
+
+template <class IndexType>
+void ForsythVertexCacheOptimizer::BuildFaceLists(const IndexType *indices, int faceCount, int vertexCount) {
+    // Counting pass, then the faces of each vertex in order
+    m_Remaining.Resize(vertexCount);
+    memset(m_Remaining.Begin(), 0, vertexCount * sizeof(int));
+    for (int i = 0; i < faceCount * 3; ++i)
+        ++m_Remaining[indices[i]];
+
+    m_Starts.Resize(vertexCount + 1);
+    m_Starts[0] = 0;
+    for (int v = 0; v < vertexCount; ++v)
+        m_Starts[v + 1] = m_Starts[v] + m_Remaining[v];
+
+    // m_LoadTimes is filled again by ResetCache
+    m_LoadTimes.Resize(vertexCount);
+    memcpy(m_LoadTimes.Begin(), m_Starts.Begin(), vertexCount * sizeof(int));
+    m_Faces.Resize(faceCount * 3);
+    for (int i = 0; i < faceCount * 3; ++i)
+        m_Faces[m_LoadTimes[indices[i]]++] = i / 3;
+}
+
+void ForsythVertexCacheOptimizer::ResetCache(int vertexCount, int cacheSize) {
+    m_CacheSize = cacheSize;
+    m_Clock = 0;
+    m_LoadTimes.Resize(vertexCount);
+    for (int v = 0; v < vertexCount; ++v)
+        m_LoadTimes[v] = kNeverLoaded;
+    m_Cache.Resize(cacheSize);
+    for (int i = 0; i < cacheSize; ++i)
+        m_Cache[i] = -1;
+}
+
+void ForsythVertexCacheOptimizer::BuildScoreTables(int cacheSize) {
+    m_CacheScores.Resize(cacheSize);
+    for (int age = 0; age < cacheSize; ++age)
+        m_CacheScores[age] = kCachedScore + kCacheAgeBonus * (float) age / (float) cacheSize;
+
+    m_ValenceScores.Resize(kValenceTableSize);
+    m_ValenceScores[0] = 0.0f;
+    for (int valence = 1; valence < kValenceTableSize; ++valence)
+        m_ValenceScores[valence] = kValenceBoostScale * powf((float) valence, -kValenceBoostPower);
+}
+
+float ForsythVertexCacheOptimizer::ComputeVertexScore(int vertex) const {
+    const int remaining = m_Remaining[vertex];
+    if (remaining == 0)
+        return -1.0f;
+
+    float score = (remaining < kValenceTableSize) ? m_ValenceScores[remaining]
+                                                  : kValenceBoostScale * powf((float) remaining, -kValenceBoostPower);
+    if (InCache(vertex))
+        score += m_CacheScores[m_Clock - 1 - m_LoadTimes[vertex]];
+    return score;
+}
+
+void ForsythVertexCacheOptimizer::RemoveFace(int vertex, int face) {
+    int *faces = m_Faces.Begin() + m_Starts[vertex];
+    const int last = --m_Remaining[vertex];
+    for (int i = 0; i <= last; ++i) {
+        if (faces[i] == face) {
+            faces[i] = faces[last];
+            faces[last] = face;
+            return;
+        }
+    }
+}
+
+template <class IndexType>
+void ForsythVertexCacheOptimizer::Reorder(const IndexType *indices, int faceCount, int vertexCount, int cacheSize,
+                                          IndexType *output) {
+    if (!indices || !output || faceCount <= 0)
+        return;
+    if (cacheSize < kMinCacheSize)
+        cacheSize = kMinCacheSize;
+
+    vertexCount = GetIndexedVertexCount(indices, faceCount * 3, vertexCount);
+    BuildFaceLists(indices, faceCount, vertexCount);
+    ResetCache(vertexCount, cacheSize);
+    if (m_CacheScores.Size() != cacheSize)
+        BuildScoreTables(cacheSize);
+
+    m_Scores.Resize(vertexCount);
+    for (int v = 0; v < vertexCount; ++v)
+        m_Scores[v] = ComputeVertexScore(v);
+    m_Emitted.Resize(faceCount);
+    memset(m_Emitted.Begin(), 0, faceCount);
+    m_Order.Resize(faceCount);
+
+    int best = -1;
+    int nextInputFace = 0;
+    for (int n = 0; n < faceCount; ++n) {
+        // Nothing left around the cached vertices: take the next face in input order
+        if (best < 0) {
+            while (m_Emitted[nextInputFace])
+                ++nextInputFace;
+            best = nextInputFace;
+        }
+        m_Emitted[best] = 1;
+        m_Order[n] = best;
+
+        const IndexType *face = indices + best * 3;
+        int evicted[3];
+        int evictedCount = 0;
+        CKBOOL missed = FALSE;
+        for (int c = 0; c < 3; ++c) {
+            const int v = face[c];
+            RemoveFace(v, best);
+            if (!InCache(v)) {
+                const int slot = m_Clock % m_CacheSize;
+                if (m_Cache[slot] >= 0)
+                    evicted[evictedCount++] = m_Cache[slot];
+                m_Cache[slot] = v;
+                m_LoadTimes[v] = m_Clock++;
+                missed = TRUE;
+            }
+        }
+
+        // Cache positions only move on misses, valences only around the emitted face
+        for (int e = 0; e < evictedCount; ++e)
+            m_Scores[evicted[e]] = ComputeVertexScore(evicted[e]);
+        if (missed) {
+            for (int slot = 0; slot < m_CacheSize; ++slot) {
+                if (m_Cache[slot] >= 0)
+                    m_Scores[m_Cache[slot]] = ComputeVertexScore(m_Cache[slot]);
+            }
+        } else {
+            for (int c = 0; c < 3; ++c)
+                m_Scores[face[c]] = ComputeVertexScore(face[c]);
+        }
+
+        // Best face left around the cached vertices
+        best = -1;
+        float bestScore = 0.0f;
+        for (int slot = 0; slot < m_CacheSize; ++slot) {
+            const int v = m_Cache[slot];
+            if (v < 0)
+                continue;
+            const int *faces = m_Faces.Begin() + m_Starts[v];
+            for (int i = 0; i < m_Remaining[v]; ++i) {
+                const IndexType *tri = indices + faces[i] * 3;
+                const float score = m_Scores[tri[0]] + m_Scores[tri[1]] + m_Scores[tri[2]];
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = faces[i];
+                }
+            }
+        }
+    }
+
+    // Reordering in place reads the faces from a copy
+    XArray<IndexType> source;
+    if (output == indices) {
+        source.Resize(faceCount * 3);
+        memcpy(source.Begin(), indices, faceCount * 3 * sizeof(IndexType));
+        indices = source.Begin();
+    }
+    for (int n = 0; n < faceCount; ++n) {
+        const IndexType *tri = indices + m_Order[n] * 3;
+        output[n * 3] = tri[0];
+        output[n * 3 + 1] = tri[1];
+        output[n * 3 + 2] = tri[2];
+    }
+}
+
+template <class IndexType>
+float ForsythVertexCacheOptimizer::SimulateCache(const IndexType *indices, int faceCount, int cacheSize) {
+    if (!indices || faceCount <= 0 || cacheSize <= 0)
+        return 0.0f;
+
+    ResetCache(GetIndexedVertexCount(indices, faceCount * 3, 0), cacheSize);
+    for (int i = 0; i < faceCount * 3; ++i) {
+        if (!InCache(indices[i]))
+            m_LoadTimes[indices[i]] = m_Clock++;
+    }
+    return (float) m_Clock / (float) faceCount;
+}
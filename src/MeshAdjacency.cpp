@@ -1,6 +1,18 @@
 #include "MeshAdjacency.h"
 
-#include "RadixSort.h"
+#include "CKJobPool.h"
+
+#include <stdlib.h>
+
+// Vertex buckets and faces per task when Compute is split over a job pool
+static const int kBucketChunkSize = 4096;
+static const int kFaceChunkSize = 4096;
+
+// Larger buckets (high valence vertices) are sorted with qsort
+static const int kBucketInsertionSort = 16;
+
+// Vertices of the edges of a face: (V0, V1), (V0, V2), (V1, V2)
+static const int kEdgeVertices[3][2] = {{0, 1}, {0, 2}, {1, 2}};
 
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
@@ -14,15 +26,14 @@ MeshAdjacency::~MeshAdjacency() {}
 // Init the class with extern data
 // the data are then copied inside and no more needed
 void MeshAdjacency::Init(CKWORD *iIndices, int iCount) {
+    m_Edges.Resize(0);
     if (!iIndices || iCount <= 0) {
         m_Faces.Resize(0);
-        m_Edges.Resize(0);
         return;
     }
 
     // allocating the arrays
     m_Faces.Resize(iCount);
-    m_Edges.Resize(iCount * 3);
 
     // adding the triangles
     for (int i = 0; i < iCount; ++i) {
@@ -35,15 +46,14 @@ void MeshAdjacency::Init(CKWORD *iIndices, int iCount) {
 
 // {secret}
 void MeshAdjacency::Init(CKDWORD *iIndices, int iCount) {
+    m_Edges.Resize(0);
     if (!iIndices || iCount <= 0) {
         m_Faces.Resize(0);
-        m_Edges.Resize(0);
         return;
     }
 
     // allocating the arrays
     m_Faces.Resize(iCount);
-    m_Edges.Resize(iCount * 3);
 
     // adding the triangles
     for (int i = 0; i < iCount; ++i) {
@@ -54,94 +64,63 @@ void MeshAdjacency::Init(CKDWORD *iIndices, int iCount) {
     }
 }
 
-bool MeshAdjacency::Compute(bool iEdges, bool iFaces) {
-    RadixSorter Core;
-    const int edgesCount = m_Edges.Size();
-    if (edgesCount <= 0) {
-        if (!iEdges)
-            m_Edges.Resize(0);
+bool MeshAdjacency::Compute(bool iEdges, bool iFaces, CKJobPool *iPool) {
+    const int faceCount = m_Faces.Size();
+    m_Edges.Resize(0);
+    if (faceCount <= 0) {
+        m_VertexFaceStarts.Resize(0);
+        m_VertexFaces.Resize(0);
         return true;
     }
 
-    XArray<CKDWORD> tempFaces;
-    tempFaces.Resize(edgesCount);
-    XArray<CKDWORD> tempV0;
-    tempV0.Resize(edgesCount);
-    XArray<CKDWORD> tempV1;
-    tempV1.Resize(edgesCount);
-
-    for (int i = 0; i < edgesCount; i++) {
-        tempFaces[i] = m_Edges[i].faces[0];
-        tempV0[i] = m_Edges[i].vertices[0];
-        tempV1[i] = m_Edges[i].vertices[1];
-    }
-
-    // Multiple sort
-    CKDWORD *Sorted = Core.Sort(tempFaces.Begin(), edgesCount).Sort(tempV0.Begin(), edgesCount).Sort(
-        tempV1.Begin(), edgesCount).GetIndices();
-
-    // Read the list in sorted order, look for similar edges
-    CKDWORD LastRef0 = tempV0[Sorted[0]];
-    CKDWORD LastRef1 = tempV1[Sorted[0]];
-    CKDWORD Count = 0;
-    CKDWORD TmpBuffer[3];
-
-    for (int i = 0; i < edgesCount; i++) {
-        CKDWORD Face = tempFaces[Sorted[i]]; // Owner face
-        CKDWORD Ref0 = tempV0[Sorted[i]];    // Vertex ref #1
-        CKDWORD Ref1 = tempV1[Sorted[i]];    // Vertex ref #2
-        if (Ref0 == LastRef0 && Ref1 == LastRef1) {
-            // Current edge is the same as last one
-            TmpBuffer[Count++] = Face; // Store face number
-            if (Count == 3) {
-                return false; // Only works with manifold meshes (i.e. an edge is not shared by more than 2 triangles)
-            }
-        } else {
-            // Here we have a new edge (LastRef0, LastRef1) shared by Count triangles stored in TmpBuffer
-            if (Count == 2) {
-                // if Count==1 => edge is a boundary edge: it belongs to a single triangle.
-                // Hence there's no need to update a link to an adjacent triangle.
-                bool Status = UpdateLink(TmpBuffer[0], TmpBuffer[1], LastRef0, LastRef1);
-                if (!Status) {
-                    return Status;
-                }
-
-                m_Edges[Sorted[i - 2]].faces[1] = tempFaces[Sorted[i - 1]];
-                m_Edges[Sorted[i - 1]].faces[0] = 0xffffffff; // mark as invalid
-            }
-            // Reset for next edge
-            Count = 0;
-            TmpBuffer[Count++] = Face;
-            LastRef0 = Ref0;
-            LastRef1 = Ref1;
-        }
-    }
+    BuildVertexFaces();
+    BuildBuckets();
 
-    bool Status = true;
-    if (Count == 2) {
-        Status = UpdateLink(TmpBuffer[0], TmpBuffer[1], LastRef0, LastRef1);
-        if (Status) {
-            m_Edges[Sorted[edgesCount - 2]].faces[1] = tempFaces[Sorted[edgesCount - 1]];
-            m_Edges[Sorted[edgesCount - 1]].faces[0] = 0xffffffff;
-        }
+    // A bucket holds every slot of its edges: the buckets link their faces
+    // on their own
+    const CKBOOL split = iPool && iPool->GetWorkerCount() > 0;
+    const int bucketChunkCount = (GetVertexCount() + kBucketChunkSize - 1) / kBucketChunkSize;
+    m_ChunkResults.Resize(bucketChunkCount);
+    if (split && bucketChunkCount > 1) {
+        iPool->Run(bucketChunkCount, LinkBucketsTask, this);
+    } else {
+        for (int c = 0; c < bucketChunkCount; ++c)
+            LinkBucketsTask(this, c);
+    }
+    for (int c = 0; c < bucketChunkCount; ++c) {
+        if (m_ChunkResults[c] < 0)
+            return false; // Only works with manifold meshes (i.e. an edge is not shared by more than 2 triangles)
     }
 
     // We don't need the edges anymore
-    if (!iEdges) {
-        m_Edges.Resize(0);
+    if (!iEdges)
+        return true;
+
+    // An edge is kept in its first slot, the edges stay in the slot order
+    const int faceChunkCount = (faceCount + kFaceChunkSize - 1) / kFaceChunkSize;
+    m_ChunkResults.Resize(faceChunkCount);
+    if (split && faceChunkCount > 1) {
+        iPool->Run(faceChunkCount, CountEdgesTask, this);
     } else {
-        int writeIndex = 0;
-        for (int readIndex = 0; readIndex < edgesCount; ++readIndex) {
-            if (m_Edges[readIndex].faces[0] == 0xffffffff)
-                continue;
-            if (writeIndex != readIndex)
-                m_Edges[writeIndex] = m_Edges[readIndex];
-            ++writeIndex;
-        }
-        m_Edges.Resize(writeIndex);
+        for (int c = 0; c < faceChunkCount; ++c)
+            CountEdgesTask(this, c);
     }
 
-    return Status;
+    int edgeCount = 0;
+    for (int c = 0; c < faceChunkCount; ++c) {
+        const int count = m_ChunkResults[c];
+        m_ChunkResults[c] = edgeCount;
+        edgeCount += count;
+    }
+    m_Edges.Resize(edgeCount);
+    if (split && faceChunkCount > 1) {
+        iPool->Run(faceChunkCount, WriteEdgesTask, this);
+    } else {
+        for (int c = 0; c < faceChunkCount; ++c)
+            WriteEdgesTask(this, c);
+    }
+
+    return true;
 }
 
 /////////////////////////////////////////////////////:
@@ -157,53 +136,221 @@ void MeshAdjacency::AddTriangle(int iIndex, CKDWORD iV0, CKDWORD iV1, CKDWORD iV
     m_Faces[iIndex].faces[0] = -1;
     m_Faces[iIndex].faces[1] = -1;
     m_Faces[iIndex].faces[2] = -1;
+}
+
+void MeshAdjacency::ComputeVertexFaces() {
+    m_Edges.Resize(0);
+    BuildVertexFaces();
+}
+
+// Counting sort of the faces by vertex (a face once per distinct vertex), in
+// increasing face order
+void MeshAdjacency::BuildVertexFaces() {
+    const int faceCount = m_Faces.Size();
+    CKDWORD vertexCount = 0;
+    for (int f = 0; f < faceCount; ++f) {
+        const CKDWORD *v = m_Faces[f].vertices;
+        for (int k = 0; k < 3; ++k) {
+            if (v[k] >= vertexCount)
+                vertexCount = v[k] + 1;
+        }
+    }
+
+    m_VertexFaceStarts.Resize(faceCount > 0 ? vertexCount + 1 : 0);
+    if (faceCount <= 0) {
+        m_VertexFaces.Resize(0);
+        return;
+    }
+    m_VertexFaceStarts.Memset(0);
+    CKDWORD *faceStarts = m_VertexFaceStarts.Begin();
+    for (int f = 0; f < faceCount; ++f) {
+        const CKDWORD *v = m_Faces[f].vertices;
+        ++faceStarts[v[0] + 1];
+        if (v[1] != v[0])
+            ++faceStarts[v[1] + 1];
+        if (v[2] != v[0] && v[2] != v[1])
+            ++faceStarts[v[2] + 1];
+    }
+    for (CKDWORD v = 1; v <= vertexCount; ++v)
+        faceStarts[v] += faceStarts[v - 1];
+
+    // The starts are used as write cursors, then moved back by one vertex
+    m_VertexFaces.Resize(faceStarts[vertexCount]);
+    CKDWORD *vertexFaces = m_VertexFaces.Begin();
+    for (int f = 0; f < faceCount; ++f) {
+        const CKDWORD *v = m_Faces[f].vertices;
+        vertexFaces[faceStarts[v[0]]++] = f;
+        if (v[1] != v[0])
+            vertexFaces[faceStarts[v[1]]++] = f;
+        if (v[2] != v[0] && v[2] != v[1])
+            vertexFaces[faceStarts[v[2]]++] = f;
+    }
+    for (CKDWORD v = vertexCount; v > 0; --v)
+        faceStarts[v] = faceStarts[v - 1];
+    faceStarts[0] = 0;
+}
 
-    // Add edge 01 to database
-    if (iV0 < iV1)
-        AddEdge(iV0, iV1, iIndex, 0);
-    else
-        AddEdge(iV1, iV0, iIndex, 0);
-    // Add edge 02 to database
-    if (iV0 < iV2)
-        AddEdge(iV0, iV2, iIndex, 1);
-    else
-        AddEdge(iV2, iV0, iIndex, 1);
-    // Add edge 12 to database
-    if (iV1 < iV2)
-        AddEdge(iV1, iV2, iIndex, 2);
-    else
-        AddEdge(iV2, iV1, iIndex, 2);
-}
-
-void MeshAdjacency::AddEdge(CKDWORD iV0, CKDWORD iV1, CKDWORD iFace, CKDWORD iEdgeIndex) {
-    // Store edge data
-    m_Edges[iFace * 3 + iEdgeIndex].vertices[0] = iV0;
-    m_Edges[iFace * 3 + iEdgeIndex].vertices[1] = iV1;
-    // only the face[0] is used for the first part of the algorithm
-    m_Edges[iFace * 3 + iEdgeIndex].faces[0] = iFace;
-    m_Edges[iFace * 3 + iEdgeIndex].faces[1] = 0xffffffff;
-}
-
-bool MeshAdjacency::UpdateLink(CKDWORD iFace1, CKDWORD iFace2, CKDWORD iV0, CKDWORD iV1) {
-    Face &tri0 = m_Faces[iFace1]; // Catch the first triangle
-    Face &tri1 = m_Faces[iFace2]; // Catch the second triangle
-
-    // Get the edge IDs. 0xff means input references are wrong.
-    CKBYTE EdgeNb0 = tri0.FindEdge(iV0, iV1);
-    if (EdgeNb0 == 0xff)
-        return false;
-
-    CKBYTE EdgeNb1 = tri1.FindEdge(iV0, iV1);
-    if (EdgeNb1 == 0xff)
-        return false;
-
-    // Update links. The two most significant bits contain the counterpart edge's ID.
-    tri0.faces[EdgeNb0] = iFace2 | (CKDWORD(EdgeNb1) << 30);
-    tri1.faces[EdgeNb1] = iFace1 | (CKDWORD(EdgeNb0) << 30);
+// Counting sort of the edge slots by smallest vertex, in increasing slot
+// order, over the vertices of the face table
+void MeshAdjacency::BuildBuckets() {
+    const int faceCount = m_Faces.Size();
+    const CKDWORD vertexCount = (CKDWORD) GetVertexCount();
+    for (int f = 0; f < faceCount; ++f) {
+        Face &face = m_Faces[f];
+        face.faces[0] = 0xffffffff;
+        face.faces[1] = 0xffffffff;
+        face.faces[2] = 0xffffffff;
+    }
 
+    m_BucketStarts.Resize(vertexCount + 1);
+    m_BucketStarts.Memset(0);
+    CKDWORD *bucketStarts = m_BucketStarts.Begin();
+    for (int f = 0; f < faceCount; ++f) {
+        const CKDWORD *v = m_Faces[f].vertices;
+        for (int e = 0; e < 3; ++e)
+            ++bucketStarts[XMin(v[kEdgeVertices[e][0]], v[kEdgeVertices[e][1]]) + 1];
+    }
+    for (CKDWORD v = 1; v <= vertexCount; ++v)
+        bucketStarts[v] += bucketStarts[v - 1];
+
+    // The starts are used as write cursors, then moved back by one vertex
+    m_Buckets.Resize(faceCount * 3);
+    EdgeSlot *buckets = m_Buckets.Begin();
+    for (int f = 0; f < faceCount; ++f) {
+        const CKDWORD *v = m_Faces[f].vertices;
+        for (int e = 0; e < 3; ++e) {
+            const CKDWORD v0 = v[kEdgeVertices[e][0]];
+            const CKDWORD v1 = v[kEdgeVertices[e][1]];
+            EdgeSlot &entry = buckets[bucketStarts[XMin(v0, v1)]++];
+            entry.vertex = XMax(v0, v1);
+            entry.slot = f * 3 + e;
+        }
+    }
+    for (CKDWORD v = vertexCount; v > 0; --v)
+        bucketStarts[v] = bucketStarts[v - 1];
+    bucketStarts[0] = 0;
+}
+
+int MeshAdjacency::CompareEdgeSlots(const void *iA, const void *iB) {
+    const EdgeSlot *a = (const EdgeSlot *) iA;
+    const EdgeSlot *b = (const EdgeSlot *) iB;
+    if (a->vertex != b->vertex)
+        return (a->vertex < b->vertex) ? -1 : 1;
+    return (a->slot < b->slot) ? -1 : (a->slot > b->slot) ? 1 : 0;
+}
+
+// Links the faces of the edges of the buckets of [iBegin, iEnd): the slots
+// of an edge follow each other once a bucket is sorted by largest vertex
+bool MeshAdjacency::LinkBuckets(int iBegin, int iEnd) {
+    const CKDWORD *starts = m_BucketStarts.Begin();
+    for (int v = iBegin; v < iEnd; ++v) {
+        EdgeSlot *bucket = m_Buckets.Begin() + starts[v];
+        const int count = (int) (starts[v + 1] - starts[v]);
+        if (count > kBucketInsertionSort) {
+            ::qsort(bucket, count, sizeof(EdgeSlot), CompareEdgeSlots);
+        } else {
+            for (int i = 1; i < count; ++i) {
+                const EdgeSlot entry = bucket[i];
+                int j = i;
+                for (; j > 0 && bucket[j - 1].vertex > entry.vertex; --j)
+                    bucket[j] = bucket[j - 1];
+                bucket[j] = entry;
+            }
+        }
+
+        for (int i = 0; i < count;) {
+            int end = i + 1;
+            while (end < count && bucket[end].vertex == bucket[i].vertex)
+                ++end;
+            if (end - i > 2)
+                return false;
+            // if Count==1 => edge is a boundary edge: it belongs to a single triangle.
+            if (end - i == 2) {
+                // An edge is found by its own slot unless a face holds it
+                // twice: both slots are then here and the first one wins
+                const CKDWORD face0 = bucket[i].slot / 3;
+                const CKDWORD face1 = bucket[i + 1].slot / 3;
+                const CKDWORD edgeNb0 = bucket[i].slot % 3;
+                const CKDWORD edgeNb1 = (face0 == face1) ? edgeNb0 : bucket[i + 1].slot % 3;
+
+                // Update links. The two most significant bits contain the counterpart edge's ID.
+                m_Faces[face0].faces[edgeNb0] = face1 | (edgeNb1 << 30);
+                m_Faces[face1].faces[edgeNb1] = face0 | (edgeNb0 << 30);
+            }
+            i = end;
+        }
+    }
     return true;
 }
 
+// An edge is kept in the first slot holding it, when its other face does not
+// come first
+static inline bool IsFirstSlot(const MeshAdjacency::Face &iFace, CKDWORD iFaceIndex, int iEdge) {
+    const CKDWORD v0 = iFace.vertices[kEdgeVertices[iEdge][0]];
+    const CKDWORD v1 = iFace.vertices[kEdgeVertices[iEdge][1]];
+    for (int e = 0; e < iEdge; ++e) {
+        const CKDWORD w0 = iFace.vertices[kEdgeVertices[e][0]];
+        const CKDWORD w1 = iFace.vertices[kEdgeVertices[e][1]];
+        if ((w0 == v0 && w1 == v1) || (w0 == v1 && w1 == v0))
+            return false;
+    }
+    const CKDWORD link = iFace.faces[iEdge];
+    return IS_BOUNDARY(link) || MAKE_ADJ_TRI(link) >= iFaceIndex;
+}
+
+int MeshAdjacency::CountEdges(int iBegin, int iEnd) const {
+    int count = 0;
+    for (int f = iBegin; f < iEnd; ++f) {
+        for (int e = 0; e < 3; ++e) {
+            if (IsFirstSlot(m_Faces[f], f, e))
+                ++count;
+        }
+    }
+    return count;
+}
+
+void MeshAdjacency::WriteEdges(int iBegin, int iEnd, int iFirstEdge) {
+    Edge *edge = m_Edges.Begin() + iFirstEdge;
+    for (int f = iBegin; f < iEnd; ++f) {
+        const Face &face = m_Faces[f];
+        for (int e = 0; e < 3; ++e) {
+            if (!IsFirstSlot(face, f, e))
+                continue;
+            const CKDWORD v0 = face.vertices[kEdgeVertices[e][0]];
+            const CKDWORD v1 = face.vertices[kEdgeVertices[e][1]];
+            edge->vertices[0] = XMin(v0, v1);
+            edge->vertices[1] = XMax(v0, v1);
+            edge->faces[0] = f;
+            edge->faces[1] = IS_BOUNDARY(face.faces[e]) ? 0xffffffff : MAKE_ADJ_TRI(face.faces[e]);
+            ++edge;
+        }
+    }
+}
+
+void MeshAdjacency::LinkBucketsTask(void *iContext, int iIndex) {
+    MeshAdjacency *adjacency = (MeshAdjacency *) iContext;
+    const int vertexCount = adjacency->GetVertexCount();
+    const int begin = iIndex * kBucketChunkSize;
+    const int end = (vertexCount - begin > kBucketChunkSize) ? begin + kBucketChunkSize : vertexCount;
+    adjacency->m_ChunkResults[iIndex] = adjacency->LinkBuckets(begin, end) ? 0 : -1;
+}
+
+void MeshAdjacency::CountEdgesTask(void *iContext, int iIndex) {
+    MeshAdjacency *adjacency = (MeshAdjacency *) iContext;
+    const int faceCount = adjacency->m_Faces.Size();
+    const int begin = iIndex * kFaceChunkSize;
+    const int end = (faceCount - begin > kFaceChunkSize) ? begin + kFaceChunkSize : faceCount;
+    adjacency->m_ChunkResults[iIndex] = adjacency->CountEdges(begin, end);
+}
+
+void MeshAdjacency::WriteEdgesTask(void *iContext, int iIndex) {
+    MeshAdjacency *adjacency = (MeshAdjacency *) iContext;
+    const int faceCount = adjacency->m_Faces.Size();
+    const int begin = iIndex * kFaceChunkSize;
+    const int end = (faceCount - begin > kFaceChunkSize) ? begin + kFaceChunkSize : faceCount;
+    adjacency->WriteEdges(begin, end, adjacency->m_ChunkResults[iIndex]);
+}
+
 CKBYTE MeshAdjacency::Face::FindEdge(CKDWORD iV0, CKDWORD iV1) const {
     CKBYTE edgeNb = 0xff;
 
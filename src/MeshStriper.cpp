@@ -1,5 +1,4 @@
 #include "MeshStriper.h"
-#include "RadixSort.h"
 
 static CKDWORD MakeAdjTri(CKDWORD x) { return x & 0x3fffffff; }
 
@@ -17,7 +16,7 @@ static void ReverseRange(CKDWORD *data, int count) {
     }
 }
 
-MeshStriper::MeshStriper() : m_AdjValid(0), m_Flags(0), m_NbStrips(0), m_ConnectedStripLength(0) {}
+MeshStriper::MeshStriper() : m_AdjValid(0), m_Flags(0), m_NbStrips(0), m_ConnectedStripLength(0), m_Mark(0) {}
 
 MeshStriper::~MeshStriper() = default;
 
@@ -35,6 +34,20 @@ CKBOOL MeshStriper::Init(CKWORD *triList, int triCount, CKDWORD flags) {
     return 1;
 }
 
+CKBOOL MeshStriper::Init(CKDWORD *triList, int triCount, CKDWORD flags) {
+    m_Flags = flags;
+    m_AdjValid = 0;
+    if (!triList || triCount <= 0)
+        return 0;
+
+    m_Adj.Init(triList, triCount);
+    if (!m_Adj.Compute(false, true))
+        return 0;
+
+    m_AdjValid = 1;
+    return 1;
+}
+
 CKBOOL MeshStriper::Compute(Result *out) {
     if (!out || !m_AdjValid)
         return 0;
@@ -47,54 +60,31 @@ CKBOOL MeshStriper::Compute(Result *out) {
     m_Connected32.Resize(0);
     m_ConnectedStripLength = 0;
 
-    const XArray<MeshAdjacency::Face> &faces = m_Adj.GetFaces();
-    const int faceCount = faces.Size();
+    const int faceCount = m_Adj.GetFaces().Size();
     if (faceCount <= 0)
         return 0;
 
-    XArray<CKBYTE> used;
-    used.Resize(faceCount);
-    for (int i = 0; i < faceCount; ++i)
-        used[i] = 0;
-
-    XArray<CKDWORD> order;
-    order.Resize(faceCount);
-
-    if ((m_Flags & CKMESHSTRIPER_SORTSEEDS) != 0) {
-        XArray<CKDWORD> degrees;
-        degrees.Resize(faceCount);
-        for (int f = 0; f < faceCount; ++f) {
-            const MeshAdjacency::Face &face = faces[f];
-            CKDWORD deg = 0;
-            if ((int) face.faces[0] != -1)
-                ++deg;
-            if ((int) face.faces[1] != -1)
-                ++deg;
-            if ((int) face.faces[2] != -1)
-                ++deg;
-            degrees[f] = deg;
-        }
+    m_Marks.Resize(faceCount);
+    memset(m_Marks.Begin(), 0, (size_t) faceCount * sizeof(CKDWORD));
+    m_Mark = 0;
 
-        RadixSorter sorter;
-        sorter.Sort(degrees.Begin(), (CKDWORD) faceCount, true);
-        CKDWORD *sorted = sorter.GetIndices();
-        for (int i = 0; i < faceCount; ++i)
-            order[i] = sorted[i];
-    } else {
-        for (int i = 0; i < faceCount; ++i)
-            order[i] = (CKDWORD) i;
+    // A strip holds at most every face, plus its first two vertices and the
+    // vertex inserted by the parity fix
+    for (int i = 0; i < 3; ++i) {
+        m_CandidateVertices[i].Resize(faceCount + 5);
+        m_CandidateFaces[i].Resize(faceCount + 2);
     }
 
+    ComputeSeedOrder(faceCount);
+
     CKDWORD consumed = 0;
     for (int idx = 0; idx < faceCount; ++idx) {
-        const CKDWORD seedFace = order[idx];
-        if (seedFace >= (CKDWORD) faceCount)
-            continue;
-        if (used[(int) seedFace])
+        const CKDWORD seedFace = m_Order[idx];
+        if (m_Marks[(int) seedFace] == kCommitted)
             continue;
 
         const int before = m_StripLengths.Size();
-        const CKDWORD usedFaces = ComputeBestStrip(seedFace, used.Begin(), faceCount);
+        const CKDWORD usedFaces = ComputeBestStrip(seedFace);
         if (m_StripLengths.Size() != before) {
             consumed += usedFaces;
             ++m_NbStrips;
@@ -114,22 +104,47 @@ CKBOOL MeshStriper::Compute(Result *out) {
     return (out->NbStrips != 0 && out->StripIndices != nullptr) ? TRUE : FALSE;
 }
 
+void MeshStriper::ComputeSeedOrder(int faceCount) {
+    m_Order.Resize(faceCount);
+    if ((m_Flags & CKMESHSTRIPER_SORTSEEDS) == 0) {
+        for (int i = 0; i < faceCount; ++i)
+            m_Order[i] = (CKDWORD) i;
+        return;
+    }
+
+    // Faces with the fewest neighbors first, in face order within a degree:
+    // a bucket queue over the 4 possible degrees, as a stable sort would give
+    const XArray<MeshAdjacency::Face> &faces = m_Adj.GetFaces();
+    int starts[5] = {0, 0, 0, 0, 0};
+    for (int f = 0; f < faceCount; ++f) {
+        const MeshAdjacency::Face &face = faces[f];
+        const int degree = ((int) face.faces[0] != -1) + ((int) face.faces[1] != -1) + ((int) face.faces[2] != -1);
+        ++starts[degree + 1];
+    }
+    for (int d = 1; d < 5; ++d)
+        starts[d] += starts[d - 1];
+    for (int f = 0; f < faceCount; ++f) {
+        const MeshAdjacency::Face &face = faces[f];
+        const int degree = ((int) face.faces[0] != -1) + ((int) face.faces[1] != -1) + ((int) face.faces[2] != -1);
+        m_Order[starts[degree]++] = (CKDWORD) f;
+    }
+}
+
 int MeshStriper::TrackStrip(
     CKDWORD faceIndex,
     CKDWORD startV0,
     CKDWORD startV1,
     CKDWORD *outVertices,
-    CKDWORD *outFaces,
-    CKBYTE *used) const {
-    if (!outVertices || !outFaces || !used)
+    CKDWORD *outFaces) {
+    if (!outVertices || !outFaces)
         return 0;
 
     outVertices[0] = startV0;
     outVertices[1] = startV1;
 
-    const XArray<MeshAdjacency::Face> &faces = m_Adj.GetFaces();
-    const int faceCount = faces.Size();
-    if (faceIndex >= (CKDWORD) faceCount)
+    const MeshAdjacency::Face *faces = m_Adj.GetFaces().Begin();
+    const CKDWORD faceCount = (CKDWORD) m_Adj.GetFaces().Size();
+    if (faceIndex >= faceCount)
         return 2;
     int outVertexCount = 2;
 
@@ -137,13 +152,13 @@ int MeshStriper::TrackStrip(
     CKDWORD vLast = startV1;
     bool cont = true;
     while (cont) {
-        const MeshAdjacency::Face &face = faces[(int) faceIndex];
+        const MeshAdjacency::Face &face = faces[faceIndex];
         const CKDWORD vOpp = face.OppositeVertex(v7, vLast);
         if ((int) vOpp == -1)
             break;
         outVertices[outVertexCount++] = vOpp;
         *outFaces++ = faceIndex;
-        used[(int) faceIndex] = 1;
+        m_Marks[(int) faceIndex] = m_Mark;
 
         const CKBYTE edge = face.FindEdge(vLast, vOpp);
         if (edge == 0xff)
@@ -153,7 +168,7 @@ int MeshStriper::TrackStrip(
             cont = false;
         } else {
             const CKDWORD nextFace = MakeAdjTri(link);
-            if (nextFace >= (CKDWORD) faceCount || used[(int) nextFace]) {
+            if (nextFace >= faceCount || IsUsed(nextFace)) {
                 cont = false;
             } else {
                 faceIndex = nextFace;
@@ -167,94 +182,72 @@ int MeshStriper::TrackStrip(
     return outVertexCount;
 }
 
-CKDWORD MeshStriper::ComputeBestStrip(CKDWORD seedFace, CKBYTE *usedGlobal, int faceCount) {
+CKDWORD MeshStriper::ComputeBestStrip(CKDWORD seedFace) {
     const XArray<MeshAdjacency::Face> &faces = m_Adj.GetFaces();
+    const int faceCount = faces.Size();
     const MeshAdjacency::Face &seed = faces[(int) seedFace];
 
     CKDWORD v87[3] = {seed.vertices[1], seed.vertices[0], seed.vertices[2]};
     CKDWORD v88[3] = {seed.vertices[0], seed.vertices[2], seed.vertices[1]};
 
-    struct Candidate {
-        XArray<CKDWORD> verts;
-        XArray<CKDWORD> faces;
-        CKDWORD initialLen;
-        CKDWORD totalLen;
-    };
-
-    Candidate cands[3];
+    CKDWORD initialLens[3];
+    CKDWORD totalLens[3];
     for (int i = 0; i < 3; ++i) {
-        cands[i].initialLen = 0;
-        cands[i].totalLen = 0;
-        cands[i].verts.Resize(faceCount + 5);
-        cands[i].faces.Resize(faceCount + 2);
-        for (int k = 0; k < cands[i].verts.Size(); ++k)
-            cands[i].verts[k] = 0xFFFFFFFFu;
-        for (int k = 0; k < cands[i].faces.Size(); ++k)
-            cands[i].faces[k] = 0xFFFFFFFFu;
-
-        XArray<CKBYTE> usedWork;
-        usedWork.Resize(faceCount);
-        memcpy(usedWork.Begin(), usedGlobal, (size_t) faceCount * sizeof(CKBYTE));
-
-        const int initial = TrackStrip(
-            seedFace,
-            v88[i],
-            v87[i],
-            cands[i].verts.Begin(),
-            cands[i].faces.Begin(),
-            usedWork.Begin());
-        cands[i].initialLen = (CKDWORD) initial;
+        CKDWORD *verts = m_CandidateVertices[i].Begin();
+        CKDWORD *candFaces = m_CandidateFaces[i].Begin();
+
+        // Faces walked by the previous candidates are free again
+        ++m_Mark;
+
+        const int initial = TrackStrip(seedFace, v88[i], v87[i], verts, candFaces);
+        initialLens[i] = (CKDWORD) initial;
 
         if (initial < 3) {
-            cands[i].totalLen = (CKDWORD) initial;
+            totalLens[i] = (CKDWORD) initial;
             continue;
         }
 
-        ReverseRange(cands[i].verts.Begin(), initial);
-        if (initial >= 2)
-            ReverseRange(cands[i].faces.Begin(), initial - 2);
+        ReverseRange(verts, initial);
+        ReverseRange(candFaces, initial - 2);
 
         const int growStart = initial - 3;
-        const int extend = TrackStrip(
-            seedFace,
-            cands[i].verts[growStart],
-            cands[i].verts[growStart + 1],
-            &cands[i].verts[growStart],
-            &cands[i].faces[growStart],
-            usedWork.Begin());
-        cands[i].totalLen = (CKDWORD) (extend + initial - 3);
+        const int extend = TrackStrip(seedFace, verts[growStart], verts[growStart + 1], &verts[growStart],
+                                      &candFaces[growStart]);
+        totalLens[i] = (CKDWORD) (extend + initial - 3);
     }
 
     int best = 0;
-    if (cands[1].totalLen > cands[0].totalLen)
+    if (totalLens[1] > totalLens[0])
         best = 1;
-    if (cands[2].totalLen > cands[best].totalLen)
+    if (totalLens[2] > totalLens[best])
         best = 2;
 
-    CKDWORD bestLen = cands[best].totalLen;
-    const CKDWORD initialLen = cands[best].initialLen;
+    CKDWORD bestLen = totalLens[best];
+    const CKDWORD initialLen = initialLens[best];
     if (bestLen < 3)
         return 0;
-    const CKDWORD triUsed = (bestLen >= 2) ? (bestLen - 2) : 0;
+    const CKDWORD triUsed = bestLen - 2;
 
+    CKDWORD *verts = m_CandidateVertices[best].Begin();
+    const CKDWORD *bestFaces = m_CandidateFaces[best].Begin();
     for (CKDWORD t = 0; t < triUsed; ++t) {
-        const CKDWORD f = cands[best].faces[(int) t];
+        const CKDWORD f = bestFaces[t];
         if (f < (CKDWORD) faceCount)
-            usedGlobal[(int) f] = 1;
+            m_Marks[(int) f] = kCommitted;
     }
 
     if ((m_Flags & CKMESHSTRIPER_PARITYFIX) != 0 && (initialLen & 1) != 0) {
         if (bestLen == 3 || bestLen == 4) {
-            const CKDWORD tmp = cands[best].verts[1];
-            cands[best].verts[1] = cands[best].verts[2];
-            cands[best].verts[2] = tmp;
+            const CKDWORD tmp = verts[1];
+            verts[1] = verts[2];
+            verts[2] = tmp;
         } else {
-            ReverseRange(cands[best].verts.Begin(), (int) bestLen);
+            ReverseRange(verts, (int) bestLen);
             if (((bestLen - initialLen) & 1) != 0) {
                 // Insert one extra copy of first vertex at index 1 (shift right).
                 for (int i = (int) bestLen; i > 1; --i)
-                    cands[best].verts[i] = cands[best].verts[i - 1];
-                cands[best].verts[1] = cands[best].verts[0];
+                    verts[i] = verts[i - 1];
+                verts[1] = verts[0];
                 ++bestLen;
             }
         }
@@ -262,10 +255,10 @@ CKDWORD MeshStriper::ComputeBestStrip(CKDWORD seedFace, CKBYTE *usedGlobal, int
 
     if ((m_Flags & CKMESHSTRIPER_INDEX16) != 0) {
         for (CKDWORD i = 0; i < bestLen; ++i)
-            m_Indices16.PushBack((CKWORD) cands[best].verts[(int) i]);
+            m_Indices16.PushBack((CKWORD) verts[i]);
     } else {
         for (CKDWORD i = 0; i < bestLen; ++i)
-            m_Indices32.PushBack((CKDWORD) cands[best].verts[(int) i]);
+            m_Indices32.PushBack(verts[i]);
     }
     m_StripLengths.PushBack(bestLen);
     return triUsed;
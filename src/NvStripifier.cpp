@@ -35,18 +35,15 @@ NvEdgeInfo *NvStripifier::FindEdgeInfo(XArray<NvEdgeInfo *> &edgeBuckets, int v0
 // ============================================================================
 // Static helper: NvStripifier::FindOtherFace (0x64)
 // ============================================================================
-NvFaceInfo *NvStripifier::FindOtherFace(XArray<NvEdgeInfo *> &edgeBuckets, int v0, int v1, NvFaceInfo *notThisFace) {
-    // Find the edge, then return the other face
-    NvEdgeInfo *edge = FindEdgeInfo(edgeBuckets, v0, v1);
-    if (!edge)
-        return nullptr;
-
-    // Check if edge matches (v0, v1) or (v1, v0)
-    if ((edge->Vertex0 == v0 && edge->Vertex1 == v1) ||
-        (edge->Vertex0 == v1 && edge->Vertex1 == v0)) {
-        if (edge->Face0 == notThisFace)
-            return edge->Face1;
-        return edge->Face0;
+NvFaceInfo *NvStripifier::FindOtherFace(NvFaceInfo *face, int v0, int v1) {
+    // The binary looks the edge up in the buckets of v0. The Neighbor links
+    // follow the MeshAdjacency edge order: (V0, V1), (V0, V2), (V1, V2).
+    static const int edgeVertices[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+    for (int e = 0; e < 3; e++) {
+        const int a = face->V[edgeVertices[e][0]];
+        const int b = face->V[edgeVertices[e][1]];
+        if ((a == v0 && b == v1) || (a == v1 && b == v0))
+            return face->Neighbor[e];
     }
     return nullptr;
 }
@@ -292,8 +289,11 @@ static int FaceSharedVertices(const NvFaceInfo *a, const NvFaceInfo *b, int &out
     return count;
 }
 
-static bool BuildStripIndexSequenceFromFaces(const XArray<NvFaceInfo *> &faces, XArray<CKWORD> &seq) {
-    seq.Resize(0);
+// Appends the index sequence of a strip to seq, which may already hold the
+// sequences of the previous strips. On failure seq is left unchanged.
+template <class IndexType>
+static bool BuildStripIndexSequenceFromFaces(const XArray<NvFaceInfo *> &faces, XArray<IndexType> &seq) {
+    const int start = seq.Size();
     if (faces.Size() <= 0)
         return false;
 
@@ -302,9 +302,9 @@ static bool BuildStripIndexSequenceFromFaces(const XArray<NvFaceInfo *> &faces,
         const NvFaceInfo *f0 = faces[0];
         if (!f0)
             return false;
-        seq.PushBack((CKWORD)f0->V[0]);
-        seq.PushBack((CKWORD)f0->V[1]);
-        seq.PushBack((CKWORD)f0->V[2]);
+        seq.PushBack((IndexType)f0->V[0]);
+        seq.PushBack((IndexType)f0->V[1]);
+        seq.PushBack((IndexType)f0->V[2]);
         return true;
     }
 
@@ -317,9 +317,9 @@ static bool BuildStripIndexSequenceFromFaces(const XArray<NvFaceInfo *> &faces,
     const int u0 = FaceUniqueVertexNotInOther(f0, f1);
     if (u0 < 0) {
         // Fallback: still emit something usable.
-        seq.PushBack((CKWORD)f0->V[0]);
-        seq.PushBack((CKWORD)f0->V[1]);
-        seq.PushBack((CKWORD)f0->V[2]);
+        seq.PushBack((IndexType)f0->V[0]);
+        seq.PushBack((IndexType)f0->V[1]);
+        seq.PushBack((IndexType)f0->V[2]);
     } else {
         int sh0 = -1;
         int sh1 = -1;
@@ -338,20 +338,22 @@ static bool BuildStripIndexSequenceFromFaces(const XArray<NvFaceInfo *> &faces,
         }
 
         if (shCount != 2) {
-            seq.PushBack((CKWORD)f0->V[0]);
-            seq.PushBack((CKWORD)f0->V[1]);
-            seq.PushBack((CKWORD)f0->V[2]);
+            seq.PushBack((IndexType)f0->V[0]);
+            seq.PushBack((IndexType)f0->V[1]);
+            seq.PushBack((IndexType)f0->V[2]);
         } else {
-            seq.PushBack((CKWORD)u0);
-            seq.PushBack((CKWORD)sh0);
-            seq.PushBack((CKWORD)sh1);
+            seq.PushBack((IndexType)u0);
+            seq.PushBack((IndexType)sh0);
+            seq.PushBack((IndexType)sh1);
         }
     }
 
     for (int i = 1; i < faces.Size(); i++) {
         const NvFaceInfo *cur = faces[i];
-        if (!cur)
+        if (!cur) {
+            seq.Resize(start);
             return false;
+        }
 
         int lastA = (int)seq[seq.Size() - 2];
         int lastB = (int)seq[seq.Size() - 1];
@@ -362,62 +364,68 @@ static bool BuildStripIndexSequenceFromFaces(const XArray<NvFaceInfo *> &faces,
             int s0 = -1;
             int s1 = -1;
             const int shared = FaceSharedVertices(prev, cur, s0, s1);
-            if (shared != 2)
+            if (shared != 2) {
+                seq.Resize(start);
                 return false;
+            }
 
-            const CKWORD last = seq[seq.Size() - 1];
+            const IndexType last = seq[seq.Size() - 1];
             seq.PushBack(last); // degenerate
-            seq.PushBack((CKWORD)s0);
-            seq.PushBack((CKWORD)s1);
+            seq.PushBack((IndexType)s0);
+            seq.PushBack((IndexType)s1);
 
             lastA = (int)seq[seq.Size() - 2];
             lastB = (int)seq[seq.Size() - 1];
-            if (!FaceContainsVertex(cur, lastA) || !FaceContainsVertex(cur, lastB))
+            if (!FaceContainsVertex(cur, lastA) || !FaceContainsVertex(cur, lastB)) {
+                seq.Resize(start);
                 return false;
+            }
         }
 
         const int nextV = FaceUniqueVertexNotEq(cur, lastA, lastB);
-        if (nextV < 0)
+        if (nextV < 0) {
+            seq.Resize(start);
             return false;
-        seq.PushBack((CKWORD)nextV);
+        }
+        seq.PushBack((IndexType)nextV);
     }
 
     return true;
 }
 
-static bool SequenceContainsRestartValue(const XArray<CKWORD> &seq) {
-    for (int i = 0; i < seq.Size(); ++i) {
-        if (seq[i] == (CKWORD)0xFFFF)
+template <class IndexType>
+static bool SequenceContainsRestartValue(const IndexType *seq, int count, IndexType restart) {
+    for (int i = 0; i < count; ++i) {
+        if (seq[i] == restart)
             return true;
     }
     return false;
 }
 
-static void AppendJoinedSequence(XArray<CKWORD> &outIndices, const XArray<CKWORD> &seq) {
-    if (seq.Size() == 0)
+template <class IndexType>
+static void AppendJoinedSequence(XArray<IndexType> &outIndices, const IndexType *seq, int count) {
+    if (count == 0)
         return;
 
     if (outIndices.Size() > 0) {
-        const CKWORD last = outIndices[outIndices.Size() - 1];
+        const IndexType last = outIndices[outIndices.Size() - 1];
         if ((outIndices.Size() % 2) != 0)
             outIndices.PushBack(last);
         outIndices.PushBack(last);
         outIndices.PushBack(seq[0]);
     }
 
-    for (int i = 0; i < seq.Size(); ++i)
+    for (int i = 0; i < count; ++i)
         outIndices.PushBack(seq[i]);
 }
 
 // ============================================================================
 // NvStripInfo::Build (0x834) - Uses STATIC local variables!
 // ============================================================================
-void NvStripInfo::Build(XArray<NvEdgeInfo *> &edgeBuckets, XArray<NvFaceInfo *> &allFaces) {
+void NvStripInfo::Build() {
     // CRITICAL: Binary uses static local variables
     static XArray<NvFaceInfo *> forwardFaces;
     static XArray<NvFaceInfo *> backwardFaces;
-    static XArray<CKWORD> scratchIndices;
-    static XArray<NvFaceInfo *> tempAllFaces;
 
     Faces.Resize(0);
 
@@ -427,7 +435,6 @@ void NvStripInfo::Build(XArray<NvEdgeInfo *> &edgeBuckets, XArray<NvFaceInfo *>
     // Initialize scratch arrays
     forwardFaces.Resize(0);
     backwardFaces.Resize(0);
-    scratchIndices.Resize(0);
 
     // Determine starting vertices based on StartCW
     int v0, v1;
@@ -448,24 +455,16 @@ void NvStripInfo::Build(XArray<NvEdgeInfo *> &edgeBuckets, XArray<NvFaceInfo *>
     else
         v2 = StartFace->V[2];
 
-    // Build forward direction
-    scratchIndices.PushBack((CKWORD)v0);
-    scratchIndices.PushBack((CKWORD)v1);
-    scratchIndices.PushBack((CKWORD)v2);
-
+    // Build forward direction: (a, b) is the last edge of the strip
     forwardFaces.PushBack(StartFace);
     MarkTriangle(StartFace);
 
     NvFaceInfo *curFace = StartFace;
+    int a = v1;
+    int b = v2;
     while (true) {
-        if (scratchIndices.Size() < 3)
-            break;
-
-        int a = (int)scratchIndices[scratchIndices.Size() - 2];
-        int b = (int)scratchIndices[scratchIndices.Size() - 1];
-
         // Find neighbor through edge (a, b)
-        NvFaceInfo *next = NvStripifier::FindOtherFace(edgeBuckets, a, b, curFace);
+        NvFaceInfo *next = NvStripifier::FindOtherFace(curFace, a, b);
         if (!next)
             break;
 
@@ -486,35 +485,19 @@ void NvStripInfo::Build(XArray<NvEdgeInfo *> &edgeBuckets, XArray<NvFaceInfo *>
         else
             break;
 
-        scratchIndices.PushBack((CKWORD)nextV);
         forwardFaces.PushBack(next);
         MarkTriangle(next);
         curFace = next;
+        a = b;
+        b = nextV;
     }
 
     // Build backward direction (reverse winding from start)
-    scratchIndices.Resize(0);
-    int bv0, bv1;
-    if (StartCW) {
-        bv0 = StartEdge->Vertex1;
-        bv1 = StartEdge->Vertex0;
-    } else {
-        bv0 = StartEdge->Vertex0;
-        bv1 = StartEdge->Vertex1;
-    }
-    scratchIndices.PushBack((CKWORD)bv0);
-    scratchIndices.PushBack((CKWORD)bv1);
-    scratchIndices.PushBack((CKWORD)v2);
-
     curFace = StartFace;
+    a = StartCW ? StartEdge->Vertex0 : StartEdge->Vertex1;
+    b = v2;
     while (true) {
-        if (scratchIndices.Size() < 3)
-            break;
-
-        int a = (int)scratchIndices[scratchIndices.Size() - 2];
-        int b = (int)scratchIndices[scratchIndices.Size() - 1];
-
-        NvFaceInfo *next = NvStripifier::FindOtherFace(edgeBuckets, a, b, curFace);
+        NvFaceInfo *next = NvStripifier::FindOtherFace(curFace, a, b);
         if (!next)
             break;
 
@@ -533,10 +516,11 @@ void NvStripInfo::Build(XArray<NvEdgeInfo *> &edgeBuckets, XArray<NvFaceInfo *>
         else
             break;
 
-        scratchIndices.PushBack((CKWORD)nextV);
         backwardFaces.PushBack(next);
         MarkTriangle(next);
         curFace = next;
+        a = b;
+        b = nextV;
     }
 
     // Combine forward and backward
@@ -563,16 +547,15 @@ void NvStripInfo::Combine(XArray<NvFaceInfo *> &forward, XArray<NvFaceInfo *> &b
 // ============================================================================
 // NvStripifier::FindGoodResetPoint
 // ============================================================================
-NvFaceInfo *NvStripifier::FindGoodResetPoint(XArray<NvFaceInfo *> &allFaces, XArray<NvEdgeInfo *> &edgeBuckets) {
-    int faceCount = allFaces.Size();
-    if (faceCount == 0)
-        return nullptr;
-
-    // Find first unmarked face
-    for (int i = 0; i < faceCount; i++) {
-        NvFaceInfo *face = allFaces[i];
+NvFaceInfo *NvStripifier::FindGoodResetPoint() {
+    // Find first unmarked face. Committed faces stay marked, so the search
+    // resumes where the previous one stopped.
+    const int faceCount = m_Faces.Size();
+    while (m_ResetCursor < faceCount) {
+        NvFaceInfo *face = &m_Faces[m_ResetCursor];
         if (face->MarkA < 0)
             return face;
+        ++m_ResetCursor;
     }
     return nullptr;
 }
@@ -624,90 +607,75 @@ void NvStripifier::RemoveSmallStrips(
 // ============================================================================
 // NvStripifier::BuildStripifyInfo (0x174)
 // ============================================================================
-void NvStripifier::BuildStripifyInfo(
-    const XArray<CKWORD> &indices,
-    CKWORD vertexCount,
-    XArray<NvFaceInfo *> &outFaces,
-    XArray<NvEdgeInfo *> &outEdgeBuckets,
-    XArray<NvEdgeInfo *> &outEdges) {
-
-    outFaces.Resize(0);
-    outEdgeBuckets.Resize(0);
-    outEdges.Resize(0);
-    if (indices.Size() < 3 || vertexCount == 0)
-        return;
-
-    int triCount = indices.Size() / 3;
-
-    // Create face array
-    outFaces.Reserve(triCount);
-    for (int i = 0; i < triCount; i++) {
-        NvFaceInfo *face = new NvFaceInfo();
-        face->V[0] = (int)indices[i * 3 + 0];
-        face->V[1] = (int)indices[i * 3 + 1];
-        face->V[2] = (int)indices[i * 3 + 2];
-        outFaces.PushBack(face);
-    }
-
-    // Create edge buckets
-    outEdgeBuckets.Resize(vertexCount + 1);
-    for (int i = 0; i < outEdgeBuckets.Size(); i++)
-        outEdgeBuckets[i] = nullptr;
+template <class IndexType>
+bool NvStripifier::BuildStripifyInfo(IndexType *indices, int triCount, int vertexCount) {
+    m_Faces.Resize(0);
+    m_Edges.Resize(0);
+    m_EdgeBuckets.Resize(0);
+    m_ResetCursor = 0;
+    if (triCount <= 0 || vertexCount <= 0)
+        return false;
 
     // Use MeshAdjacency to compute neighbors and edges
-    MeshAdjacency adj;
-    adj.Init((CKWORD *)indices.Begin(), triCount);
-    if (!adj.Compute(true, true)) {
-        for (int i = 0; i < outFaces.Size(); ++i)
-            delete outFaces[i];
-        outFaces.Resize(0);
-        outEdgeBuckets.Resize(0);
-        return;
-    }
+    m_Adjacency.Init(indices, triCount);
+    if (!m_Adjacency.Compute(true, true))
+        return false;
 
-    // Set neighbor links
-    const XArray<MeshAdjacency::Face> &adjFaces = adj.GetFaces();
+    // Create face array with its neighbor links
+    const XArray<MeshAdjacency::Face> &adjFaces = m_Adjacency.GetFaces();
+    m_Faces.Resize(triCount);
     for (int i = 0; i < triCount; i++) {
         const MeshAdjacency::Face &af = adjFaces[i];
-        NvFaceInfo *face = outFaces[i];
+        NvFaceInfo &face = m_Faces[i];
+        face = NvFaceInfo();
+        face.V[0] = (int)indices[i * 3 + 0];
+        face.V[1] = (int)indices[i * 3 + 1];
+        face.V[2] = (int)indices[i * 3 + 2];
         for (int e = 0; e < 3; e++) {
             CKDWORD link = af.faces[e];
             if (IS_BOUNDARY(link)) {
-                face->Neighbor[e] = nullptr;
+                face.Neighbor[e] = nullptr;
             } else {
                 int nface = (int)MAKE_ADJ_TRI(link);
                 if (nface >= 0 && nface < triCount)
-                    face->Neighbor[e] = outFaces[nface];
+                    face.Neighbor[e] = &m_Faces[nface];
                 else
-                    face->Neighbor[e] = nullptr;
+                    face.Neighbor[e] = nullptr;
             }
         }
     }
 
+    // Create edge buckets
+    m_EdgeBuckets.Resize(vertexCount + 1);
+    for (int i = 0; i < m_EdgeBuckets.Size(); i++)
+        m_EdgeBuckets[i] = nullptr;
+
     // Create edge info and buckets
-    const XArray<MeshAdjacency::Edge> &adjEdges = adj.GetEdges();
+    const XArray<MeshAdjacency::Edge> &adjEdges = m_Adjacency.GetEdges();
+    m_Edges.Resize(adjEdges.Size());
     for (int i = 0; i < adjEdges.Size(); i++) {
         const MeshAdjacency::Edge &e = adjEdges[i];
-        NvEdgeInfo *edge = new NvEdgeInfo();
-        outEdges.PushBack(edge);
+        NvEdgeInfo *edge = &m_Edges[i];
+        *edge = NvEdgeInfo();
         edge->Vertex0 = (int)e.vertices[0];
         edge->Vertex1 = (int)e.vertices[1];
 
         CKDWORD f0 = e.faces[0];
         CKDWORD f1 = e.faces[1];
-        edge->Face0 = (f0 != 0xFFFFFFFFu && (int)f0 < triCount) ? outFaces[(int)f0] : nullptr;
-        edge->Face1 = (f1 != 0xFFFFFFFFu && (int)f1 < triCount) ? outFaces[(int)f1] : nullptr;
+        edge->Face0 = (f0 != 0xFFFFFFFFu && (int)f0 < triCount) ? &m_Faces[(int)f0] : nullptr;
+        edge->Face1 = (f1 != 0xFFFFFFFFu && (int)f1 < triCount) ? &m_Faces[(int)f1] : nullptr;
 
         // Insert into buckets
-        if (edge->Vertex0 >= 0 && edge->Vertex0 < outEdgeBuckets.Size()) {
-            edge->NextV0 = outEdgeBuckets[edge->Vertex0];
-            outEdgeBuckets[edge->Vertex0] = edge;
+        if (edge->Vertex0 >= 0 && edge->Vertex0 < m_EdgeBuckets.Size()) {
+            edge->NextV0 = m_EdgeBuckets[edge->Vertex0];
+            m_EdgeBuckets[edge->Vertex0] = edge;
         }
-        if (edge->Vertex1 >= 0 && edge->Vertex1 < outEdgeBuckets.Size()) {
-            edge->NextV1 = outEdgeBuckets[edge->Vertex1];
-            outEdgeBuckets[edge->Vertex1] = edge;
+        if (edge->Vertex1 >= 0 && edge->Vertex1 < m_EdgeBuckets.Size()) {
+            edge->NextV1 = m_EdgeBuckets[edge->Vertex1];
+            m_EdgeBuckets[edge->Vertex1] = edge;
         }
     }
+    return true;
 }
 
 // ============================================================================
@@ -715,8 +683,6 @@ void NvStripifier::BuildStripifyInfo(
 // ============================================================================
 bool NvStripifier::FindAllStrips(
     XArray<NvStripInfo *> &outAllStrips,
-    XArray<NvFaceInfo *> &allFaces,
-    XArray<NvEdgeInfo *> &edgeBuckets,
     int numSamples,
     int minStripLength) {
 
@@ -725,10 +691,11 @@ bool NvStripifier::FindAllStrips(
     int experimentId = 0;
 
     XArray<NvFaceInfo *> usedResetPoints;
+    XArray<NvStripInfo *> candidates;
 
     for (int sample = 0; sample < numSamples; sample++) {
         // Find a good reset point
-        NvFaceInfo *resetPoint = FindGoodResetPoint(allFaces, edgeBuckets);
+        NvFaceInfo *resetPoint = FindGoodResetPoint();
         if (!resetPoint)
             return true;  // All faces used
 
@@ -745,7 +712,7 @@ bool NvStripifier::FindAllStrips(
         usedResetPoints.PushBack(resetPoint);
 
         // Generate 6 candidate strips (3 edges x 2 directions)
-        XArray<NvStripInfo *> candidates;
+        candidates.Resize(0);
 
         int edges[3][2] = {
             {resetPoint->V[0], resetPoint->V[1]},
@@ -754,7 +721,7 @@ bool NvStripifier::FindAllStrips(
         };
 
         for (int e = 0; e < 3; e++) {
-            NvEdgeInfo *edge = FindEdgeInfo(edgeBuckets, edges[e][0], edges[e][1]);
+            NvEdgeInfo *edge = FindEdgeInfo(m_EdgeBuckets, edges[e][0], edges[e][1]);
             if (!edge)
                 continue;
 
@@ -766,7 +733,7 @@ bool NvStripifier::FindAllStrips(
                 strip->StripId = stripId++;
                 strip->ExperimentId = experimentId++;
 
-                strip->Build(edgeBuckets, allFaces);
+                strip->Build();
 
                 candidates.PushBack(strip);
             }
@@ -818,79 +785,90 @@ void NvStripifier::SplitUpStripsAndOptimize(
 // ============================================================================
 // NvStripifier::CreateStrips (0x1A94)
 // ============================================================================
-void NvStripifier::CreateStrips(
+template <class IndexType>
+static void CreateStripIndices(
     const XArray<NvStripInfo *> &strips,
-    XArray<CKWORD> &outIndices,
+    XArray<IndexType> &outIndices,
     bool joinStrips,
     CKDWORD &outStripCount) {
 
+    const IndexType restart = (IndexType)0xFFFFFFFF;
+
     outIndices.Resize(0);
     outStripCount = 0;
-    XArray<XArray<CKWORD> > sequences;
-    sequences.Reserve(strips.Size());
     bool requiresJoinedFallback = false;
 
+    // Sequences of all the strips, back to back
+    XArray<IndexType> sequences;
+    XArray<int> lengths;
+    lengths.Reserve(strips.Size());
+
     for (int s = 0; s < strips.Size(); s++) {
         NvStripInfo *strip = strips[s];
         if (!strip || strip->Faces.Size() == 0)
             continue;
 
         // Build index sequence for this strip from the ordered face list.
-        XArray<CKWORD> seq;
-        if (!BuildStripIndexSequenceFromFaces(strip->Faces, seq))
+        const int start = sequences.Size();
+        if (!BuildStripIndexSequenceFromFaces(strip->Faces, sequences))
             continue;
 
-        if (seq.Size() == 0)
+        const int length = sequences.Size() - start;
+        if (length == 0)
             continue;
 
-        if (!joinStrips && SequenceContainsRestartValue(seq))
+        if (!joinStrips && SequenceContainsRestartValue(sequences.Begin() + start, length, restart))
             requiresJoinedFallback = true;
 
-        sequences.PushBack(seq);
+        lengths.PushBack(length);
     }
 
+    const IndexType *seq = sequences.Begin();
     if (joinStrips || requiresJoinedFallback) {
-        for (int i = 0; i < sequences.Size(); ++i)
-            AppendJoinedSequence(outIndices, sequences[i]);
+        outIndices.Reserve(sequences.Size() + 3 * lengths.Size());
+        for (int i = 0; i < lengths.Size(); ++i) {
+            AppendJoinedSequence(outIndices, seq, lengths[i]);
+            seq += lengths[i];
+        }
         outStripCount = (outIndices.Size() > 0) ? 1 : 0;
         return;
     }
 
-    for (int i = 0; i < sequences.Size(); ++i) {
+    outIndices.Reserve(sequences.Size() + lengths.Size());
+    for (int i = 0; i < lengths.Size(); ++i) {
         if (outIndices.Size() > 0)
-            outIndices.PushBack((CKWORD)0xFFFF);
+            outIndices.PushBack(restart);
 
-        const XArray<CKWORD> &seq = sequences[i];
-        for (int j = 0; j < seq.Size(); ++j)
+        for (int j = 0; j < lengths[i]; ++j)
             outIndices.PushBack(seq[j]);
-        if (seq.Size() > 0) {
-            outStripCount++;
-        }
+        seq += lengths[i];
+        outStripCount++;
     }
 }
 
+void NvStripifier::CreateStrips(
+    const XArray<NvStripInfo *> &strips,
+    XArray<CKWORD> &outIndices,
+    bool joinStrips,
+    CKDWORD &outStripCount) {
+    CreateStripIndices(strips, outIndices, joinStrips, outStripCount);
+}
+
+void NvStripifier::CreateStrips(
+    const XArray<NvStripInfo *> &strips,
+    XArray<CKDWORD> &outIndices,
+    bool joinStrips,
+    CKDWORD &outStripCount) {
+    CreateStripIndices(strips, outIndices, joinStrips, outStripCount);
+}
+
 // ============================================================================
 // NvStripifier::DestroyStrips - Cleanup method
 // ============================================================================
 void NvStripifier::DestroyStrips(XArray<NvStripInfo *> &strips) {
-    XArray<NvFaceInfo *> deletedFaces;
-    for (int i = 0; i < strips.Size(); i++) {
-        NvStripInfo *strip = strips[i];
-        if (!strip)
-            continue;
-
-        for (int j = 0; j < strip->Faces.Size(); ++j) {
-            NvFaceInfo *face = strip->Faces[j];
-            if (!face)
-                continue;
-            if (deletedFaces.Find(face) != deletedFaces.End())
-                continue;
-            deletedFaces.PushBack(face);
-            delete face;
-        }
-
-        delete strip;
-    }
+    // The faces belong to the stripifier
+    for (int i = 0; i < strips.Size(); i++)
+        delete strips[i];
     strips.Resize(0);
 }
 
@@ -898,7 +876,7 @@ void NvStripifier::DestroyStrips(XArray<NvStripInfo *> &strips) {
 // NvStripifier constructor/destructor
 // ============================================================================
 NvStripifier::NvStripifier()
-    : m_MinStripLength(0), m_CacheSize(0), m_Ratio(0.0f), m_FirstTime(1) {
+    : m_MinStripLength(0), m_CacheSize(0), m_Ratio(0.0f), m_FirstTime(1), m_ResetCursor(0) {
 }
 
 NvStripifier::~NvStripifier() {
@@ -907,17 +885,15 @@ NvStripifier::~NvStripifier() {
 // ============================================================================
 // NvStripifier::Stripify - Main API (0x1F24)
 // ============================================================================
-void NvStripifier::Stripify(
-    const XArray<CKWORD> &inIndices,
+template <class IndexType>
+void NvStripifier::StripifyIndices(
+    IndexType *indices,
+    int triCount,
     int minStripLength,
     int cacheSize,
-    CKWORD vertexCount,
+    int vertexCount,
     XArray<NvStripInfo *> &outStrips) {
 
-    outStrips.Resize(0);
-    if (inIndices.Size() < 3 || vertexCount == 0)
-        return;
-
     // Binary: internalMin = max(1, minStripLength - 6)
     int internalMin = minStripLength - 6;
     if (internalMin < 1)
@@ -928,31 +904,23 @@ void NvStripifier::Stripify(
     m_Ratio = 0.0f;
     m_FirstTime = 1;
 
-    // Copy indices to scratch
-    m_Scratch.Resize(0);
-    m_Scratch.Reserve(inIndices.Size());
-    for (int i = 0; i < inIndices.Size(); i++)
-        m_Scratch.PushBack(inIndices[i]);
-
     // Build adjacency info
-    XArray<NvFaceInfo *> faces;
-    XArray<NvEdgeInfo *> edgeBuckets;
-    XArray<NvEdgeInfo *> edges;
-    BuildStripifyInfo(m_Scratch, vertexCount, faces, edgeBuckets, edges);
+    if (!BuildStripifyInfo(indices, triCount, vertexCount))
+        return;
 
     // Find all strips (10 samples as in binary)
-    FindAllStrips(outStrips, faces, edgeBuckets, 10, m_MinStripLength);
+    FindAllStrips(outStrips, 10, m_MinStripLength);
 
     // SplitUpStripsAndOptimize is called but does minimal work for now
-    SplitUpStripsAndOptimize(outStrips, false, edgeBuckets);
+    SplitUpStripsAndOptimize(outStrips, false, m_EdgeBuckets);
 
     // Add remaining unmarked faces as single-triangle strips
-    for (int i = 0; i < faces.Size(); i++) {
-        NvFaceInfo *face = faces[i];
+    for (int i = m_ResetCursor; i < m_Faces.Size(); i++) {
+        NvFaceInfo *face = &m_Faces[i];
         if (face->MarkA < 0) {
             NvStripInfo *strip = new NvStripInfo();
             strip->StartFace = face;
-            strip->StartEdge = FindEdgeInfo(edgeBuckets, face->V[0], face->V[1]);
+            strip->StartEdge = FindEdgeInfo(m_EdgeBuckets, face->V[0], face->V[1]);
             strip->StartCW = 1;
             strip->ExperimentId = -1;
             strip->StripId = outStrips.Size();
@@ -961,9 +929,41 @@ void NvStripifier::Stripify(
             outStrips.PushBack(strip);
         }
     }
+}
+
+void NvStripifier::Stripify(
+    const XArray<CKWORD> &inIndices,
+    int minStripLength,
+    int cacheSize,
+    CKWORD vertexCount,
+    XArray<NvStripInfo *> &outStrips) {
+
+    outStrips.Resize(0);
+    if (inIndices.Size() < 3 || vertexCount == 0)
+        return;
+
+    // Copy indices to scratch
+    m_Scratch.Resize(0);
+    m_Scratch.Reserve(inIndices.Size());
+    for (int i = 0; i < inIndices.Size(); i++)
+        m_Scratch.PushBack(inIndices[i]);
 
-    for (int i = 0; i < edges.Size(); ++i)
-        delete edges[i];
+    StripifyIndices(m_Scratch.Begin(), inIndices.Size() / 3, minStripLength, cacheSize, vertexCount, outStrips);
+}
+
+void NvStripifier::Stripify(
+    const XArray<CKDWORD> &inIndices,
+    int minStripLength,
+    int cacheSize,
+    int vertexCount,
+    XArray<NvStripInfo *> &outStrips) {
+
+    outStrips.Resize(0);
+    if (inIndices.Size() < 3 || vertexCount <= 0)
+        return;
+
+    StripifyIndices((CKDWORD *)inIndices.Begin(), inIndices.Size() / 3, minStripLength, cacheSize, vertexCount,
+                    outStrips);
 }
 
 // ============================================================================
@@ -985,3 +985,18 @@ void NvStripifier::Stripify(
     // Cleanup strips
     DestroyStrips(strips);
 }
+
+void NvStripifier::Stripify(
+    const XArray<CKDWORD> &inIndices,
+    int minStripLength,
+    int cacheSize,
+    int vertexCount,
+    bool joinStrips,
+    XArray<CKDWORD> &outIndices,
+    CKDWORD &outStripCount) {
+
+    XArray<NvStripInfo *> strips;
+    Stripify(inIndices, minStripLength, cacheSize, vertexCount, strips);
+    CreateStrips(strips, outIndices, joinStrips, outStripCount);
+    DestroyStrips(strips);
+}
@@ -0,0 +1,321 @@
+#include "OverdrawOptimizer.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+// Load time of the vertices never loaded, far enough in the past to never be cached
+const int kNeverLoaded = -0x40000000;
+
+// Resolution of the views of the overdraw counter
+const int kOverdrawGridSize = 256;
+
+template <class IndexType>
+int GetIndexedVertexCount(const IndexType *indices, int indexCount) {
+    int vertexCount = 0;
+    for (int i = 0; i < indexCount; ++i) {
+        if ((int) indices[i] >= vertexCount)
+            vertexCount = (int) indices[i] + 1;
+    }
+    return vertexCount;
+}
+
+inline const VxVector &GetPosition(const VxVector *positions, CKDWORD stride, int vertex) {
+    return *(const VxVector *) ((const CKBYTE *) positions + vertex * stride);
+}
+
+// Corner positions of a face, FALSE when one of its indices is out of range
+template <class IndexType>
+CKBOOL GetFacePositions(const IndexType *face, const VxVector *positions, CKDWORD stride, int vertexCount,
+                        const VxVector *corners[3]) {
+    for (int c = 0; c < 3; ++c) {
+        if ((CKDWORD) face[c] >= (CKDWORD) vertexCount)
+            return FALSE;
+        corners[c] = &GetPosition(positions, stride, face[c]);
+    }
+    return TRUE;
+}
+
+// Exactly one of the two directions of an edge owns the pixel centers lying on it
+inline CKBOOL OwnsEdge(float dx, float dy) {
+    return dy > 0.0f || (dy == 0.0f && dx > 0.0f);
+}
+
+inline float EdgeFunction(float ax, float ay, float bx, float by, float px, float py) {
+    return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+}
+
+// Depth tested rasterization of a triangle given in pixels, returns the
+// pixels passing the depth test
+int RasterizeTriangle(float *depths, int size, const float x[3], const float y[3], const float z[3]) {
+    int i1 = 1;
+    int i2 = 2;
+    float area = EdgeFunction(x[0], y[0], x[1], y[1], x[2], y[2]);
+    if (area == 0.0f)
+        return 0;
+    if (area < 0.0f) {
+        i1 = 2;
+        i2 = 1;
+        area = -area;
+    }
+    const float vx[3] = {x[0], x[i1], x[i2]};
+    const float vy[3] = {y[0], y[i1], y[i2]};
+    const float vz[3] = {z[0], z[i1], z[i2]};
+
+    const int minX = XMax((int) floorf(XMin(vx[0], XMin(vx[1], vx[2]))), 0);
+    const int maxX = XMin((int) ceilf(XMax(vx[0], XMax(vx[1], vx[2]))), size - 1);
+    const int minY = XMax((int) floorf(XMin(vy[0], XMin(vy[1], vy[2]))), 0);
+    const int maxY = XMin((int) ceilf(XMax(vy[0], XMax(vy[1], vy[2]))), size - 1);
+    const float invArea = 1.0f / area;
+
+    int shaded = 0;
+    for (int py = minY; py <= maxY; ++py) {
+        const float cy = (float) py + 0.5f;
+        for (int px = minX; px <= maxX; ++px) {
+            const float cx = (float) px + 0.5f;
+            float weights[3];
+            CKBOOL inside = TRUE;
+            for (int e = 0; e < 3 && inside; ++e) {
+                const int a = (e + 1) % 3;
+                const int b = (e + 2) % 3;
+                weights[e] = EdgeFunction(vx[a], vy[a], vx[b], vy[b], cx, cy);
+                inside = weights[e] > 0.0f || (weights[e] == 0.0f && OwnsEdge(vx[b] - vx[a], vy[b] - vy[a]));
+            }
+            if (!inside)
+                continue;
+
+            const float depth = (weights[0] * vz[0] + weights[1] * vz[1] + weights[2] * vz[2]) * invArea;
+            float &stored = depths[py * size + px];
+            if (depth < stored) {
+                stored = depth;
+                ++shaded;
+            }
+        }
+    }
+    return shaded;
+}
+
+} // namespace
+
+OverdrawOptimizer::OverdrawOptimizer() : m_CacheSize(0), m_Clock(0) {}
+
+void OverdrawOptimizer::Optimize(const CKWORD *indices, int faceCount, const VxVector *positions,
+                                 CKDWORD positionStride, int vertexCount, int cacheSize, float threshold,
+                                 CKWORD *output) {
+    Reorder(indices, faceCount, positions, positionStride, vertexCount, cacheSize, threshold, output);
+}
+
+void OverdrawOptimizer::Optimize(const CKDWORD *indices, int faceCount, const VxVector *positions,
+                                 CKDWORD positionStride, int vertexCount, int cacheSize, float threshold,
+                                 CKDWORD *output) {
+    Reorder(indices, faceCount, positions, positionStride, vertexCount, cacheSize, threshold, output);
+}
+
+float OverdrawOptimizer::ComputeOverdraw(const CKWORD *indices, int faceCount, const VxVector *positions,
+                                         CKDWORD positionStride, int vertexCount) {
+    return Rasterize(indices, faceCount, positions, positionStride, vertexCount);
+}
+
+float OverdrawOptimizer::ComputeOverdraw(const CKDWORD *indices, int faceCount, const VxVector *positions,
+                                         CKDWORD positionStride, int vertexCount) {
+    return Rasterize(indices, faceCount, positions, positionStride, vertexCount);
+}
+
+void OverdrawOptimizer::ResetCache(int vertexCount, int cacheSize) {
+    m_CacheSize = cacheSize;
+    m_Clock = 0;
+    m_LoadTimes.Resize(vertexCount);
+    for (int v = 0; v < vertexCount; ++v)
+        m_LoadTimes[v] = kNeverLoaded;
+}
+
+int OverdrawOptimizer::LoadVertex(int vertex) {
+    if (m_Clock - m_LoadTimes[vertex] <= m_CacheSize)
+        return 0;
+    m_LoadTimes[vertex] = m_Clock++;
+    return 1;
+}
+
+template <class IndexType>
+void OverdrawOptimizer::BuildClusters(const IndexType *indices, int faceCount, int vertexCount, int cacheSize,
+                                      float threshold) {
+    ResetCache(vertexCount, cacheSize);
+
+    // Cold cache: the vertex cache order moved to another part of the mesh
+    XArray<int> hardStarts;
+    for (int f = 0; f < faceCount; ++f) {
+        const IndexType *face = indices + f * 3;
+        const int misses = LoadVertex(face[0]) + LoadVertex(face[1]) + LoadVertex(face[2]);
+        if (f == 0 || misses == 3)
+            hardStarts.PushBack(f);
+    }
+    hardStarts.PushBack(faceCount);
+
+    m_ClusterStarts.Resize(0);
+    for (int h = 0; h + 1 < hardStarts.Size(); ++h) {
+        const int start = hardStarts[h];
+        const int end = hardStarts[h + 1];
+
+        FlushCache();
+        int partMisses = 0;
+        for (int f = start; f < end; ++f) {
+            const IndexType *face = indices + f * 3;
+            partMisses += LoadVertex(face[0]) + LoadVertex(face[1]) + LoadVertex(face[2]);
+        }
+        const float clusterMisses = threshold * (float) partMisses / (float) (end - start);
+
+        FlushCache();
+        m_ClusterStarts.PushBack(start);
+        int runMisses = 0;
+        int runFaces = 0;
+        for (int f = start; f < end; ++f) {
+            const IndexType *face = indices + f * 3;
+            runMisses += LoadVertex(face[0]) + LoadVertex(face[1]) + LoadVertex(face[2]);
+            ++runFaces;
+            if ((float) runMisses <= clusterMisses * (float) runFaces && f + 1 < end) {
+                m_ClusterStarts.PushBack(f + 1);
+                FlushCache();
+                runMisses = 0;
+                runFaces = 0;
+            }
+        }
+    }
+}
+
+template <class IndexType>
+void OverdrawOptimizer::ComputeClusterKeys(const IndexType *indices, int faceCount, const VxVector *positions,
+                                           CKDWORD positionStride, int vertexCount) {
+    // Area weighted centroid of the surface
+    VxVector meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (int f = 0; f < faceCount; ++f) {
+        const VxVector *corners[3];
+        if (!GetFacePositions(indices + f * 3, positions, positionStride, vertexCount, corners))
+            continue;
+        const float area = Magnitude(CrossProduct(*corners[1] - *corners[0], *corners[2] - *corners[0]));
+        meshCentroid += (*corners[0] + *corners[1] + *corners[2]) * area;
+        meshArea += area;
+    }
+    if (meshArea > 0.0f)
+        meshCentroid /= 3.0f * meshArea;
+
+    // The keys hold the opposite of the occlusion potential: the sorter
+    // orders them increasing and keeps the order of equal keys
+    const int clusterCount = m_ClusterStarts.Size();
+    m_ClusterKeys.Resize(clusterCount);
+    for (int c = 0; c < clusterCount; ++c) {
+        const int end = (c + 1 < clusterCount) ? m_ClusterStarts[c + 1] : faceCount;
+        VxVector centroid(0.0f);
+        VxVector normal(0.0f);
+        float area = 0.0f;
+        for (int f = m_ClusterStarts[c]; f < end; ++f) {
+            const VxVector *corners[3];
+            if (!GetFacePositions(indices + f * 3, positions, positionStride, vertexCount, corners))
+                continue;
+            const VxVector faceNormal = CrossProduct(*corners[1] - *corners[0], *corners[2] - *corners[0]);
+            const float faceArea = Magnitude(faceNormal);
+            centroid += (*corners[0] + *corners[1] + *corners[2]) * faceArea;
+            normal += faceNormal;
+            area += faceArea;
+        }
+
+        const float normalLength = Magnitude(normal);
+        if (area > 0.0f && normalLength > 0.0f) {
+            centroid /= 3.0f * area;
+            m_ClusterKeys[c] = -DotProduct(centroid - meshCentroid, normal) / normalLength;
+        } else {
+            m_ClusterKeys[c] = 0.0f;
+        }
+    }
+}
+
+template <class IndexType>
+void OverdrawOptimizer::Reorder(const IndexType *indices, int faceCount, const VxVector *positions,
+                                CKDWORD positionStride, int vertexCount, int cacheSize, float threshold,
+                                IndexType *output) {
+    if (!indices || !positions || !output || faceCount <= 0)
+        return;
+    if (cacheSize < 3)
+        cacheSize = 3;
+
+    BuildClusters(indices, faceCount, GetIndexedVertexCount(indices, faceCount * 3), cacheSize, threshold);
+    ComputeClusterKeys(indices, faceCount, positions, positionStride, vertexCount);
+    const int clusterCount = m_ClusterStarts.Size();
+    // The sorter starts from its previous order, which can hold more clusters
+    const CKDWORD *order = m_Sorter.ResetIndices().Sort(m_ClusterKeys.Begin(), (CKDWORD) clusterCount).GetIndices();
+
+    // Reordering in place reads the faces from a copy
+    XArray<IndexType> source;
+    if (output == indices) {
+        source.Resize(faceCount * 3);
+        memcpy(source.Begin(), indices, faceCount * 3 * sizeof(IndexType));
+        indices = source.Begin();
+    }
+    IndexType *out = output;
+    for (int i = 0; i < clusterCount; ++i) {
+        const int c = (int) order[i];
+        const int start = m_ClusterStarts[c];
+        const int end = (c + 1 < clusterCount) ? m_ClusterStarts[c + 1] : faceCount;
+        memcpy(out, indices + start * 3, (end - start) * 3 * sizeof(IndexType));
+        out += (end - start) * 3;
+    }
+}
+
+template <class IndexType>
+float OverdrawOptimizer::Rasterize(const IndexType *indices, int faceCount, const VxVector *positions,
+                                   CKDWORD positionStride, int vertexCount) {
+    if (!indices || !positions || faceCount <= 0 || vertexCount <= 0)
+        return 0.0f;
+
+    VxVector minimum(FLT_MAX);
+    VxVector maximum(-FLT_MAX);
+    for (int v = 0; v < vertexCount; ++v) {
+        const VxVector &p = GetPosition(positions, positionStride, v);
+        minimum = Minimize(minimum, p);
+        maximum = Maximize(maximum, p);
+    }
+
+    const int size = kOverdrawGridSize;
+    m_Depths.Resize(size * size);
+    int shaded = 0;
+    int covered = 0;
+    for (int view = 0; view < 6; ++view) {
+        // Looking along +axis or -axis, the other two axes are the pixel ones
+        const int axis = view / 2;
+        const float direction = (view & 1) ? -1.0f : 1.0f;
+        const int u = (axis + 1) % 3;
+        const int w = (axis + 2) % 3;
+        const float extent = XMax(maximum[u] - minimum[u], maximum[w] - minimum[w]);
+        if (extent <= 0.0f)
+            continue;
+        const float scale = (float) size / extent;
+
+        for (int i = 0; i < size * size; ++i)
+            m_Depths[i] = FLT_MAX;
+
+        for (int f = 0; f < faceCount; ++f) {
+            const VxVector *corners[3];
+            if (!GetFacePositions(indices + f * 3, positions, positionStride, vertexCount, corners))
+                continue;
+            const VxVector normal = CrossProduct(*corners[1] - *corners[0], *corners[2] - *corners[0]);
+            if (normal[axis] * direction >= 0.0f)
+                continue;
+
+            float x[3], y[3], z[3];
+            for (int c = 0; c < 3; ++c) {
+                x[c] = ((*corners[c])[u] - minimum[u]) * scale;
+                y[c] = ((*corners[c])[w] - minimum[w]) * scale;
+                z[c] = (*corners[c])[axis] * direction;
+            }
+            shaded += RasterizeTriangle(m_Depths.Begin(), size, x, y, z);
+        }
+
+        for (int i = 0; i < size * size; ++i) {
+            if (m_Depths[i] != FLT_MAX)
+                ++covered;
+        }
+    }
+    return covered ? (float) shaded / (float) covered : 0.0f;
+}
@@ -0,0 +1,416 @@
+/// @file PointIndex.cpp
+/// @brief Implementation of the hashed grid and k-d tree point index
+
+#include "PointIndex.h"
+
+#include "CKJobPool.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+namespace {
+
+// Points per k-d tree leaf
+const int kLeafSize = 8;
+
+// Deepest k-d tree, with room for the far children pushed on the way down
+const int kMaxTreeDepth = 64;
+
+// Queries per task when a batch is split over the job pool
+const int kQueryChunkSize = 256;
+
+// Cell coordinates are clamped so that the extent of a query box fits an int
+const float kMaxCellCoord = (float) (1 << 29);
+
+inline CKDWORD HashCell(int x, int y, int z) {
+    return ((CKDWORD) x * 73856093u) ^ ((CKDWORD) y * 19349663u) ^ ((CKDWORD) z * 83492791u);
+}
+
+inline float Distance2(const VxVector &a, const VxVector &b) {
+    const float dx = a.x - b.x;
+    const float dy = a.y - b.y;
+    const float dz = a.z - b.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+int CompareInts(const void *a, const void *b) {
+    const int ia = *(const int *) a;
+    const int ib = *(const int *) b;
+    return (ia < ib) ? -1 : (ia > ib) ? 1 : 0;
+}
+
+struct NearestBatch {
+    const PointIndex *Index;
+    const CKBYTE *Points;
+    CKDWORD Stride;
+    int Count;
+    float Radius;
+    int *Results;
+};
+
+void NearestBatchTask(void *context, int index) {
+    const NearestBatch &batch = *(const NearestBatch *) context;
+    const int begin = index * kQueryChunkSize;
+    const int end = (batch.Count - begin > kQueryChunkSize) ? begin + kQueryChunkSize : batch.Count;
+    for (int i = begin; i < end; ++i) {
+        const VxVector &p = *(const VxVector *) (batch.Points + i * batch.Stride);
+        batch.Results[i] = batch.Index->FindNearest(p, batch.Radius);
+    }
+}
+
+} // namespace
+
+// Keeps the nearest point, the first added on ties
+struct PointIndexNearest {
+    VxVector p;
+    float best2;
+    int bestOrder;
+
+    template <class PointType>
+    void operator()(const PointType &point) {
+        const float distance2 = Distance2(point.pt, p);
+        if (distance2 < best2 || (distance2 == best2 && point.order < bestOrder)) {
+            best2 = distance2;
+            bestOrder = point.order;
+        }
+    }
+};
+
+// Collects the addition order of the points within the radius
+struct PointIndexInRadius {
+    VxVector p;
+    float radius2;
+    XArray<int> *orders;
+
+    template <class PointType>
+    void operator()(const PointType &point) {
+        if (Distance2(point.pt, p) <= radius2)
+            orders->PushBack(point.order);
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Constructor
+////////////////////////////////////////////////////////////////////////////////
+PointIndex::PointIndex()
+    : m_Mode(HASHED_GRID), m_CellSize(1.0f), m_InvCellSize(1.0f), m_BuiltCount(0), m_CellCount(0) {}
+
+////////////////////////////////////////////////////////////////////////////////
+// Destructor
+////////////////////////////////////////////////////////////////////////////////
+PointIndex::~PointIndex() {}
+
+////////////////////////////////////////////////////////////////////////////////
+// Points
+////////////////////////////////////////////////////////////////////////////////
+void PointIndex::Clear() {
+    m_Positions.Resize(0);
+    m_Indices.Resize(0);
+    m_Points.Resize(0);
+    m_Cells.Resize(0);
+    m_Nodes.Resize(0);
+    m_CellCount = 0;
+    m_BuiltCount = 0;
+}
+
+void PointIndex::Reserve(int count) {
+    m_Positions.Reserve(count);
+    m_Indices.Reserve(count);
+}
+
+void PointIndex::AddPoint(const VxVector &p, int index) {
+    m_Positions.PushBack(p);
+    m_Indices.PushBack(index);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Build
+////////////////////////////////////////////////////////////////////////////////
+void PointIndex::Build() {
+    m_InvCellSize = 1.0f / m_CellSize;
+    m_BuiltCount = m_Positions.Size();
+    m_Points.Resize(m_BuiltCount);
+    m_Cells.Resize(0);
+    m_Nodes.Resize(0);
+    m_CellCount = 0;
+    if (m_BuiltCount == 0)
+        return;
+
+    if (m_Mode == KD_TREE)
+        BuildTree();
+    else
+        BuildGrid();
+}
+
+int PointIndex::CellCoord(float value) const {
+    float cell = floorf(value * m_InvCellSize);
+    if (cell < -kMaxCellCoord)
+        cell = -kMaxCellCoord;
+    if (cell > kMaxCellCoord)
+        cell = kMaxCellCoord;
+    return (int) cell;
+}
+
+int PointIndex::FindCellSlot(int x, int y, int z) const {
+    const int mask = m_Cells.Size() - 1;
+    for (int slot = (int) (HashCell(x, y, z) & mask);; slot = (slot + 1) & mask) {
+        const Cell &cell = m_Cells[slot];
+        if (cell.count == 0)
+            return -1;
+        if (cell.x == x && cell.y == y && cell.z == z)
+            return slot;
+    }
+}
+
+// Counting sort of the points by cell, in addition order within a cell
+void PointIndex::BuildGrid() {
+    const int count = m_BuiltCount;
+
+    // At most half full, so that probes stay short
+    int capacity = 16;
+    while (capacity < count * 2)
+        capacity <<= 1;
+    m_Cells.Resize(capacity);
+    m_Cells.Memset(0);
+    m_PointSlots.Resize(count);
+
+    const int mask = capacity - 1;
+    for (int i = 0; i < count; ++i) {
+        const VxVector &p = m_Positions[i];
+        const int x = CellCoord(p.x);
+        const int y = CellCoord(p.y);
+        const int z = CellCoord(p.z);
+        int slot = (int) (HashCell(x, y, z) & mask);
+        while (m_Cells[slot].count != 0 && (m_Cells[slot].x != x || m_Cells[slot].y != y || m_Cells[slot].z != z))
+            slot = (slot + 1) & mask;
+
+        Cell &cell = m_Cells[slot];
+        if (cell.count == 0) {
+            cell.x = x;
+            cell.y = y;
+            cell.z = z;
+            ++m_CellCount;
+        }
+        ++cell.count;
+        m_PointSlots[i] = slot;
+    }
+
+    int start = 0;
+    for (int slot = 0; slot < capacity; ++slot) {
+        m_Cells[slot].start = start;
+        start += m_Cells[slot].count;
+    }
+
+    // The starts are used as write cursors, then moved back
+    for (int i = 0; i < count; ++i) {
+        Point &point = m_Points[m_Cells[m_PointSlots[i]].start++];
+        point.pt = m_Positions[i];
+        point.order = i;
+    }
+    for (int slot = 0; slot < capacity; ++slot)
+        m_Cells[slot].start -= m_Cells[slot].count;
+}
+
+// Moves the nth smallest point along axis to nth, the smaller ones before it
+// and the larger ones after it
+void PointIndex::SelectPoint(Point *points, int begin, int end, int nth, int axis) {
+    while (end - begin > 2) {
+        const float pivot = points[(begin + end) / 2].pt[axis];
+        int i = begin;
+        int j = end - 1;
+        while (i <= j) {
+            while (points[i].pt[axis] < pivot)
+                ++i;
+            while (points[j].pt[axis] > pivot)
+                --j;
+            if (i <= j) {
+                XSwap(points[i], points[j]);
+                ++i;
+                --j;
+            }
+        }
+        // [begin, j] <= pivot <= [i, end), pivot between them
+        if (nth <= j)
+            end = j + 1;
+        else if (nth >= i)
+            begin = i;
+        else
+            return;
+    }
+    if (end - begin == 2 && points[begin].pt[axis] > points[begin + 1].pt[axis])
+        XSwap(points[begin], points[begin + 1]);
+}
+
+void PointIndex::BuildTree() {
+    for (int i = 0; i < m_BuiltCount; ++i) {
+        m_Points[i].pt = m_Positions[i];
+        m_Points[i].order = i;
+    }
+    m_Nodes.Reserve(2 * m_BuiltCount / kLeafSize + 1);
+    BuildNode(0, m_BuiltCount);
+}
+
+// Splits the points at the median of their largest extent
+int PointIndex::BuildNode(int begin, int end) {
+    const int index = m_Nodes.Size();
+    Node node;
+    node.begin = begin;
+    node.end = end;
+    node.left = -1;
+    node.right = -1;
+    node.axis = 0;
+    node.split = 0.0f;
+    m_Nodes.PushBack(node);
+    if (end - begin <= kLeafSize)
+        return index;
+
+    VxVector minimum = m_Points[begin].pt;
+    VxVector maximum = minimum;
+    for (int i = begin + 1; i < end; ++i) {
+        minimum = Minimize(minimum, m_Points[i].pt);
+        maximum = Maximize(maximum, m_Points[i].pt);
+    }
+    const VxVector extent = maximum - minimum;
+    int axis = 0;
+    if (extent.y > extent[axis])
+        axis = 1;
+    if (extent.z > extent[axis])
+        axis = 2;
+    if (extent[axis] <= 0.0f)
+        return index; // All the points at the same place
+
+    // The children reorder their points: the median is read before
+    const int middle = (begin + end) / 2;
+    SelectPoint(m_Points.Begin(), begin, end, middle, axis);
+    const float split = m_Points[middle].pt[axis];
+    const int left = BuildNode(begin, middle);
+    const int right = BuildNode(middle, end);
+
+    Node &parent = m_Nodes[index];
+    parent.left = left;
+    parent.right = right;
+    parent.axis = axis;
+    parent.split = split;
+    return index;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Queries
+////////////////////////////////////////////////////////////////////////////////
+template <class Visitor>
+void PointIndex::VisitPoints(const VxVector &p, float radius, const float &best2, Visitor &visitor) const {
+    if (m_BuiltCount == 0 || radius < 0.0f)
+        return;
+
+    if (m_Mode == KD_TREE) {
+        // Far children are kept with the squared distance to their plane
+        struct Entry {
+            int node;
+            float distance2;
+        } stack[kMaxTreeDepth];
+        int top = 0;
+        stack[top].node = 0;
+        stack[top].distance2 = 0.0f;
+        ++top;
+        while (top > 0) {
+            const Entry entry = stack[--top];
+            if (entry.distance2 > best2)
+                continue;
+            const Node &node = m_Nodes[entry.node];
+            if (node.left < 0) {
+                for (int i = node.begin; i < node.end; ++i)
+                    visitor(m_Points[i]);
+                continue;
+            }
+            const float offset = p[node.axis] - node.split;
+            stack[top].node = (offset < 0.0f) ? node.right : node.left;
+            stack[top].distance2 = offset * offset;
+            ++top;
+            stack[top].node = (offset < 0.0f) ? node.left : node.right;
+            stack[top].distance2 = entry.distance2;
+            ++top;
+        }
+        return;
+    }
+
+    const int minX = CellCoord(p.x - radius);
+    const int minY = CellCoord(p.y - radius);
+    const int minZ = CellCoord(p.z - radius);
+    const int maxX = CellCoord(p.x + radius);
+    const int maxY = CellCoord(p.y + radius);
+    const int maxZ = CellCoord(p.z + radius);
+
+    // A box wider than the occupied cells: scan them instead
+    const float boxCells = (float) (maxX - minX + 1) * (float) (maxY - minY + 1) * (float) (maxZ - minZ + 1);
+    if (boxCells > (float) m_CellCount) {
+        for (int slot = 0; slot < m_Cells.Size(); ++slot) {
+            const Cell &cell = m_Cells[slot];
+            if (cell.count == 0 || cell.x < minX || cell.x > maxX || cell.y < minY || cell.y > maxY ||
+                cell.z < minZ || cell.z > maxZ)
+                continue;
+            for (int i = cell.start; i < cell.start + cell.count; ++i)
+                visitor(m_Points[i]);
+        }
+        return;
+    }
+
+    for (int z = minZ; z <= maxZ; ++z) {
+        for (int y = minY; y <= maxY; ++y) {
+            for (int x = minX; x <= maxX; ++x) {
+                const int slot = FindCellSlot(x, y, z);
+                if (slot < 0)
+                    continue;
+                const Cell &cell = m_Cells[slot];
+                for (int i = cell.start; i < cell.start + cell.count; ++i)
+                    visitor(m_Points[i]);
+            }
+        }
+    }
+}
+
+int PointIndex::FindNearest(const VxVector &p, float radius) const {
+    PointIndexNearest nearest;
+    nearest.p = p;
+    nearest.best2 = radius * radius;
+    nearest.bestOrder = 0x7fffffff;
+    VisitPoints(p, radius, nearest.best2, nearest);
+    return (nearest.bestOrder != 0x7fffffff) ? m_Indices[nearest.bestOrder] : -1;
+}
+
+void PointIndex::FindNearest(const VxVector *points, CKDWORD stride, int count, float radius, int *results,
+                             CKJobPool *pool) const {
+    if (!points || !results || count <= 0)
+        return;
+
+    NearestBatch batch;
+    batch.Index = this;
+    batch.Points = (const CKBYTE *) points;
+    batch.Stride = stride;
+    batch.Count = count;
+    batch.Radius = radius;
+    batch.Results = results;
+
+    const int chunkCount = (count + kQueryChunkSize - 1) / kQueryChunkSize;
+    if (pool && pool->GetWorkerCount() > 0 && chunkCount > 1) {
+        pool->Run(chunkCount, NearestBatchTask, &batch);
+    } else {
+        for (int c = 0; c < chunkCount; ++c)
+            NearestBatchTask(&batch, c);
+    }
+}
+
+int PointIndex::FindInRadius(const VxVector &p, float radius, XArray<int> &results) const {
+    const int first = results.Size();
+    PointIndexInRadius inRadius;
+    inRadius.p = p;
+    inRadius.radius2 = radius * radius;
+    inRadius.orders = &results;
+    VisitPoints(p, radius, inRadius.radius2, inRadius);
+
+    const int count = results.Size() - first;
+    if (count > 1)
+        ::qsort(results.Begin() + first, count, sizeof(int), CompareInts);
+    for (int i = first; i < results.Size(); ++i)
+        results[i] = m_Indices[results[i]];
+    return count;
+}
@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+#include "CKJobPool.h"
+#include "MeshAdjacency.h"
+#include "RadixSort.h"
+
+// Computes the adjacency of generated meshes of up to 1M triangles and
+// reports the build times of MeshAdjacency, single threaded and split over a
+// CKJobPool, against a reference copy of the previous implementation: three
+// radix sorts of all the edges by face and vertices, then a scan of the runs.
+
+namespace {
+
+// ----------------------------------------------------------------------------
+// Previous MeshAdjacency::Compute
+// ----------------------------------------------------------------------------
+namespace reference {
+
+void AddEdge(XArray<MeshAdjacency::Edge> &edges, CKDWORD v0, CKDWORD v1, CKDWORD face, CKDWORD edgeIndex) {
+    MeshAdjacency::Edge &edge = edges[face * 3 + edgeIndex];
+    edge.vertices[0] = (v0 < v1) ? v0 : v1;
+    edge.vertices[1] = (v0 < v1) ? v1 : v0;
+    edge.faces[0] = face;
+    edge.faces[1] = 0xffffffff;
+}
+
+void UpdateLink(XArray<MeshAdjacency::Face> &faces, CKDWORD face1, CKDWORD face2, CKDWORD v0, CKDWORD v1) {
+    MeshAdjacency::Face &tri0 = faces[face1];
+    MeshAdjacency::Face &tri1 = faces[face2];
+    const CKBYTE edgeNb0 = tri0.FindEdge(v0, v1);
+    const CKBYTE edgeNb1 = tri1.FindEdge(v0, v1);
+    tri0.faces[edgeNb0] = face2 | (CKDWORD(edgeNb1) << 30);
+    tri1.faces[edgeNb1] = face1 | (CKDWORD(edgeNb0) << 30);
+}
+
+bool Compute(const CKDWORD *indices, int faceCount, XArray<MeshAdjacency::Face> &faces,
+             XArray<MeshAdjacency::Edge> &edges) {
+    faces.Resize(faceCount);
+    edges.Resize(faceCount * 3);
+    for (int f = 0; f < faceCount; ++f) {
+        const CKDWORD *v = indices + f * 3;
+        for (int k = 0; k < 3; ++k) {
+            faces[f].vertices[k] = v[k];
+            faces[f].faces[k] = 0xffffffff;
+        }
+        AddEdge(edges, v[0], v[1], f, 0);
+        AddEdge(edges, v[0], v[2], f, 1);
+        AddEdge(edges, v[1], v[2], f, 2);
+    }
+
+    const int edgeCount = edges.Size();
+    XArray<CKDWORD> tempFaces;
+    XArray<CKDWORD> tempV0;
+    XArray<CKDWORD> tempV1;
+    tempFaces.Resize(edgeCount);
+    tempV0.Resize(edgeCount);
+    tempV1.Resize(edgeCount);
+    for (int i = 0; i < edgeCount; ++i) {
+        tempFaces[i] = edges[i].faces[0];
+        tempV0[i] = edges[i].vertices[0];
+        tempV1[i] = edges[i].vertices[1];
+    }
+
+    RadixSorter sorter;
+    const CKDWORD *sorted = sorter.Sort(tempFaces.Begin(), edgeCount)
+                                .Sort(tempV0.Begin(), edgeCount)
+                                .Sort(tempV1.Begin(), edgeCount)
+                                .GetIndices();
+
+    int runStart = 0;
+    for (int i = 1; i <= edgeCount; ++i) {
+        if (i < edgeCount && tempV0[sorted[i]] == tempV0[sorted[runStart]] &&
+            tempV1[sorted[i]] == tempV1[sorted[runStart]])
+            continue;
+        const int count = i - runStart;
+        if (count > 2)
+            return false;
+        if (count == 2) {
+            UpdateLink(faces, tempFaces[sorted[runStart]], tempFaces[sorted[runStart + 1]], tempV0[sorted[runStart]],
+                       tempV1[sorted[runStart]]);
+            edges[sorted[runStart]].faces[1] = tempFaces[sorted[runStart + 1]];
+            edges[sorted[runStart + 1]].faces[0] = 0xffffffff;
+        }
+        runStart = i;
+    }
+
+    int writeIndex = 0;
+    for (int readIndex = 0; readIndex < edgeCount; ++readIndex) {
+        if (edges[readIndex].faces[0] != 0xffffffff)
+            edges[writeIndex++] = edges[readIndex];
+    }
+    edges.Resize(writeIndex);
+    return true;
+}
+
+} // namespace reference
+
+struct BenchMesh {
+    const char *name;
+    XArray<CKDWORD> indices;
+};
+
+void BuildGrid(BenchMesh &mesh, int w, int h) {
+    for (int j = 0; j < h; ++j) {
+        for (int i = 0; i < w; ++i) {
+            const CKDWORD a = j * (w + 1) + i;
+            const CKDWORD quad[6] = {a, a + 1, a + w + 2, a, a + w + 2, a + w + 1};
+            for (int k = 0; k < 6; ++k)
+                mesh.indices.PushBack(quad[k]);
+        }
+    }
+}
+
+// Closed tube: a grid wrapped around so that every edge is shared
+void BuildTorus(BenchMesh &mesh, int rings, int segments) {
+    for (int r = 0; r < rings; ++r) {
+        for (int s = 0; s < segments; ++s) {
+            const CKDWORD a = r * segments + s;
+            const CKDWORD b = r * segments + (s + 1) % segments;
+            const CKDWORD c = ((r + 1) % rings) * segments + (s + 1) % segments;
+            const CKDWORD d = ((r + 1) % rings) * segments + s;
+            const CKDWORD quad[6] = {a, b, c, a, c, d};
+            for (int k = 0; k < 6; ++k)
+                mesh.indices.PushBack(quad[k]);
+        }
+    }
+}
+
+void ShuffleFaces(BenchMesh &mesh) {
+    const int faceCount = mesh.indices.Size() / 3;
+    for (int i = faceCount - 1; i > 0; --i) {
+        const int j = (int) (((CKDWORD) rand() << 15 ^ (CKDWORD) rand()) % (CKDWORD) (i + 1));
+        for (int k = 0; k < 3; ++k)
+            XSwap(mesh.indices[i * 3 + k], mesh.indices[j * 3 + k]);
+    }
+}
+
+bool SameAdjacency(const MeshAdjacency &adjacency, const XArray<MeshAdjacency::Face> &faces,
+                   const XArray<MeshAdjacency::Edge> &edges) {
+    if (adjacency.GetEdges().Size() != edges.Size())
+        return false;
+    for (int f = 0; f < faces.Size(); ++f) {
+        for (int k = 0; k < 3; ++k) {
+            if (adjacency.GetFaces()[f].faces[k] != faces[f].faces[k])
+                return false;
+        }
+    }
+    for (int e = 0; e < edges.Size(); ++e) {
+        const MeshAdjacency::Edge &a = adjacency.GetEdges()[e];
+        if (a.vertices[0] != edges[e].vertices[0] || a.vertices[1] != edges[e].vertices[1] ||
+            a.faces[0] != edges[e].faces[0] || a.faces[1] != edges[e].faces[1])
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    CKJobPool pool;
+    pool.Start(CKJobPool::GetAutoWorkerCount(-1));
+    const int iterations = 5;
+
+    BenchMesh meshes[4];
+    meshes[0].name = "grid";
+    BuildGrid(meshes[0], 400, 300);
+    meshes[1].name = "shuffled grid";
+    BuildGrid(meshes[1], 400, 300);
+    meshes[2].name = "torus";
+    BuildTorus(meshes[2], 500, 500);
+    meshes[3].name = "shuffled torus";
+    BuildTorus(meshes[3], 1000, 500);
+    srand(7);
+    ShuffleFaces(meshes[1]);
+    ShuffleFaces(meshes[3]);
+
+    printf("workers: %d\n", pool.GetWorkerCount());
+    printf("%-16s %8s %-10s %10s %9s %6s\n", "mesh", "faces", "path", "time (ms)", "speedup", "same");
+    for (int m = 0; m < 4; ++m) {
+        BenchMesh &mesh = meshes[m];
+        const int faceCount = mesh.indices.Size() / 3;
+
+        XArray<MeshAdjacency::Face> faces;
+        XArray<MeshAdjacency::Edge> edges;
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; ++i)
+            reference::Compute(mesh.indices.Begin(), faceCount, faces, edges);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+        const double referenceTime = elapsed.count() / iterations;
+        printf("%-16s %8d %-10s %10.2f %8.2fx %6s\n", mesh.name, faceCount, "sort", referenceTime, 1.0, "-");
+
+        for (int p = 0; p < 2; ++p) {
+            MeshAdjacency adjacency;
+            start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                adjacency.Init(mesh.indices.Begin(), faceCount);
+                adjacency.Compute(true, true, p ? &pool : nullptr);
+            }
+            elapsed = std::chrono::high_resolution_clock::now() - start;
+            const double time = elapsed.count() / iterations;
+            printf("%-16s %8d %-10s %10.2f %8.2fx %6s\n", mesh.name, faceCount, p ? "pooled" : "buckets", time,
+                   referenceTime / time, SameAdjacency(adjacency, faces, edges) ? "yes" : "NO");
+        }
+    }
+    return 0;
+}
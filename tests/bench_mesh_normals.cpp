@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+#include "RCKMesh.h"
+
+// Times the generic and SIMD normal kernels on meshes from 1k to 500k faces.
+// Indices are 16 bits, so large meshes reuse a 65536 vertex grid.
+
+namespace {
+
+typedef void (*BuildNormalsFunc)(CKFace *, CKWORD *, int, VxVertex *, int);
+
+struct Kernel {
+    const char *name;
+    CK_MESHSIMD level;
+    BuildNormalsFunc buildFaceNormals;
+    BuildNormalsFunc buildNormals;
+};
+
+const Kernel kKernels[] = {
+    {"generic", CK_MESHSIMD_NONE, BuildFaceNormalsGenericFunc, BuildNormalsGenericFunc},
+    {"SSE2", CK_MESHSIMD_SSE2, BuildFaceNormalsSSE2Func, BuildNormalsSSE2Func},
+    {"AVX2", CK_MESHSIMD_AVX2, BuildFaceNormalsAVX2Func, BuildNormalsAVX2Func},
+};
+
+struct BenchMesh {
+    XArray<VxVertex> vertices;
+    XArray<CKFace> faces;
+    XArray<CKWORD> indices;
+};
+
+void BuildGridMesh(BenchMesh &mesh, int faceCount) {
+    int side = 2;
+    while (side < 256 && 2 * (side - 1) * (side - 1) < faceCount)
+        ++side;
+
+    mesh.vertices.Resize(side * side);
+    for (int i = 0; i < mesh.vertices.Size(); ++i) {
+        VxVertex &v = mesh.vertices[i];
+        v.m_Position.Set((float) (i % side), (float) (rand() % 100) * 0.01f, (float) (i / side));
+        v.m_Normal.Set(0.0f, 1.0f, 0.0f);
+        v.m_UV = Vx2DVector(0.0f, 0.0f);
+    }
+
+    const int cells = (side - 1) * (side - 1);
+    mesh.faces.Resize(faceCount);
+    mesh.indices.Resize(faceCount * 3);
+    for (int f = 0; f < faceCount; ++f) {
+        const int cell = (f / 2) % cells;
+        const CKWORD a = (CKWORD) (cell / (side - 1) * side + cell % (side - 1));
+        CKWORD *tri = &mesh.indices[f * 3];
+        tri[0] = (f & 1) ? (CKWORD) (a + 1) : a;
+        tri[1] = (f & 1) ? (CKWORD) (a + side + 1) : (CKWORD) (a + 1);
+        tri[2] = (CKWORD) (a + side);
+        mesh.faces[f].m_MatIndex = 0;
+        mesh.faces[f].m_ChannelMask = 0;
+    }
+}
+
+double TimeKernel(BuildNormalsFunc func, BenchMesh &mesh, int iterations) {
+    func(mesh.faces.Begin(), mesh.indices.Begin(), mesh.faces.Size(), mesh.vertices.Begin(), mesh.vertices.Size());
+
+    const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func(mesh.faces.Begin(), mesh.indices.Begin(), mesh.faces.Size(), mesh.vertices.Begin(), mesh.vertices.Size());
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+} // namespace
+
+int main() {
+    const int faceCounts[] = {1000, 10000, 50000, 100000, 250000, 500000};
+    const int kernelCount = (int) (sizeof(kKernels) / sizeof(kKernels[0]));
+    const CK_MESHSIMD level = GetMeshSIMDLevel();
+
+    printf("SIMD level: %s\n", level == CK_MESHSIMD_AVX2 ? "AVX2" : level == CK_MESHSIMD_SSE2 ? "SSE2" : "none");
+    printf("%8s %-8s %14s %14s %9s\n", "faces", "kernel", "face (ms)", "vertex (ms)", "speedup");
+
+    for (int c = 0; c < (int) (sizeof(faceCounts) / sizeof(faceCounts[0])); ++c) {
+        srand(7);
+        BenchMesh mesh;
+        BuildGridMesh(mesh, faceCounts[c]);
+        const int iterations = faceCounts[c] >= 100000 ? 20 : 200;
+
+        double genericTime = 0.0;
+        for (int k = 0; k < kernelCount; ++k) {
+            if (kKernels[k].level > level)
+                continue;
+
+            const double faceTime = TimeKernel(kKernels[k].buildFaceNormals, mesh, iterations);
+            const double vertexTime = TimeKernel(kKernels[k].buildNormals, mesh, iterations);
+            if (k == 0)
+                genericTime = vertexTime;
+            printf("%8d %-8s %14.4f %14.4f %8.2fx\n", faceCounts[c], kKernels[k].name, faceTime, vertexTime,
+                   vertexTime > 0.0 ? genericTime / vertexTime : 0.0);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+#include "ForsythVertexCacheOptimizer.h"
+#include "OverdrawOptimizer.h"
+
+// Runs OverdrawOptimizer after the vertex cache optimizer on generated
+// meshes and reports the overdraw of the software counter, the ACMR of a
+// FIFO cache of 16 vertices and the time of the pass for a few thresholds.
+
+namespace {
+
+const int kCacheSize = 16;
+
+struct BenchMesh {
+    const char *name;
+    XArray<VxVector> positions;
+    XArray<CKWORD> indices;
+};
+
+void PushQuad(BenchMesh &mesh, int a, int b, int c, int d) {
+    const CKWORD quad[6] = {(CKWORD) a, (CKWORD) b, (CKWORD) c, (CKWORD) a, (CKWORD) c, (CKWORD) d};
+    for (int i = 0; i < 6; ++i)
+        mesh.indices.PushBack(quad[i]);
+}
+
+void AddSphere(BenchMesh &mesh, const VxVector &center, float radius, int rings, int segments) {
+    const int first = mesh.positions.Size();
+    for (int r = 0; r <= rings; ++r) {
+        const float theta = 3.14159265f * (float) r / (float) rings;
+        for (int s = 0; s < segments; ++s) {
+            const float phi = 2.0f * 3.14159265f * (float) s / (float) segments;
+            mesh.positions.PushBack(center + VxVector(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi)) *
+                                                 radius);
+        }
+    }
+    for (int r = 0; r < rings; ++r) {
+        for (int s = 0; s < segments; ++s) {
+            const int a = first + r * segments + s;
+            const int b = first + r * segments + (s + 1) % segments;
+            PushQuad(mesh, a, b, b + segments, a + segments);
+        }
+    }
+}
+
+// Closed box from its 8 corners, faces outward
+void AddBox(BenchMesh &mesh, const VxVector &minimum, const VxVector &maximum) {
+    const int first = mesh.positions.Size();
+    for (int i = 0; i < 8; ++i)
+        mesh.positions.PushBack(VxVector((i & 1) ? maximum.x : minimum.x, (i & 2) ? maximum.y : minimum.y,
+                                         (i & 4) ? maximum.z : minimum.z));
+    PushQuad(mesh, first + 0, first + 2, first + 3, first + 1); // -z
+    PushQuad(mesh, first + 4, first + 5, first + 7, first + 6); // +z
+    PushQuad(mesh, first + 0, first + 4, first + 6, first + 2); // -x
+    PushQuad(mesh, first + 1, first + 3, first + 7, first + 5); // +x
+    PushQuad(mesh, first + 0, first + 1, first + 5, first + 4); // -y
+    PushQuad(mesh, first + 2, first + 6, first + 7, first + 3); // +y
+}
+
+// Heightfield of side x side vertices, faces up
+void AddTerrain(BenchMesh &mesh, int side, float size, float height) {
+    const int first = mesh.positions.Size();
+    for (int j = 0; j < side; ++j) {
+        for (int i = 0; i < side; ++i) {
+            const float x = size * ((float) i / (float) (side - 1) - 0.5f);
+            const float z = size * ((float) j / (float) (side - 1) - 0.5f);
+            mesh.positions.PushBack(VxVector(x, height * sinf(x * 0.7f) * cosf(z * 0.5f), z));
+        }
+    }
+    for (int j = 0; j < side - 1; ++j) {
+        for (int i = 0; i < side - 1; ++i) {
+            const int a = first + j * side + i;
+            PushQuad(mesh, a, a + side, a + side + 1, a + 1);
+        }
+    }
+}
+
+void BuildNestedSpheres(BenchMesh &mesh) {
+    mesh.name = "nested spheres";
+    for (int s = 1; s <= 4; ++s)
+        AddSphere(mesh, VxVector(0.0f), (float) s, 24, 48);
+}
+
+void BuildCity(BenchMesh &mesh) {
+    mesh.name = "city blocks";
+    AddTerrain(mesh, 64, 40.0f, 0.0f);
+    for (int j = 0; j < 12; ++j) {
+        for (int i = 0; i < 12; ++i) {
+            const float x = -18.0f + 3.0f * (float) i;
+            const float z = -18.0f + 3.0f * (float) j;
+            const float height = 1.0f + (float) (rand() % 8);
+            AddBox(mesh, VxVector(x, 0.0f, z), VxVector(x + 2.0f, height, z + 2.0f));
+        }
+    }
+}
+
+void BuildHills(BenchMesh &mesh) {
+    mesh.name = "hills";
+    AddTerrain(mesh, 160, 40.0f, 6.0f);
+}
+
+void BuildSphereCluster(BenchMesh &mesh) {
+    mesh.name = "sphere cluster";
+    for (int i = 0; i < 40; ++i) {
+        const VxVector center((float) (rand() % 100) * 0.1f, (float) (rand() % 100) * 0.1f,
+                              (float) (rand() % 100) * 0.1f);
+        AddSphere(mesh, center, 1.0f + (float) (rand() % 10) * 0.1f, 12, 24);
+    }
+}
+
+} // namespace
+
+int main() {
+    void (*builders[])(BenchMesh &) = {BuildNestedSpheres, BuildCity, BuildHills, BuildSphereCluster};
+    const float thresholds[] = {1.0f, 1.05f, 1.2f};
+    const int iterations = 10;
+
+    printf("FIFO cache: %d vertices\n", kCacheSize);
+    printf("%-16s %7s %9s %8s %8s %9s %8s %10s\n", "mesh", "faces", "threshold", "clusters", "ACMR", "overdraw",
+           "time ms", "reduction");
+
+    ForsythVertexCacheOptimizer cacheOptimizer;
+    OverdrawOptimizer overdrawOptimizer;
+    srand(7);
+    for (int b = 0; b < (int) (sizeof(builders) / sizeof(builders[0])); ++b) {
+        BenchMesh mesh;
+        builders[b](mesh);
+        const int faceCount = mesh.indices.Size() / 3;
+        const int vertexCount = mesh.positions.Size();
+        cacheOptimizer.Optimize(mesh.indices.Begin(), faceCount, vertexCount, kCacheSize, mesh.indices.Begin());
+
+        const float cacheOverdraw = overdrawOptimizer.ComputeOverdraw(mesh.indices.Begin(), faceCount,
+                                                                      mesh.positions.Begin(), sizeof(VxVector),
+                                                                      vertexCount);
+        printf("%-16s %7d %9s %8s %8.3f %9.3f %8s %10s\n", mesh.name, faceCount, "cache", "-",
+               cacheOptimizer.ComputeACMR(mesh.indices.Begin(), faceCount, kCacheSize), cacheOverdraw, "-", "-");
+
+        XArray<CKWORD> reordered;
+        reordered.Resize(mesh.indices.Size());
+        for (int t = 0; t < (int) (sizeof(thresholds) / sizeof(thresholds[0])); ++t) {
+            const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; ++i)
+                overdrawOptimizer.Optimize(mesh.indices.Begin(), faceCount, mesh.positions.Begin(), sizeof(VxVector),
+                                           vertexCount, kCacheSize, thresholds[t], reordered.Begin());
+            const std::chrono::duration<double, std::milli> elapsed =
+                std::chrono::high_resolution_clock::now() - start;
+
+            const float overdraw = overdrawOptimizer.ComputeOverdraw(reordered.Begin(), faceCount,
+                                                                     mesh.positions.Begin(), sizeof(VxVector),
+                                                                     vertexCount);
+            printf("%-16s %7d %9.2f %8d %8.3f %9.3f %8.3f %9.1f%%\n", mesh.name, faceCount, thresholds[t],
+                   overdrawOptimizer.GetClusterCount(),
+                   cacheOptimizer.ComputeACMR(reordered.Begin(), faceCount, kCacheSize), overdraw,
+                   elapsed.count() / iterations,
+                   cacheOverdraw > 1.0f ? 100.0f * (cacheOverdraw - overdraw) / (cacheOverdraw - 1.0f) : 0.0f);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,223 @@
+#include <math.h>
+#include <stdio.h>
+
+#include <chrono>
+
+#include "CKJobPool.h"
+#include "PointIndex.h"
+
+// Welds generated point sets: each vertex, moved by a tenth of the
+// tolerance, looks up its nearest point within the tolerance. Reports the
+// build and query times of PointIndex in both modes, single threaded and
+// batched over a CKJobPool, against a reference copy of the previous
+// NearestPointGrid: a dense array of cell pointers over the bounding box.
+
+namespace {
+
+// ----------------------------------------------------------------------------
+// Previous NearestPointGrid, points in grid units
+// ----------------------------------------------------------------------------
+namespace reference {
+
+class DenseGrid {
+public:
+    struct Point {
+        VxVector pt;
+        int index;
+    };
+    typedef XArray<Point> Cell;
+
+    DenseGrid(int sizeX, int sizeY, int sizeZ) : m_SizeX(sizeX), m_SizeY(sizeY), m_SizeZ(sizeZ) {
+        m_Grid.Resize(sizeX * sizeY * sizeZ);
+        m_Grid.Memset(0);
+    }
+
+    ~DenseGrid() {
+        for (int a = 0; a < m_Grid.Size(); ++a)
+            delete m_Grid[a];
+    }
+
+    void AddPoint(const VxVector &p, int index) {
+        Cell *&cell = m_Grid[(int) p.x + m_SizeX * ((int) p.y + m_SizeY * (int) p.z)];
+        if (!cell)
+            cell = new Cell;
+        Point point;
+        point.pt = p;
+        point.index = index;
+        cell->PushBack(point);
+    }
+
+    int FindNearPoint(const VxVector &p, float threshold) const {
+        int minX = (int) (p.x - threshold), maxX = (int) (p.x + threshold);
+        int minY = (int) (p.y - threshold), maxY = (int) (p.y + threshold);
+        int minZ = (int) (p.z - threshold), maxZ = (int) (p.z + threshold);
+        minX = XMax(minX, 0);
+        minY = XMax(minY, 0);
+        minZ = XMax(minZ, 0);
+        maxX = XMin(maxX, m_SizeX - 1);
+        maxY = XMin(maxY, m_SizeY - 1);
+        maxZ = XMin(maxZ, m_SizeZ - 1);
+
+        int bestIndex = -1;
+        float bestDistance2 = threshold * threshold;
+        for (int z = minZ; z <= maxZ; ++z) {
+            for (int y = minY; y <= maxY; ++y) {
+                for (int x = minX; x <= maxX; ++x) {
+                    const Cell *cell = m_Grid[x + m_SizeX * (y + m_SizeY * z)];
+                    if (!cell)
+                        continue;
+                    for (int a = 0; a < cell->Size(); ++a) {
+                        const VxVector d = (*cell)[a].pt - p;
+                        const float distance2 = d.x * d.x + d.y * d.y + d.z * d.z;
+                        if (distance2 > bestDistance2)
+                            continue;
+                        bestDistance2 = distance2;
+                        bestIndex = (*cell)[a].index;
+                    }
+                }
+            }
+        }
+        return bestIndex;
+    }
+
+private:
+    XArray<Cell *> m_Grid;
+    int m_SizeX, m_SizeY, m_SizeZ;
+};
+
+} // namespace reference
+
+struct Random {
+    CKDWORD seed;
+
+    float Next() {
+        seed = seed * 1664525u + 1013904223u;
+        return (float) (seed >> 8) / (float) (1 << 24);
+    }
+};
+
+struct BenchSet {
+    const char *name;
+    float tolerance;
+    XArray<VxVector> points;
+};
+
+// Points spread over a cube of the given side
+void BuildUniform(BenchSet &set, int count, float side) {
+    Random random = {3};
+    for (int i = 0; i < count; ++i)
+        set.points.PushBack(VxVector(random.Next(), random.Next(), random.Next()) * side);
+}
+
+// Small dense parts scattered over a large assembly
+void BuildAssembly(BenchSet &set, int partCount, int pointsPerPart, float side) {
+    Random random = {11};
+    for (int p = 0; p < partCount; ++p) {
+        const VxVector origin(random.Next() * side, random.Next() * side, random.Next() * side);
+        const float size = 0.5f + random.Next() * 4.0f;
+        for (int i = 0; i < pointsPerPart; ++i)
+            set.points.PushBack(origin + VxVector(random.Next(), random.Next(), random.Next()) * size);
+    }
+}
+
+double Milliseconds(const std::chrono::high_resolution_clock::time_point &start) {
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count();
+}
+
+} // namespace
+
+int main() {
+    CKJobPool pool;
+    pool.Start(CKJobPool::GetAutoWorkerCount(-1));
+
+    // The dense grid is capped as PlaceFitter caps it
+    const int maxCells = 128;
+
+    BenchSet sets[3];
+    sets[0].name = "uniform";
+    sets[0].tolerance = 0.05f;
+    BuildUniform(sets[0], 300000, 64.0f);
+    sets[1].name = "assembly";
+    sets[1].tolerance = 0.002f;
+    BuildAssembly(sets[1], 300, 1000, 1000.0f);
+    sets[2].name = "dense assembly";
+    sets[2].tolerance = 0.0005f;
+    BuildAssembly(sets[2], 60, 5000, 1000.0f);
+
+    printf("workers: %d, dense grid: at most %d cells per axis\n", pool.GetWorkerCount(), maxCells);
+    printf("%-15s %7s %-12s %10s %10s %9s %6s\n", "set", "points", "index", "build (ms)", "query (ms)", "speedup",
+           "same");
+    for (int s = 0; s < 3; ++s) {
+        BenchSet &set = sets[s];
+        const int count = set.points.Size();
+        VxVector minimum = set.points[0];
+        VxVector maximum = minimum;
+        for (int i = 1; i < count; ++i) {
+            minimum = Minimize(minimum, set.points[i]);
+            maximum = Maximize(maximum, set.points[i]);
+        }
+
+        XArray<VxVector> queries;
+        Random random = {29};
+        for (int i = 0; i < count; ++i) {
+            const VxVector offset(random.Next() - 0.5f, random.Next() - 0.5f, random.Next() - 0.5f);
+            queries.PushBack(set.points[i] + offset * (0.2f * set.tolerance));
+        }
+
+        // Reference: grid units of the cell size, capped at maxCells
+        const VxVector extent = maximum - minimum;
+        const float cellSize = XMax(XMax(extent.x, extent.y), extent.z) / (float) (maxCells - 2);
+        const int sizeX = XMin((int) (extent.x / cellSize) + 2, maxCells);
+        const int sizeY = XMin((int) (extent.y / cellSize) + 2, maxCells);
+        const int sizeZ = XMin((int) (extent.z / cellSize) + 2, maxCells);
+        XArray<int> expected;
+        expected.Resize(count);
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        double buildTime;
+        double referenceTime;
+        {
+            reference::DenseGrid grid(sizeX, sizeY, sizeZ);
+            for (int i = 0; i < count; ++i)
+                grid.AddPoint((set.points[i] - minimum) / cellSize, i);
+            buildTime = Milliseconds(start);
+            start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < count; ++i)
+                expected[i] = grid.FindNearPoint((queries[i] - minimum) / cellSize, set.tolerance / cellSize);
+            referenceTime = buildTime + Milliseconds(start);
+        }
+        printf("%-15s %7d %-12s %10.2f %10.2f %8.2fx %6s\n", set.name, count, "dense grid", buildTime,
+               referenceTime - buildTime, 1.0, "-");
+
+        const char *names[4] = {"hashed grid", "kd tree", "hashed/pool", "kd tree/pool"};
+        XArray<int> results;
+        results.Resize(count);
+        for (int m = 0; m < 4; ++m) {
+            PointIndex index;
+            index.SetMode((m & 1) ? PointIndex::KD_TREE : PointIndex::HASHED_GRID);
+            index.SetCellSize(8.0f * set.tolerance);
+            start = std::chrono::high_resolution_clock::now();
+            index.Reserve(count);
+            for (int i = 0; i < count; ++i)
+                index.AddPoint(set.points[i], i);
+            index.Build();
+            buildTime = Milliseconds(start);
+
+            start = std::chrono::high_resolution_clock::now();
+            if (m >= 2) {
+                index.FindNearest(queries.Begin(), sizeof(VxVector), count, set.tolerance, results.Begin(), &pool);
+            } else {
+                for (int i = 0; i < count; ++i)
+                    results[i] = index.FindNearest(queries[i], set.tolerance);
+            }
+            const double queryTime = Milliseconds(start);
+
+            int same = 0;
+            for (int i = 0; i < count; ++i)
+                same += results[i] == expected[i];
+            printf("%-15s %7d %-12s %10.2f %10.2f %8.2fx %5.1f%%\n", set.name, count, names[m], buildTime, queryTime,
+                   referenceTime / (buildTime + queryTime), 100.0 * same / count);
+        }
+    }
+    return 0;
+}
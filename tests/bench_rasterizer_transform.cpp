@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+#include "CKRasterizerSIMD.h"
+
+// Times the generic and SIMD rasterizer kernels: transform with clip flags
+// and screen projection of 1k to 500k vertices laid out like a VxVertex
+// buffer, and clip flags of as many boxes.
+
+namespace {
+
+struct Kernel {
+    const char *name;
+    CKRST_SIMD level;
+};
+
+const Kernel kKernels[] = {
+    {"generic", CKRST_SIMD_NONE},
+    {"SSE2", CKRST_SIMD_SSE2},
+    {"AVX", CKRST_SIMD_AVX},
+};
+
+struct BenchVertex {
+    VxVector Position;
+    VxVector Normal;
+    float U, V;
+};
+
+struct BenchData {
+    XArray<BenchVertex> vertices;
+    XArray<VxVector4> clip;
+    XArray<VxVector4> screen;
+    XArray<CKDWORD> flags;
+    XArray<VxBbox> boxes;
+    XArray<CKDWORD> orFlags;
+    XArray<CKDWORD> andFlags;
+};
+
+float RandomFloat(float range) {
+    return ((float) rand() / (float) RAND_MAX * 2.0f - 1.0f) * range;
+}
+
+void BuildData(BenchData &data, int count) {
+    data.vertices.Resize(count);
+    data.clip.Resize(count);
+    data.screen.Resize(count);
+    data.flags.Resize(count);
+    data.boxes.Resize(count);
+    data.orFlags.Resize(count);
+    data.andFlags.Resize(count);
+    for (int i = 0; i < count; ++i) {
+        const VxVector p(RandomFloat(10.0f), RandomFloat(10.0f), RandomFloat(10.0f));
+        data.vertices[i].Position = p;
+        data.vertices[i].Normal.Set(0.0f, 1.0f, 0.0f);
+        data.vertices[i].U = data.vertices[i].V = 0.0f;
+        data.boxes[i] = VxBbox(p - VxVector(0.5f), p + VxVector(0.5f));
+    }
+}
+
+void BuildViewProj(VxMatrix &mat) {
+    Vx3DMatrixIdentity(mat);
+    const float q = 1000.0f / 999.0f;
+    mat[0][0] = 0.75f;
+    mat[2][2] = q;
+    mat[2][3] = 1.0f;
+    mat[3][2] = -q + 12.0f * q;
+    mat[3][3] = 12.0f;
+}
+
+enum BenchOp {
+    BENCH_TRANSFORM,
+    BENCH_PROJECT,
+    BENCH_BOXES,
+};
+
+void RunOp(BenchOp op, CKRST_SIMD level, const VxMatrix &mat, BenchData &data) {
+    const int count = data.vertices.Size();
+    switch (op) {
+    case BENCH_TRANSFORM:
+        CKRstTransformVertices(level, mat, data.vertices.Begin(), sizeof(BenchVertex), data.clip.Begin(),
+                               sizeof(VxVector4), data.flags.Begin(), count);
+        break;
+    case BENCH_PROJECT:
+        CKRstProjectVertices(level, data.clip.Begin(), sizeof(VxVector4), data.screen.Begin(), sizeof(VxVector4),
+                             count, 320.0f, 240.0f, 320.0f, 240.0f);
+        break;
+    case BENCH_BOXES:
+        CKRstComputeBoxesClipFlags(level, mat, data.boxes.Begin(), count, data.orFlags.Begin(),
+                                   data.andFlags.Begin());
+        break;
+    }
+}
+
+double TimeKernel(BenchOp op, CKRST_SIMD level, const VxMatrix &mat, BenchData &data, int iterations) {
+    RunOp(op, level, mat, data);
+
+    const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        RunOp(op, level, mat, data);
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+} // namespace
+
+int main() {
+    const int counts[] = {1000, 10000, 50000, 100000, 250000, 500000};
+    const int kernelCount = (int) (sizeof(kKernels) / sizeof(kKernels[0]));
+    const CKRST_SIMD level = GetRasterizerSIMDLevel();
+
+    VxMatrix mat;
+    BuildViewProj(mat);
+
+    printf("SIMD level: %s\n", level == CKRST_SIMD_AVX ? "AVX" : level == CKRST_SIMD_SSE2 ? "SSE2" : "none");
+    printf("%8s %-8s %14s %14s %14s %9s\n", "count", "kernel", "transform (ms)", "project (ms)", "boxes (ms)",
+           "speedup");
+
+    for (int c = 0; c < (int) (sizeof(counts) / sizeof(counts[0])); ++c) {
+        srand(7);
+        BenchData data;
+        BuildData(data, counts[c]);
+        const int iterations = counts[c] >= 100000 ? 20 : 200;
+
+        double genericTime = 0.0;
+        for (int k = 0; k < kernelCount; ++k) {
+            if (kKernels[k].level > level)
+                continue;
+
+            const double transformTime = TimeKernel(BENCH_TRANSFORM, kKernels[k].level, mat, data, iterations);
+            const double projectTime = TimeKernel(BENCH_PROJECT, kKernels[k].level, mat, data, iterations);
+            const double boxTime = TimeKernel(BENCH_BOXES, kKernels[k].level, mat, data, iterations);
+            if (k == 0)
+                genericTime = transformTime;
+            printf("%8d %-8s %14.4f %14.4f %14.4f %8.2fx\n", counts[c], kKernels[k].name, transformTime, projectTime,
+                   boxTime, transformTime > 0.0 ? genericTime / transformTime : 0.0);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+#include "CKJobPool.h"
+#include "CKSkinEngine.h"
+#include "RCKMesh.h"
+#include "RCKSkin.h"
+
+// Times the bone-major loop of the original CalcPointsEx against the
+// vertex-major kernels, single threaded and split over a CKJobPool.
+// Each configuration skins a crowd of identical characters (positions and
+// normals, 4 influences per vertex, 60 bones).
+
+namespace {
+
+const int kBoneCount = 60;
+const int kChunkSize = 1024;
+
+struct Kernel {
+    const char *name;
+    CK_MESHSIMD level;
+    CKSkinVerticesFunc func;
+};
+
+const Kernel kKernels[] = {
+    {"generic", CK_MESHSIMD_NONE, SkinVerticesGenericFunc},
+    {"SSE2", CK_MESHSIMD_SSE2, SkinVerticesSSE2Func},
+    {"AVX2", CK_MESHSIMD_AVX2, SkinVerticesAVX2Func},
+};
+
+// Per-bone lists of the original code
+struct BonePoints {
+    XArray<VxVector4> weightedVertices;
+    XArray<VxVector4> weightedNormals;
+    XArray<int> vertexIndices;
+};
+
+struct BenchSkin {
+    XClassArray<RCKSkinVertexData> vertexData;
+    XArray<VxVector> normals;
+    XArray<VxMatrix> palette;
+    XClassArray<BonePoints> points;
+    CKSkinInfluenceTable table;
+    XArray<VxVertex> out;
+};
+
+float RandomFloat(float range) {
+    return ((float) rand() / (float) RAND_MAX * 2.0f - 1.0f) * range;
+}
+
+void BuildBenchSkin(BenchSkin &skin, int vertexCount) {
+    skin.vertexData.Resize(vertexCount);
+    skin.normals.Resize(vertexCount);
+    skin.points.Resize(kBoneCount);
+    for (int v = 0; v < vertexCount; ++v) {
+        RCKSkinVertexData &vd = skin.vertexData[v];
+        VxVector pos(RandomFloat(1.0f), RandomFloat(2.0f), RandomFloat(0.5f));
+        vd.SetInitialPos(pos);
+        skin.normals[v] = Normalize(VxVector(RandomFloat(1.0f), RandomFloat(1.0f), 1.0f));
+
+        // Neighbouring bones, as along a limb
+        const int first = rand() % (kBoneCount - 4);
+        vd.SetBoneCount(4);
+        const float weights[4] = {0.5f, 0.3f, 0.15f, 0.05f};
+        for (int b = 0; b < 4; ++b) {
+            vd.SetBone(b, first + b);
+            vd.SetWeight(b, weights[b]);
+
+            BonePoints &points = skin.points[first + b];
+            points.weightedVertices.PushBack(VxVector4(pos.x, pos.y, pos.z, weights[b]));
+            points.weightedNormals.PushBack(VxVector4(skin.normals[v].x, skin.normals[v].y, skin.normals[v].z, weights[b]));
+            points.vertexIndices.PushBack(v);
+        }
+    }
+
+    skin.palette.Resize(kBoneCount);
+    for (int i = 0; i < kBoneCount; ++i) {
+        VxMatrix &m = skin.palette[i];
+        Vx3DMatrixIdentity(m);
+        m[3][0] = RandomFloat(1.0f);
+        m[3][1] = RandomFloat(1.0f);
+        m[3][2] = RandomFloat(1.0f);
+    }
+    skin.table.Build(skin.vertexData.Begin(), vertexCount, kBoneCount, skin.normals.Begin(), skin.normals.Size(), FALSE);
+    skin.out.Resize(vertexCount);
+}
+
+void SkinBoneMajor(BenchSkin &skin) {
+    CKBYTE *positions = (CKBYTE *) &skin.out[0].m_Position;
+    CKBYTE *normals = (CKBYTE *) &skin.out[0].m_Normal;
+    VxVector zero(0.0f, 0.0f, 0.0f);
+    VxFillStructure(skin.out.Size(), positions, sizeof(VxVertex), sizeof(VxVector), &zero);
+    VxFillStructure(skin.out.Size(), normals, sizeof(VxVertex), sizeof(VxVector), &zero);
+
+    for (int b = 0; b < kBoneCount; ++b) {
+        const BonePoints &points = skin.points[b];
+        const VxMatrix &m = skin.palette[b];
+        for (int p = 0; p < points.vertexIndices.Size(); ++p) {
+            VxVertex &out = skin.out[points.vertexIndices[p]];
+            const VxVector4 &wv = points.weightedVertices[p];
+            const VxVector4 &wn = points.weightedNormals[p];
+            VxVector pos(wv.x, wv.y, wv.z);
+            VxVector norm(wn.x, wn.y, wn.z);
+            VxVector transformed;
+            Vx3DMultiplyMatrixVector(&transformed, m, &pos);
+            out.m_Position += transformed * wv.w;
+            Vx3DRotateVector(&transformed, m, &norm);
+            out.m_Normal += transformed * wn.w;
+        }
+    }
+}
+
+void SkinTable(BenchSkin &skin, CKSkinVerticesFunc func, int begin, int end) {
+    func(skin.table, skin.palette.Begin(), begin, end, (CKBYTE *) &skin.out[0].m_Position, sizeof(VxVertex),
+         (CKBYTE *) &skin.out[0].m_Normal, sizeof(VxVertex));
+}
+
+struct ChunkBatch {
+    XClassArray<BenchSkin> *skins;
+    CKSkinVerticesFunc func;
+    int chunksPerSkin;
+};
+
+void ChunkTask(void *context, int index) {
+    ChunkBatch &batch = *(ChunkBatch *) context;
+    BenchSkin &skin = (*batch.skins)[index / batch.chunksPerSkin];
+    const int begin = (index % batch.chunksPerSkin) * kChunkSize;
+    const int end = begin + kChunkSize < skin.out.Size() ? begin + kChunkSize : skin.out.Size();
+    SkinTable(skin, batch.func, begin, end);
+}
+
+typedef std::chrono::high_resolution_clock Clock;
+
+double Elapsed(const Clock::time_point &start, int iterations) {
+    const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+} // namespace
+
+int main() {
+    const int vertexCounts[] = {2000, 10000, 50000};
+    const int skinCounts[] = {200, 40, 8};
+    const CK_MESHSIMD level = GetMeshSIMDLevel();
+    CKSkinVerticesFunc best = GetSkinVerticesFunc();
+
+    CKJobPool pool;
+    pool.Start(CKJobPool::GetAutoWorkerCount(-1));
+
+    printf("SIMD level: %s, workers: %d\n", level == CK_MESHSIMD_AVX2 ? "AVX2" : level == CK_MESHSIMD_SSE2 ? "SSE2" : "none",
+           pool.GetWorkerCount());
+    printf("%8s %6s %-12s %12s %9s\n", "vertices", "skins", "path", "frame (ms)", "speedup");
+
+    for (int c = 0; c < 3; ++c) {
+        srand(3);
+        XClassArray<BenchSkin> skins;
+        skins.Resize(skinCounts[c]);
+        for (int s = 0; s < skins.Size(); ++s)
+            BuildBenchSkin(skins[s], vertexCounts[c]);
+        const int iterations = 10;
+
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            for (int s = 0; s < skins.Size(); ++s)
+                SkinBoneMajor(skins[s]);
+        }
+        const double boneMajorTime = Elapsed(start, iterations);
+        printf("%8d %6d %-12s %12.3f %8.2fx\n", vertexCounts[c], skins.Size(), "bone-major", boneMajorTime, 1.0);
+
+        for (int k = 0; k < (int) (sizeof(kKernels) / sizeof(kKernels[0])); ++k) {
+            if (kKernels[k].level > level)
+                continue;
+            start = Clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                for (int s = 0; s < skins.Size(); ++s)
+                    SkinTable(skins[s], kKernels[k].func, 0, vertexCounts[c]);
+            }
+            const double time = Elapsed(start, iterations);
+            printf("%8d %6d %-12s %12.3f %8.2fx\n", vertexCounts[c], skins.Size(), kKernels[k].name, time,
+                   time > 0.0 ? boneMajorTime / time : 0.0);
+        }
+
+        ChunkBatch batch;
+        batch.skins = &skins;
+        batch.func = best;
+        batch.chunksPerSkin = (vertexCounts[c] + kChunkSize - 1) / kChunkSize;
+        start = Clock::now();
+        for (int i = 0; i < iterations; ++i)
+            pool.Run(skins.Size() * batch.chunksPerSkin, ChunkTask, &batch);
+        const double pooledTime = Elapsed(start, iterations);
+        printf("%8d %6d %-12s %12.3f %8.2fx\n", vertexCounts[c], skins.Size(), "pooled", pooledTime,
+               pooledTime > 0.0 ? boneMajorTime / pooledTime : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+
+#include "CKSoftRasterizer.h"
+
+// Renders a scene of 131k triangles and 72k vertices with the software
+// rasterizer and reports the frame time by thread count. The scene is one
+// 32-bit indexed triangle list, drawn in chunks of at most 0x10000 vertices
+// with rebased 16-bit indices, as RCKMesh draws its wide meshes.
+
+namespace {
+
+const int kWidth = 1280;
+const int kHeight = 720;
+const int kSphereColumns = 16;
+const int kSphereRows = 8;
+const int kSegments = 32;
+const int kRings = 16;
+
+struct BenchScene {
+    XArray<VxVector> positions;
+    XArray<CKDWORD> colors;
+    XArray<CKDWORD> indices;
+};
+
+// Overlapping spheres in front of the camera, so that the depth test rejects
+// part of the fragments and back faces are culled
+void BuildScene(BenchScene &scene) {
+    for (int row = 0; row < kSphereRows; ++row) {
+        for (int column = 0; column < kSphereColumns; ++column) {
+            const VxVector center((float) column * 2.6f - 19.5f, (float) row * 2.6f - 9.1f,
+                                  24.0f + (float) ((row * 7 + column * 3) % 5) * 3.0f);
+            const CKDWORD base = scene.positions.Size();
+            for (int r = 0; r <= kRings; ++r) {
+                const float theta = (float) r / (float) kRings * 3.14159265f;
+                for (int s = 0; s <= kSegments; ++s) {
+                    const float phi = (float) s / (float) kSegments * 6.28318531f;
+                    const VxVector normal(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+                    scene.positions.PushBack(center + normal * 1.8f);
+                    const CKDWORD red = (CKDWORD) (127.0f + normal.x * 127.0f);
+                    const CKDWORD green = (CKDWORD) (127.0f + normal.y * 127.0f);
+                    const CKDWORD blue = (CKDWORD) ((column * 16 + row * 8) & 0xFF);
+                    scene.colors.PushBack(0xFF000000 | (red << 16) | (green << 8) | blue);
+                }
+            }
+            for (int r = 0; r < kRings; ++r) {
+                for (int s = 0; s < kSegments; ++s) {
+                    const CKDWORD a = base + r * (kSegments + 1) + s;
+                    const CKDWORD b = a + kSegments + 1;
+                    const CKDWORD quad[6] = {a, b, a + 1, a + 1, b, b + 1};
+                    for (int k = 0; k < 6; ++k)
+                        scene.indices.PushBack(quad[k]);
+                }
+            }
+        }
+    }
+}
+
+// Draws a 32-bit indexed triangle list: triangles are taken in order while
+// their vertices span at most 0x10000 vertices, then drawn with the indices
+// rebased on the first vertex of the span
+int DrawChunked(CKRasterizerContext *ctx, const BenchScene &scene, XArray<CKWORD> &chunkIndices) {
+    const int indexCount = scene.indices.Size();
+    int drawCount = 0;
+    int first = 0;
+    while (first < indexCount) {
+        CKDWORD minIndex = 0xFFFFFFFF;
+        CKDWORD maxIndex = 0;
+        int end = first;
+        while (end < indexCount) {
+            CKDWORD triMin = minIndex;
+            CKDWORD triMax = maxIndex;
+            for (int k = 0; k < 3; ++k) {
+                triMin = XMin(triMin, scene.indices[end + k]);
+                triMax = XMax(triMax, scene.indices[end + k]);
+            }
+            if (triMax - triMin >= 0x10000)
+                break;
+            minIndex = triMin;
+            maxIndex = triMax;
+            end += 3;
+        }
+
+        chunkIndices.Resize(end - first);
+        for (int i = first; i < end; ++i)
+            chunkIndices[i - first] = (CKWORD) (scene.indices[i] - minIndex);
+
+        VxDrawPrimitiveData data;
+        memset(&data, 0, sizeof(data));
+        data.VertexCount = maxIndex - minIndex + 1;
+        data.Flags = CKRST_DP_TRANSFORM | CKRST_DP_DIFFUSE;
+        data.PositionPtr = (void *) (scene.positions.Begin() + minIndex);
+        data.PositionStride = sizeof(VxVector);
+        data.ColorPtr = (void *) (scene.colors.Begin() + minIndex);
+        data.ColorStride = sizeof(CKDWORD);
+        ctx->DrawPrimitive(VX_TRIANGLELIST, chunkIndices.Begin(), chunkIndices.Size(), &data);
+
+        ++drawCount;
+        first = end;
+    }
+    return drawCount;
+}
+
+void SetupContext(CKSoftRasterizerContext *ctx) {
+    // Perspective projection, near 1 and far 100, 16:9
+    VxMatrix proj;
+    Vx3DMatrixIdentity(proj);
+    const float q = 100.0f / 99.0f;
+    proj[0][0] = 1.0f;
+    proj[1][1] = (float) kWidth / (float) kHeight;
+    proj[2][2] = q;
+    proj[2][3] = 1.0f;
+    proj[3][2] = -q;
+    proj[3][3] = 0.0f;
+
+    ctx->SetTransformMatrix(VXMATRIX_WORLD, VxMatrix::Identity());
+    ctx->SetTransformMatrix(VXMATRIX_VIEW, VxMatrix::Identity());
+    ctx->SetTransformMatrix(VXMATRIX_PROJECTION, proj);
+    ctx->SetRenderState(VXRENDERSTATE_CULLMODE, VXCULL_CCW);
+    ctx->SetRenderState(VXRENDERSTATE_LIGHTING, FALSE);
+    ctx->SetRenderState(VXRENDERSTATE_ZENABLE, TRUE);
+    ctx->SetRenderState(VXRENDERSTATE_ZWRITEENABLE, TRUE);
+    ctx->SetRenderState(VXRENDERSTATE_ZFUNC, VXCMP_LESSEQUAL);
+    ctx->SetRenderState(VXRENDERSTATE_ALPHABLENDENABLE, FALSE);
+    ctx->SetRenderState(VXRENDERSTATE_SHADEMODE, VXSHADE_GOURAUD);
+    ctx->SetTexture(0, 0);
+}
+
+} // namespace
+
+int main() {
+    BenchScene scene;
+    BuildScene(scene);
+    const int triangleCount = scene.indices.Size() / 3;
+
+    CKRasterizer *rst = CKSoftRasterizerStart(NULL);
+    CKSoftRasterizerContext *ctx = (CKSoftRasterizerContext *) rst->GetDriver(0)->CreateContext();
+    if (!ctx->Create(NULL, 0, 0, kWidth, kHeight)) {
+        printf("Software context creation failed\n");
+        return 1;
+    }
+    SetupContext(ctx);
+
+    const int workerCounts[] = {0, 1, 3, 7, CKSOFT_MAX_WORKERS};
+    const int frames = 20;
+    XArray<CKWORD> chunkIndices;
+    XArray<CKDWORD> reference;
+
+    printf("%d triangles, %d vertices, %dx%d, %u hardware threads\n", triangleCount, scene.positions.Size(), kWidth,
+           kHeight, std::thread::hardware_concurrency());
+    printf("%8s %6s %15s %12s %9s %6s\n", "threads", "draws", "frame (ms)", "Mtris/s", "speedup", "same");
+
+    double singleTime = 0.0;
+    for (int w = 0; w < (int) (sizeof(workerCounts) / sizeof(workerCounts[0])); ++w) {
+        ctx->SetWorkerCount(workerCounts[w]);
+
+        // One frame to warm up the bins and the framebuffer
+        ctx->Clear(CKRST_CTXCLEAR_ALL, 0xFF000000, 1.0f);
+        int drawCount = DrawChunked(ctx, scene, chunkIndices);
+        ctx->EndScene();
+
+        const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        for (int f = 0; f < frames; ++f) {
+            ctx->Clear(CKRST_CTXCLEAR_ALL, 0xFF000000, 1.0f);
+            drawCount = DrawChunked(ctx, scene, chunkIndices);
+            ctx->EndScene();
+        }
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+        const double frameTime = elapsed.count() / frames;
+
+        const int pixelCount = kWidth * kHeight;
+        const char *same = "-";
+        if (w == 0) {
+            singleTime = frameTime;
+            reference.Resize(pixelCount);
+            memcpy(reference.Begin(), ctx->GetColorBuffer(), pixelCount * sizeof(CKDWORD));
+        } else {
+            same = memcmp(reference.Begin(), ctx->GetColorBuffer(), pixelCount * sizeof(CKDWORD)) == 0 ? "yes" : "NO";
+        }
+        printf("%8d %6d %15.2f %12.2f %8.2fx %6s\n", ctx->GetWorkerCount() + 1, drawCount, frameTime,
+               (double) triangleCount / (frameTime * 1000.0), singleTime / frameTime, same);
+    }
+
+    rst->GetDriver(0)->DestroyContext(ctx);
+    CKSoftRasterizerClose(rst);
+    return 0;
+}
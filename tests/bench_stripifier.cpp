@@ -0,0 +1,492 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "MeshStriper.h"
+#include "NvStripifier.h"
+#include "RadixSort.h"
+
+// Strips a corpus of generated meshes of 100k+ triangles with MeshStriper
+// and NvStripifier, and reports the strip counts, the indices emitted and
+// the build times against reference copies of the previous implementations:
+// MeshStriper copying the used face flags for each candidate strip, and
+// NvStripifier allocating each face and edge and sharing faces on release.
+
+namespace {
+
+// ----------------------------------------------------------------------------
+// Previous MeshStriper: per seed, three candidate buffers of the mesh size
+// and a copy of the used flags for each candidate.
+// ----------------------------------------------------------------------------
+namespace reference {
+
+int TrackStrip(const XArray<MeshAdjacency::Face> &faces, CKDWORD faceIndex, CKDWORD v0, CKDWORD v1,
+               CKDWORD *outVertices, CKDWORD *outFaces, CKBYTE *used) {
+    outVertices[0] = v0;
+    outVertices[1] = v1;
+    int count = 2;
+    while (true) {
+        const MeshAdjacency::Face &face = faces[(int) faceIndex];
+        const CKDWORD opposite = face.OppositeVertex(v0, v1);
+        if ((int) opposite == -1)
+            break;
+        outVertices[count++] = opposite;
+        *outFaces++ = faceIndex;
+        used[(int) faceIndex] = 1;
+
+        const CKBYTE edge = face.FindEdge(v1, opposite);
+        if (edge == 0xff)
+            break;
+        const CKDWORD link = face.faces[edge];
+        v0 = v1;
+        v1 = opposite;
+        if ((int) link == -1 || used[(int) MAKE_ADJ_TRI(link)])
+            break;
+        faceIndex = MAKE_ADJ_TRI(link);
+    }
+    return count;
+}
+
+void ReverseRange(CKDWORD *data, int count) {
+    for (int i = 0, j = count - 1; i < j; ++i, --j)
+        XSwap(data[i], data[j]);
+}
+
+// 16-bit output with sorted seeds, without parity fix nor connection
+void MeshStrip(CKWORD *indices, int triCount, XArray<CKDWORD> &stripLengths, XArray<CKWORD> &output) {
+    stripLengths.Resize(0);
+    output.Resize(0);
+    MeshAdjacency adjacency;
+    adjacency.Init(indices, triCount);
+    if (!adjacency.Compute(false, true))
+        return;
+    const XArray<MeshAdjacency::Face> &faces = adjacency.GetFaces();
+
+    XArray<CKDWORD> degrees;
+    degrees.Resize(triCount);
+    for (int f = 0; f < triCount; ++f)
+        degrees[f] = ((int) faces[f].faces[0] != -1) + ((int) faces[f].faces[1] != -1) +
+                     ((int) faces[f].faces[2] != -1);
+    RadixSorter sorter;
+    const CKDWORD *order = sorter.Sort(degrees.Begin(), (CKDWORD) triCount, true).GetIndices();
+
+    XArray<CKBYTE> used;
+    used.Resize(triCount);
+    memset(used.Begin(), 0, triCount);
+    for (int idx = 0; idx < triCount; ++idx) {
+        const CKDWORD seedFace = order[idx];
+        if (used[(int) seedFace])
+            continue;
+
+        const MeshAdjacency::Face &seed = faces[(int) seedFace];
+        const CKDWORD starts0[3] = {seed.vertices[0], seed.vertices[2], seed.vertices[1]};
+        const CKDWORD starts1[3] = {seed.vertices[1], seed.vertices[0], seed.vertices[2]};
+        XArray<CKDWORD> verts[3];
+        XArray<CKDWORD> stripFaces[3];
+        CKDWORD lengths[3];
+        for (int i = 0; i < 3; ++i) {
+            verts[i].Resize(triCount + 5);
+            stripFaces[i].Resize(triCount + 2);
+            XArray<CKBYTE> usedWork;
+            usedWork.Resize(triCount);
+            memcpy(usedWork.Begin(), used.Begin(), triCount);
+
+            const int initial = TrackStrip(faces, seedFace, starts0[i], starts1[i], verts[i].Begin(),
+                                           stripFaces[i].Begin(), usedWork.Begin());
+            lengths[i] = (CKDWORD) initial;
+            if (initial < 3)
+                continue;
+            ReverseRange(verts[i].Begin(), initial);
+            ReverseRange(stripFaces[i].Begin(), initial - 2);
+            const int grow = initial - 3;
+            lengths[i] = (CKDWORD) (TrackStrip(faces, seedFace, verts[i][grow], verts[i][grow + 1], &verts[i][grow],
+                                               &stripFaces[i][grow], usedWork.Begin()) + grow);
+        }
+
+        int best = 0;
+        if (lengths[1] > lengths[0])
+            best = 1;
+        if (lengths[2] > lengths[best])
+            best = 2;
+        if (lengths[best] < 3)
+            continue;
+        for (CKDWORD t = 0; t < lengths[best] - 2; ++t)
+            used[(int) stripFaces[best][(int) t]] = 1;
+        for (CKDWORD i = 0; i < lengths[best]; ++i)
+            output.PushBack((CKWORD) verts[best][(int) i]);
+        stripLengths.PushBack(lengths[best]);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Previous NvStripifier: faces and edges allocated one by one, strips walked
+// through the edge buckets, one index array per strip, faces released
+// through a list of the faces already deleted.
+// ----------------------------------------------------------------------------
+NvEdgeInfo *FindEdgeInfo(XArray<NvEdgeInfo *> &buckets, int v0, int v1) {
+    if (v0 < 0 || v0 >= buckets.Size())
+        return nullptr;
+    NvEdgeInfo *edge = buckets[v0];
+    while (edge) {
+        if ((edge->Vertex0 == v0 && edge->Vertex1 == v1) || (edge->Vertex0 == v1 && edge->Vertex1 == v0))
+            return edge;
+        edge = (edge->Vertex0 == v0) ? edge->NextV0 : edge->NextV1;
+    }
+    return nullptr;
+}
+
+void WalkStrip(NvStripInfo *strip, XArray<NvEdgeInfo *> &buckets, NvFaceInfo *face, int a, int b,
+               XArray<NvFaceInfo *> &faces) {
+    while (true) {
+        NvEdgeInfo *edge = FindEdgeInfo(buckets, a, b);
+        if (!edge)
+            break;
+        NvFaceInfo *next = (edge->Face0 == face) ? edge->Face1 : edge->Face0;
+        if (!next || next->MarkA >= 0 || (strip->ExperimentId >= 0 && next->Experiment == strip->ExperimentId))
+            break;
+        int c = -1;
+        for (int i = 0; i < 3 && c < 0; ++i)
+            if (next->V[i] != a && next->V[i] != b)
+                c = next->V[i];
+        if (c < 0)
+            break;
+        faces.PushBack(next);
+        strip->MarkTriangle(next);
+        face = next;
+        a = b;
+        b = c;
+    }
+}
+
+void BuildStrip(NvStripInfo *strip, XArray<NvEdgeInfo *> &buckets) {
+    XArray<NvFaceInfo *> forward;
+    XArray<NvFaceInfo *> backward;
+    const int v0 = strip->StartCW ? strip->StartEdge->Vertex0 : strip->StartEdge->Vertex1;
+    const int v1 = strip->StartCW ? strip->StartEdge->Vertex1 : strip->StartEdge->Vertex0;
+    int v2 = strip->StartFace->V[2];
+    for (int i = 0; i < 2; ++i)
+        if (strip->StartFace->V[i] != v0 && strip->StartFace->V[i] != v1) {
+            v2 = strip->StartFace->V[i];
+            break;
+        }
+    forward.PushBack(strip->StartFace);
+    strip->MarkTriangle(strip->StartFace);
+    WalkStrip(strip, buckets, strip->StartFace, v1, v2, forward);
+    WalkStrip(strip, buckets, strip->StartFace, v0, v2, backward);
+    strip->Combine(forward, backward);
+}
+
+int FaceUniqueVertex(const NvFaceInfo *face, int a, int b) {
+    for (int i = 0; i < 3; ++i)
+        if (face->V[i] != a && face->V[i] != b)
+            return face->V[i];
+    return -1;
+}
+
+bool FaceHas(const NvFaceInfo *face, int v) { return face->V[0] == v || face->V[1] == v || face->V[2] == v; }
+
+bool StripSequence(const XArray<NvFaceInfo *> &faces, XArray<CKWORD> &seq) {
+    seq.Resize(0);
+    const NvFaceInfo *f0 = faces[0];
+    if (faces.Size() == 1) {
+        for (int i = 0; i < 3; ++i)
+            seq.PushBack((CKWORD) f0->V[i]);
+        return true;
+    }
+    const NvFaceInfo *f1 = faces[1];
+    int unique = -1;
+    for (int i = 0; i < 3 && unique < 0; ++i)
+        if (!FaceHas(f1, f0->V[i]))
+            unique = f0->V[i];
+    if (unique < 0) {
+        for (int i = 0; i < 3; ++i)
+            seq.PushBack((CKWORD) f0->V[i]);
+    } else {
+        seq.PushBack((CKWORD) unique);
+        for (int i = 0; i < 3; ++i)
+            if (f0->V[i] != unique && FaceHas(f1, f0->V[i]))
+                seq.PushBack((CKWORD) f0->V[i]);
+        if (seq.Size() != 3) {
+            seq.Resize(0);
+            for (int i = 0; i < 3; ++i)
+                seq.PushBack((CKWORD) f0->V[i]);
+        }
+    }
+    for (int i = 1; i < faces.Size(); ++i) {
+        const NvFaceInfo *cur = faces[i];
+        int a = seq[seq.Size() - 2];
+        int b = seq[seq.Size() - 1];
+        if (!FaceHas(cur, a) || !FaceHas(cur, b)) {
+            int shared[2] = {-1, -1};
+            int count = 0;
+            for (int k = 0; k < 3; ++k) {
+                if (!FaceHas(cur, faces[i - 1]->V[k]))
+                    continue;
+                if (count < 2)
+                    shared[count] = faces[i - 1]->V[k];
+                ++count;
+            }
+            if (count != 2)
+                return false;
+            seq.PushBack(seq[seq.Size() - 1]);
+            seq.PushBack((CKWORD) shared[0]);
+            seq.PushBack((CKWORD) shared[1]);
+            a = shared[0];
+            b = shared[1];
+            if (!FaceHas(cur, a) || !FaceHas(cur, b))
+                return false;
+        }
+        const int next = FaceUniqueVertex(cur, a, b);
+        if (next < 0)
+            return false;
+        seq.PushBack((CKWORD) next);
+    }
+    return true;
+}
+
+// Joined output, minimum strip length of 0 as CreateRenderGroups
+void NvStrip(const XArray<CKWORD> &indices, int vertexCount, XArray<CKWORD> &output) {
+    output.Resize(0);
+    const int triCount = indices.Size() / 3;
+    XArray<NvFaceInfo *> faces;
+    for (int i = 0; i < triCount; ++i) {
+        NvFaceInfo *face = new NvFaceInfo();
+        for (int k = 0; k < 3; ++k)
+            face->V[k] = indices[i * 3 + k];
+        faces.PushBack(face);
+    }
+
+    MeshAdjacency adjacency;
+    adjacency.Init((CKWORD *) indices.Begin(), triCount);
+    adjacency.Compute(true, true);
+    XArray<NvEdgeInfo *> buckets;
+    buckets.Resize(vertexCount + 1);
+    memset(buckets.Begin(), 0, buckets.Size() * sizeof(NvEdgeInfo *));
+    XArray<NvEdgeInfo *> edges;
+    for (int i = 0; i < adjacency.GetEdges().Size(); ++i) {
+        const MeshAdjacency::Edge &e = adjacency.GetEdges()[i];
+        NvEdgeInfo *edge = new NvEdgeInfo();
+        edges.PushBack(edge);
+        edge->Vertex0 = (int) e.vertices[0];
+        edge->Vertex1 = (int) e.vertices[1];
+        edge->Face0 = (e.faces[0] != 0xFFFFFFFF) ? faces[(int) e.faces[0]] : nullptr;
+        edge->Face1 = (e.faces[1] != 0xFFFFFFFF) ? faces[(int) e.faces[1]] : nullptr;
+        edge->NextV0 = buckets[edge->Vertex0];
+        buckets[edge->Vertex0] = edge;
+        edge->NextV1 = buckets[edge->Vertex1];
+        buckets[edge->Vertex1] = edge;
+    }
+
+    XArray<NvStripInfo *> strips;
+    XArray<NvFaceInfo *> resetPoints;
+    int stripId = 0;
+    for (int sample = 0; sample < 10; ++sample) {
+        NvFaceInfo *reset = nullptr;
+        for (int i = 0; i < triCount && !reset; ++i)
+            if (faces[i]->MarkA < 0)
+                reset = faces[i];
+        if (!reset)
+            break;
+        if (resetPoints.Find(reset) != resetPoints.End())
+            continue;
+        resetPoints.PushBack(reset);
+
+        NvStripInfo *best = nullptr;
+        for (int e = 0; e < 3; ++e) {
+            NvEdgeInfo *edge = FindEdgeInfo(buckets, reset->V[e], reset->V[(e + 1) % 3]);
+            for (int cw = 0; edge && cw < 2; ++cw) {
+                NvStripInfo *strip = new NvStripInfo();
+                strip->StartFace = reset;
+                strip->StartEdge = edge;
+                strip->StartCW = (unsigned char) cw;
+                strip->StripId = stripId;
+                strip->ExperimentId = stripId++;
+                BuildStrip(strip, buckets);
+                if (!best || strip->Faces.Size() > best->Faces.Size()) {
+                    delete best;
+                    best = strip;
+                } else {
+                    delete strip;
+                }
+            }
+        }
+        if (best) {
+            best->ExperimentId = -1;
+            for (int j = 0; j < best->Faces.Size(); ++j)
+                best->MarkTriangle(best->Faces[j]);
+            strips.PushBack(best);
+        }
+    }
+    for (int i = 0; i < triCount; ++i) {
+        if (faces[i]->MarkA < 0) {
+            NvStripInfo *strip = new NvStripInfo();
+            strip->StartFace = faces[i];
+            strip->StartEdge = FindEdgeInfo(buckets, faces[i]->V[0], faces[i]->V[1]);
+            strip->Faces.PushBack(faces[i]);
+            strip->MarkTriangle(faces[i]);
+            strips.PushBack(strip);
+        }
+    }
+    for (int i = 0; i < edges.Size(); ++i)
+        delete edges[i];
+
+    XArray<XArray<CKWORD> > sequences;
+    for (int s = 0; s < strips.Size(); ++s) {
+        XArray<CKWORD> seq;
+        if (StripSequence(strips[s]->Faces, seq))
+            sequences.PushBack(seq);
+    }
+    for (int i = 0; i < sequences.Size(); ++i) {
+        if (output.Size() > 0) {
+            const CKWORD last = output[output.Size() - 1];
+            if ((output.Size() % 2) != 0)
+                output.PushBack(last);
+            output.PushBack(last);
+            output.PushBack(sequences[i][0]);
+        }
+        for (int j = 0; j < sequences[i].Size(); ++j)
+            output.PushBack(sequences[i][j]);
+    }
+
+    XArray<NvFaceInfo *> deleted;
+    for (int s = 0; s < strips.Size(); ++s) {
+        for (int j = 0; j < strips[s]->Faces.Size(); ++j) {
+            NvFaceInfo *face = strips[s]->Faces[j];
+            if (deleted.Find(face) != deleted.End())
+                continue;
+            deleted.PushBack(face);
+            delete face;
+        }
+        delete strips[s];
+    }
+}
+
+} // namespace reference
+
+struct CorpusMesh {
+    const char *name;
+    int vertexCount;
+    XArray<CKWORD> indices;
+};
+
+void AddGrid(XArray<CKWORD> &indices, int columns, int rows, int first) {
+    for (int y = 0; y < rows - 1; ++y) {
+        for (int x = 0; x < columns - 1; ++x) {
+            const int a = first + y * columns + x;
+            const CKWORD face[6] = {(CKWORD) a, (CKWORD) (a + 1), (CKWORD) (a + columns),
+                                    (CKWORD) (a + columns), (CKWORD) (a + 1), (CKWORD) (a + columns + 1)};
+            for (int i = 0; i < 6; ++i)
+                indices.PushBack(face[i]);
+        }
+    }
+}
+
+void ShuffleFaces(XArray<CKWORD> &indices) {
+    const int faceCount = indices.Size() / 3;
+    for (int f = faceCount - 1; f > 0; --f) {
+        const int other = rand() % (f + 1);
+        for (int c = 0; c < 3; ++c)
+            XSwap(indices[f * 3 + c], indices[other * 3 + c]);
+    }
+}
+
+// Grid in scan line order, as modelers export terrains
+void BuildScanLineGrid(CorpusMesh &mesh) {
+    mesh.name = "grid 251x201";
+    mesh.vertexCount = 251 * 201;
+    AddGrid(mesh.indices, 251, 201, 0);
+}
+
+// Grid with its faces in random order, as after material sorting
+void BuildShuffledGrid(CorpusMesh &mesh) {
+    mesh.name = "shuffled grid 251x201";
+    mesh.vertexCount = 251 * 201;
+    AddGrid(mesh.indices, 251, 201, 0);
+    ShuffleFaces(mesh.indices);
+}
+
+// Several shuffled parts, as a merged level chunk
+void BuildMergedParts(CorpusMesh &mesh) {
+    mesh.name = "shuffled parts 36x(40x40)";
+    mesh.vertexCount = 36 * 40 * 40;
+    for (int p = 0; p < 36; ++p)
+        AddGrid(mesh.indices, 40, 40, p * 40 * 40);
+    ShuffleFaces(mesh.indices);
+}
+
+template <class Func>
+double TimeBuild(Func func, int iterations) {
+    func();
+
+    const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+void PrintRow(const char *mesh, const char *stripper, int faceCount, int strips, int indices, double oldTime,
+              double newTime, bool same) {
+    printf("%-26s %-13s %7d %7d %8d %10.2f %10.2f %8.2fx %5s\n", mesh, stripper, faceCount, strips, indices, oldTime,
+           newTime, newTime > 0.0 ? oldTime / newTime : 0.0, same ? "yes" : "NO");
+}
+
+} // namespace
+
+int main() {
+    void (*builders[])(CorpusMesh &) = {BuildScanLineGrid, BuildShuffledGrid, BuildMergedParts};
+    const int iterations = 1;
+
+    printf("%-26s %-13s %7s %7s %8s %10s %10s %9s %5s\n", "mesh", "stripper", "faces", "strips", "indices", "old ms",
+           "new ms", "speedup", "same");
+
+    srand(7);
+    for (int b = 0; b < (int) (sizeof(builders) / sizeof(builders[0])); ++b) {
+        CorpusMesh mesh;
+        builders[b](mesh);
+        const int faceCount = mesh.indices.Size() / 3;
+
+        // MeshStriper, 16-bit output with sorted seeds
+        XArray<CKDWORD> oldLengths;
+        XArray<CKWORD> oldStrips;
+        const double oldStriperTime = TimeBuild(
+            [&]() { reference::MeshStrip(mesh.indices.Begin(), faceCount, oldLengths, oldStrips); }, iterations);
+        MeshStriper striper;
+        MeshStriper::Result result = {};
+        const double newStriperTime = TimeBuild(
+            [&]() {
+                striper.Init(mesh.indices.Begin(), faceCount, CKMESHSTRIPER_INDEX16 | CKMESHSTRIPER_SORTSEEDS);
+                striper.Compute(&result);
+            },
+            iterations);
+        int striperIndices = 0;
+        for (CKDWORD s = 0; s < result.NbStrips; ++s)
+            striperIndices += (int) result.StripLengths[s];
+        const bool striperSame = (int) result.NbStrips == oldLengths.Size() && striperIndices == oldStrips.Size() &&
+                                 memcmp(result.StripIndices, oldStrips.Begin(), striperIndices * sizeof(CKWORD)) == 0;
+        PrintRow(mesh.name, "MeshStriper", faceCount, (int) result.NbStrips, striperIndices, oldStriperTime,
+                 newStriperTime, striperSame);
+
+        // NvStripifier, joined as in CreateRenderGroups
+        XArray<CKWORD> oldJoined;
+        const double oldNvTime =
+            TimeBuild([&]() { reference::NvStrip(mesh.indices, mesh.vertexCount, oldJoined); }, iterations);
+        NvStripifier stripifier;
+        XArray<CKWORD> joined;
+        CKDWORD joinedCount = 0;
+        const double newNvTime = TimeBuild(
+            [&]() {
+                stripifier.Stripify(mesh.indices, 0, 16, (CKWORD) mesh.vertexCount, true, joined, joinedCount);
+            },
+            iterations);
+        XArray<NvStripInfo *> strips;
+        stripifier.Stripify(mesh.indices, 0, 16, (CKWORD) mesh.vertexCount, strips);
+        const bool nvSame = joined.Size() == oldJoined.Size() &&
+                            memcmp(joined.Begin(), oldJoined.Begin(), joined.Size() * sizeof(CKWORD)) == 0;
+        PrintRow(mesh.name, "NvStripifier", faceCount, strips.Size(), joined.Size(), oldNvTime, newNvTime, nvSame);
+        NvStripifier::DestroyStrips(strips);
+    }
+    return 0;
+}
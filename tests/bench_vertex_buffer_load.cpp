@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "CKRasterizer.h"
+#include "CKRasterizerSIMD.h"
+
+// Times CKRSTLoadVertexBuffer on every vertex format CKRSTGetVertexFormat
+// returns, against the copy of one attribute at a time it used for them,
+// with the sources laid out like a mesh (VxVertex array, color arrays).
+
+namespace {
+
+struct MeshVertex {
+    VxVector Position;
+    VxVector Normal;
+    Vx2DVector UV;
+};
+
+struct BenchSources {
+    XArray<MeshVertex> vertices;
+    XArray<VxVector4> rasterPositions;
+    XArray<CKDWORD> colors;
+    XArray<Vx2DVector> texCoords;
+};
+
+struct Format {
+    const char *name;
+    CKDWORD dpFlags;
+};
+
+const Format kFormats[] = {
+    {"xyz|n", CKRST_DP_TRANSFORM | CKRST_DP_LIGHT},
+    {"xyz", CKRST_DP_TRANSFORM},
+    {"xyz|d", CKRST_DP_TRANSFORM | CKRST_DP_DIFFUSE},
+    {"xyz|s", CKRST_DP_TRANSFORM | CKRST_DP_SPECULAR},
+    {"xyz|ds", CKRST_DP_TRANSFORM | CKRST_DP_DIFFUSE | CKRST_DP_SPECULAR},
+    {"xyzw", 0},
+    {"xyzw|d", CKRST_DP_DIFFUSE},
+    {"xyzw|s", CKRST_DP_SPECULAR},
+    {"xyzw|ds", CKRST_DP_DIFFUSE | CKRST_DP_SPECULAR},
+};
+
+void BuildSources(BenchSources &sources, int count) {
+    sources.vertices.Resize(count);
+    sources.rasterPositions.Resize(count);
+    sources.colors.Resize(count);
+    sources.texCoords.Resize(count);
+    for (int i = 0; i < count; ++i) {
+        sources.vertices[i].Position.Set((float) (rand() % 100), (float) (rand() % 100), (float) (rand() % 100));
+        sources.vertices[i].Normal.Set(0.0f, 1.0f, 0.0f);
+        sources.vertices[i].UV = Vx2DVector((float) (i & 1), (float) (i & 2));
+        sources.rasterPositions[i] = VxVector4((float) (rand() % 640), (float) (rand() % 480), 0.5f, 1.0f);
+        sources.colors[i] = (CKDWORD) rand();
+        sources.texCoords[i] = Vx2DVector(0.5f, 0.5f);
+    }
+}
+
+void SetupData(VxDrawPrimitiveData &data, BenchSources &sources, CKDWORD vertexFormat, int count) {
+    memset(&data, 0, sizeof(data));
+    data.VertexCount = count;
+    if (vertexFormat & CKRST_VF_RASTERPOS) {
+        data.PositionPtr = sources.rasterPositions.Begin();
+        data.PositionStride = sizeof(VxVector4);
+    } else {
+        data.PositionPtr = &sources.vertices.Begin()->Position;
+        data.PositionStride = sizeof(MeshVertex);
+    }
+    data.NormalPtr = &sources.vertices.Begin()->Normal;
+    data.NormalStride = sizeof(MeshVertex);
+    data.ColorPtr = sources.colors.Begin();
+    data.ColorStride = sizeof(CKDWORD);
+    data.TexCoordPtr = &sources.vertices.Begin()->UV;
+    data.TexCoordStride = sizeof(MeshVertex);
+    for (int t = 0; t < CKRST_MAX_STAGES - 1; ++t) {
+        data.TexCoordPtrs[t] = sources.texCoords.Begin();
+        data.TexCoordStrides[t] = sizeof(Vx2DVector);
+    }
+}
+
+// The copy CKRSTLoadVertexBuffer did for these formats, one attribute at a time
+void LoadAttributes(CKBYTE *mem, CKDWORD vertexFormat, CKDWORD vertexSize, VxDrawPrimitiveData *data) {
+    const int count = data->VertexCount;
+    int offset = (vertexFormat & CKRST_VF_RASTERPOS) ? sizeof(VxVector4) : sizeof(VxVector);
+    VxCopyStructure(count, mem, vertexSize, offset, data->PositionPtr, data->PositionStride);
+    if (vertexFormat & CKRST_VF_NORMAL) {
+        VxCopyStructure(count, mem + offset, vertexSize, sizeof(VxVector), data->NormalPtr, data->NormalStride);
+        offset += sizeof(VxVector);
+    }
+    if (vertexFormat & CKRST_VF_DIFFUSE) {
+        VxCopyStructure(count, mem + offset, vertexSize, sizeof(CKDWORD), data->ColorPtr, data->ColorStride);
+        offset += sizeof(CKDWORD);
+    }
+    if (vertexFormat & CKRST_VF_SPECULAR) {
+        CKDWORD black = 0;
+        VxFillStructure(count, mem + offset, vertexSize, sizeof(CKDWORD), &black);
+        offset += sizeof(CKDWORD);
+    }
+    for (CKDWORD t = 0; t < CKRST_VF_GETTEXCOUNT(vertexFormat); ++t) {
+        void *uv = t ? data->TexCoordPtrs[t - 1] : data->TexCoordPtr;
+        const CKDWORD stride = t ? data->TexCoordStrides[t - 1] : data->TexCoordStride;
+        VxCopyStructure(count, mem + offset, vertexSize, 2 * sizeof(float), uv, stride);
+        offset += 2 * sizeof(float);
+    }
+}
+
+template <class Func>
+double TimeLoad(Func func, int iterations) {
+    func();
+
+    const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+} // namespace
+
+int main() {
+    const int vertexCounts[] = {1000, 10000, 100000};
+    const int stageCounts[] = {0, 1, 2, 4};
+    const CKRST_SIMD level = GetRasterizerSIMDLevel();
+
+    printf("SIMD level: %s\n", level == CKRST_SIMD_AVX ? "AVX" : level == CKRST_SIMD_SSE2 ? "SSE2" : "none");
+    printf("%8s %-8s %6s %5s %16s %16s %9s\n", "vertices", "format", "stages", "size", "attributes (ms)",
+           "vertices (ms)", "speedup");
+
+    for (int c = 0; c < (int) (sizeof(vertexCounts) / sizeof(vertexCounts[0])); ++c) {
+        srand(7);
+        const int count = vertexCounts[c];
+        BenchSources sources;
+        BuildSources(sources, count);
+        // Vertex buffers are 16 byte aligned, like the locked buffers of the drivers
+        XArray<CKBYTE> memory;
+        memory.Resize(count * 128 + 16);
+        CKBYTE *mem = memory.Begin() + ((16 - ((size_t) memory.Begin() & 15)) & 15);
+        const int iterations = count >= 100000 ? 20 : 200;
+
+        for (int f = 0; f < (int) (sizeof(kFormats) / sizeof(kFormats[0])); ++f) {
+            for (int s = 0; s < (int) (sizeof(stageCounts) / sizeof(stageCounts[0])); ++s) {
+                CKDWORD dpFlags = kFormats[f].dpFlags;
+                for (int t = 0; t < stageCounts[s]; ++t)
+                    dpFlags |= CKRST_DP_STAGE(t);
+                CKDWORD vertexSize;
+                const CKDWORD vertexFormat = CKRSTGetVertexFormat((CKRST_DPFLAGS) dpFlags, vertexSize);
+
+                VxDrawPrimitiveData data;
+                SetupData(data, sources, vertexFormat, count);
+                const double attributeTime = TimeLoad(
+                    [&]() { LoadAttributes(mem, vertexFormat, vertexSize, &data); }, iterations);
+                const double vertexTime = TimeLoad(
+                    [&]() { CKRSTLoadVertexBuffer(mem, vertexFormat, vertexSize, &data); }, iterations);
+                printf("%8d %-8s %6d %5u %16.4f %16.4f %8.2fx\n", count, kFormats[f].name, stageCounts[s],
+                       (unsigned) vertexSize, attributeTime, vertexTime,
+                       vertexTime > 0.0 ? attributeTime / vertexTime : 0.0);
+            }
+        }
+    }
+    return 0;
+}
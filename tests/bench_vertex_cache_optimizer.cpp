@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+#include "ForsythVertexCacheOptimizer.h"
+#include "VertexCacheOptimizer.h"
+
+// Reorders the triangle lists of a small corpus of generated meshes with
+// the greedy VertexCacheOptimizer and ForsythVertexCacheOptimizer, and
+// reports the ACMR of a FIFO cache of 16 vertices and the build times.
+
+namespace {
+
+const int kCacheSize = 16;
+
+struct CorpusMesh {
+    const char *name;
+    int vertexCount;
+    XArray<CKWORD> indices;
+};
+
+void AddGrid(XArray<CKWORD> &indices, int columns, int rows, int first) {
+    for (int y = 0; y < rows - 1; ++y) {
+        for (int x = 0; x < columns - 1; ++x) {
+            const int a = first + y * columns + x;
+            const CKWORD face[6] = {(CKWORD) a, (CKWORD) (a + columns), (CKWORD) (a + 1),
+                                    (CKWORD) (a + 1), (CKWORD) (a + columns), (CKWORD) (a + columns + 1)};
+            for (int i = 0; i < 6; ++i)
+                indices.PushBack(face[i]);
+        }
+    }
+}
+
+void ShuffleFaces(XArray<CKWORD> &indices) {
+    const int faceCount = indices.Size() / 3;
+    for (int f = faceCount - 1; f > 0; --f) {
+        const int other = rand() % (f + 1);
+        for (int c = 0; c < 3; ++c)
+            XSwap(indices[f * 3 + c], indices[other * 3 + c]);
+    }
+}
+
+// Grid in scan line order, as modelers export terrains
+void BuildScanLineGrid(CorpusMesh &mesh) {
+    mesh.name = "grid 128x128";
+    mesh.vertexCount = 128 * 128;
+    AddGrid(mesh.indices, 128, 128, 0);
+}
+
+// Grid with its faces in random order, as after material sorting
+void BuildShuffledGrid(CorpusMesh &mesh) {
+    mesh.name = "shuffled grid 180x180";
+    mesh.vertexCount = 180 * 180;
+    AddGrid(mesh.indices, 180, 180, 0);
+    ShuffleFaces(mesh.indices);
+}
+
+// Sphere of 64 rings of 128 vertices, with a fan at each pole
+void BuildSphere(CorpusMesh &mesh) {
+    const int rings = 64;
+    const int segments = 128;
+    mesh.name = "sphere 64x128";
+    mesh.vertexCount = rings * segments + 2;
+    AddGrid(mesh.indices, segments, rings, 0);
+    const int north = rings * segments;
+    const int south = north + 1;
+    for (int s = 0; s < segments - 1; ++s) {
+        const int last = (rings - 1) * segments;
+        const CKWORD fan[6] = {(CKWORD) north, (CKWORD) s, (CKWORD) (s + 1),
+                               (CKWORD) south, (CKWORD) (last + s + 1), (CKWORD) (last + s)};
+        for (int i = 0; i < 6; ++i)
+            mesh.indices.PushBack(fan[i]);
+    }
+}
+
+// Several shuffled parts, as a merged character or prop
+void BuildMergedParts(CorpusMesh &mesh) {
+    mesh.name = "shuffled parts 16x(40x40)";
+    mesh.vertexCount = 16 * 40 * 40;
+    for (int p = 0; p < 16; ++p)
+        AddGrid(mesh.indices, 40, 40, p * 40 * 40);
+    ShuffleFaces(mesh.indices);
+}
+
+// Random triangles over a few vertices: no order helps much
+void BuildSoup(CorpusMesh &mesh) {
+    mesh.name = "random soup";
+    mesh.vertexCount = 4096;
+    mesh.indices.Resize(3 * 20000);
+    for (int i = 0; i < mesh.indices.Size(); ++i)
+        mesh.indices[i] = (CKWORD) (rand() % mesh.vertexCount);
+}
+
+template <class Func>
+double TimeBuild(Func func, int iterations) {
+    func();
+
+    const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        func();
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+} // namespace
+
+int main() {
+    void (*builders[])(CorpusMesh &) = {BuildScanLineGrid, BuildShuffledGrid, BuildSphere, BuildMergedParts,
+                                        BuildSoup};
+    const int iterations = 5;
+
+    printf("FIFO cache: %d vertices\n", kCacheSize);
+    printf("%-26s %7s %7s %8s %10s %8s %10s %9s\n", "mesh", "faces", "input", "greedy", "greedy ms", "scored",
+           "scored ms", "speedup");
+
+    VertexCacheOptimizer greedy;
+    ForsythVertexCacheOptimizer scored;
+    srand(7);
+    for (int b = 0; b < (int) (sizeof(builders) / sizeof(builders[0])); ++b) {
+        CorpusMesh mesh;
+        builders[b](mesh);
+        const int faceCount = mesh.indices.Size() / 3;
+
+        XArray<CKWORD> greedyIndices;
+        const double greedyTime = TimeBuild(
+            [&]() {
+                greedy.Initialize(mesh.vertexCount, faceCount, kCacheSize);
+                greedy.BuildVertexFaceLists(mesh.indices);
+                greedy.ProcessFaces(mesh.indices);
+            },
+            iterations);
+        greedy.SwapOutput(greedyIndices);
+
+        XArray<CKWORD> scoredIndices;
+        scoredIndices.Resize(mesh.indices.Size());
+        const double scoredTime = TimeBuild(
+            [&]() {
+                scored.Optimize(mesh.indices.Begin(), faceCount, mesh.vertexCount, kCacheSize, scoredIndices.Begin());
+            },
+            iterations);
+
+        printf("%-26s %7d %7.3f %8.3f %10.3f %8.3f %10.3f %8.2fx\n", mesh.name, faceCount,
+               scored.ComputeACMR(mesh.indices.Begin(), faceCount, kCacheSize),
+               scored.ComputeACMR(greedyIndices.Begin(), faceCount, kCacheSize), greedyTime,
+               scored.ComputeACMR(scoredIndices.Begin(), faceCount, kCacheSize), scoredTime,
+               scoredTime > 0.0 ? greedyTime / scoredTime : 0.0);
+    }
+    return 0;
+}
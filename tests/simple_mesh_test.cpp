@@ -10,6 +10,55 @@ extern void SetProcessorSpecific_FunctionsPtr();
 
 namespace {
 
+// Exposes the render groups built by CreateRenderGroups
+class RenderGroupMesh : public RCKMesh {
+public:
+    RenderGroupMesh(CKContext *context, CKSTRING name) : RCKMesh(context, name) {}
+
+    CKMaterialGroup *GetGroupWithFaces() const {
+        for (int i = 0; i < m_MaterialGroups.Size(); ++i) {
+            if (m_MaterialGroups[i] && m_MaterialGroups[i]->m_FaceIndices.Size() > 0)
+                return m_MaterialGroups[i];
+        }
+        return nullptr;
+    }
+};
+
+const int kWideColumns = 256;
+const int kWideRows = 260; // 66560 vertices, more than 16-bit indices address
+
+// Grid of kWideColumns x rows vertices, two faces per cell, one material group
+void BuildGrid(RCKMesh &mesh, int rows) {
+    mesh.SetVertexCount(kWideColumns * rows);
+    for (int i = 0; i < kWideColumns * rows; ++i) {
+        VxVector position((float) (i % kWideColumns), 0.0f, (float) (i / kWideColumns));
+        mesh.SetVertexPosition(i, &position);
+    }
+    const int cells = (kWideColumns - 1) * (rows - 1);
+    mesh.SetFaceCount(2 * cells);
+    for (int c = 0; c < cells; ++c) {
+        const int a = c / (kWideColumns - 1) * kWideColumns + c % (kWideColumns - 1);
+        mesh.SetFaceVertexIndex(2 * c, a, a + kWideColumns, a + 1);
+        mesh.SetFaceVertexIndex(2 * c + 1, a + 1, a + kWideColumns, a + kWideColumns + 1);
+        mesh.SetFaceMaterial(2 * c, nullptr);
+        mesh.SetFaceMaterial(2 * c + 1, nullptr);
+    }
+}
+
+bool SameIndices(RCKMesh &lhs, RCKMesh &rhs) {
+    if (lhs.GetFaceCount() != rhs.GetFaceCount() || lhs.GetLineCount() != rhs.GetLineCount())
+        return false;
+    for (int i = 0; i < 3 * lhs.GetFaceCount(); ++i) {
+        if (lhs.GetFaceIndexValue(i) != rhs.GetFaceIndexValue(i))
+            return false;
+    }
+    for (int i = 0; i < 2 * lhs.GetLineCount(); ++i) {
+        if (lhs.GetLineIndexValue(i) != rhs.GetLineIndexValue(i))
+            return false;
+    }
+    return true;
+}
+
 void RunSerializationSmokeTest() {
     CKContext context(nullptr, 0, 0);
     RCKMesh source(&context, "SourceMesh");
@@ -67,6 +116,129 @@ void RunTopologyMutationSmokeTest() {
     mesh.UnOptimize();
 }
 
+void RunWideIndicesRoundTripTest() {
+    CKContext context(nullptr, 0, 0);
+    RCKMesh source(&context, "WideSource");
+    RCKMesh loaded(&context, "WideLoaded");
+
+    source.EnableWideIndices(TRUE);
+    BuildGrid(source, kWideRows);
+    source.SetLineCount(2);
+    source.SetLine(0, 0, kWideColumns * kWideRows - 1);
+    source.SetLine(1, 0x10000, 0x10001);
+    TestCheck(source.HasWideIndices() == TRUE, "More than 0x10000 vertices should use 32-bit indices");
+
+    CKStateChunk *chunk = source.Save(nullptr, CK_STATESAVE_MESHONLY);
+    TestCheck(chunk != nullptr, "Save returned a null chunk");
+    TestCheck(loaded.Load(chunk, nullptr) == CK_OK, "Load failed");
+    delete chunk;
+
+    TestCheck(loaded.IsWideIndicesEnabled() == TRUE && loaded.HasWideIndices() == TRUE,
+              "The loaded mesh should use 32-bit indices");
+    TestCheck(loaded.GetVertexCount() == kWideColumns * kWideRows, "Loaded vertex count mismatch");
+    TestCheck(SameIndices(source, loaded), "Loaded face and line indices should match the saved ones");
+}
+
+void RunWideIndicesOptInTest() {
+    CKContext context(nullptr, 0, 0);
+    RCKMesh source(&context, "OptInSource");
+    RCKMesh loaded(&context, "OptInLoaded");
+
+    // The opt-in is saved even though the mesh fits in 16-bit indices
+    source.EnableWideIndices(TRUE);
+    BuildGrid(source, 4);
+    TestCheck(source.HasWideIndices() == FALSE, "Few vertices should keep 16-bit indices");
+    CKStateChunk *chunk = source.Save(nullptr, CK_STATESAVE_MESHONLY);
+    TestCheck(loaded.Load(chunk, nullptr) == CK_OK, "Load failed");
+    delete chunk;
+    TestCheck(loaded.IsWideIndicesEnabled() == TRUE && loaded.HasWideIndices() == FALSE,
+              "The loaded mesh should keep the opt-in with 16-bit indices");
+    loaded.SetVertexCount(0x10001);
+    TestCheck(loaded.HasWideIndices() == TRUE, "The loaded mesh should switch to 32-bit indices when it grows");
+
+    // Loading a mesh saved without the opt-in clears it
+    RCKMesh narrow(&context, "NarrowSource");
+    BuildGrid(narrow, 4);
+    chunk = narrow.Save(nullptr, CK_STATESAVE_MESHONLY);
+    TestCheck(loaded.Load(chunk, nullptr) == CK_OK, "Load failed");
+    delete chunk;
+    TestCheck(loaded.IsWideIndicesEnabled() == FALSE && loaded.HasWideIndices() == FALSE,
+              "Loading a mesh without the opt-in should clear it");
+    TestCheck(SameIndices(narrow, loaded), "Loaded face and line indices should match the saved ones");
+}
+
+void RunIndexStorageSwitchTest() {
+    CKContext context(nullptr, 0, 0);
+    RCKMesh mesh(&context, "SwitchMesh");
+
+    // Without the opt-in, indices stay 16-bit whatever the vertex count
+    BuildGrid(mesh, kWideRows);
+    TestCheck(mesh.HasWideIndices() == FALSE && mesh.GetFacesIndices() != nullptr, "Wide indices are opt-in");
+
+    // Faces of the first rows only reference vertices below 0x10000
+    const int keptFaces = 2 * (kWideColumns - 1) * 200;
+    XArray<CKDWORD> expected;
+    mesh.EnableWideIndices(TRUE);
+    TestCheck(mesh.HasWideIndices() == TRUE, "Enabling should switch a large mesh to 32-bit indices");
+    TestCheck(mesh.GetFacesIndices() == nullptr && mesh.GetFacesIndices32() != nullptr,
+              "Only the 32-bit face indices should be available");
+    for (int i = 0; i < 3 * keptFaces; ++i)
+        expected.PushBack(mesh.GetFaceIndexValue(i));
+
+    mesh.SetVertexCount(0x10000);
+    TestCheck(mesh.HasWideIndices() == FALSE && mesh.GetFacesIndices() != nullptr &&
+                  mesh.GetFacesIndices32() == nullptr,
+              "0x10000 vertices should move back to 16-bit indices");
+    bool same = true;
+    for (int i = 0; i < 3 * keptFaces; ++i)
+        same &= mesh.GetFaceIndexValue(i) == expected[i];
+    TestCheck(same, "Narrowing should keep the face indices");
+
+    mesh.SetVertexCount(0x10001);
+    TestCheck(mesh.HasWideIndices() == TRUE, "0x10001 vertices should use 32-bit indices");
+    for (int i = 0; i < 3 * keptFaces; ++i)
+        same &= mesh.GetFaceIndexValue(i) == expected[i];
+    TestCheck(same, "Widening should keep the face indices");
+}
+
+void RunWideRenderGroupSplitTest() {
+    CKContext context(nullptr, 0, 0);
+    RenderGroupMesh mesh(&context, "SplitMesh");
+    mesh.EnableWideIndices(TRUE);
+    BuildGrid(mesh, kWideRows);
+    mesh.CreateRenderGroups();
+
+    CKMaterialGroup *group = mesh.GetGroupWithFaces();
+    CKVBuffer *vb = group ? mesh.GetVBuffer(group) : nullptr;
+    TestCheck(vb != nullptr, "Wide render groups should go through a remap buffer");
+    TestCheck(group->m_Primitives.Size() >= 2, "More than 0x10000 vertices should need several batches");
+
+    // Batches follow each other in the group vertices, and their faces in
+    // order are the mesh faces
+    CKDWORD vertexStart = 0;
+    int face = 0;
+    bool valid = true;
+    bool same = true;
+    for (int p = 0; p < group->m_Primitives.Size(); ++p) {
+        const CKPrimitiveEntry &prim = group->m_Primitives[p];
+        valid &= prim.m_VertexStart == vertexStart && prim.m_VertexCount > 0 && prim.m_VertexCount <= 0x10000;
+        valid &= prim.m_Indices.Size() % 3 == 0;
+        if (p + 1 < group->m_Primitives.Size())
+            valid &= prim.m_VertexCount > 0x10000 - 3;
+        for (int i = 0; i < prim.m_Indices.Size(); ++i) {
+            valid &= prim.m_Indices[i] < prim.m_VertexCount;
+            const int global = vb->m_VertexRemap[prim.m_VertexStart + prim.m_Indices[i]];
+            same &= face < mesh.GetFaceCount() && (CKDWORD) global == mesh.GetFaceIndexValue(3 * face + i % 3);
+            if (i % 3 == 2)
+                ++face;
+        }
+        vertexStart += prim.m_VertexCount;
+    }
+    TestCheck(valid, "Each batch should address at most 0x10000 vertices of its own");
+    TestCheck(vertexStart == group->m_VertexCount, "Batches should cover the group vertices");
+    TestCheck(face == mesh.GetFaceCount() && same, "Batches should draw the mesh faces");
+}
+
 } // namespace
 
 int main() {
@@ -75,5 +247,9 @@ int main() {
     TestFramework tests;
     tests.Run("Mesh serialization smoke", &RunSerializationSmokeTest);
     tests.Run("Mesh topology mutation smoke", &RunTopologyMutationSmokeTest);
+    tests.Run("Wide indices round trip", &RunWideIndicesRoundTripTest);
+    tests.Run("Wide indices opt-in is saved", &RunWideIndicesOptInTest);
+    tests.Run("Index storage follows the vertex count", &RunIndexStorageSwitchTest);
+    tests.Run("Wide render groups split at 0x10000 vertices", &RunWideRenderGroupSplitTest);
     return tests.ExitCode();
 }
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CKContext.h"
+#include "RCK3dEntity.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+// Tree of entities, parent index -1 for the roots: two roots, a deep chain
+// under the first one and a few branches.
+const int kEntityCount = 14;
+const int kParents[kEntityCount] = {-1, 0, 1, 2, 3, 4, 5, 2, 7, 0, 9, -1, 11, 12};
+
+CKDWORD NextRandom(CKDWORD &state) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+float RandomFloat(CKDWORD &state, float range) {
+    return ((float) (NextRandom(state) & 0xFFFF) / 65535.0f * 2.0f - 1.0f) * range;
+}
+
+void RandomMatrix(CKDWORD &state, VxMatrix &mat) {
+    VxVector axis(RandomFloat(state, 1.0f), RandomFloat(state, 1.0f), RandomFloat(state, 1.0f) + 1.5f);
+    axis.Normalize();
+    Vx3DMatrixFromRotation(mat, axis, RandomFloat(state, 3.0f));
+    mat[3][0] = RandomFloat(state, 10.0f);
+    mat[3][1] = RandomFloat(state, 10.0f);
+    mat[3][2] = RandomFloat(state, 10.0f);
+}
+
+bool SameMatrix(const VxMatrix &lhs, const VxMatrix &rhs) {
+    return memcmp(&lhs, &rhs, sizeof(VxMatrix)) == 0;
+}
+
+// Matrices the entities had when a move updated the whole subtree at once.
+// Inverses come from the entities: Translate updates a cached inverse
+// incrementally, which does not round like a full inversion.
+struct ReferenceHierarchy {
+    RCK3dEntity **Entities;
+    VxMatrix Local[kEntityCount];
+    VxMatrix World[kEntityCount];
+
+    void UpdateWorld(int entity) {
+        if (kParents[entity] >= 0)
+            Vx3DMultiplyMatrix(World[entity], World[kParents[entity]], Local[entity]);
+        else
+            World[entity] = Local[entity];
+    }
+
+    // Children are listed after their parent
+    void UpdateDescendants(int entity) {
+        for (int i = entity + 1; i < kEntityCount; ++i) {
+            for (int p = kParents[i]; p >= 0; p = kParents[p]) {
+                if (p == entity) {
+                    UpdateWorld(i);
+                    break;
+                }
+            }
+        }
+    }
+
+    void LocalFromWorld(int entity) {
+        if (kParents[entity] >= 0) {
+            const VxMatrix &inverse = Entities[kParents[entity]]->GetInverseWorldMatrix();
+            Vx3DMultiplyMatrix(Local[entity], inverse, World[entity]);
+        } else {
+            Local[entity] = World[entity];
+        }
+    }
+
+    void SetLocal(int entity, const VxMatrix &mat) {
+        Local[entity] = mat;
+        UpdateWorld(entity);
+        UpdateDescendants(entity);
+    }
+
+    void SetWorld(int entity, const VxMatrix &mat, CKBOOL keepChildren) {
+        World[entity] = mat;
+        LocalFromWorld(entity);
+        if (!keepChildren) {
+            UpdateDescendants(entity);
+            return;
+        }
+        const VxMatrix &inverse = Entities[entity]->GetInverseWorldMatrix();
+        for (int i = 0; i < kEntityCount; ++i) {
+            if (kParents[i] == entity)
+                Vx3DMultiplyMatrix(Local[i], inverse, World[i]);
+        }
+    }
+};
+
+void CheckEntity(RCK3dEntity *entity, const ReferenceHierarchy &reference, int index) {
+    TestCheck(SameMatrix(entity->GetWorldMatrix(), reference.World[index]),
+              "World matrix differs from the eager update");
+    TestCheck(SameMatrix(entity->GetLocalMatrix(), reference.Local[index]),
+              "Local matrix differs from the eager update");
+}
+
+void LazyWorldMatricesMatchEagerUpdates() {
+    CKContext context(nullptr, 0, 0);
+    RCK3dEntity *entities[kEntityCount];
+    ReferenceHierarchy reference;
+    CKDWORD state = 0x3D3D3Du;
+    reference.Entities = entities;
+
+    for (int i = 0; i < kEntityCount; ++i) {
+        entities[i] = new RCK3dEntity(&context, nullptr);
+        if (kParents[i] >= 0) {
+            entities[i]->m_Parent = entities[kParents[i]];
+            entities[kParents[i]]->m_Children.PushBack(entities[i]);
+        }
+        reference.Local[i] = VxMatrix::Identity();
+        reference.World[i] = VxMatrix::Identity();
+    }
+
+    for (int i = 0; i < kEntityCount; ++i) {
+        VxMatrix mat;
+        RandomMatrix(state, mat);
+        entities[i]->SetLocalMatrix(mat, FALSE);
+        reference.SetLocal(i, mat);
+    }
+    for (int i = 0; i < kEntityCount; ++i)
+        CheckEntity(entities[i], reference, i);
+
+    for (int step = 0; step < 400; ++step) {
+        const int target = (int) (NextRandom(state) % kEntityCount);
+        VxMatrix mat;
+        RandomMatrix(state, mat);
+        switch (NextRandom(state) % 4) {
+        case 0:
+            entities[target]->SetLocalMatrix(mat, FALSE);
+            reference.SetLocal(target, mat);
+            break;
+        case 1:
+            entities[target]->SetWorldMatrix(mat, FALSE);
+            reference.SetWorld(target, mat, FALSE);
+            break;
+        case 2:
+            entities[target]->SetWorldMatrix(mat, TRUE);
+            reference.SetWorld(target, mat, TRUE);
+            break;
+        default: {
+            const VxVector offset(RandomFloat(state, 2.0f), RandomFloat(state, 2.0f), RandomFloat(state, 2.0f));
+            entities[target]->Translate(&offset, nullptr, FALSE);
+            VxMatrix world = reference.World[target];
+            world[3][0] += offset.x;
+            world[3][1] += offset.y;
+            world[3][2] += offset.z;
+            reference.SetWorld(target, world, FALSE);
+            break;
+        }
+        }
+
+        // Read a few entities only, the others stay dirty over several moves
+        if ((step & 3) == 0) {
+            const int probe = (int) (NextRandom(state) % kEntityCount);
+            CheckEntity(entities[probe], reference, probe);
+        }
+    }
+
+    for (int i = kEntityCount - 1; i >= 0; --i)
+        CheckEntity(entities[i], reference, i);
+
+    for (int i = 0; i < kEntityCount; ++i)
+        delete entities[i];
+}
+
+void MovedParentOnlyMarksChildren() {
+    CKContext context(nullptr, 0, 0);
+    RCK3dEntity parent(&context, nullptr);
+    RCK3dEntity child(&context, nullptr);
+    child.m_Parent = &parent;
+    parent.m_Children.PushBack(&child);
+
+    VxMatrix mat;
+    CKDWORD state = 7u;
+    RandomMatrix(state, mat);
+    child.SetLocalMatrix(mat, FALSE);
+    TestCheck(!child.m_WorldMatrixDirty, "Setting a local matrix computes the world matrix");
+
+    RandomMatrix(state, mat);
+    parent.SetLocalMatrix(mat, FALSE);
+    TestCheck(child.m_WorldMatrixDirty == TRUE, "A moved parent should leave the child world matrix dirty");
+
+    VxMatrix expected;
+    Vx3DMultiplyMatrix(expected, parent.GetWorldMatrix(), child.GetLocalMatrix());
+    TestCheck(SameMatrix(child.GetWorldMatrix(), expected), "Resolved world matrix differs");
+    TestCheck(!child.m_WorldMatrixDirty, "Reading the world matrix resolves it");
+
+    child.ModifyMoveableFlags(VX_MOVEABLE_DONTUPDATEFROMPARENT, 0);
+    RandomMatrix(state, mat);
+    parent.SetLocalMatrix(mat, FALSE);
+    TestCheck(!child.m_WorldMatrixDirty, "A child not updated from its parent stays resolved");
+    TestCheck(SameMatrix(child.GetWorldMatrix(), expected), "A child not updated from its parent should not move");
+
+    parent.m_Children.Clear();
+    child.m_Parent = nullptr;
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("Lazy world matrices match eager updates", &LazyWorldMatricesMatchEagerUpdates);
+    tests.Run("Moved parent only marks children", &MovedParentOnlyMarksChildren);
+    return tests.ExitCode();
+}
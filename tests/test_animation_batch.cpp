@@ -0,0 +1,190 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "CKContext.h"
+#include "RCK3dEntity.h"
+#include "RCKKeyedAnimation.h"
+#include "RCKKeyframeData.h"
+#include "RCKObjectAnimation.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+// Two roots, a chain six levels deep under the first one and a few branches.
+// Entity 5 is not animated and entity 10 does not follow its parent.
+const int kEntityCount = 14;
+const int kParents[kEntityCount] = {-1, 0, 1, 2, 3, 4, 5, 2, 7, 0, 9, -1, 11, 12};
+const int kUnanimated = 5;
+const int kDetached = 10;
+const float kLength = 60.0f;
+
+float RandomFloat(float range) {
+    return ((float) rand() / (float) RAND_MAX * 2.0f - 1.0f) * range;
+}
+
+bool SameMatrix(const VxMatrix &lhs, const VxMatrix &rhs) {
+    return memcmp(&lhs, &rhs, sizeof(VxMatrix)) == 0;
+}
+
+// Position, rotation and scale keys, or some of them only: a bone without
+// every channel keeps the others from its current local matrix
+void AddKeys(RCKObjectAnimation *anim, int bone, unsigned int seed) {
+    srand(seed);
+    anim->SetLength(kLength);
+    const CKBOOL position = (bone % 4) != 1;
+    const CKBOOL rotation = (bone % 4) != 2;
+    const CKBOOL scale = (bone % 4) == 3;
+
+    CKAnimController *positions = position ? anim->CreateController(CKANIMATION_LINPOS_CONTROL) : nullptr;
+    CKAnimController *rotations = rotation ? anim->CreateController(CKANIMATION_TCBROT_CONTROL) : nullptr;
+    CKAnimController *scales = scale ? anim->CreateController(CKANIMATION_BEZIERSCL_CONTROL) : nullptr;
+    for (int k = 0; k < 7; ++k) {
+        const float time = (float) k * 10.0f;
+        if (positions) {
+            CKPositionKey key;
+            key.TimeStep = time;
+            key.Pos = VxVector(RandomFloat(5.0f), RandomFloat(5.0f), RandomFloat(5.0f));
+            positions->AddKey(&key);
+        }
+        if (rotations) {
+            CKTCBRotationKey key;
+            key.TimeStep = time;
+            key.Rot = VxQuaternion(RandomFloat(1.0f), RandomFloat(1.0f), RandomFloat(1.0f), 1.0f);
+            key.Rot.Normalize();
+            key.tension = RandomFloat(0.5f);
+            key.continuity = RandomFloat(0.5f);
+            key.bias = RandomFloat(0.5f);
+            key.easeto = 0.0f;
+            key.easefrom = 0.0f;
+            rotations->AddKey(&key);
+        }
+        if (scales) {
+            CKBezierPositionKey key;
+            key.TimeStep = time;
+            key.Pos = VxVector(1.0f + RandomFloat(0.5f), 1.0f + RandomFloat(0.5f), 1.0f + RandomFloat(0.5f));
+            key.In = VxVector(RandomFloat(0.2f), RandomFloat(0.2f), RandomFloat(0.2f));
+            key.Out = VxVector(RandomFloat(0.2f), RandomFloat(0.2f), RandomFloat(0.2f));
+            scales->AddKey(&key);
+        }
+    }
+}
+
+// A hierarchy driven by a keyed animation whose sub-animations are listed
+// children first, so that the batch has to sort them
+struct AnimatedHierarchy {
+    RCK3dEntity *Entities[kEntityCount];
+    RCKObjectAnimation *Anims[kEntityCount];
+    RCKKeyedAnimation *Keyed;
+
+    void Create(CKContext *context) {
+        Keyed = new RCKKeyedAnimation(context, nullptr);
+        Keyed->SetLength(kLength);
+        for (int i = 0; i < kEntityCount; ++i) {
+            Entities[i] = new RCK3dEntity(context, nullptr);
+            if (kParents[i] >= 0) {
+                Entities[i]->m_Parent = Entities[kParents[i]];
+                Entities[kParents[i]]->m_Children.PushBack(Entities[i]);
+            }
+            VxMatrix mat;
+            Vx3DMatrixFromRotation(mat, VxVector(0.0f, 1.0f, 0.0f), 0.1f * (float) i);
+            mat[3][0] = (float) i;
+            Entities[i]->SetLocalMatrix(mat, FALSE);
+        }
+        Entities[kDetached]->ModifyMoveableFlags(VX_MOVEABLE_DONTUPDATEFROMPARENT, 0);
+
+        for (int i = kEntityCount - 1; i >= 0; --i) {
+            Anims[i] = nullptr;
+            if (i == kUnanimated)
+                continue;
+            Anims[i] = new RCKObjectAnimation(context, nullptr);
+            AddKeys(Anims[i], i, 1000u + i);
+            Anims[i]->Set3dEntity((CK3dEntity *) Entities[i]);
+            Keyed->AddAnimation((CKObjectAnimation *) Anims[i]);
+        }
+    }
+
+    // The previous way: one SetStep per sub-animation, in the animation order
+    void SetStepPerBone(float step) {
+        for (int a = 0; a < Keyed->GetAnimationCount(); ++a)
+            ((RCKObjectAnimation *) Keyed->GetAnimation(a))->SetStep(step, (CKKeyedAnimation *) Keyed);
+    }
+
+    void SetParent(int entity, int parent) {
+        Entities[entity]->SetParent((CK3dEntity *) Entities[parent], FALSE);
+    }
+
+    void Destroy() {
+        delete Keyed;
+        for (int i = 0; i < kEntityCount; ++i) {
+            if (Anims[i]) {
+                Anims[i]->Set3dEntity(nullptr);
+                delete Anims[i];
+            }
+        }
+        for (int i = 0; i < kEntityCount; ++i) {
+            Entities[i]->m_Children.Clear();
+            Entities[i]->m_Parent = nullptr;
+        }
+        for (int i = 0; i < kEntityCount; ++i)
+            delete Entities[i];
+    }
+};
+
+void CheckSameHierarchy(const AnimatedHierarchy &expected, const AnimatedHierarchy &actual) {
+    for (int i = 0; i < kEntityCount; ++i) {
+        TestCheck(SameMatrix(expected.Entities[i]->GetLocalMatrix(), actual.Entities[i]->GetLocalMatrix()),
+                  "Local matrix differs from per bone SetStep");
+        TestCheck(SameMatrix(expected.Entities[i]->GetWorldMatrix(), actual.Entities[i]->GetWorldMatrix()),
+                  "World matrix differs from per bone SetStep");
+    }
+}
+
+void BatchMatchesPerBoneSetStep() {
+    CKContext context(nullptr, 0, 0);
+    AnimatedHierarchy reference;
+    AnimatedHierarchy batched;
+    reference.Create(&context);
+    batched.Create(&context);
+    CheckSameHierarchy(reference, batched);
+
+    const float steps[] = {0.0f, 0.13f, 0.5f, 0.77f, 1.0f, 0.21f, 0.21f, 0.9f};
+    for (int s = 0; s < (int) (sizeof(steps) / sizeof(steps[0])); ++s) {
+        // A hierarchy changed after the batch was built
+        if (s == 5) {
+            reference.SetParent(12, 3);
+            batched.SetParent(12, 3);
+        }
+
+        reference.SetStepPerBone(steps[s]);
+        batched.Keyed->SetStep(steps[s]);
+        TestCheck(batched.Keyed->GetStep() == steps[s], "SetStep should store the step");
+        for (int i = 0; i < kEntityCount; ++i) {
+            if (batched.Anims[i])
+                TestCheck(batched.Anims[i]->GetCurrentStep() == steps[s], "Sub-animation step not set");
+        }
+        CheckSameHierarchy(reference, batched);
+    }
+
+    // SetFrame goes through SetStep
+    reference.SetStepPerBone(33.0f / kLength);
+    batched.Keyed->SetFrame(33.0f);
+    CheckSameHierarchy(reference, batched);
+
+    // Sub-animations changed since the last step rebuild the batch
+    batched.Keyed->RemoveAnimation((CKObjectAnimation *) batched.Anims[3]);
+    reference.Keyed->RemoveAnimation((CKObjectAnimation *) reference.Anims[3]);
+    reference.SetStepPerBone(0.4f);
+    batched.Keyed->SetStep(0.4f);
+    CheckSameHierarchy(reference, batched);
+
+    reference.Destroy();
+    batched.Destroy();
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("Batched keyed animation matches per bone SetStep", &BatchMatchesPerBoneSetStep);
+    return tests.ExitCode();
+}
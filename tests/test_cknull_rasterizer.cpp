@@ -0,0 +1,133 @@
+#include "CKNullRasterizer.h"
+#include "TestTriangleMultiset.h"
+
+#include <string.h>
+
+namespace {
+
+struct NullRasterizerFixture
+{
+    CKRasterizer *rst;
+    CKNullRasterizerContext *ctx;
+
+    NullRasterizerFixture() : rst(NULL), ctx(NULL)
+    {
+        rst = CKNullRasterizerStart(NULL);
+        TestCheck(rst != NULL, "Null rasterizer failed to start");
+        TestCheck(rst->GetDriverCount() == 1, "Null rasterizer should expose one driver");
+        ctx = static_cast<CKNullRasterizerContext *>(rst->GetDriver(0)->CreateContext());
+        TestCheck(ctx->Create(NULL, 0, 0, 320, 240), "Null context creation failed");
+    }
+
+    ~NullRasterizerFixture()
+    {
+        if (ctx)
+            rst->GetDriver(0)->DestroyContext(ctx);
+        CKNullRasterizerClose(rst);
+    }
+};
+
+int CountCommands(const XArray<CKNullCommand> &commands, CKNULL_COMMANDTYPE type)
+{
+    int count = 0;
+    for (int i = 0; i < commands.Size(); ++i)
+        if (commands[i].Type == (CKDWORD) type)
+            ++count;
+    return count;
+}
+
+void RedundantRenderStatesAreFiltered()
+{
+    NullRasterizerFixture f;
+    CKNullRasterizerContext *ctx = f.ctx;
+
+    ctx->SetRenderState(VXRENDERSTATE_ZENABLE, TRUE);
+    ctx->SetRenderState(VXRENDERSTATE_ZENABLE, TRUE);
+    ctx->SetRenderState(VXRENDERSTATE_ZENABLE, FALSE);
+
+    const CKNullFrameStats &stats = ctx->GetFrameStats();
+    TestCheck(stats.RenderStateChanges == 2, "Only render state changes should reach the stream");
+    TestCheck(stats.RedundantRenderStates == 1, "Repeated render state should be counted as redundant");
+    TestCheck(CountCommands(ctx->GetCommands(), CKNULL_CMD_SETRENDERSTATE) == 2, "Render state commands mismatch");
+}
+
+void BufferLocksAndDrawsAreRecorded()
+{
+    NullRasterizerFixture f;
+    CKNullRasterizerContext *ctx = f.ctx;
+
+    const CKDWORD vbIndex = f.rst->CreateObjectIndex(CKRST_OBJ_VERTEXBUFFER);
+    const CKDWORD ibIndex = f.rst->CreateObjectIndex(CKRST_OBJ_INDEXBUFFER);
+    ctx->UpdateObjectArrays(f.rst);
+
+    CKVertexBufferDesc vbDesc;
+    vbDesc.m_VertexFormat = CKRST_VF_VERTEX;
+    vbDesc.m_VertexSize = 32;
+    vbDesc.m_MaxVertexCount = 64;
+    TestCheck(ctx->CreateObject(vbIndex, CKRST_OBJ_VERTEXBUFFER, &vbDesc), "Vertex buffer creation failed");
+
+    CKIndexBufferDesc ibDesc;
+    ibDesc.m_MaxIndexCount = 96;
+    TestCheck(ctx->CreateObject(ibIndex, CKRST_OBJ_INDEXBUFFER, &ibDesc), "Index buffer creation failed");
+
+    void *vertices = ctx->LockVertexBuffer(vbIndex, 0, 16);
+    TestCheck(vertices != NULL, "Vertex buffer lock failed");
+    memset(vertices, 0, 16 * 32);
+    TestCheck(ctx->UnlockVertexBuffer(vbIndex), "Vertex buffer unlock failed");
+
+    CKWORD *indices = (CKWORD *) ctx->LockIndexBuffer(ibIndex, 0, 24);
+    TestCheck(indices != NULL, "Index buffer lock failed");
+    for (int i = 0; i < 24; ++i)
+        indices[i] = (CKWORD) (i % 16);
+    TestCheck(ctx->UnlockIndexBuffer(ibIndex), "Index buffer unlock failed");
+
+    TestCheck(ctx->DrawPrimitiveVBIB(VX_TRIANGLELIST, vbIndex, ibIndex, 0, 16, 0, 24), "Indexed draw failed");
+    TestCheck(!ctx->DrawPrimitiveVBIB(VX_TRIANGLELIST, vbIndex, ibIndex, 0, 16, 90, 24),
+              "Indexed draw past the index buffer end should fail");
+
+    const CKNullFrameStats &stats = ctx->GetFrameStats();
+    TestCheck(stats.ObjectsCreated == 2, "Created objects were not counted");
+    TestCheck(stats.BufferLocks == 2, "Buffer locks were not counted");
+    TestCheck(stats.BytesUploaded == 16 * 32 + 24 * sizeof(CKWORD), "Uploaded bytes mismatch");
+    TestCheck(stats.DrawCalls == 1, "Only the valid draw call should be counted");
+    TestCheck(stats.PrimitiveCount == 8, "Triangle count mismatch");
+
+    const XArray<CKNullCommand> &commands = ctx->GetCommands();
+    TestCheck(CountCommands(commands, CKNULL_CMD_CREATEOBJECT) == 2, "CreateObject commands mismatch");
+    TestCheck(CountCommands(commands, CKNULL_CMD_LOCKVB) == 1, "LockVertexBuffer command missing");
+    TestCheck(CountCommands(commands, CKNULL_CMD_UNLOCKIB) == 1, "UnlockIndexBuffer command missing");
+    TestCheck(CountCommands(commands, CKNULL_CMD_DRAWPRIMITIVEVBIB) == 1, "DrawPrimitiveVBIB command missing");
+}
+
+void BackToFrontClosesTheFrame()
+{
+    NullRasterizerFixture f;
+    CKNullRasterizerContext *ctx = f.ctx;
+
+    ctx->SetTexture(0, 0);
+    ctx->SetRenderState(VXRENDERSTATE_ALPHABLENDENABLE, TRUE);
+    ctx->BackToFront(FALSE);
+
+    TestCheck(ctx->GetFrameCount() == 1, "BackToFront should count frames");
+    TestCheck(ctx->GetCommands().Size() == 0, "A new frame should start with an empty stream");
+    TestCheck(ctx->GetFrameStats().RenderStateChanges == 0, "A new frame should start with zeroed counters");
+    TestCheck(ctx->GetLastFrameStats().RenderStateChanges == 1, "Last frame counters were lost");
+    TestCheck(CountCommands(ctx->GetLastFrameCommands(), CKNULL_CMD_BACKTOFRONT) == 1,
+              "Last frame stream should end with BackToFront");
+
+    ctx->EnableRecording(FALSE);
+    ctx->SetRenderState(VXRENDERSTATE_ALPHABLENDENABLE, FALSE);
+    TestCheck(ctx->GetCommands().Size() == 0, "Disabled recording should not grow the stream");
+    TestCheck(ctx->GetFrameStats().RenderStateChanges == 1, "Counters should not depend on recording");
+}
+
+} // namespace
+
+int main()
+{
+    TestFramework tests;
+    tests.Run("Redundant render states are filtered", &RedundantRenderStatesAreFiltered);
+    tests.Run("Buffer locks and draws are recorded", &BufferLocksAndDrawsAreRecorded);
+    tests.Run("BackToFront closes the frame", &BackToFrontClosesTheFrame);
+    return tests.ExitCode();
+}
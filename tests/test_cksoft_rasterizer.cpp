@@ -0,0 +1,151 @@
+#include "CKSoftRasterizer.h"
+#include "TestTriangleMultiset.h"
+
+#include <string.h>
+
+namespace {
+
+struct SoftRasterizerFixture
+{
+    CKRasterizer *rst;
+    CKSoftRasterizerContext *ctx;
+
+    SoftRasterizerFixture(int width = 64, int height = 64) : rst(NULL), ctx(NULL)
+    {
+        rst = CKSoftRasterizerStart(NULL);
+        TestCheck(rst != NULL, "Software rasterizer failed to start");
+        TestCheck(rst->GetDriverCount() == 1, "Software rasterizer should expose one driver");
+        ctx = static_cast<CKSoftRasterizerContext *>(rst->GetDriver(0)->CreateContext());
+        TestCheck(ctx->Create(NULL, 0, 0, width, height), "Software context creation failed");
+
+        ctx->SetTransformMatrix(VXMATRIX_WORLD, VxMatrix::Identity());
+        ctx->SetTransformMatrix(VXMATRIX_VIEW, VxMatrix::Identity());
+        ctx->SetTransformMatrix(VXMATRIX_PROJECTION, VxMatrix::Identity());
+        ctx->SetRenderState(VXRENDERSTATE_CULLMODE, VXCULL_NONE);
+        ctx->SetRenderState(VXRENDERSTATE_LIGHTING, FALSE);
+        ctx->SetRenderState(VXRENDERSTATE_ZENABLE, TRUE);
+        ctx->SetRenderState(VXRENDERSTATE_ZWRITEENABLE, TRUE);
+        ctx->SetRenderState(VXRENDERSTATE_ZFUNC, VXCMP_LESSEQUAL);
+        ctx->SetRenderState(VXRENDERSTATE_ALPHABLENDENABLE, FALSE);
+        ctx->SetTexture(0, 0);
+    }
+
+    ~SoftRasterizerFixture()
+    {
+        if (ctx)
+            rst->GetDriver(0)->DestroyContext(ctx);
+        CKSoftRasterizerClose(rst);
+    }
+};
+
+// Draws an axis aligned quad in clip space ([-1, 1] on both axes) as a triangle list
+void DrawQuad(CKSoftRasterizerContext *ctx, float x0, float y0, float x1, float y1, float z, CKDWORD color)
+{
+    VxVector positions[4] = {
+        VxVector(x0, y0, z), VxVector(x1, y0, z), VxVector(x1, y1, z), VxVector(x0, y1, z)};
+    CKDWORD colors[4] = {color, color, color, color};
+    CKWORD indices[6] = {0, 1, 2, 0, 2, 3};
+
+    VxDrawPrimitiveData data;
+    memset(&data, 0, sizeof(data));
+    data.VertexCount = 4;
+    data.Flags = CKRST_DP_TRANSFORM | CKRST_DP_DIFFUSE;
+    data.PositionPtr = positions;
+    data.PositionStride = sizeof(VxVector);
+    data.ColorPtr = colors;
+    data.ColorStride = sizeof(CKDWORD);
+
+    TestCheck(ctx->DrawPrimitive(VX_TRIANGLELIST, indices, 6, &data), "DrawPrimitive failed");
+}
+
+CKDWORD ReadPixel(CKSoftRasterizerContext *ctx, int x, int y)
+{
+    CKDWORD pixel = 0;
+    CKRECT rect = {x, y, x + 1, y + 1};
+    VxImageDescEx desc;
+    desc.Image = (XBYTE *) &pixel;
+    TestCheck(ctx->CopyToMemoryBuffer(&rect, VXBUFFER_BACKBUFFER, desc) == 4, "CopyToMemoryBuffer failed");
+    return pixel;
+}
+
+void DepthTestKeepsTheNearestSurface()
+{
+    SoftRasterizerFixture f;
+    CKSoftRasterizerContext *ctx = f.ctx;
+
+    ctx->Clear(CKRST_CTXCLEAR_ALL, 0xFF000000, 1.0f);
+    DrawQuad(ctx, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0xFFFF0000);
+    DrawQuad(ctx, -1.0f, -1.0f, 1.0f, 1.0f, 0.8f, 0xFF00FF00);
+    ctx->EndScene();
+
+    TestCheck((ReadPixel(ctx, 32, 32) & 0x00FFFFFF) == 0x00FF0000, "Nearest quad should stay visible");
+    TestCheck((ReadPixel(ctx, 2, 2) & 0x00FFFFFF) == 0x0000FF00, "Farther quad should fill uncovered pixels");
+
+    // Disabling the depth test lets the far quad overwrite the near one
+    ctx->SetRenderState(VXRENDERSTATE_ZENABLE, FALSE);
+    DrawQuad(ctx, -1.0f, -1.0f, 1.0f, 1.0f, 0.8f, 0xFF0000FF);
+    ctx->EndScene();
+    TestCheck((ReadPixel(ctx, 32, 32) & 0x00FFFFFF) == 0x000000FF, "Depth test should be disabled");
+}
+
+void AlphaBlendingMixesWithTheFramebuffer()
+{
+    SoftRasterizerFixture f;
+    CKSoftRasterizerContext *ctx = f.ctx;
+
+    ctx->Clear(CKRST_CTXCLEAR_ALL, 0xFF000000, 1.0f);
+    ctx->SetRenderState(VXRENDERSTATE_ALPHABLENDENABLE, TRUE);
+    ctx->SetRenderState(VXRENDERSTATE_SRCBLEND, VXBLEND_SRCALPHA);
+    ctx->SetRenderState(VXRENDERSTATE_DESTBLEND, VXBLEND_INVSRCALPHA);
+    DrawQuad(ctx, -1.0f, -1.0f, 1.0f, 1.0f, 0.5f, 0x80FFFFFF);
+    ctx->EndScene();
+
+    const CKDWORD pixel = ReadPixel(ctx, 16, 48);
+    const CKDWORD red = (pixel >> 16) & 0xFF;
+    const CKDWORD blue = pixel & 0xFF;
+    TestCheck(red >= 0x7E && red <= 0x81, "Half transparent white over black should be mid gray");
+    TestCheck(red == blue, "Blending should treat all channels alike");
+}
+
+void ThreadedOutputMatchesSingleThreaded()
+{
+    SoftRasterizerFixture single(200, 150);
+    SoftRasterizerFixture threaded(200, 150);
+    single.ctx->SetWorkerCount(0);
+    threaded.ctx->SetWorkerCount(3);
+
+    SoftRasterizerFixture *fixtures[2] = {&single, &threaded};
+    for (int i = 0; i < 2; ++i)
+    {
+        CKSoftRasterizerContext *ctx = fixtures[i]->ctx;
+        ctx->Clear(CKRST_CTXCLEAR_ALL, 0xFF202020, 1.0f);
+        ctx->SetRenderState(VXRENDERSTATE_ALPHABLENDENABLE, TRUE);
+        ctx->SetRenderState(VXRENDERSTATE_SRCBLEND, VXBLEND_SRCALPHA);
+        ctx->SetRenderState(VXRENDERSTATE_DESTBLEND, VXBLEND_INVSRCALPHA);
+        // Overlapping quads crossing tile borders, drawn without depth test so
+        // the result depends on the submission order being kept per pixel
+        ctx->SetRenderState(VXRENDERSTATE_ZENABLE, FALSE);
+        for (int q = 0; q < 40; ++q)
+        {
+            const float x = -1.0f + (float) (q % 8) * 0.22f;
+            const float y = -1.0f + (float) (q / 8) * 0.35f;
+            const CKDWORD color = 0x90000000 | ((q * 0x3F1D27) & 0x00FFFFFF);
+            DrawQuad(ctx, x, y, x + 0.6f, y + 0.7f, 0.5f, color);
+        }
+        ctx->EndScene();
+    }
+
+    TestCheck(memcmp(single.ctx->GetColorBuffer(), threaded.ctx->GetColorBuffer(), 200 * 150 * sizeof(CKDWORD)) == 0,
+              "Threaded rasterization should produce the same image");
+}
+
+} // namespace
+
+int main()
+{
+    TestFramework tests;
+    tests.Run("Depth test keeps the nearest surface", &DepthTestKeepsTheNearestSurface);
+    tests.Run("Alpha blending mixes with the framebuffer", &AlphaBlendingMixesWithTheFramebuffer);
+    tests.Run("Threaded output matches single threaded", &ThreadedOutputMatchesSingleThreaded);
+    return tests.ExitCode();
+}
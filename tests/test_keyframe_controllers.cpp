@@ -0,0 +1,606 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CKContext.h"
+#include "RCK3dEntity.h"
+#include "RCKKeyframeData.h"
+#include "RCKMesh.h"
+#include "RCKObjectAnimation.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+const int kKeyCount = 30;
+const int kClipKeyCount = 300;
+
+float RandomFloat(float range) {
+    return ((float) rand() / (float) RAND_MAX * 2.0f - 1.0f) * range;
+}
+
+struct ControllerCase {
+    const char *name;
+    CKANIMATION_CONTROLLER type;
+    int resultSize;
+};
+
+const ControllerCase kCases[] = {
+    {"linear position", CKANIMATION_LINPOS_CONTROL, sizeof(VxVector)},
+    {"linear rotation", CKANIMATION_LINROT_CONTROL, sizeof(VxQuaternion)},
+    {"TCB position", CKANIMATION_TCBPOS_CONTROL, sizeof(VxVector)},
+    {"TCB rotation", CKANIMATION_TCBROT_CONTROL, sizeof(VxQuaternion)},
+    {"TCB scale", CKANIMATION_TCBSCL_CONTROL, sizeof(VxVector)},
+    {"Bezier position", CKANIMATION_BEZIERPOS_CONTROL, sizeof(VxVector)},
+    {"Bezier scale", CKANIMATION_BEZIERSCL_CONTROL, sizeof(VxVector)},
+};
+
+// Keys at irregular times in [0, ~60] with random values, or with smooth
+// motion sampled every frame as in captured clips
+CKAnimController *BuildController(CKKeyframeData &data, CKANIMATION_CONTROLLER type, int keyCount = kKeyCount,
+                                  bool smooth = false) {
+    CKAnimController *controller = data.CreateController(type);
+    float time = 0.0f;
+    for (int i = 0; i < keyCount; ++i) {
+        VxVector pos(RandomFloat(10.0f), RandomFloat(10.0f), RandomFloat(10.0f));
+        VxQuaternion rot(RandomFloat(1.0f), RandomFloat(1.0f), RandomFloat(1.0f), 1.0f);
+        if (smooth) {
+            time = (float) i;
+            pos = VxVector(10.0f * sinf(0.05f * time), 5.0f * cosf(0.03f * time), 2.0f * sinf(0.11f * time + 1.0f));
+            const float angle = 0.75f * sinf(0.04f * time);
+            rot = VxQuaternion(sinf(angle) * 0.6f, sinf(angle) * 0.8f * cosf(0.02f * time),
+                               sinf(angle) * 0.8f * sinf(0.02f * time), cosf(angle));
+        }
+        rot.Normalize();
+
+        switch (type) {
+        case CKANIMATION_LINPOS_CONTROL: {
+            CKPositionKey key;
+            key.TimeStep = time;
+            key.Pos = pos;
+            controller->AddKey(&key);
+            break;
+        }
+        case CKANIMATION_LINROT_CONTROL: {
+            CKRotationKey key;
+            key.TimeStep = time;
+            key.Rot = rot;
+            controller->AddKey(&key);
+            break;
+        }
+        case CKANIMATION_TCBPOS_CONTROL:
+        case CKANIMATION_TCBSCL_CONTROL: {
+            CKTCBPositionKey key;
+            key.TimeStep = time;
+            key.Pos = pos;
+            key.tension = RandomFloat(0.5f);
+            key.continuity = RandomFloat(0.5f);
+            key.bias = RandomFloat(0.5f);
+            key.easeto = 0.2f * (float) rand() / (float) RAND_MAX;
+            key.easefrom = 0.2f * (float) rand() / (float) RAND_MAX;
+            controller->AddKey(&key);
+            break;
+        }
+        case CKANIMATION_TCBROT_CONTROL: {
+            CKTCBRotationKey key;
+            key.TimeStep = time;
+            key.Rot = rot;
+            key.tension = RandomFloat(0.5f);
+            key.continuity = RandomFloat(0.5f);
+            key.bias = RandomFloat(0.5f);
+            key.easeto = 0.0f;
+            key.easefrom = 0.0f;
+            controller->AddKey(&key);
+            break;
+        }
+        default: {
+            CKBezierPositionKey key;
+            key.TimeStep = time;
+            key.Pos = pos;
+            key.In = smooth ? VxVector(0.0f, 0.0f, 0.0f) : VxVector(RandomFloat(1.0f), RandomFloat(1.0f), RandomFloat(1.0f));
+            key.Out = smooth ? VxVector(0.0f, 0.0f, 0.0f) : VxVector(RandomFloat(1.0f), RandomFloat(1.0f), RandomFloat(1.0f));
+            controller->AddKey(&key);
+            break;
+        }
+        }
+        if (smooth) {
+            CKKey *key = controller->GetKey(i);
+            if (type == CKANIMATION_TCBPOS_CONTROL || type == CKANIMATION_TCBSCL_CONTROL) {
+                CKTCBPositionKey *tcbKey = static_cast<CKTCBPositionKey *>(key);
+                tcbKey->tension = tcbKey->continuity = tcbKey->bias = 0.0f;
+                tcbKey->easeto = tcbKey->easefrom = 0.0f;
+            } else if (type == CKANIMATION_TCBROT_CONTROL) {
+                CKTCBRotationKey *tcbKey = static_cast<CKTCBRotationKey *>(key);
+                tcbKey->tension = tcbKey->continuity = tcbKey->bias = 0.0f;
+            }
+        }
+        time += 0.5f + 3.0f * (float) rand() / (float) RAND_MAX;
+    }
+    return controller;
+}
+
+// Result of a controller that never evaluated before, so without a cached interval
+void EvaluateFresh(CKKeyframeData &data, CKAnimController *source, float time, void *result) {
+    CKAnimController *fresh = data.CreateController(source->GetType());
+    fresh->Clone(source);
+    fresh->Evaluate(time, result);
+    delete fresh;
+}
+
+void CheckSameAsFresh(CKKeyframeData &data, CKAnimController *controller, int resultSize, float time) {
+    float cached[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float expected[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    TestCheck(controller->Evaluate(time, cached) != FALSE, "Evaluate should succeed");
+    EvaluateFresh(data, controller, time, expected);
+    TestCheck(memcmp(cached, expected, resultSize) == 0, "Cached interval should not change the result");
+}
+
+void PlaybackOrderDoesNotChangeResults() {
+    srand(12);
+    for (int c = 0; c < (int) (sizeof(kCases) / sizeof(kCases[0])); ++c) {
+        CKKeyframeData data;
+        CKAnimController *controller = BuildController(data, kCases[c].type);
+        const float end = controller->GetKey(kKeyCount - 1)->TimeStep;
+
+        // Forward, with small and large steps
+        for (float time = -1.0f; time < end + 1.0f; time += 0.07f)
+            CheckSameAsFresh(data, controller, kCases[c].resultSize, time);
+        for (float time = 0.0f; time < end; time += 4.3f)
+            CheckSameAsFresh(data, controller, kCases[c].resultSize, time);
+        // Backward
+        for (float time = end + 1.0f; time > -1.0f; time -= 0.11f)
+            CheckSameAsFresh(data, controller, kCases[c].resultSize, time);
+        // Looping
+        for (int i = 0; i < 500; ++i)
+            CheckSameAsFresh(data, controller, kCases[c].resultSize, fmodf(i * 0.9f, end));
+        // Random access, and exactly on the keys
+        for (int i = 0; i < 300; ++i)
+            CheckSameAsFresh(data, controller, kCases[c].resultSize, RandomFloat(end));
+        for (int i = 0; i < kKeyCount; ++i)
+            CheckSameAsFresh(data, controller, kCases[c].resultSize, controller->GetKey(i)->TimeStep);
+
+        delete controller;
+    }
+}
+
+void KeyEditsInvalidateCachedInterval() {
+    srand(31);
+    const CKANIMATION_CONTROLLER types[] = {CKANIMATION_TCBPOS_CONTROL, CKANIMATION_BEZIERPOS_CONTROL};
+    for (int c = 0; c < 2; ++c) {
+        CKKeyframeData data;
+        CKAnimController *controller = BuildController(data, types[c]);
+        const float time = 0.5f * (controller->GetKey(10)->TimeStep + controller->GetKey(11)->TimeStep);
+
+        VxVector before;
+        controller->Evaluate(time, &before);
+
+        // Edited through the key pointer
+        CKPositionKey *key = static_cast<CKPositionKey *>(controller->GetKey(11));
+        key->Pos.x += 5.0f;
+        VxVector after;
+        controller->Evaluate(time, &after);
+        TestCheck(after.x != before.x, "Editing a key should change the cached interval");
+
+        // A key inserted in the interval
+        controller->Evaluate(time, &before);
+        CKBezierPositionKey inserted;
+        inserted.TimeStep = time - 0.1f;
+        inserted.Pos = VxVector(100.0f, 100.0f, 100.0f);
+        inserted.In = VxVector(0.0f, 0.0f, 0.0f);
+        inserted.Out = VxVector(0.0f, 0.0f, 0.0f);
+        if (types[c] == CKANIMATION_TCBPOS_CONTROL) {
+            CKTCBPositionKey tcbKey;
+            tcbKey.TimeStep = inserted.TimeStep;
+            tcbKey.Pos = inserted.Pos;
+            tcbKey.tension = tcbKey.continuity = tcbKey.bias = 0.0f;
+            tcbKey.easeto = tcbKey.easefrom = 0.0f;
+            controller->AddKey(&tcbKey);
+        } else {
+            controller->AddKey(&inserted);
+        }
+        CheckSameAsFresh(data, controller, sizeof(VxVector), time);
+
+        // And removed again
+        controller->RemoveKey(11);
+        CheckSameAsFresh(data, controller, sizeof(VxVector), time);
+
+        delete controller;
+    }
+}
+
+struct CompressionCase {
+    const char *name;
+    CKANIMATION_CONTROLLER source;
+    CKANIMATION_CONTROLLER compressed;
+    float maxError;
+};
+
+const CompressionCase kCompressionCases[] = {
+    {"linear position", CKANIMATION_LINPOS_CONTROL, CKANIMATION_COMPRESSEDPOS_CONTROL, 0.01f},
+    {"TCB position", CKANIMATION_TCBPOS_CONTROL, CKANIMATION_COMPRESSEDPOS_CONTROL, 0.01f},
+    {"Bezier position", CKANIMATION_BEZIERPOS_CONTROL, CKANIMATION_COMPRESSEDPOS_CONTROL, 0.05f},
+    {"TCB scale", CKANIMATION_TCBSCL_CONTROL, CKANIMATION_COMPRESSEDSCL_CONTROL, 0.01f},
+    {"linear rotation", CKANIMATION_LINROT_CONTROL, CKANIMATION_COMPRESSEDROT_CONTROL, 0.002f},
+    {"TCB rotation", CKANIMATION_TCBROT_CONTROL, CKANIMATION_COMPRESSEDROT_CONTROL, 0.002f},
+};
+
+CKBOOL IsRotation(CKANIMATION_CONTROLLER type) {
+    return (type & CKANIMATION_CONTROLLER_MASK) == CKANIMATION_CONTROLLER_ROT;
+}
+
+// Distance for vectors, angle for unit quaternions
+float ResultError(CKANIMATION_CONTROLLER type, const float *a, const float *b) {
+    if (IsRotation(type)) {
+        // 4 asin(|a - b| / 2), precise for small angles
+        const float sign = (a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3]) < 0.0f ? -1.0f : 1.0f;
+        float chord = 0.0f;
+        for (int i = 0; i < 4; ++i)
+            chord += (a[i] - sign * b[i]) * (a[i] - sign * b[i]);
+        const float halfChord = 0.5f * sqrtf(chord);
+        return 4.0f * asinf(halfChord > 1.0f ? 1.0f : halfChord);
+    }
+    return sqrtf((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+}
+
+CKBOOL Compress(CKAnimController *compressed, CKAnimController *source, float maxError) {
+    if (IsRotation(compressed->GetType()))
+        return static_cast<RCKCompressedQuaternionController *>(compressed)->Compress(source, maxError);
+    return static_cast<RCKCompressedVectorController *>(compressed)->Compress(source, maxError);
+}
+
+void CompressedTracksStayWithinErrorBound() {
+    srand(57);
+    int sourceBytes = 0;
+    int compressedBytes = 0;
+    for (int c = 0; c < (int) (sizeof(kCompressionCases) / sizeof(kCompressionCases[0])); ++c) {
+        const CompressionCase &test = kCompressionCases[c];
+        CKKeyframeData data;
+        CKAnimController *source = BuildController(data, test.source, kClipKeyCount, true);
+        CKAnimController *compressed = data.CreateController(test.compressed);
+        TestCheck(Compress(compressed, source, test.maxError) != FALSE, "Compress should accept the source");
+
+        // At the source keys the reduction guarantees the bound, plus the
+        // quantization of the kept keys
+        const float tolerance = test.maxError + (IsRotation(test.source) ? 2.0e-4f : 1.0e-3f);
+        float keyError = 0.0f;
+        for (int i = 0; i < kClipKeyCount; ++i) {
+            const float time = source->GetKey(i)->TimeStep;
+            float expected[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            float result[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            source->Evaluate(time, expected);
+            TestCheck(compressed->Evaluate(time, result) != FALSE, "Evaluate should succeed");
+            const float error = ResultError(test.source, expected, result);
+            keyError = error > keyError ? error : keyError;
+        }
+        TestCheck(keyError <= tolerance, "Compressed track exceeds its error bound at a source key");
+
+        // Between the samples of Compress the error is not bounded, but stays
+        // close on smooth motion
+        const float end = source->GetKey(kClipKeyCount - 1)->TimeStep;
+        float playbackError = 0.0f;
+        for (float time = 0.0f; time < end; time += 0.03f) {
+            float expected[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            float result[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            source->Evaluate(time, expected);
+            compressed->Evaluate(time, result);
+            const float error = ResultError(test.source, expected, result);
+            playbackError = error > playbackError ? error : playbackError;
+        }
+        TestCheck(playbackError <= 2.0f * tolerance, "Compressed track is far from its source in playback");
+
+        const int sourceSize = source->DumpKeysTo(nullptr);
+        const int compressedSize = compressed->DumpKeysTo(nullptr);
+        printf("  %-16s %4d -> %4d keys, %5d -> %5d bytes, max error %.5f at keys, %.5f in playback\n", test.name,
+               kClipKeyCount, compressed->GetKeyCount(), sourceSize, compressedSize, keyError, playbackError);
+        sourceBytes += sourceSize;
+        compressedBytes += compressedSize;
+
+        delete source;
+        delete compressed;
+    }
+    printf("  total %d -> %d bytes (%.1f%%)\n", sourceBytes, compressedBytes, 100.0f * compressedBytes / sourceBytes);
+    TestCheck(compressedBytes < sourceBytes, "Compressed tracks should be smaller than their sources");
+}
+
+void CompressedTracksRoundTrip() {
+    srand(77);
+    const CKANIMATION_CONTROLLER types[] = {CKANIMATION_COMPRESSEDPOS_CONTROL, CKANIMATION_COMPRESSEDROT_CONTROL};
+    const CKANIMATION_CONTROLLER sources[] = {CKANIMATION_TCBPOS_CONTROL, CKANIMATION_TCBROT_CONTROL};
+    for (int c = 0; c < 2; ++c) {
+        CKKeyframeData data;
+        CKAnimController *source = BuildController(data, sources[c]);
+        CKAnimController *compressed = data.CreateController(types[c]);
+        Compress(compressed, source, 0.001f);
+
+        const int size = compressed->DumpKeysTo(nullptr);
+        TestCheck(size % 4 == 0, "Dumped keys should fill whole dwords");
+        XArray<CKBYTE> buffer;
+        buffer.Resize(size);
+        compressed->DumpKeysTo(buffer.Begin());
+        CKAnimController *loaded = data.CreateController(types[c]);
+        TestCheck(loaded->ReadKeysFrom(buffer.Begin()) == size, "ReadKeysFrom should read what DumpKeysTo wrote");
+        TestCheck(loaded->Compare(compressed, 0.0f) != FALSE, "Loaded track should equal the saved one");
+
+        const float end = source->GetKey(kKeyCount - 1)->TimeStep;
+        for (float time = -1.0f; time < end + 1.0f; time += 0.13f) {
+            float a[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            float b[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            compressed->Evaluate(time, a);
+            loaded->Evaluate(time, b);
+            TestCheck(memcmp(a, b, sizeof(a)) == 0, "Loaded track should evaluate the same");
+        }
+
+        // Key edits: a key added between two others, then removed
+        const float time = 0.5f * (loaded->GetKey(3)->TimeStep + loaded->GetKey(4)->TimeStep);
+        const int count = loaded->GetKeyCount();
+        float before[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        loaded->Evaluate(time, before);
+        CKPositionKey posKey;
+        posKey.TimeStep = time;
+        posKey.Pos = VxVector(50.0f, -50.0f, 25.0f);
+        CKRotationKey rotKey;
+        rotKey.TimeStep = time;
+        rotKey.Rot = VxQuaternion(0.3f, -0.2f, 0.1f, 0.9f);
+        rotKey.Rot.Normalize();
+        const int index = loaded->AddKey(IsRotation(types[c]) ? (CKKey *) &rotKey : (CKKey *) &posKey);
+        TestCheck(loaded->GetKeyCount() == count + 1 && loaded->GetKey(index)->TimeStep == time, "Key should be added");
+        float added[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        loaded->Evaluate(time, added);
+        TestCheck(ResultError(types[c], added, before) > 0.01f, "Added key should change the track");
+        loaded->RemoveKey(index);
+        TestCheck(loaded->GetKeyCount() == count, "Key should be removed");
+
+        delete source;
+        delete compressed;
+        delete loaded;
+    }
+}
+
+
+// Morph keys over a base pose, each key moving one region of the vertices
+// (about 5% of them) with its normals
+const int kMorphVertexCount = 2000;
+const int kMorphKeyCount = 12;
+
+void AddMorphKeys(RCKMorphController *controller) {
+    controller->SetMorphVertexCount(kMorphVertexCount);
+    XArray<VxVector> basePositions;
+    XArray<VxCompressedVector> baseNormals;
+    basePositions.Resize(kMorphVertexCount);
+    baseNormals.Resize(kMorphVertexCount);
+    for (int v = 0; v < kMorphVertexCount; ++v) {
+        basePositions[v] = VxVector(RandomFloat(10.0f), RandomFloat(10.0f), RandomFloat(10.0f));
+        baseNormals[v].xa = (short) (rand() & 0x7FFF);
+        baseNormals[v].ya = (short) (rand() & 0x7FFF);
+    }
+
+    float time = 0.0f;
+    for (int k = 0; k < kMorphKeyCount; ++k) {
+        CKMorphKey *key = static_cast<CKMorphKey *>(controller->GetKey(controller->AddKey(time, TRUE)));
+        memcpy(key->PosArray, basePositions.Begin(), kMorphVertexCount * sizeof(VxVector));
+        memcpy(key->NormArray, baseNormals.Begin(), kMorphVertexCount * sizeof(VxCompressedVector));
+        if (k > 0) {
+            const int regionSize = kMorphVertexCount / 20;
+            const int region = rand() % (kMorphVertexCount - regionSize);
+            for (int v = region; v < region + regionSize; ++v) {
+                key->PosArray[v] += VxVector(RandomFloat(1.0f), RandomFloat(1.0f), RandomFloat(1.0f));
+                key->NormArray[v].xa = (short) (rand() & 0x7FFF);
+            }
+        }
+        time += 1.0f + (float) (rand() % 4);
+    }
+}
+
+RCKMorphController *BuildMorphController(CKKeyframeData &data) {
+    RCKMorphController *controller =
+        static_cast<RCKMorphController *>(data.CreateController(CKANIMATION_MORPH_CONTROL));
+    AddMorphKeys(controller);
+    return controller;
+}
+
+// Same 32 byte stride as mesh vertices
+struct MorphVertex {
+    VxVector Position;
+    VxVector Normal;
+    float u, v;
+};
+
+// Dense blend between the keys around time
+void MorphReference(RCKMorphController *controller, float time, MorphVertex *vertices, VxCompressedVector *normals) {
+    const int last = controller->GetKeyCount() - 1;
+    int from = 0;
+    while (from < last && controller->GetKey(from + 1)->TimeStep <= time)
+        ++from;
+    CKMorphKey *key1 = static_cast<CKMorphKey *>(controller->GetKey(from));
+    CKMorphKey *key2 = key1;
+    float t = 0.0f;
+    if (from < last && time > key1->TimeStep) {
+        key2 = static_cast<CKMorphKey *>(controller->GetKey(from + 1));
+        t = (time - key1->TimeStep) / (key2->TimeStep - key1->TimeStep);
+    }
+    for (int v = 0; v < kMorphVertexCount; ++v) {
+        const VxVector &p1 = key1->PosArray[v];
+        const VxVector &p2 = key2->PosArray[v];
+        vertices[v].Position.x = p1.x + (p2.x - p1.x) * t;
+        vertices[v].Position.y = p1.y + (p2.y - p1.y) * t;
+        vertices[v].Position.z = p1.z + (p2.z - p1.z) * t;
+        const VxCompressedVector &n1 = key1->NormArray[v];
+        const VxCompressedVector &n2 = key2->NormArray[v];
+        normals[v].xa = (short) (int) (n1.xa + (n2.xa - n1.xa) * t);
+        normals[v].ya = (short) (int) (n1.ya + (n2.ya - n1.ya) * t);
+    }
+}
+
+bool SameMorph(const XArray<MorphVertex> &a, const XArray<MorphVertex> &b, const XArray<VxCompressedVector> &na,
+               const XArray<VxCompressedVector> &nb) {
+    for (int v = 0; v < kMorphVertexCount; ++v) {
+        if (memcmp(&a[v].Position, &b[v].Position, sizeof(VxVector)) != 0)
+            return false;
+    }
+    return memcmp(na.Begin(), nb.Begin(), kMorphVertexCount * sizeof(VxCompressedVector)) == 0;
+}
+
+void SparseMorphMatchesDenseBlend() {
+    srand(41);
+    CKKeyframeData data;
+    RCKMorphController *controller = BuildMorphController(data);
+    const float end = controller->GetKey(kMorphKeyCount - 1)->TimeStep;
+
+    XArray<MorphVertex> vertices, expected;
+    XArray<VxCompressedVector> normals, expectedNormals;
+    vertices.Resize(kMorphVertexCount);
+    expected.Resize(kMorphVertexCount);
+    normals.Resize(kMorphVertexCount);
+    expectedNormals.Resize(kMorphVertexCount);
+    memset(vertices.Begin(), 0, kMorphVertexCount * sizeof(MorphVertex));
+    memset(expected.Begin(), 0, kMorphVertexCount * sizeof(MorphVertex));
+
+    for (int i = 0; i < 400; ++i) {
+        // Forward playback, random access, then exactly on the keys
+        float time = i < 200 ? -1.0f + i * (end + 2.0f) / 200.0f : RandomFloat(end + 1.0f);
+        if (i >= 400 - kMorphKeyCount)
+            time = controller->GetKey(400 - 1 - i)->TimeStep;
+        TestCheck(controller->Evaluate(time, kMorphVertexCount, vertices.Begin(), sizeof(MorphVertex), normals.Begin()) !=
+                      FALSE,
+                  "Evaluate should succeed");
+        MorphReference(controller, time, expected.Begin(), expectedNormals.Begin());
+        TestCheck(SameMorph(vertices, expected, normals, expectedNormals), "Sparse morph should match the dense blend");
+    }
+    delete controller;
+}
+
+void MorphChangesRewriteMovedVertices() {
+    srand(43);
+    CKKeyframeData data;
+    RCKMorphController *controller = BuildMorphController(data);
+    const float end = controller->GetKey(kMorphKeyCount - 1)->TimeStep;
+
+    XArray<MorphVertex> vertices, previous, expected;
+    XArray<VxCompressedVector> normals, expectedNormals;
+    vertices.Resize(kMorphVertexCount);
+    expected.Resize(kMorphVertexCount);
+    normals.Resize(kMorphVertexCount);
+    expectedNormals.Resize(kMorphVertexCount);
+    memset(vertices.Begin(), 0, kMorphVertexCount * sizeof(MorphVertex));
+    memset(expected.Begin(), 0, kMorphVertexCount * sizeof(MorphVertex));
+
+    CKMorphState state;
+    XArray<int> moved;
+    XArray<CKBYTE> isMoved;
+    isMoved.Resize(kMorphVertexCount);
+    int sparseCalls = 0;
+    for (int i = 0; i < 600; ++i) {
+        // Forward playback with pauses, jumps, backward playback
+        float time = fmodf(i * 0.05f, end);
+        if (i % 50 >= 45)
+            time = fmodf((i - i % 50 + 45) * 0.05f, end);
+        else if (i >= 400)
+            time = end - (i - 400) * 0.07f;
+        else if (i % 97 == 0)
+            time = RandomFloat(end);
+
+        previous = vertices;
+        const int count = controller->EvaluateChanges(time, kMorphVertexCount, vertices.Begin(), sizeof(MorphVertex),
+                                                      normals.Begin(), state, moved);
+        TestCheck(count == -1 || count == moved.Size(), "Moved count should match the list");
+        MorphReference(controller, time, expected.Begin(), expectedNormals.Begin());
+        TestCheck(SameMorph(vertices, expected, normals, expectedNormals),
+                  "Incremental morph should match the dense blend");
+        if (count < 0)
+            continue;
+
+        ++sparseCalls;
+        memset(isMoved.Begin(), 0, kMorphVertexCount);
+        for (int m = 0; m < count; ++m)
+            isMoved[moved[m]] = 1;
+        for (int v = 0; v < kMorphVertexCount; ++v) {
+            if (!isMoved[v])
+                TestCheck(memcmp(&vertices[v].Position, &previous[v].Position, sizeof(VxVector)) == 0,
+                          "Vertices outside the moved list should not change");
+        }
+        TestCheck(count < kMorphVertexCount / 4, "Only the key regions should move");
+    }
+    TestCheck(sparseCalls > 500, "Playback should mostly take the incremental path");
+
+    // Reading the keys keeps the table
+    const float time = controller->GetKey(3)->TimeStep;
+    TestCheck(controller->EvaluateChanges(time, kMorphVertexCount, vertices.Begin(), sizeof(MorphVertex), normals.Begin(),
+                                          state, moved) >= 0,
+              "Reading the keys should keep the state");
+
+    // Key edits rebuild the table, and the next call rewrites everything
+    CKMorphKey *key = static_cast<CKMorphKey *>(controller->GetKey(3));
+    key->PosArray[0].x += 1.0f;
+    controller->KeysChanged();
+    TestCheck(controller->EvaluateChanges(1.0f, kMorphVertexCount, vertices.Begin(), sizeof(MorphVertex), normals.Begin(),
+                                          state, moved) == -1,
+              "Edited keys should invalidate the state");
+    delete controller;
+}
+
+struct MorphAnimationAccess : RCKObjectAnimation {
+    using RCKObjectAnimation::m_MorphMoved;
+    using RCKObjectAnimation::m_MorphState;
+};
+
+// The animation path: ApplyMorphTarget reads the keys (HasMorphNormalInfo)
+// every frame, and the second frame still only rewrites the moved vertices
+void ApplyMorphTargetMovesChangedVertices() {
+    srand(47);
+    CKContext context(nullptr, 0, 0);
+    RCKMesh *mesh = new RCKMesh(&context, nullptr);
+    TestCheck(mesh->SetVertexCount(kMorphVertexCount) != FALSE, "SetVertexCount failed");
+    RCK3dEntity *entity = new RCK3dEntity(&context, nullptr);
+    entity->m_CurrentMesh = mesh;
+    RCKObjectAnimation *anim = new RCKObjectAnimation(&context, nullptr);
+    RCKMorphController *controller =
+        static_cast<RCKMorphController *>(anim->CreateController(CKANIMATION_MORPH_CONTROL));
+    AddMorphKeys(controller);
+    anim->Set3dEntity((CK3dEntity *) entity);
+    MorphAnimationAccess *access = static_cast<MorphAnimationAccess *>(anim);
+
+    const float from = controller->GetKey(4)->TimeStep;
+    const float to = controller->GetKey(5)->TimeStep;
+    anim->ApplyMorphTarget(from + (to - from) * 0.25f);
+    const int version = access->m_MorphState.Version;
+    TestCheck(version != 0, "The first frame should set the morph state");
+    TestCheck(access->m_MorphMoved.Size() == 0, "The first frame should write every vertex");
+
+    anim->ApplyMorphTarget(from + (to - from) * 0.5f);
+    TestCheck(access->m_MorphState.Version == version, "The second frame should not rebuild the delta table");
+    const int movedCount = access->m_MorphMoved.Size();
+    TestCheck(movedCount > 0 && movedCount < kMorphVertexCount / 4,
+              "The second frame should only report the moved vertices");
+
+    XArray<MorphVertex> expected;
+    XArray<VxCompressedVector> expectedNormals;
+    expected.Resize(kMorphVertexCount);
+    expectedNormals.Resize(kMorphVertexCount);
+    MorphReference(controller, from + (to - from) * 0.5f, expected.Begin(), expectedNormals.Begin());
+    CKDWORD stride = 0;
+    CKBYTE *vertices = mesh->GetModifierVertices(&stride);
+    for (int v = 0; v < kMorphVertexCount; ++v) {
+        TestCheck(memcmp(vertices + v * stride, &expected[v].Position, sizeof(VxVector)) == 0,
+                  "Mesh vertices should hold the morph target");
+    }
+
+    anim->Set3dEntity(nullptr);
+    entity->m_CurrentMesh = nullptr;
+    delete anim;
+    delete entity;
+    delete mesh;
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("Playback order does not change results", &PlaybackOrderDoesNotChangeResults);
+    tests.Run("Key edits invalidate the cached interval", &KeyEditsInvalidateCachedInterval);
+    tests.Run("Compressed tracks stay within the error bound", &CompressedTracksStayWithinErrorBound);
+    tests.Run("Compressed tracks round trip", &CompressedTracksRoundTrip);
+    tests.Run("Sparse morph matches the dense blend", &SparseMorphMatchesDenseBlend);
+    tests.Run("Morph changes rewrite the moved vertices", &MorphChangesRewriteMovedVertices);
+    tests.Run("ApplyMorphTarget moves the changed vertices", &ApplyMorphTargetMovesChangedVertices);
+    return tests.ExitCode();
+}
@@ -0,0 +1,215 @@
+#include "CKJobPool.h"
+#include "MeshAdjacency.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+// Grid of w x h quads, two triangles each
+void BuildGrid(XArray<CKDWORD> &indices, int w, int h) {
+    indices.Resize(0);
+    for (int j = 0; j < h; ++j) {
+        for (int i = 0; i < w; ++i) {
+            const CKDWORD a = j * (w + 1) + i;
+            const CKDWORD quad[6] = {a, a + 1, a + w + 2, a, a + w + 2, a + w + 1};
+            for (int k = 0; k < 6; ++k)
+                indices.PushBack(quad[k]);
+        }
+    }
+}
+
+// Shuffles the faces and rotates their vertices with a fixed LCG
+void ShuffleFaces(XArray<CKDWORD> &indices) {
+    CKDWORD seed = 12345;
+    const int faceCount = indices.Size() / 3;
+    for (int i = faceCount - 1; i > 0; --i) {
+        seed = seed * 1664525u + 1013904223u;
+        const int j = (int) ((seed >> 8) % (CKDWORD) (i + 1));
+        for (int k = 0; k < 3; ++k)
+            XSwap(indices[i * 3 + k], indices[j * 3 + k]);
+        if (seed & 0x10) {
+            const CKDWORD first = indices[i * 3];
+            indices[i * 3] = indices[i * 3 + 1];
+            indices[i * 3 + 1] = indices[i * 3 + 2];
+            indices[i * 3 + 2] = first;
+        }
+    }
+}
+
+// Every link should point to the single other face sharing the edge, with the
+// counterpart edge number in the two upper bits
+bool LinksMatchBruteForce(const MeshAdjacency &adjacency, const XArray<CKDWORD> &indices) {
+    static const int edgeVertices[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+    const XArray<MeshAdjacency::Face> &faces = adjacency.GetFaces();
+    const int faceCount = indices.Size() / 3;
+    for (int f = 0; f < faceCount; ++f) {
+        for (int e = 0; e < 3; ++e) {
+            const CKDWORD v0 = indices[f * 3 + edgeVertices[e][0]];
+            const CKDWORD v1 = indices[f * 3 + edgeVertices[e][1]];
+            CKDWORD expected = 0xffffffff;
+            for (int g = 0; g < faceCount; ++g) {
+                if (g == f)
+                    continue;
+                const CKBYTE edge = faces[g].FindEdge(v0, v1);
+                if (edge != 0xff)
+                    expected = g | (CKDWORD(edge) << 30);
+            }
+            if (faces[f].faces[e] != expected)
+                return false;
+        }
+    }
+    return true;
+}
+
+void GridLinksMatchBruteForce() {
+    XArray<CKDWORD> indices;
+    BuildGrid(indices, 12, 9);
+    ShuffleFaces(indices);
+    const int faceCount = indices.Size() / 3;
+
+    MeshAdjacency adjacency;
+    adjacency.Init(indices.Begin(), faceCount);
+    TestCheck(adjacency.Compute(true, true), "A grid should be manifold");
+    TestCheck(LinksMatchBruteForce(adjacency, indices), "Links should match a brute force search");
+
+    // Inner edges once, border edges once: V + F - 1 for a disc
+    TestCheck(adjacency.GetEdges().Size() == 13 * 10 + faceCount - 1, "Each edge should be listed once");
+    int boundaryCount = 0;
+    for (int e = 0; e < adjacency.GetEdges().Size(); ++e) {
+        const MeshAdjacency::Edge &edge = adjacency.GetEdges()[e];
+        TestCheck(edge.vertices[0] < edge.vertices[1], "Edge vertices should be sorted");
+        TestCheck(edge.faces[0] != edge.faces[1], "An edge should hold two different faces");
+        if (IS_BOUNDARY(edge.faces[1]))
+            ++boundaryCount;
+    }
+    TestCheck(boundaryCount == 2 * (12 + 9), "The grid border should be made of boundary edges");
+}
+
+void EdgesAreDroppedWhenNotRequested() {
+    XArray<CKDWORD> indices;
+    BuildGrid(indices, 4, 4);
+    MeshAdjacency adjacency;
+    adjacency.Init(indices.Begin(), indices.Size() / 3);
+    TestCheck(adjacency.Compute(false, true), "A grid should be manifold");
+    TestCheck(adjacency.GetEdges().Size() == 0, "Edges should not be kept");
+    TestCheck(LinksMatchBruteForce(adjacency, indices), "Links should still be computed");
+}
+
+void DegenerateFacesLinkToThemselves() {
+    // (0, 1, 0) holds the edge (0, 1) twice and nothing else shares it
+    CKWORD indices[] = {0, 1, 0, 2, 3, 4};
+    MeshAdjacency adjacency;
+    adjacency.Init(indices, 2);
+    TestCheck(adjacency.Compute(true, true), "A degenerate face alone is manifold");
+    const MeshAdjacency::Face &face = adjacency.GetFaces()[0];
+    TestCheck(face.faces[0] == 0, "Both slots of the repeated edge should link the face to its first edge");
+    TestCheck(IS_BOUNDARY(face.faces[1]) && IS_BOUNDARY(face.faces[2]), "Other edges should be boundaries");
+    TestCheck(adjacency.GetEdges().Size() == 5, "The repeated edge should be listed once");
+    const MeshAdjacency::Edge &edge = adjacency.GetEdges()[0];
+    TestCheck(edge.vertices[0] == 0 && edge.vertices[1] == 1 && edge.faces[0] == 0 && edge.faces[1] == 0,
+              "The repeated edge should hold the face twice");
+}
+
+void NonManifoldEdgesFail() {
+    CKWORD indices[] = {0, 1, 2, 1, 0, 3, 0, 1, 4};
+    MeshAdjacency adjacency;
+    adjacency.Init(indices, 3);
+    TestCheck(!adjacency.Compute(true, true), "An edge shared by three faces should fail");
+
+    CKJobPool pool;
+    pool.Start(2);
+    XArray<CKDWORD> grid;
+    BuildGrid(grid, 100, 100);
+    const CKDWORD fan[6] = {0, 1, 20000, 1, 0, 20001};
+    for (int k = 0; k < 6; ++k)
+        grid.PushBack(fan[k]);
+    adjacency.Init(grid.Begin(), grid.Size() / 3);
+    TestCheck(!adjacency.Compute(true, true, &pool), "A non manifold edge in the last chunk should fail");
+}
+
+void VertexFacesAreListed() {
+    XArray<CKDWORD> indices;
+    BuildGrid(indices, 5, 3);
+    ShuffleFaces(indices);
+    indices.PushBack(30);
+    indices.PushBack(30);
+    indices.PushBack(31);
+    const int faceCount = indices.Size() / 3;
+
+    MeshAdjacency adjacency;
+    adjacency.Init(indices.Begin(), faceCount);
+    TestCheck(adjacency.Compute(false, true), "The mesh should be manifold");
+    TestCheck(adjacency.GetVertexCount() == 32, "The table should cover the largest vertex index");
+
+    const XArray<CKDWORD> &starts = adjacency.GetVertexFaceStarts();
+    const XArray<CKDWORD> &vertexFaces = adjacency.GetVertexFaces();
+    TestCheck(starts.Size() == 33 && starts[0] == 0 && (int) starts[32] == vertexFaces.Size(),
+              "Starts should bound the face list");
+    bool listed = true;
+    for (int v = 0; v < 32; ++v) {
+        CKDWORD cursor = starts[v];
+        for (int f = 0; f < faceCount; ++f) {
+            if (indices[f * 3] != (CKDWORD) v && indices[f * 3 + 1] != (CKDWORD) v && indices[f * 3 + 2] != (CKDWORD) v)
+                continue;
+            if (cursor >= starts[v + 1] || vertexFaces[cursor] != (CKDWORD) f)
+                listed = false;
+            ++cursor;
+        }
+        if (cursor != starts[v + 1])
+            listed = false;
+    }
+    TestCheck(listed, "Each vertex should list its faces once, by increasing index");
+}
+
+void PoolMatchesInline() {
+    XArray<CKDWORD> indices;
+    BuildGrid(indices, 160, 120);
+    ShuffleFaces(indices);
+    const int faceCount = indices.Size() / 3;
+
+    MeshAdjacency inlineAdjacency;
+    inlineAdjacency.Init(indices.Begin(), faceCount);
+    TestCheck(inlineAdjacency.Compute(true, true), "A grid should be manifold");
+
+    const int workerCounts[] = {1, 3};
+    for (int w = 0; w < 2; ++w) {
+        CKJobPool pool;
+        pool.Start(workerCounts[w]);
+        MeshAdjacency pooledAdjacency;
+        pooledAdjacency.Init(indices.Begin(), faceCount);
+        TestCheck(pooledAdjacency.Compute(true, true, &pool), "A grid should be manifold on the pool");
+
+        bool same = pooledAdjacency.GetEdges().Size() == inlineAdjacency.GetEdges().Size();
+        for (int f = 0; same && f < faceCount; ++f) {
+            for (int k = 0; k < 3; ++k)
+                same &= pooledAdjacency.GetFaces()[f].faces[k] == inlineAdjacency.GetFaces()[f].faces[k];
+        }
+        for (int e = 0; same && e < inlineAdjacency.GetEdges().Size(); ++e) {
+            const MeshAdjacency::Edge &a = pooledAdjacency.GetEdges()[e];
+            const MeshAdjacency::Edge &b = inlineAdjacency.GetEdges()[e];
+            same = a.vertices[0] == b.vertices[0] && a.vertices[1] == b.vertices[1] && a.faces[0] == b.faces[0] &&
+                   a.faces[1] == b.faces[1];
+        }
+        TestCheck(same, "The pool should give the links and edges of the single threaded build");
+    }
+}
+
+void EmptyMeshIsValid() {
+    MeshAdjacency adjacency;
+    adjacency.Init((CKWORD *) nullptr, 0);
+    TestCheck(adjacency.Compute(true, true), "An empty mesh should be valid");
+    TestCheck(adjacency.GetEdges().Size() == 0 && adjacency.GetVertexCount() == 0, "An empty mesh has no edges");
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("Grid links match brute force", &GridLinksMatchBruteForce);
+    tests.Run("Edges are dropped when not requested", &EdgesAreDroppedWhenNotRequested);
+    tests.Run("Degenerate faces link to themselves", &DegenerateFacesLinkToThemselves);
+    tests.Run("Non manifold edges fail", &NonManifoldEdgesFail);
+    tests.Run("Vertex faces are listed", &VertexFacesAreListed);
+    tests.Run("Pool matches inline", &PoolMatchesInline);
+    tests.Run("Empty mesh is valid", &EmptyMeshIsValid);
+    return tests.ExitCode();
+}
@@ -0,0 +1,206 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "CKMeshBVH.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+struct TestMesh {
+    XArray<VxVertex> vertices;
+    XArray<CKWORD> indices;
+};
+
+float RandomFloat(float range) {
+    return ((float) rand() / (float) RAND_MAX * 2.0f - 1.0f) * range;
+}
+
+// Jittered height field plus a few long thin faces crossing it, so leaves
+// overlap and some boxes are much larger than their neighbours
+void BuildTestMesh(TestMesh &mesh) {
+    const int side = 40;
+    mesh.vertices.Resize(side * side + 3 * 8);
+    for (int i = 0; i < side * side; ++i) {
+        VxVertex &v = mesh.vertices[i];
+        v.m_Position.Set((float) (i % side) + RandomFloat(0.3f), RandomFloat(1.5f), (float) (i / side) + RandomFloat(0.3f));
+    }
+    for (int i = side * side; i < mesh.vertices.Size(); ++i)
+        mesh.vertices[i].m_Position.Set(RandomFloat(20.0f) + 20.0f, RandomFloat(3.0f), RandomFloat(20.0f) + 20.0f);
+
+    for (int z = 0; z < side - 1; ++z) {
+        for (int x = 0; x < side - 1; ++x) {
+            const CKWORD a = (CKWORD) (z * side + x);
+            const CKWORD quad[6] = {a, (CKWORD) (a + 1), (CKWORD) (a + side),
+                                    (CKWORD) (a + 1), (CKWORD) (a + side + 1), (CKWORD) (a + side)};
+            for (int k = 0; k < 6; ++k)
+                mesh.indices.PushBack(quad[k]);
+        }
+    }
+    for (int i = side * side; i < mesh.vertices.Size(); ++i)
+        mesh.indices.PushBack((CKWORD) i);
+}
+
+int FaceCount(const TestMesh &mesh) {
+    return mesh.indices.Size() / 3;
+}
+
+// Two-sided ray / triangle test, t in [0, maxDist]
+bool RayHitsFace(const TestMesh &mesh, int face, const VxVector &origin, const VxVector &dir, float maxDist) {
+    const VxVector &v0 = mesh.vertices[mesh.indices[face * 3]].m_Position;
+    const VxVector &v1 = mesh.vertices[mesh.indices[face * 3 + 1]].m_Position;
+    const VxVector &v2 = mesh.vertices[mesh.indices[face * 3 + 2]].m_Position;
+    const VxVector e1 = v1 - v0;
+    const VxVector e2 = v2 - v0;
+    const VxVector p = CrossProduct(dir, e2);
+    const float det = DotProduct(e1, p);
+    if (fabsf(det) < 1e-12f)
+        return false;
+    const float inv = 1.0f / det;
+    const VxVector s = origin - v0;
+    const float u = DotProduct(s, p) * inv;
+    if (u < 0.0f || u > 1.0f)
+        return false;
+    const VxVector q = CrossProduct(s, e1);
+    const float v = DotProduct(dir, q) * inv;
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+    const float t = DotProduct(e2, q) * inv;
+    return t >= 0.0f && t <= maxDist;
+}
+
+struct Candidates {
+    XArray<int> visits; // Times each face was handed to the callback
+    int total;
+};
+
+void CollectFaces(const int *faces, int count, void *arg) {
+    Candidates &candidates = *(Candidates *) arg;
+    for (int i = 0; i < count; ++i)
+        ++candidates.visits[faces[i]];
+    candidates.total += count;
+}
+
+void Query(const CKMeshBVH &bvh, const TestMesh &mesh, const VxVector &origin, const VxVector &dir, float maxDist,
+           Candidates &candidates) {
+    candidates.visits.Resize(FaceCount(mesh));
+    for (int f = 0; f < FaceCount(mesh); ++f)
+        candidates.visits[f] = 0;
+    candidates.total = 0;
+    bvh.Traverse(origin, dir, maxDist, CollectFaces, &candidates);
+}
+
+void EveryFaceIsInOneLeaf() {
+    srand(11);
+    TestMesh mesh;
+    BuildTestMesh(mesh);
+    CKMeshBVH bvh;
+    bvh.Build(mesh.vertices.Begin(), mesh.vertices.Size(), mesh.indices.Begin(), FaceCount(mesh));
+    TestCheck(bvh.IsUpToDate(FaceCount(mesh), mesh.vertices.Size()), "Built hierarchy should be up to date");
+    TestCheck(bvh.GetNodeCount() > 1 && bvh.GetNodeCount() < 2 * FaceCount(mesh), "Unexpected node count");
+
+    // A vertical ray through the centroid crosses the leaf holding the face
+    Candidates candidates;
+    for (int f = 0; f < FaceCount(mesh); ++f) {
+        const VxVector centroid = (mesh.vertices[mesh.indices[f * 3]].m_Position +
+                                   mesh.vertices[mesh.indices[f * 3 + 1]].m_Position +
+                                   mesh.vertices[mesh.indices[f * 3 + 2]].m_Position) / 3.0f;
+        Query(bvh, mesh, centroid + VxVector(0.0f, 10.0f, 0.0f), VxVector(0.0f, -1.0f, 0.0f), 1.0e35f, candidates);
+        TestCheck(candidates.visits[f] == 1, "A face is missing from the leaves or referenced twice");
+    }
+}
+
+void CandidatesContainEveryHit() {
+    srand(5);
+    TestMesh mesh;
+    BuildTestMesh(mesh);
+    CKMeshBVH bvh;
+    bvh.Build(mesh.vertices.Begin(), mesh.vertices.Size(), mesh.indices.Begin(), FaceCount(mesh));
+
+    int candidateTotal = 0;
+    const int rayCount = 500;
+    for (int r = 0; r < rayCount; ++r) {
+        const VxVector origin(RandomFloat(25.0f) + 20.0f, RandomFloat(6.0f), RandomFloat(25.0f) + 20.0f);
+        VxVector dir(RandomFloat(1.0f), RandomFloat(1.0f), RandomFloat(1.0f));
+        // Axis aligned rays exercise the zero direction components
+        if (r % 5 == 0)
+            dir.Set(0.0f, (r & 1) ? 1.0f : -1.0f, 0.0f);
+        const bool segment = (r & 2) != 0;
+        if (segment)
+            dir *= 30.0f;
+        const float maxDist = segment ? 1.0f : 1.0e35f;
+
+        Candidates candidates;
+        Query(bvh, mesh, origin, dir, maxDist, candidates);
+        candidateTotal += candidates.total;
+        for (int f = 0; f < FaceCount(mesh); ++f) {
+            if (RayHitsFace(mesh, f, origin, dir, maxDist))
+                TestCheck(candidates.visits[f] == 1, "A face hit by the ray was not visited");
+        }
+    }
+    TestCheck(candidateTotal < rayCount * FaceCount(mesh) / 10, "Traversal should only visit a small part of the mesh");
+}
+
+void InvalidateRequestsRebuild() {
+    srand(3);
+    TestMesh mesh;
+    BuildTestMesh(mesh);
+    CKMeshBVH bvh;
+    TestCheck(!bvh.IsUpToDate(FaceCount(mesh), mesh.vertices.Size()), "Empty hierarchy should not be up to date");
+    bvh.Build(mesh.vertices.Begin(), mesh.vertices.Size(), mesh.indices.Begin(), FaceCount(mesh));
+    TestCheck(!bvh.IsUpToDate(FaceCount(mesh) - 1, mesh.vertices.Size()), "Face count change should require a rebuild");
+
+    // Move a face far away and rebuild: the old location must not report it anymore
+    const CKWORD moved = mesh.indices[0];
+    const VxVector oldPosition = mesh.vertices[moved].m_Position;
+    bvh.Invalidate();
+    TestCheck(!bvh.IsUpToDate(FaceCount(mesh), mesh.vertices.Size()), "Invalidate should require a rebuild");
+    mesh.vertices[moved].m_Position.Set(500.0f, 500.0f, 500.0f);
+    bvh.Build(mesh.vertices.Begin(), mesh.vertices.Size(), mesh.indices.Begin(), FaceCount(mesh));
+
+    Candidates candidates;
+    Query(bvh, mesh, VxVector(500.0f, 600.0f, 500.0f), VxVector(0.0f, -1.0f, 0.0f), 1.0e35f, candidates);
+    TestCheck(candidates.visits[0] == 1, "Moved face should be found at its new position");
+    Query(bvh, mesh, oldPosition + VxVector(0.0f, 10.0f, 0.0f), VxVector(0.0f, -1.0f, 0.0f), 1.0e35f, candidates);
+    TestCheck(candidates.total < FaceCount(mesh) / 4, "Ray near the old position should stay local");
+}
+
+void WideIndicesBuildTheSameHierarchy() {
+    srand(17);
+    TestMesh mesh;
+    BuildTestMesh(mesh);
+    XArray<CKDWORD> wideIndices;
+    wideIndices.Resize(mesh.indices.Size());
+    for (int i = 0; i < mesh.indices.Size(); ++i)
+        wideIndices[i] = mesh.indices[i];
+
+    CKMeshBVH bvh;
+    CKMeshBVH wideBvh;
+    bvh.Build(mesh.vertices.Begin(), mesh.vertices.Size(), mesh.indices.Begin(), FaceCount(mesh));
+    wideBvh.Build(mesh.vertices.Begin(), mesh.vertices.Size(), wideIndices.Begin(), FaceCount(mesh));
+    TestCheck(wideBvh.IsUpToDate(FaceCount(mesh), mesh.vertices.Size()), "Built hierarchy should be up to date");
+    TestCheck(wideBvh.GetNodeCount() == bvh.GetNodeCount(), "Index width should not change the hierarchy");
+
+    for (int r = 0; r < 100; ++r) {
+        const VxVector origin(RandomFloat(25.0f) + 20.0f, RandomFloat(6.0f), RandomFloat(25.0f) + 20.0f);
+        const VxVector dir(RandomFloat(1.0f), RandomFloat(1.0f), RandomFloat(1.0f));
+        Candidates candidates;
+        Candidates wideCandidates;
+        Query(bvh, mesh, origin, dir, 1.0e35f, candidates);
+        Query(wideBvh, mesh, origin, dir, 1.0e35f, wideCandidates);
+        bool same = candidates.total == wideCandidates.total;
+        for (int f = 0; f < FaceCount(mesh); ++f)
+            same = same && candidates.visits[f] == wideCandidates.visits[f];
+        TestCheck(same, "Wide index hierarchy visits different faces");
+    }
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("Every face is in one leaf", &EveryFaceIsInOneLeaf);
+    tests.Run("Candidates contain every hit", &CandidatesContainEveryHit);
+    tests.Run("Invalidate requests a rebuild", &InvalidateRequestsRebuild);
+    tests.Run("Wide indices build the same hierarchy", &WideIndicesBuildTheSameHierarchy);
+    return tests.ExitCode();
+}
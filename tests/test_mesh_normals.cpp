@@ -0,0 +1,245 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "CKMeshVertexFaces.h"
+#include "RCKMesh.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+typedef void (*BuildNormalsFunc)(CKFace *, CKWORD *, int, VxVertex *, int);
+typedef void (*NormalizeFunc)(VxVertex *, int);
+
+struct NormalKernels {
+    const char *name;
+    CK_MESHSIMD level;
+    BuildNormalsFunc buildFaceNormals;
+    BuildNormalsFunc buildNormals;
+    NormalizeFunc normalize;
+};
+
+const NormalKernels kKernels[] = {
+    {"SSE2", CK_MESHSIMD_SSE2, BuildFaceNormalsSSE2Func, BuildNormalsSSE2Func, NormalizeSSE2Func},
+    {"AVX2", CK_MESHSIMD_AVX2, BuildFaceNormalsAVX2Func, BuildNormalsAVX2Func, NormalizeAVX2Func},
+};
+
+struct TestMesh {
+    XArray<VxVertex> vertices;
+    XArray<CKFace> faces;
+    XArray<CKWORD> indices;
+};
+
+float RandomFloat(float range) {
+    return ((float) rand() / (float) RAND_MAX * 2.0f - 1.0f) * range;
+}
+
+// Jittered grid with shuffled corners, a degenerate face and recognizable
+// UVs / material indices to catch writes outside the normal fields
+void BuildTestMesh(TestMesh &mesh, int faceCount) {
+    const int side = 24;
+    mesh.vertices.Resize(side * side);
+    for (int i = 0; i < mesh.vertices.Size(); ++i) {
+        VxVertex &v = mesh.vertices[i];
+        v.m_Position.Set((float) (i % side) + RandomFloat(0.3f), RandomFloat(2.0f), (float) (i / side) + RandomFloat(0.3f));
+        v.m_Normal.Set(RandomFloat(1.0f), RandomFloat(1.0f), RandomFloat(1.0f));
+        v.m_UV = Vx2DVector((float) i, -(float) i);
+    }
+
+    mesh.faces.Resize(faceCount);
+    mesh.indices.Resize(faceCount * 3);
+    for (int f = 0; f < faceCount; ++f) {
+        const int cell = f / 2 % ((side - 1) * (side - 1));
+        const int x = cell % (side - 1);
+        const int z = cell / (side - 1);
+        const CKWORD a = (CKWORD) (z * side + x);
+        const CKWORD b = (CKWORD) (a + 1);
+        const CKWORD c = (CKWORD) (a + side);
+        const CKWORD d = (CKWORD) (c + 1);
+        CKWORD *tri = &mesh.indices[f * 3];
+        if (f & 1) {
+            tri[0] = b;
+            tri[1] = d;
+            tri[2] = c;
+        } else {
+            tri[0] = a;
+            tri[1] = b;
+            tri[2] = c;
+        }
+        mesh.faces[f].m_Normal.Set(0.0f, 0.0f, 0.0f);
+        mesh.faces[f].m_MatIndex = (CKWORD) f;
+        mesh.faces[f].m_ChannelMask = (CKWORD) (0xFFFF - f);
+    }
+
+    // A zero area face must be left unnormalized, as the generic version does
+    if (faceCount > 5) {
+        mesh.indices[15] = mesh.indices[16] = mesh.indices[17] = 0;
+    }
+}
+
+bool VectorsClose(const VxVector &lhs, const VxVector &rhs, float epsilon) {
+    return fabsf(lhs.x - rhs.x) <= epsilon && fabsf(lhs.y - rhs.y) <= epsilon && fabsf(lhs.z - rhs.z) <= epsilon;
+}
+
+void CheckSameMesh(const TestMesh &expected, const TestMesh &actual, float epsilon, const char *message) {
+    for (int f = 0; f < expected.faces.Size(); ++f) {
+        const CKFace &e = expected.faces[f];
+        const CKFace &a = actual.faces[f];
+        TestCheck(VectorsClose(e.m_Normal, a.m_Normal, epsilon), message);
+        TestCheck(e.m_MatIndex == a.m_MatIndex && e.m_ChannelMask == a.m_ChannelMask, "Face material data was overwritten");
+    }
+    for (int i = 0; i < expected.vertices.Size(); ++i) {
+        const VxVertex &e = expected.vertices[i];
+        const VxVertex &a = actual.vertices[i];
+        TestCheck(memcmp(&e.m_Position, &a.m_Position, sizeof(VxVector)) == 0, "Vertex position was overwritten");
+        TestCheck(memcmp(&e.m_UV, &a.m_UV, sizeof(Vx2DVector)) == 0, "Vertex UV was overwritten");
+        TestCheck(VectorsClose(e.m_Normal, a.m_Normal, epsilon), message);
+    }
+}
+
+void SIMDNormalsMatchGeneric() {
+    // Face counts around the 4 and 8 face blocks exercise the scalar tails
+    const int faceCounts[] = {1, 3, 4, 7, 8, 9, 15, 17, 64, 333, 1057};
+    const int levels = (int) GetMeshSIMDLevel();
+
+    for (int k = 0; k < (int) (sizeof(kKernels) / sizeof(kKernels[0])); ++k) {
+        const NormalKernels &kernels = kKernels[k];
+        if (kernels.level > levels)
+            continue;
+
+        for (int c = 0; c < (int) (sizeof(faceCounts) / sizeof(faceCounts[0])); ++c) {
+            srand(1234 + faceCounts[c]);
+            TestMesh reference;
+            BuildTestMesh(reference, faceCounts[c]);
+            TestMesh simd = reference;
+
+            BuildFaceNormalsGenericFunc(reference.faces.Begin(), reference.indices.Begin(), reference.faces.Size(),
+                                        reference.vertices.Begin(), reference.vertices.Size());
+            kernels.buildFaceNormals(simd.faces.Begin(), simd.indices.Begin(), simd.faces.Size(),
+                                     simd.vertices.Begin(), simd.vertices.Size());
+            CheckSameMesh(reference, simd, 1e-6f, "Face normals differ from the generic version");
+
+            BuildNormalsGenericFunc(reference.faces.Begin(), reference.indices.Begin(), reference.faces.Size(),
+                                    reference.vertices.Begin(), reference.vertices.Size());
+            kernels.buildNormals(simd.faces.Begin(), simd.indices.Begin(), simd.faces.Size(),
+                                 simd.vertices.Begin(), simd.vertices.Size());
+            CheckSameMesh(reference, simd, 1e-5f, "Vertex normals differ from the generic version");
+        }
+    }
+}
+
+void SIMDNormalizeMatchesGeneric() {
+    const int levels = (int) GetMeshSIMDLevel();
+
+    for (int k = 0; k < (int) (sizeof(kKernels) / sizeof(kKernels[0])); ++k) {
+        const NormalKernels &kernels = kKernels[k];
+        if (kernels.level > levels)
+            continue;
+
+        srand(42);
+        TestMesh reference;
+        BuildTestMesh(reference, 4);
+        reference.vertices.Resize(101);
+        for (int i = 0; i < reference.vertices.Size(); ++i) {
+            reference.vertices[i].m_Normal.Set(RandomFloat(50.0f), RandomFloat(50.0f), RandomFloat(50.0f));
+            reference.vertices[i].m_UV = Vx2DVector((float) i, 0.5f);
+        }
+        reference.vertices[7].m_Normal.Set(0.0f, 0.0f, 0.0f);
+        TestMesh simd = reference;
+
+        NormalizeGenericFunc(reference.vertices.Begin(), reference.vertices.Size());
+        kernels.normalize(simd.vertices.Begin(), simd.vertices.Size());
+        CheckSameMesh(reference, simd, 1e-5f, "Normalized vertex normals differ from the generic version");
+        TestCheck(simd.vertices[7].m_Normal.x == 0.0f && simd.vertices[7].m_Normal.y == 0.0f &&
+                  simd.vertices[7].m_Normal.z == 0.0f, "A zero normal should stay zero");
+    }
+}
+
+
+void PatchNormalsWith(const NormalKernels &kernels) {
+    srand(77);
+    TestMesh reference;
+    BuildTestMesh(reference, 1057);
+    // The last face and two vertices are past the 4 element blocks of the
+    // SIMD kernels
+    const int tail = reference.vertices.Size();
+    reference.vertices.Resize(tail + 2);
+    for (int i = tail; i < tail + 2; ++i) {
+        reference.vertices[i].m_Position.Set((float) i, 1.0f, -1.0f);
+        reference.vertices[i].m_UV = Vx2DVector((float) i, 0.0f);
+    }
+    reference.indices[1056 * 3] = (CKWORD) (tail - 1);
+    reference.indices[1056 * 3 + 1] = (CKWORD) tail;
+    reference.indices[1056 * 3 + 2] = (CKWORD) (tail + 1);
+    kernels.buildNormals(reference.faces.Begin(), reference.indices.Begin(), reference.faces.Size(),
+                         reference.vertices.Begin(), reference.vertices.Size());
+    TestMesh patched = reference;
+
+    CKMeshVertexFaces lists;
+    lists.Build(patched.indices.Begin(), patched.faces.Size(), patched.vertices.Size());
+    TestCheck(lists.IsUpToDate(patched.faces.Size(), patched.vertices.Size()) != FALSE, "Lists should be up to date");
+
+    XArray<int> moved;
+    for (int round = 0; round < 20; ++round) {
+        // A small region, listed with duplicates, the degenerate face corner
+        // and the tail vertices
+        moved.Resize(0);
+        const int start = rand() % (reference.vertices.Size() - 40);
+        for (int i = 0; i < 30; ++i)
+            moved.PushBack(start + rand() % 40);
+        moved.PushBack(moved[0]);
+        if (round == 0) {
+            moved.PushBack(0);
+            moved.PushBack(tail);
+        }
+        for (int i = 0; i < moved.Size(); ++i) {
+            const VxVector offset(RandomFloat(0.2f), RandomFloat(0.5f), RandomFloat(0.2f));
+            reference.vertices[moved[i]].m_Position += offset;
+            patched.vertices[moved[i]].m_Position += offset;
+        }
+
+        kernels.buildNormals(reference.faces.Begin(), reference.indices.Begin(), reference.faces.Size(),
+                             reference.vertices.Begin(), reference.vertices.Size());
+        lists.PatchNormals(moved.Begin(), moved.Size(), patched.faces.Begin(), patched.indices.Begin(),
+                           patched.vertices.Begin(), TRUE, kernels.buildFaceNormals, kernels.normalize);
+        CheckSameMesh(reference, patched, 0.0f, "Patched normals differ from the full build");
+    }
+
+    // Face normals only leave the vertex normals alone
+    const VxVector before = patched.vertices[100].m_Normal;
+    patched.vertices[100].m_Position.y += 1.0f;
+    reference.vertices[100].m_Position.y += 1.0f;
+    const int vertex = 100;
+    lists.PatchNormals(&vertex, 1, patched.faces.Begin(), patched.indices.Begin(), patched.vertices.Begin(), FALSE,
+                       kernels.buildFaceNormals, kernels.normalize);
+    kernels.buildFaceNormals(reference.faces.Begin(), reference.indices.Begin(), reference.faces.Size(),
+                             reference.vertices.Begin(), reference.vertices.Size());
+    TestCheck(memcmp(&before, &patched.vertices[100].m_Normal, sizeof(VxVector)) == 0,
+              "Face normal patch should keep the vertex normals");
+    for (int f = 0; f < reference.faces.Size(); ++f)
+        TestCheck(memcmp(&reference.faces[f].m_Normal, &patched.faces[f].m_Normal, sizeof(VxVector)) == 0,
+                  "Patched face normals differ from the full build");
+}
+
+// The patch gives the normals of the full build of each level, bit for bit
+void PatchedNormalsMatchFullBuild() {
+    const NormalKernels generic = {"Generic", CK_MESHSIMD_NONE, BuildFaceNormalsGenericFunc, BuildNormalsGenericFunc,
+                                   NormalizeGenericFunc};
+    PatchNormalsWith(generic);
+
+    const int levels = (int) GetMeshSIMDLevel();
+    for (int k = 0; k < (int) (sizeof(kKernels) / sizeof(kKernels[0])); ++k) {
+        if (kKernels[k].level <= levels)
+            PatchNormalsWith(kKernels[k]);
+    }
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("SIMD normals match generic", &SIMDNormalsMatchGeneric);
+    tests.Run("SIMD normalize matches generic", &SIMDNormalizeMatchesGeneric);
+    tests.Run("Patched normals match a full build", &PatchedNormalsMatchFullBuild);
+    return tests.ExitCode();
+}
@@ -0,0 +1,171 @@
+#include <string.h>
+
+#include "CKContext.h"
+#include "CKStateChunk.h"
+#include "RCKMesh.h"
+#include "CKNullRasterizer.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+const int kGridSide = 32;
+
+// Lit grid of kGridSide x kGridSide vertices with one material group
+void BuildGridMesh(RCKMesh &mesh) {
+    const int cells = kGridSide - 1;
+    mesh.SetVertexCount(kGridSide * kGridSide);
+    for (int i = 0; i < kGridSide * kGridSide; ++i) {
+        VxVector position((float) (i % kGridSide), 0.0f, (float) (i / kGridSide));
+        mesh.SetVertexPosition(i, &position);
+        mesh.SetVertexTextureCoordinates(i, position.x / cells, position.z / cells, -1);
+    }
+    mesh.SetFaceCount(2 * cells * cells);
+    for (int c = 0; c < cells * cells; ++c) {
+        const int a = c / cells * kGridSide + c % cells;
+        mesh.SetFaceVertexIndex(2 * c, a, a + kGridSide, a + 1);
+        mesh.SetFaceVertexIndex(2 * c + 1, a + 1, a + kGridSide, a + kGridSide + 1);
+        mesh.SetFaceMaterial(2 * c, NULL);
+        mesh.SetFaceMaterial(2 * c + 1, NULL);
+    }
+    mesh.BuildNormals();
+    mesh.CreateRenderGroups();
+}
+
+// The draw data RCKMesh::Render hands to CheckHWVertexBuffer for a lit
+// mesh without extra channels
+void SetupDrawData(VxDrawPrimitiveData &data, RCKMesh &mesh) {
+    memset(&data, 0, sizeof(data));
+    CKDWORD stride;
+    data.VertexCount = mesh.GetVertexCount();
+    data.Flags = CKRST_DP_TRANSFORM | CKRST_DP_LIGHT | CKRST_DP_STAGE(0);
+    data.PositionPtr = mesh.GetPositionsPtr(&stride);
+    data.PositionStride = stride;
+    data.NormalPtr = mesh.GetNormalsPtr(&stride);
+    data.NormalStride = stride;
+    data.ColorPtr = mesh.GetColorsPtr(&stride);
+    data.ColorStride = stride;
+    data.SpecularColorPtr = mesh.GetSpecularColorsPtr(&stride);
+    data.SpecularColorStride = stride;
+    data.TexCoordPtr = mesh.GetTextureCoordinatesPtr(&stride, -1);
+    data.TexCoordStride = stride;
+}
+
+// The vertex buffer of a lit mesh holds VxVertex (position, normal, uv).
+// Without a render manager the mesh uses the object index 0.
+CKBOOL BufferMatchesMesh(CKNullRasterizerContext *ctx, RCKMesh &mesh) {
+    CKNullVertexBufferDesc *vb = static_cast<CKNullVertexBufferDesc *>(ctx->GetVertexBufferData(0));
+    CKDWORD stride;
+    const CKBYTE *vertices = (const CKBYTE *) mesh.GetPositionsPtr(&stride);
+    return vb && vb->Data && vb->m_VertexSize == sizeof(VxVertex) && stride == sizeof(VxVertex) &&
+           memcmp(vb->Data, vertices, mesh.GetVertexCount() * sizeof(VxVertex)) == 0;
+}
+
+void OnlyChangedVerticesAreUploaded() {
+    CKContext context(nullptr, 0, 0);
+    RCKMesh mesh(&context, "VertexBufferMesh");
+    BuildGridMesh(mesh);
+
+    CKRasterizer *rst = CKNullRasterizerStart(NULL);
+    TestCheck(rst != NULL, "Null rasterizer failed to start");
+    CKNullRasterizerContext *ctx = static_cast<CKNullRasterizerContext *>(rst->GetDriver(0)->CreateContext());
+    TestCheck(ctx->Create(NULL, 0, 0, 320, 240), "Null context creation failed");
+
+    VxDrawPrimitiveData data;
+    SetupDrawData(data, mesh);
+    CKDWORD vertexSize;
+    const CKDWORD vertexFormat = CKRSTGetVertexFormat((CKRST_DPFLAGS) data.Flags, vertexSize);
+    const CKDWORD wholeBuffer = mesh.GetVertexCount() * vertexSize;
+
+    ctx->ResetFrame();
+    TestCheck(mesh.CheckHWVertexBuffer(ctx, &data), "The vertex buffer should be created");
+    TestCheck(ctx->GetFrameStats().BytesUploaded == wholeBuffer, "A new vertex buffer is written whole");
+    TestCheck(BufferMatchesMesh(ctx, mesh), "The vertex buffer should hold the mesh vertices");
+
+    // Two vertices in the middle of the grid move: their normals and the
+    // normals of their neighbours are rebuilt, a few rows of the grid
+    CKDWORD stride;
+    CKBYTE *positions = mesh.GetModifierVertices(&stride);
+    const int moved[2] = {16 * kGridSide + 10, 16 * kGridSide + 11};
+    for (int i = 0; i < 2; ++i)
+        ((VxVector *) (positions + moved[i] * stride))->y = 2.0f;
+    mesh.ModifierVerticesMoved(moved, 2, TRUE, FALSE);
+    TestCheck(mesh.IsHWVertexBufferPatchable(vertexFormat), "A few moved vertices can be written alone");
+
+    ctx->ResetFrame();
+    TestCheck(mesh.CheckHWVertexBuffer(ctx, &data), "The vertex buffer should be patched");
+    const CKDWORD patched = ctx->GetFrameStats().BytesUploaded;
+    TestCheck(patched > 0 && patched <= 4 * kGridSide * vertexSize,
+              "Only the rows around the moved vertices are written");
+    TestCheck(BufferMatchesMesh(ctx, mesh), "The patched vertex buffer should hold the moved vertices");
+
+    // Colors are not part of the vertex buffer of a lit mesh
+    mesh.SetVertexColor(3, 0xFF00FF00);
+    TestCheck(mesh.IsHWVertexBufferPatchable(vertexFormat), "Attributes outside the buffer do not invalidate it");
+    ctx->ResetFrame();
+    TestCheck(mesh.CheckHWVertexBuffer(ctx, &data), "The vertex buffer should stay valid");
+    TestCheck(ctx->GetFrameStats().BytesUploaded == 0 && ctx->GetFrameStats().BufferLocks == 0,
+              "Changes to attributes outside the buffer are not uploaded");
+
+    // Moving every vertex waits for the mesh to settle and writes it whole
+    mesh.VertexMove();
+    TestCheck(!mesh.IsHWVertexBufferPatchable(vertexFormat), "Moving all vertices is not a patch");
+    ctx->ResetFrame();
+    TestCheck(mesh.CheckHWVertexBuffer(ctx, &data), "The vertex buffer should be written again");
+    TestCheck(ctx->GetFrameStats().BytesUploaded == wholeBuffer, "Moving all vertices writes the whole buffer");
+
+    rst->GetDriver(0)->DestroyContext(ctx);
+    CKNullRasterizerClose(rst);
+}
+
+void ReloadedMeshIsWrittenAgain() {
+    CKContext context(nullptr, 0, 0);
+    RCKMesh mesh(&context, "ReloadedMesh");
+    BuildGridMesh(mesh);
+    RCKMesh raised(&context, "RaisedMesh");
+    BuildGridMesh(raised);
+    for (int i = 0; i < raised.GetVertexCount(); ++i) {
+        VxVector position;
+        raised.GetVertexPosition(i, &position);
+        position.y += 1.0f + (float) (i % 3);
+        raised.SetVertexPosition(i, &position);
+    }
+    raised.BuildNormals();
+
+    CKRasterizer *rst = CKNullRasterizerStart(NULL);
+    TestCheck(rst != NULL, "Null rasterizer failed to start");
+    CKNullRasterizerContext *ctx = static_cast<CKNullRasterizerContext *>(rst->GetDriver(0)->CreateContext());
+    TestCheck(ctx->Create(NULL, 0, 0, 320, 240), "Null context creation failed");
+
+    VxDrawPrimitiveData data;
+    SetupDrawData(data, mesh);
+    CKDWORD vertexSize;
+    const CKDWORD vertexFormat = CKRSTGetVertexFormat((CKRST_DPFLAGS) data.Flags, vertexSize);
+    TestCheck(mesh.CheckHWVertexBuffer(ctx, &data), "The vertex buffer should be created");
+
+    // Loading, as restoring the initial conditions does, replaces every
+    // vertex without a change notification
+    CKStateChunk *chunk = raised.Save(nullptr, CK_STATESAVE_MESHONLY);
+    TestCheck(chunk != nullptr && mesh.Load(chunk, nullptr) == CK_OK, "Load failed");
+    delete chunk;
+    mesh.CreateRenderGroups();
+    TestCheck(!mesh.IsHWVertexBufferPatchable(vertexFormat), "A reloaded mesh is not a patch");
+
+    SetupDrawData(data, mesh);
+    ctx->ResetFrame();
+    TestCheck(mesh.CheckHWVertexBuffer(ctx, &data), "The vertex buffer should be written again");
+    TestCheck(ctx->GetFrameStats().BytesUploaded == mesh.GetVertexCount() * vertexSize,
+              "A reloaded mesh writes the whole buffer");
+    TestCheck(BufferMatchesMesh(ctx, mesh), "The vertex buffer should hold the reloaded vertices");
+
+    rst->GetDriver(0)->DestroyContext(ctx);
+    CKNullRasterizerClose(rst);
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("Only changed vertices are uploaded", &OnlyChangedVerticesAreUploaded);
+    tests.Run("Reloaded mesh is written again", &ReloadedMeshIsWrittenAgain);
+    return tests.ExitCode();
+}
@@ -106,6 +106,75 @@ XArray<CKWORD> MakeNonManifoldEdge() {
     return tris;
 }
 
+void AddGridTris(XArray<CKWORD> &tris, int width, int height, int first) {
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const int v00 = first + y * (width + 1) + x;
+            const int v01 = v00 + width + 1;
+            const CKWORD quad[6] = {(CKWORD)v00, (CKWORD)(v00 + 1), (CKWORD)v01,
+                                    (CKWORD)v01, (CKWORD)(v00 + 1), (CKWORD)(v01 + 1)};
+            for (int i = 0; i < 6; i++)
+                tris.PushBack(quad[i]);
+        }
+    }
+}
+
+// Shuffles the triangles with a fixed generator, the same on every platform
+void ShuffleTris(XArray<CKWORD> &tris, CKDWORD seed) {
+    for (int f = tris.Size() / 3 - 1; f > 0; --f) {
+        seed = seed * 1664525u + 1013904223u;
+        const int other = (int)((seed >> 8) % (CKDWORD)(f + 1));
+        for (int c = 0; c < 3; ++c)
+            XSwap(tris[f * 3 + c], tris[other * 3 + c]);
+    }
+}
+
+XArray<CKWORD> MakeShuffledGrid() {
+    XArray<CKWORD> tris;
+    AddGridTris(tris, 16, 16, 0);
+    ShuffleTris(tris, 7);
+    return tris;
+}
+
+XArray<CKWORD> MakeShuffledParts() {
+    XArray<CKWORD> tris;
+    AddGridTris(tris, 6, 6, 0);
+    AddGridTris(tris, 5, 7, 100);
+    ShuffleTris(tris, 3);
+    return tris;
+}
+
+CKDWORD HashDword(CKDWORD hash, CKDWORD value) {
+    for (int i = 0; i < 4; ++i) {
+        hash ^= (value >> (i * 8)) & 0xff;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// FNV-1a of the strip lengths then of the indices
+CKDWORD HashResult(const MeshStriper::Result &r, CKDWORD flags, CKDWORD &outIndexCount) {
+    CKDWORD hash = 2166136261u;
+    outIndexCount = 0;
+    for (CKDWORD s = 0; s < r.NbStrips; s++) {
+        hash = HashDword(hash, r.StripLengths[s]);
+        outIndexCount += r.StripLengths[s];
+    }
+    for (CKDWORD i = 0; i < outIndexCount; i++) {
+        const CKDWORD index = ((flags & CKMESHSTRIPER_INDEX16) != 0) ? ((const CKWORD *)r.StripIndices)[i]
+                                                                     : ((const CKDWORD *)r.StripIndices)[i];
+        hash = HashDword(hash, index);
+    }
+    return hash;
+}
+
+bool SameResult(const MeshStriper::Result &a, const MeshStriper::Result &b, CKDWORD flags) {
+    CKDWORD countA = 0;
+    CKDWORD countB = 0;
+    return a.NbStrips == b.NbStrips && HashResult(a, flags, countA) == HashResult(b, flags, countB) &&
+           countA == countB;
+}
+
 void RunMeshStriperAndCheck(const XArray<CKWORD> &inTris, int triCount, CKDWORD flags) {
     MeshStriper ms;
     TestCheck(ms.Init((CKWORD *)inTris.Begin(), triCount, flags) == TRUE, "MeshStriper::Init failed");
@@ -146,7 +215,8 @@ void RunMeshStriperAndCheck(const XArray<CKWORD> &inTris, int triCount, CKDWORD
 
 void Test_InitRejectsInvalidInput() {
     MeshStriper ms;
-    TestCheck(ms.Init(nullptr, 1, 0) == FALSE, "Init should fail with null triList");
+    TestCheck(ms.Init((CKWORD *)nullptr, 1, 0) == FALSE, "Init should fail with null triList");
+    TestCheck(ms.Init((CKDWORD *)nullptr, 1, 0) == FALSE, "Init should fail with null 32-bit triList");
 
     XArray<CKWORD> empty;
     TestCheck(ms.Init((CKWORD *)empty.Begin(), 0, 0) == FALSE, "Init should fail with triCount<=0");
@@ -198,6 +268,82 @@ void Test_NonManifoldEdge_InitFails() {
     TestCheck(ms.Init((CKWORD *)in.Begin(), /*triCount=*/3, CKMESHSTRIPER_INDEX16) == FALSE, "Init should fail for non-manifold edge input");
 }
 
+// Strips recorded from the implementation which copied the used face flags
+// for each candidate strip: the scratch reuse must not change a single index.
+void Test_MatchesPreviousImplementation() {
+    struct Expected {
+        int mesh;
+        CKDWORD flags;
+        CKDWORD strips;
+        CKDWORD indices;
+        CKDWORD hash;
+    };
+    const Expected expected[] = {
+        {0, 0, 16, 544, 0xEF85FAEAu},
+        {0, CKMESHSTRIPER_INDEX16 | CKMESHSTRIPER_SORTSEEDS, 16, 544, 0xB9963266u},
+        {0, CKMESHSTRIPER_INDEX16 | CKMESHSTRIPER_PARITYFIX | CKMESHSTRIPER_CONNECTALL, 1, 574, 0xD2940DE1u},
+        {0, 0xF, 1, 574, 0xCD0E1C0Au},
+        {1, CKMESHSTRIPER_PARITYFIX, 11, 170, 0x38D82910u},
+        {1, CKMESHSTRIPER_INDEX16 | CKMESHSTRIPER_PARITYFIX | CKMESHSTRIPER_SORTSEEDS, 11, 164, 0x49C25AA3u},
+        {1, CKMESHSTRIPER_PARITYFIX | CKMESHSTRIPER_CONNECTALL, 1, 190, 0xA068C433u},
+        {1, CKMESHSTRIPER_INDEX16 | CKMESHSTRIPER_SORTSEEDS | CKMESHSTRIPER_CONNECTALL, 1, 184, 0x7EBF45DFu},
+    };
+    XArray<CKWORD> meshes[2] = {MakeShuffledGrid(), MakeShuffledParts()};
+
+    for (int i = 0; i < (int)(sizeof(expected) / sizeof(expected[0])); i++) {
+        const Expected &e = expected[i];
+        MeshStriper ms;
+        TestCheck(ms.Init(meshes[e.mesh].Begin(), meshes[e.mesh].Size() / 3, e.flags) == TRUE, "Init failed");
+        MeshStriper::Result r{};
+        TestCheck(ms.Compute(&r) == TRUE, "Compute failed");
+
+        CKDWORD indexCount = 0;
+        const CKDWORD hash = HashResult(r, e.flags, indexCount);
+        TestCheck(r.NbStrips == e.strips, "Strip count differs from the previous implementation");
+        TestCheck(indexCount == e.indices, "Index count differs from the previous implementation");
+        TestCheck(hash == e.hash, "Strips differ from the previous implementation");
+    }
+}
+
+void Test_Index32InputMatchesIndex16() {
+    XArray<CKWORD> in16 = MakeShuffledParts();
+    XArray<CKDWORD> in32;
+    for (int i = 0; i < in16.Size(); i++)
+        in32.PushBack(in16[i]);
+
+    for (CKDWORD flags = 0; flags < 16; flags++) {
+        MeshStriper ms16;
+        MeshStriper ms32;
+        TestCheck(ms16.Init(in16.Begin(), in16.Size() / 3, flags) == TRUE, "Init (16-bit input) failed");
+        TestCheck(ms32.Init(in32.Begin(), in32.Size() / 3, flags) == TRUE, "Init (32-bit input) failed");
+        MeshStriper::Result r16{};
+        MeshStriper::Result r32{};
+        TestCheck(ms16.Compute(&r16) == TRUE && ms32.Compute(&r32) == TRUE, "Compute failed");
+        TestCheck(SameResult(r16, r32, flags), "32-bit input should give the strips of 16-bit input");
+    }
+}
+
+void Test_StriperReuseMatchesFreshStriper() {
+    XArray<CKWORD> grid = MakeShuffledGrid();
+    XArray<CKWORD> parts = MakeShuffledParts();
+    const CKDWORD flags = CKMESHSTRIPER_INDEX16 | CKMESHSTRIPER_PARITYFIX | CKMESHSTRIPER_SORTSEEDS;
+
+    // The scratch of a larger mesh is reused for a smaller one
+    MeshStriper reused;
+    MeshStriper::Result r{};
+    TestCheck(reused.Init(grid.Begin(), grid.Size() / 3, flags) == TRUE, "Init failed");
+    TestCheck(reused.Compute(&r) == TRUE, "Compute failed");
+    TestCheck(reused.Init(parts.Begin(), parts.Size() / 3, flags) == TRUE, "Init failed");
+    TestCheck(reused.Compute(&r) == TRUE, "Compute failed");
+    TestCheck(reused.Compute(&r) == TRUE, "Compute failed");
+
+    MeshStriper fresh;
+    MeshStriper::Result expected{};
+    TestCheck(fresh.Init(parts.Begin(), parts.Size() / 3, flags) == TRUE, "Init failed");
+    TestCheck(fresh.Compute(&expected) == TRUE, "Compute failed");
+    TestCheck(SameResult(r, expected, flags), "A reused striper should give the strips of a fresh one");
+}
+
 } // namespace
 
 int main() {
@@ -211,6 +357,9 @@ int main() {
     tf.Run("2x2 grid INDEX32 connectall parityfix", &Test_Grid2x2_Index32_ConnectAll_ParityFix);
     tf.Run("Disconnected squares connectall", &Test_DisconnectedSquares_ConnectAll);
     tf.Run("Non-manifold edge init fails", &Test_NonManifoldEdge_InitFails);
+    tf.Run("Matches previous implementation", &Test_MatchesPreviousImplementation);
+    tf.Run("32-bit input matches 16-bit input", &Test_Index32InputMatchesIndex16);
+    tf.Run("Reused striper matches fresh striper", &Test_StriperReuseMatchesFreshStriper);
 
     return tf.ExitCode();
 }
@@ -158,6 +158,58 @@ XArray<CKWORD> MakeGridTris(int width, int height) {
     return tris;
 }
 
+void AddGridTris(XArray<CKWORD> &tris, int width, int height, int first) {
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const int v00 = first + y * (width + 1) + x;
+            const int v01 = v00 + width + 1;
+            const CKWORD quad[6] = {(CKWORD)v00, (CKWORD)(v00 + 1), (CKWORD)v01,
+                                    (CKWORD)v01, (CKWORD)(v00 + 1), (CKWORD)(v01 + 1)};
+            for (int i = 0; i < 6; i++)
+                tris.PushBack(quad[i]);
+        }
+    }
+}
+
+// Shuffles the triangles with a fixed generator, the same on every platform
+void ShuffleTris(XArray<CKWORD> &tris, CKDWORD seed) {
+    for (int f = tris.Size() / 3 - 1; f > 0; --f) {
+        seed = seed * 1664525u + 1013904223u;
+        const int other = (int)((seed >> 8) % (CKDWORD)(f + 1));
+        for (int c = 0; c < 3; ++c)
+            XSwap(tris[f * 3 + c], tris[other * 3 + c]);
+    }
+}
+
+XArray<CKWORD> MakeShuffledGrid() {
+    XArray<CKWORD> tris;
+    AddGridTris(tris, 16, 16, 0);
+    ShuffleTris(tris, 7);
+    return tris;
+}
+
+XArray<CKWORD> MakeShuffledParts() {
+    XArray<CKWORD> tris;
+    AddGridTris(tris, 6, 6, 0);
+    AddGridTris(tris, 5, 7, 100);
+    ShuffleTris(tris, 3);
+    return tris;
+}
+
+// FNV-1a of the indices
+template <typename IndexT>
+CKDWORD HashIndices(const XArray<IndexT> &indices) {
+    CKDWORD hash = 2166136261u;
+    for (int i = 0; i < indices.Size(); i++) {
+        const CKDWORD value = (CKDWORD)indices[i];
+        for (int b = 0; b < 4; b++) {
+            hash ^= (value >> (b * 8)) & 0xff;
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
 void StripifyAndDestroyForLeakCheck() {
     XArray<CKWORD> in = MakeGridTris(/*width=*/2, /*height=*/2);
     NvStripifier stripifier;
@@ -267,6 +319,82 @@ void Test_DestroyStrips_ReleasesStripifyAllocations() {
     TestCheck(g_AllocationBalance == 0, "Stripify/DestroyStrips should release per-call allocations");
 }
 
+// Streams recorded from the implementation which allocated each face and
+// edge and walked the edge buckets: the flat arrays must not change them.
+void Test_MatchesPreviousImplementation() {
+    struct Expected {
+        int mesh;
+        int minStripLen;
+        bool joinStrips;
+        CKDWORD strips;
+        int indices;
+        CKDWORD hash;
+    };
+    const Expected expected[] = {
+        {0, 0, false, 304, 1528, 0xBD07F181u},
+        {0, 0, true, 1, 2129, 0xDA05F5BCu},
+        {1, 10, false, 83, 432, 0xFB3882E1u},
+        {1, 0, true, 1, 473, 0x0B346726u},
+    };
+    XArray<CKWORD> meshes[2] = {MakeShuffledGrid(), MakeShuffledParts()};
+
+    for (int i = 0; i < (int)(sizeof(expected) / sizeof(expected[0])); i++) {
+        const Expected &e = expected[i];
+        NvStripifier stripifier;
+        XArray<CKWORD> out;
+        CKDWORD outStripCount = 0;
+        stripifier.Stripify(meshes[e.mesh], e.minStripLen, /*cacheSize=*/16, /*vertexCount=*/300, e.joinStrips, out,
+                            outStripCount);
+        TestCheck(outStripCount == e.strips, "Strip count differs from the previous implementation");
+        TestCheck(out.Size() == e.indices, "Index count differs from the previous implementation");
+        TestCheck(HashIndices(out) == e.hash, "Strips differ from the previous implementation");
+    }
+}
+
+void Test_Index32MatchesIndex16() {
+    XArray<CKWORD> in16 = MakeShuffledParts();
+    XArray<CKDWORD> in32;
+    for (int i = 0; i < in16.Size(); i++)
+        in32.PushBack(in16[i]);
+
+    for (int join = 0; join < 2; join++) {
+        NvStripifier stripifier;
+        XArray<CKWORD> out16;
+        XArray<CKDWORD> out32;
+        CKDWORD count16 = 0;
+        CKDWORD count32 = 0;
+        stripifier.Stripify(in16, /*minStripLen=*/0, /*cacheSize=*/16, /*vertexCount=*/200, join != 0, out16, count16);
+        stripifier.Stripify(in32, /*minStripLen=*/0, /*cacheSize=*/16, /*vertexCount=*/200, join != 0, out32, count32);
+
+        TestCheck(count16 == count32 && out16.Size() == out32.Size(), "32-bit strips should match 16-bit strips");
+        for (int i = 0; i < out16.Size(); i++) {
+            const CKDWORD expected = (out16[i] == (CKWORD)0xFFFF) ? 0xFFFFFFFFu : (CKDWORD)out16[i];
+            TestCheck(out32[i] == expected, "32-bit strips should match 16-bit strips");
+        }
+    }
+}
+
+void Test_StripifierReuseMatchesFreshStripifier() {
+    XArray<CKWORD> grid = MakeShuffledGrid();
+    XArray<CKWORD> parts = MakeShuffledParts();
+
+    // The faces and edges of a larger mesh are reused for a smaller one
+    NvStripifier reused;
+    XArray<CKWORD> out;
+    CKDWORD outStripCount = 0;
+    reused.Stripify(grid, /*minStripLen=*/0, /*cacheSize=*/16, /*vertexCount=*/300, true, out, outStripCount);
+    reused.Stripify(parts, /*minStripLen=*/0, /*cacheSize=*/16, /*vertexCount=*/200, true, out, outStripCount);
+
+    NvStripifier fresh;
+    XArray<CKWORD> expected;
+    CKDWORD expectedStripCount = 0;
+    fresh.Stripify(parts, /*minStripLen=*/0, /*cacheSize=*/16, /*vertexCount=*/200, true, expected,
+                   expectedStripCount);
+    TestCheck(outStripCount == expectedStripCount && out.Size() == expected.Size() &&
+                  HashIndices(out) == HashIndices(expected),
+              "A reused stripifier should give the strips of a fresh one");
+}
+
 } // namespace
 
 int main() {
@@ -278,6 +406,9 @@ int main() {
     tf.Run("2x2 grid join=true", &Test_Grid_JoinTrue_PreservesTriangles_NoRestartMarkers);
     tf.Run("2x2 grid join=false", &Test_Grid_JoinFalse_PreservesTriangles);
     tf.Run("DestroyStrips releases stripify allocations", &Test_DestroyStrips_ReleasesStripifyAllocations);
+    tf.Run("Matches previous implementation", &Test_MatchesPreviousImplementation);
+    tf.Run("32-bit indices match 16-bit indices", &Test_Index32MatchesIndex16);
+    tf.Run("Reused stripifier matches fresh stripifier", &Test_StripifierReuseMatchesFreshStripifier);
 
     return tf.ExitCode();
 }
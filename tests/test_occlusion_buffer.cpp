@@ -0,0 +1,149 @@
+#include <math.h>
+#include <stdio.h>
+
+#include "CKOcclusionBuffer.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+const int kBufferSize = 64;
+
+// Camera at the origin looking down +z, 90 degrees field of view, near 1
+void PerspectiveViewProj(VxMatrix &mat) {
+    const float nearPlane = 1.0f;
+    const float farPlane = 1000.0f;
+    const float q = farPlane / (farPlane - nearPlane);
+    Vx3DMatrixIdentity(mat);
+    mat[2][2] = q;
+    mat[2][3] = 1.0f;
+    mat[3][2] = -q * nearPlane;
+    mat[3][3] = 0.0f;
+}
+
+// Square of half size extent facing the camera at depth z
+void AddWall(CKOcclusionBuffer &buffer, float extent, float z) {
+    const VxVector positions[4] = {
+        VxVector(-extent, -extent, z),
+        VxVector(extent, -extent, z),
+        VxVector(extent, extent, z),
+        VxVector(-extent, extent, z),
+    };
+    const CKWORD indices[6] = {0, 1, 2, 0, 2, 3};
+    VxMatrix world;
+    Vx3DMatrixIdentity(world);
+    buffer.AddOccluder(world, (const CKBYTE *) positions, sizeof(VxVector), 4, indices, 6);
+}
+
+VxBbox Box(float x0, float y0, float z0, float x1, float y1, float z1) {
+    return VxBbox(VxVector(x0, y0, z0), VxVector(x1, y1, z1));
+}
+
+void WallHidesBoxesBehindIt() {
+    VxMatrix viewProj;
+    PerspectiveViewProj(viewProj);
+    CKOcclusionBuffer buffer;
+    buffer.Begin(kBufferSize, kBufferSize, viewProj);
+    AddWall(buffer, 5.0f, 10.0f);
+
+    TestCheck(buffer.GetOccluderTriangleCount() == 2, "Both wall triangles should be rasterized");
+    TestCheck(fabsf(buffer.GetInverseDepth(kBufferSize / 2, kBufferSize / 2) - 0.1f) < 1.0e-5f,
+              "Wall pixels should hold 1 / w of the wall");
+    TestCheck(buffer.GetInverseDepth(0, 0) == 0.0f, "Pixels outside the wall should stay empty");
+
+    TestCheck(buffer.IsBoxOccluded(Box(-1.0f, -1.0f, 20.0f, 1.0f, 1.0f, 22.0f)),
+              "A box behind the wall should be occluded");
+    TestCheck(!buffer.IsBoxOccluded(Box(-1.0f, -1.0f, 5.0f, 1.0f, 1.0f, 6.0f)),
+              "A box in front of the wall should stay visible");
+    TestCheck(!buffer.IsBoxOccluded(Box(8.0f, -1.0f, 20.0f, 14.0f, 1.0f, 22.0f)),
+              "A box reaching past the wall edge should stay visible");
+    TestCheck(!buffer.IsBoxOccluded(Box(-1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 30.0f)),
+              "A box crossing the near plane should stay visible");
+    TestCheck(!buffer.IsBoxOccluded(Box(-1.0f, -1.0f, 10.0f, 1.0f, 1.0f, 11.0f)),
+              "A box touching the wall should stay visible");
+
+    TestCheck(buffer.GetTestedBoxCount() == 5, "Every tested box should be counted");
+    TestCheck(buffer.GetOccludedBoxCount() == 1, "Only the box behind the wall is occluded");
+
+    buffer.Begin(kBufferSize, kBufferSize, viewProj);
+    TestCheck(buffer.GetOccluderTriangleCount() == 0 && buffer.GetTestedBoxCount() == 0,
+              "Begin should reset the counters");
+    TestCheck(!buffer.IsBoxOccluded(Box(-1.0f, -1.0f, 20.0f, 1.0f, 1.0f, 22.0f)),
+              "Begin should clear the buffer");
+}
+
+void OccluderDoesNotHideItsOwnBox() {
+    VxMatrix viewProj;
+    PerspectiveViewProj(viewProj);
+    CKOcclusionBuffer buffer;
+    buffer.Begin(kBufferSize, kBufferSize, viewProj);
+
+    // Front and back faces of a slab, both windings
+    const VxVector positions[8] = {
+        VxVector(-3.0f, -3.0f, 10.0f), VxVector(3.0f, -3.0f, 10.0f),
+        VxVector(3.0f, 3.0f, 10.0f),   VxVector(-3.0f, 3.0f, 10.0f),
+        VxVector(-3.0f, -3.0f, 12.0f), VxVector(3.0f, -3.0f, 12.0f),
+        VxVector(3.0f, 3.0f, 12.0f),   VxVector(-3.0f, 3.0f, 12.0f),
+    };
+    const CKDWORD indices[12] = {0, 1, 2, 0, 2, 3, 4, 6, 5, 4, 7, 6};
+    VxMatrix world;
+    Vx3DMatrixIdentity(world);
+    world[3][0] = 0.5f;
+    buffer.AddOccluder(world, (const CKBYTE *) positions, sizeof(VxVector), 8, indices, 12);
+
+    TestCheck(!buffer.IsBoxOccluded(Box(-2.5f, -3.0f, 10.0f, 3.5f, 3.0f, 12.0f)),
+              "The occluder box should not be hidden by the occluder");
+    TestCheck(buffer.IsBoxOccluded(Box(-0.5f, -0.5f, 13.0f, 1.5f, 0.5f, 14.0f)),
+              "A box behind the translated slab should be occluded");
+}
+
+void NearClippedTriangleIsRasterized() {
+    VxMatrix viewProj;
+    PerspectiveViewProj(viewProj);
+    CKOcclusionBuffer buffer;
+    buffer.Begin(kBufferSize, kBufferSize, viewProj);
+
+    // Floor triangle below the camera with a vertex behind it
+    const VxVector positions[3] = {
+        VxVector(-10.0f, -2.0f, 4.0f),
+        VxVector(10.0f, -2.0f, 4.0f),
+        VxVector(0.0f, -2.0f, -4.0f),
+    };
+    const CKWORD indices[3] = {0, 1, 2};
+    VxMatrix world;
+    Vx3DMatrixIdentity(world);
+    buffer.AddOccluder(world, (const CKBYTE *) positions, sizeof(VxVector), 3, indices, 3);
+
+    TestCheck(buffer.GetOccluderTriangleCount() == 2, "The clipped triangle should split in two");
+
+    // Row 60 sees the floor, 2 below the eye, at 1 / w = (60.5 / 32 - 1) / 2
+    const float expected = (60.5f / 32.0f - 1.0f) * 0.5f;
+    TestCheck(fabsf(buffer.GetInverseDepth(kBufferSize / 2, 60) - expected) < 1.0e-4f,
+              "Clipped floor pixels should hold the interpolated 1 / w");
+    TestCheck(buffer.GetInverseDepth(kBufferSize / 2, 20) == 0.0f, "The floor should not reach above the horizon");
+}
+
+void OddBufferWidthsStayInsideTheRows() {
+    VxMatrix viewProj;
+    PerspectiveViewProj(viewProj);
+    CKOcclusionBuffer buffer;
+    buffer.Begin(37, 21, viewProj);
+    AddWall(buffer, 100.0f, 10.0f);
+
+    for (int y = 0; y < buffer.GetHeight(); ++y) {
+        for (int x = 0; x < buffer.GetWidth(); ++x)
+            TestCheck(fabsf(buffer.GetInverseDepth(x, y) - 0.1f) < 1.0e-5f, "A full screen wall covers every pixel");
+    }
+    TestCheck(buffer.IsBoxOccluded(Box(-50.0f, -50.0f, 20.0f, 50.0f, 50.0f, 30.0f)),
+              "A box behind a full screen wall should be occluded");
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("Wall hides boxes behind it", &WallHidesBoxesBehindIt);
+    tests.Run("Occluder does not hide its own box", &OccluderDoesNotHideItsOwnBox);
+    tests.Run("Near clipped triangle is rasterized", &NearClippedTriangleIsRasterized);
+    tests.Run("Odd buffer widths stay inside the rows", &OddBufferWidthsStayInsideTheRows);
+    return tests.ExitCode();
+}
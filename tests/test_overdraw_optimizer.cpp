@@ -0,0 +1,175 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ForsythVertexCacheOptimizer.h"
+#include "OverdrawOptimizer.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+struct TestMesh {
+    XArray<VxVector> positions;
+    XArray<CKWORD> indices;
+};
+
+// Sphere of the given radius with outward faces, appended to the mesh
+void AddSphere(TestMesh &mesh, float radius, int rings, int segments) {
+    const int first = mesh.positions.Size();
+    for (int r = 0; r <= rings; ++r) {
+        const float theta = 3.14159265f * (float) r / (float) rings;
+        for (int s = 0; s < segments; ++s) {
+            const float phi = 2.0f * 3.14159265f * (float) s / (float) segments;
+            mesh.positions.PushBack(VxVector(radius * sinf(theta) * cosf(phi), radius * cosf(theta),
+                                             radius * sinf(theta) * sinf(phi)));
+        }
+    }
+    for (int r = 0; r < rings; ++r) {
+        for (int s = 0; s < segments; ++s) {
+            const int a = first + r * segments + s;
+            const int b = first + r * segments + (s + 1) % segments;
+            const CKWORD quad[6] = {(CKWORD) a, (CKWORD) b, (CKWORD) (a + segments),
+                                    (CKWORD) b, (CKWORD) (b + segments), (CKWORD) (a + segments)};
+            for (int i = 0; i < 6; ++i)
+                mesh.indices.PushBack(quad[i]);
+        }
+    }
+}
+
+// Cube of 2 x 2 cells per side with outward faces
+void BuildCube(TestMesh &mesh) {
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int side = -1; side <= 1; side += 2) {
+            const int first = mesh.positions.Size();
+            const int u = (axis + 1) % 3;
+            const int w = (axis + 2) % 3;
+            for (int j = 0; j <= 2; ++j) {
+                for (int i = 0; i <= 2; ++i) {
+                    VxVector p;
+                    p[axis] = (float) side;
+                    p[u] = (float) i - 1.0f;
+                    p[w] = (float) j - 1.0f;
+                    mesh.positions.PushBack(p);
+                }
+            }
+            for (int j = 0; j < 2; ++j) {
+                for (int i = 0; i < 2; ++i) {
+                    const int a = first + j * 3 + i;
+                    CKWORD quad[6] = {(CKWORD) a, (CKWORD) (a + 1), (CKWORD) (a + 4),
+                                      (CKWORD) a, (CKWORD) (a + 4), (CKWORD) (a + 3)};
+                    if (side < 0) {
+                        XSwap(quad[1], quad[2]);
+                        XSwap(quad[4], quad[5]);
+                    }
+                    for (int k = 0; k < 6; ++k)
+                        mesh.indices.PushBack(quad[k]);
+                }
+            }
+        }
+    }
+}
+
+void CubeIsDrawnOnce() {
+    TestMesh mesh;
+    BuildCube(mesh);
+    OverdrawOptimizer optimizer;
+    const float overdraw = optimizer.ComputeOverdraw(mesh.indices.Begin(), mesh.indices.Size() / 3,
+                                                     mesh.positions.Begin(), sizeof(VxVector), mesh.positions.Size());
+    TestCheck(overdraw == 1.0f, "A convex mesh with back faces culled should shade each pixel once");
+
+    // Flipping the faces shows the inside: the same pixels, still once
+    for (int i = 0; i < mesh.indices.Size(); i += 3)
+        XSwap(mesh.indices[i + 1], mesh.indices[i + 2]);
+    const float inside = optimizer.ComputeOverdraw(mesh.indices.Begin(), mesh.indices.Size() / 3,
+                                                   mesh.positions.Begin(), sizeof(VxVector), mesh.positions.Size());
+    TestCheck(inside == 1.0f, "The inside of a convex mesh should shade each pixel once");
+}
+
+void OuterSurfacesAreDrawnFirst() {
+    // The inner sphere comes first in the cache order, hidden by the outer one
+    TestMesh mesh;
+    AddSphere(mesh, 0.5f, 16, 32);
+    AddSphere(mesh, 1.0f, 16, 32);
+    const int faceCount = mesh.indices.Size() / 3;
+
+    ForsythVertexCacheOptimizer cacheOptimizer;
+    cacheOptimizer.Optimize(mesh.indices.Begin(), faceCount, mesh.positions.Size(), 16, mesh.indices.Begin());
+    const float cacheACMR = cacheOptimizer.ComputeACMR(mesh.indices.Begin(), faceCount, 16);
+
+    OverdrawOptimizer optimizer;
+    const float before = optimizer.ComputeOverdraw(mesh.indices.Begin(), faceCount, mesh.positions.Begin(),
+                                                   sizeof(VxVector), mesh.positions.Size());
+
+    XArray<CKWORD> reordered;
+    reordered.Resize(mesh.indices.Size());
+    optimizer.Optimize(mesh.indices.Begin(), faceCount, mesh.positions.Begin(), sizeof(VxVector),
+                       mesh.positions.Size(), 16, 1.05f, reordered.Begin());
+    const float after = optimizer.ComputeOverdraw(reordered.Begin(), faceCount, mesh.positions.Begin(),
+                                                  sizeof(VxVector), mesh.positions.Size());
+
+    XArray<TestTriCount> input;
+    XArray<TestTriCount> output;
+    for (int f = 0; f < faceCount; ++f) {
+        TestAddTriangle(input, TestMakeTriKey(mesh.indices[f * 3], mesh.indices[f * 3 + 1], mesh.indices[f * 3 + 2]));
+        TestAddTriangle(output, TestMakeTriKey(reordered[f * 3], reordered[f * 3 + 1], reordered[f * 3 + 2]));
+    }
+    TestCheck(TestSameTriangleMultiset(input, output), "The reordered list should hold the input triangles");
+    // The inner sphere covers a quarter of the pixels of the outer one
+    TestCheck(before > 1.2f, "Drawing the inner sphere first should shade its pixels twice");
+    TestCheck(after < 1.05f, "Drawing the outer sphere first should hide the inner one");
+    TestCheck(cacheOptimizer.ComputeACMR(reordered.Begin(), faceCount, 16) <= cacheACMR * 1.1f,
+              "The clusters should stay close to the cache order");
+}
+
+void ThresholdControlsClusterSize() {
+    TestMesh mesh;
+    AddSphere(mesh, 1.0f, 32, 64);
+    const int faceCount = mesh.indices.Size() / 3;
+    ForsythVertexCacheOptimizer cacheOptimizer;
+    cacheOptimizer.Optimize(mesh.indices.Begin(), faceCount, mesh.positions.Size(), 16, mesh.indices.Begin());
+
+    OverdrawOptimizer optimizer;
+    XArray<CKWORD> reordered;
+    reordered.Resize(mesh.indices.Size());
+    int clusterCounts[3];
+    const float thresholds[3] = {0.5f, 1.05f, 3.0f};
+    for (int t = 0; t < 3; ++t) {
+        optimizer.Optimize(mesh.indices.Begin(), faceCount, mesh.positions.Begin(), sizeof(VxVector),
+                           mesh.positions.Size(), 16, thresholds[t], reordered.Begin());
+        clusterCounts[t] = optimizer.GetClusterCount();
+    }
+    TestCheck(clusterCounts[0] <= clusterCounts[1] && clusterCounts[1] < clusterCounts[2],
+              "Higher thresholds should cut smaller clusters");
+    TestCheck(clusterCounts[2] <= faceCount, "Clusters should not be empty");
+}
+
+void WideIndicesAreReordered() {
+    TestMesh mesh;
+    AddSphere(mesh, 0.5f, 8, 16);
+    AddSphere(mesh, 1.0f, 8, 16);
+    const int faceCount = mesh.indices.Size() / 3;
+    XArray<CKDWORD> indices;
+    indices.Resize(mesh.indices.Size());
+    for (int i = 0; i < indices.Size(); ++i)
+        indices[i] = mesh.indices[i];
+
+    OverdrawOptimizer optimizer;
+    const float before = optimizer.ComputeOverdraw(indices.Begin(), faceCount, mesh.positions.Begin(),
+                                                   sizeof(VxVector), mesh.positions.Size());
+    optimizer.Optimize(indices.Begin(), faceCount, mesh.positions.Begin(), sizeof(VxVector), mesh.positions.Size(),
+                       16, 1.05f, indices.Begin());
+    const float after = optimizer.ComputeOverdraw(indices.Begin(), faceCount, mesh.positions.Begin(),
+                                                  sizeof(VxVector), mesh.positions.Size());
+    TestCheck(after < before, "Reordering 32-bit indices in place should lower the overdraw");
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("Cube is drawn once", &CubeIsDrawnOnce);
+    tests.Run("Outer surfaces are drawn first", &OuterSurfacesAreDrawnFirst);
+    tests.Run("Threshold controls cluster size", &ThresholdControlsClusterSize);
+    tests.Run("Wide indices are reordered", &WideIndicesAreReordered);
+    return tests.ExitCode();
+}
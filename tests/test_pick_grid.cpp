@@ -0,0 +1,144 @@
+#include <stdlib.h>
+
+#include "RCKRenderContext.h"
+#include "CKPickGrid.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+float RandomFloat(float minValue, float maxValue) {
+    return minValue + (float) rand() / (float) RAND_MAX * (maxValue - minValue);
+}
+
+// Mostly small rectangles over a 640x480 viewport, some partly or fully
+// outside of it, a few huge ones and a few empty (inverted) extents
+void BuildExtents(XArray<CKObjectExtents> &extents, int count) {
+    extents.Resize(count);
+    for (int i = 0; i < count; ++i) {
+        CKObjectExtents &ext = extents[i];
+        const float x = RandomFloat(-100.0f, 740.0f);
+        const float y = RandomFloat(-100.0f, 580.0f);
+        const float size = (i % 50 == 0) ? RandomFloat(300.0f, 2000.0f) : RandomFloat(2.0f, 60.0f);
+        ext.m_Rect = VxRect(x, y, x + size, y + size * 0.7f);
+        if (i % 97 == 0)
+            ext.m_Rect = VxRect(100000000.0f, 100000000.0f, -100000000.0f, -100000000.0f);
+        // Non-null marker: the grid never dereferences the entity
+        ext.m_Entity = (i % 31 == 0) ? nullptr : (CK3dEntity *) (size_t) (16 * (i + 1));
+        ext.m_Camera = 0;
+    }
+}
+
+bool Contains(const VxRect &rect, const Vx2DVector &pt) {
+    return !(pt.x > rect.right || pt.x < rect.left || pt.y > rect.bottom || pt.y < rect.top);
+}
+
+bool Overlaps(const VxRect &a, const VxRect &b) {
+    return !(a.left > b.right || a.right < b.left || a.top > b.bottom || a.bottom < b.top);
+}
+
+void CheckSameIndices(const XArray<int> &found, const XArray<int> &expected, const char *message) {
+    XArray<int> count;
+    count.Resize(expected.Size() + found.Size() + 4096);
+    for (int i = 0; i < count.Size(); ++i)
+        count[i] = 0;
+    for (int i = 0; i < found.Size(); ++i)
+        ++count[found[i]];
+    bool same = found.Size() == expected.Size();
+    for (int i = 0; i < expected.Size(); ++i)
+        same = same && count[expected[i]] == 1;
+    TestCheck(same, message);
+}
+
+void PointQueryMatchesLinearScan() {
+    srand(21);
+    XArray<CKObjectExtents> extents;
+    BuildExtents(extents, 3000);
+    CKPickGrid grid;
+    grid.Build(extents.Begin(), extents.Size(), VxRect(0.0f, 0.0f, 640.0f, 480.0f));
+    TestCheck(grid.IsBuilt(), "Grid should be built");
+
+    for (int q = 0; q < 400; ++q) {
+        // Include points outside the viewport and exactly on extent borders
+        Vx2DVector pt(RandomFloat(-50.0f, 690.0f), RandomFloat(-50.0f, 530.0f));
+        if (q % 7 == 0 && extents[q].m_Entity)
+            pt = Vx2DVector(extents[q].m_Rect.right, extents[q].m_Rect.top);
+
+        XArray<int> expected;
+        for (int i = 0; i < extents.Size(); ++i) {
+            if (extents[i].m_Entity && Contains(extents[i].m_Rect, pt))
+                expected.PushBack(i);
+        }
+        XArray<int> found;
+        grid.QueryPoint(extents.Begin(), pt, found);
+        CheckSameIndices(found, expected, "Point query differs from the linear scan");
+    }
+}
+
+void RectQueryMatchesLinearScan() {
+    srand(8);
+    XArray<CKObjectExtents> extents;
+    BuildExtents(extents, 2000);
+    CKPickGrid grid;
+    grid.Build(extents.Begin(), extents.Size(), VxRect(0.0f, 0.0f, 640.0f, 480.0f));
+
+    for (int q = 0; q < 200; ++q) {
+        const float x = RandomFloat(-80.0f, 700.0f);
+        const float y = RandomFloat(-80.0f, 540.0f);
+        const VxRect rect(x, y, x + RandomFloat(0.0f, 300.0f), y + RandomFloat(0.0f, 200.0f));
+
+        XArray<int> expected;
+        for (int i = 0; i < extents.Size(); ++i) {
+            if (extents[i].m_Entity && Overlaps(extents[i].m_Rect, rect))
+                expected.PushBack(i);
+        }
+        XArray<int> found;
+        grid.QueryRect(extents.Begin(), rect, found);
+        CheckSameIndices(found, expected, "Rect query differs from the linear scan");
+    }
+}
+
+void DegenerateViewportUsesOneCell() {
+    XArray<CKObjectExtents> extents;
+    BuildExtents(extents, 50);
+    CKPickGrid grid;
+    grid.Build(extents.Begin(), extents.Size(), VxRect(0.0f, 0.0f, 0.0f, 0.0f));
+
+    const Vx2DVector pt(extents[1].m_Rect.left + 1.0f, extents[1].m_Rect.top + 1.0f);
+    XArray<int> found;
+    grid.QueryPoint(extents.Begin(), pt, found);
+    bool hasExtent = false;
+    for (int i = 0; i < found.Size(); ++i)
+        hasExtent = hasExtent || found[i] == 1;
+    TestCheck(hasExtent, "Extent should be found with an empty viewport");
+
+    grid.Invalidate();
+    TestCheck(!grid.IsBuilt(), "Invalidate should require a rebuild");
+}
+
+void CandidatesSortFrontToBack() {
+    XArray<CKPickCandidate> candidates;
+    const float distances[] = {5.0f, 1.0f, 3.0f, 1.0f, 0.0f};
+    const int indices[] = {0, 9, 4, 2, 7};
+    for (int i = 0; i < 5; ++i) {
+        CKPickCandidate candidate;
+        candidate.Distance = distances[i];
+        candidate.Index = indices[i];
+        candidates.PushBack(candidate);
+    }
+    CKPickGrid::SortFrontToBack(candidates);
+
+    const int expected[] = {7, 2, 9, 4, 0};
+    for (int i = 0; i < 5; ++i)
+        TestCheck(candidates[i].Index == expected[i], "Candidates should be sorted by distance, then index");
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("Point query matches linear scan", &PointQueryMatchesLinearScan);
+    tests.Run("Rect query matches linear scan", &RectQueryMatchesLinearScan);
+    tests.Run("Degenerate viewport uses one cell", &DegenerateViewportUsesOneCell);
+    tests.Run("Candidates sort front to back", &CandidatesSortFrontToBack);
+    return tests.ExitCode();
+}
@@ -0,0 +1,179 @@
+#include "CKJobPool.h"
+#include "NearestPointGrid.h"
+#include "PointIndex.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+// Fixed LCG so that the point sets do not depend on the C library
+struct TestRandom {
+    CKDWORD seed;
+
+    explicit TestRandom(CKDWORD s) : seed(s) {}
+
+    float Next() {
+        seed = seed * 1664525u + 1013904223u;
+        return (float) (seed >> 8) / (float) (1 << 24);
+    }
+};
+
+// Clustered points: dense blobs far apart, as the parts of a CAD assembly
+void BuildClusters(XArray<VxVector> &points, int clusterCount, int pointsPerCluster) {
+    TestRandom random(17);
+    for (int c = 0; c < clusterCount; ++c) {
+        const VxVector center(random.Next() * 1000.0f, random.Next() * 1000.0f, random.Next() * 1000.0f);
+        const float size = 0.05f + random.Next() * 2.0f;
+        for (int i = 0; i < pointsPerCluster; ++i)
+            points.PushBack(center + VxVector(random.Next(), random.Next(), random.Next()) * size);
+    }
+}
+
+int BruteNearest(const XArray<VxVector> &points, const VxVector &p, float radius) {
+    int best = -1;
+    float best2 = radius * radius;
+    for (int i = 0; i < points.Size(); ++i) {
+        const VxVector d = points[i] - p;
+        const float distance2 = d.x * d.x + d.y * d.y + d.z * d.z;
+        if (distance2 < best2 || (best < 0 && distance2 == best2)) {
+            best2 = distance2;
+            best = i;
+        }
+    }
+    return best;
+}
+
+void BuildIndex(PointIndex &index, const XArray<VxVector> &points, PointIndex::Mode mode, float cellSize) {
+    index.Clear();
+    index.SetMode(mode);
+    index.SetCellSize(cellSize);
+    for (int i = 0; i < points.Size(); ++i)
+        index.AddPoint(points[i], i);
+    index.Build();
+}
+
+void NearestMatchesBruteForce() {
+    XArray<VxVector> points;
+    BuildClusters(points, 20, 100);
+    TestRandom random(5);
+    const PointIndex::Mode modes[2] = {PointIndex::HASHED_GRID, PointIndex::KD_TREE};
+    for (int m = 0; m < 2; ++m) {
+        PointIndex index;
+        BuildIndex(index, points, modes[m], 0.1f);
+        bool same = true;
+        for (int q = 0; q < 500; ++q) {
+            // Half the queries near a point, half anywhere
+            const VxVector p = (q & 1) ? points[q % points.Size()] + VxVector(random.Next() - 0.5f) * 0.2f
+                                       : VxVector(random.Next(), random.Next(), random.Next()) * 1000.0f;
+            const float radius = (q % 3 == 0) ? 0.05f : (q % 3 == 1) ? 0.3f : 40.0f;
+            same &= index.FindNearest(p, radius) == BruteNearest(points, p, radius);
+        }
+        TestCheck(same, "Nearest points should match a brute force search");
+    }
+}
+
+void RadiusQueriesReturnAllMatches() {
+    XArray<VxVector> points;
+    BuildClusters(points, 10, 200);
+    const PointIndex::Mode modes[2] = {PointIndex::HASHED_GRID, PointIndex::KD_TREE};
+    for (int m = 0; m < 2; ++m) {
+        PointIndex index;
+        BuildIndex(index, points, modes[m], 0.25f);
+        bool same = true;
+        XArray<int> found;
+        for (int q = 0; q < points.Size(); q += 37) {
+            const float radius = (q & 1) ? 0.2f : 1.5f;
+            found.Resize(0);
+            found.PushBack(-7); // Results are appended
+            const int count = index.FindInRadius(points[q], radius, found);
+            int expected = 0;
+            for (int i = 0; i < points.Size(); ++i) {
+                const VxVector d = points[i] - points[q];
+                if (d.x * d.x + d.y * d.y + d.z * d.z <= radius * radius) {
+                    same &= expected + 1 < found.Size() && found[expected + 1] == i;
+                    ++expected;
+                }
+            }
+            same &= count == expected && found.Size() == expected + 1 && found[0] == -7;
+        }
+        TestCheck(same, "Radius queries should return every point within the radius in addition order");
+    }
+}
+
+void TiesGoToFirstPoint() {
+    const PointIndex::Mode modes[2] = {PointIndex::HASHED_GRID, PointIndex::KD_TREE};
+    for (int m = 0; m < 2; ++m) {
+        PointIndex index;
+        index.SetMode(modes[m]);
+        index.SetCellSize(0.5f);
+        for (int i = 0; i < 40; ++i)
+            index.AddPoint(VxVector((i & 1) ? 1.0f : -1.0f, 0.0f, 0.0f), 100 + i);
+        index.Build();
+        TestCheck(index.FindNearest(VxVector(0.0f), 1.0f) == 100, "Equal distances should pick the first point");
+        TestCheck(index.FindNearest(VxVector(0.0f), 0.99f) == -1, "The radius should bound the search");
+    }
+}
+
+void SparseExtentStaysSmall() {
+    // Two points a million cells apart: a dense grid would not fit in memory
+    PointIndex index;
+    index.SetCellSize(0.001f);
+    index.AddPoint(VxVector(0.0f), 1);
+    index.AddPoint(VxVector(1000.0f, 1000.0f, 1000.0f), 2);
+    index.Build();
+    TestCheck(index.FindNearest(VxVector(1000.0f, 1000.0f, 1000.0005f), 0.001f) == 2, "Far cells should be found");
+    TestCheck(index.FindNearest(VxVector(500.0f), 1000.0f) == 1, "Wide queries should scan the occupied cells");
+    TestCheck(index.FindNearest(VxVector(-0.0005f, 0.0f, 0.0f), 0.001f) == 1, "Negative cells should be found");
+}
+
+void BatchedQueriesMatchSingle() {
+    XArray<VxVector> points;
+    BuildClusters(points, 30, 300);
+    XArray<VxVector> queries;
+    TestRandom random(9);
+    for (int i = 0; i < 5000; ++i)
+        queries.PushBack(points[i % points.Size()] + VxVector(random.Next() - 0.5f) * 0.02f);
+
+    PointIndex index;
+    BuildIndex(index, points, PointIndex::HASHED_GRID, 0.02f);
+    XArray<int> expected;
+    for (int i = 0; i < queries.Size(); ++i)
+        expected.PushBack(index.FindNearest(queries[i], 0.01f));
+
+    const int workerCounts[2] = {0, 3};
+    for (int w = 0; w < 2; ++w) {
+        CKJobPool pool;
+        pool.Start(workerCounts[w]);
+        XArray<int> results;
+        results.Resize(queries.Size());
+        index.FindNearest(queries.Begin(), sizeof(VxVector), queries.Size(), 0.01f, results.Begin(), &pool);
+        bool same = true;
+        for (int i = 0; i < queries.Size(); ++i)
+            same &= results[i] == expected[i];
+        TestCheck(same, "Batched queries should match single queries");
+    }
+}
+
+void GridWrapperRebuildsOnAdd() {
+    NearestPointGrid grid;
+    grid.SetGridDimensions(8, 8, 8);
+    grid.SetThreshold(0.5f);
+    grid.AddPoint(VxVector(1.0f, 1.0f, 1.0f), 3);
+    TestCheck(grid.FindNearPoint(VxVector(1.2f, 1.0f, 1.0f)) == 3, "The grid should find its point");
+    grid.AddPoint(VxVector(1.3f, 1.0f, 1.0f), 4);
+    TestCheck(grid.FindNearPoint(VxVector(1.2f, 1.0f, 1.0f)) == 4, "Points added after a query should be found");
+    grid.SetGridDimensions(8, 8, 8);
+    TestCheck(grid.FindNearPoint(VxVector(1.2f, 1.0f, 1.0f)) == -1, "Resizing the grid should clear it");
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("Nearest matches brute force", &NearestMatchesBruteForce);
+    tests.Run("Radius queries return all matches", &RadiusQueriesReturnAllMatches);
+    tests.Run("Ties go to first point", &TiesGoToFirstPoint);
+    tests.Run("Sparse extent stays small", &SparseExtentStaysSmall);
+    tests.Run("Batched queries match single", &BatchedQueriesMatchSingle);
+    tests.Run("Grid wrapper rebuilds on add", &GridWrapperRebuildsOnAdd);
+    return tests.ExitCode();
+}
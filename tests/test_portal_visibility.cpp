@@ -0,0 +1,96 @@
+#include <stdio.h>
+
+#include "CKContext.h"
+#include "RCKPlace.h"
+#include "CKPortalVisibility.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+// Camera at the origin looking down +z, 90 degrees field of view, near 1
+void PerspectiveViewProj(VxMatrix &mat) {
+    const float nearPlane = 1.0f;
+    const float farPlane = 1000.0f;
+    const float q = farPlane / (farPlane - nearPlane);
+    Vx3DMatrixIdentity(mat);
+    mat[2][2] = q;
+    mat[2][3] = 1.0f;
+    mat[3][2] = -q * nearPlane;
+    mat[3][3] = 0.0f;
+}
+
+void SetPortalBox(RCK3dEntity &portal, float x0, float y0, float z0, float x1, float y1, float z1) {
+    const VxBbox box(VxVector(x0, y0, z0), VxVector(x1, y1, z1));
+    portal.SetFlags(CK_3DENTITY_PORTAL);
+    portal.SetBoundingBox(&box, TRUE);
+}
+
+CKPlace *AsPlace(RCKPlace &place) {
+    return (CKPlace *) &place;
+}
+
+void PortalsNarrowThePlacesBehindThem() {
+    CKContext context(nullptr, 0, 0);
+    RCKPlace room(&context), hall(&context), closet(&context), side(&context);
+    RCKPlace open(&context), doorway(&context), behind(&context), unlinked(&context);
+    RCK3dEntity door(&context, nullptr), slit(&context, nullptr), sideDoor(&context, nullptr);
+    RCK3dEntity nearDoor(&context, nullptr), backDoor(&context, nullptr);
+
+    // room -> hall through a door 10 ahead, hall -> closet through a slit
+    // seen inside the door, hall -> side through a door outside of it.
+    // Portals go both ways, so the walk meets every place it came from.
+    SetPortalBox(door, -1.0f, -1.0f, 10.0f, 1.0f, 1.0f, 10.1f);
+    SetPortalBox(slit, 0.5f, -0.5f, 20.0f, 1.5f, 0.5f, 20.1f);
+    SetPortalBox(sideDoor, 30.0f, -1.0f, 20.0f, 32.0f, 1.0f, 20.1f);
+    SetPortalBox(nearDoor, -1.0f, -1.0f, -0.5f, 1.0f, 1.0f, 2.0f);
+    SetPortalBox(backDoor, -1.0f, -1.0f, -10.0f, 1.0f, 1.0f, -9.0f);
+    room.AddPortal(AsPlace(hall), &door);
+    hall.AddPortal(AsPlace(closet), &slit);
+    hall.AddPortal(AsPlace(side), &sideDoor);
+    room.AddPortal(AsPlace(open), nullptr);
+    room.AddPortal(AsPlace(doorway), &nearDoor);
+    room.AddPortal(AsPlace(behind), &backDoor);
+
+    VxMatrix viewProj;
+    PerspectiveViewProj(viewProj);
+    CKPortalVisibility visibility;
+    visibility.Compute(AsPlace(room), viewProj);
+
+    VxRect rect;
+    TestCheck(visibility.GetPlaceRect(AsPlace(room), rect), "The camera place is visible");
+    TestCheck(rect.left == 0.0f && rect.top == 0.0f && rect.right == 1.0f && rect.bottom == 1.0f,
+              "The camera place sees the whole viewport");
+
+    VxRect hallRect;
+    TestCheck(visibility.GetPlaceRect(AsPlace(hall), hallRect), "The place behind the door is visible");
+    TestCheck(hallRect.left > 0.44f && hallRect.right < 0.56f && hallRect.top > 0.44f && hallRect.bottom < 0.56f,
+              "The place behind the door is seen through the door only");
+
+    VxRect closetRect;
+    TestCheck(visibility.GetPlaceRect(AsPlace(closet), closetRect), "The place behind the slit is visible");
+    TestCheck(closetRect.left > 0.5f && closetRect.right <= hallRect.right && closetRect.top >= hallRect.top,
+              "The slit narrows the door rectangle");
+
+    TestCheck(!visibility.GetPlaceRect(AsPlace(side), rect), "A door outside the door rectangle hides its place");
+    TestCheck(!visibility.GetPlaceRect(AsPlace(behind), rect), "A door behind the camera hides its place");
+    TestCheck(!visibility.GetPlaceRect(AsPlace(unlinked), rect), "A place without portals is not visible");
+
+    TestCheck(visibility.GetPlaceRect(AsPlace(open), rect), "A portal without geometry shows its place");
+    TestCheck(rect.right - rect.left == 1.0f, "A portal without geometry does not narrow the view");
+    TestCheck(visibility.GetPlaceRect(AsPlace(doorway), rect), "A door crossing the near plane shows its place");
+    TestCheck(rect.right - rect.left == 1.0f, "A door crossing the near plane does not narrow the view");
+
+    TestCheck(visibility.GetVisiblePlaceCount() == 5, "Only the reached places are listed");
+
+    visibility.Compute(nullptr, viewProj);
+    TestCheck(visibility.GetVisiblePlaceCount() == 0 && !visibility.GetPlaceRect(AsPlace(room), rect),
+              "Computing without a camera place clears the places");
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("Portals narrow the places behind them", &PortalsNarrowThePlacesBehindThem);
+    return tests.ExitCode();
+}
@@ -0,0 +1,417 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "CKRasterizerSIMD.h"
+#include "CKNullRasterizer.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+const char *const kLevelNames[] = {"generic", "SSE2", "AVX"};
+
+float RandomFloat(float range) {
+    return ((float) rand() / (float) RAND_MAX * 2.0f - 1.0f) * range;
+}
+
+// Perspective projection (near 1, far 100) of a camera moved back along z,
+// so the random points below land inside, outside and behind the frustum
+void BuildViewProj(VxMatrix &mat) {
+    Vx3DMatrixIdentity(mat);
+    const float q = 100.0f / 99.0f;
+    mat[0][0] = 0.75f;
+    mat[2][2] = q;
+    mat[2][3] = 1.0f;
+    mat[3][2] = -q + 5.0f * q;
+    mat[3][3] = 5.0f;
+}
+
+// Positions inside vertices with a stride of 32 bytes and tightly packed
+struct StridedVertex {
+    VxVector Position;
+    float Extra[5];
+};
+
+void SIMDTransformMatchesGeneric() {
+    // Counts around the 4 and 8 vertex blocks exercise the scalar tails
+    const int counts[] = {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 100, 1001};
+    VxMatrix mat;
+    BuildViewProj(mat);
+    const int levels = (int) GetRasterizerSIMDLevel();
+
+    for (int c = 0; c < (int) (sizeof(counts) / sizeof(counts[0])); ++c) {
+        const int count = counts[c];
+        srand(77 + count);
+        XArray<StridedVertex> wide;
+        XArray<VxVector> packed;
+        wide.Resize(count);
+        packed.Resize(count);
+        for (int i = 0; i < count; ++i) {
+            packed[i].Set(RandomFloat(12.0f), RandomFloat(12.0f), RandomFloat(12.0f));
+            wide[i].Position = packed[i];
+        }
+
+        XArray<VxVector4> reference, referenceScreen;
+        XArray<CKDWORD> referenceFlags;
+        reference.Resize(count);
+        referenceScreen.Resize(count);
+        referenceFlags.Resize(count);
+        const CKDWORD referenceAnd = CKRstTransformVertices(CKRST_SIMD_NONE, mat, packed.Begin(), sizeof(VxVector),
+                                                           reference.Begin(), sizeof(VxVector4),
+                                                           referenceFlags.Begin(), count);
+        CKRstProjectVertices(CKRST_SIMD_NONE, reference.Begin(), sizeof(VxVector4), referenceScreen.Begin(),
+                             sizeof(VxVector4), count, 160.0f, 120.0f, 160.0f, -120.0f);
+
+        CKDWORD expectedAnd = 0xFFFFFFFF;
+        for (int i = 0; i < count; ++i)
+            expectedAnd &= referenceFlags[i];
+        TestCheck(count == 0 || referenceAnd == expectedAnd,
+                  "The generic transform should return the AND of the clip flags");
+
+        for (int level = CKRST_SIMD_SSE2; level <= levels; ++level) {
+            for (int layout = 0; layout < 2; ++layout) {
+                XArray<VxVector4> out, screen;
+                XArray<CKDWORD> flags;
+                out.Resize(count);
+                screen.Resize(count);
+                flags.Resize(count);
+                const void *in = layout ? (const void *) wide.Begin() : (const void *) packed.Begin();
+                const CKDWORD stride = layout ? sizeof(StridedVertex) : sizeof(VxVector);
+                const CKDWORD andFlags = CKRstTransformVertices((CKRST_SIMD) level, mat, in, stride, out.Begin(),
+                                                                sizeof(VxVector4), flags.Begin(), count);
+                CKRstProjectVertices((CKRST_SIMD) level, out.Begin(), sizeof(VxVector4), screen.Begin(),
+                                     sizeof(VxVector4), count, 160.0f, 120.0f, 160.0f, -120.0f);
+
+                TestCheck(andFlags == referenceAnd, kLevelNames[level]);
+                TestCheck(count == 0 || memcmp(out.Begin(), reference.Begin(), count * sizeof(VxVector4)) == 0,
+                          "Clip coordinates differ from the generic version");
+                TestCheck(count == 0 || memcmp(flags.Begin(), referenceFlags.Begin(), count * sizeof(CKDWORD)) == 0,
+                          "Clip flags differ from the generic version");
+                TestCheck(count == 0 || memcmp(screen.Begin(), referenceScreen.Begin(), count * sizeof(VxVector4)) == 0,
+                          "Screen coordinates differ from the generic version");
+
+                XArray<VxVector4> unflagged;
+                unflagged.Resize(count);
+                TestCheck(CKRstTransformVertices((CKRST_SIMD) level, mat, in, stride, unflagged.Begin(),
+                                                 sizeof(VxVector4), NULL, count) == 0,
+                          "No clip flags were asked for");
+                TestCheck(count == 0 || memcmp(unflagged.Begin(), reference.Begin(), count * sizeof(VxVector4)) == 0,
+                          "Clip coordinates depend on the clip flags");
+            }
+        }
+    }
+}
+
+void ClipFlagsFollowTheClipVolume() {
+    VxMatrix identity;
+    Vx3DMatrixIdentity(identity);
+    const VxVector points[6] = {
+        VxVector(0.0f, 0.0f, 0.5f),  // inside
+        VxVector(-2.0f, 0.0f, 0.5f), // left
+        VxVector(2.0f, 3.0f, 0.5f),  // right and top
+        VxVector(0.0f, -2.0f, 0.5f), // bottom
+        VxVector(0.0f, 0.0f, -0.5f), // front
+        VxVector(0.0f, 0.0f, 1.5f),  // back
+    };
+    const CKDWORD expected[6] = {0, VXCLIP_LEFT, VXCLIP_RIGHT | VXCLIP_TOP, VXCLIP_BOTTOM, VXCLIP_FRONT, VXCLIP_BACK};
+    VxVector4 out[6];
+    CKDWORD flags[6];
+    for (int level = CKRST_SIMD_NONE; level <= (int) GetRasterizerSIMDLevel(); ++level) {
+        // Eight copies of each point so the SIMD levels use their blocks
+        for (int i = 0; i < 6; ++i) {
+            VxVector block[8];
+            VxVector4 blockOut[8];
+            CKDWORD blockFlags[8];
+            for (int k = 0; k < 8; ++k)
+                block[k] = points[i];
+            const CKDWORD andFlags = CKRstTransformVertices((CKRST_SIMD) level, identity, block, sizeof(VxVector),
+                                                            blockOut, sizeof(VxVector4), blockFlags, 8);
+            for (int k = 0; k < 8; ++k)
+                TestCheck(blockFlags[k] == expected[i], "Wrong clip flags");
+            TestCheck(andFlags == expected[i], "Wrong AND of the clip flags");
+            out[i] = blockOut[0];
+            flags[i] = blockFlags[0];
+        }
+        TestCheck(out[2].w == 1.0f && flags[0] == 0, "Positions are transformed with w = 1");
+    }
+}
+
+void SIMDBoxFlagsMatchGeneric() {
+    VxMatrix mat;
+    BuildViewProj(mat);
+    srand(5);
+    XArray<VxBbox> boxes;
+    boxes.Resize(333);
+    for (int i = 0; i < boxes.Size(); ++i) {
+        const VxVector center(RandomFloat(15.0f), RandomFloat(15.0f), RandomFloat(15.0f));
+        const VxVector half(fabsf(RandomFloat(3.0f)), fabsf(RandomFloat(3.0f)), fabsf(RandomFloat(3.0f)));
+        boxes[i] = VxBbox(center - half, center + half);
+    }
+
+    XArray<CKDWORD> referenceOr, referenceAnd;
+    referenceOr.Resize(boxes.Size());
+    referenceAnd.Resize(boxes.Size());
+    CKRstComputeBoxesClipFlags(CKRST_SIMD_NONE, mat, boxes.Begin(), boxes.Size(), referenceOr.Begin(),
+                               referenceAnd.Begin());
+
+    int offscreen = 0, crossing = 0;
+    for (int i = 0; i < boxes.Size(); ++i) {
+        if (referenceAnd[i] & VXCLIP_ALL)
+            ++offscreen;
+        else if (referenceOr[i] & VXCLIP_ALL)
+            ++crossing;
+    }
+    TestCheck(offscreen > 0 && crossing > 0 && offscreen + crossing < boxes.Size(),
+              "The boxes should be off screen, crossing and inside the view");
+
+    for (int level = CKRST_SIMD_SSE2; level <= (int) GetRasterizerSIMDLevel(); ++level) {
+        XArray<CKDWORD> orFlags, andFlags;
+        orFlags.Resize(boxes.Size());
+        andFlags.Resize(boxes.Size());
+        CKRstComputeBoxesClipFlags((CKRST_SIMD) level, mat, boxes.Begin(), boxes.Size(), orFlags.Begin(),
+                                   andFlags.Begin());
+        TestCheck(memcmp(orFlags.Begin(), referenceOr.Begin(), boxes.Size() * sizeof(CKDWORD)) == 0,
+                  "Box OR flags differ from the generic version");
+        TestCheck(memcmp(andFlags.Begin(), referenceAnd.Begin(), boxes.Size() * sizeof(CKDWORD)) == 0,
+                  "Box AND flags differ from the generic version");
+    }
+}
+
+// Source arrays laid out like a mesh: positions, normals and the first
+// texture coordinates in a VxVertex, colors and other stages in their arrays
+struct MeshVertex {
+    VxVector m_Position;
+    VxVector m_Normal;
+    Vx2DVector m_UV;
+};
+
+struct LoadSources {
+    XArray<MeshVertex> vertices;
+    XArray<VxVector4> rasterPositions;
+    XArray<CKDWORD> colors;
+    XArray<CKDWORD> speculars;
+    XArray<Vx2DVector> texCoords[CKRST_MAX_STAGES - 1];
+};
+
+void BuildLoadSources(LoadSources &sources, int count) {
+    sources.vertices.Resize(count);
+    sources.rasterPositions.Resize(count);
+    sources.colors.Resize(count);
+    sources.speculars.Resize(count);
+    for (int t = 0; t < CKRST_MAX_STAGES - 1; ++t)
+        sources.texCoords[t].Resize(count);
+    for (int i = 0; i < count; ++i) {
+        MeshVertex &v = sources.vertices[i];
+        v.m_Position.Set(RandomFloat(10.0f), RandomFloat(10.0f), RandomFloat(10.0f));
+        v.m_Normal.Set(RandomFloat(1.0f), RandomFloat(1.0f), RandomFloat(1.0f));
+        v.m_UV = Vx2DVector(RandomFloat(1.0f), RandomFloat(1.0f));
+        sources.rasterPositions[i] = VxVector4(RandomFloat(320.0f), RandomFloat(240.0f), RandomFloat(1.0f), 1.0f);
+        sources.colors[i] = (CKDWORD) rand() * 65599u;
+        sources.speculars[i] = (CKDWORD) rand() * 31u;
+        for (int t = 0; t < CKRST_MAX_STAGES - 1; ++t)
+            sources.texCoords[t][i] = Vx2DVector(RandomFloat(1.0f), RandomFloat(1.0f));
+    }
+}
+
+void SetupLoadData(VxDrawPrimitiveData &data, LoadSources &sources, CKDWORD format, int count, CKBOOL colors) {
+    memset(&data, 0, sizeof(data));
+    data.VertexCount = count;
+    if (format & CKRST_VF_RASTERPOS) {
+        data.PositionPtr = sources.rasterPositions.Begin();
+        data.PositionStride = sizeof(VxVector4);
+    } else {
+        data.PositionPtr = &sources.vertices.Begin()->m_Position;
+        data.PositionStride = sizeof(MeshVertex);
+    }
+    data.NormalPtr = &sources.vertices.Begin()->m_Normal;
+    data.NormalStride = sizeof(MeshVertex);
+    if (colors) {
+        data.ColorPtr = sources.colors.Begin();
+        data.ColorStride = sizeof(CKDWORD);
+        data.SpecularColorPtr = sources.speculars.Begin();
+        data.SpecularColorStride = sizeof(CKDWORD);
+    }
+    data.TexCoordPtr = &sources.vertices.Begin()->m_UV;
+    data.TexCoordStride = sizeof(MeshVertex);
+    for (int t = 0; t < CKRST_MAX_STAGES - 1; ++t) {
+        data.TexCoordPtrs[t] = sources.texCoords[t].Begin();
+        data.TexCoordStrides[t] = sizeof(Vx2DVector);
+    }
+}
+
+// One attribute at a time, as CKRSTLoadVertexBuffer does for other formats
+void LoadVerticesReference(CKBYTE *mem, CKDWORD format, CKDWORD vertexSize, const VxDrawPrimitiveData &data) {
+    const CKDWORD white = 0xFFFFFFFF;
+    const CKDWORD black = 0;
+    for (int v = 0; v < data.VertexCount; ++v) {
+        CKBYTE *dst = mem + v * vertexSize;
+        const int positionSize = (format & CKRST_VF_RASTERPOS) ? 16 : 12;
+        memcpy(dst, (const CKBYTE *) data.PositionPtr + v * data.PositionStride, positionSize);
+        dst += positionSize;
+        if (format & CKRST_VF_NORMAL) {
+            memcpy(dst, (const CKBYTE *) data.NormalPtr + v * data.NormalStride, 12);
+            dst += 12;
+        }
+        if (format & CKRST_VF_DIFFUSE) {
+            memcpy(dst, data.ColorPtr ? (const CKBYTE *) data.ColorPtr + v * data.ColorStride
+                                      : (const CKBYTE *) &white, 4);
+            dst += 4;
+        }
+        if (format & CKRST_VF_SPECULAR) {
+            memcpy(dst, data.SpecularColorPtr ? (const CKBYTE *) data.SpecularColorPtr + v * data.SpecularColorStride
+                                              : (const CKBYTE *) &black, 4);
+            dst += 4;
+        }
+        for (CKDWORD t = 0; t < CKRST_VF_GETTEXCOUNT(format); ++t) {
+            const CKBYTE *uv = t ? (const CKBYTE *) data.TexCoordPtrs[t - 1] + v * data.TexCoordStrides[t - 1]
+                                 : (const CKBYTE *) data.TexCoordPtr + v * data.TexCoordStride;
+            memcpy(dst, uv, 8);
+            dst += 8;
+        }
+    }
+}
+
+CKDWORD PackedVertexSize(CKDWORD format) {
+    CKDWORD size = (format & CKRST_VF_RASTERPOS) ? 16 : 12;
+    if (format & CKRST_VF_NORMAL)
+        size += 12;
+    if (format & CKRST_VF_DIFFUSE)
+        size += 4;
+    if (format & CKRST_VF_SPECULAR)
+        size += 4;
+    return size + 8 * CKRST_VF_GETTEXCOUNT(format);
+}
+
+// 16 byte aligned memory, so large buffers take the streaming kernels
+CKBYTE *AlignedBuffer(XArray<CKBYTE> &storage, int size) {
+    storage.Resize(size + 16);
+    CKBYTE *mem = storage.Begin() + ((16 - ((size_t) storage.Begin() & 15)) & 15);
+    memset(mem, 0xCD, size);
+    return mem;
+}
+
+void LoadedVerticesMatchAttributeCopies() {
+    // The vertex formats CKRSTGetVertexFormat returns
+    const CKDWORD formats[] = {
+        CKRST_VF_POSITION | CKRST_VF_NORMAL,
+        CKRST_VF_POSITION,
+        CKRST_VF_POSITION | CKRST_VF_DIFFUSE,
+        CKRST_VF_POSITION | CKRST_VF_SPECULAR,
+        CKRST_VF_POSITION | CKRST_VF_DIFFUSE | CKRST_VF_SPECULAR,
+        CKRST_VF_RASTERPOS,
+        CKRST_VF_RASTERPOS | CKRST_VF_DIFFUSE,
+        CKRST_VF_RASTERPOS | CKRST_VF_SPECULAR,
+        CKRST_VF_RASTERPOS | CKRST_VF_DIFFUSE | CKRST_VF_SPECULAR,
+    };
+    const int counts[] = {1, 3, 4, 5, 9, 2001};
+
+    for (int c = 0; c < (int) (sizeof(counts) / sizeof(counts[0])); ++c) {
+        srand(11 + counts[c]);
+        LoadSources sources;
+        BuildLoadSources(sources, counts[c]);
+        for (int f = 0; f < (int) (sizeof(formats) / sizeof(formats[0])); ++f) {
+            for (int tex = 0; tex <= CKRST_MAX_STAGES; ++tex) {
+                const CKDWORD format = formats[f] | CKRST_VF_TEXCOUNT(tex);
+                const CKDWORD vertexSize = PackedVertexSize(format);
+                const int size = counts[c] * vertexSize;
+                for (int colors = 0; colors < 2; ++colors) {
+                    VxDrawPrimitiveData data;
+                    SetupLoadData(data, sources, format, counts[c], colors);
+                    XArray<CKBYTE> referenceStorage;
+                    CKBYTE *reference = AlignedBuffer(referenceStorage, size);
+                    LoadVerticesReference(reference, format, vertexSize, data);
+
+                    for (int level = CKRST_SIMD_NONE; level <= (int) GetRasterizerSIMDLevel(); ++level) {
+                        XArray<CKBYTE> storage;
+                        CKBYTE *mem = AlignedBuffer(storage, size);
+                        TestCheck(CKRstLoadVertices((CKRST_SIMD) level, mem, format, vertexSize, &data),
+                                  "The vertex formats of CKRSTGetVertexFormat have a kernel");
+                        TestCheck(memcmp(mem, reference, size) == 0, "Loaded vertices differ from attribute copies");
+                    }
+                }
+            }
+        }
+    }
+}
+
+void UnusualVertexFormatsAreLeftToAttributeCopies() {
+    LoadSources sources;
+    BuildLoadSources(sources, 8);
+    VxDrawPrimitiveData data;
+    CKBYTE mem[8 * 64];
+    memset(mem, 0xCD, sizeof(mem));
+
+    const CKDWORD vertex = CKRST_VF_POSITION | CKRST_VF_NORMAL | CKRST_VF_TEX1;
+    SetupLoadData(data, sources, vertex, 8, TRUE);
+    TestCheck(!CKRstLoadVertices(CKRST_SIMD_NONE, mem, vertex, 36, &data), "Padded vertices are not handled");
+    TestCheck(!CKRstLoadVertices(CKRST_SIMD_NONE, mem, CKRST_VF_POSITION1W | CKRST_VF_TEX1, 24, &data),
+              "Vertex weights are not handled");
+    TestCheck(!CKRstLoadVertices(CKRST_SIMD_NONE, mem, CKRST_VF_POSITION | CKRST_VF_PSIZE, 16, &data),
+              "Point sizes are not handled");
+    TestCheck(!CKRstLoadVertices(CKRST_SIMD_NONE, mem, CKRST_VF_POSITION | CKRST_VF_TEX1 | CKRST_VF_TEX0_3FLOAT, 24,
+                                 &data),
+              "Texture coordinate sizes are not handled");
+    TestCheck(!CKRstLoadVertices(CKRST_SIMD_NONE, mem, CKRST_VF_POSITION | CKRST_VF_NORMAL | CKRST_VF_DIFFUSE, 28,
+                                 &data),
+              "Normals with colors are not handled");
+
+    data.NormalPtr = NULL;
+    TestCheck(!CKRstLoadVertices(CKRST_SIMD_NONE, mem, vertex, 32, &data), "Missing normals are not handled");
+    data.NormalPtr = &sources.vertices.Begin()->m_Normal;
+    data.TexCoordPtrs[0] = NULL;
+    TestCheck(!CKRstLoadVertices(CKRST_SIMD_NONE, mem, CKRST_VF_POSITION | CKRST_VF_TEX2, 28, &data),
+              "Missing texture coordinates are not handled");
+
+    for (int i = 0; i < (int) sizeof(mem); ++i)
+        TestCheck(mem[i] == 0xCD, "Formats without a kernel leave the vertex buffer alone");
+}
+
+void BatchedBoxVisibilityMatchesSingleBoxes() {
+    CKRasterizer *rst = CKNullRasterizerStart(NULL);
+    TestCheck(rst != NULL, "Null rasterizer failed to start");
+    CKRasterizerContext *ctx = rst->GetDriver(0)->CreateContext();
+    TestCheck(ctx->Create(NULL, 0, 0, 320, 240), "Null context creation failed");
+
+    VxMatrix proj, view, world;
+    BuildViewProj(proj);
+    Vx3DMatrixIdentity(view);
+    view[3][0] = 2.0f;
+    Vx3DMatrixIdentity(world);
+    world[3][1] = -1.0f;
+    ctx->SetTransformMatrix(VXMATRIX_PROJECTION, proj);
+    ctx->SetTransformMatrix(VXMATRIX_VIEW, view);
+    ctx->SetTransformMatrix(VXMATRIX_WORLD, world);
+
+    srand(9);
+    XArray<VxBbox> boxes;
+    boxes.Resize(150);
+    for (int i = 0; i < boxes.Size(); ++i) {
+        const VxVector center(RandomFloat(15.0f), RandomFloat(15.0f), RandomFloat(15.0f));
+        const VxVector half(fabsf(RandomFloat(3.0f)), fabsf(RandomFloat(3.0f)), fabsf(RandomFloat(3.0f)));
+        boxes[i] = VxBbox(center - half, center + half);
+    }
+
+    XArray<CKDWORD> results;
+    results.Resize(boxes.Size());
+    for (int inWorld = 0; inWorld < 2; ++inWorld) {
+        ctx->ComputeBoxVisibility(boxes.Size(), boxes.Begin(), results.Begin(), inWorld);
+        for (int i = 0; i < boxes.Size(); ++i)
+            TestCheck(results[i] == ctx->ComputeBoxVisibility(boxes[i], inWorld, NULL),
+                      "Batched visibility differs from the single box test");
+    }
+
+    rst->GetDriver(0)->DestroyContext(ctx);
+    CKNullRasterizerClose(rst);
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("SIMD transform matches generic", &SIMDTransformMatchesGeneric);
+    tests.Run("Clip flags follow the clip volume", &ClipFlagsFollowTheClipVolume);
+    tests.Run("SIMD box flags match generic", &SIMDBoxFlagsMatchGeneric);
+    tests.Run("Loaded vertices match attribute copies", &LoadedVerticesMatchAttributeCopies);
+    tests.Run("Unusual vertex formats are left to attribute copies", &UnusualVertexFormatsAreLeftToAttributeCopies);
+    tests.Run("Batched box visibility matches single boxes", &BatchedBoxVisibilityMatchesSingleBoxes);
+    return tests.ExitCode();
+}
@@ -1,8 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 
-#include "CKSceneGraph.h"
+#include "CKContext.h"
+#include "CKJobPool.h"
+#include "CKNullRasterizer.h"
+#include "CKSceneGraphBVH.h"
+#include "RCK3dEntity.h"
 #include "TestTriangleMultiset.h"
 
 namespace {
@@ -33,11 +38,409 @@ void TransparentObjectLayoutMatchesOriginalDllOffsets() {
 #endif
 }
 
+struct TransparentOrderStats {
+    int classifyCalls;
+};
+
+// Orders overlapping objects by the center of their depth range, farthest first.
+int ClassifyByDepthCenter(const CKTransparentObject &a, const CKTransparentObject &b, void *arg) {
+    ++((TransparentOrderStats *) arg)->classifyCalls;
+    const float ca = a.m_ZhMin + a.m_ZhMax;
+    const float cb = b.m_ZhMin + b.m_ZhMax;
+    if (ca > cb)
+        return 1;
+    if (ca < cb)
+        return -1;
+    return 0;
+}
+
+CKDWORD NextRandom(CKDWORD &state) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+void RadixTransparentSortMatchesLegacyOrder() {
+    const int count = 4000;
+
+    XClassArray<CKSceneGraphNode> nodes;
+    nodes.Resize(count);
+
+    XClassArray<CKTransparentObject> legacy;
+    legacy.Resize(count);
+
+    CKDWORD seed = 12345u;
+    for (int i = 0; i < count; ++i) {
+        // A few priority bands, distinct depth centers and extents wide enough to overlap neighbours.
+        nodes[i].m_MaxPriority = (short) (10000 + (int) (NextRandom(seed) % 3));
+
+        const float center = (float) i * 0.25f + (float) (NextRandom(seed) % 100) * 0.001f;
+        const float halfExtent = 0.01f + (float) (NextRandom(seed) % 1000) * 0.0005f;
+
+        legacy[i].m_Node = &nodes[i];
+        legacy[i].m_ZhMin = center - halfExtent;
+        legacy[i].m_ZhMax = center + halfExtent;
+    }
+
+    // Shuffle so both sorts start from an arbitrary previous-frame order.
+    for (int i = count - 1; i > 0; --i) {
+        const int j = (int) (NextRandom(seed) % (CKDWORD) (i + 1));
+        CKTransparentObject tmp = legacy[i];
+        legacy[i] = legacy[j];
+        legacy[j] = tmp;
+    }
+
+    XClassArray<CKTransparentObject> sorted = legacy;
+
+    TransparentOrderStats legacyStats = {0};
+    CKTransparentSorter::SortLegacy(legacy.Begin(), legacy.End(), &ClassifyByDepthCenter, &legacyStats);
+
+    TransparentOrderStats radixStats = {0};
+    CKTransparentSorter sorter;
+    sorter.Sort(sorted, &ClassifyByDepthCenter, &radixStats);
+
+    TestCheck(sorted.Size() == count, "Radix sort must keep every transparent object");
+    for (int i = 0; i < count; ++i)
+        TestCheck(sorted[i].m_Node == legacy[i].m_Node, "Radix sort order differs from the legacy bubble sort");
+
+    TestCheck(sorter.GetOverlapClusterCount() > 0, "Test data should contain overlapping depth ranges");
+    TestCheck(radixStats.classifyCalls < legacyStats.classifyCalls,
+              "Tie-breaker should only run inside overlap clusters");
+
+    // Sorting an already ordered list again must be stable.
+    sorter.Sort(sorted, &ClassifyByDepthCenter, &radixStats);
+    for (int i = 0; i < count; ++i)
+        TestCheck(sorted[i].m_Node == legacy[i].m_Node, "Re-sorting an ordered list changed the order");
+}
+
+struct NonTransitiveOrder {
+    const CKSceneGraphNode *nodes;
+    int classifyCalls;
+};
+
+// Orders each overlapping pair from a hash of the two nodes: a third of the
+// pairs undecided, the others either way. Antisymmetric but full of cycles
+// (a before b before c before a).
+int ClassifyByPairHash(const CKTransparentObject &a, const CKTransparentObject &b, void *arg) {
+    NonTransitiveOrder *order = (NonTransitiveOrder *) arg;
+    ++order->classifyCalls;
+    const CKDWORD ia = (CKDWORD) (a.m_Node - order->nodes);
+    const CKDWORD ib = (CKDWORD) (b.m_Node - order->nodes);
+    const CKDWORD low = (ia < ib) ? ia : ib;
+    const CKDWORD high = (ia < ib) ? ib : ia;
+    CKDWORD hash = low * 2654435761u ^ high * 40503u;
+    hash ^= hash >> 13;
+    switch ((hash * 2246822519u >> 16) % 3) {
+    case 0:
+        return 0;
+    case 1:
+        return (ia == low) ? 1 : -1;
+    default:
+        return (ia == low) ? -1 : 1;
+    }
+}
+
+void RadixTransparentSortMatchesLegacyWithCycles() {
+    const int count = 3000;
+
+    XClassArray<CKSceneGraphNode> nodes;
+    nodes.Resize(count);
+    XClassArray<CKTransparentObject> legacy;
+    legacy.Resize(count);
+
+    // Clusters of 1 to 12 objects around spaced depths, their ranges
+    // overlapping inside a cluster, some of them chained through a single
+    // overlap. A few share their ZhMin so that the epsilon fallback runs.
+    CKDWORD seed = 777u;
+    int i = 0;
+    float depth = 0.0f;
+    while (i < count) {
+        const int size = 1 + (int) (NextRandom(seed) % 12);
+        const short priority = (short) (NextRandom(seed) % 2);
+        for (int c = 0; c < size && i < count; ++c, ++i) {
+            const float zMin = depth + (float) (NextRandom(seed) % 100) * 0.01f;
+            nodes[i].m_MaxPriority = priority;
+            legacy[i].m_Node = &nodes[i];
+            legacy[i].m_ZhMin = (c == 3) ? legacy[i - 1].m_ZhMin : zMin;
+            legacy[i].m_ZhMax = zMin + 0.5f + (float) (NextRandom(seed) % 100) * 0.01f;
+        }
+        depth += 3.0f;
+    }
+
+    for (int j = count - 1; j > 0; --j) {
+        const int k = (int) (NextRandom(seed) % (CKDWORD) (j + 1));
+        CKTransparentObject tmp = legacy[j];
+        legacy[j] = legacy[k];
+        legacy[k] = tmp;
+    }
+
+    XClassArray<CKTransparentObject> sorted = legacy;
+
+    NonTransitiveOrder legacyOrder = {nodes.Begin(), 0};
+    CKTransparentSorter::SortLegacy(legacy.Begin(), legacy.End(), &ClassifyByPairHash, &legacyOrder);
+
+    NonTransitiveOrder radixOrder = {nodes.Begin(), 0};
+    CKTransparentSorter sorter;
+    sorter.Sort(sorted, &ClassifyByPairHash, &radixOrder);
+
+    TestCheck(sorter.GetOverlapClusterCount() > 100, "Test data should contain many overlap clusters");
+    TestCheck(radixOrder.classifyCalls < legacyOrder.classifyCalls,
+              "Tie-breaker should only run inside overlap clusters");
+    bool same = sorted.Size() == count;
+    for (int j = 0; same && j < count; ++j)
+        same = sorted[j].m_Node == legacy[j].m_Node;
+    TestCheck(same, "Radix sort order differs from the legacy bubble sort with a non-transitive classifier");
+
+    // Same input as the previous frame order: still the legacy result
+    XClassArray<CKTransparentObject> again = legacy;
+    CKTransparentSorter::SortLegacy(legacy.Begin(), legacy.End(), &ClassifyByPairHash, &legacyOrder);
+    sorter.Sort(again, &ClassifyByPairHash, &radixOrder);
+    same = true;
+    for (int j = 0; same && j < count; ++j)
+        same = again[j].m_Node == legacy[j].m_Node;
+    TestCheck(same, "Re-sorting with cycles differs from the legacy bubble sort");
+}
+
+float RandomFloat(CKDWORD &state, float range) {
+    return ((float) (NextRandom(state) & 0xFFFF) / 65535.0f * 2.0f - 1.0f) * range;
+}
+
+void MoveEntity(RCK3dEntity *entity, CKDWORD &state) {
+    VxMatrix mat;
+    VxVector axis(RandomFloat(state, 1.0f), RandomFloat(state, 1.0f), 2.0f);
+    axis.Normalize();
+    Vx3DMatrixFromRotation(mat, axis, RandomFloat(state, 3.0f));
+    mat[3][0] = RandomFloat(state, 100.0f);
+    mat[3][1] = RandomFloat(state, 100.0f);
+    mat[3][2] = RandomFloat(state, 100.0f);
+    entity->SetWorldMatrix(mat, FALSE);
+}
+
+// Hierarchical box as CKSceneGraphNode::ComputeHierarchicalBox merges it
+CKBOOL ReferenceBox(CKSceneGraphNode *node, VxBbox &box) {
+    CKBOOL valid = FALSE;
+    if (node->m_Entity) {
+        node->m_Entity->UpdateBox(TRUE);
+        if (node->m_Entity->m_MoveableFlags & VX_MOVEABLE_BOXVALID) {
+            box = node->m_Entity->m_WorldBoundingBox;
+            valid = TRUE;
+        }
+    }
+    for (int c = 0; c < node->m_Children.Size(); ++c) {
+        VxBbox childBox;
+        if (!ReferenceBox(node->m_Children[c], childBox))
+            continue;
+        if (valid) {
+            box.Merge(childBox);
+        } else {
+            box = childBox;
+            valid = TRUE;
+        }
+    }
+    return valid;
+}
+
+void CheckRefittedBoxes(const XArray<CKSceneGraphNode *> &nodes) {
+    for (int i = 0; i < nodes.Size(); ++i) {
+        VxBbox expected;
+        const CKBOOL valid = ReferenceBox(nodes[i], expected);
+        TestCheck(nodes[i]->IsHierarchyBoxComputed() == TRUE, "Refitted node is not flagged computed");
+        TestCheck(nodes[i]->IsHierarchyBoxValid() == valid, "Refitted box validity differs");
+        if (valid)
+            TestCheck(memcmp(&nodes[i]->m_Bbox, &expected, sizeof(VxBbox)) == 0,
+                      "Refitted box differs from the full recompute");
+    }
+}
+
+void FlatRefitOnlyVisitsInvalidatedBranches() {
+    CKContext context(nullptr, 0, 0);
+    CKSceneGraphRootNode root;
+    XArray<CKSceneGraphNode *> nodes;
+    XArray<RCK3dEntity *> entities;
+    CKDWORD state = 0xB0B0u;
+
+    // Wide levels so that the pool gets several chunks, and a deep chain
+    const VxBbox localBox(VxVector(-1.0f, -2.0f, -0.5f), VxVector(1.0f, 2.0f, 0.5f));
+    for (int i = 0; i < 1500; ++i) {
+        RCK3dEntity *entity = new RCK3dEntity(&context, nullptr);
+        // One entity in 7 has no box and only forwards the box of its children
+        if (i % 7 != 3)
+            entity->SetBoundingBox(&localBox, TRUE);
+        MoveEntity(entity, state);
+
+        CKSceneGraphNode *parent = &root;
+        if (i >= 8 && i < 40)
+            parent = nodes[i - 1];
+        else if (i >= 40)
+            parent = nodes[NextRandom(state) % nodes.Size()];
+        CKSceneGraphNode *node = new CKSceneGraphNode(entity);
+        node->m_Parent = parent;
+        node->m_Index = parent->m_Children.Size();
+        parent->m_Children.PushBack(node);
+        nodes.PushBack(node);
+        entities.PushBack(entity);
+    }
+
+    CKJobPool pool;
+    pool.Start(3);
+    CKSceneGraphBVH bvh;
+    bvh.Update(&root, &pool);
+    TestCheck(bvh.GetRefittedNodeCount() == nodes.Size() + 1, "First update should fit every node");
+    CheckRefittedBoxes(nodes);
+
+    bvh.Update(&root, &pool);
+    TestCheck(bvh.GetRefittedNodeCount() == 0, "Nothing moved, nothing should be refitted");
+
+    for (int frame = 0; frame < 6; ++frame) {
+        CKJobPool *framePool = (frame & 1) ? nullptr : &pool;
+        const int moveCount = (frame < 3) ? 10 : 600;
+        for (int m = 0; m < moveCount; ++m) {
+            const int i = (int) (NextRandom(state) % entities.Size());
+            MoveEntity(entities[i], state);
+            // What RCK3dEntity does through its scene graph node
+            nodes[i]->InvalidateBox(TRUE);
+            bvh.NodeInvalidated(nodes[i]);
+        }
+        bvh.Update(&root, framePool);
+        if (frame < 3)
+            TestCheck(bvh.GetRefittedNodeCount() < nodes.Size() / 2, "Untouched branches should keep their boxes");
+        CheckRefittedBoxes(nodes);
+    }
+
+    pool.Stop();
+    for (int i = nodes.Size() - 1; i >= 0; --i) {
+        nodes[i]->m_Children.Clear();
+        delete nodes[i];
+        delete entities[i];
+    }
+    root.m_Children.Clear();
+}
+
+// Walks the hierarchy as RenderTransparentObjects does: a node culled
+// outside or all inside skips its children. Each visited node must carry the
+// classification the rasterizer gives its hierarchical box. The flat pass
+// tests the box against planes and the rasterizer transforms its corners, so
+// a box touching a clip plane may round either way.
+void CheckCulledNode(CKSceneGraphNode *node, CKRasterizerContext *ctx, int &mismatches, int &tested) {
+    VxBbox box;
+    const CKBOOL valid = ReferenceBox(node, box);
+    const CKDWORD expected = valid ? ctx->ComputeBoxVisibility(box, TRUE, nullptr) : CBV_VISIBLE;
+    CKDWORD flat = CBV_VISIBLE;
+    if (node->HasAnyFlags(CKSGN_CULLOUTSIDE))
+        flat = CBV_OFFSCREEN;
+    else if (node->HasAnyFlags(CKSGN_CULLINSIDE))
+        flat = CBV_ALLINSIDE;
+    ++tested;
+    if (flat != expected) {
+        const VxVector margin(0.001f);
+        const VxBbox grown(box.Min - margin, box.Max + margin);
+        const VxBbox shrunk(box.Min + margin, box.Max - margin);
+        if (flat != ctx->ComputeBoxVisibility(grown, TRUE, nullptr) &&
+            flat != ctx->ComputeBoxVisibility(shrunk, TRUE, nullptr))
+            ++mismatches;
+    }
+    if (flat != CBV_VISIBLE)
+        return;
+    for (int c = 0; c < node->m_Children.Size(); ++c)
+        CheckCulledNode(node->m_Children[c], ctx, mismatches, tested);
+}
+
+void FlatCullMatchesHierarchicalFrustumTest() {
+    CKContext context(nullptr, 0, 0);
+    CKSceneGraphRootNode root;
+    XArray<CKSceneGraphNode *> nodes;
+    XArray<RCK3dEntity *> entities;
+    CKDWORD state = 0xC011u;
+
+    // Groups of a root, children and grandchildren a few units apart, spread
+    // around the camera so that whole groups fall inside, outside and across
+    // the frustum
+    const VxBbox localBox(VxVector(-0.5f), VxVector(0.5f));
+    for (int g = 0; g < 300; ++g) {
+        const VxVector center(RandomFloat(state, 120.0f), RandomFloat(state, 120.0f), RandomFloat(state, 120.0f));
+        const int groupStart = nodes.Size();
+        const int groupSize = 1 + (int) (NextRandom(state) % 8);
+        for (int i = 0; i < groupSize; ++i) {
+            RCK3dEntity *entity = new RCK3dEntity(&context, nullptr);
+            if (NextRandom(state) % 9 != 0)
+                entity->SetBoundingBox(&localBox, TRUE);
+            VxMatrix mat;
+            Vx3DMatrixIdentity(mat);
+            const float spread = (i == 0) ? 0.0f : 4.0f;
+            mat[3][0] = center.x + RandomFloat(state, spread);
+            mat[3][1] = center.y + RandomFloat(state, spread);
+            mat[3][2] = center.z + RandomFloat(state, spread);
+            entity->SetWorldMatrix(mat, FALSE);
+
+            CKSceneGraphNode *parent = (i == 0) ? &root : nodes[groupStart + (int) (NextRandom(state) % i)];
+            CKSceneGraphNode *node = new CKSceneGraphNode(entity);
+            node->m_Parent = parent;
+            node->m_Index = parent->m_Children.Size();
+            parent->m_Children.PushBack(node);
+            nodes.PushBack(node);
+            entities.PushBack(entity);
+        }
+    }
+
+    CKRasterizer *rst = CKNullRasterizerStart(NULL);
+    CKRasterizerContext *ctx = rst->GetDriver(0)->CreateContext();
+    TestCheck(ctx->Create(NULL, 0, 0, 320, 240), "Null context creation failed");
+
+    // Perspective projection, near 1 and far 100, of cameras turning around
+    VxMatrix proj;
+    Vx3DMatrixIdentity(proj);
+    const float q = 100.0f / 99.0f;
+    proj[0][0] = 0.75f;
+    proj[2][2] = q;
+    proj[2][3] = 1.0f;
+    proj[3][2] = -q;
+    proj[3][3] = 0.0f;
+    ctx->SetTransformMatrix(VXMATRIX_PROJECTION, proj);
+
+    CKSceneGraphBVH bvh;
+    int culled = 0;
+    for (int view = 0; view < 8; ++view) {
+        VxMatrix camera, viewMatrix;
+        Vx3DMatrixFromRotation(camera, VxVector(0.0f, 1.0f, 0.0f), (float) view * 0.785f);
+        camera[3][0] = RandomFloat(state, 20.0f);
+        camera[3][2] = RandomFloat(state, 20.0f);
+        Vx3DInverseMatrix(viewMatrix, camera);
+        ctx->SetTransformMatrix(VXMATRIX_VIEW, viewMatrix);
+        ctx->UpdateMatrices(VIEW_TRANSFORM);
+
+        bvh.Update(&root);
+        bvh.Cull(ctx->m_ViewProjMatrix);
+        TestCheck(bvh.IsCulled() == TRUE, "The flat pass should report a culled hierarchy");
+
+        int mismatches = 0;
+        int tested = 0;
+        for (int c = 0; c < root.m_Children.Size(); ++c)
+            CheckCulledNode(root.m_Children[c], ctx, mismatches, tested);
+        TestCheck(mismatches == 0, "Flat culling differs from the per-node hierarchical frustum test");
+        TestCheck(bvh.GetTestedNodeCount() == tested + 1, "Flat culling should test the nodes the traversal visits");
+        for (int i = 0; i < nodes.Size(); ++i)
+            culled += nodes[i]->HasAnyFlags(CKSGN_CULLOUTSIDE) ? 1 : 0;
+    }
+    TestCheck(culled > 0, "Some groups should be outside the frustum");
+
+    rst->GetDriver(0)->DestroyContext(ctx);
+    CKNullRasterizerClose(rst);
+    for (int i = nodes.Size() - 1; i >= 0; --i) {
+        nodes[i]->m_Children.Clear();
+        delete nodes[i];
+        delete entities[i];
+    }
+    root.m_Children.Clear();
+}
+
 } // namespace
 
 int main() {
     TestFramework tests;
     tests.Run("Deleting parent detaches child nodes", &DeleteParentNodeDetachesChildNodes);
     tests.Run("Transparent object layout matches original DLL offsets", &TransparentObjectLayoutMatchesOriginalDllOffsets);
+    tests.Run("Radix transparent sort matches legacy order", &RadixTransparentSortMatchesLegacyOrder);
+    tests.Run("Radix transparent sort matches legacy with cycles", &RadixTransparentSortMatchesLegacyWithCycles);
+    tests.Run("Flat refit only visits invalidated branches", &FlatRefitOnlyVisitsInvalidatedBranches);
+    tests.Run("Flat cull matches hierarchical frustum test", &FlatCullMatchesHierarchicalFrustumTest);
     return tests.ExitCode();
 }
@@ -0,0 +1,310 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include <atomic>
+
+#include "CKContext.h"
+#include "CKJobPool.h"
+#include "CKSkinEngine.h"
+#include "RCK3dEntity.h"
+#include "RCKMesh.h"
+#include "RCKSkin.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+struct Kernel {
+    const char *name;
+    CK_MESHSIMD level;
+    CKSkinVerticesFunc func;
+};
+
+const Kernel kKernels[] = {
+    {"generic", CK_MESHSIMD_NONE, SkinVerticesGenericFunc},
+    {"SSE2", CK_MESHSIMD_SSE2, SkinVerticesSSE2Func},
+    {"AVX2", CK_MESHSIMD_AVX2, SkinVerticesAVX2Func},
+};
+
+float RandomFloat(float range) {
+    return ((float) rand() / (float) RAND_MAX * 2.0f - 1.0f) * range;
+}
+
+struct TestSkin {
+    XClassArray<RCKSkinVertexData> vertexData;
+    XArray<VxVector> normals;
+    XArray<VxMatrix> palette;
+};
+
+// Random weights summing to at most 1, a few vertices without bones and a few
+// influences on a bone index out of range (ignored like the bone-major path)
+void BuildTestSkin(TestSkin &skin, int vertexCount, int boneCount, int maxInfluences) {
+    skin.vertexData.Resize(vertexCount);
+    skin.normals.Resize(vertexCount);
+    for (int v = 0; v < vertexCount; ++v) {
+        RCKSkinVertexData &vd = skin.vertexData[v];
+        VxVector pos(RandomFloat(10.0f), RandomFloat(10.0f), RandomFloat(10.0f));
+        vd.SetInitialPos(pos);
+        skin.normals[v] = Normalize(VxVector(RandomFloat(1.0f), RandomFloat(1.0f), RandomFloat(1.0f) + 2.0f));
+
+        const int count = (v % 37 == 0) ? 0 : 1 + rand() % maxInfluences;
+        vd.SetBoneCount(count);
+        float left = (v % 5 == 0) ? 0.8f : 1.0f;
+        for (int b = 0; b < count; ++b) {
+            const float weight = (b == count - 1) ? left : left * (float) rand() / (float) RAND_MAX;
+            left -= weight;
+            vd.SetBone(b, (v % 53 == 1 && b == 0) ? boneCount + 3 : rand() % boneCount);
+            vd.SetWeight(b, weight);
+        }
+    }
+
+    skin.palette.Resize(boneCount);
+    for (int i = 0; i < boneCount; ++i) {
+        VxMatrix &m = skin.palette[i];
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 4; ++c)
+                m[r][c] = (r == 3) ? RandomFloat(5.0f) : RandomFloat(1.0f);
+        }
+    }
+    // A missing bone: the palette holds a zero matrix
+    memset(&skin.palette[boneCount / 2], 0, sizeof(VxMatrix));
+}
+
+// Bone-major weighted sum of the original CalcPointsEx
+void ReferenceSkin(TestSkin &skin, CKBOOL weighted, XArray<VxVector> &positions, XArray<VxVector> &normals) {
+    const int vertexCount = skin.vertexData.Size();
+    const int boneCount = skin.palette.Size();
+    positions.Resize(vertexCount);
+    normals.Resize(vertexCount);
+    for (int v = 0; v < vertexCount; ++v) {
+        RCKSkinVertexData &vd = skin.vertexData[v];
+        float totalWeight = 0.0f;
+        for (int b = 0; b < vd.GetBoneCount(); ++b)
+            totalWeight += vd.GetWeight(b);
+        const float remainder = 1.0f - totalWeight;
+        positions[v] = (weighted && remainder > 0.0f) ? vd.GetInitialPos() * remainder : VxVector(0.0f, 0.0f, 0.0f);
+        normals[v].Set(0.0f, 0.0f, 0.0f);
+
+        for (int b = 0; b < vd.GetBoneCount(); ++b) {
+            const int bone = vd.GetBone(b);
+            if (bone < 0 || bone >= boneCount)
+                continue;
+            VxVector pos;
+            VxVector norm;
+            Vx3DMultiplyMatrixVector(&pos, skin.palette[bone], &vd.GetInitialPos());
+            Vx3DRotateVector(&norm, skin.palette[bone], &skin.normals[v]);
+            positions[v] += pos * vd.GetWeight(b);
+            normals[v] += norm * vd.GetWeight(b);
+        }
+    }
+}
+
+bool Near(const VxVector &a, const VxVector &b) {
+    // 16 bit weights on coordinates up to ~100
+    const float tolerance = 2.0e-3f;
+    return fabsf(a.x - b.x) <= tolerance && fabsf(a.y - b.y) <= tolerance && fabsf(a.z - b.z) <= tolerance;
+}
+
+void CheckKernels(int maxInfluences, CKBOOL weighted) {
+    TestSkin skin;
+    BuildTestSkin(skin, 1500, 40, maxInfluences);
+
+    CKSkinInfluenceTable table;
+    TestCheck(table.Build(skin.vertexData.Begin(), skin.vertexData.Size(), skin.palette.Size(), skin.normals.Begin(),
+                          skin.normals.Size(), weighted) != FALSE, "Table should accept the skin");
+    TestCheck(table.GetInfluenceCount() == (maxInfluences <= 4 ? 4 : 8), "Unexpected influence count");
+
+    XArray<VxVector> expectedPositions;
+    XArray<VxVector> expectedNormals;
+    ReferenceSkin(skin, weighted, expectedPositions, expectedNormals);
+
+    // Interleaved position / normal output, like a mesh vertex
+    XArray<VxVertex> out;
+    out.Resize(skin.vertexData.Size());
+    const CK_MESHSIMD level = GetMeshSIMDLevel();
+    for (int k = 0; k < (int) (sizeof(kKernels) / sizeof(kKernels[0])); ++k) {
+        if (kKernels[k].level > level)
+            continue;
+        memset(out.Begin(), 0, out.Size() * sizeof(VxVertex));
+        kKernels[k].func(table, skin.palette.Begin(), 0, out.Size(), (CKBYTE *) &out[0].m_Position, sizeof(VxVertex),
+                         (CKBYTE *) &out[0].m_Normal, sizeof(VxVertex));
+        for (int v = 0; v < out.Size(); ++v) {
+            TestCheck(Near(out[v].m_Position, expectedPositions[v]), "Skinned position differs from the bone-major sum");
+            TestCheck(Near(out[v].m_Normal, expectedNormals[v]), "Skinned normal differs from the bone-major sum");
+        }
+    }
+}
+
+void KernelsMatchBoneMajorSum() {
+    srand(9);
+    CheckKernels(4, FALSE);
+    CheckKernels(8, FALSE);
+    CheckKernels(4, TRUE);
+    CheckKernels(8, TRUE);
+}
+
+void RangesAreIndependent() {
+    srand(4);
+    TestSkin skin;
+    BuildTestSkin(skin, 3000, 25, 6);
+    CKSkinInfluenceTable table;
+    table.Build(skin.vertexData.Begin(), skin.vertexData.Size(), skin.palette.Size(), nullptr, 0, FALSE);
+    TestCheck(!table.HasNormals(), "Table built without normals should not have any");
+
+    XArray<VxVector> whole;
+    XArray<VxVector> split;
+    whole.Resize(skin.vertexData.Size());
+    split.Resize(skin.vertexData.Size());
+    CKSkinVerticesFunc kernel = GetSkinVerticesFunc();
+    kernel(table, skin.palette.Begin(), 0, whole.Size(), (CKBYTE *) whole.Begin(), sizeof(VxVector), nullptr, 0);
+    for (int begin = 0; begin < split.Size(); begin += 700) {
+        const int end = (begin + 700 < split.Size()) ? begin + 700 : split.Size();
+        kernel(table, skin.palette.Begin(), begin, end, (CKBYTE *) split.Begin(), sizeof(VxVector), nullptr, 0);
+    }
+    TestCheck(memcmp(whole.Begin(), split.Begin(), whole.Size() * sizeof(VxVector)) == 0,
+              "Skinning in chunks should give the same result");
+}
+
+void TableRejectsUnsupportedSkins() {
+    XClassArray<RCKSkinVertexData> vertexData;
+    vertexData.Resize(2);
+    VxVector pos(1.0f, 2.0f, 3.0f);
+    vertexData[0].SetInitialPos(pos);
+    vertexData[1].SetInitialPos(pos);
+    vertexData[0].SetBoneCount(1);
+    vertexData[0].SetBone(0, 0);
+    vertexData[0].SetWeight(0, 1.0f);
+
+    vertexData[1].SetBoneCount(9);
+    for (int b = 0; b < 9; ++b) {
+        vertexData[1].SetBone(b, b);
+        vertexData[1].SetWeight(b, 1.0f / 9.0f);
+    }
+    CKSkinInfluenceTable table;
+    TestCheck(!table.Build(vertexData.Begin(), 2, 16, nullptr, 0, FALSE), "Nine influences should not fit");
+    TestCheck(!table.IsBuilt(), "A rejected table should stay empty");
+
+    // Influences on unknown bones do not count
+    vertexData[1].SetBone(8, 40);
+    TestCheck(table.Build(vertexData.Begin(), 2, 16, nullptr, 0, FALSE) != FALSE, "Eight valid influences should fit");
+    TestCheck(table.GetInfluenceCount() == 8, "Eight influences need the wide table");
+    TestCheck(!table.IsBoneUsed(9), "Unused bone should not be flagged");
+
+    vertexData[1].SetBoneCount(1);
+    vertexData[1].SetWeight(0, 1.5f);
+    TestCheck(!table.Build(vertexData.Begin(), 2, 16, nullptr, 0, FALSE), "Weights above 1 should not fit");
+}
+
+// Skins of a frame run as one batch (RCKRenderManager::BatchSkins), several
+// of them larger than a chunk, give the CalcPointsEx result of each skin
+void BatchMatchesPerSkinCalcPoints() {
+    srand(21);
+    CKContext context(nullptr, 0, 0);
+    const int boneCount = 12;
+    RCK3dEntity *bones[boneCount];
+    for (int i = 0; i < boneCount; ++i) {
+        bones[i] = new RCK3dEntity(&context, nullptr);
+        VxMatrix mat;
+        Vx3DMatrixFromRotation(mat, VxVector(RandomFloat(1.0f), 1.0f, RandomFloat(1.0f)), RandomFloat(3.0f));
+        mat[3][0] = RandomFloat(5.0f);
+        mat[3][1] = RandomFloat(5.0f);
+        bones[i]->SetLocalMatrix(mat, FALSE);
+    }
+
+    const int skinCount = 4;
+    const int vertexCounts[skinCount] = {3000, 500, 2500, 1024};
+    RCKSkin skins[skinCount];
+    XArray<VxVertex> expected[skinCount];
+    XArray<VxVertex> batched[skinCount];
+    CKSkinJob jobs[skinCount];
+    for (int s = 0; s < skinCount; ++s) {
+        TestSkin data;
+        BuildTestSkin(data, vertexCounts[s], boneCount, 4 + s);
+        RCKSkin &skin = skins[s];
+        skin.SetBoneCount(boneCount);
+        for (int b = 0; b < boneCount; ++b) {
+            // Bone 3 is missing from the second skin
+            skin.GetBoneData(b)->SetBone((s == 1 && b == 3) ? nullptr : (CK3dEntity *) bones[b]);
+            skin.GetBoneData(b)->SetBoneInitialInverseMatrix(data.palette[b]);
+        }
+        skin.SetVertexCount(vertexCounts[s]);
+        // The last skin has no normals
+        skin.SetNormalCount(s == skinCount - 1 ? 0 : vertexCounts[s]);
+        for (int v = 0; v < vertexCounts[s]; ++v) {
+            RCKSkinVertexData &src = data.vertexData[v];
+            CKSkinVertexData *dst = skin.GetVertexData(v);
+            dst->SetBoneCount(src.GetBoneCount());
+            for (int b = 0; b < src.GetBoneCount(); ++b) {
+                dst->SetBone(b, src.GetBone(b) % boneCount);
+                dst->SetWeight(b, src.GetWeight(b));
+            }
+            dst->SetInitialPos(src.GetInitialPos());
+            if (s != skinCount - 1)
+                skin.SetNormal(v, data.normals[v]);
+        }
+
+        expected[s].Resize(vertexCounts[s]);
+        memset(expected[s].Begin(), 0, expected[s].Size() * sizeof(VxVertex));
+        TestCheck(skin.CalcPointsEx(vertexCounts[s], (CKBYTE *) &expected[s][0].m_Position, sizeof(VxVertex),
+                                    (CKBYTE *) &expected[s][0].m_Normal, sizeof(VxVertex)) != FALSE,
+                  "CalcPointsEx should succeed");
+
+        batched[s].Resize(vertexCounts[s]);
+        memset(batched[s].Begin(), 0, batched[s].Size() * sizeof(VxVertex));
+        CKSkinJob job = {&skin, vertexCounts[s], (CKBYTE *) &batched[s][0].m_Position, sizeof(VxVertex),
+                         (CKBYTE *) &batched[s][0].m_Normal, sizeof(VxVertex), FALSE};
+        jobs[s] = job;
+    }
+
+    CKJobPool pool;
+    pool.Start(3);
+    RCKSkin::CalcPointsBatch(jobs, skinCount, &pool);
+    pool.Stop();
+    for (int s = 0; s < skinCount; ++s) {
+        TestCheck(jobs[s].Result != FALSE, "Batched skin should succeed");
+        TestCheck(memcmp(expected[s].Begin(), batched[s].Begin(), expected[s].Size() * sizeof(VxVertex)) == 0,
+                  "Batched skin differs from CalcPointsEx");
+    }
+
+    for (int i = 0; i < boneCount; ++i)
+        delete bones[i];
+}
+
+void JobPoolRunsEveryIndexOnce() {
+    const int taskCount = 1000;
+    static std::atomic<int> visits[taskCount];
+    struct Task {
+        static void Run(void *context, int index) {
+            ++((std::atomic<int> *) context)[index];
+        }
+    };
+
+    const int workerCounts[] = {0, 1, 3};
+    for (int w = 0; w < 3; ++w) {
+        for (int i = 0; i < taskCount; ++i)
+            visits[i] = 0;
+        CKJobPool pool;
+        pool.Start(workerCounts[w]);
+        TestCheck(pool.GetWorkerCount() == workerCounts[w], "Unexpected worker count");
+        for (int run = 0; run < 50; ++run)
+            pool.Run(taskCount, Task::Run, visits);
+        for (int i = 0; i < taskCount; ++i)
+            TestCheck(visits[i] == 50, "Every task should run exactly once per Run");
+        pool.Stop();
+    }
+
+    TestCheck(CKJobPool::GetAutoWorkerCount(2) == 2, "Explicit worker count should be kept");
+    TestCheck(CKJobPool::GetAutoWorkerCount(100) == CKJOBPOOL_MAX_WORKERS, "Worker count should be capped");
+    TestCheck(CKJobPool::GetAutoWorkerCount(-1) >= 0, "Automatic worker count should not be negative");
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("Kernels match the bone-major sum", &KernelsMatchBoneMajorSum);
+    tests.Run("Ranges are independent", &RangesAreIndependent);
+    tests.Run("Table rejects unsupported skins", &TableRejectsUnsupportedSkins);
+    tests.Run("Batch matches per skin CalcPointsEx", &BatchMatchesPerSkinCalcPoints);
+    tests.Run("Job pool runs every index once", &JobPoolRunsEveryIndexOnce);
+    return tests.ExitCode();
+}
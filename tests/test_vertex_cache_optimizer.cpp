@@ -0,0 +1,174 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "ForsythVertexCacheOptimizer.h"
+#include "VertexCache.h"
+#include "VertexCacheOptimizer.h"
+#include "TestTriangleMultiset.h"
+
+namespace {
+
+// Triangle list of a side x side vertex grid
+template <class IndexType>
+void BuildGrid(XArray<IndexType> &indices, int side) {
+    const int cells = side - 1;
+    indices.Resize(cells * cells * 6);
+    IndexType *out = indices.Begin();
+    for (int y = 0; y < cells; ++y) {
+        for (int x = 0; x < cells; ++x) {
+            const int a = y * side + x;
+            *out++ = (IndexType) a;
+            *out++ = (IndexType) (a + side);
+            *out++ = (IndexType) (a + 1);
+            *out++ = (IndexType) (a + 1);
+            *out++ = (IndexType) (a + side);
+            *out++ = (IndexType) (a + side + 1);
+        }
+    }
+}
+
+template <class IndexType>
+void ShuffleFaces(XArray<IndexType> &indices, unsigned int seed) {
+    srand(seed);
+    const int faceCount = indices.Size() / 3;
+    for (int f = faceCount - 1; f > 0; --f) {
+        const int other = rand() % (f + 1);
+        for (int c = 0; c < 3; ++c)
+            XSwap(indices[f * 3 + c], indices[other * 3 + c]);
+    }
+}
+
+template <class IndexType>
+int CompareFaces(const void *lhs, const void *rhs) {
+    const IndexType *a = (const IndexType *) lhs;
+    const IndexType *b = (const IndexType *) rhs;
+    for (int c = 0; c < 3; ++c) {
+        if (a[c] != b[c])
+            return a[c] < b[c] ? -1 : 1;
+    }
+    return 0;
+}
+
+// TRUE when both lists hold the same triangles with the same corner order
+template <class IndexType>
+bool SameFaces(const XArray<IndexType> &lhs, const XArray<IndexType> &rhs) {
+    if (lhs.Size() != rhs.Size())
+        return false;
+    XArray<IndexType> a = lhs;
+    XArray<IndexType> b = rhs;
+    qsort(a.Begin(), a.Size() / 3, 3 * sizeof(IndexType), &CompareFaces<IndexType>);
+    qsort(b.Begin(), b.Size() / 3, 3 * sizeof(IndexType), &CompareFaces<IndexType>);
+    return memcmp(a.Begin(), b.Begin(), a.Size() * sizeof(IndexType)) == 0;
+}
+
+float ComputeLinearScanACMR(const XArray<CKWORD> &indices, int cacheSize) {
+    VertexCache cache(cacheSize);
+    int misses = 0;
+    for (int i = 0; i < indices.Size(); ++i) {
+        if (!cache.InCache(indices[i])) {
+            cache.AddEntry(indices[i]);
+            ++misses;
+        }
+    }
+    return (float) misses / (float) (indices.Size() / 3);
+}
+
+void ACMRMatchesLinearScanCache() {
+    ForsythVertexCacheOptimizer optimizer;
+    XArray<CKWORD> indices;
+    srand(3);
+    indices.Resize(3000);
+    for (int i = 0; i < indices.Size(); ++i)
+        indices[i] = (CKWORD) (rand() % 64);
+
+    const int cacheSizes[] = {4, 16, 32};
+    for (int s = 0; s < 3; ++s) {
+        TestCheck(optimizer.ComputeACMR(indices.Begin(), 1000, cacheSizes[s]) ==
+                      ComputeLinearScanACMR(indices, cacheSizes[s]),
+                  "The timestamp cache should count the misses of a FIFO cache");
+    }
+}
+
+void ReorderedGridKeepsItsFaces() {
+    ForsythVertexCacheOptimizer optimizer;
+    XArray<CKWORD> input;
+    BuildGrid(input, 40);
+    ShuffleFaces(input, 5);
+    const int faceCount = input.Size() / 3;
+
+    XArray<CKWORD> output;
+    output.Resize(input.Size());
+    optimizer.Optimize(input.Begin(), faceCount, 40 * 40, 16, output.Begin());
+    TestCheck(SameFaces(input, output), "The reordered list should hold the input triangles");
+
+    // In place gives the same order
+    XArray<CKWORD> inPlace = input;
+    optimizer.Optimize(inPlace.Begin(), faceCount, 40 * 40, 16, inPlace.Begin());
+    TestCheck(memcmp(inPlace.Begin(), output.Begin(), output.Size() * sizeof(CKWORD)) == 0,
+              "Reordering in place should give the same triangles");
+}
+
+void ReorderedGridMissesLessThanGreedyOptimizer() {
+    ForsythVertexCacheOptimizer optimizer;
+    XArray<CKWORD> input;
+    BuildGrid(input, 64);
+    ShuffleFaces(input, 11);
+    const int faceCount = input.Size() / 3;
+    const float inputACMR = optimizer.ComputeACMR(input.Begin(), faceCount, 16);
+
+    XArray<CKWORD> scored;
+    scored.Resize(input.Size());
+    optimizer.Optimize(input.Begin(), faceCount, 64 * 64, 16, scored.Begin());
+    const float scoredACMR = optimizer.ComputeACMR(scored.Begin(), faceCount, 16);
+
+    VertexCacheOptimizer greedy;
+    greedy.Initialize(64 * 64, faceCount, 16);
+    greedy.BuildVertexFaceLists(input);
+    greedy.ProcessFaces(input);
+    const float greedyACMR = optimizer.ComputeACMR(greedy.GetOutputIndices().Begin(), faceCount, 16);
+
+    TestCheck(inputACMR > 2.0f, "Shuffled faces should miss the cache");
+    TestCheck(scoredACMR < 0.8f, "The scored order should reuse the cached vertices");
+    TestCheck(scoredACMR <= greedyACMR, "The scored order should miss less than the greedy one");
+}
+
+void LargeMeshesUse32BitIndices() {
+    ForsythVertexCacheOptimizer optimizer;
+    const int side = 300;
+    XArray<CKDWORD> input;
+    BuildGrid(input, side);
+    ShuffleFaces(input, 17);
+    const int faceCount = input.Size() / 3;
+
+    XArray<CKDWORD> output;
+    output.Resize(input.Size());
+    optimizer.Optimize(input.Begin(), faceCount, side * side, 32, output.Begin());
+    TestCheck(SameFaces(input, output), "The reordered 32-bit list should hold the input triangles");
+    TestCheck(optimizer.ComputeACMR(output.Begin(), faceCount, 32) < 0.8f,
+              "The scored order of a large grid should reuse the cached vertices");
+}
+
+void IndicesAboveVertexCountExtendIt() {
+    ForsythVertexCacheOptimizer optimizer;
+    XArray<CKWORD> input;
+    const CKWORD faces[] = {0, 1, 2, 2, 1, 9, 9, 1, 1, 7, 8, 9};
+    input.Resize(12);
+    memcpy(input.Begin(), faces, sizeof(faces));
+
+    XArray<CKWORD> output;
+    output.Resize(input.Size());
+    optimizer.Optimize(input.Begin(), 4, 3, 16, output.Begin());
+    TestCheck(SameFaces(input, output), "Faces past the vertex count and degenerate faces should be kept");
+}
+
+} // namespace
+
+int main() {
+    TestFramework tests;
+    tests.Run("ACMR matches a linear scan cache", &ACMRMatchesLinearScanCache);
+    tests.Run("Reordered grid keeps its faces", &ReorderedGridKeepsItsFaces);
+    tests.Run("Reordered grid misses less than the greedy optimizer", &ReorderedGridMissesLessThanGreedyOptimizer);
+    tests.Run("Large meshes use 32-bit indices", &LargeMeshesUse32BitIndices);
+    tests.Run("Indices above the vertex count extend it", &IndicesAboveVertexCountExtendIt);
+    return tests.ExitCode();
+}